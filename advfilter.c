@@ -0,0 +1,272 @@
+/***************************************************************************//**
+ * @file
+ * @brief Advertising data parser and scan report filter with a cache of
+ * seen addresses
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "advfilter.h"
+
+#define VERDICT_EMPTY			0
+#define VERDICT_MATCH			1
+#define VERDICT_REJECT			2
+
+/* The address is kept as two integers, so a probe is two compares */
+typedef struct {
+	uint32_t low;							// Address bytes 0 to 3
+	uint16_t high;							// Address bytes 4 and 5
+	uint8_t addressType;
+	uint8_t verdict;
+	uint32_t age;							// Insertion count when cached
+} Entry_t;
+
+static ADVFILTER_Criteria_t criteria;
+static ADVFILTER_Stats_t stats;
+static Entry_t cache[ADVFILTER_CACHE_SIZE];
+static uint32_t insertions;
+
+/**************************************************************************//**
+* @brief Next AD structure of a report. A zero length ends the data early,
+* as the padding of a short report does
+*****************************************************************************/
+ADVFILTER_AdStatus_t ADVFILTER_AdNext(const uint8_t *data, uint32_t len, uint32_t *offset, ADVFILTER_Ad_t *ad)
+{
+	uint32_t i = *offset;
+	uint32_t adLen;
+
+	if(i >= len || data[i] == 0)
+	{
+		return ADVFILTER_AD_END;
+	}
+
+	/* The length byte counts the type byte and the value */
+	adLen = data[i];
+	if(adLen > len - i - 1)
+	{
+		return ADVFILTER_AD_MALFORMED;
+	}
+
+	ad->type = data[i + 1];
+	ad->len = (uint8_t)(adLen - 1);
+	ad->value = &data[i + 2];
+	*offset = i + 1 + adLen;
+	return ADVFILTER_AD_FOUND;
+}
+
+static bool listsUuid(const ADVFILTER_Criteria_t *c, const ADVFILTER_Ad_t *ad)
+{
+	for(uint32_t i = 0; i + c->uuidLen <= ad->len; i += c->uuidLen)
+	{
+		if(memcmp(&ad->value[i], c->uuid, c->uuidLen) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool matchData(const ADVFILTER_Criteria_t *c, const uint8_t *data, uint32_t len, bool *malformed)
+{
+	ADVFILTER_Ad_t ad;
+	ADVFILTER_AdStatus_t status;
+	uint32_t offset = 0;
+
+	while((status = ADVFILTER_AdNext(data, len, &offset, &ad)) == ADVFILTER_AD_FOUND)
+	{
+		switch(ad.type)
+		{
+			case ADVFILTER_AD_NAME_COMPLETE:
+				if(c->name != NULL && ad.len == c->nameLen && memcmp(ad.value, c->name, c->nameLen) == 0)
+				{
+					return true;
+				}
+				break;
+			case ADVFILTER_AD_UUID16_INCOMPLETE:
+			case ADVFILTER_AD_UUID16_COMPLETE:
+				if(c->uuid != NULL && c->uuidLen == 2 && listsUuid(c, &ad))
+				{
+					return true;
+				}
+				break;
+			case ADVFILTER_AD_UUID128_INCOMPLETE:
+			case ADVFILTER_AD_UUID128_COMPLETE:
+				if(c->uuid != NULL && c->uuidLen == 16 && listsUuid(c, &ad))
+				{
+					return true;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	*malformed = (status == ADVFILTER_AD_MALFORMED);
+	return false;
+}
+
+/**************************************************************************//**
+* @brief Whether the report data carries the name or the UUID of the
+* criteria. Structures before a malformed one still count
+*****************************************************************************/
+bool ADVFILTER_Match(const ADVFILTER_Criteria_t *c, const uint8_t *data, uint32_t len)
+{
+	bool malformed;
+
+	return matchData(c, data, len, &malformed);
+}
+
+/* Fibonacci hashing, the top bits of the product are the best mixed */
+static uint32_t hash(uint32_t low, uint16_t high)
+{
+	return ((low ^ ((uint32_t)high << 13)) * 2654435761u) >> 16;
+}
+
+static Entry_t *lookup(uint32_t low, uint16_t high, uint8_t addressType)
+{
+	uint32_t slot = hash(low, high);
+
+	for(uint32_t p = 0; p < ADVFILTER_PROBES; p++)
+	{
+		Entry_t *e = &cache[(slot + p) & (ADVFILTER_CACHE_SIZE - 1)];
+
+		if(e->low == low && e->high == high && e->addressType == addressType && e->verdict != VERDICT_EMPTY)
+		{
+			return e;
+		}
+	}
+	return NULL;
+}
+
+static void insert(uint32_t low, uint16_t high, uint8_t addressType, uint8_t verdict)
+{
+	uint32_t slot = hash(low, high);
+	Entry_t *victim = NULL;
+
+	for(uint32_t p = 0; p < ADVFILTER_PROBES; p++)
+	{
+		Entry_t *e = &cache[(slot + p) & (ADVFILTER_CACHE_SIZE - 1)];
+
+		if(e->verdict == VERDICT_EMPTY)
+		{
+			victim = e;
+			break;
+		}
+		if(victim == NULL || (insertions - e->age) > (insertions - victim->age))
+		{
+			victim = e;
+		}
+	}
+
+	if(victim->verdict != VERDICT_EMPTY)
+	{
+		stats.evictions++;
+	}
+	victim->low = low;
+	victim->high = high;
+	victim->addressType = addressType;
+	victim->verdict = verdict;
+	victim->age = insertions++;
+}
+
+/**************************************************************************//**
+* @brief Takes the criteria, the name and UUID are not copied, and clears
+* the cache and the statistics
+*****************************************************************************/
+void ADVFILTER_Init(const ADVFILTER_Criteria_t *c)
+{
+	criteria = *c;
+	memset(&stats, 0, sizeof(stats));
+	ADVFILTER_Reset();
+}
+
+/**************************************************************************//**
+* @brief Sets the target address, NULL matches on the data only. Clears the
+* cache, whose verdicts were for the old criteria
+*****************************************************************************/
+void ADVFILTER_SetAddress(const uint8_t *address)
+{
+	criteria.useAddress = (address != NULL);
+	if(address != NULL)
+	{
+		memcpy(criteria.address, address, 6);
+	}
+	ADVFILTER_Reset();
+}
+
+/**************************************************************************//**
+* @brief Forgets every verdict, call when a scan starts
+*****************************************************************************/
+void ADVFILTER_Reset(void)
+{
+	memset(cache, 0, sizeof(cache));
+	insertions = 0;
+}
+
+/**************************************************************************//**
+* @brief Filters one scan report
+* @param final No other report of this advertising event can follow, so a
+* miss is cached
+* @return true if the device should be connected to
+*****************************************************************************/
+bool ADVFILTER_Report(const uint8_t *address, uint8_t addressType, const uint8_t *data, uint32_t len, bool final)
+{
+	uint32_t low = address[0] | (address[1] << 8) | (address[2] << 16) | ((uint32_t)address[3] << 24);
+	uint16_t high = (uint16_t)(address[4] | (address[5] << 8));
+	Entry_t *e;
+	bool malformed = false;
+	bool match;
+
+	stats.reports++;
+
+	e = lookup(low, high, addressType);
+	if(e != NULL)
+	{
+		stats.cacheHits++;
+		if(e->verdict == VERDICT_MATCH)
+		{
+			stats.matches++;
+			return true;
+		}
+		return false;
+	}
+
+	match = criteria.useAddress && memcmp(address, criteria.address, 6) == 0;
+	if(!match)
+	{
+		stats.parsed++;
+		match = matchData(&criteria, data, len, &malformed);
+		if(malformed)
+		{
+			stats.malformed++;
+		}
+	}
+
+	if(match)
+	{
+		stats.matches++;
+		insert(low, high, addressType, VERDICT_MATCH);
+	}
+	else if(final)
+	{
+		insert(low, high, addressType, VERDICT_REJECT);
+	}
+	return match;
+}
+
+void ADVFILTER_GetStats(ADVFILTER_Stats_t *out)
+{
+	*out = stats;
+}
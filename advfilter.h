@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief Advertising data parser and scan report filter with a cache of
+ * seen addresses
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef ADVFILTER_H_
+#define ADVFILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A scan report matches when its address is the target address, or its
+ * data carries the complete local name or lists the service UUID, any of
+ * the criteria that are set. ADVFILTER_AdNext() walks the AD structures
+ * without ever reading past the report, a structure running past the end
+ * stops the walk and counts the report as malformed.
+ *
+ * Each verdict is kept in a small open addressed hash set of addresses, so
+ * the many reports of a device already seen are settled without parsing.
+ * A miss is only cached once it is final: the report is a scan response,
+ * or no scan response can follow it. Otherwise the name could still come in
+ * the scan response. When the set is full the oldest entry in the probe
+ * window goes. Nothing here touches the hardware, tools/advfilter_bench.c
+ * builds it on a PC. */
+
+#ifndef ADVFILTER_CACHE_SIZE
+#define ADVFILTER_CACHE_SIZE	64			// Addresses, a power of two
+#endif
+#define ADVFILTER_PROBES		4			// Slots looked at per address
+
+/* AD types, Bluetooth Assigned Numbers, Generic Access Profile */
+#define ADVFILTER_AD_UUID16_INCOMPLETE	0x02
+#define ADVFILTER_AD_UUID16_COMPLETE	0x03
+#define ADVFILTER_AD_UUID128_INCOMPLETE	0x06
+#define ADVFILTER_AD_UUID128_COMPLETE	0x07
+#define ADVFILTER_AD_NAME_COMPLETE		0x09
+
+typedef enum {
+	ADVFILTER_AD_END,						// No more structures
+	ADVFILTER_AD_FOUND,
+	ADVFILTER_AD_MALFORMED					// A length runs past the data
+} ADVFILTER_AdStatus_t;
+
+typedef struct {
+	uint8_t type;
+	uint8_t len;
+	const uint8_t *value;					// Points into the report
+} ADVFILTER_Ad_t;
+
+typedef struct {
+	const char *name;						// Complete local name, NULL for any
+	uint8_t nameLen;
+	const uint8_t *uuid;					// Service UUID, little endian as on air, NULL for any
+	uint8_t uuidLen;						// 2 or 16
+	bool useAddress;
+	uint8_t address[6];						// Target address, little endian as in bd_addr
+} ADVFILTER_Criteria_t;
+
+typedef struct {
+	uint32_t reports;
+	uint32_t cacheHits;						// Reports settled by the cache
+	uint32_t parsed;
+	uint32_t malformed;
+	uint32_t matches;
+	uint32_t evictions;						// Cached verdicts pushed out for space
+} ADVFILTER_Stats_t;
+
+ADVFILTER_AdStatus_t ADVFILTER_AdNext(const uint8_t *data, uint32_t len, uint32_t *offset, ADVFILTER_Ad_t *ad);
+bool ADVFILTER_Match(const ADVFILTER_Criteria_t *criteria, const uint8_t *data, uint32_t len);
+void ADVFILTER_Init(const ADVFILTER_Criteria_t *criteria);
+void ADVFILTER_SetAddress(const uint8_t *address);
+void ADVFILTER_Reset(void);
+bool ADVFILTER_Report(const uint8_t *address, uint8_t addressType, const uint8_t *data, uint32_t len, bool final);
+void ADVFILTER_GetStats(ADVFILTER_Stats_t *stats);
+
+#endif
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+ * @file
+ * @brief Ring of fixed size test summaries in internal flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARCHIVE_HOST_MODEL
+#include "msc_model.h"
+#define ARCHIVE_MEMORY			MSC_MODEL_Base()
+#define ARCHIVE_BYTES			MSC_MODEL_SIZE
+#else
+#include "em_msc.h"
+/* Reserved in efr32bg13p632f512gm48.ld, right below NVM3 */
+extern uint32_t __archive_base[];
+extern uint8_t __archive_size[];
+#define ARCHIVE_MEMORY			__archive_base
+#define ARCHIVE_BYTES			((uint32_t)__archive_size)
+#endif
+
+#include "flashlog.h"
+#include "archive.h"
+
+_Static_assert(sizeof(ARCHIVE_Summary_t) == ARCHIVE_RECORD_SIZE, "ARCHIVE_Summary_t must fill one slot");
+
+#define PAGE_WORDS				(ARCHIVE_PAGE_SIZE / 4)
+#define RECORD_WORDS			(ARCHIVE_RECORD_SIZE / 4)
+#define ERASED_WORD				0xFFFFFFFF
+
+static bool ready = false;
+static uint32_t *memory;
+static uint32_t pages;
+static uint32_t slots;
+static uint32_t head;						// Next slot to write
+static bool headReady;						// Slots from head to the end of its page are erased
+static uint32_t ahead;						// Page after the head page, erased before head gets there
+static bool aheadBlank;
+static uint32_t nextSequence;
+
+static ARCHIVE_Summary_t queue[ARCHIVE_QUEUE_SIZE];
+static uint32_t queuePut = 0;				// Free running counters
+static uint32_t queueGet = 0;
+
+static ARCHIVE_Stats_t stats;
+
+static uint32_t *slotAddress(uint32_t slot)
+{
+	return &memory[slot * RECORD_WORDS];
+}
+
+static uint32_t pageOf(uint32_t slot)
+{
+	return slot / ARCHIVE_SLOTS_PER_PAGE;
+}
+
+static bool isBlank(const uint32_t *words, uint32_t count)
+{
+	while(count--)
+	{
+		if(*words++ != ERASED_WORD)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Slots from the given one to the end of its page */
+static bool restOfPageBlank(uint32_t slot)
+{
+	return isBlank(slotAddress(slot), (ARCHIVE_SLOTS_PER_PAGE - (slot % ARCHIVE_SLOTS_PER_PAGE)) * RECORD_WORDS);
+}
+
+static uint16_t summaryCrc(const ARCHIVE_Summary_t *summary)
+{
+	return FLASHLOG_Crc16(0xFFFF, (const uint8_t *)summary, offsetof(ARCHIVE_Summary_t, crc));
+}
+
+/* Copies a slot out of flash, false if it is free or torn */
+static bool readSlot(uint32_t slot, ARCHIVE_Summary_t *summary)
+{
+	memcpy(summary, slotAddress(slot), sizeof(*summary));
+	return summary->sequence != ERASED_WORD && summary->crc == summaryCrc(summary);
+}
+
+/**************************************************************************//**
+* @brief Erases one page, dropping whatever summaries it still held
+*****************************************************************************/
+static bool erasePage(uint32_t page)
+{
+	uint32_t *address = &memory[page * PAGE_WORDS];
+	uint32_t lost = 0;
+	ARCHIVE_Summary_t summary;
+
+	for(uint32_t slot = page * ARCHIVE_SLOTS_PER_PAGE; slot < (page + 1) * ARCHIVE_SLOTS_PER_PAGE; slot++)
+	{
+		if(readSlot(slot, &summary))
+		{
+			lost++;
+		}
+	}
+	if(lost)
+	{
+		stats.records -= lost;
+		stats.recycled++;
+	}
+
+	/* The stack locks the MSC again after its own NVM3 writes */
+	MSC_Init();
+	return MSC_ErasePage(address) == mscReturnOk && isBlank(address, PAGE_WORDS);
+}
+
+/**************************************************************************//**
+* @brief Moves head to the next slot, handing over the erased ahead page
+*****************************************************************************/
+static void advance(void)
+{
+	head = (head + 1) % slots;
+	if(head % ARCHIVE_SLOTS_PER_PAGE == 0)
+	{
+		headReady = aheadBlank;
+		ahead = (pageOf(head) + 1) % pages;
+		aheadBlank = isBlank(&memory[ahead * PAGE_WORDS], PAGE_WORDS);
+	}
+}
+
+/**************************************************************************//**
+* @brief Writes the oldest queued summary to the head slot in one burst
+* @details MSC_WriteWordFast() keeps interrupts off for the whole record,
+* which is why the caller only polls between stack events. A refused or
+* unverified write leaves the summary queued and skips the slot.
+*****************************************************************************/
+static void writeHead(void)
+{
+	ARCHIVE_Summary_t *summary = &queue[queueGet % ARCHIVE_QUEUE_SIZE];
+	uint32_t *address = slotAddress(head);
+	MSC_Status_TypeDef status;
+
+	summary->sequence = nextSequence;
+	summary->crc = summaryCrc(summary);
+
+	MSC_Init();
+	status = MSC_WriteWordFast(address, summary, ARCHIVE_RECORD_SIZE);
+	if(status == mscReturnOk && memcmp(address, summary, ARCHIVE_RECORD_SIZE) == 0)
+	{
+		nextSequence++;
+		queueGet++;
+		stats.written++;
+		stats.records++;
+	}
+	else
+	{
+		stats.writeErrors++;
+	}
+	advance();
+}
+
+/**************************************************************************//**
+* @brief Finds the newest summary and the next free slot
+* @return false if the linker script reserved too little space
+*****************************************************************************/
+bool ARCHIVE_Init(void)
+{
+	ARCHIVE_Summary_t summary;
+	uint32_t newestSlot = 0;
+	uint32_t newest = 0;
+	bool found = false;
+
+	memset(&stats, 0, sizeof(stats));
+	queuePut = queueGet = 0;
+	ready = false;
+
+	memory = ARCHIVE_MEMORY;
+	pages = ARCHIVE_BYTES / ARCHIVE_PAGE_SIZE;
+	slots = pages * ARCHIVE_SLOTS_PER_PAGE;
+	if(pages < 3)
+	{
+		return false;
+	}
+
+	for(uint32_t slot = 0; slot < slots; slot++)
+	{
+		if(isBlank(slotAddress(slot), RECORD_WORDS))
+		{
+			continue;
+		}
+		if(!readSlot(slot, &summary))
+		{
+			stats.corrupt++;
+			continue;
+		}
+		stats.records++;
+		if(!found || summary.sequence > newest)
+		{
+			found = true;
+			newest = summary.sequence;
+			newestSlot = slot;
+		}
+	}
+
+	head = found ? (newestSlot + 1) % slots : 0;
+	nextSequence = found ? newest + 1 : 0;
+
+	/* Skip a slot torn by a reset after the newest summary. If the page is
+	 * still not clean, start over in the next page rather than erase the one
+	 * holding the newest summaries */
+	while(head % ARCHIVE_SLOTS_PER_PAGE != 0 && !isBlank(slotAddress(head), RECORD_WORDS))
+	{
+		head = (head + 1) % slots;
+	}
+	if(head % ARCHIVE_SLOTS_PER_PAGE != 0 && !restOfPageBlank(head))
+	{
+		head = ((pageOf(head) + 1) % pages) * ARCHIVE_SLOTS_PER_PAGE;
+	}
+	headReady = restOfPageBlank(head);
+	ahead = (pageOf(head) + 1) % pages;
+	aheadBlank = isBlank(&memory[ahead * PAGE_WORDS], PAGE_WORDS);
+
+	ready = true;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Queues a summary, never touches the flash
+* @return false if the queue is full or there is no archive
+*****************************************************************************/
+bool ARCHIVE_Save(const ARCHIVE_Summary_t *summary)
+{
+	if(!ready || queuePut - queueGet >= ARCHIVE_QUEUE_SIZE)
+	{
+		stats.dropped++;
+		return false;
+	}
+
+	queue[queuePut % ARCHIVE_QUEUE_SIZE] = *summary;
+	queuePut++;
+	stats.saved++;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Does at most one flash operation: a queued write, or the erase of
+* the ahead page
+* @param quiet True when no connection events are due soon. A page erase
+* stalls flash fetches for tens of milliseconds, so the ahead page is only
+* erased when quiet, unless a save is already waiting for it.
+*****************************************************************************/
+void ARCHIVE_Poll(bool quiet)
+{
+	if(!ready)
+	{
+		return;
+	}
+
+	if(!headReady)
+	{
+		/* The erase ahead did not get done in time, the head page goes first */
+		if(queueGet != queuePut)
+		{
+			stats.forcedErases++;
+			headReady = erasePage(pageOf(head));
+		}
+		else if(quiet)
+		{
+			stats.erases++;
+			headReady = erasePage(pageOf(head));
+		}
+	}
+	else if(queueGet != queuePut)
+	{
+		writeHead();
+	}
+	else if(quiet && !aheadBlank)
+	{
+		stats.erases++;
+		aheadBlank = erasePage(ahead);
+	}
+}
+
+/**************************************************************************//**
+* @brief Writes every queued summary now, erasing as needed
+*****************************************************************************/
+void ARCHIVE_Flush(void)
+{
+	/* Bounded, a part that refuses every write must not hang the caller */
+	for(uint32_t i = 0; i < 4 * ARCHIVE_QUEUE_SIZE && queueGet != queuePut; i++)
+	{
+		ARCHIVE_Poll(true);
+	}
+}
+
+/**************************************************************************//**
+* @brief Calls walker for every valid summary, oldest first
+* @return Number of summaries walked
+*****************************************************************************/
+uint32_t ARCHIVE_Walk(ARCHIVE_Walker_t walker)
+{
+	ARCHIVE_Summary_t summary;
+	uint32_t count = 0;
+
+	if(!ready)
+	{
+		return 0;
+	}
+
+	/* Slots are written in order, so the oldest follow the free ones at head */
+	for(uint32_t i = 0; i < slots; i++)
+	{
+		uint32_t slot = (head + i) % slots;
+
+		if(readSlot(slot, &summary))
+		{
+			walker(&summary);
+			count++;
+		}
+	}
+	return count;
+}
+
+void ARCHIVE_GetStats(ARCHIVE_Stats_t *out)
+{
+	*out = stats;
+	out->head = head;
+	out->slots = slots;
+	out->queued = queuePut - queueGet;
+}
@@ -0,0 +1,97 @@
+/***************************************************************************//**
+ * @file
+ * @brief Ring of fixed size test summaries in internal flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* One summary per run, kept in the pages the linker script reserves below
+ * NVM3 (__archive_base, __archive_size). ARCHIVE_Save() only queues the
+ * summary in RAM; ARCHIVE_Poll() writes it with MSC_WriteWordFast() as one
+ * burst of ARCHIVE_RECORD_SIZE / 4 words. The page after the one being
+ * written is erased ahead of time, so a save never has to wait for an erase,
+ * and that erase is only started when the caller says the radio is quiet.
+ * When the ring is full the oldest page is recycled.
+ *
+ * Built with -DARCHIVE_HOST_MODEL the module runs on a PC against
+ * tools/msc_model.c, which checks the page and word rules of the part. */
+
+#define ARCHIVE_PAGE_SIZE		2048		// FLASH_PAGE_SIZE of series 1 parts
+#define ARCHIVE_RECORD_SIZE		64
+#define ARCHIVE_SLOTS_PER_PAGE	(ARCHIVE_PAGE_SIZE / ARCHIVE_RECORD_SIZE)
+#ifndef ARCHIVE_QUEUE_SIZE
+#define ARCHIVE_QUEUE_SIZE		4			// Summaries waiting in RAM
+#endif
+
+/* ARCHIVE_Summary_t kind */
+#define ARCHIVE_KIND_RUN		1			// End of a throughput run
+#define ARCHIVE_KIND_BENCH		2			// Written by the archive benchmark
+
+/* Flash layout of one slot, little endian. sequence is written first and
+ * crc last in the same burst, so a slot whose crc does not match was torn
+ * by a reset and is skipped. An all 0xFF slot is free. */
+typedef struct {
+	uint32_t sequence;						// Filled in when the slot is written
+	uint32_t timestamp;						// RTCC ticks at the end of the run
+	uint8_t kind;							// ARCHIVE_KIND_*
+	uint8_t phy;							// PHY_1M, PHY_2M, PHY_S8 or PHY_S2
+	uint8_t mode;							// FLASHLOG_MODE_*
+	uint8_t invalid;						// Invalid data indications seen
+	uint16_t dataSize;						// Payload bytes per operation
+	uint16_t mtu;
+	uint16_t interval;						// Connection interval, 1.25 ms units
+	uint16_t reserved0;
+	uint32_t bits;
+	uint32_t ticks;							// Run length, RTCC ticks
+	uint32_t throughput;					// bits/s
+	uint32_t operations;
+	uint32_t lpRequests;					// Coex counters over the run
+	uint32_t hpRequests;
+	uint32_t lpDenials;
+	uint32_t hpDenials;
+	uint32_t reserved1[2];
+	uint16_t reserved2;
+	uint16_t crc;							// FLASHLOG_Crc16() of everything before it
+} ARCHIVE_Summary_t;
+
+typedef struct {
+	uint32_t saved;							// Summaries accepted by ARCHIVE_Save()
+	uint32_t dropped;						// Refused, queue full or no archive
+	uint32_t written;						// Bursts completed
+	uint32_t writeErrors;					// Bursts the MSC refused, slot skipped
+	uint32_t erases;						// Pages erased ahead, radio quiet
+	uint32_t forcedErases;					// Pages erased because a save was waiting
+	uint32_t recycled;						// Pages whose summaries were dropped for space
+	uint32_t corrupt;						// Torn slots seen by Init
+	uint32_t records;						// Valid summaries held
+	uint32_t head;							// Next slot to write
+	uint32_t slots;
+	uint32_t queued;
+} ARCHIVE_Stats_t;
+
+typedef void (*ARCHIVE_Walker_t)(const ARCHIVE_Summary_t *summary);
+
+bool ARCHIVE_Init(void);
+bool ARCHIVE_Save(const ARCHIVE_Summary_t *summary);
+void ARCHIVE_Poll(bool quiet);
+void ARCHIVE_Flush(void);
+uint32_t ARCHIVE_Walk(ARCHIVE_Walker_t walker);
+void ARCHIVE_GetStats(ARCHIVE_Stats_t *stats);
+
+#endif
@@ -0,0 +1,172 @@
+/***************************************************************************//**
+ * @file
+ * @brief Data channel classification from a per channel packet error rate
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "chanclass.h"
+
+/**************************************************************************//**
+* @brief RF channel of a link layer data channel. Data channels 0 to 10 are
+* 2404 to 2424 MHz, 11 to 36 are 2428 to 2478 MHz
+*****************************************************************************/
+uint8_t CHANCLASS_RfChannel(uint8_t index)
+{
+	return (index <= 10) ? index + 1 : index + 2;
+}
+
+/**************************************************************************//**
+* @brief Link layer data channel of an RF channel, -1 for the advertising
+* channels at 2402, 2426 and 2480 MHz
+*****************************************************************************/
+int CHANCLASS_DataChannel(uint8_t rf)
+{
+	if(rf == 0 || rf == 12 || rf >= 39)
+	{
+		return -1;
+	}
+	return (rf <= 11) ? rf - 1 : rf - 2;
+}
+
+static void set(uint8_t map[CHANCLASS_MAP_SIZE], uint8_t index, bool used)
+{
+	if(used)
+	{
+		map[index / 8] |= (uint8_t)(1 << (index % 8));
+	}
+	else
+	{
+		map[index / 8] &= (uint8_t)~(1 << (index % 8));
+	}
+}
+
+bool CHANCLASS_Used(const uint8_t map[CHANCLASS_MAP_SIZE], uint8_t index)
+{
+	return (map[index / 8] >> (index % 8)) & 1;
+}
+
+/**************************************************************************//**
+* @brief The default map, every data channel used
+*****************************************************************************/
+void CHANCLASS_All(uint8_t map[CHANCLASS_MAP_SIZE])
+{
+	memset(map, 0, CHANCLASS_MAP_SIZE);
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		set(map, i, true);
+	}
+}
+
+uint32_t CHANCLASS_Count(const uint8_t map[CHANCLASS_MAP_SIZE])
+{
+	uint32_t count = 0;
+
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		count += CHANCLASS_Used(map, i);
+	}
+	return count;
+}
+
+/**************************************************************************//**
+* @brief Classifies the data channels
+* @param per Packet error rate of each RF channel, permille, CHANCLASS_NO_DATA
+* where there is no figure
+* @param previous The map in use, for the hysteresis. May be the same as map
+* @return Channels used
+*****************************************************************************/
+uint32_t CHANCLASS_Classify(const uint32_t per[CHANCLASS_RF_CHANNELS], const uint8_t previous[CHANCLASS_MAP_SIZE],
+		uint8_t map[CHANCLASS_MAP_SIZE])
+{
+	bool bad[CHANCLASS_DATA_CHANNELS];
+	bool widen[CHANCLASS_DATA_CHANNELS];
+	uint32_t run = 0;
+	uint32_t used = 0;
+
+	/* Thresholds, with hysteresis on channels already bad */
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		uint32_t p = per[CHANCLASS_RfChannel(i)];
+		bool wasBad = !CHANCLASS_Used(previous, i);
+
+		if(p == CHANCLASS_NO_DATA)
+		{
+			bad[i] = wasBad;
+		}
+		else
+		{
+			bad[i] = (p >= CHANCLASS_BAD_PER) || (wasBad && p >= CHANCLASS_GOOD_PER);
+		}
+		widen[i] = false;
+	}
+
+	/* Wi-Fi skirts, in RF order the data channels are in index order */
+	for(uint8_t i = 0; i <= CHANCLASS_DATA_CHANNELS; i++)
+	{
+		if(i < CHANCLASS_DATA_CHANNELS && bad[i])
+		{
+			run++;
+			continue;
+		}
+		if(run >= CHANCLASS_WIFI_RUN)
+		{
+			uint8_t first = i - run;
+
+			if(first > 0)
+			{
+				widen[first - 1] = true;
+			}
+			if(i < CHANCLASS_DATA_CHANNELS)
+			{
+				widen[i] = true;
+			}
+		}
+		run = 0;
+	}
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		uint32_t p = per[CHANCLASS_RfChannel(i)];
+
+		if(widen[i] && p != CHANCLASS_NO_DATA && p >= CHANCLASS_GOOD_PER)
+		{
+			bad[i] = true;
+		}
+		used += !bad[i];
+	}
+
+	/* Too few left, take back the best of the bad ones */
+	while(used < CHANCLASS_MIN_USED)
+	{
+		int best = -1;
+
+		for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+		{
+			if(bad[i] && (best < 0 || per[CHANCLASS_RfChannel(i)] < per[CHANCLASS_RfChannel((uint8_t)best)]))
+			{
+				best = i;
+			}
+		}
+		bad[best] = false;
+		used++;
+	}
+
+	memset(map, 0, CHANCLASS_MAP_SIZE);
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		set(map, i, !bad[i]);
+	}
+	return used;
+}
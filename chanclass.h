@@ -0,0 +1,57 @@
+/***************************************************************************//**
+ * @file
+ * @brief Data channel classification from a per channel packet error rate
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CHANCLASS_H_
+#define CHANCLASS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Turns a survey, the packet error rate of every RF channel, into the map
+ * for le_gap_set_data_channel_classification: 37 bits, one per link layer
+ * data channel, 1 unknown (used) and 0 bad. Channels are taken in RF order,
+ * so the advertising channel 38 between data channels 10 and 11 does not
+ * break a run of neighbours.
+ *
+ *  - A channel at or above CHANCLASS_BAD_PER is bad. One already bad stays
+ *    bad until it falls below CHANCLASS_GOOD_PER, so a map applied again
+ *    after every survey does not flap on a channel near the limit.
+ *  - Wi-Fi is 20 MHz wide, its skirts reach past what the survey caught. A
+ *    run of CHANCLASS_WIFI_RUN bad channels also takes the neighbour either
+ *    side if that is at or above CHANCLASS_GOOD_PER.
+ *  - At least CHANCLASS_MIN_USED channels are kept, the best of the bad
+ *    ones are taken back if need be.
+ *  - A channel the survey has no figure for is left as it was. */
+
+#define CHANCLASS_DATA_CHANNELS	37
+#define CHANCLASS_RF_CHANNELS	40			// (F - 2402) / 2, F in MHz
+#define CHANCLASS_MAP_SIZE		5
+#define CHANCLASS_BAD_PER		100			// Permille
+#define CHANCLASS_GOOD_PER		40			// Permille
+#define CHANCLASS_WIFI_RUN		4			// Bad channels in a row taken as a Wi-Fi channel
+#define CHANCLASS_MIN_USED		8			// The specification asks for 2, fewer than this makes each hop count too much
+#define CHANCLASS_NO_DATA		UINT32_MAX
+
+void CHANCLASS_All(uint8_t map[CHANCLASS_MAP_SIZE]);
+uint32_t CHANCLASS_Classify(const uint32_t per[CHANCLASS_RF_CHANNELS], const uint8_t previous[CHANCLASS_MAP_SIZE],
+		uint8_t map[CHANCLASS_MAP_SIZE]);
+bool CHANCLASS_Used(const uint8_t map[CHANCLASS_MAP_SIZE], uint8_t index);
+uint32_t CHANCLASS_Count(const uint8_t map[CHANCLASS_MAP_SIZE]);
+uint8_t CHANCLASS_RfChannel(uint8_t index);
+int CHANCLASS_DataChannel(uint8_t rf);
+
+#endif
@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ * @file
+ * @brief Selectable core clock and DC-DC profiles
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "retargetserial.h"
+
+#include "clockprof.h"
+
+/* The boot settings, HFXO undivided with the DC-DC on, come first */
+static const CLOCKPROF_Profile_t profiles[] = {
+	{ "38m4",			1,	true },
+	{ "19m2",			2,	true },
+	{ "12m8",			3,	true },
+	{ "9m6",			4,	true },
+	{ "38m4-bypass",	1,	false },
+	{ "19m2-bypass",	2,	false },
+	{ "9m6-bypass",		4,	false },
+};
+
+uint32_t CLOCKPROF_Count(void)
+{
+	return sizeof(profiles) / sizeof(profiles[0]);
+}
+
+const CLOCKPROF_Profile_t *CLOCKPROF_Get(uint32_t index)
+{
+	return (index < CLOCKPROF_Count()) ? &profiles[index] : NULL;
+}
+
+/**************************************************************************//**
+* @brief Index of the profile of that name, -1 if there is none
+*****************************************************************************/
+int CLOCKPROF_Find(const char *name)
+{
+	for(uint32_t i = 0; i < CLOCKPROF_Count(); i++)
+	{
+		if(strcmp(profiles[i].name, name) == 0)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/**************************************************************************//**
+* @brief Index of the profile the hardware is in, read back from the HFPRESC
+* prescaler and the DC-DC mode, -1 if none matches
+*****************************************************************************/
+int CLOCKPROF_Current(void)
+{
+	uint32_t divider = ((CMU->HFPRESC & _CMU_HFPRESC_PRESC_MASK) >> _CMU_HFPRESC_PRESC_SHIFT) + 1;
+	bool dcdc = (EMU->DCDCCTRL & _EMU_DCDCCTRL_DCDCMODE_MASK) != EMU_DCDCCTRL_DCDCMODE_BYPASS;
+
+	for(uint32_t i = 0; i < CLOCKPROF_Count(); i++)
+	{
+		if(profiles[i].hfDivider == divider && profiles[i].dcdc == dcdc)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/**************************************************************************//**
+* @brief Switches to a profile. The console output is drained first and the
+* UART baud rate set again after, so a line is not garbled by the change
+*****************************************************************************/
+void CLOCKPROF_Apply(uint32_t index)
+{
+	const CLOCKPROF_Profile_t *profile = CLOCKPROF_Get(index);
+
+	if(profile == NULL)
+	{
+		return;
+	}
+
+	RETARGET_SerialFlush();
+	EMU_DCDCModeSet(profile->dcdc ? emuDcdcMode_LowNoise : emuDcdcMode_Bypass);
+	CMU_ClockDivSet(cmuClock_HF, (CMU_ClkDiv_TypeDef)profile->hfDivider);
+	RETARGET_SerialClockChanged();
+}
@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @file
+ * @brief Selectable core clock and DC-DC profiles
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CLOCKPROF_H_
+#define CLOCKPROF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* initMcu() leaves HFCLK on the HFXO undivided and the DC-DC as
+ * BSP_DCDC_INIT has it. A profile divides HFCLK with the HFPRESC prescaler
+ * and runs the DC-DC in low noise mode or bypasses it. The radio keeps
+ * running from the HFXO whatever the profile, only the core and the
+ * peripheral clocks follow HFCLK; em_cmu sets the flash wait states and the
+ * HFLE and HFPER prescalers to match.
+ *
+ * Peripherals set up for a clock are slowed down with it: the retarget UART
+ * is given its baud rate again, the SPI clock of the MX25 flash is just
+ * slower. The energy model's currents are for the full clock. Profiles are
+ * only changed between runs, the stack has to keep up with the radio at
+ * the lowest of them, which is what a run at that profile finds out. */
+
+typedef struct {
+	const char *name;
+	uint8_t hfDivider;						// HFCLK is the HFXO over this
+	bool dcdc;								// Low noise DC-DC, else bypassed
+} CLOCKPROF_Profile_t;
+
+uint32_t CLOCKPROF_Count(void);
+const CLOCKPROF_Profile_t *CLOCKPROF_Get(uint32_t index);
+int CLOCKPROF_Find(const char *name);
+int CLOCKPROF_Current(void);
+void CLOCKPROF_Apply(uint32_t index);
+
+#endif
@@ -0,0 +1,154 @@
+/***************************************************************************//**
+ * @file
+ * @brief Connection setup milestones, from boot or a restarted scan to the
+ * first data
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "connsetup.h"
+
+static const char *names[CONNSETUP_MILESTONES] = {
+	"start", "found", "opened", "parameters", "mtu", "cccd notify", "cccd indicate", "first data"
+};
+
+static HISTOGRAM_t elapsed[CONNSETUP_MILESTONES];
+static HISTOGRAM_t phase[CONNSETUP_MILESTONES];
+static CONNSETUP_Stats_t stats;
+static CONNSETUP_Cycle_t cycle;
+static CONNSETUP_Done_t doneCallback;
+static bool active;							// A cycle is running and has not completed
+static CONNSETUP_Milestone_t last;			// Milestone reached most recently
+
+static uint32_t ticksToMicroseconds(uint32_t ticks)
+{
+	uint64_t us = ((uint64_t)ticks * 1000000u) >> 15;
+
+	return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
+
+/**************************************************************************//**
+* @brief Clears the figures and takes the callback each finished cycle goes
+* to, NULL for none. No cycle runs until CONNSETUP_Start()
+*****************************************************************************/
+void CONNSETUP_Init(CONNSETUP_Done_t done)
+{
+	doneCallback = done;
+	active = false;
+	memset(&cycle, 0, sizeof(cycle));
+	CONNSETUP_Clear();
+}
+
+/**************************************************************************//**
+* @brief Clears the histograms and the counters, a running cycle goes on
+*****************************************************************************/
+void CONNSETUP_Clear(void)
+{
+	memset(&stats, 0, sizeof(stats));
+	for(uint32_t m = 0; m < CONNSETUP_MILESTONES; m++)
+	{
+		HISTOGRAM_Reset(&elapsed[m]);
+		HISTOGRAM_Reset(&phase[m]);
+	}
+}
+
+/**************************************************************************//**
+* @brief Starts a cycle, abandoning the running one
+*****************************************************************************/
+void CONNSETUP_Start(uint32_t now)
+{
+	if(active)
+	{
+		active = false;
+		stats.stalled[last]++;
+		if(doneCallback != NULL)
+		{
+			doneCallback(&cycle, false);
+		}
+	}
+
+	memset(&cycle, 0, sizeof(cycle));
+	cycle.cycle = (uint16_t)++stats.cycles;
+	cycle.reached = 1 << CONNSETUP_START;
+	cycle.start = now;
+	last = CONNSETUP_START;
+	active = true;
+}
+
+/**************************************************************************//**
+* @brief Takes a milestone of the running cycle
+* @return true the first time the milestone is reached in the cycle
+*****************************************************************************/
+bool CONNSETUP_Mark(CONNSETUP_Milestone_t milestone, uint32_t now)
+{
+	uint32_t ticks = now - cycle.start;
+
+	if(!active || milestone >= CONNSETUP_MILESTONES || (cycle.reached & (1 << milestone)))
+	{
+		return false;
+	}
+
+	HISTOGRAM_Add(&elapsed[milestone], ticksToMicroseconds(ticks));
+	HISTOGRAM_Add(&phase[milestone], ticksToMicroseconds(ticks - cycle.ticks[last]));
+	cycle.ticks[milestone] = ticks;
+	cycle.reached |= 1 << milestone;
+	last = milestone;
+
+	if(milestone == CONNSETUP_FIRST_DATA)
+	{
+		active = false;
+		stats.completed++;
+		if(doneCallback != NULL)
+		{
+			doneCallback(&cycle, true);
+		}
+	}
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Whether the running or the last cycle reached the milestone
+*****************************************************************************/
+bool CONNSETUP_Reached(CONNSETUP_Milestone_t milestone)
+{
+	return milestone < CONNSETUP_MILESTONES && (cycle.reached & (1 << milestone)) != 0;
+}
+
+const char *CONNSETUP_Name(CONNSETUP_Milestone_t milestone)
+{
+	return (milestone < CONNSETUP_MILESTONES) ? names[milestone] : "?";
+}
+
+/**************************************************************************//**
+* @brief Microseconds from the start of the cycle to the milestone
+*****************************************************************************/
+const HISTOGRAM_t *CONNSETUP_Elapsed(CONNSETUP_Milestone_t milestone)
+{
+	return (milestone < CONNSETUP_MILESTONES) ? &elapsed[milestone] : NULL;
+}
+
+/**************************************************************************//**
+* @brief Microseconds from the milestone reached before to this one
+*****************************************************************************/
+const HISTOGRAM_t *CONNSETUP_Phase(CONNSETUP_Milestone_t milestone)
+{
+	return (milestone < CONNSETUP_MILESTONES) ? &phase[milestone] : NULL;
+}
+
+void CONNSETUP_GetStats(CONNSETUP_Stats_t *out)
+{
+	*out = stats;
+}
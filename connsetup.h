@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file
+ * @brief Connection setup milestones, from boot or a restarted scan to the
+ * first data
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CONNSETUP_H_
+#define CONNSETUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+/* A cycle starts at the boot event, or when scanning or advertising
+ * restarts after a disconnection, and completes at the first data. Each
+ * milestone is taken the first time its event comes in a cycle, whatever
+ * the order. Two histograms are kept per milestone, in microseconds: the
+ * time since the start of the cycle, and the phase, the time since the
+ * milestone reached just before it. Percentiles are bucket upper bounds,
+ * so within a factor of two, min, mean and max are exact.
+ *
+ * Starting a cycle before the last one completed abandons it, it is
+ * counted by the last milestone it reached. Every cycle, completed or
+ * not, is handed to the callback given to CONNSETUP_Init().
+ *
+ * Timestamps are RTCC ticks passed in by the caller, so nothing here
+ * touches the hardware. Everything runs from the main loop. */
+
+typedef enum {
+	CONNSETUP_START,						// Boot, or scanning or advertising restarted
+	CONNSETUP_FOUND,						// Master: a scan report matched, connect sent
+	CONNSETUP_OPENED,
+	CONNSETUP_PARAMETERS,					// First connection parameters event
+	CONNSETUP_MTU,
+	CONNSETUP_CCCD_NOTIFY,					// Notifications enabled
+	CONNSETUP_CCCD_INDICATE,				// Indications enabled
+	CONNSETUP_FIRST_DATA,					// First data sent or received, completes the cycle
+	CONNSETUP_MILESTONES
+} CONNSETUP_Milestone_t;
+
+typedef struct {
+	uint16_t cycle;							// Cycle number since the counters were cleared
+	uint16_t reached;						// Bit per milestone reached
+	uint32_t start;							// RTCC at CONNSETUP_START
+	uint32_t ticks[CONNSETUP_MILESTONES];	// RTCC ticks since CONNSETUP_START
+} CONNSETUP_Cycle_t;
+
+typedef struct {
+	uint32_t cycles;						// Cycles started
+	uint32_t completed;						// Cycles that reached the first data
+	uint32_t stalled[CONNSETUP_MILESTONES];	// Abandoned cycles by the last milestone reached
+} CONNSETUP_Stats_t;
+
+typedef void (*CONNSETUP_Done_t)(const CONNSETUP_Cycle_t *cycle, bool completed);
+
+void CONNSETUP_Init(CONNSETUP_Done_t done);
+void CONNSETUP_Clear(void);
+void CONNSETUP_Start(uint32_t now);
+bool CONNSETUP_Mark(CONNSETUP_Milestone_t milestone, uint32_t now);
+bool CONNSETUP_Reached(CONNSETUP_Milestone_t milestone);
+const char *CONNSETUP_Name(CONNSETUP_Milestone_t milestone);
+const HISTOGRAM_t *CONNSETUP_Elapsed(CONNSETUP_Milestone_t milestone);
+const HISTOGRAM_t *CONNSETUP_Phase(CONNSETUP_Milestone_t milestone);
+void CONNSETUP_GetStats(CONNSETUP_Stats_t *stats);
+
+#endif
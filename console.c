@@ -0,0 +1,198 @@
+/***************************************************************************//**
+ * @file
+ * @brief Line oriented serial command console
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "console.h"
+
+/**************************************************************************//**
+* @brief Attach a command table and start with an empty line
+*****************************************************************************/
+void CONSOLE_Init(CONSOLE_t *console, const CONSOLE_Command_t *commands, uint32_t count)
+{
+	console->commands = commands;
+	console->count = count;
+	console->len = 0;
+	console->overflow = false;
+	console->cr = false;
+}
+
+/**************************************************************************//**
+* @brief Feed one received character. CR, LF or CRLF end a line, backspace and
+* DEL remove the last character.
+* @return CONSOLE_PENDING until a line is complete, then the result of running it
+*****************************************************************************/
+CONSOLE_Status_t CONSOLE_Input(CONSOLE_t *console, char c)
+{
+	CONSOLE_Status_t status;
+	bool cr = console->cr;
+
+	console->cr = (c == '\r');
+	if(c == '\n' && cr)
+	{
+		return CONSOLE_PENDING;
+	}
+
+	if(c == '\r' || c == '\n')
+	{
+		if(console->overflow)
+		{
+			status = CONSOLE_OVERFLOW;
+		}
+		else
+		{
+			console->line[console->len] = '\0';
+			status = CONSOLE_Execute(console, console->line);
+		}
+		console->len = 0;
+		console->overflow = false;
+		return status;
+	}
+
+	if(c == '\b' || c == 0x7F)
+	{
+		if(console->len > 0)
+		{
+			console->len--;
+		}
+		return CONSOLE_PENDING;
+	}
+
+	if(console->len < (CONSOLE_LINE_SIZE - 1))
+	{
+		console->line[console->len++] = c;
+	}
+	else
+	{
+		console->overflow = true;
+	}
+
+	return CONSOLE_PENDING;
+}
+
+/**************************************************************************//**
+* @brief Split a line into words in place and run the matching command
+*****************************************************************************/
+CONSOLE_Status_t CONSOLE_Execute(const CONSOLE_t *console, char *line)
+{
+	char *argv[CONSOLE_MAX_ARGS];
+	int argc = 0;
+
+	while(*line)
+	{
+		while(*line == ' ' || *line == '\t')
+		{
+			*line++ = '\0';
+		}
+		if(*line == '\0')
+		{
+			break;
+		}
+		if(argc == CONSOLE_MAX_ARGS)
+		{
+			return CONSOLE_USAGE;
+		}
+		argv[argc++] = line;
+		while(*line && *line != ' ' && *line != '\t')
+		{
+			line++;
+		}
+	}
+
+	if(argc == 0)
+	{
+		return CONSOLE_EMPTY;
+	}
+
+	for(uint32_t i = 0; i < console->count; i++)
+	{
+		if(strcmp(argv[0], console->commands[i].name) == 0)
+		{
+			return console->commands[i].handler(argc, argv);
+		}
+	}
+
+	return CONSOLE_UNKNOWN;
+}
+
+/**************************************************************************//**
+* @brief Parse a decimal or 0x prefixed hexadecimal number
+* @return false if text is empty, has trailing garbage or does not fit 32 bits
+*****************************************************************************/
+bool CONSOLE_ParseUint(const char *text, uint32_t *value)
+{
+	uint32_t base = 10;
+	uint32_t result = 0;
+	uint32_t digit;
+
+	if(text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+	{
+		base = 16;
+		text += 2;
+	}
+	if(*text == '\0')
+	{
+		return false;
+	}
+
+	for(; *text; text++)
+	{
+		if(*text >= '0' && *text <= '9')
+		{
+			digit = *text - '0';
+		}
+		else if(base == 16 && *text >= 'a' && *text <= 'f')
+		{
+			digit = *text - 'a' + 10;
+		}
+		else if(base == 16 && *text >= 'A' && *text <= 'F')
+		{
+			digit = *text - 'A' + 10;
+		}
+		else
+		{
+			return false;
+		}
+
+		if(result > (UINT32_MAX - digit) / base)
+		{
+			return false;
+		}
+		result = result * base + digit;
+	}
+
+	*value = result;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Short reply for a completed line
+*****************************************************************************/
+const char *CONSOLE_StatusString(CONSOLE_Status_t status)
+{
+	switch(status)
+	{
+		case CONSOLE_OK:		return "OK";
+		case CONSOLE_UNKNOWN:	return "ERR unknown command";
+		case CONSOLE_USAGE:		return "ERR usage";
+		case CONSOLE_BUSY:		return "ERR busy";
+		case CONSOLE_NOT_READY:	return "ERR not connected";
+		case CONSOLE_OVERFLOW:	return "ERR line too long";
+		default:				return "";
+	}
+}
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file
+ * @brief Line oriented serial command console
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The console only assembles and dispatches lines. It does not touch the
+ * hardware or the stack, so it can be built and exercised on a host. */
+
+#ifndef CONSOLE_LINE_SIZE
+#define CONSOLE_LINE_SIZE	64		// Longest accepted line, including the terminator
+#endif
+#define CONSOLE_MAX_ARGS	6		// Command name plus up to 5 arguments
+
+typedef enum {
+	CONSOLE_PENDING = 0,			// Line not complete yet
+	CONSOLE_OK,						// Command executed
+	CONSOLE_EMPTY,					// Blank line, nothing to do
+	CONSOLE_UNKNOWN,				// No such command
+	CONSOLE_USAGE,					// Wrong number or format of arguments
+	CONSOLE_BUSY,					// Not allowed while a run is active
+	CONSOLE_NOT_READY,				// Not allowed in the current link state
+	CONSOLE_OVERFLOW				// Line longer than CONSOLE_LINE_SIZE, discarded
+} CONSOLE_Status_t;
+
+typedef CONSOLE_Status_t (*CONSOLE_Handler_t)(int argc, char **argv);
+
+typedef struct {
+	const char *name;				// First word of the line
+	const char *usage;				// Argument summary printed by help
+	CONSOLE_Handler_t handler;		// Called with argv[0] == name
+} CONSOLE_Command_t;
+
+typedef struct {
+	const CONSOLE_Command_t *commands;
+	uint32_t count;
+	char line[CONSOLE_LINE_SIZE];
+	uint32_t len;
+	bool overflow;
+	bool cr;						// Last character was CR, a LF right after it is part of the same ending
+} CONSOLE_t;
+
+void CONSOLE_Init(CONSOLE_t *console, const CONSOLE_Command_t *commands, uint32_t count);
+CONSOLE_Status_t CONSOLE_Input(CONSOLE_t *console, char c);
+CONSOLE_Status_t CONSOLE_Execute(const CONSOLE_t *console, char *line);
+bool CONSOLE_ParseUint(const char *text, uint32_t *value);
+const char *CONSOLE_StatusString(CONSOLE_Status_t status);
+
+#endif
@@ -0,0 +1,263 @@
+/***************************************************************************//**
+ * @file
+ * @brief Duration of interrupt disabled sections taken through em_core
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef CRITPROF_HOST_MODEL
+#include "em_device.h"
+#include "em_core.h"
+#endif
+
+#include "critprof.h"
+
+#ifdef CRITPROF_HOST_MODEL
+uint32_t CRITPROF_HostCycles;
+uint32_t CRITPROF_HostPrimask;
+
+#define CYCLES()				CRITPROF_HostCycles
+#define PRIMASK()				CRITPROF_HostPrimask
+#define IRQ_OFF()				(CRITPROF_HostPrimask = 1)
+#define IRQ_ON()				(CRITPROF_HostPrimask = 0)
+#define BARRIER()
+#else
+#define CYCLES()				DWT->CYCCNT
+#define PRIMASK()				__get_PRIMASK()
+#define IRQ_OFF()				__disable_irq()
+#define IRQ_ON()				__enable_irq()
+#define BARRIER()				__ISB()
+#endif
+
+/* Return address of the function it is used in, without the Thumb bit */
+#define CALLER()				((uint32_t)(uintptr_t)__builtin_return_address(0) & ~1u)
+
+static HISTOGRAM_t histogram;
+static CRITPROF_Stats_t stats;
+static bool running;
+static bool open;							// A window is being timed
+static uint32_t openCycles;
+static uint32_t openPc;
+static uint32_t callerFloor;				// Shortest window in a full caller table, 0 until it is full
+
+void CRITPROF_Start(void)
+{
+	uint32_t primask = PRIMASK();
+
+	IRQ_OFF();
+#ifndef CRITPROF_HOST_MODEL
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	HISTOGRAM_Reset(&histogram);
+	memset(&stats, 0, sizeof(stats));
+	callerFloor = 0;
+	open = false;
+	running = CRITPROF_ENABLE;
+	if(primask == 0)
+	{
+		IRQ_ON();
+	}
+}
+
+void CRITPROF_Stop(void)
+{
+	uint32_t primask = PRIMASK();
+
+	IRQ_OFF();
+	running = false;
+	open = false;
+	if(primask == 0)
+	{
+		IRQ_ON();
+	}
+}
+
+void CRITPROF_Get(CRITPROF_Stats_t *statsOut, HISTOGRAM_t *histogramOut)
+{
+	uint32_t primask = PRIMASK();
+
+	IRQ_OFF();
+	*statsOut = stats;
+	*histogramOut = histogram;
+	if(primask == 0)
+	{
+		IRQ_ON();
+	}
+}
+
+/**************************************************************************//**
+* @brief Keeps the longest window of each of the callers with the longest
+* windows, longest first
+*****************************************************************************/
+static void callerAdd(uint32_t pc, uint32_t cycles)
+{
+	CRITPROF_Caller_t *callers = stats.callers;
+	uint32_t i;
+
+	for(i = 0; i < CRITPROF_CALLERS - 1; i++)
+	{
+		if(callers[i].pc == pc || callers[i].pc == 0)
+		{
+			break;
+		}
+	}
+	/* Here, the last slot, or the shortest window of a full table */
+	if(callers[i].pc == pc && callers[i].maxCycles >= cycles)
+	{
+		return;
+	}
+	if(callers[i].pc != pc && callers[i].pc != 0 && callers[i].maxCycles >= cycles)
+	{
+		return;
+	}
+	callers[i].pc = pc;
+	callers[i].maxCycles = cycles;
+	for(; i > 0 && callers[i - 1].maxCycles < cycles; i--)
+	{
+		CRITPROF_Caller_t swap = callers[i - 1];
+
+		callers[i - 1] = callers[i];
+		callers[i] = swap;
+	}
+	callerFloor = (callers[CRITPROF_CALLERS - 1].pc != 0) ? callers[CRITPROF_CALLERS - 1].maxCycles : 0;
+}
+
+static void opened(uint32_t now, uint32_t pc)
+{
+	if(running)
+	{
+		open = true;
+		openCycles = now;
+		openPc = pc;
+	}
+}
+
+static void closed(uint32_t now)
+{
+	uint32_t cycles;
+
+	if(!open)
+	{
+		return;
+	}
+	open = false;
+	cycles = now - openCycles;
+	HISTOGRAM_Add(&histogram, cycles);
+	if(cycles > stats.maxCycles)
+	{
+		stats.maxCycles = cycles;
+		stats.maxPc = openPc;
+	}
+	/* Most windows are short, they cannot get into a full table */
+	if(cycles > callerFloor)
+	{
+		callerAdd(openPc, cycles);
+	}
+}
+
+#if CRITPROF_ENABLE
+static CORE_irqState_t enter(uint32_t pc)
+{
+	CORE_irqState_t irqState = PRIMASK();
+
+	IRQ_OFF();
+	if(irqState == 0)
+	{
+		opened(CYCLES(), pc);
+	}
+	return irqState;
+}
+
+static void leave(CORE_irqState_t irqState)
+{
+	if(irqState == 0)
+	{
+		closed(CYCLES());
+		IRQ_ON();
+	}
+}
+
+static void yield(void)
+{
+	if((PRIMASK() & 1) != 0)
+	{
+		bool wasOpen = open;
+
+		closed(CYCLES());
+		IRQ_ON();
+		BARRIER();
+		IRQ_OFF();
+		if(wasOpen)
+		{
+			stats.yields++;
+			opened(CYCLES(), openPc);
+		}
+	}
+}
+
+/* The em_core.c functions. With the PRIMASK method ATOMIC is CRITICAL */
+
+CORE_irqState_t CORE_EnterCritical(void)
+{
+	return enter(CALLER());
+}
+
+void CORE_ExitCritical(CORE_irqState_t irqState)
+{
+	leave(irqState);
+}
+
+void CORE_YieldCritical(void)
+{
+	yield();
+}
+
+CORE_irqState_t CORE_EnterAtomic(void)
+{
+	return enter(CALLER());
+}
+
+void CORE_ExitAtomic(CORE_irqState_t irqState)
+{
+	leave(irqState);
+}
+
+void CORE_YieldAtomic(void)
+{
+	yield();
+}
+
+void CORE_CriticalDisableIrq(void)
+{
+	(void)enter(CALLER());
+}
+
+void CORE_CriticalEnableIrq(void)
+{
+	leave(0);
+}
+
+void CORE_AtomicDisableIrq(void)
+{
+	(void)enter(CALLER());
+}
+
+void CORE_AtomicEnableIrq(void)
+{
+	leave(0);
+}
+#endif
@@ -0,0 +1,87 @@
+/***************************************************************************//**
+ * @file
+ * @brief Duration of interrupt disabled sections taken through em_core
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CRITPROF_H_
+#define CRITPROF_H_
+
+#include <stdint.h>
+
+#include "histogram.h"
+
+/* With CRITPROF_ENABLE set, critprof.c replaces the SL_WEAK enter, exit,
+ * yield and disable/enable functions of em_core.c, so every CRITICAL and
+ * ATOMIC section of the drivers and the application is seen. CORE_ATOMIC_METHOD
+ * is left at PRIMASK, both kinds mask every interrupt and are timed alike.
+ *
+ * A window runs from the DWT cycle count read just after interrupts go off
+ * to the one read just before they come back on. Nested sections are one
+ * window, opened and closed by the outermost. A yield closes the window and
+ * opens another for the same caller. The caller is the return address of the
+ * outermost enter, the instruction after the call in the function that took
+ * the section. The longest window is kept with its caller, and the longest
+ * window of each of the CRITPROF_CALLERS callers with the longest ones.
+ *
+ * Not seen: __disable_irq() called directly, as the Bluetooth stack library
+ * and RAIL do, and the bookkeeping itself, which runs with interrupts off
+ * after the closing count and so lengthens each window a little beyond what
+ * is reported. Bookkeeping happens with interrupts off, so the histogram is
+ * only ever fed from one context at a time, and CRITPROF_Get() copies the
+ * figures with interrupts off too. The histogram is in core cycles.
+ *
+ * With -DCRITPROF_HOST_MODEL the cycle counter and PRIMASK are plain
+ * variables and the overrides build on a PC, see tools/critprof_check.c. */
+
+#ifndef CRITPROF_ENABLE
+#define CRITPROF_ENABLE			1			// 0 leaves em_core.c as it is, nothing is then recorded
+#endif
+#define CRITPROF_CALLERS		8
+
+typedef struct {
+	uint32_t pc;							// Return address of the outermost enter, 0 for a free slot
+	uint32_t maxCycles;
+} CRITPROF_Caller_t;
+
+typedef struct {
+	uint32_t maxCycles;
+	uint32_t maxPc;
+	uint32_t yields;
+	CRITPROF_Caller_t callers[CRITPROF_CALLERS];	// Longest first
+} CRITPROF_Stats_t;
+
+#ifdef CRITPROF_HOST_MODEL
+typedef uint32_t CORE_irqState_t;
+
+extern uint32_t CRITPROF_HostCycles;
+extern uint32_t CRITPROF_HostPrimask;
+
+CORE_irqState_t CORE_EnterCritical(void);
+void CORE_ExitCritical(CORE_irqState_t irqState);
+void CORE_YieldCritical(void);
+CORE_irqState_t CORE_EnterAtomic(void);
+void CORE_ExitAtomic(CORE_irqState_t irqState);
+void CORE_YieldAtomic(void);
+void CORE_CriticalDisableIrq(void);
+void CORE_CriticalEnableIrq(void);
+void CORE_AtomicDisableIrq(void);
+void CORE_AtomicEnableIrq(void);
+#endif
+
+void CRITPROF_Start(void);
+void CRITPROF_Stop(void);
+void CRITPROF_Get(CRITPROF_Stats_t *stats, HISTOGRAM_t *histogram);
+
+#endif
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+ * @file
+ * @brief Crypto backend selection, known answer tests and benchmark
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#ifdef CRYPTOBACKEND_SOFTWARE_ONLY
+#include <time.h>
+#else
+#include "em_device.h"
+#include "em_cmu.h"
+#endif
+
+#include "cryptobackend.h"
+
+#define BLOCK				CRYPTOBACKEND_AES_BLOCK
+#define MUL_BITS			128
+#define COMPARE_ROUNDS		8
+
+#ifdef CRYPTOBACKEND_SOFTWARE_ONLY
+const CRYPTOBACKEND_t *CRYPTOBACKEND_Active = &CRYPTOBACKEND_Software;
+#else
+const CRYPTOBACKEND_t *CRYPTOBACKEND_Active = &CRYPTOBACKEND_Hardware;
+#endif
+
+static const char *operationNames[CRYPTOBACKEND_OPERATIONS] = {
+	"ecb-enc", "ecb-dec", "cbc-enc", "cbc-dec", "ctr", "sha1", "sha256", "mul",
+};
+
+/* NIST SP 800-38A appendix F, the same key and plaintext for every mode */
+static const uint8_t key[BLOCK] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t plain[4 * BLOCK] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+static const uint8_t ecbCipher[4 * BLOCK] = {							// F.1.1
+	0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+	0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+	0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+	0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4,
+};
+static const uint8_t cbcIv[BLOCK] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+static const uint8_t cbcCipher[4 * BLOCK] = {							// F.2.1
+	0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+	0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+	0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+	0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+static const uint8_t ctrInitial[BLOCK] = {
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+static const uint8_t ctrCipher[4 * BLOCK] = {							// F.5.1
+	0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+	0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+	0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+	0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+};
+
+/* FIPS 180-2 appendices A and B */
+static const char *shaMessages[] = {
+	"",
+	"abc",
+	"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+};
+static const uint8_t sha1Digests[][CRYPTOBACKEND_SHA1_SIZE] = {
+	{ 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55, 0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 },
+	{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+	{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+};
+static const uint8_t sha256Digests[][CRYPTOBACKEND_SHA256_SIZE] = {
+	{ 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+	  0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 },
+	{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+	  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+};
+
+/* (2^128 - 1)^2 = 2^256 - 2^129 + 1, little endian words */
+static const uint32_t mulAllOnes[MUL_BITS / 32] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+static const uint32_t mulSquare[2 * MUL_BITS / 32] = {
+	0x00000001, 0x00000000, 0x00000000, 0x00000000, 0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+};
+
+/* Shared by the self test and the benchmark, words so SHA takes the hardware path */
+static uint32_t bufferIn[CRYPTOBACKEND_BENCH_MAX / 4];
+static uint32_t bufferOut[CRYPTOBACKEND_BENCH_MAX / 4];
+static uint32_t bufferOther[CRYPTOBACKEND_BENCH_MAX / 4];
+static uint32_t mulResult[2 * CRYPTOBACKEND_BENCH_MAX / 4];
+
+uint32_t CRYPTOBACKEND_Cycles(void)
+{
+#ifdef CRYPTOBACKEND_SOFTWARE_ONLY
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+/**************************************************************************//**
+* @brief Rate of CRYPTOBACKEND_Cycles(), the core clock on the target and
+* nanoseconds on a PC
+*****************************************************************************/
+uint32_t CRYPTOBACKEND_CyclesPerSecond(void)
+{
+#ifdef CRYPTOBACKEND_SOFTWARE_ONLY
+	return 1000000000u;
+#else
+	return CMU_ClockFreqGet(cmuClock_CORE);
+#endif
+}
+
+const char *CRYPTOBACKEND_OperationName(CRYPTOBACKEND_Operation_t operation)
+{
+	return (operation < CRYPTOBACKEND_OPERATIONS) ? operationNames[operation] : "?";
+}
+
+static uint32_t check(const void *got, const void *expected, uint32_t len)
+{
+	return (memcmp(got, expected, len) != 0) ? 1 : 0;
+}
+
+static uint32_t knownAnswers(const CRYPTOBACKEND_t *backend)
+{
+	uint8_t *out = (uint8_t *)bufferOut;
+	uint8_t *in = (uint8_t *)bufferIn;
+	uint8_t ctr[BLOCK];
+	uint8_t digest[CRYPTOBACKEND_SHA256_SIZE];
+	uint32_t failures = 0;
+
+	backend->aesEcb128(out, plain, sizeof(plain), key, true);
+	failures += check(out, ecbCipher, sizeof(ecbCipher));
+	backend->aesEcb128(out, out, sizeof(ecbCipher), key, false);
+	failures += check(out, plain, sizeof(plain));
+
+	backend->aesCbc128(out, plain, sizeof(plain), key, cbcIv, true);
+	failures += check(out, cbcCipher, sizeof(cbcCipher));
+	backend->aesCbc128(out, out, sizeof(cbcCipher), key, cbcIv, false);
+	failures += check(out, plain, sizeof(plain));
+
+	memcpy(ctr, ctrInitial, BLOCK);
+	backend->aesCtr128(out, plain, sizeof(plain), key, ctr);
+	failures += check(out, ctrCipher, sizeof(ctrCipher));
+	failures += (ctr[15] != (uint8_t)(ctrInitial[15] + 4)) ? 1 : 0;
+
+	for(uint32_t m = 0; m < sizeof(shaMessages) / sizeof(shaMessages[0]); m++)
+	{
+		uint32_t len = (uint32_t)strlen(shaMessages[m]);
+
+		memcpy(in, shaMessages[m], len);
+		backend->sha1(in, len, digest);
+		failures += check(digest, sha1Digests[m], CRYPTOBACKEND_SHA1_SIZE);
+		backend->sha256(in, len, digest);
+		failures += check(digest, sha256Digests[m], CRYPTOBACKEND_SHA256_SIZE);
+	}
+
+	backend->mul(mulAllOnes, mulAllOnes, mulResult, MUL_BITS);
+	failures += check(mulResult, mulSquare, sizeof(mulSquare));
+
+	return failures;
+}
+
+/**************************************************************************//**
+* @brief Runs backend and the software backend on the same pseudo-random
+* inputs, at lengths that cross CRYPTOBACKEND_HW_CHUNK and the 64 byte SHA
+* block, and counts the operations that disagree
+*****************************************************************************/
+static uint32_t compareWithSoftware(const CRYPTOBACKEND_t *backend)
+{
+	static const uint32_t lengths[] = { 16, 48, 64, 80, 240, 1024 };
+	const CRYPTOBACKEND_t *sw = &CRYPTOBACKEND_Software;
+	uint8_t *in = (uint8_t *)bufferIn;
+	uint8_t *out = (uint8_t *)bufferOut;
+	uint8_t *other = (uint8_t *)bufferOther;
+	uint8_t k[BLOCK];
+	uint8_t iv[BLOCK];
+	uint8_t ctrA[BLOCK];
+	uint8_t ctrB[BLOCK];
+	uint8_t digest[2][CRYPTOBACKEND_SHA256_SIZE];
+	uint32_t x = 0x2545f491;
+	uint32_t failures = 0;
+
+	for(uint32_t round = 0; round < COMPARE_ROUNDS; round++)
+	{
+		uint32_t len = lengths[round % (sizeof(lengths) / sizeof(lengths[0]))];
+
+		if(len > CRYPTOBACKEND_BENCH_MAX)
+		{
+			len = CRYPTOBACKEND_BENCH_MAX;
+		}
+		for(uint32_t i = 0; i < CRYPTOBACKEND_BENCH_MAX; i++)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			in[i] = (uint8_t)x;
+		}
+		memcpy(k, in + 1, BLOCK);
+		memcpy(iv, in + 1 + BLOCK, BLOCK);
+		memcpy(ctrA, in + 1 + 2 * BLOCK, BLOCK);
+		memcpy(ctrB, ctrA, BLOCK);
+
+		for(uint32_t encrypt = 0; encrypt < 2; encrypt++)
+		{
+			backend->aesEcb128(out, in, len, k, encrypt);
+			sw->aesEcb128(other, in, len, k, encrypt);
+			failures += check(out, other, len);
+			backend->aesCbc128(out, in, len, k, iv, encrypt);
+			sw->aesCbc128(other, in, len, k, iv, encrypt);
+			failures += check(out, other, len);
+		}
+		backend->aesCtr128(out, in, len, k, ctrA);
+		sw->aesCtr128(other, in, len, k, ctrB);
+		failures += check(out, other, len) + check(ctrA, ctrB, BLOCK);
+
+		backend->sha1(in, len - round, digest[0]);
+		sw->sha1(in, len - round, digest[1]);
+		failures += check(digest[0], digest[1], CRYPTOBACKEND_SHA1_SIZE);
+		backend->sha256(in, len - round, digest[0]);
+		sw->sha256(in, len - round, digest[1]);
+		failures += check(digest[0], digest[1], CRYPTOBACKEND_SHA256_SIZE);
+
+		if(len % BLOCK == 0 && 2 * len <= sizeof(mulResult))
+		{
+			uint32_t bits = (len * 8 / 2) & ~(MUL_BITS - 1);
+
+			if(bits != 0)
+			{
+				backend->mul(bufferIn, bufferIn + bits / 32, mulResult, bits);
+				memcpy(other, mulResult, bits / 4);
+				sw->mul(bufferIn, bufferIn + bits / 32, mulResult, bits);
+				failures += check(other, mulResult, bits / 4);
+			}
+		}
+	}
+
+	return failures;
+}
+
+/**************************************************************************//**
+* @brief Known answer tests from NIST SP 800-38A and FIPS 180-2, and for any
+* backend but the software one a comparison with it
+* @return Number of checks that failed
+*****************************************************************************/
+uint32_t CRYPTOBACKEND_SelfTest(const CRYPTOBACKEND_t *backend)
+{
+	uint32_t failures = knownAnswers(backend);
+
+	if(backend != &CRYPTOBACKEND_Software)
+	{
+		failures += compareWithSoftware(backend);
+	}
+	return failures;
+}
+
+/**************************************************************************//**
+* @brief Times one operation on a buffer of size bytes, operands of size
+* bytes each for mul
+* @return Average CRYPTOBACKEND_Cycles() per call, 0 if size does not fit
+*****************************************************************************/
+uint32_t CRYPTOBACKEND_Bench(const CRYPTOBACKEND_t *backend, CRYPTOBACKEND_Operation_t operation, uint32_t size, uint32_t iterations)
+{
+	uint8_t *in = (uint8_t *)bufferIn;
+	uint8_t *out = (uint8_t *)bufferOut;
+	uint8_t ctr[BLOCK];
+	uint8_t digest[CRYPTOBACKEND_SHA256_SIZE];
+	uint32_t start;
+	uint64_t total;
+
+	if(size == 0 || size > CRYPTOBACKEND_BENCH_MAX || iterations == 0)
+	{
+		return 0;
+	}
+	if(operation == CRYPTOBACKEND_MUL && (size % BLOCK != 0 || size > CRYPTOBACKEND_BENCH_MAX / 2))
+	{
+		return 0;
+	}
+	if(operation <= CRYPTOBACKEND_CTR && size % BLOCK != 0)
+	{
+		return 0;
+	}
+
+	memset(in, 0x5a, size);
+	memset(ctr, 0, sizeof(ctr));
+	start = CRYPTOBACKEND_Cycles();
+	for(uint32_t i = 0; i < iterations; i++)
+	{
+		switch(operation)
+		{
+			case CRYPTOBACKEND_ECB_ENCRYPT:
+			case CRYPTOBACKEND_ECB_DECRYPT:
+				backend->aesEcb128(out, in, size, key, operation == CRYPTOBACKEND_ECB_ENCRYPT);
+				break;
+			case CRYPTOBACKEND_CBC_ENCRYPT:
+			case CRYPTOBACKEND_CBC_DECRYPT:
+				backend->aesCbc128(out, in, size, key, cbcIv, operation == CRYPTOBACKEND_CBC_ENCRYPT);
+				break;
+			case CRYPTOBACKEND_CTR:
+				backend->aesCtr128(out, in, size, key, ctr);
+				break;
+			case CRYPTOBACKEND_SHA1:
+				backend->sha1(in, size, digest);
+				break;
+			case CRYPTOBACKEND_SHA256:
+				backend->sha256(in, size, digest);
+				break;
+			case CRYPTOBACKEND_MUL:
+				backend->mul(bufferIn, bufferIn + size / 4, mulResult, size * 8);
+				break;
+			default:
+				return 0;
+		}
+	}
+	total = (uint32_t)(CRYPTOBACKEND_Cycles() - start);
+
+	return (uint32_t)(total / iterations);
+}
@@ -0,0 +1,94 @@
+/***************************************************************************//**
+ * @file
+ * @brief AES, SHA and big integer multiply on the CRYPTO peripheral or in
+ * software behind one interface
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CRYPTOBACKEND_H_
+#define CRYPTOBACKEND_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The operations em_crypto.c offers, with the same byte order, so either
+ * backend gives the same bytes:
+ *   - AES-128 lengths are whole 16 byte blocks, out may equal in. Keys are
+ *     always the encryption key, the hardware backend makes the decryption
+ *     key itself. CTR increments the last 32 bits of ctr big endian and
+ *     leaves the next counter in it.
+ *   - SHA digests are 20 and 32 bytes.
+ *   - mul multiplies two little endian numbers of bits bits, a multiple of
+ *     128, into r of 2 * bits bits.
+ *
+ * cryptobackend_hw.c drives the CRYPTO peripheral. The Bluetooth stack uses
+ * it from its interrupts, so AES runs with interrupts off
+ * CRYPTOBACKEND_HW_CHUNK bytes at a time and a SHA or a multiply for the
+ * whole call. The peripheral reads SHA messages a word at a time, unaligned
+ * ones go to the software backend.
+ *
+ * cryptobackend_sw.c is plain C from FIPS-197 and FIPS 180-4 and builds
+ * anywhere. With -DCRYPTOBACKEND_SOFTWARE_ONLY nothing refers to the
+ * hardware backend, which is how the host tools build. */
+
+#define CRYPTOBACKEND_AES_BLOCK		16
+#define CRYPTOBACKEND_SHA1_SIZE		20
+#define CRYPTOBACKEND_SHA256_SIZE	32
+
+#ifndef CRYPTOBACKEND_HW_CHUNK
+#define CRYPTOBACKEND_HW_CHUNK		64			// AES bytes per stretch with interrupts off
+#endif
+#ifndef CRYPTOBACKEND_BENCH_MAX
+#define CRYPTOBACKEND_BENCH_MAX		1024		// Largest buffer CRYPTOBACKEND_Bench() takes
+#endif
+
+typedef struct {
+	const char *name;
+	void (*aesEcb128)(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, bool encrypt);
+	void (*aesCbc128)(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, const uint8_t *iv, bool encrypt);
+	void (*aesCtr128)(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, uint8_t *ctr);
+	void (*sha1)(const uint8_t *msg, uint32_t len, uint8_t *digest);
+	void (*sha256)(const uint8_t *msg, uint32_t len, uint8_t *digest);
+	void (*mul)(const uint32_t *a, const uint32_t *b, uint32_t *r, uint32_t bits);
+} CRYPTOBACKEND_t;
+
+/* What CRYPTOBACKEND_Bench() measures, size is the buffer or operand size */
+typedef enum {
+	CRYPTOBACKEND_ECB_ENCRYPT,
+	CRYPTOBACKEND_ECB_DECRYPT,
+	CRYPTOBACKEND_CBC_ENCRYPT,
+	CRYPTOBACKEND_CBC_DECRYPT,
+	CRYPTOBACKEND_CTR,
+	CRYPTOBACKEND_SHA1,
+	CRYPTOBACKEND_SHA256,
+	CRYPTOBACKEND_MUL,
+	CRYPTOBACKEND_OPERATIONS
+} CRYPTOBACKEND_Operation_t;
+
+extern const CRYPTOBACKEND_t CRYPTOBACKEND_Software;
+#ifndef CRYPTOBACKEND_SOFTWARE_ONLY
+extern const CRYPTOBACKEND_t CRYPTOBACKEND_Hardware;
+#endif
+
+/* Backend the application's crypto users go through, the hardware one
+ * unless built with CRYPTOBACKEND_SOFTWARE_ONLY */
+extern const CRYPTOBACKEND_t *CRYPTOBACKEND_Active;
+
+uint32_t CRYPTOBACKEND_Cycles(void);
+uint32_t CRYPTOBACKEND_CyclesPerSecond(void);
+const char *CRYPTOBACKEND_OperationName(CRYPTOBACKEND_Operation_t operation);
+uint32_t CRYPTOBACKEND_SelfTest(const CRYPTOBACKEND_t *backend);
+uint32_t CRYPTOBACKEND_Bench(const CRYPTOBACKEND_t *backend, CRYPTOBACKEND_Operation_t operation, uint32_t size, uint32_t iterations);
+
+#endif
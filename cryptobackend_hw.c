@@ -0,0 +1,185 @@
+/***************************************************************************//**
+ * @file
+ * @brief CRYPTO peripheral backend over em_crypto
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef CRYPTOBACKEND_SOFTWARE_ONLY
+
+#include <string.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_crypto.h"
+
+#include "cryptobackend.h"
+
+#define BLOCK				CRYPTOBACKEND_AES_BLOCK
+
+_Static_assert((CRYPTOBACKEND_HW_CHUNK % BLOCK) == 0, "CRYPTOBACKEND_HW_CHUNK must be whole blocks");
+
+static bool clockOn;
+static uint8_t decryptKey[BLOCK];			// Made from encryptKey
+static uint8_t encryptKey[BLOCK];
+static bool decryptKeyValid;
+
+static void clockEnable(void)
+{
+	if(!clockOn)
+	{
+		CMU_ClockEnable(cmuClock_CRYPTO0, true);
+		clockOn = true;
+	}
+}
+
+/* The peripheral decrypts with the last round key, made once per key */
+static const uint8_t *decryptKeyFor(const uint8_t *key)
+{
+	CORE_DECLARE_IRQ_STATE;
+
+	if(!decryptKeyValid || memcmp(encryptKey, key, BLOCK) != 0)
+	{
+		CORE_ENTER_ATOMIC();
+		CRYPTO_AES_DecryptKey128(DEFAULT_CRYPTO, decryptKey, key);
+		CORE_EXIT_ATOMIC();
+		memcpy(encryptKey, key, BLOCK);
+		decryptKeyValid = true;
+	}
+	return decryptKey;
+}
+
+static void aesEcb128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, bool encrypt)
+{
+	const uint8_t *k;
+	CORE_DECLARE_IRQ_STATE;
+
+	clockEnable();
+	k = encrypt ? key : decryptKeyFor(key);
+	len -= len % BLOCK;
+	for(uint32_t i = 0; i < len; i += CRYPTOBACKEND_HW_CHUNK)
+	{
+		uint32_t chunk = (len - i < CRYPTOBACKEND_HW_CHUNK) ? len - i : CRYPTOBACKEND_HW_CHUNK;
+
+		CORE_ENTER_ATOMIC();
+		CRYPTO_AES_ECB128(DEFAULT_CRYPTO, &out[i], &in[i], chunk, k, encrypt);
+		CORE_EXIT_ATOMIC();
+	}
+}
+
+/**************************************************************************//**
+* @brief CRYPTO_AES_CBC128() does not give back the last block, so the chain
+* is carried between chunks here: the last ciphertext block out when
+* encrypting, the last one in, saved before out overwrites it, when
+* decrypting
+*****************************************************************************/
+static void aesCbc128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, const uint8_t *iv, bool encrypt)
+{
+	const uint8_t *k;
+	uint8_t chain[BLOCK];
+	uint8_t next[BLOCK];
+	CORE_DECLARE_IRQ_STATE;
+
+	clockEnable();
+	k = encrypt ? key : decryptKeyFor(key);
+	memcpy(chain, iv, BLOCK);
+	len -= len % BLOCK;
+	for(uint32_t i = 0; i < len; i += CRYPTOBACKEND_HW_CHUNK)
+	{
+		uint32_t chunk = (len - i < CRYPTOBACKEND_HW_CHUNK) ? len - i : CRYPTOBACKEND_HW_CHUNK;
+
+		if(!encrypt)
+		{
+			memcpy(next, &in[i + chunk - BLOCK], BLOCK);
+		}
+		CORE_ENTER_ATOMIC();
+		CRYPTO_AES_CBC128(DEFAULT_CRYPTO, &out[i], &in[i], chunk, k, chain, encrypt);
+		CORE_EXIT_ATOMIC();
+		memcpy(chain, encrypt ? &out[i + chunk - BLOCK] : next, BLOCK);
+	}
+}
+
+static void aesCtr128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, uint8_t *ctr)
+{
+	CORE_DECLARE_IRQ_STATE;
+
+	clockEnable();
+	len -= len % BLOCK;
+	for(uint32_t i = 0; i < len; i += CRYPTOBACKEND_HW_CHUNK)
+	{
+		uint32_t chunk = (len - i < CRYPTOBACKEND_HW_CHUNK) ? len - i : CRYPTOBACKEND_HW_CHUNK;
+
+		CORE_ENTER_ATOMIC();
+		CRYPTO_AES_CTR128(DEFAULT_CRYPTO, &out[i], &in[i], chunk, key, ctr, NULL);
+		CORE_EXIT_ATOMIC();
+	}
+}
+
+static void sha1(const uint8_t *msg, uint32_t len, uint8_t *digest)
+{
+	uint32_t aligned[(CRYPTOBACKEND_SHA1_SIZE + 3) / 4];
+	CORE_DECLARE_IRQ_STATE;
+
+	if(((uintptr_t)msg & 3) != 0)
+	{
+		CRYPTOBACKEND_Software.sha1(msg, len, digest);
+		return;
+	}
+
+	clockEnable();
+	CORE_ENTER_ATOMIC();
+	CRYPTO_SHA_1(DEFAULT_CRYPTO, msg, len, (uint8_t *)aligned);
+	CORE_EXIT_ATOMIC();
+	memcpy(digest, aligned, CRYPTOBACKEND_SHA1_SIZE);
+}
+
+static void sha256(const uint8_t *msg, uint32_t len, uint8_t *digest)
+{
+	uint32_t aligned[CRYPTOBACKEND_SHA256_SIZE / 4];
+	CORE_DECLARE_IRQ_STATE;
+
+	if(((uintptr_t)msg & 3) != 0)
+	{
+		CRYPTOBACKEND_Software.sha256(msg, len, digest);
+		return;
+	}
+
+	clockEnable();
+	CORE_ENTER_ATOMIC();
+	CRYPTO_SHA_256(DEFAULT_CRYPTO, msg, len, (uint8_t *)aligned);
+	CORE_EXIT_ATOMIC();
+	memcpy(digest, aligned, CRYPTOBACKEND_SHA256_SIZE);
+}
+
+static void mul(const uint32_t *a, const uint32_t *b, uint32_t *r, uint32_t bits)
+{
+	CORE_DECLARE_IRQ_STATE;
+
+	clockEnable();
+	CORE_ENTER_ATOMIC();
+	CRYPTO_Mul(DEFAULT_CRYPTO, (uint32_t *)a, (int)bits, (uint32_t *)b, (int)bits, r, (int)(2 * bits));
+	CORE_EXIT_ATOMIC();
+}
+
+const CRYPTOBACKEND_t CRYPTOBACKEND_Hardware = {
+	"hardware",
+	aesEcb128,
+	aesCbc128,
+	aesCtr128,
+	sha1,
+	sha256,
+	mul,
+};
+
+#endif
@@ -0,0 +1,484 @@
+/***************************************************************************//**
+ * @file
+ * @brief Software crypto backend, builds on the target and on a PC
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "cryptobackend.h"
+
+#define ROUNDS				10
+#define BLOCK				CRYPTOBACKEND_AES_BLOCK
+
+typedef struct {
+	uint8_t encrypt[16 * (ROUNDS + 1)];
+} Schedule_t;
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static uint8_t inverseSbox[256];			// Built from sbox on first use
+
+static const uint32_t k256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Times {02} in GF(2^8), without a branch on the data */
+static uint8_t xtime(uint8_t x)
+{
+	return (uint8_t)((x << 1) ^ (0x1b & -(x >> 7)));
+}
+
+/* FIPS-197 section 5.1.3 on one column */
+static void mixColumn(uint8_t *col)
+{
+	uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+	uint8_t first = col[0];
+
+	col[0] ^= all ^ xtime(col[0] ^ col[1]);
+	col[1] ^= all ^ xtime(col[1] ^ col[2]);
+	col[2] ^= all ^ xtime(col[2] ^ col[3]);
+	col[3] ^= all ^ xtime(col[3] ^ first);
+}
+
+/* FIPS-197 section 5.2 */
+static void expandKey(const uint8_t *key, Schedule_t *schedule)
+{
+	uint8_t *w = schedule->encrypt;
+	uint8_t rcon = 0x01;
+
+	memcpy(w, key, 16);
+	for(uint32_t i = 16; i < sizeof(schedule->encrypt); i += 4)
+	{
+		uint8_t t[4];
+
+		memcpy(t, &w[i - 4], 4);
+		if((i % 16) == 0)
+		{
+			uint8_t first = t[0];
+
+			t[0] = sbox[t[1]] ^ rcon;
+			t[1] = sbox[t[2]];
+			t[2] = sbox[t[3]];
+			t[3] = sbox[first];
+			rcon = xtime(rcon);
+		}
+		for(uint32_t j = 0; j < 4; j++)
+		{
+			w[i + j] = w[i - 16 + j] ^ t[j];
+		}
+	}
+}
+
+/* FIPS-197 section 5.1, the state is kept column by column as in the input */
+static void encryptBlock(const Schedule_t *schedule, const uint8_t *in, uint8_t *out)
+{
+	const uint8_t *w = schedule->encrypt;
+	uint8_t s[16];
+
+	for(uint32_t i = 0; i < 16; i++)
+	{
+		s[i] = in[i] ^ w[i];
+	}
+
+	for(uint32_t round = 1; round <= ROUNDS; round++)
+	{
+		uint8_t t[16];
+
+		/* SubBytes and ShiftRows */
+		for(uint32_t c = 0; c < 4; c++)
+		{
+			for(uint32_t r = 0; r < 4; r++)
+			{
+				t[4 * c + r] = sbox[s[4 * ((c + r) % 4) + r]];
+			}
+		}
+
+		/* MixColumns, skipped in the last round */
+		if(round != ROUNDS)
+		{
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				mixColumn(&t[4 * c]);
+			}
+		}
+
+		for(uint32_t i = 0; i < 16; i++)
+		{
+			s[i] = t[i] ^ w[16 * round + i];
+		}
+	}
+
+	memcpy(out, s, 16);
+}
+
+/* FIPS-197 section 5.3, the inverse cipher */
+static void decryptBlock(const Schedule_t *schedule, const uint8_t *in, uint8_t *out)
+{
+	const uint8_t *w = schedule->encrypt;
+	uint8_t s[16];
+
+	if(inverseSbox[0] == 0)
+	{
+		for(uint32_t i = 0; i < 256; i++)
+		{
+			inverseSbox[sbox[i]] = (uint8_t)i;
+		}
+	}
+
+	for(uint32_t i = 0; i < 16; i++)
+	{
+		s[i] = in[i] ^ w[16 * ROUNDS + i];
+	}
+
+	for(int32_t round = ROUNDS - 1; round >= 0; round--)
+	{
+		uint8_t t[16];
+
+		/* InvShiftRows and InvSubBytes */
+		for(uint32_t c = 0; c < 4; c++)
+		{
+			for(uint32_t r = 0; r < 4; r++)
+			{
+				t[4 * c + r] = inverseSbox[s[4 * ((c + 4 - r) % 4) + r]];
+			}
+		}
+
+		for(uint32_t i = 0; i < 16; i++)
+		{
+			t[i] ^= w[16 * round + i];
+		}
+
+		/* InvMixColumns, skipped after the last round key. Its matrix is
+		 * MixColumns times {04}x^2 + {05}, so each column is pre-multiplied
+		 * by that and then goes through MixColumns */
+		if(round != 0)
+		{
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				uint8_t *col = &t[4 * c];
+				uint8_t u = xtime(xtime(col[0] ^ col[2]));
+				uint8_t v = xtime(xtime(col[1] ^ col[3]));
+
+				col[0] ^= u;
+				col[1] ^= v;
+				col[2] ^= u;
+				col[3] ^= v;
+				mixColumn(col);
+			}
+		}
+
+		memcpy(s, t, sizeof(s));
+	}
+
+	memcpy(out, s, 16);
+}
+
+static void aesEcb128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, bool encrypt)
+{
+	Schedule_t schedule;
+
+	expandKey(key, &schedule);
+	for(uint32_t i = 0; i + BLOCK <= len; i += BLOCK)
+	{
+		if(encrypt)
+		{
+			encryptBlock(&schedule, &in[i], &out[i]);
+		}
+		else
+		{
+			decryptBlock(&schedule, &in[i], &out[i]);
+		}
+	}
+}
+
+static void aesCbc128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, const uint8_t *iv, bool encrypt)
+{
+	Schedule_t schedule;
+	uint8_t chain[BLOCK];
+	uint8_t block[BLOCK];
+
+	expandKey(key, &schedule);
+	memcpy(chain, iv, BLOCK);
+	for(uint32_t i = 0; i + BLOCK <= len; i += BLOCK)
+	{
+		if(encrypt)
+		{
+			for(uint32_t j = 0; j < BLOCK; j++)
+			{
+				block[j] = in[i + j] ^ chain[j];
+			}
+			encryptBlock(&schedule, block, &out[i]);
+			memcpy(chain, &out[i], BLOCK);
+		}
+		else
+		{
+			/* in may be out, keep the ciphertext for the next block */
+			memcpy(block, &in[i], BLOCK);
+			decryptBlock(&schedule, block, &out[i]);
+			for(uint32_t j = 0; j < BLOCK; j++)
+			{
+				out[i + j] ^= chain[j];
+			}
+			memcpy(chain, block, BLOCK);
+		}
+	}
+}
+
+static void ctrIncrement(uint8_t *ctr)
+{
+	for(int i = 15; i >= 12; i--)
+	{
+		if(++ctr[i] != 0)
+		{
+			break;
+		}
+	}
+}
+
+static void aesCtr128(uint8_t *out, const uint8_t *in, uint32_t len, const uint8_t *key, uint8_t *ctr)
+{
+	Schedule_t schedule;
+	uint8_t stream[BLOCK];
+
+	expandKey(key, &schedule);
+	for(uint32_t i = 0; i + BLOCK <= len; i += BLOCK)
+	{
+		encryptBlock(&schedule, ctr, stream);
+		for(uint32_t j = 0; j < BLOCK; j++)
+		{
+			out[i + j] = in[i + j] ^ stream[j];
+		}
+		ctrIncrement(ctr);
+	}
+}
+
+static uint32_t rol(uint32_t x, uint32_t n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+static uint32_t ror(uint32_t x, uint32_t n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static uint32_t load32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* FIPS 180-4 section 6.1.2, one 64 byte block */
+static void sha1Block(uint32_t *h, const uint8_t *block)
+{
+	uint32_t w[80];
+	uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+	for(uint32_t t = 0; t < 16; t++)
+	{
+		w[t] = load32(&block[4 * t]);
+	}
+	for(uint32_t t = 16; t < 80; t++)
+	{
+		w[t] = rol(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+	}
+
+	for(uint32_t t = 0; t < 80; t++)
+	{
+		uint32_t f;
+		uint32_t k;
+		uint32_t temp;
+
+		if(t < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5a827999;
+		}
+		else if(t < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1;
+		}
+		else if(t < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8f1bbcdc;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xca62c1d6;
+		}
+		temp = rol(a, 5) + f + e + k + w[t];
+		e = d;
+		d = c;
+		c = rol(b, 30);
+		b = a;
+		a = temp;
+	}
+
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+	h[4] += e;
+}
+
+/* FIPS 180-4 section 6.2.2, one 64 byte block */
+static void sha256Block(uint32_t *h, const uint8_t *block)
+{
+	uint32_t w[64];
+	uint32_t v[8];
+
+	for(uint32_t t = 0; t < 16; t++)
+	{
+		w[t] = load32(&block[4 * t]);
+	}
+	for(uint32_t t = 16; t < 64; t++)
+	{
+		uint32_t s0 = ror(w[t - 15], 7) ^ ror(w[t - 15], 18) ^ (w[t - 15] >> 3);
+		uint32_t s1 = ror(w[t - 2], 17) ^ ror(w[t - 2], 19) ^ (w[t - 2] >> 10);
+
+		w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+	}
+
+	memcpy(v, h, sizeof(v));
+	for(uint32_t t = 0; t < 64; t++)
+	{
+		uint32_t s1 = ror(v[4], 6) ^ ror(v[4], 11) ^ ror(v[4], 25);
+		uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+		uint32_t t1 = v[7] + s1 + ch + k256[t] + w[t];
+		uint32_t s0 = ror(v[0], 2) ^ ror(v[0], 13) ^ ror(v[0], 22);
+		uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+
+		memmove(&v[1], &v[0], 7 * sizeof(v[0]));
+		v[4] += t1;
+		v[0] = t1 + s0 + maj;
+	}
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		h[i] += v[i];
+	}
+}
+
+/**************************************************************************//**
+* @brief Merkle-Damgard padding shared by SHA-1 and SHA-256: 0x80, zeros,
+* then the length in bits big endian. words is the size of h
+*****************************************************************************/
+static void shaRun(void (*block)(uint32_t *, const uint8_t *), uint32_t *h, uint32_t words,
+		const uint8_t *msg, uint32_t len, uint8_t *digest)
+{
+	uint8_t last[64];
+	uint32_t left = len;
+	uint32_t used;
+
+	for(; left >= sizeof(last); left -= sizeof(last), msg += sizeof(last))
+	{
+		block(h, msg);
+	}
+
+	memset(last, 0, sizeof(last));
+	memcpy(last, msg, left);
+	used = left;
+	last[used++] = 0x80;
+	if(used > 56)
+	{
+		block(h, last);
+		memset(last, 0, sizeof(last));
+	}
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		last[63 - i] = (uint8_t)(((uint64_t)len << 3) >> (8 * i));
+	}
+	block(h, last);
+
+	for(uint32_t i = 0; i < words; i++)
+	{
+		digest[4 * i] = (uint8_t)(h[i] >> 24);
+		digest[4 * i + 1] = (uint8_t)(h[i] >> 16);
+		digest[4 * i + 2] = (uint8_t)(h[i] >> 8);
+		digest[4 * i + 3] = (uint8_t)h[i];
+	}
+}
+
+static void sha1(const uint8_t *msg, uint32_t len, uint8_t *digest)
+{
+	uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+	shaRun(sha1Block, h, 5, msg, len, digest);
+}
+
+static void sha256(const uint8_t *msg, uint32_t len, uint8_t *digest)
+{
+	uint32_t h[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+
+	shaRun(sha256Block, h, 8, msg, len, digest);
+}
+
+/* Schoolbook multiply, 32x32 bits into 64 at a time */
+static void mul(const uint32_t *a, const uint32_t *b, uint32_t *r, uint32_t bits)
+{
+	uint32_t words = bits / 32;
+
+	memset(r, 0, 2 * words * sizeof(r[0]));
+	for(uint32_t i = 0; i < words; i++)
+	{
+		uint64_t carry = 0;
+
+		for(uint32_t j = 0; j < words; j++)
+		{
+			uint64_t t = (uint64_t)a[i] * b[j] + r[i + j] + carry;
+
+			r[i + j] = (uint32_t)t;
+			carry = t >> 32;
+		}
+		r[i + words] = (uint32_t)carry;
+	}
+}
+
+const CRYPTOBACKEND_t CRYPTOBACKEND_Software = {
+	"software",
+	aesEcb128,
+	aesCbc128,
+	aesCtr128,
+	sha1,
+	sha256,
+	mul,
+};
@@ -0,0 +1,124 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred binary logging
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include "em_core.h"
+#include "em_rtcc.h"
+#include "retargetserial.h"
+
+#include "dlog.h"
+
+#if (DLOG_BUFFER_WORDS & (DLOG_BUFFER_WORDS - 1)) != 0
+#error "DLOG_BUFFER_WORDS must be a power of two"
+#endif
+
+/* Records are stored as [id | nargs << 16] [timestamp] [args...] */
+static uint32_t dlogBuffer[DLOG_BUFFER_WORDS];
+static volatile uint32_t dlogPut = 0;			// Free running word write counter
+static volatile uint32_t dlogGet = 0;			// Free running word read counter
+static volatile uint32_t dlogDropped = 0;		// Records lost because the ring was full
+
+/**************************************************************************//**
+* @brief Reset the record ring
+*****************************************************************************/
+void DLOG_Init(void)
+{
+	dlogPut = 0;
+	dlogGet = 0;
+	dlogDropped = 0;
+}
+
+/**************************************************************************//**
+* @brief Append one record. Called through DLOG(), safe from interrupts
+*****************************************************************************/
+void DLOG_Write(uint32_t id, const uint32_t *args, uint32_t nargs)
+{
+	uint32_t put;
+	CORE_DECLARE_IRQ_STATE;
+
+	CORE_ENTER_ATOMIC();
+	put = dlogPut;
+	if((DLOG_BUFFER_WORDS - (put - dlogGet)) < (nargs + 2))
+	{
+		dlogDropped++;
+		CORE_EXIT_ATOMIC();
+		return;
+	}
+
+	dlogBuffer[put++ & (DLOG_BUFFER_WORDS - 1)] = (id & 0xFFFF) | (nargs << 16);
+	dlogBuffer[put++ & (DLOG_BUFFER_WORDS - 1)] = RTCC_CounterGet();
+	for(uint32_t i = 0; i < nargs; i++)
+	{
+		dlogBuffer[put++ & (DLOG_BUFFER_WORDS - 1)] = args[i];
+	}
+	dlogPut = put;
+	CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+* @brief Serialize pending records to the serial port. Call from the main loop
+* when there is nothing more urgent to do
+*****************************************************************************/
+void DLOG_Flush(void)
+{
+	uint8_t frame[DLOG_HEADER_SIZE + (4 * DLOG_MAX_ARGS) + 1];
+	uint32_t header;
+	uint32_t word;
+	uint32_t nargs;
+	uint32_t len;
+	uint8_t checksum;
+
+	while(dlogGet != dlogPut)
+	{
+		header = dlogBuffer[dlogGet & (DLOG_BUFFER_WORDS - 1)];
+		nargs = header >> 16;
+		len = 0;
+
+		frame[len++] = DLOG_SYNC;
+		frame[len++] = (uint8_t)nargs;
+		frame[len++] = (uint8_t)header;
+		frame[len++] = (uint8_t)(header >> 8);
+
+		for(uint32_t i = 1; i < nargs + 2; i++)
+		{
+			word = dlogBuffer[(dlogGet + i) & (DLOG_BUFFER_WORDS - 1)];
+			frame[len++] = (uint8_t)word;
+			frame[len++] = (uint8_t)(word >> 8);
+			frame[len++] = (uint8_t)(word >> 16);
+			frame[len++] = (uint8_t)(word >> 24);
+		}
+
+		checksum = 0;
+		for(uint32_t i = 0; i < len; i++)
+		{
+			checksum ^= frame[i];
+		}
+		frame[len++] = checksum;
+
+		/* Release the words before the write so producers get the space back early */
+		dlogGet += nargs + 2;
+
+		RETARGET_Write((const char*)frame, (int)len);
+	}
+}
+
+/**************************************************************************//**
+* @brief Number of records dropped because the ring was full
+*****************************************************************************/
+uint32_t DLOG_Dropped(void)
+{
+	return dlogDropped;
+}
@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief Deferred binary logging
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef DLOG_H_
+#define DLOG_H_
+
+#include <stdint.h>
+
+/* Set DLOG_ENABLE to 0 to turn every DLOG() back into a plain printf() */
+#ifndef DLOG_ENABLE
+#define DLOG_ENABLE 1
+#endif
+
+/* Size of the RAM ring holding pending records, in 32-bit words */
+#ifndef DLOG_BUFFER_WORDS
+#define DLOG_BUFFER_WORDS 256
+#endif
+
+/* Largest number of arguments a single DLOG() call can carry */
+#define DLOG_MAX_ARGS     8
+
+/* Wire format of one record, all fields little endian:
+ *   sync(1) nargs(1) id(2) timestamp(4) args(4 * nargs) checksum(1)
+ * id is the offset of the format string in the .dlog_fmt section of the .axf
+ * (the link fails once the section passes 64 KB), timestamp is the RTCC
+ * counter and checksum is the XOR of all previous bytes of the record.
+ * Anything between records is plain text and is passed through by the
+ * decoder, so printf() output can share the same UART.
+ * Records are binary, so RETARGET_SerialCrLf() must stay off. */
+#define DLOG_SYNC         0xD1
+#define DLOG_HEADER_SIZE  8
+#define DLOG_SECTION      ".dlog_fmt"
+
+/* Counts the variadic arguments of DLOG(), 0 to DLOG_MAX_ARGS */
+#define DLOG_NARGS(...) \
+  DLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#if DLOG_ENABLE
+/* Record a log line without formatting it. The format string is only stored
+ * in the non-loaded .dlog_fmt section of the .axf; the target keeps its
+ * offset plus the raw argument words. Arguments are converted to uint32_t,
+ * so only integer conversions (d, i, u, x, X, o, c) are meaningful. */
+#define DLOG(fmt, ...)                                                          \
+  do {                                                                          \
+    static const char dlogFmt[] __attribute__((section(DLOG_SECTION), used)) = fmt; \
+    const uint32_t dlogArgs[DLOG_NARGS(__VA_ARGS__) + 1] = { 0, ##__VA_ARGS__ };    \
+    DLOG_Write((uint32_t)dlogFmt, &dlogArgs[1], DLOG_NARGS(__VA_ARGS__));       \
+  } while (0)
+#else
+#include <stdio.h>
+#define DLOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#endif
+
+void     DLOG_Init(void);
+void     DLOG_Write(uint32_t id, const uint32_t *args, uint32_t nargs);
+void     DLOG_Flush(void);
+uint32_t DLOG_Dropped(void);
+
+#endif
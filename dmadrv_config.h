@@ -45,8 +45,10 @@
 /// and CH_PRIORITY to CH_COUNT as round-robin.
 /// On DMA, this will have no impact, since high priority is unuseable with
 /// peripherals.
+/// All channels are fixed priority here: mx25flash_spi.c gives its RX channel
+/// the lower number of its pair so it always drains RXDATA before TX runs ahead.
 #ifndef EMDRV_DMADRV_DMA_CH_PRIORITY
-#define EMDRV_DMADRV_DMA_CH_PRIORITY 0
+#define EMDRV_DMADRV_DMA_CH_PRIORITY EMDRV_DMADRV_DMA_CH_COUNT
 #endif
 
 /// DMADRV channel count configuration option.
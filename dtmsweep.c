@@ -0,0 +1,350 @@
+/***************************************************************************//**
+ * @file
+ * @brief Direct Test Mode packet error rate sweep over channels and PHYs
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "dtmsweep.h"
+
+typedef enum {
+	STATE_IDLE,
+	STATE_WAITING,							// For the slot of the cell to open
+	STATE_OPEN,								// Test running until the window closes
+	STATE_CLOSING							// Test ended, waiting for its count
+} State_t;
+
+static const DTMSWEEP_Port_t *port;
+static DTMSWEEP_Plan_t plan;
+static DTMSWEEP_Role_t role;
+static State_t state = STATE_IDLE;
+static uint8_t channelList[DTMSWEEP_CHANNELS];
+static uint32_t channelCount;
+static uint32_t cellCount;
+static uint32_t current;					// Cell under way, cellCount when done
+static uint32_t start;						// RTCC of the first slot
+static uint32_t guard;
+static uint32_t slot;
+static uint16_t packets[DTMSWEEP_MAX_CELLS];
+static uint8_t flags[DTMSWEEP_MAX_CELLS];
+
+/**************************************************************************//**
+* @brief Time between the starts of two DTM packets, microseconds. Packet
+* length in microseconds L, then I(L) = ceil((L + 249) / 625) * 625
+*****************************************************************************/
+uint32_t DTMSWEEP_PacketInterval(uint8_t phy, uint8_t length)
+{
+	uint32_t us;
+
+	switch(phy)
+	{
+		case DTMSWEEP_PHY_2M:
+			us = (length + 11) * 4;			// 2 preamble, 4 access address, 2 header, 3 CRC bytes
+			break;
+		case DTMSWEEP_PHY_S8:
+			us = 80 + 256 + (16 + 8 * length + 24) * 8 + 3 * 8;	// Preamble, FEC block 1, header to CRC, TERM2
+			break;
+		case DTMSWEEP_PHY_S2:
+			us = 80 + 256 + (16 + 8 * length + 24) * 2 + 3 * 2;
+			break;
+		default:
+			us = (length + 10) * 8;
+			break;
+	}
+	return ((us + 249 + 624) / 625) * 625;
+}
+
+/**************************************************************************//**
+* @brief Packets sent in ticks of transmitting, the first goes out at once
+*****************************************************************************/
+uint32_t DTMSWEEP_Expected(uint8_t phy, uint8_t length, uint32_t ticks)
+{
+	uint32_t us = (uint32_t)(((uint64_t)ticks * 1000000u) >> 15);
+	uint32_t interval = DTMSWEEP_PacketInterval(phy, length);
+
+	return (us + interval - 1) / interval;
+}
+
+static void cellOf(uint32_t index, uint8_t *channel, uint8_t *phy, uint8_t *length)
+{
+	uint32_t perPhy = plan.lengthCount * channelCount;
+
+	*phy = plan.phys[index / perPhy];
+	*length = plan.lengths[(index % perPhy) / channelCount];
+	*channel = channelList[index % channelCount];
+}
+
+/**************************************************************************//**
+* @brief Window of a cell for a role, RTCC ticks from the common start
+*****************************************************************************/
+void DTMSWEEP_Window(uint32_t index, DTMSWEEP_Role_t r, uint32_t *open, uint32_t *close)
+{
+	if(r == DTMSWEEP_RX)
+	{
+		*open = index * slot;
+		*close = *open + slot - DTMSWEEP_SETTLE;
+	}
+	else
+	{
+		*open = index * slot + guard;
+		*close = *open + plan.cellTicks;
+	}
+}
+
+static void arm(uint32_t deadline, uint32_t now)
+{
+	int32_t ticks = (int32_t)(deadline - now);
+
+	port->timer((ticks > 0) ? (uint32_t)ticks : 1);
+}
+
+static uint32_t openAt(uint32_t index)
+{
+	uint32_t open, close;
+
+	DTMSWEEP_Window(index, role, &open, &close);
+	return start + open;
+}
+
+static void finish(void)
+{
+	state = STATE_IDLE;
+	port->timer(0);
+	port->done();
+}
+
+/* The next cell waits for its slot. The timer may already be armed for it */
+static void advance(uint32_t now)
+{
+	current++;
+	if(current == cellCount)
+	{
+		finish();
+		return;
+	}
+	state = STATE_WAITING;
+	arm(openAt(current), now);
+}
+
+static void cellOpen(uint32_t now)
+{
+	uint32_t open, close;
+	uint8_t channel, phy, length;
+	bool started;
+
+	cellOf(current, &channel, &phy, &length);
+	started = (role == DTMSWEEP_RX) ? port->rx(channel, phy) : port->tx(length, channel, phy);
+	if(!started)
+	{
+		flags[current] |= DTMSWEEP_FAILED;
+		advance(now);
+		return;
+	}
+	state = STATE_OPEN;
+	DTMSWEEP_Window(current, role, &open, &close);
+	arm(start + close, now);
+}
+
+/**************************************************************************//**
+* @brief Starts the sweep
+* @param start RTCC of the first slot, the same moment on both boards
+* @return false if a sweep is running or the plan does not fit
+*****************************************************************************/
+bool DTMSWEEP_Start(const DTMSWEEP_Port_t *p, const DTMSWEEP_Plan_t *s, DTMSWEEP_Role_t r, uint32_t startTicks,
+		uint32_t now)
+{
+	uint32_t drift;
+
+	if(state != STATE_IDLE || s->phyCount == 0 || s->phyCount > DTMSWEEP_MAX_PHYS || s->lengthCount == 0
+			|| s->lengthCount > DTMSWEEP_MAX_LENGTHS || s->cellTicks == 0 || s->cellTicks > 32768 * 10
+			|| (s->channels >> DTMSWEEP_CHANNELS) != 0 || s->channels == 0)
+	{
+		return false;
+	}
+
+	port = p;
+	plan = *s;
+	role = r;
+	channelCount = 0;
+	for(uint8_t c = 0; c < DTMSWEEP_CHANNELS; c++)
+	{
+		if(plan.channels & ((uint64_t)1 << c))
+		{
+			channelList[channelCount++] = c;
+		}
+	}
+	cellCount = plan.phyCount * plan.lengthCount * channelCount;
+
+	/* 100 ppm of the whole sweep each way, a guard either side of a cell */
+	drift = (uint32_t)(((uint64_t)cellCount * (plan.cellTicks + 2 * (DTMSWEEP_GUARD_MIN + plan.syncTicks))) / 10000) + 1;
+	guard = DTMSWEEP_GUARD_MIN + plan.syncTicks + drift;
+	slot = plan.cellTicks + 2 * guard;
+
+	memset(packets, 0, sizeof(packets));
+	memset(flags, 0, sizeof(flags));
+	current = 0;
+	start = startTicks;
+	state = STATE_WAITING;
+	arm(openAt(0), now);
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Stops the sweep, the cell under way keeps no figure
+*****************************************************************************/
+void DTMSWEEP_Stop(void)
+{
+	if(state == STATE_IDLE)
+	{
+		return;
+	}
+	if(state == STATE_OPEN)
+	{
+		port->end();
+	}
+	if(current < cellCount)
+	{
+		flags[current] |= DTMSWEEP_FAILED;
+	}
+	finish();
+}
+
+bool DTMSWEEP_Running(void)
+{
+	return state != STATE_IDLE;
+}
+
+DTMSWEEP_Role_t DTMSWEEP_Role(void)
+{
+	return role;
+}
+
+void DTMSWEEP_Timer(uint32_t now)
+{
+	switch(state)
+	{
+		case STATE_WAITING:
+			cellOpen(now);
+			break;
+		case STATE_OPEN:
+			port->end();
+			state = STATE_CLOSING;
+			/* Wait for the count until the next slot opens */
+			arm(openAt(current + 1), now);
+			break;
+		case STATE_CLOSING:
+			flags[current] |= DTMSWEEP_NO_END;
+			advance(now);
+			if(state == STATE_WAITING)
+			{
+				cellOpen(now);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**************************************************************************//**
+* @brief The stack's test completed event. The first of a cell tells whether
+* the test started, the one after the end carries the packet count
+*****************************************************************************/
+void DTMSWEEP_Completed(uint16_t result, uint16_t count, uint32_t now)
+{
+	switch(state)
+	{
+		case STATE_OPEN:
+			if(result != 0)
+			{
+				flags[current] |= DTMSWEEP_FAILED;
+				advance(now);
+			}
+			break;
+		case STATE_CLOSING:
+			if(result != 0)
+			{
+				flags[current] |= DTMSWEEP_FAILED;
+			}
+			packets[current] = count;
+			advance(now);
+			break;
+		default:
+			break;
+	}
+}
+
+/**************************************************************************//**
+* @brief Cells in the plan of the running or the last sweep
+*****************************************************************************/
+uint32_t DTMSWEEP_Cells(void)
+{
+	return cellCount;
+}
+
+/**************************************************************************//**
+* @brief Cells finished so far
+*****************************************************************************/
+uint32_t DTMSWEEP_Done(void)
+{
+	return current;
+}
+
+bool DTMSWEEP_Cell(uint32_t index, DTMSWEEP_Cell_t *cell)
+{
+	if(index >= cellCount)
+	{
+		return false;
+	}
+	cellOf(index, &cell->channel, &cell->phy, &cell->length);
+	cell->flags = flags[index];
+	cell->expected = (uint16_t)DTMSWEEP_Expected(cell->phy, cell->length, plan.cellTicks);
+	cell->packets = packets[index];
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Packet error rate of a channel and PHY over all lengths, permille
+* @return DTMSWEEP_NO_DATA if no cell of theirs has a figure, or transmitting
+*****************************************************************************/
+uint32_t DTMSWEEP_Per(uint8_t channel, uint8_t phy)
+{
+	uint32_t expected = 0;
+	uint32_t received = 0;
+	DTMSWEEP_Cell_t cell;
+
+	if(role != DTMSWEEP_RX)
+	{
+		return DTMSWEEP_NO_DATA;
+	}
+	for(uint32_t i = 0; i < current && DTMSWEEP_Cell(i, &cell); i++)
+	{
+		if(cell.channel == channel && cell.phy == phy && cell.flags == 0)
+		{
+			expected += cell.expected;
+			/* A packet either side of the window is within the estimate */
+			received += (cell.packets < cell.expected) ? cell.packets : cell.expected;
+		}
+	}
+	if(expected == 0)
+	{
+		return DTMSWEEP_NO_DATA;
+	}
+	return ((expected - received) * 1000 + expected / 2) / expected;
+}
+
+const DTMSWEEP_Plan_t *DTMSWEEP_Plan(void)
+{
+	return &plan;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file
+ * @brief Direct Test Mode packet error rate sweep over channels and PHYs
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef DTMSWEEP_H_
+#define DTMSWEEP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Two boards run the same plan, one transmitting and one receiving, with no
+ * link between them once started. Every cell of the plan, one channel, PHY
+ * and payload length, has a slot of the same length counted from a common
+ * start:
+ *
+ *   |guard|------- cell -------|guard|
+ *   |rx ----------------------------|settle
+ *         |tx -----------------|
+ *
+ * The receiver listens over the whole slot less the settle time, the
+ * transmitter sends in the middle, so the two may disagree on the start by
+ * up to the guard less the settle time. The guard grows with the sweep
+ * length to cover 100 ppm of clock drift between the boards.
+ *
+ * The transmitter sends one packet every I(L) as the core specification
+ * sets for direct test mode, so the receiver knows what was sent from the
+ * cell length alone, give or take a packet. The packet error rate of a cell
+ * is what did not arrive of that. The transmitter keeps its own counts.
+ *
+ * Only schedules, the radio is reached through DTMSWEEP_Port_t and the
+ * stack's completed events are passed in, so tools/dtmsweep_sim.c runs it on
+ * a PC. Everything runs from the main loop. */
+
+#define DTMSWEEP_MAX_PHYS		4
+#define DTMSWEEP_MAX_LENGTHS	4
+#define DTMSWEEP_CHANNELS		40			// DTM channel is (F - 2402) / 2, F in MHz
+#define DTMSWEEP_MAX_CELLS		(DTMSWEEP_CHANNELS * DTMSWEEP_MAX_PHYS * DTMSWEEP_MAX_LENGTHS)
+#define DTMSWEEP_GUARD_MIN		(32768 / 50)	// RTCC ticks
+#define DTMSWEEP_SETTLE			(32768 / 200)	// RTCC ticks from the end of a receive to the next slot
+#define DTMSWEEP_NO_DATA		UINT32_MAX
+
+/* DTM PHY numbering, not that of the connection PHYs */
+#define DTMSWEEP_PHY_1M			1
+#define DTMSWEEP_PHY_2M			2
+#define DTMSWEEP_PHY_S8			3
+#define DTMSWEEP_PHY_S2			4
+
+/* DTMSWEEP_Cell_t flags */
+#define DTMSWEEP_FAILED			0x01		// The test did not start, the cell has no figure
+#define DTMSWEEP_NO_END			0x02		// No count came back before the next slot
+
+typedef enum {
+	DTMSWEEP_RX,
+	DTMSWEEP_TX
+} DTMSWEEP_Role_t;
+
+typedef struct {
+	uint64_t channels;						// Bit per DTM channel
+	uint8_t phys[DTMSWEEP_MAX_PHYS];		// DTMSWEEP_PHY_*
+	uint8_t phyCount;
+	uint8_t lengths[DTMSWEEP_MAX_LENGTHS];	// Payload bytes
+	uint8_t lengthCount;
+	uint32_t cellTicks;						// Transmit time of a cell, RTCC ticks
+	uint32_t syncTicks;						// How far apart the boards may take the common start
+} DTMSWEEP_Plan_t;
+
+typedef struct {
+	uint8_t channel;
+	uint8_t phy;
+	uint8_t length;
+	uint8_t flags;							// DTMSWEEP_*
+	uint16_t expected;						// Packets the transmitter sends in a cell
+	uint16_t packets;						// Received, or sent when transmitting
+} DTMSWEEP_Cell_t;
+
+typedef struct {
+	bool (*rx)(uint8_t channel, uint8_t phy);
+	bool (*tx)(uint8_t length, uint8_t channel, uint8_t phy);
+	void (*end)(void);
+	void (*timer)(uint32_t ticks);			// Arm the one shot timer, 0 stops it
+	void (*done)(void);
+} DTMSWEEP_Port_t;
+
+bool DTMSWEEP_Start(const DTMSWEEP_Port_t *port, const DTMSWEEP_Plan_t *plan, DTMSWEEP_Role_t role,
+		uint32_t start, uint32_t now);
+void DTMSWEEP_Stop(void);
+bool DTMSWEEP_Running(void);
+DTMSWEEP_Role_t DTMSWEEP_Role(void);
+void DTMSWEEP_Timer(uint32_t now);
+void DTMSWEEP_Completed(uint16_t result, uint16_t packets, uint32_t now);
+uint32_t DTMSWEEP_Cells(void);
+uint32_t DTMSWEEP_Done(void);
+bool DTMSWEEP_Cell(uint32_t index, DTMSWEEP_Cell_t *cell);
+void DTMSWEEP_Window(uint32_t index, DTMSWEEP_Role_t role, uint32_t *open, uint32_t *close);
+uint32_t DTMSWEEP_Per(uint8_t channel, uint8_t phy);
+uint32_t DTMSWEEP_Expected(uint8_t phy, uint8_t length, uint32_t ticks);
+uint32_t DTMSWEEP_PacketInterval(uint8_t phy, uint8_t length);
+const DTMSWEEP_Plan_t *DTMSWEEP_Plan(void);
+
+#endif
@@ -0,0 +1,226 @@
+/***************************************************************************//**
+ * @file
+ * @brief Energy mode residency and energy per delivered bit of a run
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#ifndef ENERGY_HOST_MODEL
+#include "em_device.h"
+#include "em_rtcc.h"
+#include "sleep.h"
+#endif
+
+#include "energy.h"
+
+#define HEADER_BYTES			2			// LL data PDU header
+#define CRC_BYTES				3
+#define ACCESS_ADDRESS_BYTES	4
+#define CODED_FIXED_US			376			// Preamble 80, access address 256, CI 16, TERM1 24
+#define DEFAULT_PDU				27
+
+static ENERGY_Residency_t residency;
+static ENERGY_Mode_t mode = ENERGY_EM0;
+static uint32_t since;						// Timestamp mode was entered
+static bool running;
+
+#ifndef ENERGY_HOST_MODEL
+/* The stack's own callbacks, which ENERGY_Init() replaces */
+extern void bg_pre_sleep(SLEEP_EnergyMode_t emode);
+extern void bg_post_wakeup(SLEEP_EnergyMode_t emode);
+
+static void sleepCallback(SLEEP_EnergyMode_t emode)
+{
+	bg_pre_sleep(emode);
+	ENERGY_Sleep((emode < sleepEM4) ? (ENERGY_Mode_t)emode : ENERGY_EM3, RTCC_CounterGet());
+}
+
+static void wakeupCallback(SLEEP_EnergyMode_t emode)
+{
+	ENERGY_Wake(RTCC_CounterGet());
+	bg_post_wakeup(emode);
+}
+#endif
+
+/**************************************************************************//**
+* @brief Takes over the sleep driver callbacks from the stack, chaining to
+* its own. SLEEP_Init() also clears the EM2 and EM3 blocks, so the lowest
+* mode the stack allowed is blocked again. Call after gecko_init()
+*****************************************************************************/
+void ENERGY_Init(void)
+{
+#ifndef ENERGY_HOST_MODEL
+	SLEEP_EnergyMode_t lowest = SLEEP_LowestEnergyModeGet();
+
+	SLEEP_Init(sleepCallback, wakeupCallback);
+	if(lowest < sleepEM2)
+	{
+		SLEEP_SleepBlockBegin(sleepEM2);
+	}
+	else if(lowest < sleepEM3)
+	{
+		SLEEP_SleepBlockBegin(sleepEM3);
+	}
+#endif
+}
+
+/**************************************************************************//**
+* @brief Clears the residency and airtime and starts counting, in EM0
+*****************************************************************************/
+void ENERGY_Start(uint32_t now)
+{
+	memset(&residency, 0, sizeof(residency));
+	mode = ENERGY_EM0;
+	since = now;
+	running = true;
+}
+
+void ENERGY_Stop(uint32_t now)
+{
+	if(running)
+	{
+		residency.ticks[mode] += now - since;
+		running = false;
+	}
+}
+
+/**************************************************************************//**
+* @brief The core is about to enter a sleep mode. From the sleep driver with
+* interrupts off
+*****************************************************************************/
+void ENERGY_Sleep(ENERGY_Mode_t next, uint32_t now)
+{
+	if(running)
+	{
+		residency.ticks[mode] += now - since;
+		residency.sleeps[next]++;
+	}
+	mode = next;
+	since = now;
+}
+
+void ENERGY_Wake(uint32_t now)
+{
+	if(running)
+	{
+		residency.ticks[mode] += now - since;
+		residency.sleeps[ENERGY_EM0]++;
+	}
+	mode = ENERGY_EM0;
+	since = now;
+}
+
+/**************************************************************************//**
+* @brief On-air time of one data PDU with pduBytes of payload, from the
+* preamble to the end of the CRC, or of the coded PHY's TERM2
+*****************************************************************************/
+uint32_t ENERGY_AirtimeMicroseconds(uint8_t phy, uint16_t pduBytes)
+{
+	uint32_t bits = 8 * (HEADER_BYTES + pduBytes + CRC_BYTES);
+
+	switch(phy)
+	{
+		case ENERGY_PHY_2M:
+			return (8 * (2 + ACCESS_ADDRESS_BYTES) + bits) / 2;
+		case ENERGY_PHY_S8:
+			return CODED_FIXED_US + 8 * bits + 3 * 8;
+		case ENERGY_PHY_S2:
+			return CODED_FIXED_US + 2 * bits + 3 * 2;
+		default:
+			return 8 * (1 + ACCESS_ADDRESS_BYTES) + bits;
+	}
+}
+
+/**************************************************************************//**
+* @brief Adds the airtime of one L2CAP packet of bytes bytes, cut into PDUs
+* of at most pduMax, each acknowledged by an empty PDU the other way
+*****************************************************************************/
+void ENERGY_Packet(uint8_t phy, uint16_t bytes, uint16_t pduMax, bool transmitted)
+{
+	uint32_t *data = transmitted ? &residency.txMicroseconds : &residency.rxMicroseconds;
+	uint32_t *empty = transmitted ? &residency.rxMicroseconds : &residency.txMicroseconds;
+	uint32_t *dataPackets = transmitted ? &residency.txPackets : &residency.rxPackets;
+	uint32_t *emptyPackets = transmitted ? &residency.rxPackets : &residency.txPackets;
+
+	if(!running)
+	{
+		return;
+	}
+	if(pduMax == 0)
+	{
+		pduMax = DEFAULT_PDU;
+	}
+
+	do
+	{
+		uint16_t chunk = (bytes < pduMax) ? bytes : pduMax;
+
+		*data += ENERGY_AirtimeMicroseconds(phy, chunk);
+		*empty += ENERGY_AirtimeMicroseconds(phy, 0);
+		(*dataPackets)++;
+		(*emptyPackets)++;
+		bytes -= chunk;
+	} while(bytes != 0);
+}
+
+/**************************************************************************//**
+* @brief Residency so far, the mode the core is in counted up to now
+*****************************************************************************/
+void ENERGY_GetResidency(ENERGY_Residency_t *out, uint32_t now)
+{
+	*out = residency;
+	if(running)
+	{
+		out->ticks[mode] += now - since;
+	}
+}
+
+/**************************************************************************//**
+* @brief Prices a residency: microamps times millivolts is nanowatts, so the
+* sums below are nanojoules
+*****************************************************************************/
+void ENERGY_Estimate(const ENERGY_Residency_t *r, const ENERGY_Currents_t *c, uint32_t bits, ENERGY_Estimate_t *estimate)
+{
+	uint64_t core = 0;
+	uint64_t radio;
+	uint64_t total;
+	uint64_t ticks = 0;
+
+	for(uint32_t m = 0; m < ENERGY_MODES; m++)
+	{
+		core += ((uint64_t)c->microamps[m] * c->millivolts * r->ticks[m]) / ENERGY_TICKS_PER_SECOND;
+		ticks += r->ticks[m];
+	}
+	radio = ((uint64_t)c->txMicroamps * c->millivolts * r->txMicroseconds) / 1000000u
+			+ ((uint64_t)c->rxMicroamps * c->millivolts * r->rxMicroseconds) / 1000000u;
+	total = core + radio;
+
+	memset(estimate, 0, sizeof(*estimate));
+	estimate->microjoules = (uint32_t)(total / 1000u);
+	if(ticks != 0 && c->millivolts != 0)
+	{
+		estimate->averageMicroamps = (uint32_t)((total * ENERGY_TICKS_PER_SECOND) / (ticks * c->millivolts));
+	}
+	if(bits != 0)
+	{
+		uint64_t perBit = (total * 1000u) / bits;
+
+		estimate->picojoulesPerBit = (perBit > UINT32_MAX) ? UINT32_MAX : (uint32_t)perBit;
+	}
+	if(total != 0)
+	{
+		estimate->radioPermille = (uint32_t)((radio * 1000u) / total);
+	}
+}
@@ -0,0 +1,100 @@
+/***************************************************************************//**
+ * @file
+ * @brief Energy mode residency and energy per delivered bit of a run
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ENERGY_Init() hooks the sleep driver callbacks, which the Bluetooth stack
+ * calls around every EMU_EnterEMx() of gecko_wait_event(), and timestamps
+ * them with the RTCC. Between ENERGY_Start() and ENERGY_Stop() the ticks
+ * spent in each energy mode add up to the run time. With .sleep.flags = 0
+ * the stack blocks EM2, so a run is EM0 and EM1 only and the EM1 share is
+ * the sleep the run left on the table.
+ *
+ * The radio is not timed, the application adds the on-air time of every
+ * packet with ENERGY_Packet(): each data PDU one way and the empty PDU that
+ * acknowledges it the other, from the PHY's preamble, access address, CRC
+ * and coding. Retransmissions and empty connection events are not seen, so
+ * the airtime is a lower bound.
+ *
+ * ENERGY_Estimate() prices the residency with a table of currents, the radio
+ * currents on top of the core's, and divides by the bits delivered. Only
+ * ENERGY_Init() touches the hardware: built with -DENERGY_HOST_MODEL the
+ * accounting runs on a PC from timestamps the caller gives it, see
+ * tools/energy_rank.c. */
+
+/* Same values as the le_gap PHY bits of the Bluetooth API */
+#define ENERGY_PHY_1M			0x01
+#define ENERGY_PHY_2M			0x02
+#define ENERGY_PHY_S8			0x04
+#define ENERGY_PHY_S2			0x08
+
+#define ENERGY_TICKS_PER_SECOND	32768			// RTCC
+
+typedef enum {
+	ENERGY_EM0,
+	ENERGY_EM1,
+	ENERGY_EM2,
+	ENERGY_EM3,
+	ENERGY_MODES
+} ENERGY_Mode_t;
+
+typedef struct {
+	uint32_t ticks[ENERGY_MODES];				// RTCC ticks spent in each mode
+	uint32_t sleeps[ENERGY_MODES];				// Times each mode was entered, sleeps[ENERGY_EM0] counts wake ups
+	uint32_t txMicroseconds;					// Estimated radio airtime
+	uint32_t rxMicroseconds;
+	uint32_t txPackets;							// PDUs in the airtime, empty ones included
+	uint32_t rxPackets;
+} ENERGY_Residency_t;
+
+/* Supply current in each mode, the radio currents are added to the core's
+ * while it transmits or receives */
+typedef struct {
+	uint32_t microamps[ENERGY_MODES];
+	uint32_t txMicroamps;
+	uint32_t rxMicroamps;
+	uint32_t millivolts;
+} ENERGY_Currents_t;
+
+/* EFR32BG13 datasheet typicals at 3.3 V with the DC-DC: EM0 at 38.4 MHz,
+ * EM1, EM2 and EM3 with full RAM retention, TX at 0 dBm and RX at 1 Mbit/s */
+#ifndef ENERGY_CURRENTS_DEFAULT
+#define ENERGY_CURRENTS_DEFAULT	{ { 3340, 1350, 3, 2 }, 8500, 8700, 3300 }
+#endif
+
+typedef struct {
+	uint32_t microjoules;						// Whole run
+	uint32_t averageMicroamps;
+	uint32_t picojoulesPerBit;					// 0 when no bit was delivered
+	uint32_t radioPermille;						// Share of the energy spent by the radio
+} ENERGY_Estimate_t;
+
+void ENERGY_Init(void);
+void ENERGY_Start(uint32_t now);
+void ENERGY_Stop(uint32_t now);
+void ENERGY_Sleep(ENERGY_Mode_t mode, uint32_t now);
+void ENERGY_Wake(uint32_t now);
+uint32_t ENERGY_AirtimeMicroseconds(uint8_t phy, uint16_t pduBytes);
+void ENERGY_Packet(uint8_t phy, uint16_t bytes, uint16_t pduMax, bool transmitted);
+void ENERGY_GetResidency(ENERGY_Residency_t *residency, uint32_t now);
+void ENERGY_Estimate(const ENERGY_Residency_t *residency, const ENERGY_Currents_t *currents, uint32_t bits, ENERGY_Estimate_t *estimate);
+
+#endif
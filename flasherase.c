@@ -0,0 +1,202 @@
+/***************************************************************************//**
+ * @file
+ * @brief Background erase scheduler for the MX25 SPI flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "mx25flash_spi.h"
+#include "flasherase.h"
+
+#if (FLASHERASE_QUEUE_SIZE & (FLASHERASE_QUEUE_SIZE - 1)) != 0
+#error "FLASHERASE_QUEUE_SIZE must be a power of two"
+#endif
+
+/* Upper bound on the wait for WIP to drop after a suspend. The MX25R needs
+ * about 20 us, this only keeps a missing part from hanging the caller. */
+#define SUSPEND_POLL_LIMIT	1000
+
+static struct {
+	uint32_t address;
+	uint32_t size;
+} queue[FLASHERASE_QUEUE_SIZE];
+static uint32_t queuePut = 0;			// Free running counters
+static uint32_t queueGet = 0;
+static bool erasing = false;			// Head of the queue has been started
+static bool suspended = false;			// Head of the queue is parked by a Hold
+static uint32_t holds = 0;				// Nesting depth of Hold
+static FLASHERASE_Callback_t doneCallback;
+static FLASHERASE_Stats_t stats;
+
+static bool flashBusy(void)
+{
+	uint8_t status;
+
+	MX25_RDSR(&status);
+	return (status & FLASH_WIP_MASK) != 0;
+}
+
+/**************************************************************************//**
+* @brief Forget all queued erases and statistics
+* @param done Called from FLASHERASE_Poll() for every finished erase, or NULL
+*****************************************************************************/
+void FLASHERASE_Init(FLASHERASE_Callback_t done)
+{
+	queuePut = 0;
+	queueGet = 0;
+	erasing = false;
+	suspended = false;
+	holds = 0;
+	doneCallback = done;
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**************************************************************************//**
+* @brief Queue the erase of one 4 KB sector or one 32 KB block
+* @return false if size is not Sector_Offset or Block32K_Offset or the queue
+* is full
+*****************************************************************************/
+bool FLASHERASE_Queue(uint32_t address, uint32_t size)
+{
+	if(size != Sector_Offset && size != Block32K_Offset)
+	{
+		return false;
+	}
+	if((queuePut - queueGet) == FLASHERASE_QUEUE_SIZE)
+	{
+		stats.rejected++;
+		return false;
+	}
+
+	queue[queuePut & (FLASHERASE_QUEUE_SIZE - 1)].address = address & ~(size - 1);
+	queue[queuePut & (FLASHERASE_QUEUE_SIZE - 1)].size = size;
+	queuePut++;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Advance the scheduler by one step. Never waits for the flash, call it
+* whenever the main loop is idle
+*****************************************************************************/
+void FLASHERASE_Poll(void)
+{
+	uint32_t address;
+	uint32_t size;
+	ReturnMsg status;
+
+	if(holds || queueGet == queuePut)
+	{
+		return;
+	}
+
+	address = queue[queueGet & (FLASHERASE_QUEUE_SIZE - 1)].address;
+	size = queue[queueGet & (FLASHERASE_QUEUE_SIZE - 1)].size;
+
+	if(erasing)
+	{
+		if(flashBusy())
+		{
+			return;
+		}
+		erasing = false;
+		queueGet++;
+		stats.erases++;
+		if(doneCallback)
+		{
+			doneCallback(address, size);
+		}
+		return;
+	}
+
+	if(size == Sector_Offset)
+	{
+		status = MX25_SE_Start(address);
+	}
+	else
+	{
+		status = MX25_BE32K_Start(address);
+	}
+
+	if(status == FlashOperationSuccess)
+	{
+		erasing = true;
+	}
+	else if(status == FlashAddressInvalid)
+	{
+		queueGet++;
+	}
+	/* FlashIsBusy: a program is still running, try again next time */
+}
+
+/**************************************************************************//**
+* @brief True while an erase is queued or running
+*****************************************************************************/
+bool FLASHERASE_Busy(void)
+{
+	return queueGet != queuePut;
+}
+
+/**************************************************************************//**
+* @brief Make the flash available for reads and programs outside the sector
+* being erased. Suspends a running erase and waits for the suspend to take
+* effect. Calls nest, each one needs a FLASHERASE_Release()
+*****************************************************************************/
+void FLASHERASE_Hold(void)
+{
+	uint32_t polls = 0;
+
+	if(holds++ != 0 || !erasing)
+	{
+		return;
+	}
+
+	MX25_PGM_ERS_S();
+	while(flashBusy() && polls < SUSPEND_POLL_LIMIT)
+	{
+		polls++;
+	}
+
+	suspended = true;
+	stats.suspends++;
+	if(polls > stats.maxSuspendPolls)
+	{
+		stats.maxSuspendPolls = polls;
+	}
+}
+
+/**************************************************************************//**
+* @brief End a FLASHERASE_Hold(), resuming the erase after the last one
+*****************************************************************************/
+void FLASHERASE_Release(void)
+{
+	if(holds == 0 || --holds != 0)
+	{
+		return;
+	}
+	if(suspended)
+	{
+		MX25_PGM_ERS_R();
+		suspended = false;
+	}
+}
+
+/**************************************************************************//**
+* @brief Scheduler statistics
+*****************************************************************************/
+const FLASHERASE_Stats_t *FLASHERASE_Stats(void)
+{
+	return &stats;
+}
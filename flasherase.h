@@ -0,0 +1,55 @@
+/***************************************************************************//**
+ * @file
+ * @brief Background erase scheduler for the MX25 SPI flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef FLASHERASE_H_
+#define FLASHERASE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Erases are queued and started without waiting for them, so the 40 ms to
+ * 200 ms the part needs never blocks the caller. FLASHERASE_Poll() only
+ * issues a status read or a single instruction, so calling it from the main
+ * loop when the stack has no event pending keeps SPI traffic in the gaps
+ * between connection events. Anyone who needs the flash while an erase runs
+ * brackets the access with FLASHERASE_Hold() / FLASHERASE_Release(), which
+ * suspend and resume the erase. Only the MX25 driver is used, so the
+ * scheduler runs on a host against tools/mx25_model.c. */
+
+#ifndef FLASHERASE_QUEUE_SIZE
+#define FLASHERASE_QUEUE_SIZE	8		// Pending erases, power of two
+#endif
+
+/* Called from FLASHERASE_Poll() when an erase has completed */
+typedef void (*FLASHERASE_Callback_t)(uint32_t address, uint32_t size);
+
+typedef struct {
+	uint32_t erases;					// Erases completed
+	uint32_t suspends;					// Erases suspended for a Hold
+	uint32_t maxSuspendPolls;			// Longest wait for a suspend to take effect, in RDSR reads
+	uint32_t rejected;					// Queue requests refused because the queue was full
+} FLASHERASE_Stats_t;
+
+void FLASHERASE_Init(FLASHERASE_Callback_t done);
+bool FLASHERASE_Queue(uint32_t address, uint32_t size);
+void FLASHERASE_Poll(void);
+bool FLASHERASE_Busy(void);
+void FLASHERASE_Hold(void);
+void FLASHERASE_Release(void);
+const FLASHERASE_Stats_t *FLASHERASE_Stats(void);
+
+#endif
@@ -0,0 +1,673 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log structured test result store on the MX25 SPI flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "mx25flash_spi.h"
+#include "flasherase.h"
+#include "flashlog.h"
+
+#if FLASHLOG_SECTOR_SIZE != Sector_Offset
+#error "FLASHLOG_SECTOR_SIZE must match the MX25 sector size"
+#endif
+#if (FLASHLOG_STAGE_SIZE & (FLASHLOG_STAGE_SIZE - 1)) != 0
+#error "FLASHLOG_STAGE_SIZE must be a power of two"
+#endif
+#if FLASHLOG_SECTORS < (FLASHLOG_SPARE_SECTORS + 2)
+#error "FLASHLOG_SECTORS must leave room for the spares, the head and one more"
+#endif
+
+#define SECTOR_ADDRESS(sector)	(FLASHLOG_BASE + ((sector) * FLASHLOG_SECTOR_SIZE))
+#define SECTORS_PER_BLOCK		(Block32K_Offset / FLASHLOG_SECTOR_SIZE)
+#define ERASED_WORD				0xFFFFFFFF
+
+typedef enum {
+	SECTOR_DIRTY = 0,						// Old or unknown contents, needs an erase
+	SECTOR_ERASING,							// Queued with the erase scheduler
+	SECTOR_BLANK,							// Erased, header not stamped yet
+	SECTOR_SPARE,							// Erased and stamped, ready to be opened
+	SECTOR_LIVE								// Holds records
+} Sector_State_t;
+
+typedef enum {
+	PROGRAM_NONE = 0,
+	PROGRAM_STAMP,							// magic and erase count of a blank sector
+	PROGRAM_OPEN,							// seq of a spare sector
+	PROGRAM_RECORD							// Staged record bytes
+} Program_Kind_t;
+
+static bool ready = false;
+static uint8_t sectorState[FLASHLOG_SECTORS];
+static uint32_t sectorSeq[FLASHLOG_SECTORS];
+static uint32_t sectorErases[FLASHLOG_SECTORS];
+static uint32_t head;						// Sector being written, or the one before the first to open
+static uint32_t tail;						// Oldest live sector
+static uint32_t liveCount;
+static uint32_t writeOffset;				// Next free byte in the head sector
+static uint32_t nextSeq;
+
+static uint8_t stage[FLASHLOG_STAGE_SIZE];
+static uint32_t stagePut = 0;				// Free running counters
+static uint32_t stageGet = 0;
+static uint32_t recordLeft = 0;				// Bytes of the record being programmed still staged
+
+static Program_Kind_t programKind = PROGRAM_NONE;
+static uint32_t programSector;
+static uint32_t programLen;
+static uint32_t headerWords[2];				// Source of header programs, must outlive the PP
+
+static FLASHLOG_Stats_t stats;
+
+/* Sector after the given one, in rotation order */
+static uint32_t nextSector(uint32_t sector)
+{
+	return (sector + 1) % FLASHLOG_SECTORS;
+}
+
+/**************************************************************************//**
+* @brief Erase scheduler callback, the sectors covered are now blank
+*****************************************************************************/
+static void eraseDone(uint32_t address, uint32_t size)
+{
+	for(uint32_t a = address; a < address + size; a += FLASHLOG_SECTOR_SIZE)
+	{
+		uint32_t sector = (a - FLASHLOG_BASE) / FLASHLOG_SECTOR_SIZE;
+
+		if(sector < FLASHLOG_SECTORS)
+		{
+			sectorState[sector] = SECTOR_BLANK;
+			sectorErases[sector]++;
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief MX25_PP_Async completion
+*****************************************************************************/
+static void programDone(ReturnMsg status, void *user)
+{
+	(void)user;
+
+	FLASHERASE_Release();
+
+	switch(programKind)
+	{
+	case PROGRAM_STAMP:
+		sectorState[programSector] = (status == FlashOperationSuccess) ? SECTOR_SPARE : SECTOR_DIRTY;
+		break;
+	case PROGRAM_OPEN:
+		if(status != FlashOperationSuccess)
+		{
+			sectorState[programSector] = SECTOR_DIRTY;
+			break;
+		}
+		sectorState[programSector] = SECTOR_LIVE;
+		sectorSeq[programSector] = headerWords[0];
+		if(liveCount++ == 0)
+		{
+			tail = programSector;
+		}
+		head = programSector;
+		writeOffset = FLASHLOG_HEADER_SIZE;
+		break;
+	case PROGRAM_RECORD:
+		stageGet += programLen;
+		writeOffset += programLen;
+		recordLeft -= programLen;
+		if(recordLeft == 0)
+		{
+			stats.written++;
+		}
+		break;
+	default:
+		break;
+	}
+	programKind = PROGRAM_NONE;
+}
+
+static bool startProgram(Program_Kind_t kind, uint32_t address, const void *data, uint32_t len)
+{
+	/* Suspends a running erase elsewhere in the flash */
+	FLASHERASE_Hold();
+	programKind = kind;
+	if(MX25_PP_Async(address, (uint8_t*)data, len, programDone, NULL) != FlashOperationSuccess)
+	{
+		programKind = PROGRAM_NONE;
+		FLASHERASE_Release();
+		return false;
+	}
+	return true;
+}
+
+/**************************************************************************//**
+* @brief The oldest sector gives up its records to make room
+*****************************************************************************/
+static void recycle(uint32_t sector)
+{
+	sectorState[sector] = SECTOR_DIRTY;
+	stats.recycled++;
+	if(--liveCount != 0 && sector == tail)
+	{
+		do
+		{
+			tail = nextSector(tail);
+		} while(sectorState[tail] != SECTOR_LIVE);
+	}
+}
+
+/**************************************************************************//**
+* @brief Queue one erase for the dirty sector nearest ahead of the head, as
+* a 32 KB block erase if the whole block is dirty
+*****************************************************************************/
+static void scrub(void)
+{
+	uint32_t sector = head;
+
+	for(uint32_t i = 1; i < FLASHLOG_SECTORS; i++)
+	{
+		sector = nextSector(sector);
+		if(sectorState[sector] != SECTOR_DIRTY)
+		{
+			continue;
+		}
+
+		uint32_t first = sector - (sector % SECTORS_PER_BLOCK);
+		bool block = ((SECTOR_ADDRESS(first) % Block32K_Offset) == 0)
+				&& (first + SECTORS_PER_BLOCK <= FLASHLOG_SECTORS);
+
+		for(uint32_t j = first; block && j < first + SECTORS_PER_BLOCK; j++)
+		{
+			block = (sectorState[j] == SECTOR_DIRTY);
+		}
+
+		if(block && FLASHERASE_Queue(SECTOR_ADDRESS(first), Block32K_Offset))
+		{
+			memset(&sectorState[first], SECTOR_ERASING, SECTORS_PER_BLOCK);
+		}
+		else if(!block && FLASHERASE_Queue(SECTOR_ADDRESS(sector), FLASHLOG_SECTOR_SIZE))
+		{
+			sectorState[sector] = SECTOR_ERASING;
+		}
+		return;
+	}
+}
+
+/**************************************************************************//**
+* @brief Make sure the sectors right after the head are, or will be, erased
+*****************************************************************************/
+static void keepSpares(void)
+{
+	uint32_t sector = head;
+
+	for(uint32_t i = 0; i < FLASHLOG_SPARE_SECTORS; i++)
+	{
+		sector = nextSector(sector);
+		if(sectorState[sector] == SECTOR_LIVE && sector != head)
+		{
+			recycle(sector);
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Program the header of one freshly erased sector
+*****************************************************************************/
+static bool stampBlank(void)
+{
+	for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+	{
+		if(sectorState[sector] == SECTOR_BLANK)
+		{
+			headerWords[0] = FLASHLOG_MAGIC;
+			headerWords[1] = sectorErases[sector];
+			programSector = sector;
+			return startProgram(PROGRAM_STAMP, SECTOR_ADDRESS(sector), headerWords, 8);
+		}
+	}
+	return false;
+}
+
+/**************************************************************************//**
+* @brief Open the sector after the head once it is a stamped spare
+*****************************************************************************/
+static bool openNext(void)
+{
+	uint32_t sector = nextSector(head);
+
+	if(sectorState[sector] == SECTOR_LIVE)
+	{
+		/* No spare was kept, the oldest records have to go now */
+		recycle(sector);
+	}
+	if(sectorState[sector] != SECTOR_SPARE)
+	{
+		/* scrub() and stampBlank() get it there */
+		return false;
+	}
+
+	headerWords[0] = nextSeq++;
+	headerWords[1] = ~headerWords[0];
+	programSector = sector;
+	return startProgram(PROGRAM_OPEN, SECTOR_ADDRESS(sector) + 8, headerWords, 8);
+}
+
+/**************************************************************************//**
+* @brief Program the next piece of staged record data
+*****************************************************************************/
+static bool programStaged(void)
+{
+	uint32_t index = stageGet & (FLASHLOG_STAGE_SIZE - 1);
+	uint32_t address;
+	uint32_t len;
+
+	if(stagePut == stageGet)
+	{
+		return false;
+	}
+
+	if(recordLeft == 0)
+	{
+		uint32_t recordLen = FLASHLOG_RECORD_HEADER + stage[index];
+
+		if(liveCount == 0 || writeOffset + recordLen > FLASHLOG_SECTOR_SIZE)
+		{
+			return openNext();
+		}
+		recordLeft = recordLen;
+	}
+
+	/* One PP per contiguous run of the ring that stays inside a page */
+	address = SECTOR_ADDRESS(head) + writeOffset;
+	len = recordLeft;
+	if(len > FLASHLOG_STAGE_SIZE - index)
+	{
+		len = FLASHLOG_STAGE_SIZE - index;
+	}
+	if(len > Page_Offset - (address & (Page_Offset - 1)))
+	{
+		len = Page_Offset - (address & (Page_Offset - 1));
+	}
+	programLen = len;
+	return startProgram(PROGRAM_RECORD, address, &stage[index], len);
+}
+
+static bool blank(const uint8_t *data, uint32_t len)
+{
+	while(len--)
+	{
+		if(*data++ != 0xFF)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Read the records of one sector
+* @param walker Called for every record with a valid CRC, may be NULL
+* @param count Incremented for every record delivered
+* @return Offset of the erased space after the last record, or
+* FLASHLOG_SECTOR_SIZE if the rest of the sector cannot be trusted
+*****************************************************************************/
+static uint32_t scanSector(uint32_t sector, FLASHLOG_Walker_t walker, uint32_t *count)
+{
+	uint8_t record[FLASHLOG_RECORD_HEADER + FLASHLOG_MAX_PAYLOAD];
+	uint32_t offset = FLASHLOG_HEADER_SIZE;
+
+	while(offset + FLASHLOG_RECORD_HEADER <= FLASHLOG_SECTOR_SIZE)
+	{
+		uint32_t len;
+		uint16_t crc;
+
+		MX25_ReadFast(SECTOR_ADDRESS(sector) + offset, record, FLASHLOG_RECORD_HEADER);
+		len = record[0];
+		if(len == 0xFF)
+		{
+			/* A torn header may have len still erased but other bits programmed */
+			return blank(record, FLASHLOG_RECORD_HEADER) ? offset : FLASHLOG_SECTOR_SIZE;
+		}
+		if(len > FLASHLOG_MAX_PAYLOAD || offset + FLASHLOG_RECORD_HEADER + len > FLASHLOG_SECTOR_SIZE)
+		{
+			stats.corrupt++;
+			return FLASHLOG_SECTOR_SIZE;
+		}
+
+		MX25_ReadFast(SECTOR_ADDRESS(sector) + offset + FLASHLOG_RECORD_HEADER, &record[FLASHLOG_RECORD_HEADER], len);
+		crc = FLASHLOG_Crc16(0xFFFF, record, 2);
+		crc = FLASHLOG_Crc16(crc, &record[4], 4 + len);
+		if(crc != (record[2] | (record[3] << 8)))
+		{
+			/* len is plausible, skip just this record */
+			stats.corrupt++;
+		}
+		else
+		{
+			if(walker)
+			{
+				uint32_t timestamp = record[4] | (record[5] << 8) | (record[6] << 16) | ((uint32_t)record[7] << 24);
+				walker(record[1], timestamp, &record[FLASHLOG_RECORD_HEADER], len);
+			}
+			(*count)++;
+		}
+		offset += FLASHLOG_RECORD_HEADER + len;
+	}
+	return FLASHLOG_SECTOR_SIZE;
+}
+
+/**************************************************************************//**
+* @brief Find the end of the records in the head sector after a reset
+*****************************************************************************/
+static void recoverHead(void)
+{
+	uint8_t chunk[64];
+	uint32_t count = 0;
+	uint32_t offset = scanSector(head, NULL, &count);
+
+	/* Appending is only safe over erased space, seal the sector otherwise */
+	for(uint32_t o = offset; o < FLASHLOG_SECTOR_SIZE; o += sizeof(chunk))
+	{
+		MX25_ReadFast(SECTOR_ADDRESS(head) + o, chunk, sizeof(chunk));
+		if(!blank(chunk, sizeof(chunk)))
+		{
+			offset = FLASHLOG_SECTOR_SIZE;
+			break;
+		}
+	}
+	writeOffset = offset;
+}
+
+/**************************************************************************//**
+* @brief Recover the store from the sector headers. The MX25 must be
+* initialized and out of deep power down
+* @return false if the flash does not answer, the store then drops all records
+*****************************************************************************/
+bool FLASHLOG_Init(void)
+{
+	uint32_t id = 0;
+	uint32_t maxErases = 0;
+	uint32_t maxSeq = 0;
+	uint8_t status;
+
+	memset(&stats, 0, sizeof(stats));
+	stagePut = 0;
+	stageGet = 0;
+	recordLeft = 0;
+	programKind = PROGRAM_NONE;
+	liveCount = 0;
+	nextSeq = 1;
+	head = FLASHLOG_SECTORS - 1;
+	tail = 0;
+	writeOffset = FLASHLOG_SECTOR_SIZE;
+
+	/* The part may need a moment after leaving deep power down */
+	for(uint32_t tries = 0; tries < 8 && id != FlashID; tries++)
+	{
+		MX25_RDID(&id);
+	}
+	ready = (id == FlashID);
+	if(!ready)
+	{
+		return false;
+	}
+
+	/* A reset does not stop an erase, and may leave one suspended. Let it
+	 * finish before the headers are read */
+	MX25_PGM_ERS_R();
+	do
+	{
+		MX25_RDSR(&status);
+	} while(status & FLASH_WIP_MASK);
+
+	FLASHERASE_Init(eraseDone);
+
+	for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+	{
+		uint32_t header[FLASHLOG_HEADER_SIZE / 4];
+
+		MX25_ReadFast(SECTOR_ADDRESS(sector), (uint8_t*)header, sizeof(header));
+		sectorState[sector] = SECTOR_DIRTY;
+		sectorErases[sector] = ERASED_WORD;
+		if(header[0] != FLASHLOG_MAGIC)
+		{
+			continue;
+		}
+
+		sectorErases[sector] = header[1];
+		if(header[1] > maxErases)
+		{
+			maxErases = header[1];
+		}
+		if(header[2] == ERASED_WORD && header[3] == ERASED_WORD)
+		{
+			sectorState[sector] = SECTOR_SPARE;
+		}
+		else if(header[2] == ~header[3] && header[2] != ERASED_WORD)
+		{
+			sectorState[sector] = SECTOR_LIVE;
+			sectorSeq[sector] = header[2];
+			if(liveCount == 0 || header[2] > maxSeq)
+			{
+				maxSeq = header[2];
+				head = sector;
+			}
+			if(liveCount == 0 || header[2] < sectorSeq[tail])
+			{
+				tail = sector;
+			}
+			liveCount++;
+		}
+	}
+
+	/* Sectors without a readable header have an unknown history, assume the worst */
+	for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+	{
+		if(sectorErases[sector] == ERASED_WORD)
+		{
+			sectorErases[sector] = maxErases;
+		}
+	}
+
+	if(liveCount)
+	{
+		nextSeq = maxSeq + 1;
+		recoverHead();
+	}
+	else
+	{
+		/* Start at the first spare, if there is one */
+		for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+		{
+			if(sectorState[sector] == SECTOR_SPARE)
+			{
+				head = (sector + FLASHLOG_SECTORS - 1) % FLASHLOG_SECTORS;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Stage one record. Does not touch the flash, safe to call anywhere in
+* the main loop
+* @return false if the record was dropped
+*****************************************************************************/
+bool FLASHLOG_Append(uint8_t type, uint32_t timestamp, const void *payload, uint32_t len)
+{
+	uint8_t header[FLASHLOG_RECORD_HEADER];
+	const uint8_t *data = payload;
+	uint16_t crc;
+
+	if(!ready || len > FLASHLOG_MAX_PAYLOAD
+		|| (FLASHLOG_STAGE_SIZE - (stagePut - stageGet)) < FLASHLOG_RECORD_HEADER + len)
+	{
+		stats.dropped++;
+		return false;
+	}
+
+	header[0] = (uint8_t)len;
+	header[1] = type;
+	header[4] = (uint8_t)timestamp;
+	header[5] = (uint8_t)(timestamp >> 8);
+	header[6] = (uint8_t)(timestamp >> 16);
+	header[7] = (uint8_t)(timestamp >> 24);
+	crc = FLASHLOG_Crc16(0xFFFF, header, 2);
+	crc = FLASHLOG_Crc16(crc, &header[4], 4);
+	crc = FLASHLOG_Crc16(crc, data, len);
+	header[2] = (uint8_t)crc;
+	header[3] = (uint8_t)(crc >> 8);
+
+	for(uint32_t i = 0; i < FLASHLOG_RECORD_HEADER + len; i++)
+	{
+		stage[stagePut++ & (FLASHLOG_STAGE_SIZE - 1)] = (i < FLASHLOG_RECORD_HEADER) ? header[i] : data[i - FLASHLOG_RECORD_HEADER];
+	}
+	stats.appended++;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Move the store forward by at most one flash operation. Never waits for
+* the flash; call it from the main loop whenever no stack event is pending
+*****************************************************************************/
+void FLASHLOG_Poll(void)
+{
+	if(!ready)
+	{
+		return;
+	}
+	if(programKind != PROGRAM_NONE)
+	{
+		/* Calls programDone() once the page program has finished */
+		if(MX25_AsyncPoll() || programKind != PROGRAM_NONE)
+		{
+			return;
+		}
+	}
+
+	FLASHERASE_Poll();
+
+	if(stampBlank() || programStaged())
+	{
+		return;
+	}
+	keepSpares();
+	if(!FLASHERASE_Busy())
+	{
+		scrub();
+	}
+}
+
+/**************************************************************************//**
+* @brief True when nothing is staged, programming or erasing
+*****************************************************************************/
+bool FLASHLOG_Idle(void)
+{
+	return !ready || (programKind == PROGRAM_NONE && stagePut == stageGet && !FLASHERASE_Busy());
+}
+
+/**************************************************************************//**
+* @brief Drop every record. Sectors are erased in the background, with 32 KB
+* block erases where a whole block is dirty
+*****************************************************************************/
+void FLASHLOG_Format(void)
+{
+	if(!ready)
+	{
+		return;
+	}
+	while(programKind != PROGRAM_NONE)
+	{
+		MX25_AsyncPoll();
+	}
+
+	stagePut = 0;
+	stageGet = 0;
+	recordLeft = 0;
+	liveCount = 0;
+	head = FLASHLOG_SECTORS - 1;
+	writeOffset = FLASHLOG_SECTOR_SIZE;
+	for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+	{
+		/* Erased sectors hold no records and are kept */
+		if(sectorState[sector] == SECTOR_LIVE)
+		{
+			sectorState[sector] = SECTOR_DIRTY;
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Read every stored record, oldest first. Blocks until done; records
+* still staged in RAM are not included
+* @return Number of records delivered
+*****************************************************************************/
+uint32_t FLASHLOG_Walk(FLASHLOG_Walker_t walker)
+{
+	uint32_t count = 0;
+	uint32_t sector;
+
+	if(!ready)
+	{
+		return 0;
+	}
+	while(programKind != PROGRAM_NONE)
+	{
+		MX25_AsyncPoll();
+	}
+
+	FLASHERASE_Hold();
+	sector = tail;
+	for(uint32_t i = 0; i < liveCount; i++)
+	{
+		while(sectorState[sector] != SECTOR_LIVE)
+		{
+			sector = nextSector(sector);
+		}
+		scanSector(sector, walker, &count);
+		sector = nextSector(sector);
+	}
+	FLASHERASE_Release();
+
+	return count;
+}
+
+/**************************************************************************//**
+* @brief Snapshot of the store counters and layout
+*****************************************************************************/
+void FLASHLOG_GetStats(FLASHLOG_Stats_t *out)
+{
+	*out = stats;
+	out->live = liveCount;
+	out->head = head;
+	out->offset = writeOffset;
+	out->staged = stagePut - stageGet;
+	out->minErases = ERASED_WORD;
+	out->maxErases = 0;
+	for(uint32_t sector = 0; sector < FLASHLOG_SECTORS; sector++)
+	{
+		if(sectorErases[sector] < out->minErases)
+		{
+			out->minErases = sectorErases[sector];
+		}
+		if(sectorErases[sector] > out->maxErases)
+		{
+			out->maxErases = sectorErases[sector];
+		}
+	}
+}
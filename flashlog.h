@@ -0,0 +1,165 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log structured test result store on the MX25 SPI flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef FLASHLOG_H_
+#define FLASHLOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Records are appended to a RAM staging ring and programmed from
+ * FLASHLOG_Poll(), so FLASHLOG_Append() never touches the flash. Sectors are
+ * used round robin, which spreads the erases evenly; when the store is full
+ * the oldest sector is recycled. The next FLASHLOG_SPARE_SECTORS sectors are
+ * kept erased in the background through flasherase.c, so opening a sector
+ * never waits for an erase. On boot only the 16 byte sector headers are read
+ * to find the newest sector, then that one sector is scanned for the end of
+ * the written records. */
+
+#ifndef FLASHLOG_BASE
+#define FLASHLOG_BASE			0x00000		// Start of the store, sector aligned
+#endif
+#ifndef FLASHLOG_SECTORS
+#define FLASHLOG_SECTORS		128			// 512 KB, half of the MX25R8035F
+#endif
+#ifndef FLASHLOG_SPARE_SECTORS
+#define FLASHLOG_SPARE_SECTORS	2			// Sectors kept erased ahead of the head
+#endif
+#ifndef FLASHLOG_STAGE_SIZE
+#define FLASHLOG_STAGE_SIZE		512			// RAM staging ring, power of two
+#endif
+
+/* Flash layout, all fields little endian.
+ *
+ * Sector header, at the start of every sector:
+ *   magic(4) erase_count(4)	programmed as soon as the erase completes
+ *   seq(4) seq_check(4)		programmed when the sector is opened, seq_check = ~seq
+ * A header with magic and an erased seq is a spare sector. seq increases by
+ * one for every sector opened and orders the sectors from oldest to newest.
+ *
+ * Record, packed after the header and never crossing a sector boundary:
+ *   len(1) type(1) crc(2) timestamp(4) payload(len)
+ * crc is FLASHLOG_Crc16() over len, type, timestamp and payload. A len of
+ * 0xFF is erased space and ends the sector. */
+#define FLASHLOG_SECTOR_SIZE	0x1000
+#define FLASHLOG_MAGIC			0x474F4C46	// "FLOG"
+#define FLASHLOG_HEADER_SIZE	16
+#define FLASHLOG_RECORD_HEADER	8
+#define FLASHLOG_MAX_PAYLOAD	64
+
+/* Record types written by the application */
+typedef enum {
+	FLASHLOG_TYPE_BOOT = 1,					// No payload, timestamps restart here
+	FLASHLOG_TYPE_RUN_START,				// FLASHLOG_RunStart_t
+	FLASHLOG_TYPE_THROUGHPUT,				// FLASHLOG_Throughput_t, once per second of a run
+	FLASHLOG_TYPE_RUN_END,					// FLASHLOG_RunEnd_t
+	FLASHLOG_TYPE_COEX,						// FLASHLOG_Coex_t
+	FLASHLOG_TYPE_EDGES,					// Up to FLASHLOG_EDGES_PER_RECORD FLASHLOG_Edge_t
+	FLASHLOG_TYPE_SETUP,					// CONNSETUP_Cycle_t, timestamp is the start of the cycle
+	FLASHLOG_TYPE_PHY_STEP,					// PHYMATRIX_Row_t, one per step when the PHY matrix ends
+	FLASHLOG_TYPE_DTM_CELL,					// DTMSWEEP_Cell_t, one per cell of the DTM sweep
+	FLASHLOG_TYPE_CPU						// FLASHLOG_Cpu_t, behind the RUN_END of a run
+} FLASHLOG_Type_t;
+
+/* FLASHLOG_RunStart_t mode */
+#define FLASHLOG_MODE_NOTIFY	0
+#define FLASHLOG_MODE_INDICATE	1
+#define FLASHLOG_MODE_WRITE		2
+
+typedef struct {
+	uint8_t phy;							// PHY_1M, PHY_2M, PHY_S8 or PHY_S2
+	uint8_t mode;							// FLASHLOG_MODE_*
+	uint16_t dataSize;						// Payload bytes per operation
+	uint16_t mtu;
+	uint16_t interval;						// Connection interval, 1.25 ms units
+} FLASHLOG_RunStart_t;
+
+typedef struct {
+	uint32_t bits;							// Bits sent since the start of the run
+	uint32_t operations;					// GATT operations since boot
+} FLASHLOG_Throughput_t;
+
+typedef struct {
+	uint32_t bits;
+	uint32_t ticks;							// Run length, RTCC ticks
+	uint32_t throughput;					// bits/s
+	uint32_t operations;
+} FLASHLOG_RunEnd_t;
+
+/* Where the core's time went in a run, see headroom.h */
+typedef struct {
+	uint32_t coreHz;
+	uint16_t permille[4];					// App, stack, spin, sleep
+	uint32_t neededHz;
+} FLASHLOG_Cpu_t;
+
+typedef struct {
+	uint32_t lpRequests;
+	uint32_t hpRequests;
+	uint32_t lpDenials;
+	uint32_t hpDenials;
+} FLASHLOG_Coex_t;
+
+/* Coex pin edge, as queued by the GPIO interrupt dispatcher */
+typedef struct {
+	uint32_t timestamp;						// RTCC when the interrupt ran
+	uint8_t intNo;							// Pin interrupt number, the pin number
+	uint8_t level;
+	uint16_t dropped;						// Edges lost just before this one
+} FLASHLOG_Edge_t;
+
+#define FLASHLOG_EDGES_PER_RECORD	(FLASHLOG_MAX_PAYLOAD / sizeof(FLASHLOG_Edge_t))
+
+typedef struct {
+	uint32_t appended;						// Records accepted by FLASHLOG_Append()
+	uint32_t dropped;						// Records refused, staging full or no flash
+	uint32_t written;						// Records completely programmed
+	uint32_t corrupt;						// Records failing the CRC, seen by Init or Walk
+	uint32_t recycled;						// Sectors whose records were dropped for space
+	uint32_t live;							// Sectors holding records
+	uint32_t head;							// Sector being written
+	uint32_t offset;						// Write offset in the head sector
+	uint32_t staged;						// Bytes waiting in RAM
+	uint32_t minErases;						// Lowest and highest erase count of any sector
+	uint32_t maxErases;
+} FLASHLOG_Stats_t;
+
+typedef void (*FLASHLOG_Walker_t)(uint8_t type, uint32_t timestamp, const uint8_t *payload, uint32_t len);
+
+/* CRC-16/CCITT-FALSE, seed with 0xFFFF */
+static inline uint16_t FLASHLOG_Crc16(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+	while(len--)
+	{
+		crc ^= (uint16_t)(*data++ << 8);
+		for(int i = 0; i < 8; i++)
+		{
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+bool FLASHLOG_Init(void);
+bool FLASHLOG_Append(uint8_t type, uint32_t timestamp, const void *payload, uint32_t len);
+void FLASHLOG_Poll(void);
+bool FLASHLOG_Idle(void);
+void FLASHLOG_Format(void);
+uint32_t FLASHLOG_Walk(FLASHLOG_Walker_t walker);
+void FLASHLOG_GetStats(FLASHLOG_Stats_t *stats);
+
+#endif
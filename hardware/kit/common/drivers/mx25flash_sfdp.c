@@ -0,0 +1,232 @@
+/***************************************************************************//**
+ * @file
+ * @brief JEDEC SFDP parser and read mode selection for the MX25 driver.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "mx25flash_sfdp.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup MX25
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+#define HEADER_SIZE         8       // SFDP header and each parameter header
+#define BFPT_ID_LSB         0x00
+#define BFPT_ID_MSB         0xFF
+#define BFPT_MIN_DWORDS     9       // JESD216 rev A
+#define BFPT_PAGE_DWORD     11      // Page size, JESD216 rev A and later
+#define CLOCKS_COMMAND      8
+
+static uint32_t get32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* BFPT DWORD n, counting from 1 like JESD216 does */
+static uint32_t dword(const uint8_t *bfpt, uint32_t n)
+{
+  return get32(&bfpt[(n - 1) * 4]);
+}
+
+/* One 16 bit fast read descriptor from BFPT DWORD 3 or 4 */
+static void fastRead(MX25_SFDP_Read_t *read,
+                     bool supported,
+                     uint16_t field,
+                     uint8_t addressLines,
+                     uint8_t dataLines)
+{
+  read->supported    = supported && ((field >> 8) != 0);
+  read->opcode       = field >> 8;
+  read->waitStates   = field & 0x1F;
+  read->modeClocks   = (field >> 5) & 0x07;
+  read->addressLines = addressLines;
+  read->dataLines    = dataLines;
+}
+
+static void erase(MX25_SFDP_Erase_t *slot, uint16_t field)
+{
+  uint8_t exponent = field & 0xFF;
+
+  slot->size   = (exponent != 0 && exponent < 32) ? (1UL << exponent) : 0;
+  slot->opcode = field >> 8;
+}
+
+/** @endcond */
+
+/**************************************************************************//**
+ * @brief Decode the SFDP header and the basic flash parameter table
+ * @param sfdp SFDP space read from address 0 with RDSFDP
+ * @param length Number of bytes in sfdp
+ * @param info Filled in on success
+ * @return false if the signature is missing, there is no BFPT or the BFPT
+ *         does not fit in length. info is not touched in that case.
+ * @details The newest BFPT revision whose table fits is used. The parser
+ *          never reads outside sfdp, so it can be fed captured or corrupt
+ *          blobs on a host.
+ *****************************************************************************/
+bool MX25_SFDP_Parse(const uint8_t *sfdp, uint32_t length, MX25_SFDP_Info_t *info)
+{
+  const uint8_t *bfpt = NULL;
+  uint32_t dwords = 0;
+  uint32_t headers;
+  uint32_t first;
+  uint32_t density;
+  MX25_SFDP_Info_t out;
+
+  if (length < 2 * HEADER_SIZE || get32(sfdp) != MX25_SFDP_SIGNATURE || sfdp[5] != 1) {
+    return false;
+  }
+
+  memset(&out, 0, sizeof(out));
+
+  /* NPH is zero based, the BFPT header is mandatory and comes first */
+  headers = sfdp[6] + 1;
+  for (uint32_t i = 0; i < headers && HEADER_SIZE * (i + 2) <= length; i++) {
+    const uint8_t *h = &sfdp[HEADER_SIZE * (i + 1)];
+    uint32_t pointer = h[4] | (h[5] << 8) | (h[6] << 16);
+
+    if (h[0] != BFPT_ID_LSB || h[7] != BFPT_ID_MSB || h[2] != 1
+        || h[3] < BFPT_MIN_DWORDS || pointer + 4 * h[3] > length) {
+      continue;
+    }
+    if (bfpt == NULL || h[1] >= out.minor) {
+      bfpt       = &sfdp[pointer];
+      dwords     = h[3];
+      out.major  = h[2];
+      out.minor  = h[1];
+    }
+  }
+  if (bfpt == NULL) {
+    return false;
+  }
+  out.dwords = dwords;
+
+  first = dword(bfpt, 1);
+  switch ((first >> 17) & 0x03) {
+    case 0:
+      out.addressBytes = 3;
+      break;
+    case 1:
+      out.addressBytes = 34;
+      break;
+    default:
+      out.addressBytes = 4;
+      break;
+  }
+
+  /* Bit 31 set: the rest is log2 of the size in bits */
+  density = dword(bfpt, 2);
+  if (density & 0x80000000) {
+    density &= 0x7FFFFFFF;
+    out.sizeBytes = (density >= 3 && density < 35) ? (uint32_t)(1ULL << (density - 3)) : 0;
+  } else {
+    out.sizeBytes = (uint32_t)(((uint64_t)density + 1) / 8);
+  }
+
+  out.pageSize = 256;
+  if (dwords >= BFPT_PAGE_DWORD) {
+    out.pageSize = 1UL << ((dword(bfpt, BFPT_PAGE_DWORD) >> 4) & 0x0F);
+  }
+
+  erase(&out.erase[0], dword(bfpt, 8) & 0xFFFF);
+  erase(&out.erase[1], dword(bfpt, 8) >> 16);
+  erase(&out.erase[2], dword(bfpt, 9) & 0xFFFF);
+  erase(&out.erase[3], dword(bfpt, 9) >> 16);
+
+  /* 03h and 0Bh are not described, every SFDP part has them */
+  out.read[MX25_SFDP_READ_1_1_1] = (MX25_SFDP_Read_t){ true, 0x03, 0, 0, 1, 1 };
+  out.read[MX25_SFDP_FAST_1_1_1] = (MX25_SFDP_Read_t){ true, 0x0B, 8, 0, 1, 1 };
+  fastRead(&out.read[MX25_SFDP_FAST_1_1_2], first & (1UL << 16), dword(bfpt, 4) & 0xFFFF, 1, 2);
+  fastRead(&out.read[MX25_SFDP_FAST_1_2_2], first & (1UL << 20), dword(bfpt, 4) >> 16, 2, 2);
+  fastRead(&out.read[MX25_SFDP_FAST_1_1_4], first & (1UL << 22), dword(bfpt, 3) >> 16, 1, 4);
+  fastRead(&out.read[MX25_SFDP_FAST_1_4_4], first & (1UL << 21), dword(bfpt, 3) & 0xFFFF, 4, 4);
+
+  *info = out;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Serial clocks one read instruction takes, 3 byte addressing
+ * @param info Parsed SFDP
+ * @param mode Read instruction
+ * @param bytes Data bytes read by the instruction
+ *****************************************************************************/
+uint32_t MX25_SFDP_ReadClocks(const MX25_SFDP_Info_t *info,
+                              MX25_SFDP_ReadMode_t mode,
+                              uint32_t bytes)
+{
+  const MX25_SFDP_Read_t *read = &info->read[mode];
+
+  return CLOCKS_COMMAND
+         + (24 / read->addressLines)
+         + read->modeClocks + read->waitStates
+         + (8 * bytes) / read->dataLines;
+}
+
+/**************************************************************************//**
+ * @brief Pick the read instruction that moves a page in the fewest clocks
+ * @param info Parsed SFDP
+ * @param busLines Data lines wired between the MCU and the flash: 1, 2 or 4
+ * @param spiHz Serial clock the driver runs at
+ * @param readMaxHz Highest clock READ 03h is specified for; the fast reads
+ *        are assumed to run at any clock the MCU can produce
+ *****************************************************************************/
+MX25_SFDP_ReadMode_t MX25_SFDP_SelectRead(const MX25_SFDP_Info_t *info,
+                                          uint8_t busLines,
+                                          uint32_t spiHz,
+                                          uint32_t readMaxHz)
+{
+  MX25_SFDP_ReadMode_t best = MX25_SFDP_FAST_1_1_1;
+
+  for (int mode = 0; mode < MX25_SFDP_READ_MODES; mode++) {
+    const MX25_SFDP_Read_t *read = &info->read[mode];
+
+    if (!read->supported
+        || read->addressLines > busLines || read->dataLines > busLines
+        || (mode == MX25_SFDP_READ_1_1_1 && spiHz > readMaxHz)) {
+      continue;
+    }
+    if (MX25_SFDP_ReadClocks(info, (MX25_SFDP_ReadMode_t)mode, info->pageSize)
+        < MX25_SFDP_ReadClocks(info, best, info->pageSize)) {
+      best = (MX25_SFDP_ReadMode_t)mode;
+    }
+  }
+
+  return best;
+}
+
+/**************************************************************************//**
+ * @brief Short name of a read instruction, for logs
+ *****************************************************************************/
+const char *MX25_SFDP_ReadName(MX25_SFDP_ReadMode_t mode)
+{
+  static const char *names[MX25_SFDP_READ_MODES] = {
+    "READ 1-1-1", "FASTREAD 1-1-1", "DREAD 1-1-2", "2READ 1-2-2", "QREAD 1-1-4", "4READ 1-4-4"
+  };
+
+  return (mode < MX25_SFDP_READ_MODES) ? names[mode] : "?";
+}
+
+/** @} (end group MX25) */
+/** @} (end group kitdrv) */
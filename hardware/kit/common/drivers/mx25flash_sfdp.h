@@ -0,0 +1,107 @@
+/***************************************************************************//**
+ * @file
+ * @brief JEDEC SFDP parser and read mode selection for the MX25 driver.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef __MX25FLASH_SFDP_H
+#define __MX25FLASH_SFDP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup MX25
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bytes of SFDP space read at boot. Covers the header, the parameter
+ *  headers and a JESD216B basic flash parameter table (BFPT) of up to 16
+ *  DWORDs on every part that keeps the BFPT near the start. */
+#define MX25_SFDP_SIZE           256
+
+/** SFDP signature, "SFDP" read as a little endian word */
+#define MX25_SFDP_SIGNATURE      0x50444653
+
+/**
+ * Read instructions described by the BFPT, slowest first. The names give the
+ * number of lines used for instruction, address and data.
+ */
+typedef enum {
+  MX25_SFDP_READ_1_1_1 = 0,     /**< READ 03h, no dummy cycles */
+  MX25_SFDP_FAST_1_1_1,         /**< FASTREAD 0Bh, 8 dummy cycles */
+  MX25_SFDP_FAST_1_1_2,         /**< DREAD */
+  MX25_SFDP_FAST_1_2_2,         /**< 2READ */
+  MX25_SFDP_FAST_1_1_4,         /**< QREAD */
+  MX25_SFDP_FAST_1_4_4,         /**< 4READ */
+  MX25_SFDP_READ_MODES
+} MX25_SFDP_ReadMode_t;
+
+/** One read instruction */
+typedef struct {
+  bool    supported;
+  uint8_t opcode;
+  uint8_t waitStates;           /**< Dummy clocks after the mode bits */
+  uint8_t modeClocks;           /**< Clocks carrying mode bits */
+  uint8_t addressLines;
+  uint8_t dataLines;
+} MX25_SFDP_Read_t;
+
+/** One erase instruction from BFPT DWORDs 8 and 9 */
+typedef struct {
+  uint32_t size;                /**< Bytes, 0 if the slot is unused */
+  uint8_t  opcode;
+} MX25_SFDP_Erase_t;
+
+/** What the driver needs to know from the BFPT */
+typedef struct {
+  uint8_t           major;      /**< BFPT revision */
+  uint8_t           minor;
+  uint8_t           dwords;     /**< BFPT length used */
+  uint8_t           addressBytes; /**< 3, 4, or 34 for either */
+  uint32_t          sizeBytes;
+  uint32_t          pageSize;   /**< 256 unless BFPT DWORD 11 says otherwise */
+  MX25_SFDP_Erase_t erase[4];
+  MX25_SFDP_Read_t  read[MX25_SFDP_READ_MODES];
+} MX25_SFDP_Info_t;
+
+bool     MX25_SFDP_Parse(const uint8_t *sfdp,
+                         uint32_t length,
+                         MX25_SFDP_Info_t *info);
+uint32_t MX25_SFDP_ReadClocks(const MX25_SFDP_Info_t *info,
+                              MX25_SFDP_ReadMode_t mode,
+                              uint32_t bytes);
+MX25_SFDP_ReadMode_t MX25_SFDP_SelectRead(const MX25_SFDP_Info_t *info,
+                                          uint8_t busLines,
+                                          uint32_t spiHz,
+                                          uint32_t readMaxHz);
+const char *MX25_SFDP_ReadName(MX25_SFDP_ReadMode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group MX25) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -20,13 +20,65 @@
  * $Id: MX25_CMD.c,v 1.31 2015/03/24 01:06:33 mxclldb1 Exp $
  */
 
+#include <stddef.h>
+#include <string.h>
 #include "mx25flash_spi.h"
+#include "mx25flash_sfdp.h"
+#ifdef MX25_HOST_MODEL
+#include "mx25_model.h"
+#else
 #include "em_gpio.h"
 #include "em_usart.h"
 #include "em_cmu.h"
+#include "em_rtcc.h"
+#endif
 
 /* If the USART for the MX25 driver is not defined, these functions are unavailable */
-#ifdef MX25_USART
+#if defined(MX25_USART) || defined(MX25_HOST_MODEL)
+
+/* One full duplex byte on the SPI bus */
+#ifdef MX25_HOST_MODEL
+#define MX25_SPI_TRANSFER( data )    MX25_MODEL_Transfer( data )
+#else
+#define MX25_SPI_TRANSFER( data )    USART_SpiTransfer( MX25_USART, data )
+#endif
+
+/* Time base for the asynchronous page program timeout, one that keeps
+   counting while the core sleeps between polls */
+#ifdef MX25_HOST_MODEL
+#define MX25_SLEEPSTAMP()      ( (uint32_t)MX25_MODEL_Now() )
+#define MX25_SLEEPSTAMP_HZ     1000000
+#else
+#define MX25_SLEEPSTAMP()      RTCC_CounterGet()
+#define MX25_SLEEPSTAMP_HZ     32768
+#endif
+/* tPP in ns, rounded up, one more for the count the start fell in */
+#define PageProgramStamps      ( (uint32_t)( ( (uint64_t)tPP * MX25_SLEEPSTAMP_HZ + 999999999 ) / 1000000000 ) + 1 )
+
+/* LDMA request signals for the bulk data phase. Only USART0/1 have signals
+   declared in the DMADRV subset, other ports keep the polled data phase. */
+#if !defined(MX25_HOST_MODEL) && defined(BSP_EXTFLASH_USART) && !defined(MX25_DMA_RX_SIGNAL)
+#if BSP_EXTFLASH_USART == HAL_SPI_PORT_USART0
+#define MX25_DMA_RX_SIGNAL     dmadrvPeripheralSignal_USART0_RXDATAV
+#define MX25_DMA_TX_SIGNAL     dmadrvPeripheralSignal_USART0_TXBL
+#elif BSP_EXTFLASH_USART == HAL_SPI_PORT_USART1
+#define MX25_DMA_RX_SIGNAL     dmadrvPeripheralSignal_USART1_RXDATAV
+#define MX25_DMA_TX_SIGNAL     dmadrvPeripheralSignal_USART1_TXBL
+#endif
+#endif
+
+#ifndef MX25_DMA
+#if defined(MX25_DMA_RX_SIGNAL) && defined(MX25_DMA_TX_SIGNAL)
+#define MX25_DMA               1
+#else
+#define MX25_DMA               0
+#endif
+#endif
+
+#if MX25_DMA
+#include "dmadrv.h"
+#include "sleep.h"
+#endif
 
 /* Fallback to loc 11 if no location is defined for backwards compatibility */
 #ifndef MX25_LOC_RX
@@ -43,6 +95,31 @@
 #define MX25_BAUDRATE   8000000
 #endif
 
+/* Data lines between the MCU and the flash. The USART drives SI and samples
+   SO only, so MX25_ReadFast() never picks a dual or quad read on this port. */
+#ifndef MX25_BUS_LINES
+#define MX25_BUS_LINES         1
+#endif
+/* fR, the highest clock READ 03h is specified for on the MX25R8035F */
+#ifndef MX25_READ_MAX_HZ
+#define MX25_READ_MAX_HZ       33000000
+#endif
+/* Page reads timed by MX25_ReadFastConfigure() */
+#ifndef MX25_READFAST_PROBE
+#define MX25_READFAST_PROBE    16
+#endif
+
+/* Time base for the read throughput probe */
+#ifdef MX25_HOST_MODEL
+#define MX25_SPI_HZ            MX25_MODEL_SPI_HZ
+#define MX25_TIMESTAMP()       ( (uint32_t)MX25_MODEL_Now() )
+#define MX25_TIMESTAMP_HZ      1000000
+#else
+#define MX25_SPI_HZ            USART_BaudrateGet( MX25_USART )
+#define MX25_TIMESTAMP()       ( DWT->CYCCNT )
+#define MX25_TIMESTAMP_HZ      SystemCoreClockGet()
+#endif
+
 /* Local functions */
 
 /* Basic functions */
@@ -63,7 +140,51 @@ bool IsFlash4Byte( void );
 void SendFlashAddr( uint32_t flash_address, uint8_t io_mode, bool addr_4byte_mode );
 uint8_t GetDummyCycle( uint32_t default_cycle );
 
+/* Asynchronous transfer engine */
+static ReturnMsg AsyncBulkStart( uint8_t *rx, const uint8_t *tx, uint32_t byte_length, bool program, MX25_Callback_t callback, void *user );
+static ReturnMsg AsyncWait( void );
+static ReturnMsg EraseStart( uint8_t erase_cmd, uint32_t flash_address );
+
 
+#if MX25_DMA
+static unsigned int dmaRxChannel;
+static unsigned int dmaTxChannel;
+static bool         dmaReady = false;
+#endif
+
+/* Asynchronous transfer state */
+enum {
+    AsyncIdle,              // No transfer in progress
+    AsyncTransfer,          // Data phase running, CS low
+    AsyncTransferDone,      // Data phase done, callback pending
+    AsyncProgram            // Page buffer loaded, waiting for WIP to clear
+};
+
+static volatile uint8_t asyncState = AsyncIdle;
+static uint8_t          *asyncRx;           // Receive buffer, NULL to discard
+static const uint8_t    *asyncTx;           // Transmit buffer, NULL to send 0xff
+static uint32_t         asyncRemaining;     // Bytes left in the data phase
+static uint32_t         asyncChunk;         // Bytes in the running LDMA transfer
+static bool             asyncProgramming;   // Data phase loads the page buffer
+static MX25_Callback_t  asyncCallback;
+static void             *asyncUser;
+static uint32_t         asyncProgramStart;  // MX25_SLEEPSTAMP() when WIP was set
+
+#ifdef MX25_HOST_MODEL
+void MX25_init( void )
+{
+   /* Stands in for the reset a target goes through before MX25_init */
+   asyncState = AsyncIdle;
+   MX25_MODEL_Select( false );
+
+   /* Wait for flash warm-up */
+   Initial_Spi();
+}
+
+void MX25_deinit( void )
+{
+}
+#else
 void MX25_init( void )
 {
    USART_InitSync_TypeDef init = USART_INITSYNC_DEFAULT;
@@ -99,6 +220,35 @@ void MX25_init( void )
                             | USART_ROUTEPEN_TXPEN
                             | USART_ROUTEPEN_CLKPEN );
 
+#endif
+#if MX25_DMA
+   /* With every channel fixed priority ( EMDRV_DMADRV_DMA_CH_PRIORITY in
+      dmadrv_config.h ) a lower channel wins arbitration. RX takes the lower
+      of the pair, whatever order they were handed out in, so it always
+      drains RXDATA before TX can run ahead of it */
+   if( !dmaReady )
+   {
+      unsigned int channel;
+
+      DMADRV_Init();
+      dmaReady = ( DMADRV_AllocateChannel( &dmaRxChannel, NULL ) == ECODE_EMDRV_DMADRV_OK )
+                 && ( DMADRV_AllocateChannel( &dmaTxChannel, NULL ) == ECODE_EMDRV_DMADRV_OK );
+      if( dmaReady && ( dmaTxChannel < dmaRxChannel ) )
+      {
+         channel      = dmaRxChannel;
+         dmaRxChannel = dmaTxChannel;
+         dmaTxChannel = channel;
+      }
+#if ( EMDRV_DMADRV_DMA_CH_PRIORITY < EMDRV_DMADRV_DMA_CH_COUNT )
+      /* Past the fixed channels RX and TX would be round-robin */
+      if( dmaReady && ( dmaRxChannel >= EMDRV_DMADRV_DMA_CH_PRIORITY ) )
+      {
+         DMADRV_FreeChannel( dmaTxChannel );
+         DMADRV_FreeChannel( dmaRxChannel );
+         dmaReady = false;
+      }
+#endif
+   }
 #endif
    /* Wait for flash warm-up */
    Initial_Spi();
@@ -106,6 +256,15 @@ void MX25_init( void )
 
 void MX25_deinit( void )
 {
+#if MX25_DMA
+  if( dmaReady )
+  {
+    DMADRV_FreeChannel( dmaTxChannel );
+    DMADRV_FreeChannel( dmaRxChannel );
+    dmaReady = false;
+  }
+#endif
+
   GPIO_PinModeSet( MX25_PORT_MOSI, MX25_PIN_MOSI, gpioModeDisabled, 0);
   GPIO_PinModeSet( MX25_PORT_MISO, MX25_PIN_MISO, gpioModeDisabled, 0);
   GPIO_PinModeSet( MX25_PORT_SCLK, MX25_PIN_SCLK, gpioModeDisabled, 1);
@@ -125,6 +284,7 @@ void MX25_deinit( void )
 
   CMU_ClockEnable( MX25_USART_CLK, false );
 }
+#endif //MX25_HOST_MODEL
 
 /*
  --Common functions
@@ -166,12 +326,20 @@ void Initial_Spi()
  */
 void CS_Low()
 {
+#ifdef MX25_HOST_MODEL
+   MX25_MODEL_Select( true );
+#else
    GPIO_PinOutClear( MX25_PORT_CS, MX25_PIN_CS );
+#endif
 }
 
 void CS_High()
 {
+#ifdef MX25_HOST_MODEL
+   MX25_MODEL_Select( false );
+#else
    GPIO_PinOutSet( MX25_PORT_CS, MX25_PIN_CS );
+#endif
 }
 
 /*
@@ -186,7 +354,7 @@ void InsertDummyCycle( uint8_t dummy_cycle )
 
    for( i = 0; i < dummy_cycle/8; i++ )
    {
-      USART_SpiTransfer( MX25_USART, 0xff );
+      MX25_SPI_TRANSFER( 0xff );
    }
 }
 
@@ -211,7 +379,7 @@ void SendByte( uint8_t byte_value, uint8_t transfer_type )
    {
 #ifdef SIO
    case SIO: // Single I/O
-      USART_SpiTransfer( MX25_USART, byte_value );
+      MX25_SPI_TRANSFER( byte_value );
       break;
 #endif
 #ifdef DIO
@@ -274,7 +442,7 @@ uint8_t GetByte( uint8_t transfer_type )
 #ifdef SIO
    case SIO: // Single I/O
       //--- insert your code here for single IO receive. ---//
-      data_buf = USART_SpiTransfer( MX25_USART, 0xff );
+      data_buf = MX25_SPI_TRANSFER( 0xff );
       break;
 #endif
 #ifdef DIO
@@ -357,8 +525,10 @@ bool WaitRYBYReady( uint32_t ExpectTime )
 {
 #ifndef NON_SYNCHRONOUS_IO
     uint32_t temp = 0;
-#ifdef GPIO_SPI
+#if defined(GPIO_SPI)
     while( SO == 0 )
+#elif defined(MX25_HOST_MODEL)
+    while( IsFlashBusy() )
 #else
     while(GPIO_PinInGet(MX25_PORT_MISO, MX25_PIN_MISO) == 0)
 #endif
@@ -791,16 +961,42 @@ ReturnMsg MX25_RDCR( uint8_t *ConfigReg )
  *                 target_address, buffer address to store returned data
  *                 byte_length, length of returned data in byte unit
  * Description:    The READ instruction is for reading data out.
- * Return Message: FlashAddressInvalid, FlashOperationSuccess
+ *                 Blocking wrapper around MX25_READ_Async.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
  */
 ReturnMsg MX25_READ( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length )
 {
-    uint32_t index;
+    ReturnMsg status;
+
+    // Start the transfer and wait for the data phase to complete
+    status = MX25_READ_Async( flash_address, target_address, byte_length, NULL, NULL );
+    if( status == FlashOperationSuccess )
+        status = AsyncWait();
+
+    return status;
+}
+
+/*
+ * Function:       MX25_READ_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ *                 callback, called from MX25_AsyncPoll when done, or NULL
+ *                 user, passed to callback
+ * Description:    Start a READ instruction and return while the data phase
+ *                 is still running.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_READ_Async( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_Callback_t callback, void *user )
+{
     uint8_t  addr_4byte_mode;
 
     // Check flash address
     if( flash_address > FlashSize ) return FlashAddressInvalid;
 
+    // Only one transfer at a time
+    if( asyncState != AsyncIdle ) return FlashIsBusy;
+
     // Check 3-byte or 4-byte mode
     if( IsFlash4Byte() )
         addr_4byte_mode = TRUE;  // 4-byte mode
@@ -814,17 +1010,8 @@ ReturnMsg MX25_READ( uint32_t flash_address, uint8_t *target_address, uint32_t b
     SendByte( FLASH_CMD_READ, SIO );
     SendFlashAddr( flash_address, SIO, addr_4byte_mode );
 
-    // Set a loop to read data into buffer
-    for( index=0; index < byte_length; index++ )
-    {
-        // Read data one byte at a time
-        *(target_address + index) = GetByte( SIO );
-    }
-
-    // Chip select go high to end a flash command
-    CS_High();
-
-    return FlashOperationSuccess;
+    // Read data into buffer, chip select goes high when it is done
+    return AsyncBulkStart( target_address, NULL, byte_length, FALSE, callback, user );
 }
 
 /*
@@ -1030,17 +1217,43 @@ ReturnMsg MX25_QREAD( uint32_t flash_address, uint8_t *target_address, uint32_t
  *                 target_address, buffer address to store returned data
  *                 byte_length, length of returned data in byte unit
  * Description:    The FASTREAD instruction is for quickly reading data out.
- * Return Message: FlashAddressInvalid, FlashOperationSuccess
+ *                 Blocking wrapper around MX25_FASTREAD_Async.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
  */
 ReturnMsg MX25_FASTREAD( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length )
 {
-    uint32_t index;
+    ReturnMsg status;
+
+    // Start the transfer and wait for the data phase to complete
+    status = MX25_FASTREAD_Async( flash_address, target_address, byte_length, NULL, NULL );
+    if( status == FlashOperationSuccess )
+        status = AsyncWait();
+
+    return status;
+}
+
+/*
+ * Function:       MX25_FASTREAD_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ *                 callback, called from MX25_AsyncPoll when done, or NULL
+ *                 user, passed to callback
+ * Description:    Start a FASTREAD instruction and return while the data
+ *                 phase is still running.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_FASTREAD_Async( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_Callback_t callback, void *user )
+{
     uint8_t  addr_4byte_mode;
     uint8_t  dc;
 
     // Check flash address
     if( flash_address > FlashSize ) return FlashAddressInvalid;
 
+    // Only one transfer at a time
+    if( asyncState != AsyncIdle ) return FlashIsBusy;
+
     // Check 3-byte or 4-byte mode
     if( IsFlash4Byte() )
         addr_4byte_mode = TRUE;  // 4-byte mode
@@ -1057,16 +1270,8 @@ ReturnMsg MX25_FASTREAD( uint32_t flash_address, uint8_t *target_address, uint32
     SendFlashAddr( flash_address, SIO, addr_4byte_mode );
     InsertDummyCycle ( dc );          // Wait dummy cycle
 
-    // Set a loop to read data into data buffer
-    for( index=0; index < byte_length; index++ )
-    {
-        *(target_address + index) = GetByte( SIO );
-    }
-
-    // Chip select go high to end a flash command
-    CS_High();
-
-    return FlashOperationSuccess;
+    // Read data into buffer, chip select goes high when it is done
+    return AsyncBulkStart( target_address, NULL, byte_length, FALSE, callback, user );
 }
 
 
@@ -1113,6 +1318,128 @@ ReturnMsg MX25_RDSFDP( uint32_t flash_address, uint8_t *target_address, uint32_t
 
     return FlashOperationSuccess;
 }
+
+/*
+ * Read Mode Autoconfiguration
+ */
+
+static uint8_t  readFastMode = MX25_SFDP_READ_1_1_1;   // READ until configured
+static uint32_t readFastRate = 0;                      // bytes/s, 0 until measured
+
+/*
+ * Function:       MX25_ReadFastConfigure
+ * Arguments:      None.
+ * Description:    Read the SFDP tables and select the read instruction that
+ *                 moves a page in the fewest clocks with the lines wired to
+ *                 the part (MX25_BUS_LINES). The choice is checked against
+ *                 READ on the first page and its throughput is measured
+ *                 with MX25_READFAST_PROBE page reads. Without a valid SFDP
+ *                 table READ is kept and still measured.
+ * Return Message: FlashIsBusy, FlashAddressInvalid (no SFDP table),
+ *                 FlashOperationSuccess
+ */
+ReturnMsg MX25_ReadFastConfigure( void )
+{
+    uint8_t          sfdp[MX25_SFDP_SIZE];
+    uint8_t          check[Page_Offset];
+    MX25_SFDP_Info_t info;
+    ReturnMsg        status = FlashOperationSuccess;
+    uint32_t         start;
+    uint32_t         elapsed;
+    uint32_t         index;
+
+    // Only one transfer at a time
+    if( asyncState != AsyncIdle ) return FlashIsBusy;
+
+    readFastMode = MX25_SFDP_READ_1_1_1;
+    MX25_RDSFDP( 0, sfdp, sizeof( sfdp ) );
+    if( MX25_SFDP_Parse( sfdp, sizeof( sfdp ), &info ) )
+    {
+        readFastMode = MX25_SFDP_SelectRead( &info, MX25_BUS_LINES, MX25_SPI_HZ, MX25_READ_MAX_HZ );
+
+        // A mode the port cannot drive, or one that reads back different data, is dropped
+        MX25_READ( 0, sfdp, Page_Offset );
+        if( MX25_ReadFast( 0, check, Page_Offset ) != FlashOperationSuccess
+            || memcmp( sfdp, check, Page_Offset ) != 0 )
+        {
+            readFastMode = MX25_SFDP_READ_1_1_1;
+        }
+    }
+    else
+    {
+        status = FlashAddressInvalid;
+    }
+
+#ifndef MX25_HOST_MODEL
+    // The cycle counter may not be running without a debugger attached
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    start = MX25_TIMESTAMP();
+    for( index = 0; index < MX25_READFAST_PROBE; index++ )
+    {
+        MX25_ReadFast( index * Page_Offset, check, Page_Offset );
+    }
+    elapsed = MX25_TIMESTAMP() - start;
+    readFastRate = elapsed ? (uint32_t)( (uint64_t)MX25_READFAST_PROBE * Page_Offset * MX25_TIMESTAMP_HZ / elapsed ) : 0;
+
+    return status;
+}
+
+/*
+ * Function:       MX25_ReadFast
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 target_address, buffer address to store returned data
+ *                 byte_length, length of returned data in byte unit
+ * Description:    Read with the instruction picked by MX25_ReadFastConfigure,
+ *                 READ if it has not been called.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_ReadFast( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length )
+{
+    switch( readFastMode )
+    {
+    case MX25_SFDP_FAST_1_1_1:
+        return MX25_FASTREAD( flash_address, target_address, byte_length );
+    case MX25_SFDP_FAST_1_1_2:
+        return MX25_DREAD( flash_address, target_address, byte_length );
+    case MX25_SFDP_FAST_1_2_2:
+        return MX25_2READ( flash_address, target_address, byte_length );
+    case MX25_SFDP_FAST_1_1_4:
+        return MX25_QREAD( flash_address, target_address, byte_length );
+    case MX25_SFDP_FAST_1_4_4:
+        return MX25_4READ( flash_address, target_address, byte_length );
+    default:
+        return MX25_READ( flash_address, target_address, byte_length );
+    }
+}
+
+/*
+ * Function:       MX25_ReadFastMode
+ * Arguments:      None.
+ * Description:    Read instruction used by MX25_ReadFast, an
+ *                 MX25_SFDP_ReadMode_t value.
+ * Return Message: Read mode
+ */
+uint8_t MX25_ReadFastMode( void )
+{
+    return readFastMode;
+}
+
+/*
+ * Function:       MX25_ReadFastRate
+ * Arguments:      None.
+ * Description:    Throughput of MX25_ReadFast measured by
+ *                 MX25_ReadFastConfigure, page sized reads including the
+ *                 instruction, address and dummy cycles.
+ * Return Message: Bytes per second, 0 if not measured
+ */
+uint32_t MX25_ReadFastRate( void )
+{
+    return readFastRate;
+}
+
 /*
  * Program Command
  */
@@ -1170,17 +1497,45 @@ ReturnMsg MX25_WRDI( void )
  *                 If the page address ( flash_address[7:0] ) reach 0xFF, it will
  *                 program next at 0x00 of the same page.
  *                 Some products have smaller page size ( 32 byte )
+ *                 Blocking wrapper around MX25_PP_Async.
  * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess,
  *                 FlashTimeOut
  */
 ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length )
 {
-    uint32_t index;
+    ReturnMsg status;
+
+    // Start the transfer and wait for the program cycle to complete
+    status = MX25_PP_Async( flash_address, source_address, byte_length, NULL, NULL );
+    if( status == FlashOperationSuccess )
+        status = AsyncWait();
+
+    return status;
+}
+
+/*
+ * Function:       MX25_PP_Async
+ * Arguments:      flash_address, 32 bit flash memory address
+ *                 source_address, buffer address of source data to program,
+ *                 must stay valid until the callback
+ *                 byte_length, byte length of data to programm
+ *                 callback, called from MX25_AsyncPoll when done, or NULL
+ *                 user, passed to callback
+ * Description:    Start a PP instruction and return while the page buffer
+ *                 is still being loaded. MX25_AsyncPoll reports completion
+ *                 once the WIP bit has cleared.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_PP_Async( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length, MX25_Callback_t callback, void *user )
+{
     uint8_t  addr_4byte_mode;
 
     // Check flash address
     if( flash_address > FlashSize ) return FlashAddressInvalid;
 
+    // Only one transfer at a time
+    if( asyncState != AsyncIdle ) return FlashIsBusy;
+
     // Check flash is busy or not
     if( IsFlashBusy() )    return FlashIsBusy;
 
@@ -1200,20 +1555,10 @@ ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byt
     SendByte( FLASH_CMD_PP, SIO );
     SendFlashAddr( flash_address, SIO, addr_4byte_mode );
 
-    // Set a loop to down load whole page data into flash's buffer
+    // Down load whole page data into flash's buffer, chip select goes
+    // high when it is done and the program cycle starts
     // Note: only last 256 byte ( or 32 byte ) will be programmed
-    for( index=0; index < byte_length; index++ )
-    {
-        SendByte( *(source_address + index), SIO );
-    }
-
-    // Chip select go high to end a flash command
-    CS_High();
-
-    if( WaitFlashReady( PageProgramCycleTime ) )
-        return FlashOperationSuccess;
-    else
-        return FlashTimeOut;
+    return AsyncBulkStart( NULL, source_address, byte_length, TRUE, callback, user );
 }
 
 
@@ -1290,32 +1635,11 @@ ReturnMsg MX25_4PP( uint32_t flash_address, uint8_t *source_address, uint32_t by
  */
 ReturnMsg MX25_SE( uint32_t flash_address )
 {
-    uint8_t  addr_4byte_mode;
+    ReturnMsg status;
 
-    // Check flash address
-    if( flash_address > FlashSize ) return FlashAddressInvalid;
-
-    // Check flash is busy or not
-    if( IsFlashBusy() )    return FlashIsBusy;
-
-    // Check 3-byte or 4-byte mode
-    if( IsFlash4Byte() )
-        addr_4byte_mode = TRUE;  // 4-byte mode
-    else
-        addr_4byte_mode = FALSE; // 3-byte mode
-
-    // Setting Write Enable Latch bit
-    MX25_WREN();
-
-    // Chip select go low to start a flash command
-    CS_Low();
-
-    //Write Sector Erase command = 0x20;
-    SendByte( FLASH_CMD_SE, SIO );
-    SendFlashAddr( flash_address, SIO, addr_4byte_mode );
-
-    // Chip select go high to end a flash command
-    CS_High();
+    status = MX25_SE_Start( flash_address );
+    if( status != FlashOperationSuccess )
+        return status;
 
     if( WaitFlashReady( SectorEraseCycleTime ) )
         return FlashOperationSuccess;
@@ -1323,6 +1647,19 @@ ReturnMsg MX25_SE( uint32_t flash_address )
         return FlashTimeOut;
 }
 
+/*
+ * Function:       MX25_SE_Start
+ * Arguments:      flash_address, 32 bit flash memory address
+ * Description:    Issue the SE instruction and return without waiting.
+ *                 The caller polls the WIP bit, and may suspend the erase
+ *                 with MX25_PGM_ERS_S to read or program other sectors.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_SE_Start( uint32_t flash_address )
+{
+    return EraseStart( FLASH_CMD_SE, flash_address );
+}
+
 /*
  * Function:       MX25_BE32K
  * Arguments:      flash_address, 32 bit flash memory address
@@ -1333,32 +1670,11 @@ ReturnMsg MX25_SE( uint32_t flash_address )
  */
 ReturnMsg MX25_BE32K( uint32_t flash_address )
 {
-    uint8_t  addr_4byte_mode;
+    ReturnMsg status;
 
-    // Check flash address
-    if( flash_address > FlashSize ) return FlashAddressInvalid;
-
-    // Check flash is busy or not
-    if( IsFlashBusy() )    return FlashIsBusy;
-
-    // Check 3-byte or 4-byte mode
-    if( IsFlash4Byte() )
-        addr_4byte_mode = TRUE;  // 4-byte mode
-    else
-        addr_4byte_mode = FALSE; // 3-byte mode
-
-    // Setting Write Enable Latch bit
-    MX25_WREN();
-
-    // Chip select go low to start a flash command
-    CS_Low();
-
-    //Write Block Erase32KB command;
-    SendByte( FLASH_CMD_BE32K, SIO );
-    SendFlashAddr( flash_address, SIO, addr_4byte_mode );
-
-    // Chip select go high to end a flash command
-    CS_High();
+    status = MX25_BE32K_Start( flash_address );
+    if( status != FlashOperationSuccess )
+        return status;
 
     if( WaitFlashReady( BlockErase32KCycleTime ) )
         return FlashOperationSuccess;
@@ -1366,6 +1682,19 @@ ReturnMsg MX25_BE32K( uint32_t flash_address )
         return FlashTimeOut;
 }
 
+/*
+ * Function:       MX25_BE32K_Start
+ * Arguments:      flash_address, 32 bit flash memory address
+ * Description:    Issue the BE32K instruction and return without waiting.
+ *                 The caller polls the WIP bit, and may suspend the erase
+ *                 with MX25_PGM_ERS_S to read or program other sectors.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+ReturnMsg MX25_BE32K_Start( uint32_t flash_address )
+{
+    return EraseStart( FLASH_CMD_BE32K, flash_address );
+}
+
 /*
  * Function:       MX25_BE
  * Arguments:      flash_address, 32 bit flash memory address
@@ -1659,4 +1988,254 @@ ReturnMsg MX25_NOP( void )
     return FlashOperationSuccess;
 }
 
+/*
+ * Function:       EraseStart
+ * Arguments:      erase_cmd, FLASH_CMD_SE or FLASH_CMD_BE32K
+ *                 flash_address, 32 bit flash memory address
+ * Description:    Send an erase instruction without waiting for WIP.
+ * Return Message: FlashAddressInvalid, FlashIsBusy, FlashOperationSuccess
+ */
+static ReturnMsg EraseStart( uint8_t erase_cmd, uint32_t flash_address )
+{
+    uint8_t  addr_4byte_mode;
+
+    // Check flash address
+    if( flash_address > FlashSize ) return FlashAddressInvalid;
+
+    // Check flash is busy or not
+    if( asyncState != AsyncIdle ) return FlashIsBusy;
+    if( IsFlashBusy() )    return FlashIsBusy;
+
+    // Check 3-byte or 4-byte mode
+    if( IsFlash4Byte() )
+        addr_4byte_mode = TRUE;  // 4-byte mode
+    else
+        addr_4byte_mode = FALSE; // 3-byte mode
+
+    // Setting Write Enable Latch bit
+    MX25_WREN();
+
+    // Chip select go low to start a flash command
+    CS_Low();
+
+    // Write erase command and address
+    SendByte( erase_cmd, SIO );
+    SendFlashAddr( flash_address, SIO, addr_4byte_mode );
+
+    // Chip select go high to end a flash command
+    CS_High();
+
+    return FlashOperationSuccess;
+}
+
+/*
+ --Asynchronous transfer engine
+ */
+
+static bool SpiBulkDone( unsigned int channel, unsigned int sequenceNo, void *userParam );
+
+/*
+ * Function:       SpiBulkStart
+ * Arguments:      None.
+ * Description:    Clock the next chunk of the data phase. With MX25_DMA the
+ *                 RX channel receives into asyncRx ( or a dummy byte ) while
+ *                 the TX channel feeds asyncTx ( or 0xff ), otherwise the
+ *                 chunk is clocked out polled before returning.
+ * Return Message: None.
+ */
+static void SpiBulkStart( void )
+{
+    uint32_t index;
+    uint8_t  data;
+
+#if MX25_DMA
+    static const uint8_t txDummy = 0xff;
+    static uint8_t       rxDummy;
+
+    if( dmaReady && ( asyncRemaining > 0 ) )
+    {
+        asyncChunk = asyncRemaining;
+        if( asyncChunk > DMADRV_MAX_XFER_COUNT )
+            asyncChunk = DMADRV_MAX_XFER_COUNT;
+
+        // Drop anything left over from the command phase
+        MX25_USART->CMD = USART_CMD_CLEARRX;
+
+        DMADRV_PeripheralMemory( dmaRxChannel,
+                                 MX25_DMA_RX_SIGNAL,
+                                 asyncRx ? asyncRx : &rxDummy,
+                                 (void *)&MX25_USART->RXDATA,
+                                 asyncRx != NULL,
+                                 (int)asyncChunk,
+                                 dmadrvDataSize1,
+                                 SpiBulkDone,
+                                 NULL );
+        DMADRV_MemoryPeripheral( dmaTxChannel,
+                                 MX25_DMA_TX_SIGNAL,
+                                 (void *)&MX25_USART->TXDATA,
+                                 (void *)( asyncTx ? asyncTx : &txDummy ),
+                                 asyncTx != NULL,
+                                 (int)asyncChunk,
+                                 dmadrvDataSize1,
+                                 NULL,
+                                 NULL );
+        return;
+    }
+#endif
+
+    asyncChunk = asyncRemaining;
+    for( index=0; index < asyncChunk; index++ )
+    {
+        data = MX25_SPI_TRANSFER( asyncTx ? asyncTx[index] : 0xff );
+        if( asyncRx )
+            asyncRx[index] = data;
+    }
+    SpiBulkDone( 0, 0, NULL );
+}
+
+/*
+ * Function:       SpiBulkDone
+ * Arguments:      LDMA completion callback arguments, unused.
+ * Description:    Called when the last byte of a chunk has been received.
+ *                 Starts the next chunk or ends the command. Interrupt
+ *                 context when MX25_DMA is enabled.
+ * Return Message: TRUE
+ */
+static bool SpiBulkDone( unsigned int channel, unsigned int sequenceNo, void *userParam )
+{
+    (void)channel;
+    (void)sequenceNo;
+    (void)userParam;
+
+    asyncRemaining -= asyncChunk;
+    if( asyncRx )
+        asyncRx += asyncChunk;
+    if( asyncTx )
+        asyncTx += asyncChunk;
+
+    if( asyncRemaining > 0 )
+    {
+        SpiBulkStart();
+        return TRUE;
+    }
+
+    // Chip select go high to end a flash command
+    CS_High();
+
+#if MX25_DMA
+    SLEEP_SleepBlockEnd( sleepEM2 );
+#endif
+    asyncProgramStart = MX25_SLEEPSTAMP();
+    asyncState = asyncProgramming ? AsyncProgram : AsyncTransferDone;
+
+    return TRUE;
+}
+
+/*
+ * Function:       AsyncBulkStart
+ * Arguments:      rx, buffer for received data, NULL to discard it
+ *                 tx, data to send, NULL to send 0xff
+ *                 byte_length, length of the data phase in byte unit
+ *                 program, TRUE if the data phase loads the page buffer
+ *                 callback, user, completion callback
+ * Description:    Run the data phase of a command whose instruction and
+ *                 address have already been sent with CS low.
+ * Return Message: FlashOperationSuccess
+ */
+static ReturnMsg AsyncBulkStart( uint8_t *rx, const uint8_t *tx, uint32_t byte_length, bool program, MX25_Callback_t callback, void *user )
+{
+    asyncRx          = rx;
+    asyncTx          = tx;
+    asyncRemaining   = byte_length;
+    asyncChunk       = 0;
+    asyncProgramming = program;
+    asyncCallback    = callback;
+    asyncUser        = user;
+    asyncState       = AsyncTransfer;
+
+#if MX25_DMA
+    // The USART stops in EM2, stay out of it until CS goes high
+    SLEEP_SleepBlockBegin( sleepEM2 );
+#endif
+    SpiBulkStart();
+
+    return FlashOperationSuccess;
+}
+
+/*
+ * Function:       AsyncFinish
+ * Arguments:      status, result handed to the callback
+ * Description:    Return to idle and report completion.
+ * Return Message: None.
+ */
+static void AsyncFinish( ReturnMsg status )
+{
+    MX25_Callback_t callback = asyncCallback;
+
+    asyncCallback = NULL;
+    asyncState = AsyncIdle;
+
+    // The callback may start the next transfer
+    if( callback )
+        callback( status, asyncUser );
+}
+
+/*
+ * Function:       AsyncWait
+ * Arguments:      None.
+ * Description:    Block until the running transfer completes, used by the
+ *                 synchronous commands. Page programs keep the PP timeout.
+ * Return Message: FlashOperationSuccess, FlashTimeOut
+ */
+static ReturnMsg AsyncWait( void )
+{
+    ReturnMsg status = FlashOperationSuccess;
+
+    while( asyncState == AsyncTransfer )
+    {
+    }
+
+    if( asyncState == AsyncProgram )
+    {
+        if( !WaitFlashReady( PageProgramCycleTime ) )
+            status = FlashTimeOut;
+    }
+
+    AsyncFinish( status );
+
+    return status;
+}
+
+/*
+ * Function:       MX25_AsyncPoll
+ * Arguments:      None.
+ * Description:    Advance the running asynchronous transfer and call its
+ *                 callback when it has completed. Call from the main loop.
+ *                 A page program still busy after tPP ends with FlashTimeOut.
+ * Return Message: TRUE while a transfer is in progress, FALSE when idle.
+ */
+bool MX25_AsyncPoll( void )
+{
+    switch( asyncState )
+    {
+    case AsyncTransfer:
+        return TRUE;
+    case AsyncProgram:
+        if( !IsFlashBusy() )
+            AsyncFinish( FlashOperationSuccess );
+        else if( MX25_SLEEPSTAMP() - asyncProgramStart > PageProgramStamps )
+            AsyncFinish( FlashTimeOut );
+        else
+            return TRUE;
+        break;
+    case AsyncTransferDone:
+        AsyncFinish( FlashOperationSuccess );
+        break;
+    default:
+        break;
+    }
+
+    return asyncState != AsyncIdle;
+}
+
 #endif //MX25_USART
@@ -25,7 +25,9 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#ifdef HAL_CONFIG
+#if defined(MX25_HOST_MODEL)
+/* Host build against tools/mx25_model.c, there is no pin configuration */
+#elif defined(HAL_CONFIG)
 #include "mx25flashhalconfig.h"
 #else
 #include "mx25flash_config.h"
@@ -264,13 +266,21 @@ ReturnMsg MX25_DREAD( uint32_t flash_address, uint8_t *target_address, uint32_t
 ReturnMsg MX25_QREAD( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length );
 ReturnMsg MX25_RDSFDP( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length );
 
+/* Read with the fastest instruction found in the SFDP tables */
+ReturnMsg MX25_ReadFastConfigure( void );
+ReturnMsg MX25_ReadFast( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length );
+uint8_t MX25_ReadFastMode( void );
+uint32_t MX25_ReadFastRate( void );
+
 ReturnMsg MX25_WREN( void );
 ReturnMsg MX25_WRDI( void );
 ReturnMsg MX25_PP( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length );
 ReturnMsg MX25_4PP( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length );
 
 ReturnMsg MX25_SE( uint32_t flash_address );
+ReturnMsg MX25_SE_Start( uint32_t flash_address );
 ReturnMsg MX25_BE32K( uint32_t flash_address );
+ReturnMsg MX25_BE32K_Start( uint32_t flash_address );
 ReturnMsg MX25_BE( uint32_t flash_address );
 ReturnMsg MX25_CE( void );
 
@@ -286,7 +296,17 @@ ReturnMsg MX25_PGM_ERS_S( void );
 ReturnMsg MX25_PGM_ERS_R( void );
 ReturnMsg MX25_NOP( void );
 
-
+/* Asynchronous bulk transfers
+   Command and address are sent polled, the data phase is moved by the LDMA
+   when MX25_DMA is enabled. The callback is only ever called from
+   MX25_AsyncPoll(), never from interrupt context, and may be NULL.
+   No other MX25_ command may be issued while MX25_AsyncPoll() returns TRUE. */
+typedef void (*MX25_Callback_t)( ReturnMsg status, void *user );
+
+ReturnMsg MX25_READ_Async( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_Callback_t callback, void *user );
+ReturnMsg MX25_FASTREAD_Async( uint32_t flash_address, uint8_t *target_address, uint32_t byte_length, MX25_Callback_t callback, void *user );
+ReturnMsg MX25_PP_Async( uint32_t flash_address, uint8_t *source_address, uint32_t byte_length, MX25_Callback_t callback, void *user );
+bool MX25_AsyncPoll( void );
 
 
 #endif    /* end of __MX25_DEF_H__  */
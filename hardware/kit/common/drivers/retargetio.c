@@ -27,6 +27,7 @@
 
 extern int RETARGET_ReadChar(void);
 extern int RETARGET_WriteChar(char c);
+extern int RETARGET_Write(const char *data, int len);
 
 #if !defined(__CROSSWORKS_ARM) && defined(__GNUC__)
 
@@ -239,15 +240,11 @@ caddr_t _sbrk(int incr)
  *****************************************************************************/
 int _write(int file, const char *ptr, int len)
 {
-  int txCount;
-
   (void) file;
 
-  for (txCount = 0; txCount < len; txCount++) {
-    RETARGET_WriteChar(*ptr++);
-  }
-
-  return len;
+  /* Hand the whole block over at once so a buffered backend can queue it
+   * without taking the per character path. */
+  return RETARGET_Write(ptr, len);
 }
 #endif /* !defined( __CROSSWORKS_ARM ) && defined( __GNUC__ ) */
 
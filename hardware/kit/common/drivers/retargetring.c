@@ -0,0 +1,135 @@
+/***************************************************************************//**
+ * @file
+ * @brief Byte ring buffer used by the serial retarget TX path.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+#include "retargetring.h"
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetIo
+ * @{
+ ******************************************************************************/
+
+/**************************************************************************//**
+ * @brief Initialize an empty ring
+ * @param ring Ring to initialize
+ * @param buf Backing storage
+ * @param size Size of buf in bytes, must be a power of two
+ *****************************************************************************/
+void RETARGET_RingInit(RETARGET_Ring_t *ring, uint8_t *buf, uint32_t size)
+{
+  ring->buf       = buf;
+  ring->size      = size;
+  ring->put       = 0;
+  ring->get       = 0;
+  ring->highWater = 0;
+}
+
+/**************************************************************************//**
+ * @brief Number of bytes waiting to be drained
+ *****************************************************************************/
+uint32_t RETARGET_RingUsed(const RETARGET_Ring_t *ring)
+{
+  return ring->put - ring->get;
+}
+
+/**************************************************************************//**
+ * @brief Number of bytes that can be enqueued without overflow
+ *****************************************************************************/
+uint32_t RETARGET_RingFree(const RETARGET_Ring_t *ring)
+{
+  return ring->size - (ring->put - ring->get);
+}
+
+/**************************************************************************//**
+ * @brief Enqueue characters, optionally expanding LF to CRLF
+ * @param ring Ring to write to
+ * @param data Characters to enqueue
+ * @param len Number of characters in data
+ * @param lfToCrLf If true, every '\n' is stored as "\r\n"
+ * @return Number of characters from data that were consumed. A '\n' is only
+ *         consumed if both bytes of its expansion fit, so a line ending is
+ *         never split across an overflow.
+ *****************************************************************************/
+int RETARGET_RingWrite(RETARGET_Ring_t *ring,
+                       const char *data,
+                       int len,
+                       bool lfToCrLf)
+{
+  uint32_t put  = ring->put;
+  uint32_t free = ring->size - (put - ring->get);
+  uint32_t mask = ring->size - 1;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (lfToCrLf && (data[i] == '\n')) {
+      if (free < 2) {
+        break;
+      }
+      ring->buf[put++ & mask] = '\r';
+      free--;
+    } else if (free < 1) {
+      break;
+    }
+    ring->buf[put++ & mask] = (uint8_t)data[i];
+    free--;
+  }
+
+  /* Publish the new bytes only after they have been stored. */
+  ring->put = put;
+
+  if ((ring->size - free) > ring->highWater) {
+    ring->highWater = ring->size - free;
+  }
+
+  return i;
+}
+
+/**************************************************************************//**
+ * @brief Get the longest contiguous run of queued bytes
+ * @param ring Ring to read from
+ * @param data Set to the first queued byte
+ * @return Number of bytes at data that can be handed to the DMA in one go
+ *****************************************************************************/
+uint32_t RETARGET_RingPeek(const RETARGET_Ring_t *ring, uint8_t **data)
+{
+  uint32_t get   = ring->get;
+  uint32_t used  = ring->put - get;
+  uint32_t index = get & (ring->size - 1);
+  uint32_t toEnd = ring->size - index;
+
+  *data = &ring->buf[index];
+
+  return (used < toEnd) ? used : toEnd;
+}
+
+/**************************************************************************//**
+ * @brief Release bytes previously returned by RETARGET_RingPeek()
+ * @param ring Ring to release from
+ * @param len Number of bytes that have been drained
+ *****************************************************************************/
+void RETARGET_RingConsume(RETARGET_Ring_t *ring, uint32_t len)
+{
+  ring->get += len;
+}
+
+/** @} (end group RetargetIo) */
+/** @} (end group kitdrv) */
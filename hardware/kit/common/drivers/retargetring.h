@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file
+ * @brief Byte ring buffer used by the serial retarget TX path.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef __RETARGETRING_H
+#define __RETARGETRING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***************************************************************************//**
+ * @addtogroup kitdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RetargetIo
+ * @{
+ ******************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Single producer / single consumer byte ring.
+ *
+ * The producer (thread context) only advances @ref put and the consumer
+ * (DMA completion interrupt) only advances @ref get. Both are free running,
+ * so the fill level is always put - get and no lock is needed as long as
+ * each side only reads the other side's counter. The ring does not know
+ * anything about the hardware, so it can be compiled and exercised on a host.
+ */
+typedef struct {
+  uint8_t           *buf;       /**< Storage, size bytes */
+  uint32_t          size;       /**< Storage size, must be a power of two */
+  volatile uint32_t put;        /**< Free running write counter */
+  volatile uint32_t get;        /**< Free running read counter */
+  uint32_t          highWater;  /**< Highest fill level seen */
+} RETARGET_Ring_t;
+
+void     RETARGET_RingInit(RETARGET_Ring_t *ring, uint8_t *buf, uint32_t size);
+uint32_t RETARGET_RingUsed(const RETARGET_Ring_t *ring);
+uint32_t RETARGET_RingFree(const RETARGET_Ring_t *ring);
+int      RETARGET_RingWrite(RETARGET_Ring_t *ring,
+                            const char *data,
+                            int len,
+                            bool lfToCrLf);
+uint32_t RETARGET_RingPeek(const RETARGET_Ring_t *ring, uint8_t **data);
+void     RETARGET_RingConsume(RETARGET_Ring_t *ring, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} (end group RetargetIo) */
+/** @} (end group kitdrv) */
+
+#endif
@@ -46,10 +46,97 @@
 #include "em_leuart.h"
 #endif
 
+/* LDMA drained TX ring. Only USART0/1 have LDMA request signals declared in
+ * the DMADRV subset, other ports keep the polled TX path. */
+#if defined(RETARGET_USART) && (BSP_SERIAL_APP_PORT == HAL_SERIAL_PORT_USART0)
+#define RETARGET_TX_DMA_SIGNAL  dmadrvPeripheralSignal_USART0_TXBL
+#elif defined(RETARGET_USART) && (BSP_SERIAL_APP_PORT == HAL_SERIAL_PORT_USART1)
+#define RETARGET_TX_DMA_SIGNAL  dmadrvPeripheralSignal_USART1_TXBL
+#endif
+
+/* LDMA filled RX ring with idle line detection through TIMECMP1 */
+#if defined(RETARGET_USART) && (BSP_SERIAL_APP_PORT == HAL_SERIAL_PORT_USART0)
+#define RETARGET_RX_DMA_SIGNAL  dmadrvPeripheralSignal_USART0_RXDATAV
+#elif defined(RETARGET_USART) && (BSP_SERIAL_APP_PORT == HAL_SERIAL_PORT_USART1)
+#define RETARGET_RX_DMA_SIGNAL  dmadrvPeripheralSignal_USART1_RXDATAV
+#endif
+
+#ifndef RETARGET_RX_DMA
+#if defined(RETARGET_RX_DMA_SIGNAL)
+#define RETARGET_RX_DMA         1               /**< Fill RX through the LDMA */
+#else
+#define RETARGET_RX_DMA         0
+#endif
+#endif
+
+#ifndef RETARGET_RX_IDLE_BITS
+#define RETARGET_RX_IDLE_BITS   20              /**< Silent bit times before the line counts as idle */
+#endif
+
+#ifndef RETARGET_TX_DMA
+#if defined(RETARGET_TX_DMA_SIGNAL)
+#define RETARGET_TX_DMA         1               /**< Drain TX through the LDMA */
+#else
+#define RETARGET_TX_DMA         0
+#endif
+#endif
+
+#if RETARGET_TX_DMA || RETARGET_RX_DMA
+#include "dmadrv.h"
+#endif
+
+#if RETARGET_RX_DMA && !defined(RETARGET_RX_DMA_SIGNAL)
+#error "RETARGET_RX_DMA requires a USART with a DMADRV RX signal"
+#endif
+
+#if RETARGET_TX_DMA
+#include "sleep.h"
+#include "retargetring.h"
+
+#if !defined(RETARGET_TX_DMA_SIGNAL)
+#error "RETARGET_TX_DMA requires a USART with a DMADRV TX signal"
+#endif
+
+/* Transmit buffer */
+#ifndef TXBUFSIZE
+#define TXBUFSIZE    1024                       /**< Buffer size for TX, power of two */
+#endif
+#if (TXBUFSIZE & (TXBUFSIZE - 1)) != 0
+#error "TXBUFSIZE must be a power of two"
+#endif
+#ifndef RETARGET_TX_OVERFLOW_POLICY
+#define RETARGET_TX_OVERFLOW_POLICY  RETARGET_TX_OVERFLOW_COUNT
+#endif
+
+static RETARGET_Ring_t   txRing;                /**< Characters waiting for the DMA */
+static uint8_t           txBuffer[TXBUFSIZE];   /**< Storage for txRing */
+static unsigned int      txDmaChannel;          /**< LDMA channel draining txRing */
+static bool              txDmaReady  = false;   /**< A channel has been allocated */
+static volatile uint32_t txDmaLen    = 0;       /**< Bytes owned by the running transfer, 0 when idle */
+#endif
+static volatile uint32_t txDropped   = 0;       /**< Characters lost to TX overflow */
+
 /* Receive buffer */
 #ifndef RXBUFSIZE
+#if RETARGET_RX_DMA
+#define RXBUFSIZE    256                        /**< Buffer size for RX, two DMA halves */
+#else
 #define RXBUFSIZE    8                          /**< Buffer size for RX */
 #endif
+#endif
+#if RETARGET_RX_DMA
+#if (RXBUFSIZE & (RXBUFSIZE - 1)) != 0
+#error "RXBUFSIZE must be a power of two"
+#endif
+#define RXHALFSIZE   (RXBUFSIZE / 2)
+
+static unsigned int      rxDmaChannel;          /**< LDMA channel filling rxBuffer */
+static bool              rxDmaReady  = false;   /**< rxBuffer is filled by the LDMA */
+static volatile uint32_t rxDmaHalves = 0;       /**< Number of halves the LDMA has filled */
+static volatile uint32_t rxGet       = 0;       /**< Free running read counter */
+#endif
+static volatile uint32_t rxOverruns  = 0;       /**< Characters overwritten before they were read */
+static RETARGET_RxIdleCallback_t rxIdleCallback = NULL; /**< Called when the RX line goes idle */
 static volatile int     rxReadIndex  = 0;       /**< Index in buffer to be read */
 static volatile int     rxWriteIndex = 0;       /**< Index in buffer to be written to */
 static volatile int     rxCount      = 0;       /**< Keeps track of how much data which are stored in the buffer */
@@ -57,6 +144,148 @@ static volatile uint8_t rxBuffer[RXBUFSIZE];    /**< Buffer to store data */
 static uint8_t          LFtoCRLF    = 0;        /**< LF to CRLF conversion disabled */
 static bool             initialized = false;    /**< Initialize UART/LEUART */
 
+#if RETARGET_TX_DMA
+static bool txDmaDone(unsigned int channel, unsigned int sequenceNo, void *userParam);
+
+/**************************************************************************//**
+ * @brief Start draining the next contiguous run of the TX ring
+ * @note Must be called with interrupts masked or from the LDMA IRQ.
+ *****************************************************************************/
+static void txDmaStart(void)
+{
+  uint8_t  *data;
+  uint32_t len;
+
+  if (txDmaLen != 0) {
+    return;
+  }
+
+  len = RETARGET_RingPeek(&txRing, &data);
+  if (len == 0) {
+    return;
+  }
+  if (len > DMADRV_MAX_XFER_COUNT) {
+    len = DMADRV_MAX_XFER_COUNT;
+  }
+
+  /* The USART stops in EM2, keep the core out of it until the ring is empty */
+  SLEEP_SleepBlockBegin(sleepEM2);
+  txDmaLen = len;
+  DMADRV_MemoryPeripheral(txDmaChannel,
+                          RETARGET_TX_DMA_SIGNAL,
+                          (void *)&RETARGET_UART->TXDATA,
+                          data,
+                          true,
+                          (int)len,
+                          dmadrvDataSize1,
+                          txDmaDone,
+                          NULL);
+}
+
+/**************************************************************************//**
+ * @brief LDMA completion callback, releases the drained bytes
+ *****************************************************************************/
+static bool txDmaDone(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  (void)channel;
+  (void)sequenceNo;
+  (void)userParam;
+
+  RETARGET_RingConsume(&txRing, txDmaLen);
+  txDmaLen = 0;
+  SLEEP_SleepBlockEnd(sleepEM2);
+  txDmaStart();
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Put characters in the TX ring and make sure the LDMA is running
+ * @param data Characters to transmit
+ * @param len Number of characters
+ *****************************************************************************/
+static void txEnqueue(const char *data, int len)
+{
+  int written = 0;
+  CORE_DECLARE_IRQ_STATE;
+
+  while (written < len) {
+    written += RETARGET_RingWrite(&txRing, data + written, len - written, LFtoCRLF != 0);
+
+    CORE_ENTER_ATOMIC();
+    txDmaStart();
+    CORE_EXIT_ATOMIC();
+
+#if (RETARGET_TX_OVERFLOW_POLICY != RETARGET_TX_OVERFLOW_BLOCK)
+    if (written < len) {
+#if (RETARGET_TX_OVERFLOW_POLICY == RETARGET_TX_OVERFLOW_COUNT)
+      txDropped += (uint32_t)(len - written);
+#endif
+      break;
+    }
+#endif
+  }
+}
+#endif
+
+#if RETARGET_RX_DMA
+/**************************************************************************//**
+ * @brief LDMA callback, one half of rxBuffer has been filled
+ * @details The LDMA moves on to the other half on its own. If the reader is
+ *          more than one half behind, the bytes the LDMA is about to
+ *          overwrite are counted as overruns and skipped.
+ *****************************************************************************/
+static bool rxDmaHalfDone(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  uint32_t oldest;
+
+  (void)channel;
+  (void)sequenceNo;
+  (void)userParam;
+
+  rxDmaHalves++;
+  oldest = ((rxDmaHalves + 1) * RXHALFSIZE) - RXBUFSIZE;
+  if ((int32_t)(oldest - rxGet) > 0) {
+    rxOverruns += oldest - rxGet;
+    rxGet = oldest;
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Free running count of bytes the LDMA has written to rxBuffer
+ * @details When a half completes the LDMA reloads the transfer count for the
+ *          next half at once, but rxDmaHalves only moves in rxDmaHalfDone(),
+ *          which cannot run while interrupts are masked. A half whose done
+ *          flag is still pending is counted here, and the flag is read on
+ *          both sides of the transfer count so the two agree.
+ * @note Must be called with interrupts masked.
+ *****************************************************************************/
+static uint32_t rxDmaPut(void)
+{
+  uint32_t mask = 1UL << rxDmaChannel;
+  uint32_t done;
+  uint32_t put;
+  int remaining;
+
+  do {
+    done = LDMA->IF & mask;
+    remaining = RXHALFSIZE;
+    DMADRV_TransferRemainingCount(rxDmaChannel, &remaining);
+  } while ((LDMA->IF & mask) != done);
+
+  put = ((rxDmaHalves + (done ? 1 : 0)) * RXHALFSIZE) + (uint32_t)(RXHALFSIZE - remaining);
+
+  /* Never behind the reader, a count below it would read as a full ring */
+  if ((int32_t)(put - rxGet) < 0) {
+    put = rxGet;
+  }
+
+  return put;
+}
+#endif
+
 /**************************************************************************//**
  * @brief Disable RX interrupt
  *****************************************************************************/
@@ -86,6 +315,19 @@ static void enableRxInterrupt()
  *****************************************************************************/
 void RETARGET_IRQ_NAME(void)
 {
+#if RETARGET_RX_DMA
+  /* The LDMA empties RXDATA, only the idle line timer interrupts */
+  if (rxDmaReady) {
+    if (RETARGET_UART->IF & USART_IF_TCMP1) {
+      USART_IntClear(RETARGET_UART, USART_IF_TCMP1);
+      if (rxIdleCallback != NULL) {
+        rxIdleCallback();
+      }
+    }
+    return;
+  }
+#endif
+
 #if defined(RETARGET_USART)
   if (RETARGET_UART->STATUS & USART_STATUS_RXDATAV) {
 #else
@@ -100,6 +342,10 @@ void RETARGET_IRQ_NAME(void)
       if (rxWriteIndex == RXBUFSIZE) {
         rxWriteIndex = 0;
       }
+      /* No idle detection without the LDMA, report every character */
+      if (rxIdleCallback != NULL) {
+        rxIdleCallback();
+      }
     } else {
       /* The RX buffer is full so we must wait for the RETARGET_ReadChar()
        * function to make some more room in the buffer. RX interrupts are
@@ -176,17 +422,58 @@ void RETARGET_SerialInit(void)
   #endif
 #endif
 
+#if RETARGET_TX_DMA || RETARGET_RX_DMA
+  /* DMADRV may already be up if another driver got there first */
+  DMADRV_Init();
+#endif
+
+#if RETARGET_RX_DMA
+  /* The LDMA cycles through both halves of rxBuffer for as long as the
+   * USART is enabled. TIMECMP1 starts counting at the end of each received
+   * frame, is stopped by the next start bit, and fires when the line has
+   * been silent for RETARGET_RX_IDLE_BITS bit times. */
+  if ((DMADRV_AllocateChannel(&rxDmaChannel, NULL) == ECODE_EMDRV_DMADRV_OK)
+      && (DMADRV_PeripheralMemoryPingPong(rxDmaChannel,
+                                          RETARGET_RX_DMA_SIGNAL,
+                                          (void *)&rxBuffer[0],
+                                          (void *)&rxBuffer[RXHALFSIZE],
+                                          (void *)&RETARGET_UART->RXDATA,
+                                          true,
+                                          RXHALFSIZE,
+                                          dmadrvDataSize1,
+                                          rxDmaHalfDone,
+                                          NULL) == ECODE_EMDRV_DMADRV_OK)) {
+    rxDmaReady = true;
+    usart->TIMECMP1 = ((uint32_t)RETARGET_RX_IDLE_BITS << _USART_TIMECMP1_TCMPVAL_SHIFT)
+                      | USART_TIMECMP1_TSTART_RXEOF
+                      | USART_TIMECMP1_TSTOP_RXACT;
+  }
+#endif
+
   /* Clear previous RX interrupts */
   USART_IntClear(RETARGET_UART, USART_IF_RXDATAV);
   NVIC_ClearPendingIRQ(RETARGET_IRQn);
 
   /* Enable RX interrupts */
-  USART_IntEnable(RETARGET_UART, USART_IF_RXDATAV);
+#if RETARGET_RX_DMA
+  if (rxDmaReady) {
+    USART_IntClear(RETARGET_UART, USART_IF_TCMP1);
+    USART_IntEnable(RETARGET_UART, USART_IF_TCMP1);
+  } else
+#endif
+  {
+    USART_IntEnable(RETARGET_UART, USART_IF_RXDATAV);
+  }
   NVIC_EnableIRQ(RETARGET_IRQn);
 
   /* Finally enable it */
   USART_Enable(usart, usartEnable);
 
+#if RETARGET_TX_DMA
+  RETARGET_RingInit(&txRing, txBuffer, TXBUFSIZE);
+  txDmaReady = (DMADRV_AllocateChannel(&txDmaChannel, NULL) == ECODE_EMDRV_DMADRV_OK);
+#endif
+
 #else
   LEUART_TypeDef      *leuart = RETARGET_UART;
   LEUART_Init_TypeDef init    = LEUART_INIT_DEFAULT;
@@ -264,6 +551,18 @@ int RETARGET_ReadChar(void)
     RETARGET_SerialInit();
   }
 
+#if RETARGET_RX_DMA
+  if (rxDmaReady) {
+    CORE_ENTER_ATOMIC();
+    if (rxDmaPut() != rxGet) {
+      c = rxBuffer[rxGet & (RXBUFSIZE - 1)];
+      rxGet++;
+    }
+    CORE_EXIT_ATOMIC();
+    return c;
+  }
+#endif
+
   CORE_ENTER_ATOMIC();
   if (rxCount > 0) {
     c = rxBuffer[rxReadIndex];
@@ -283,6 +582,68 @@ int RETARGET_ReadChar(void)
   return c;
 }
 
+/**************************************************************************//**
+ * @brief Receive a block of bytes from USART/LEUART
+ * @param data Where to put the bytes
+ * @param len Most bytes to read
+ * @return Number of bytes read, 0 when nothing is waiting
+ *****************************************************************************/
+uint32_t RETARGET_SerialRead(uint8_t *data, uint32_t len)
+{
+  uint32_t count = 0;
+  int c;
+
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+#if RETARGET_RX_DMA
+  if (rxDmaReady) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_ATOMIC();
+    count = rxDmaPut() - rxGet;
+    if (count > len) {
+      count = len;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      data[i] = rxBuffer[(rxGet + i) & (RXBUFSIZE - 1)];
+    }
+    rxGet += count;
+    CORE_EXIT_ATOMIC();
+    return count;
+  }
+#endif
+
+  while ((count < len) && ((c = RETARGET_ReadChar()) >= 0)) {
+    data[count++] = (uint8_t)c;
+  }
+
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Number of received bytes waiting to be read
+ *****************************************************************************/
+uint32_t RETARGET_SerialRxPending(void)
+{
+  uint32_t count;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+#if RETARGET_RX_DMA
+  if (rxDmaReady) {
+    count = rxDmaPut() - rxGet;
+  } else
+#endif
+  {
+    count = (uint32_t)rxCount;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return count;
+}
+
 /**************************************************************************//**
  * @brief Transmit single byte to USART/LEUART
  * @param c Character to transmit
@@ -294,6 +655,13 @@ int RETARGET_WriteChar(char c)
     RETARGET_SerialInit();
   }
 
+#if RETARGET_TX_DMA
+  if (txDmaReady) {
+    txEnqueue(&c, 1);
+    return c;
+  }
+#endif
+
   /* Add CR or LF to CRLF if enabled */
   if (LFtoCRLF && (c == '\n')) {
     RETARGET_TX(RETARGET_UART, '\r');
@@ -303,6 +671,141 @@ int RETARGET_WriteChar(char c)
   return c;
 }
 
+/**************************************************************************//**
+ * @brief Transmit a block of characters to USART/LEUART
+ * @details With RETARGET_TX_DMA the characters are copied to the TX ring and
+ *          the call returns without waiting for the UART. What happens when
+ *          the ring is full is selected by RETARGET_TX_OVERFLOW_POLICY.
+ * @param data Characters to transmit
+ * @param len Number of characters
+ * @return len
+ *****************************************************************************/
+int RETARGET_Write(const char *data, int len)
+{
+  int i;
+
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+#if RETARGET_TX_DMA
+  if (txDmaReady) {
+    txEnqueue(data, len);
+    return len;
+  }
+#endif
+
+  for (i = 0; i < len; i++) {
+    RETARGET_WriteChar(data[i]);
+  }
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Queue bytes for transmission without waiting and without LF to CRLF
+ * @details Unlike RETARGET_Write(), what does not fit in the TX ring is left
+ *          to the caller and not counted as dropped. Without RETARGET_TX_DMA
+ *          the bytes are sent polled and all of them are taken.
+ * @param data Bytes to transmit
+ * @param len Number of bytes
+ * @return Number of bytes queued
+ *****************************************************************************/
+uint32_t RETARGET_SerialWriteRaw(const uint8_t *data, uint32_t len)
+{
+  uint32_t i;
+
+  if (initialized == false) {
+    RETARGET_SerialInit();
+  }
+
+#if RETARGET_TX_DMA
+  if (txDmaReady) {
+    CORE_DECLARE_IRQ_STATE;
+
+    len = (uint32_t)RETARGET_RingWrite(&txRing, (const char *)data, (int)len, false);
+    CORE_ENTER_ATOMIC();
+    txDmaStart();
+    CORE_EXIT_ATOMIC();
+    return len;
+  }
+#endif
+
+  for (i = 0; i < len; i++) {
+    RETARGET_TX(RETARGET_UART, data[i]);
+  }
+
+  return len;
+}
+
+/**************************************************************************//**
+ * @brief Room left in the TX ring
+ * @return Free bytes, UINT32_MAX when TX is polled and writes wait instead
+ *****************************************************************************/
+uint32_t RETARGET_SerialTxFree(void)
+{
+#if RETARGET_TX_DMA
+  if (txDmaReady) {
+    return RETARGET_RingFree(&txRing);
+  }
+#endif
+  return UINT32_MAX;
+}
+
+/**************************************************************************//**
+ * @brief Bytes in the TX ring the UART has not yet taken, 0 when TX is polled
+ *****************************************************************************/
+uint32_t RETARGET_SerialTxPending(void)
+{
+#if RETARGET_TX_DMA
+  if (txDmaReady) {
+    return RETARGET_RingUsed(&txRing);
+  }
+#endif
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief Number of characters discarded because the TX ring was full
+ *****************************************************************************/
+uint32_t RETARGET_SerialTxDropped(void)
+{
+  return txDropped;
+}
+
+/**************************************************************************//**
+ * @brief Highest TX ring fill level seen, 0 when TX is polled
+ *****************************************************************************/
+uint32_t RETARGET_SerialTxHighWater(void)
+{
+#if RETARGET_TX_DMA
+  return txRing.highWater;
+#else
+  return 0;
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Register a function to call when the RX line goes idle
+ * @details With RETARGET_RX_DMA the callback runs once per burst, after the
+ *          line has been silent for RETARGET_RX_IDLE_BITS bit times. Without
+ *          it the callback runs after every received character. It is called
+ *          from interrupt context and should only signal the main loop.
+ * @param callback Function to call, NULL to disable
+ *****************************************************************************/
+void RETARGET_SerialRxIdleCallbackSet(RETARGET_RxIdleCallback_t callback)
+{
+  rxIdleCallback = callback;
+}
+
+/**************************************************************************//**
+ * @brief Number of received characters overwritten before they were read
+ *****************************************************************************/
+uint32_t RETARGET_SerialRxOverruns(void)
+{
+  return rxOverruns;
+}
+
 /**************************************************************************//**
  * @brief Enable hardware flow control. (RTS + CTS)
  * @return true if hardware flow control was enabled and false otherwise.
@@ -346,10 +849,36 @@ void RETARGET_SerialFlush(void)
 #define _GENERIC_UART_STATUS_IDLE     LEUART_STATUS_TXC
 #endif
 
+#endif
+
+#if RETARGET_TX_DMA
+  /* Let the LDMA empty the ring before waiting for the shift register */
+  if (txDmaReady) {
+    while ((RETARGET_RingUsed(&txRing) != 0) || (txDmaLen != 0)) ;
+  }
 #endif
 
   while (!(RETARGET_UART->STATUS & _GENERIC_UART_STATUS_IDLE)) ;
 }
 
+/**************************************************************************//**
+ * @brief Set the baud rate again after the clock feeding the UART changed.
+ *   Call RETARGET_SerialFlush() before the clock change, a frame in flight
+ *   across it is garbled.
+ *****************************************************************************/
+void RETARGET_SerialClockChanged(void)
+{
+  if (initialized == false) {
+    return;
+  }
+#if defined(RETARGET_USART)
+  USART_InitAsync_TypeDef init = USART_INITASYNC_DEFAULT;
+
+  USART_BaudrateAsyncSet(RETARGET_UART, init.refFreq, init.baudrate, init.oversampling);
+#elif defined(RETARGET_VCOM)
+  LEUART_BaudrateSet(RETARGET_UART, 0, 115200);
+#endif
+}
+
 /** @} (end group RetargetIo) */
 /** @} (end group kitdrv) */
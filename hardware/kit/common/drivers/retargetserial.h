@@ -24,6 +24,7 @@
 #include "retargetserialconfig.h"
 #endif
 #include <stdbool.h>
+#include <stdint.h>
 
 /***************************************************************************//**
  * @addtogroup kitdrv
@@ -39,6 +40,14 @@
  * @{
  ******************************************************************************/
 
+/** TX overflow policies, select one with RETARGET_TX_OVERFLOW_POLICY */
+#define RETARGET_TX_OVERFLOW_DROP     0 /**< Silently discard what does not fit */
+#define RETARGET_TX_OVERFLOW_COUNT    1 /**< Discard and count in RETARGET_SerialTxDropped() */
+#define RETARGET_TX_OVERFLOW_BLOCK    2 /**< Wait for the DMA to make room */
+
+/** Called from the UART interrupt when the RX line has gone idle */
+typedef void (*RETARGET_RxIdleCallback_t)(void);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -50,11 +59,22 @@ int __getchar(void);
 
 int  RETARGET_ReadChar(void);
 int  RETARGET_WriteChar(char c);
+int  RETARGET_Write(const char *data, int len);
+uint32_t RETARGET_SerialRead(uint8_t *data, uint32_t len);
+uint32_t RETARGET_SerialRxPending(void);
+uint32_t RETARGET_SerialWriteRaw(const uint8_t *data, uint32_t len);
+uint32_t RETARGET_SerialTxFree(void);
+uint32_t RETARGET_SerialTxPending(void);
 
 void RETARGET_SerialCrLf(int on);
 void RETARGET_SerialInit(void);
 bool RETARGET_SerialEnableFlowControl(void);
 void RETARGET_SerialFlush(void);
+void RETARGET_SerialClockChanged(void);
+uint32_t RETARGET_SerialTxDropped(void);
+uint32_t RETARGET_SerialTxHighWater(void);
+void RETARGET_SerialRxIdleCallbackSet(RETARGET_RxIdleCallback_t callback);
+uint32_t RETARGET_SerialRxOverruns(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,169 @@
+/***************************************************************************//**
+ * @file
+ * @brief CPU headroom of a run, from the main loop and the cycle counter
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "headroom.h"
+
+static bool running;
+static bool inStack;						// Between HEADROOM_Stack() and HEADROOM_App()
+static uint32_t last;						// Cycle count the open segment started at
+static uint32_t startTicks;
+static uint32_t passApp;					// The pass so far, spin if it turns out idle
+static uint32_t passStack;
+static HEADROOM_Report_t report;
+
+static void segment(uint32_t cycles)
+{
+	uint32_t elapsed = cycles - last;
+
+	last = cycles;
+	if(inStack)
+	{
+		passStack += elapsed;
+	}
+	else
+	{
+		passApp += elapsed;
+	}
+}
+
+static void commit(bool idle)
+{
+	if(idle)
+	{
+		report.cycles[HEADROOM_SPIN] += (uint64_t)passApp + passStack;
+		report.idlePasses++;
+	}
+	else
+	{
+		report.cycles[HEADROOM_APP] += passApp;
+		report.cycles[HEADROOM_STACK] += passStack;
+	}
+	report.passes++;
+	passApp = 0;
+	passStack = 0;
+}
+
+void HEADROOM_Start(uint32_t cycles, uint32_t ticks, uint32_t coreHz)
+{
+	memset(&report, 0, sizeof(report));
+	report.coreHz = coreHz;
+	startTicks = ticks;
+	last = cycles;
+	inStack = false;
+	passApp = 0;
+	passStack = 0;
+	running = true;
+}
+
+/**************************************************************************//**
+* @brief A stack call is about to be made
+*****************************************************************************/
+void HEADROOM_Stack(uint32_t cycles)
+{
+	if(running)
+	{
+		segment(cycles);
+		inStack = true;
+	}
+}
+
+/**************************************************************************//**
+* @brief The stack call returned
+*****************************************************************************/
+void HEADROOM_App(uint32_t cycles)
+{
+	if(running)
+	{
+		segment(cycles);
+		inStack = false;
+	}
+}
+
+/**************************************************************************//**
+* @brief End of a main loop pass, idle if it found nothing to do
+*****************************************************************************/
+void HEADROOM_Pass(uint32_t cycles, bool idle)
+{
+	if(running)
+	{
+		segment(cycles);
+		commit(idle);
+	}
+}
+
+/**************************************************************************//**
+* @brief Ends the run. The pass under way is taken as busy, and what the
+* cycles counted leave of the run length as sleep
+*****************************************************************************/
+void HEADROOM_Stop(uint32_t cycles, uint32_t ticks)
+{
+	uint64_t counted = 0;
+	uint64_t total;
+	uint64_t busy;
+
+	if(!running)
+	{
+		return;
+	}
+	running = false;
+	segment(cycles);
+	commit(false);
+	report.passes--;
+
+	report.ticks = ticks - startTicks;
+	for(uint32_t s = 0; s < HEADROOM_SLEEP; s++)
+	{
+		counted += report.cycles[s];
+	}
+	total = (uint64_t)report.ticks * report.coreHz / HEADROOM_TICKS_PER_SECOND;
+	report.cycles[HEADROOM_SLEEP] = (total > counted) ? total - counted : 0;
+	total = counted + report.cycles[HEADROOM_SLEEP];
+	if(total == 0)
+	{
+		return;
+	}
+
+	for(uint32_t s = 0; s < HEADROOM_SHARES; s++)
+	{
+		report.permille[s] = (uint16_t)((report.cycles[s] * 1000 + total / 2) / total);
+	}
+	busy = report.cycles[HEADROOM_APP] + report.cycles[HEADROOM_STACK];
+	report.headroomPermille = (uint16_t)(1000 - (busy * 1000 + total / 2) / total);
+	report.neededHz = (uint32_t)((busy * report.coreHz + total / 2) / total);
+}
+
+bool HEADROOM_Running(void)
+{
+	return running;
+}
+
+/**************************************************************************//**
+* @brief The report of the last run, zeros until one has ended
+*****************************************************************************/
+void HEADROOM_Get(HEADROOM_Report_t *reportOut)
+{
+	if(running)
+	{
+		memset(reportOut, 0, sizeof(*reportOut));
+	}
+	else
+	{
+		*reportOut = report;
+	}
+}
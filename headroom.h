@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief CPU headroom of a run, from the main loop and the cycle counter
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef HEADROOM_H_
+#define HEADROOM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Splits the time of a run four ways:
+ *
+ *   app    the main loop outside of stack calls
+ *   stack  in gecko_wait_event(), gecko_peek_event() and the send commands
+ *   spin   main loop passes that found nothing to do: no event, and the
+ *          stack took no data because its buffers were full
+ *   sleep  the core stopped in EM1 or EM2 inside gecko_wait_event()
+ *
+ * The main loop gives the DWT cycle count at each stack call, at each return
+ * and at the end of each pass. The counter stops while the core sleeps, so
+ * sleep is the run length from the RTCC less every cycle counted. Interrupts
+ * are counted in whatever was running when they came. Spin and sleep are
+ * the headroom: a sender spinning on full buffers is held back by the link,
+ * not the core. The core clock a run needs is about the clock it ran at
+ * times the share that is not headroom.
+ *
+ * The counter wraps every 2^32 cycles, 112 s at 38.4 MHz, and the loop
+ * gives a count at least every stack event, so each difference is taken
+ * from the last one. Only arithmetic here, tools/headroom_check.c builds it
+ * on a PC with a fake clock. */
+
+#define HEADROOM_TICKS_PER_SECOND	32768	// RTCC
+
+typedef enum {
+	HEADROOM_APP,
+	HEADROOM_STACK,
+	HEADROOM_SPIN,
+	HEADROOM_SLEEP,
+	HEADROOM_SHARES
+} HEADROOM_Share_t;
+
+typedef struct {
+	uint32_t coreHz;
+	uint32_t ticks;							// Run length
+	uint64_t cycles[HEADROOM_SHARES];
+	uint16_t permille[HEADROOM_SHARES];
+	uint16_t headroomPermille;				// Spin and sleep
+	uint32_t neededHz;						// coreHz less the headroom
+	uint32_t passes;						// Main loop passes, and those that found nothing to do
+	uint32_t idlePasses;
+} HEADROOM_Report_t;
+
+void HEADROOM_Start(uint32_t cycles, uint32_t ticks, uint32_t coreHz);
+void HEADROOM_Stack(uint32_t cycles);
+void HEADROOM_App(uint32_t cycles);
+void HEADROOM_Pass(uint32_t cycles, bool idle);
+void HEADROOM_Stop(uint32_t cycles, uint32_t ticks);
+bool HEADROOM_Running(void);
+void HEADROOM_Get(HEADROOM_Report_t *report);
+
+#endif
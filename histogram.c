@@ -0,0 +1,108 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log2 bucketed histogram of 32-bit samples
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "histogram.h"
+
+void HISTOGRAM_Reset(HISTOGRAM_t *histogram)
+{
+	memset(histogram, 0, sizeof(*histogram));
+	histogram->min = UINT32_MAX;
+}
+
+/**************************************************************************//**
+* @brief Bucket of a value, the index of its highest set bit. A CLZ on the
+* Cortex-M4
+*****************************************************************************/
+uint32_t HISTOGRAM_Bucket(uint32_t value)
+{
+	return (value < 2) ? 0 : 31 - (uint32_t)__builtin_clz(value);
+}
+
+uint32_t HISTOGRAM_BucketLow(uint32_t bucket)
+{
+	return (bucket == 0) ? 0 : (1u << bucket);
+}
+
+uint32_t HISTOGRAM_BucketHigh(uint32_t bucket)
+{
+	return (bucket >= HISTOGRAM_BUCKETS - 1) ? UINT32_MAX : (2u << bucket) - 1;
+}
+
+void HISTOGRAM_Add(HISTOGRAM_t *histogram, uint32_t value)
+{
+	histogram->buckets[HISTOGRAM_Bucket(value)]++;
+	histogram->count++;
+	histogram->sum += value;
+	if(value < histogram->min)
+	{
+		histogram->min = value;
+	}
+	if(value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+uint32_t HISTOGRAM_Mean(const HISTOGRAM_t *histogram)
+{
+	return histogram->count ? (uint32_t)(histogram->sum / histogram->count) : 0;
+}
+
+/**************************************************************************//**
+* @brief Upper bound of the sample of rank permille/1000, the top of the
+* bucket it falls in, clamped to the smallest and largest samples seen. So
+* it is never below the true percentile and at most twice it
+*****************************************************************************/
+uint32_t HISTOGRAM_Percentile(const HISTOGRAM_t *histogram, uint32_t permille)
+{
+	uint64_t rank;
+	uint64_t seen = 0;
+
+	if(histogram->count == 0)
+	{
+		return 0;
+	}
+	if(permille > 1000)
+	{
+		permille = 1000;
+	}
+
+	/* 1-based rank of the sample, rounded up so p1000 is the largest */
+	rank = ((uint64_t)histogram->count * permille + 999) / 1000;
+	if(rank == 0)
+	{
+		rank = 1;
+	}
+
+	for(uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+	{
+		seen += histogram->buckets[b];
+		if(seen >= rank)
+		{
+			uint32_t high = HISTOGRAM_BucketHigh(b);
+
+			if(high > histogram->max)
+			{
+				high = histogram->max;
+			}
+			return (high < histogram->min) ? histogram->min : high;
+		}
+	}
+	return histogram->max;
+}
@@ -0,0 +1,47 @@
+/***************************************************************************//**
+ * @file
+ * @brief Log2 bucketed histogram of 32-bit samples
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdint.h>
+
+/* Bucket 0 holds 0 and 1, bucket k >= 1 holds [2^k, 2^(k+1)), so any
+ * uint32_t lands in one of 32 buckets found with a single count leading
+ * zeros. HISTOGRAM_Add() is short enough for interrupt context, but is not
+ * reentrant: a histogram is fed from one context only. Nothing here touches
+ * the hardware, tools/histogram_check.c builds it on a PC. */
+
+#define HISTOGRAM_BUCKETS		32
+
+typedef struct {
+	uint32_t buckets[HISTOGRAM_BUCKETS];
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+} HISTOGRAM_t;
+
+void HISTOGRAM_Reset(HISTOGRAM_t *histogram);
+uint32_t HISTOGRAM_Bucket(uint32_t value);
+uint32_t HISTOGRAM_BucketLow(uint32_t bucket);
+uint32_t HISTOGRAM_BucketHigh(uint32_t bucket);
+void HISTOGRAM_Add(HISTOGRAM_t *histogram, uint32_t value);
+uint32_t HISTOGRAM_Mean(const HISTOGRAM_t *histogram);
+uint32_t HISTOGRAM_Percentile(const HISTOGRAM_t *histogram, uint32_t permille);
+
+#endif
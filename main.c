@@ -33,6 +33,31 @@
 
 #include "gpiointerrupt.h"
 //#include "graphics.h"
+#include "retargetserial.h"
+#include "dlog.h"
+#include "console.h"
+#include "mx25flash_spi.h"
+#include "mx25flash_sfdp.h"
+#include "flasherase.h"
+#include "flashlog.h"
+#include "archive.h"
+#include "pscache.h"
+#include "payloadcrypt.h"
+#include "payloaddigest.h"
+#include "cryptobackend.h"
+#include "energy.h"
+#include "wakelatency.h"
+#include "critprof.h"
+#include "clockprof.h"
+#include "headroom.h"
+#include "uartbridge.h"
+#include "samplestats.h"
+#include "uartsink.h"
+#include "advfilter.h"
+#include "connsetup.h"
+#include "phymatrix.h"
+#include "dtmsweep.h"
+#include "chanclass.h"
 
 /* Bluetooth stack headers */
 #include "bg_types.h"
@@ -41,6 +66,7 @@
 //#include "aat.h"
 
 /* Libraries containing default Gecko configuration values */
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_cmu.h"
 #include "em_rtcc.h"
@@ -77,6 +103,10 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 #define SOFT_TIMER_DISPLAY_REFRESH_HANDLE		0	// Handle for the display refresh
 #define SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE	1 	// Handle for stopping fixed time transfer
 #define COEX_COUNTER_UPDATE                     2
+#define SOFT_TIMER_SAMPLE_HANDLE				3	// Handle for the per second time-series samples
+#define SOFT_TIMER_RECONNECT_HANDLE				4	// Handle for the reconnect loop hold time and cycle timeout
+#define SOFT_TIMER_MATRIX_HANDLE				5	// Handle for the PHY matrix waits
+#define SOFT_TIMER_DTM_HANDLE					6	// Handle for the DTM sweep slots and the slave's answer
 
 #define DATA_SIZE			255					// Size of the arrays for sending and receiving data
 
@@ -102,11 +132,34 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 #define ADV_INTERVAL_MIN				160					// 160 * 0.625us = 100ms
 //#define SEND_FIXED_TRANSFER_COUNT		1000				// Uncomment this if you want to send a fixed amount of indications/notifications on each button press
 //#define SEND_FIXED_TRANSFER_TIME		(32768*5)				// Uncomment this if you want to send indications/notifications for a fixed amount of time (in 32.768Hz clock ticks) on each button press
+//#define DEEP_SLEEP						// Uncomment this to let the stack sleep in EM2 between radio events, the "wake" console command shows what it costs
 
 /* MASTER SIDE MACROS */
 #define PHY_CHANGE						(uint32)(1 << 4)	// Bit flag to external signal command
 #define WRITE_NO_RESPONSE_START			(uint32)(1 << 5)	// Bit flag to external signal command
 #define WRITE_NO_RESPONSE_END			(uint32)(1 << 6)	// Bit flag to external signal command
+
+/* CONSOLE MACROS */
+#define CONSOLE_INPUT					(uint32)(1 << 7)	// Bit flag to external signal command, serial RX went idle
+#define SAMPLE_COUNT					120					// Number of one second time-series samples kept per run
+#define ARCHIVE_BENCH_PS_KEY			0x4000				// User PS key the archive benchmark writes and erases again
+#define PSKEY_BOOT_COUNT				0x4001				// uint32_t, resets since the PS was last cleared
+#define PSKEY_RUN_COUNT					0x4002				// uint32_t, runs completed
+#define PSKEY_PAYLOAD_SIZE				0x4003				// uint16_t, payloadSize set from the console
+#define CRYPTOBENCH_ITERATIONS			4					// Calls averaged per cryptobench figure
+#define L2CAP_HEADER_SIZE				4					// Added to every ATT PDU for the airtime estimate
+#define WAKE_PERCENTILE					990					// Wake latency percentile shown by counters, per mille
+#define RECONNECT_HOLD					1000				// Default time a reconnect loop link is held after the first data, ms
+#define RECONNECT_TIMEOUT				(32768*10)			// A reconnect loop cycle not reaching the first data by then is abandoned, RTCC ticks
+#define MATRIX_SECONDS					10					// Default run length of each PHY matrix step
+#define PEER_STREAM_START				2					// Display refresh value asking the slave to start notifications
+#define PEER_STREAM_END					3					// Display refresh value asking the slave to stop notifications
+#define PEER_DTM_SWEEP					4					// Display refresh value asking the slave to close the link and run the DTM sweep
+#define DTM_CELL_MS						250					// Transmit time of each DTM sweep cell
+#define DTM_LEAD						32768				// RTCC ticks from the link closing to the first DTM sweep slot
+#define DTM_ANSWER_TIMEOUT				(32768*3)			// The slave closes the link within this once asked for the DTM sweep
+#define PEER_DTM_SURVEY					5					// Display refresh value asking the slave to close the link and run the channel survey
+#define DTM_SURVEY_CELL_MS				200					// Transmit time of each channel survey cell
 #define CONN_INTERVAL_1MPHY_MAX			40					// 40 * 1.25ms = 50ms
 #define CONN_INTERVAL_1MPHY_MIN			40					// 40 * 1.25ms = 50ms
 #define SLAVE_LATENCY_1MPHY				0					// How many connection intervals can the slave skip if no data is to be sent
@@ -159,6 +212,10 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 #define SOFT_TIMER_DISPLAY_REFRESH_HANDLE		0	// Handle for the display refresh
 #define SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE	1 	// Handle for stopping fixed time transfer
 #define COEX_COUNTER_UPDATE                     2
+#define SOFT_TIMER_SAMPLE_HANDLE				3	// Handle for the per second time-series samples
+#define SOFT_TIMER_RECONNECT_HANDLE				4	// Handle for the reconnect loop hold time and cycle timeout
+#define SOFT_TIMER_MATRIX_HANDLE				5	// Handle for the PHY matrix waits
+#define SOFT_TIMER_DTM_HANDLE					6	// Handle for the DTM sweep slots and the slave's answer
 
 #define DATA_SIZE			255					// Size of the arrays for sending and receiving data
 
@@ -184,11 +241,34 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 #define ADV_INTERVAL_MIN				160					// 160 * 0.625us = 100ms
 //#define SEND_FIXED_TRANSFER_COUNT		1000				// Uncomment this if you want to send a fixed amount of indications/notifications on each button press
 //#define SEND_FIXED_TRANSFER_TIME		(32768*5)				// Uncomment this if you want to send indications/notifications for a fixed amount of time (in 32.768Hz clock ticks) on each button press
+//#define DEEP_SLEEP						// Uncomment this to let the stack sleep in EM2 between radio events, the "wake" console command shows what it costs
 
 /* MASTER SIDE MACROS */
 #define PHY_CHANGE						(uint32)(1 << 4)	// Bit flag to external signal command
 #define WRITE_NO_RESPONSE_START			(uint32)(1 << 5)	// Bit flag to external signal command
 #define WRITE_NO_RESPONSE_END			(uint32)(1 << 6)	// Bit flag to external signal command
+
+/* CONSOLE MACROS */
+#define CONSOLE_INPUT					(uint32)(1 << 7)	// Bit flag to external signal command, serial RX went idle
+#define SAMPLE_COUNT					120					// Number of one second time-series samples kept per run
+#define ARCHIVE_BENCH_PS_KEY			0x4000				// User PS key the archive benchmark writes and erases again
+#define PSKEY_BOOT_COUNT				0x4001				// uint32_t, resets since the PS was last cleared
+#define PSKEY_RUN_COUNT					0x4002				// uint32_t, runs completed
+#define PSKEY_PAYLOAD_SIZE				0x4003				// uint16_t, payloadSize set from the console
+#define CRYPTOBENCH_ITERATIONS			4					// Calls averaged per cryptobench figure
+#define L2CAP_HEADER_SIZE				4					// Added to every ATT PDU for the airtime estimate
+#define WAKE_PERCENTILE					990					// Wake latency percentile shown by counters, per mille
+#define RECONNECT_HOLD					1000				// Default time a reconnect loop link is held after the first data, ms
+#define RECONNECT_TIMEOUT				(32768*10)			// A reconnect loop cycle not reaching the first data by then is abandoned, RTCC ticks
+#define MATRIX_SECONDS					10					// Default run length of each PHY matrix step
+#define PEER_STREAM_START				2					// Display refresh value asking the slave to start notifications
+#define PEER_STREAM_END					3					// Display refresh value asking the slave to stop notifications
+#define PEER_DTM_SWEEP					4					// Display refresh value asking the slave to close the link and run the DTM sweep
+#define DTM_CELL_MS						250					// Transmit time of each DTM sweep cell
+#define DTM_LEAD						32768				// RTCC ticks from the link closing to the first DTM sweep slot
+#define DTM_ANSWER_TIMEOUT				(32768*3)			// The slave closes the link within this once asked for the DTM sweep
+#define PEER_DTM_SURVEY					5					// Display refresh value asking the slave to close the link and run the channel survey
+#define DTM_SURVEY_CELL_MS				200					// Transmit time of each channel survey cell
 #define CONN_INTERVAL_1MPHY_MAX			40					// 40 * 1.25ms = 50ms
 #define CONN_INTERVAL_1MPHY_MIN			40					// 40 * 1.25ms = 50ms
 #define SLAVE_LATENCY_1MPHY				0					// How many connection intervals can the slave skip if no data is to be sent
@@ -223,7 +303,7 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 /* Bluetooth stack configuration parameters (see "UG136: Silicon Labs Bluetooth C Application Developer's Guide" for details on each parameter) */
 static gecko_configuration_t config = {
   .config_flags = 0,                                   /* Check flag options from UG136 */
-#if 0 //defined(FEATURE_LFXO)
+#if defined(DEEP_SLEEP) && defined(FEATURE_LFXO)
   .sleep.flags = SLEEP_FLAGS_DEEP_SLEEP_ENABLE,        /* Sleep is enabled */
 #else
   .sleep.flags = 0,
@@ -265,6 +345,7 @@ uint16_t maxDataSizeNotifications = 0;					// Variable to calculate maximum data
 uint8_t connection = 0; 								// Variable to hold the connection handle
 uint16_t phyInUse = PHY_1M;								// Variable to hold the PHY in use
 uint16_t phyToUse = 0;									// Variable to hold the next PHY to use when changing to and from LE Coded Phy
+uint16_t connInterval = 0;								// Connection interval in 1.25ms units
 bool notifications_enabled = false; 					// Flag to check if notifications are enabled or not
 bool indications_enabled = false; 						// Flag to check if indications are enabled or not
 bool roleIsSlave; 										// Flag to check if role is slave or master (based on PB0 being pressed or not during boot)
@@ -274,11 +355,56 @@ bool sendWriteNoResponse = false;						// Flag to trigger sending of write no re
 bool notification_accepted = true;						// Flag to check if previous notification command was accepted and generate new data for the next one
 uint8 throughput_array_notifications[DATA_SIZE] = {0}; 	// Array to hold data payload to be sent over notifications
 uint8 throughput_array_indications[DATA_SIZE] = {0}; 	// Array to hold data payload to be sent over indications
+uint8 encrypted_array_notifications[DATA_SIZE];			// throughput_array_notifications as sent when payloadCrypt is set
+uint8 encrypted_array_indications[DATA_SIZE];			// throughput_array_indications as sent when payloadCrypt is set
+bool payloadCrypt = false;								// Encrypt sent and decrypt received payloads with AES-CTR
+bool payloadDigest = false;								// Random payloads checked with a SHA-256 chain instead of the ramp
+bool digestTrailerInFlight = false;						// The indication waiting for confirmation is part of the digest trailer
+uint8 digest_trailer[DATA_SIZE];						// Digest trailer packet being sent
 uint32 bitsSent = 0; 									// Variable to increment the amount of data sent and received and display the throughput
 uint32 throughput = 0;									// Variable to hold throughput calculation
 uint32 operationCount = 0;								// Variable to count how many GATT operations have occurred from both sides
 uint8_t enableNotificationsIndications = 0;				// Variable to control enabling notifications and indications in master mode
 uint8_t invalidData = 0;								// Variable to register how many notifications were not received by the application
+uint16_t payloadSize = 0;								// Payload size requested from the console, 0 = calculated from MTU and PDU
+CONSOLE_t console;										// Serial command console state
+struct {
+	uint32_t time;										// RTCC ticks
+	uint32_t bits;										// bitsSent at that time
+	uint32_t operations;								// operationCount at that time
+} samples[SAMPLE_COUNT];								// Time-series of the current or last run
+uint32_t sampleCount = 0;								// Number of valid entries in samples
+bool sampling = false;									// Between samplingStart() and samplingStop()
+SAMPLESTATS_Series_t statsRssi;							// RSSI of the current or last run, dBm
+SAMPLESTATS_Series_t statsThroughput;					// Throughput of each second of it, kbit/s
+SAMPLESTATS_Series_t statsDenials;						// Coex denials per request of each counter read, permille
+uint32_t statsBits = 0;									// bitsSent at the last second
+uint8_t runMode = FLASHLOG_MODE_NOTIFY;					// FLASHLOG_MODE_* of the current or last run
+uint32_t runCoex[4];									// Coex counters summed over the current run
+uint32_t bootCount = 0;									// Persisted through the PS cache
+uint32_t runCount = 0;									// Persisted through the PS cache
+uint8_t openConnection = 0;								// Handle of the link being set up or open, connection is only set once the MTU is known
+uint32_t reconnectCycles = 0;							// Reconnect loop cycles still to run, master only
+uint32_t reconnectHold = 0;								// RTCC ticks a reconnect loop link is held after the first data
+uint32_t matrixInvalid = 0;								// invalidData when the PHY matrix step started
+uint32_t matrixCoex[4];									// Coex counters when the PHY matrix step started, not cleared
+const PHYMATRIX_Step_t phyTimings[] = {					// Connection timing to use with each PHY
+	{ PHY_1M, CONN_INTERVAL_1MPHY_MIN, CONN_INTERVAL_1MPHY_MAX, SLAVE_LATENCY_1MPHY, SUPERVISION_TIMEOUT_1MPHY },
+	{ PHY_2M, CONN_INTERVAL_2MPHY_MIN, CONN_INTERVAL_2MPHY_MAX, SLAVE_LATENCY_2MPHY, SUPERVISION_TIMEOUT_2MPHY },
+	{ PHY_S2, CONN_INTERVAL_125KPHY_MIN, CONN_INTERVAL_125KPHY_MAX, SLAVE_LATENCY_125KPHY, SUPERVISION_TIMEOUT_125KPHY },
+	{ PHY_S8, CONN_INTERVAL_125KPHY_MIN, CONN_INTERVAL_125KPHY_MAX, SLAVE_LATENCY_125KPHY, SUPERVISION_TIMEOUT_125KPHY },
+};
+bool dtmPending = false;								// The DTM sweep starts when the link closes
+uint32_t dtmSync = 0;									// RTCC ticks the two boards may see the link close apart
+const uint8_t dtmPhys[] = { DTMSWEEP_PHY_1M, DTMSWEEP_PHY_2M, DTMSWEEP_PHY_S2, DTMSWEEP_PHY_S8 };	// DTM sweep plan, the same on both boards
+const uint8_t dtmLengths[] = { 37, 128, 255 };
+bool dtmSurvey = false;									// The sweep pending or last run is the channel survey
+uint8_t chanMap[CHANCLASS_MAP_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0x1f };	// Data channel classification of the last survey, every channel at first
+bool chanApplied = false;								// chanMap is the stack's classification, master only
+uint8_t chanComparing = 0;								// Run of chan compare under way, 1 on the default map, 2 on chanMap
+uint32_t chanSeconds = 0;								// Run length of chan compare
+uint32_t chanDefaultBps = 0;							// Throughput of chan compare on the default map
+bool bridging = false;									// Serial bytes are sent instead of the ramp, see uartbridge.h
 #ifdef SEND_FIXED_TRANSFER_COUNT
 uint32_t transferCount = 0;
 #endif
@@ -287,6 +413,8 @@ char mtuSizeString[] = "MTU:     "; 				// Char array to print MTU size on the d
 char connIntervalString[] = "INTRV:      ";		// Char array to print connection interval on the display
 char pduSizeString[] = "PDU:     ";				// Char array to print PTU size on the display
 char deviceNameString[] = "Throughput Tester";			// Char array to with device name to match against scan results
+const uint8_t throughputServiceUuid[16] = { 0xf2, 0x20, 0x18, 0xc7, 0x32, 0x2d, 0xc7, 0xab,	// bbb99e70-fff7-46cf-abc7-2d32c71820f2, little endian
+		0xcf, 0x46, 0xf7, 0xff, 0x70, 0x9e, 0xb9, 0xbb };
 char phyInUseString[] = "PHY:    ";						// Char array to print PHY in use on the display
 char maxDataSizeNotificationsString[] = "DATA SIZE:     ";
 char invalidDataString[] = "INVALD:     ";
@@ -459,127 +587,2556 @@ void handle_button_change(uint8_t pin)
 				gecko_external_signal(WRITE_NO_RESPONSE_START);
 			}
 		}
-		else
+		else
+		{
+			if(roleIsSlave) {
+				/* PB1 released */
+				gecko_external_signal(INDICATIONS_END);
+			}
+			else
+			{
+				gecko_external_signal(WRITE_NO_RESPONSE_END);
+			}
+		}
+	}
+}
+
+
+/**************************************************************************//**
+* @brief Function to generate circular data (0-255) in the data payload
+*****************************************************************************/
+void generate_data_notifications(void){
+
+	if(payloadDigest)
+	{
+		PAYLOADDIGEST_Fill(throughput_array_notifications, maxDataSizeNotifications);
+	}
+	else
+	{
+		throughput_array_notifications[0] = throughput_array_notifications[maxDataSizeNotifications-1] + 1;
+
+		for(int i = 1; i<maxDataSizeNotifications; i++)
+		{
+			throughput_array_notifications[i] = throughput_array_notifications[i-1] + 1;
+		}
+	}
+
+	if(payloadCrypt)
+	{
+		PAYLOADCRYPT_Encrypt(roleIsSlave ? PAYLOADCRYPT_STREAM_NOTIFY : PAYLOADCRYPT_STREAM_WRITE,
+				encrypted_array_notifications, throughput_array_notifications, maxDataSizeNotifications);
+	}
+}
+
+
+/**************************************************************************//**
+* @brief Function to generate circular data (0-255) in the data payload
+*****************************************************************************/
+void generate_data_indications(void){
+
+	if(payloadDigest)
+	{
+		PAYLOADDIGEST_Fill(throughput_array_indications, maxDataSizeIndications);
+	}
+	else
+	{
+		throughput_array_indications[0] = throughput_array_indications[maxDataSizeIndications-1] + 1;
+
+		for(int i = 1; i<maxDataSizeIndications; i++)
+		{
+			throughput_array_indications[i] = throughput_array_indications[i-1] + 1;
+		}
+	}
+
+	if(payloadCrypt)
+	{
+		PAYLOADCRYPT_Encrypt(PAYLOADCRYPT_STREAM_INDICATE, encrypted_array_indications, throughput_array_indications, maxDataSizeIndications);
+	}
+}
+
+/**************************************************************************//**
+* @brief Returns the notification or write payload to send, encrypted or not
+*****************************************************************************/
+uint8 *notificationsPayload(void)
+{
+	return payloadCrypt ? encrypted_array_notifications : throughput_array_notifications;
+}
+
+/**************************************************************************//**
+* @brief Returns the indication payload to send, encrypted or not
+*****************************************************************************/
+uint8 *indicationsPayload(void)
+{
+	return payloadCrypt ? encrypted_array_indications : throughput_array_indications;
+}
+
+/**************************************************************************//**
+* @brief First received byte the ramp check compares with the one before it
+*****************************************************************************/
+int rampStart(void)
+{
+	return payloadCrypt ? PAYLOADCRYPT_HEADER_SIZE + 1 : 1;
+}
+
+/**************************************************************************//**
+* @brief Adds a payload sent or received to the digest chain. The sequence
+* number in front of an encrypted payload is left out, the sender never sees it
+*****************************************************************************/
+void digestAdd(const uint8 *data, uint16_t len)
+{
+	uint16_t skip = payloadCrypt ? PAYLOADCRYPT_HEADER_SIZE : 0;
+
+	if(len > skip)
+	{
+		PAYLOADDIGEST_Add(data + skip, len - skip);
+	}
+}
+
+/**************************************************************************//**
+* @brief Adds the airtime of one ATT PDU, sent or received, on the PHY and
+* PDU size of the connection
+*****************************************************************************/
+void energyPacket(uint16_t attBytes, bool sent)
+{
+	ENERGY_Packet((uint8_t)phyInUse, attBytes + L2CAP_HEADER_SIZE, pduSize, sent);
+}
+
+/**************************************************************************//**
+* @brief Queues the edges of a pin on the pin interrupt of the same number.
+* If that interrupt is already enabled, as the coex driver does for GRANT,
+* its configuration is kept, as long as it is routed to this port
+*****************************************************************************/
+void edgeQueuePin(GPIO_Port_TypeDef port, unsigned int pin)
+{
+	uint32_t route = (pin < 8) ? (GPIO->EXTIPSELL >> (4 * pin)) : (GPIO->EXTIPSELH >> (4 * (pin - 8)));
+
+	if((GPIO->IEN & (1u << pin)) == 0)
+	{
+		GPIO_ExtIntConfig(port, pin, pin, true, true, true);
+	}
+	else if((route & 0xF) != (uint32_t)port)
+	{
+		DLOG("edges: interrupt %u is taken\r\n", pin);
+		return;
+	}
+	GPIOINT_EdgeQueueEnable((uint8_t)pin, port, pin);
+}
+
+/**************************************************************************//**
+* @brief Moves the queued coex pin edges to the flash log, at most one record
+* per call
+*****************************************************************************/
+void edgesDrain(void)
+{
+	FLASHLOG_Edge_t edges[FLASHLOG_EDGES_PER_RECORD];
+	GPIOINT_Edge_t edge;
+	uint32_t count = 0;
+
+	while(count < FLASHLOG_EDGES_PER_RECORD && GPIOINT_EdgeGet(&edge))
+	{
+		edges[count].timestamp = edge.timestamp;
+		edges[count].intNo = edge.intNo;
+		edges[count].level = edge.level;
+		edges[count].dropped = edge.dropped;
+		count++;
+	}
+	if(count != 0)
+	{
+		FLASHLOG_Append(FLASHLOG_TYPE_EDGES, RTCC_CounterGet(), edges, count * sizeof(edges[0]));
+	}
+}
+
+/**************************************************************************//**
+* @brief CONNSETUP_Done_t callback, logs the cycle and runs the reconnect
+* loop: a completed cycle is held for reconnectHold and then closed
+*****************************************************************************/
+void setupDone(const CONNSETUP_Cycle_t *cycle, bool completed)
+{
+	FLASHLOG_Append(FLASHLOG_TYPE_SETUP, cycle->start, cycle, sizeof(*cycle));
+	DLOG("setup %u completed %u, opened %u mtu %u first data %u ticks\r\n", cycle->cycle, completed,
+			cycle->ticks[CONNSETUP_OPENED], cycle->ticks[CONNSETUP_MTU], cycle->ticks[CONNSETUP_FIRST_DATA]);
+
+	if(reconnectCycles == 0)
+	{
+		return;
+	}
+	if(--reconnectCycles == 0)
+	{
+		gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_RECONNECT_HANDLE, 0);
+		DLOG("reconnect loop done\r\n");
+	}
+	else if(completed)
+	{
+		gecko_cmd_hardware_set_soft_timer(reconnectHold, SOFT_TIMER_RECONNECT_HANDLE, 1);
+	}
+}
+
+/**************************************************************************//**
+* @brief Starts a connection setup cycle, in the reconnect loop with its
+* timeout
+*****************************************************************************/
+void setupCycleStart(void)
+{
+	CONNSETUP_Start(RTCC_CounterGet());
+	if(reconnectCycles != 0)
+	{
+		gecko_cmd_hardware_set_soft_timer(RECONNECT_TIMEOUT, SOFT_TIMER_RECONNECT_HANDLE, 1);
+	}
+}
+
+/**************************************************************************//**
+* @brief Back to advertising or scanning, after a link or the DTM sweep
+*****************************************************************************/
+void linkRestart(void)
+{
+	if(roleIsSlave)
+	{
+		gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_undirected_connectable);
+	}
+	else
+	{
+		ADVFILTER_Reset();
+		gecko_cmd_le_gap_start_discovery(1, le_gap_discover_generic);
+	}
+	setupCycleStart();
+}
+
+/**************************************************************************//**
+* @brief Data went out or came in, the first time in a cycle it completes the
+* connection setup
+*****************************************************************************/
+void setupFirstData(void)
+{
+	if(!CONNSETUP_Reached(CONNSETUP_FIRST_DATA))
+	{
+		CONNSETUP_Mark(CONNSETUP_FIRST_DATA, RTCC_CounterGet());
+	}
+}
+
+/**************************************************************************//**
+* @brief Processes advertisement packets looking for the "Throughput Tester"
+* device name, the throughput service or the target address set with the
+* target console command. A scan response, a directed advertisement or
+* passive scanning leave no more data to come for the address, so a miss is
+* remembered and its later reports are not parsed again
+*****************************************************************************/
+int process_scan_response(struct gecko_msg_le_gap_scan_response_evt_t *pResp)
+{
+	/* Decoding advertising packets is done here. The list of AD types can be found
+	 * at: https://www.bluetooth.com/specifications/assigned-numbers/Generic-Access-Profile */
+
+	/* packet_type bits 0-2: 0 connectable scannable, 1 connectable directed,
+	 * 2 scannable, 3 non-connectable, 4 scan response */
+	uint8_t type = pResp->packet_type & 0x07;
+	bool final = (type != 0) || !ACTIVE_SCANNING;
+
+	if(type == 2 || type == 3)
+	{
+		/* Cannot be connected to, whatever it carries */
+		return 0;
+	}
+
+	return ADVFILTER_Report(pResp->address.addr, pResp->address_type, pResp->data.data, pResp->data.len, final) ? 1 : 0;
+}
+
+/**************************************************************************//**
+* @brief Calculates the data size for notifications and write without response
+* from the MTU and PDU sizes, or applies the size requested from the console
+*****************************************************************************/
+void updateMaxDataSizeNotifications(void)
+{
+	if(DATA_TRANSFER_SIZE_NOTIFICATIONS == 0 || DATA_TRANSFER_SIZE_NOTIFICATIONS > (mtuSize-3))
+	{
+		if(pduSize!=0 && mtuSize!=0) {
+			if(pduSize <= mtuSize)
+			{
+				maxDataSizeNotifications = (pduSize - 7) + ((mtuSize - 3 - pduSize + 7) / pduSize * pduSize);
+			}
+			else
+			{
+				if(pduSize-mtuSize<=4)
+				{
+					maxDataSizeNotifications = pduSize - 7;
+				} else {
+					maxDataSizeNotifications = mtuSize - 3;
+				}
+			}
+		}
+	}
+	else
+	{
+		maxDataSizeNotifications = DATA_TRANSFER_SIZE_NOTIFICATIONS;
+	}
+
+	if(payloadSize != 0 && mtuSize != 0)
+	{
+		maxDataSizeNotifications = (payloadSize < (mtuSize - 3)) ? payloadSize : (mtuSize - 3);
+	}
+}
+
+/**************************************************************************//**
+* @brief Starts recording one time-series sample per second
+*****************************************************************************/
+void samplingStart(void)
+{
+	sampleCount = 0;
+	sampling = true;
+	statsBits = 0;
+	SAMPLESTATS_Reset(&statsRssi);
+	SAMPLESTATS_Reset(&statsThroughput);
+	SAMPLESTATS_Reset(&statsDenials);
+	gecko_cmd_hardware_set_soft_timer(32768, SOFT_TIMER_SAMPLE_HANDLE, 0);
+}
+
+/**************************************************************************//**
+* @brief Stops the time-series, keeping the samples for the dump command
+*****************************************************************************/
+void samplingStop(void)
+{
+	sampling = false;
+	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_SAMPLE_HANDLE, 0);
+}
+
+/**************************************************************************//**
+* @brief Logs where the core's time went in the run that just ended
+*****************************************************************************/
+void cpuLog(void)
+{
+	HEADROOM_Report_t report;
+	FLASHLOG_Cpu_t cpu;
+
+	HEADROOM_Get(&report);
+	cpu.coreHz = report.coreHz;
+	for(uint32_t s = 0; s < HEADROOM_SHARES; s++)
+	{
+		cpu.permille[s] = report.permille[s];
+	}
+	cpu.neededHz = report.neededHz;
+	FLASHLOG_Append(FLASHLOG_TYPE_CPU, RTCC_CounterGet(), &cpu, sizeof(cpu));
+}
+
+/**************************************************************************//**
+* @brief Queues the summary of the run that just ended for the internal flash
+* archive. The coex counters are read without clearing them, the three second
+* timer keeps clearing them for the flash log
+*****************************************************************************/
+void archiveRun(void)
+{
+	struct gecko_msg_coex_get_counters_rsp_t *coex = gecko_cmd_coex_get_counters(0);
+	ARCHIVE_Summary_t summary;
+	uint32_t counters[4] = { 0 };
+
+	if(coex->result == 0 && coex->counters.len >= sizeof(counters))
+	{
+		memcpy(counters, coex->counters.data, sizeof(counters));
+	}
+
+	memset(&summary, 0, sizeof(summary));
+	summary.timestamp = RTCC_CounterGet();
+	summary.kind = ARCHIVE_KIND_RUN;
+	summary.phy = (uint8_t)phyInUse;
+	summary.mode = runMode;
+	summary.invalid = invalidData;
+	summary.dataSize = maxDataSizeNotifications;
+	summary.mtu = mtuSize;
+	summary.interval = connInterval;
+	summary.bits = bitsSent;
+	summary.ticks = time_elapsed;
+	summary.throughput = throughput;
+	summary.operations = operationCount;
+	summary.lpRequests = runCoex[0] + counters[0];
+	summary.hpRequests = runCoex[1] + counters[1];
+	summary.lpDenials = runCoex[2] + counters[2];
+	summary.hpDenials = runCoex[3] + counters[3];
+
+	ARCHIVE_Save(&summary);
+}
+
+/**************************************************************************//**
+* @brief Reads the persisted counters and settings through the PS cache and
+* counts this boot
+*****************************************************************************/
+void psRestore(void)
+{
+	uint16_t size;
+	uint8_t len;
+
+	PSCACHE_Init();
+
+	len = sizeof(bootCount);
+	if(PSCACHE_Load(PSKEY_BOOT_COUNT, &bootCount, &len) != 0 || len != sizeof(bootCount))
+	{
+		bootCount = 0;
+	}
+	bootCount++;
+	PSCACHE_Save(PSKEY_BOOT_COUNT, &bootCount, sizeof(bootCount));
+
+	len = sizeof(runCount);
+	if(PSCACHE_Load(PSKEY_RUN_COUNT, &runCount, &len) != 0 || len != sizeof(runCount))
+	{
+		runCount = 0;
+	}
+
+	len = sizeof(size);
+	if(PSCACHE_Load(PSKEY_PAYLOAD_SIZE, &size, &len) == 0 && len == sizeof(size) && size <= DATA_SIZE)
+	{
+		payloadSize = size;
+	}
+}
+
+/**************************************************************************//**
+* @brief Does a few things before initiating data transmissions. Read RTCC, disable
+* display refresh in master side and turn ON LED indicating data transmission
+*****************************************************************************/
+void dataTransmissionStart(uint8_t mode)
+{
+	FLASHLOG_RunStart_t run = { (uint8_t)phyInUse, mode, maxDataSizeNotifications, mtuSize, connInterval };
+
+	bitsSent = 0;
+	throughput = 0;
+	runMode = mode;
+	memset(runCoex, 0, sizeof(runCoex));
+	PAYLOADCRYPT_Start();
+	PAYLOADDIGEST_Start(RTCC_CounterGet());
+	digestTrailerInFlight = false;
+	time_elapsed = RTCC_CounterGet();
+	ENERGY_Start(time_elapsed);
+	WAKELAT_Start();
+	CRITPROF_Start();
+	HEADROOM_Start(DWT->CYCCNT, time_elapsed, CMU_ClockFreqGet(cmuClock_CORE));
+	samplingStart();
+	FLASHLOG_Append(FLASHLOG_TYPE_RUN_START, time_elapsed, &run, sizeof(run));
+
+	/* Turn OFF Display refresh on master side */
+	gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &displayRefreshOff);
+
+	/* Stop display refresh */
+	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
+
+#ifdef USE_LED_FOR_DATA_SENDING_SIGNALING
+	/* Turn ON data LED */
+	GPIO_PinOutSet(BSP_LED1_PORT,BSP_LED1_PIN);
+#endif
+}
+
+/**************************************************************************//**
+* @brief Sends this end's digest report behind the last notification or
+* write of the run. Indications send it from the confirmation handler, one
+* packet per confirmation
+*****************************************************************************/
+void digestTrailerSend(void)
+{
+	uint16_t len;
+
+	if(runMode == FLASHLOG_MODE_NOTIFY && notifications_enabled)
+	{
+		while((len = PAYLOADDIGEST_TrailerNext(digest_trailer, maxDataSizeNotifications)) != 0)
+		{
+			while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_notifications, len, digest_trailer)->result != 0);
+		}
+	}
+	else if(runMode == FLASHLOG_MODE_WRITE)
+	{
+		while((len = PAYLOADDIGEST_TrailerNext(digest_trailer, maxDataSizeNotifications)) != 0)
+		{
+			while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_throughput_write_no_response, len, digest_trailer)->result != 0);
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Does a few after data transmissions ended. Calculate transmission time,
+* enable display refresh in master side and turn OFF LED indicating data transmission
+*****************************************************************************/
+void dataTransmissionEnd(void)
+{
+	time_elapsed = RTCC_CounterGet() - time_elapsed;
+	ENERGY_Stop(RTCC_CounterGet());
+	WAKELAT_Stop();
+	CRITPROF_Stop();
+	HEADROOM_Stop(DWT->CYCCNT, RTCC_CounterGet());
+	samplingStop();
+
+	if(payloadDigest)
+	{
+		digestTrailerSend();
+	}
+
+	/* Turn ON Display on master side - stack is probably still busy pushing the last few notifications out so we need to check output */
+	while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &displayRefreshOn)->result!=0);
+
+	/* Resume display refresh - stack is probably still busy pushing the last few notifications out so we need to check output */
+	while(gecko_cmd_hardware_set_soft_timer(32768, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
+
+#ifdef USE_LED_FOR_DATA_SENDING_SIGNALING
+	/* Turn ON data LED */
+	GPIO_PinOutClear(BSP_LED1_PORT,BSP_LED1_PIN);
+#endif
+	/* Calculate throughput */
+	throughput = (uint32_t)((float)bitsSent / (float)((float)time_elapsed / (float)32768));
+
+	FLASHLOG_RunEnd_t run = { bitsSent, time_elapsed, throughput, operationCount };
+	FLASHLOG_Append(FLASHLOG_TYPE_RUN_END, RTCC_CounterGet(), &run, sizeof(run));
+	cpuLog();
+
+	archiveRun();
+
+	runCount++;
+	PSCACHE_Save(PSKEY_RUN_COUNT, &runCount, sizeof(runCount));
+}
+
+/**************************************************************************//**
+* @brief Returns true while notifications, indications or writes are being
+* sent, or the PHY matrix runs
+*****************************************************************************/
+bool runActive(void)
+{
+	return sendNotifications || sendIndications || sendWriteNoResponse || PHYMATRIX_Running() || DTMSWEEP_Running()
+			|| dtmPending || bridging;
+}
+
+/**************************************************************************//**
+* @brief Console: start [notify|indicate|write] [seconds]
+*****************************************************************************/
+CONSOLE_Status_t consoleStart(int argc, char **argv)
+{
+	const char *mode = roleIsSlave ? "notify" : "write";
+	uint32_t seconds = 0;
+	uint32_t signal;
+
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+	if(connection == 0)
+	{
+		return CONSOLE_NOT_READY;
+	}
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(!CONSOLE_ParseUint(argv[i], &seconds))
+		{
+			mode = argv[i];
+		}
+	}
+	if(seconds > 3600)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	if(roleIsSlave && strcmp(mode, "notify") == 0)
+	{
+		signal = NOTIFICATIONS_START;
+	}
+	else if(roleIsSlave && strcmp(mode, "indicate") == 0)
+	{
+		signal = INDICATIONS_START;
+	}
+	else if(!roleIsSlave && strcmp(mode, "write") == 0)
+	{
+		signal = WRITE_NO_RESPONSE_START;
+	}
+	else
+	{
+		return CONSOLE_USAGE;
+	}
+
+	if(seconds)
+	{
+		gecko_cmd_hardware_set_soft_timer(seconds * 32768, SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE, 1);
+	}
+	gecko_external_signal(signal);
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: stop
+*****************************************************************************/
+CONSOLE_Status_t consoleStop(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE, 1);
+
+	if(sendNotifications)
+	{
+		gecko_external_signal(NOTIFICATIONS_END);
+	}
+	else if(sendIndications)
+	{
+		gecko_external_signal(INDICATIONS_END);
+	}
+	else if(sendWriteNoResponse)
+	{
+		gecko_external_signal(WRITE_NO_RESPONSE_END);
+	}
+
+	return CONSOLE_OK;
+}
+
+void consoleRxIdle(void);
+void millisecondsPrint(uint32_t us);
+
+/**************************************************************************//**
+* @brief Serial RX went idle during a bridge run, called from interrupt context
+*****************************************************************************/
+void bridgeRxIdle(void)
+{
+	UARTBRIDGE_LineIdle();
+}
+
+/**************************************************************************//**
+* @brief Hands a bridge packet to the stack, as a notification on the slave
+* and a write without response on the master
+*****************************************************************************/
+bool bridgeSend(const uint8_t *data, uint16_t len)
+{
+	bool sent;
+
+	HEADROOM_Stack(DWT->CYCCNT);
+	if(roleIsSlave)
+	{
+		sent = gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_notifications, len, data)->result == 0;
+	}
+	else
+	{
+		sent = gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_throughput_write_no_response, len, data)->result == 0;
+	}
+	HEADROOM_App(DWT->CYCCNT);
+
+	if(sent)
+	{
+		setupFirstData();
+		bitsSent += len * 8;
+		operationCount++;
+		energyPacket(len + 3, true);
+	}
+	return sent;
+}
+
+const UARTBRIDGE_Port_t bridgePort = {
+	RETARGET_SerialRead,
+	RETARGET_SerialRxPending,
+	RETARGET_SerialRxOverruns,
+	bridgeSend
+};
+
+/**************************************************************************//**
+* @brief Prints the figures of the current or last bridge run
+*****************************************************************************/
+void bridgePrint(void)
+{
+	UARTBRIDGE_Stats_t stats;
+
+	UARTBRIDGE_GetStats(&stats);
+	printf("bridge %lu bytes in, %lu out in %lu packets (%lu full, %lu idle, %lu timeout), %lu bit/s\r\n",
+			(unsigned long)stats.bytesIn, (unsigned long)stats.bytesOut, (unsigned long)stats.packets,
+			(unsigned long)stats.fullPackets, (unsigned long)stats.idlePackets, (unsigned long)stats.timeoutPackets,
+			(unsigned long)UARTBRIDGE_Throughput(&stats));
+	printf("  rx ring max %lu mean %lu, %lu overruns, %lu refusals, stalled ",
+			(unsigned long)stats.pendingMax, (unsigned long)(stats.polls ? stats.pendingSum / stats.polls : 0),
+			(unsigned long)stats.overruns, (unsigned long)stats.refusals);
+	millisecondsPrint((uint32_t)(((uint64_t)stats.stallTicks * 1000000) / 32768));
+	printf(" ms, hold max ");
+	millisecondsPrint((uint32_t)(((uint64_t)stats.holdMaxTicks * 1000000) / 32768));
+	printf(" ms%s\r\n", stats.escaped ? ", escaped" : "");
+}
+
+/**************************************************************************//**
+* @brief Ends a bridge run and gives the serial port back to the console.
+* A closed link skips the run end, it has no one to tell
+*****************************************************************************/
+void bridgeEnd(bool linkUp)
+{
+	if(!bridging)
+	{
+		return;
+	}
+	bridging = false;
+	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE, 1);
+	UARTBRIDGE_Stop(RTCC_CounterGet());
+	RETARGET_SerialRxIdleCallbackSet(consoleRxIdle);
+	if(linkUp)
+	{
+		dataTransmissionEnd();
+	}
+	bridgePrint();
+}
+
+/**************************************************************************//**
+* @brief Console: bridge [seconds|stats], sends what comes in on the serial
+* port in place of the ramp, for the seconds given or until +++ with a
+* second of silence either side. The console is deaf until then
+*****************************************************************************/
+CONSOLE_Status_t consoleBridge(int argc, char **argv)
+{
+	uint32_t seconds = 0;
+	uint8_t scratch[32];
+
+	if(argc > 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2 && strcmp(argv[1], "stats") == 0)
+	{
+		bridgePrint();
+		return CONSOLE_OK;
+	}
+	if(argc == 2 && (!CONSOLE_ParseUint(argv[1], &seconds) || seconds > 3600))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive() || UARTSINK_Running())
+	{
+		return CONSOLE_BUSY;
+	}
+	if(connection == 0 || (roleIsSlave && !notifications_enabled))
+	{
+		return CONSOLE_NOT_READY;
+	}
+	if(payloadCrypt || payloadDigest)
+	{
+		printf("crypto and digest do not apply to serial data, turn them off\r\n");
+		return CONSOLE_NOT_READY;
+	}
+
+	printf("bridging %u byte packets, +++ to end\r\n", maxDataSizeNotifications);
+	RETARGET_SerialFlush();
+	/* The end of the command line is not data */
+	while(RETARGET_SerialRead(scratch, sizeof(scratch)) != 0);
+
+	dataTransmissionStart(roleIsSlave ? FLASHLOG_MODE_NOTIFY : FLASHLOG_MODE_WRITE);
+	RETARGET_SerialRxIdleCallbackSet(bridgeRxIdle);
+	UARTBRIDGE_Start(&bridgePort, maxDataSizeNotifications, RTCC_CounterGet());
+	bridging = true;
+	if(seconds)
+	{
+		gecko_cmd_hardware_set_soft_timer(seconds * 32768, SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE, 1);
+	}
+
+	return CONSOLE_OK;
+}
+
+const UARTSINK_Port_t sinkPort = {
+	RETARGET_SerialTxFree,
+	RETARGET_SerialTxPending,
+	RETARGET_SerialWriteRaw
+};
+
+/**************************************************************************//**
+* @brief Prints the figures of the current or last sink run
+*****************************************************************************/
+void sinkPrint(void)
+{
+	UARTSINK_Stats_t stats;
+
+	UARTSINK_GetStats(&stats);
+	printf("sink %lu bytes in, %lu out in %lu payloads, %lu bit/s\r\n",
+			(unsigned long)stats.bytesIn, (unsigned long)stats.bytesOut, (unsigned long)stats.packets,
+			(unsigned long)UARTSINK_Throughput(&stats));
+	printf("  tx queue max %lu, %lu dropped (%lu bytes), %lu holds (%lu given up), held ",
+			(unsigned long)stats.queueHighWater, (unsigned long)stats.drops, (unsigned long)stats.droppedBytes,
+			(unsigned long)stats.stalls, (unsigned long)stats.giveUps);
+	millisecondsPrint((uint32_t)(((uint64_t)stats.stallTicks * 1000000) / 32768));
+	printf(" ms, longest ");
+	millisecondsPrint((uint32_t)(((uint64_t)stats.stallMaxTicks * 1000000) / 32768));
+	printf(" ms\r\n");
+}
+
+/**************************************************************************//**
+* @brief Console: sink [on|off|stats], sends the data of every payload
+* received out of the serial port once it is checked, with RTS/CTS holding
+* the link back when the far end cannot keep up. The console still listens,
+* but what it prints goes into the same stream
+*****************************************************************************/
+CONSOLE_Status_t consoleSink(int argc, char **argv)
+{
+	if(argc > 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 1 || strcmp(argv[1], "stats") == 0)
+	{
+		sinkPrint();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "on") == 0)
+	{
+		if(bridging || UARTSINK_Running())
+		{
+			return CONSOLE_BUSY;
+		}
+		if(!RETARGET_SerialEnableFlowControl())
+		{
+			printf("no RTS/CTS on this port, the link is not held back\r\n");
+		}
+		RETARGET_SerialFlush();
+		UARTSINK_Start(&sinkPort, RTCC_CounterGet());
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "off") == 0)
+	{
+		UARTSINK_Stop(RTCC_CounterGet());
+		/* What is still queued goes before the figures */
+		RETARGET_SerialFlush();
+		sinkPrint();
+		return CONSOLE_OK;
+	}
+	return CONSOLE_USAGE;
+}
+
+/**************************************************************************//**
+* @brief Connection timing to use with a PHY, NULL if there is none
+*****************************************************************************/
+const PHYMATRIX_Step_t *phyTiming(uint8_t phy)
+{
+	for(uint32_t i = 0; i < sizeof(phyTimings) / sizeof(phyTimings[0]); i++)
+	{
+		if(phyTimings[i].phy == phy)
+		{
+			return &phyTimings[i];
+		}
+	}
+	return NULL;
+}
+
+/**************************************************************************//**
+* @brief Connection timing of a PHY named 1m, 2m, s2 or s8, NULL if unknown
+*****************************************************************************/
+const PHYMATRIX_Step_t *phyParse(const char *name)
+{
+	static const char *names[] = { "1m", "2m", "s2", "s8" };
+	static const uint8_t phys[] = { PHY_1M, PHY_2M, PHY_S2, PHY_S8 };
+
+	for(uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+	{
+		if(strcmp(name, names[i]) == 0)
+		{
+			return phyTiming(phys[i]);
+		}
+	}
+	return NULL;
+}
+
+const char *phyName(uint8_t phy)
+{
+	return (phy == PHY_1M) ? "1M" : (phy == PHY_2M) ? "2M" : (phy == PHY_S2) ? "S2" : (phy == PHY_S8) ? "S8" : "?";
+}
+
+/**************************************************************************//**
+* @brief Changes the connection timing for a PHY, then the PHY. The PHY is
+* requested from the connection parameters event once the new timing is in
+* place, as a coded PHY needs the longer interval. If the interval already
+* fits no such event comes, so it is requested at once
+*****************************************************************************/
+void phyRequest(const PHYMATRIX_Step_t *timing)
+{
+	phyToUse = timing->phy;
+	gecko_cmd_le_connection_set_timing_parameters(connection, timing->intervalMin, timing->intervalMax, timing->latency, timing->timeout, 0, 0);
+	if(connInterval >= timing->intervalMin && connInterval <= timing->intervalMax)
+	{
+		gecko_cmd_le_connection_set_preferred_phy(connection, phyToUse, phyToUse);
+	}
+}
+
+/**************************************************************************//**
+* @brief PHY matrix port: the master asks the slave for notifications and
+* measures them, so the data check runs on this end
+*****************************************************************************/
+void matrixRunStart(void)
+{
+	struct gecko_msg_coex_get_counters_rsp_t *coex = gecko_cmd_coex_get_counters(0);
+	const uint8_t value = PEER_STREAM_START;
+
+	memset(matrixCoex, 0, sizeof(matrixCoex));
+	if(coex->result == 0 && coex->counters.len >= sizeof(matrixCoex))
+	{
+		memcpy(matrixCoex, coex->counters.data, sizeof(matrixCoex));
+	}
+	memset(runCoex, 0, sizeof(runCoex));
+	matrixInvalid = invalidData;
+	while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &value)->result != 0);
+}
+
+void matrixRunStop(void)
+{
+	const uint8_t value = PEER_STREAM_END;
+
+	while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &value)->result != 0);
+}
+
+/**************************************************************************//**
+* @brief PHY matrix port: figures of the step. The three second coex timer
+* may have cleared the counters since the step started, what it took is in
+* runCoex
+*****************************************************************************/
+void matrixCollect(PHYMATRIX_Row_t *row)
+{
+	struct gecko_msg_coex_get_counters_rsp_t *coex = gecko_cmd_coex_get_counters(0);
+	uint32_t counters[4] = { 0 };
+
+	if(coex->result == 0 && coex->counters.len >= sizeof(counters))
+	{
+		memcpy(counters, coex->counters.data, sizeof(counters));
+	}
+
+	row->bits = bitsSent;
+	/* Without the run end time_elapsed still holds the start */
+	row->ticks = (row->flags & (PHYMATRIX_NO_END | PHYMATRIX_CLOSED)) ? RTCC_CounterGet() - time_elapsed : time_elapsed;
+	row->invalid = (invalidData >= matrixInvalid) ? invalidData - matrixInvalid : invalidData;
+	row->lpDenials = (uint16_t)(runCoex[2] + counters[2] - matrixCoex[2]);
+	row->hpDenials = (uint16_t)(runCoex[3] + counters[3] - matrixCoex[3]);
+}
+
+void matrixTimer(uint32_t ticks)
+{
+	gecko_cmd_hardware_set_soft_timer(ticks, SOFT_TIMER_MATRIX_HANDLE, 1);
+}
+
+/**************************************************************************//**
+* @brief Prints the PHY matrix report, one line per step
+*****************************************************************************/
+void matrixPrint(void)
+{
+	uint32_t count;
+	const PHYMATRIX_Row_t *rows = PHYMATRIX_Rows(&count);
+
+	printf("phy interval ms  bit/s  rssi min/mean/max  lp/hp denials  invalid  flags\r\n");
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const PHYMATRIX_Row_t *r = &rows[i];
+		uint32_t bps = r->ticks ? (uint32_t)(((uint64_t)r->bits * 32768) / r->ticks) : 0;
+
+		printf("%-3s %8lu.%02lu %6lu", phyName(r->phy), (unsigned long)(r->interval * 125 / 100),
+				(unsigned long)(r->interval * 125 % 100), (unsigned long)bps);
+		if(r->rssiCount != 0)
+		{
+			printf("  %4d/%4ld/%4d", r->rssiMin, (long)(r->rssiSum / r->rssiCount), r->rssiMax);
+		}
+		else
+		{
+			printf("       -/   -/   -");
+		}
+		printf("  %6u/%-6u %8lu  %s%s%s%s\r\n", r->lpDenials, r->hpDenials, (unsigned long)r->invalid,
+				(r->flags & PHYMATRIX_PHY_REFUSED) ? "phy refused " : "",
+				(r->flags & PHYMATRIX_INTERVAL_REFUSED) ? "interval refused " : "",
+				(r->flags & PHYMATRIX_NO_END) ? "no end " : "",
+				(r->flags & PHYMATRIX_CLOSED) ? "closed" : "");
+	}
+}
+
+/**************************************************************************//**
+* @brief PHY matrix port: logs every step and prints the report
+*****************************************************************************/
+void chanCompareNext(const PHYMATRIX_Row_t *rows, uint32_t count);
+
+void matrixDone(const PHYMATRIX_Row_t *rows, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		FLASHLOG_Append(FLASHLOG_TYPE_PHY_STEP, RTCC_CounterGet(), &rows[i], sizeof(rows[i]));
+	}
+	matrixPrint();
+	chanCompareNext(rows, count);
+}
+
+const PHYMATRIX_Port_t matrixPort = {
+	phyRequest, matrixRunStart, matrixRunStop, matrixCollect, matrixTimer, matrixDone
+};
+
+/**************************************************************************//**
+* @brief Console: matrix [run [seconds] [1m|2m|s2|s8]...|stop], master only.
+* Runs the slave's notifications on each PHY in turn, by default all four
+* for MATRIX_SECONDS each. Without an argument prints the last report
+*****************************************************************************/
+CONSOLE_Status_t consoleMatrix(int argc, char **argv)
+{
+	PHYMATRIX_Step_t steps[PHYMATRIX_MAX_STEPS];
+	uint32_t count = 0;
+	uint32_t seconds = MATRIX_SECONDS;
+
+	if(argc == 1)
+	{
+		matrixPrint();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "stop") == 0 && argc == 2)
+	{
+		PHYMATRIX_Abort();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "run") != 0)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	for(int i = 2; i < argc; i++)
+	{
+		if(i == 2 && CONSOLE_ParseUint(argv[i], &seconds))
+		{
+			continue;
+		}
+		if(phyParse(argv[i]) == NULL || count == PHYMATRIX_MAX_STEPS)
+		{
+			return CONSOLE_USAGE;
+		}
+		steps[count++] = *phyParse(argv[i]);
+	}
+	if(count == 0)
+	{
+		memcpy(steps, phyTimings, sizeof(phyTimings));
+		count = sizeof(phyTimings) / sizeof(phyTimings[0]);
+	}
+
+	if(roleIsSlave || connection == 0)
+	{
+		return CONSOLE_NOT_READY;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+	if(!PHYMATRIX_Start(&matrixPort, steps, count, seconds, (uint8_t)phyInUse, connInterval))
+	{
+		return CONSOLE_USAGE;
+	}
+
+	return CONSOLE_OK;
+}
+
+const char *dtmPhyName(uint8_t phy)
+{
+	return (phy == DTMSWEEP_PHY_1M) ? "1M" : (phy == DTMSWEEP_PHY_2M) ? "2M" : (phy == DTMSWEEP_PHY_S2) ? "S2"
+			: (phy == DTMSWEEP_PHY_S8) ? "S8" : "?";
+}
+
+/**************************************************************************//**
+* @brief Wi-Fi channel 1, 6 or 11 whose 22 MHz cover a DTM channel, 0 if none
+*****************************************************************************/
+uint8_t dtmWifiChannel(uint8_t channel)
+{
+	uint32_t mhz = 2402 + 2 * channel;
+
+	for(uint8_t wifi = 1; wifi <= 11; wifi += 5)
+	{
+		uint32_t centre = 2407 + 5 * wifi;
+
+		if(mhz + 11 >= centre && mhz <= centre + 11)
+		{
+			return wifi;
+		}
+	}
+	return 0;
+}
+
+/**************************************************************************//**
+* @brief DTM sweep port, the stack's test commands. The slave transmits
+*****************************************************************************/
+bool dtmRx(uint8_t channel, uint8_t phy)
+{
+	return gecko_cmd_test_dtm_rx(channel, phy)->result == 0;
+}
+
+bool dtmTx(uint8_t length, uint8_t channel, uint8_t phy)
+{
+	return gecko_cmd_test_dtm_tx(test_pkt_prbs9, length, channel, phy)->result == 0;
+}
+
+void dtmEnd(void)
+{
+	gecko_cmd_test_dtm_end();
+}
+
+void dtmTimer(uint32_t ticks)
+{
+	gecko_cmd_hardware_set_soft_timer(ticks, SOFT_TIMER_DTM_HANDLE, 1);
+}
+
+/**************************************************************************//**
+* @brief Logs the DTM sweep cells finished since the first given
+*****************************************************************************/
+void dtmLog(uint32_t first)
+{
+	DTMSWEEP_Cell_t cell;
+
+	for(uint32_t i = first; i < DTMSWEEP_Done() && DTMSWEEP_Cell(i, &cell); i++)
+	{
+		FLASHLOG_Append(FLASHLOG_TYPE_DTM_CELL, RTCC_CounterGet(), &cell, sizeof(cell));
+	}
+}
+
+/**************************************************************************//**
+* @brief Prints the DTM sweep as a channel by PHY heatmap of the packet error
+* rate over all lengths, permille. The mark after each figure is the band:
+* blank under 1%, '.' under 10%, '+' under 30.8%, the PER of the receiver
+* sensitivity test, '#' above. Transmitting, prints what was sent
+*****************************************************************************/
+void dtmPrint(void)
+{
+	const DTMSWEEP_Plan_t *plan = DTMSWEEP_Plan();
+	DTMSWEEP_Cell_t cell;
+
+	if(DTMSWEEP_Cells() == 0)
+	{
+		printf("no DTM sweep\r\n");
+		return;
+	}
+	printf("DTM sweep %lu of %lu cells, %lu ms each, lengths", (unsigned long)DTMSWEEP_Done(),
+			(unsigned long)DTMSWEEP_Cells(), (unsigned long)((plan->cellTicks * 1000) >> 15));
+	for(uint32_t l = 0; l < plan->lengthCount; l++)
+	{
+		printf(" %u", plan->lengths[l]);
+	}
+	printf("\r\n");
+
+	if(DTMSWEEP_Role() == DTMSWEEP_TX)
+	{
+		for(uint32_t p = 0; p < plan->phyCount; p++)
+		{
+			uint32_t sent = 0, expected = 0;
+
+			for(uint32_t i = 0; i < DTMSWEEP_Done() && DTMSWEEP_Cell(i, &cell); i++)
+			{
+				if(cell.phy == plan->phys[p] && cell.flags == 0)
+				{
+					sent += cell.packets;
+					expected += cell.expected;
+				}
+			}
+			printf("%s sent %lu, receiver expects %lu\r\n", dtmPhyName(plan->phys[p]), (unsigned long)sent,
+					(unsigned long)expected);
+		}
+		return;
+	}
+
+	printf(" MHz  ch wifi");
+	for(uint32_t p = 0; p < plan->phyCount; p++)
+	{
+		printf("    %s ", dtmPhyName(plan->phys[p]));
+	}
+	printf("\r\n");
+	for(uint8_t c = 0; c < DTMSWEEP_CHANNELS; c++)
+	{
+		if(!(plan->channels & ((uint64_t)1 << c)))
+		{
+			continue;
+		}
+		printf("%4u %3u %4u", 2402 + 2 * c, c, dtmWifiChannel(c));
+		for(uint32_t p = 0; p < plan->phyCount; p++)
+		{
+			uint32_t per = DTMSWEEP_Per(c, plan->phys[p]);
+
+			if(per == DTMSWEEP_NO_DATA)
+			{
+				printf("      - ");
+			}
+			else
+			{
+				printf("  %4lu%c ", (unsigned long)per, (per < 10) ? ' ' : (per < 100) ? '.' : (per < 308) ? '+' : '#');
+			}
+		}
+		printf("\r\n");
+		RETARGET_SerialFlush();
+	}
+}
+
+/**************************************************************************//**
+* @brief Prints every DTM sweep cell as comma separated values
+*****************************************************************************/
+void dtmCsv(void)
+{
+	DTMSWEEP_Cell_t cell;
+
+	printf("mhz,channel,phy,length,flags,expected,packets\r\n");
+	for(uint32_t i = 0; i < DTMSWEEP_Done() && DTMSWEEP_Cell(i, &cell); i++)
+	{
+		printf("%u,%u,%s,%u,%u,%u,%u\r\n", 2402 + 2 * cell.channel, cell.channel, dtmPhyName(cell.phy), cell.length,
+				cell.flags, cell.expected, cell.packets);
+		RETARGET_SerialFlush();
+	}
+}
+
+void chanClassify(void);
+
+void dtmDone(void)
+{
+	dtmPrint();
+	if(dtmSurvey && DTMSWEEP_Role() == DTMSWEEP_RX)
+	{
+		chanClassify();
+	}
+	linkRestart();
+}
+
+const DTMSWEEP_Port_t dtmPort = {
+	dtmRx, dtmTx, dtmEnd, dtmTimer, dtmDone
+};
+
+/**************************************************************************//**
+* @brief Starts the DTM sweep or the channel survey as the link closes, with
+* the plan both boards share. Two connection intervals cover the boards
+* seeing the close apart
+*****************************************************************************/
+void dtmBegin(void)
+{
+	DTMSWEEP_Plan_t plan;
+	uint32_t now = RTCC_CounterGet();
+
+	dtmPending = false;
+	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DTM_HANDLE, 1);
+
+	memset(&plan, 0, sizeof(plan));
+	if(dtmSurvey)
+	{
+		/* The data channels only, on 1M with short packets */
+		plan.channels = (((uint64_t)1 << DTMSWEEP_CHANNELS) - 1) & ~((uint64_t)1 << 0 | (uint64_t)1 << 12 | (uint64_t)1 << 39);
+		plan.phys[0] = DTMSWEEP_PHY_1M;
+		plan.phyCount = 1;
+		plan.lengths[0] = dtmLengths[0];
+		plan.lengthCount = 1;
+		plan.cellTicks = (DTM_SURVEY_CELL_MS * 32768) / 1000;
+	}
+	else
+	{
+		plan.channels = ((uint64_t)1 << DTMSWEEP_CHANNELS) - 1;
+		memcpy(plan.phys, dtmPhys, sizeof(dtmPhys));
+		plan.phyCount = sizeof(dtmPhys);
+		memcpy(plan.lengths, dtmLengths, sizeof(dtmLengths));
+		plan.lengthCount = sizeof(dtmLengths);
+		plan.cellTicks = (DTM_CELL_MS * 32768) / 1000;
+	}
+	plan.syncTicks = dtmSync;
+
+	if(!DTMSWEEP_Start(&dtmPort, &plan, roleIsSlave ? DTMSWEEP_TX : DTMSWEEP_RX, now + DTM_LEAD, now))
+	{
+		linkRestart();
+	}
+}
+
+/**************************************************************************//**
+* @brief Asks the slave for the DTM sweep or the channel survey, master only.
+* The slave closes the link and the closed event starts it on both boards
+*****************************************************************************/
+void dtmRequest(uint8_t value)
+{
+	dtmPending = true;
+	dtmSurvey = (value == PEER_DTM_SURVEY);
+	dtmSync = connInterval * 82;		// Two intervals, 1.25 ms is 40.96 ticks
+	while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &value)->result != 0);
+	gecko_cmd_hardware_set_soft_timer(DTM_ANSWER_TIMEOUT, SOFT_TIMER_DTM_HANDLE, 1);
+}
+
+/**************************************************************************//**
+* @brief Console: dtm [sweep|stop|csv]. sweep, master only, asks the slave to
+* close the link, then both run the DTM sweep from the close, the slave
+* transmitting. Without an argument prints the heatmap of the last sweep
+*****************************************************************************/
+CONSOLE_Status_t consoleDtm(int argc, char **argv)
+{
+	if(argc == 1)
+	{
+		dtmPrint();
+		return CONSOLE_OK;
+	}
+	if(argc != 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(strcmp(argv[1], "stop") == 0)
+	{
+		DTMSWEEP_Stop();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "csv") == 0)
+	{
+		dtmCsv();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "sweep") != 0)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	if(roleIsSlave || connection == 0)
+	{
+		return CONSOLE_NOT_READY;
+	}
+	if(runActive() || reconnectCycles != 0)
+	{
+		return CONSOLE_BUSY;
+	}
+
+	dtmRequest(PEER_DTM_SWEEP);
+	return CONSOLE_OK;
+}
+
+bool chanApply(const uint8_t map[CHANCLASS_MAP_SIZE])
+{
+	return gecko_cmd_le_gap_set_data_channel_classification(CHANCLASS_MAP_SIZE, map)->result == 0;
+}
+
+/**************************************************************************//**
+* @brief Prints the data channel classification and the bad channels
+*****************************************************************************/
+void chanPrint(void)
+{
+	printf("%lu of %u data channels used, map %02x %02x %02x %02x %02x, %s\r\n", (unsigned long)CHANCLASS_Count(chanMap),
+			CHANCLASS_DATA_CHANNELS, chanMap[0], chanMap[1], chanMap[2], chanMap[3], chanMap[4],
+			chanApplied ? "applied" : "not applied");
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		if(!CHANCLASS_Used(chanMap, i))
+		{
+			uint8_t rf = CHANCLASS_RfChannel(i);
+			uint32_t per = DTMSWEEP_Per(rf, DTMSWEEP_PHY_1M);
+
+			printf("bad %2u, %u MHz", i, 2402 + 2 * rf);
+			if(per != DTMSWEEP_NO_DATA)
+			{
+				printf(", PER %lu permille", (unsigned long)per);
+			}
+			printf("\r\n");
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Classifies the data channels from the survey just done and applies
+* the map. The survey's no figure is the classification's
+*****************************************************************************/
+void chanClassify(void)
+{
+	uint32_t per[CHANCLASS_RF_CHANNELS];
+
+	for(uint8_t rf = 0; rf < CHANCLASS_RF_CHANNELS; rf++)
+	{
+		per[rf] = DTMSWEEP_Per(rf, DTMSWEEP_PHY_1M);
+	}
+	CHANCLASS_Classify(per, chanMap, chanMap);
+	chanApplied = chanApply(chanMap);
+	chanPrint();
+}
+
+/**************************************************************************//**
+* @brief Next run of chan compare, as a PHY matrix run ends. The run on the
+* default map is followed by one on chanMap, then the gain is printed
+*****************************************************************************/
+void chanCompareNext(const PHYMATRIX_Row_t *rows, uint32_t count)
+{
+	uint32_t bps = 0;
+	int32_t gain;
+	uint32_t magnitude;
+
+	if(chanComparing == 0)
+	{
+		return;
+	}
+	if(count == 1 && rows[0].flags == 0 && rows[0].ticks != 0)
+	{
+		bps = (uint32_t)(((uint64_t)rows[0].bits * 32768) / rows[0].ticks);
+	}
+	if(bps == 0)
+	{
+		chanComparing = 0;
+		printf("chan compare: the run failed\r\n");
+		return;
+	}
+
+	if(chanComparing == 1)
+	{
+		chanDefaultBps = bps;
+		chanComparing = 2;
+		chanApplied = chanApply(chanMap);
+		if(!chanApplied || !PHYMATRIX_Start(&matrixPort, phyTiming((uint8_t)phyInUse), 1, chanSeconds,
+				(uint8_t)phyInUse, connInterval))
+		{
+			chanComparing = 0;
+			printf("chan compare: the classified run did not start\r\n");
+		}
+		return;
+	}
+
+	chanComparing = 0;
+	gain = (int32_t)((((int64_t)bps - chanDefaultBps) * 1000) / chanDefaultBps);
+	magnitude = (gain < 0) ? (uint32_t)-gain : (uint32_t)gain;
+	printf("default map %lu bit/s, %lu channels %lu bit/s, gain %s%lu.%lu%%\r\n", (unsigned long)chanDefaultBps,
+			(unsigned long)CHANCLASS_Count(chanMap), (unsigned long)bps, (gain < 0) ? "-" : "+",
+			(unsigned long)(magnitude / 10), (unsigned long)(magnitude % 10));
+}
+
+/**************************************************************************//**
+* @brief Console: chan [survey|apply|off|compare [seconds]], master only but
+* for printing. survey runs the DTM sweep on the data channels at 1M, then
+* classifies them and applies the map. compare runs the slave's
+* notifications on the PHY in use with the default map, then with the
+* classified one. Without an argument prints the classification
+*****************************************************************************/
+CONSOLE_Status_t consoleChan(int argc, char **argv)
+{
+	uint8_t all[CHANCLASS_MAP_SIZE];
+	uint32_t seconds = MATRIX_SECONDS;
+
+	if(argc == 1)
+	{
+		chanPrint();
+		return CONSOLE_OK;
+	}
+	if(argc > 3 || (argc == 3 && (strcmp(argv[1], "compare") != 0 || !CONSOLE_ParseUint(argv[2], &seconds))))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(roleIsSlave)
+	{
+		return CONSOLE_NOT_READY;
+	}
+
+	if(strcmp(argv[1], "apply") == 0)
+	{
+		chanApplied = chanApply(chanMap);
+		chanPrint();
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "off") == 0)
+	{
+		CHANCLASS_All(all);
+		chanApply(all);
+		chanApplied = false;
+		return CONSOLE_OK;
+	}
+	if(strcmp(argv[1], "survey") != 0 && strcmp(argv[1], "compare") != 0)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	if(connection == 0 || (argv[1][0] == 'c' && phyTiming((uint8_t)phyInUse) == NULL))
+	{
+		return CONSOLE_NOT_READY;
+	}
+	if(runActive() || reconnectCycles != 0)
+	{
+		return CONSOLE_BUSY;
+	}
+
+	if(strcmp(argv[1], "survey") == 0)
+	{
+		dtmRequest(PEER_DTM_SURVEY);
+		return CONSOLE_OK;
+	}
+
+	CHANCLASS_All(all);
+	chanApply(all);
+	chanApplied = false;
+	chanSeconds = seconds;
+	chanComparing = 1;
+	if(!PHYMATRIX_Start(&matrixPort, phyTiming((uint8_t)phyInUse), 1, seconds, (uint8_t)phyInUse, connInterval))
+	{
+		chanComparing = 0;
+		return CONSOLE_USAGE;
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: phy 1m|2m|s2|s8, with the connection timing of phyTimings,
+* the same the PHY_CHANGE button sequence and the PHY matrix use
+*****************************************************************************/
+CONSOLE_Status_t consolePhy(int argc, char **argv)
+{
+	if(argc != 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+	if(connection == 0)
+	{
+		return CONSOLE_NOT_READY;
+	}
+
+	if(phyParse(argv[1]) == NULL)
+	{
+		return CONSOLE_USAGE;
+	}
+	phyRequest(phyParse(argv[1]));
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: interval <min> [max], in 1.25ms units. Applies to the open
+* connection, or to the next one the master opens
+*****************************************************************************/
+CONSOLE_Status_t consoleInterval(int argc, char **argv)
+{
+	uint32_t min;
+	uint32_t max;
+	uint16_t timeout;
+
+	if(argc < 2 || argc > 3 || !CONSOLE_ParseUint(argv[1], &min))
+	{
+		return CONSOLE_USAGE;
+	}
+	max = min;
+	if(argc == 3 && !CONSOLE_ParseUint(argv[2], &max))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(min < 6 || max > 3200 || min > max)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	/* Supervision timeout (10ms units) must cover at least two intervals */
+	timeout = max / 2 + 10;
+	if(timeout < SUPERVISION_TIMEOUT_1MPHY)
+	{
+		timeout = SUPERVISION_TIMEOUT_1MPHY;
+	}
+
+	if(connection != 0)
+	{
+		gecko_cmd_le_connection_set_timing_parameters(connection, min, max, 0, timeout, 0, 0);
+	}
+	else
+	{
+		gecko_cmd_le_gap_set_conn_timing_parameters(min, max, 0, timeout, 0, 0);
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: payload <bytes>, 0 goes back to the size calculated from MTU and PDU
+*****************************************************************************/
+CONSOLE_Status_t consolePayload(int argc, char **argv)
+{
+	uint32_t size;
+
+	if(argc != 2 || !CONSOLE_ParseUint(argv[1], &size) || size > DATA_SIZE)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	payloadSize = size;
+	updateMaxDataSizeNotifications();
+	PSCACHE_Save(PSKEY_PAYLOAD_SIZE, &payloadSize, sizeof(payloadSize));
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Prints nanoseconds as microseconds with one decimal
+*****************************************************************************/
+void microsecondsPrint(uint32_t ns)
+{
+	printf("%lu.%lu", (unsigned long)(ns / 1000), (unsigned long)((ns % 1000) / 100));
+}
+
+/**************************************************************************//**
+* @brief Prints microseconds as milliseconds with one decimal
+*****************************************************************************/
+void millisecondsPrint(uint32_t us)
+{
+	printf("%lu.%lu", (unsigned long)(us / 1000), (unsigned long)((us % 1000) / 100));
+}
+
+/**************************************************************************//**
+* @brief Console: counters
+*****************************************************************************/
+CONSOLE_Status_t consoleCounters(int argc, char **argv)
+{
+	struct gecko_msg_coex_get_counters_rsp_t *coex;
+	uint32_t value[4] = {0};
+	WAKELAT_Stats_t wake;
+
+	(void)argc;
+	(void)argv;
+
+	coex = gecko_cmd_coex_get_counters(0);
+	if(coex->result == 0 && coex->counters.len >= sizeof(value))
+	{
+		memcpy(value, coex->counters.data, sizeof(value));
+	}
+
+	printf("run %u conn %u phy %u mtu %u pdu %u data %u\r\n",
+			runActive(), connection, phyInUse, mtuSize, pduSize, maxDataSizeNotifications);
+	printf("bits %lu ops %lu throughput %lu invalid %u\r\n",
+			(unsigned long)bitsSent, (unsigned long)operationCount, (unsigned long)throughput, invalidData);
+	WAKELAT_GetStats(&wake);
+	printf("wake p%u em1 ", WAKE_PERCENTILE / 10);
+	microsecondsPrint(HISTOGRAM_Percentile(WAKELAT_Histogram(sleepEM1), WAKE_PERCENTILE));
+	printf(" em2 ");
+	microsecondsPrint(HISTOGRAM_Percentile(WAKELAT_Histogram(sleepEM2), WAKE_PERCENTILE));
+	printf(" us sleeps %lu held em1 %lu em2 %lu\r\n", (unsigned long)wake.sleeps,
+			(unsigned long)wake.blocked[sleepEM1], (unsigned long)wake.blocked[sleepEM2]);
+	printf("coex lp req %lu hp req %lu lp deny %lu hp deny %lu edges high water %lu lost %lu\r\n",
+			(unsigned long)value[0], (unsigned long)value[1], (unsigned long)value[2], (unsigned long)value[3],
+			(unsigned long)GPIOINT_EdgeHighWater(), (unsigned long)GPIOINT_EdgeOverflows());
+	printf("uart rx overruns %lu tx dropped %lu tx high water %lu log dropped %lu\r\n",
+			(unsigned long)RETARGET_SerialRxOverruns(), (unsigned long)RETARGET_SerialTxDropped(),
+			(unsigned long)RETARGET_SerialTxHighWater(), (unsigned long)DLOG_Dropped());
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: dump, prints the time-series of the last run as CSV
+*****************************************************************************/
+CONSOLE_Status_t consoleDump(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	printf("ticks,bits,operations\r\n");
+	for(uint32_t i = 0; i < sampleCount; i++)
+	{
+		printf("%lu,%lu,%lu\r\n",
+				(unsigned long)samples[i].time, (unsigned long)samples[i].bits, (unsigned long)samples[i].operations);
+
+		/* No run is active, so waiting for the TX ring costs nothing */
+		if((i % 16) == 15)
+		{
+			RETARGET_SerialFlush();
+		}
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: log, flash log store and erase scheduler counters
+*****************************************************************************/
+CONSOLE_Status_t consoleLog(int argc, char **argv)
+{
+	const FLASHERASE_Stats_t *erase = FLASHERASE_Stats();
+	FLASHLOG_Stats_t stats;
+
+	(void)argc;
+	(void)argv;
+
+	FLASHLOG_GetStats(&stats);
+	printf("records appended %lu dropped %lu written %lu corrupt %lu staged %lu\r\n",
+			(unsigned long)stats.appended, (unsigned long)stats.dropped, (unsigned long)stats.written,
+			(unsigned long)stats.corrupt, (unsigned long)stats.staged);
+	printf("sectors live %lu recycled %lu head %lu offset %lu erases %lu..%lu\r\n",
+			(unsigned long)stats.live, (unsigned long)stats.recycled, (unsigned long)stats.head,
+			(unsigned long)stats.offset, (unsigned long)stats.minErases, (unsigned long)stats.maxErases);
+	printf("erase done %lu suspends %lu max suspend polls %lu rejected %lu\r\n",
+			(unsigned long)erase->erases, (unsigned long)erase->suspends,
+			(unsigned long)erase->maxSuspendPolls, (unsigned long)erase->rejected);
+	printf("flash read %s %lu bytes/s\r\n",
+			MX25_SFDP_ReadName((MX25_SFDP_ReadMode_t)MX25_ReadFastMode()), (unsigned long)MX25_ReadFastRate());
+
+	return CONSOLE_OK;
+}
+
+static uint32_t logDumpCount;
+
+/* FLASHLOG_Walk() callback, one line per record */
+static void logDumpRecord(uint8_t type, uint32_t timestamp, const uint8_t *payload, uint32_t len)
+{
+	printf("%lu,%u", (unsigned long)timestamp, type);
+	for(uint32_t i = 0; i + 4 <= len; i += 4)
+	{
+		uint32_t value;
+
+		memcpy(&value, &payload[i], sizeof(value));
+		printf(",%lu", (unsigned long)value);
+	}
+	printf("\r\n");
+
+	if((++logDumpCount % 16) == 0)
+	{
+		RETARGET_SerialFlush();
+	}
+}
+
+/**************************************************************************//**
+* @brief Console: logdump, prints every stored record as ticks,type,words...
+* Decode RUN_START payloads with tools/flashlog_dump.c on a raw image instead
+*****************************************************************************/
+CONSOLE_Status_t consoleLogDump(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	logDumpCount = 0;
+	printf("ticks,type,payload\r\n");
+	FLASHLOG_Walk(logDumpRecord);
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: logformat, drops every stored record
+*****************************************************************************/
+CONSOLE_Status_t consoleLogFormat(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	FLASHLOG_Format();
+
+	return CONSOLE_OK;
+}
+
+/* ARCHIVE_Walk() callback, one line per summary */
+static void archivePrint(const ARCHIVE_Summary_t *s)
+{
+	printf("%lu,%lu,%u,%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%u\r\n",
+			(unsigned long)s->sequence, (unsigned long)s->timestamp, s->kind, s->phy, s->mode,
+			s->dataSize, s->mtu, s->interval, (unsigned long)s->bits, (unsigned long)s->ticks,
+			(unsigned long)s->throughput, (unsigned long)s->operations,
+			(unsigned long)s->lpRequests, (unsigned long)s->hpRequests,
+			(unsigned long)s->lpDenials, (unsigned long)s->hpDenials, s->invalid);
+	RETARGET_SerialFlush();
+}
+
+/* Times count summaries through the archive and the same 64 bytes through
+ * flash PS. Each archive save is written and verified before the clock
+ * stops, page erases included, so both sides pay their full cost */
+static void archiveBench(uint32_t count)
+{
+	ARCHIVE_Summary_t summary;
+	ARCHIVE_Stats_t before, after;
+	uint32_t mhz = CMU_ClockFreqGet(cmuClock_CORE) / 1000000;
+	uint32_t archiveCycles = 0, archiveMax = 0;
+	uint32_t psCycles = 0, psMax = 0, psErrors = 0;
+
+	memset(&summary, 0, sizeof(summary));
+	summary.kind = ARCHIVE_KIND_BENCH;
+
+	ARCHIVE_Flush();
+	ARCHIVE_GetStats(&before);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t start;
+		uint32_t cycles;
+
+		summary.timestamp = RTCC_CounterGet();
+		summary.operations = i;
+
+		start = DWT->CYCCNT;
+		ARCHIVE_Save(&summary);
+		ARCHIVE_Flush();
+		cycles = DWT->CYCCNT - start;
+		archiveCycles += cycles;
+		archiveMax = (cycles > archiveMax) ? cycles : archiveMax;
+
+		start = DWT->CYCCNT;
+		if(gecko_cmd_flash_ps_save(ARCHIVE_BENCH_PS_KEY, sizeof(summary), (const uint8 *)&summary)->result != 0)
+		{
+			psErrors++;
+		}
+		cycles = DWT->CYCCNT - start;
+		psCycles += cycles;
+		psMax = (cycles > psMax) ? cycles : psMax;
+	}
+	gecko_cmd_flash_ps_erase(ARCHIVE_BENCH_PS_KEY);
+	ARCHIVE_GetStats(&after);
+
+	printf("archive: %lu us avg, %lu us max, %lu page erases, %lu write errors\r\n",
+			(unsigned long)(archiveCycles / count / mhz), (unsigned long)(archiveMax / mhz),
+			(unsigned long)(after.erases + after.forcedErases - before.erases - before.forcedErases),
+			(unsigned long)(after.writeErrors - before.writeErrors));
+	printf("flash ps: %lu us avg, %lu us max, %lu errors\r\n",
+			(unsigned long)(psCycles / count / mhz), (unsigned long)(psMax / mhz), (unsigned long)psErrors);
+}
+
+/**************************************************************************//**
+* @brief Console: archive [bench <count>]. Without arguments prints the
+* archive counters and every stored summary, oldest first, as
+* seq,ticks,kind,phy,mode,data,mtu,interval,bits,run ticks,bit/s,operations,
+* lp req,hp req,lp deny,hp deny,invalid
+*****************************************************************************/
+CONSOLE_Status_t consoleArchive(int argc, char **argv)
+{
+	ARCHIVE_Stats_t stats;
+	uint32_t count;
+
+	if(argc != 1 && argc != 3)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	if(argc == 3)
+	{
+		if(strcmp(argv[1], "bench") != 0 || !CONSOLE_ParseUint(argv[2], &count) || count == 0 || count > 1000)
+		{
+			return CONSOLE_USAGE;
+		}
+		archiveBench(count);
+		return CONSOLE_OK;
+	}
+
+	ARCHIVE_GetStats(&stats);
+	printf("summaries %lu of %lu slots, saved %lu dropped %lu written %lu write errors %lu corrupt %lu\r\n",
+			(unsigned long)stats.records, (unsigned long)stats.slots, (unsigned long)stats.saved,
+			(unsigned long)stats.dropped, (unsigned long)stats.written, (unsigned long)stats.writeErrors,
+			(unsigned long)stats.corrupt);
+	printf("pages erased ahead %lu forced %lu recycled %lu, head %lu queued %lu\r\n",
+			(unsigned long)stats.erases, (unsigned long)stats.forcedErases, (unsigned long)stats.recycled,
+			(unsigned long)stats.head, (unsigned long)stats.queued);
+	printf("seq,ticks,kind,phy,mode,data,mtu,interval,bits,runticks,throughput,operations,lpreq,hpreq,lpdeny,hpdeny,invalid\r\n");
+	ARCHIVE_Walk(archivePrint);
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: ps [flush], persisted counters and PS cache statistics.
+* flush writes every dirty key now instead of at the next idle flush
+*****************************************************************************/
+CONSOLE_Status_t consolePs(int argc, char **argv)
+{
+	PSCACHE_Stats_t stats;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "flush") != 0))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		printf("%lu keys not written\r\n", (unsigned long)PSCACHE_Flush());
+	}
+
+	PSCACHE_GetStats(&stats);
+	printf("boots %lu runs %lu payload %u\r\n", (unsigned long)bootCount, (unsigned long)runCount, payloadSize);
+	printf("loads %lu hits %lu (%lu%%) saves %lu coalesced %lu unchanged %lu bypassed %lu\r\n",
+			(unsigned long)stats.loads, (unsigned long)stats.hits,
+			(unsigned long)(stats.loads ? (100 * stats.hits) / stats.loads : 0),
+			(unsigned long)stats.saves, (unsigned long)stats.coalesced, (unsigned long)stats.unchanged,
+			(unsigned long)stats.bypassed);
+	printf("flushes %lu errors %lu evictions %lu written back %lu dirty %lu\r\n",
+			(unsigned long)stats.flushes, (unsigned long)stats.flushErrors, (unsigned long)stats.evictions,
+			(unsigned long)stats.evictionFlushes, (unsigned long)stats.dirty);
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Prints the AES counters of one direction with the app-level goodput,
+* the payload bytes less the sequence numbers over the last run's time
+*****************************************************************************/
+void cryptoPrint(const char *direction, const PAYLOADCRYPT_Stats_t *stats)
+{
+	uint32_t goodput = 0;
+
+	if(!runActive() && time_elapsed != 0)
+	{
+		goodput = (uint32_t)(((uint64_t)stats->bytes * 8 * 32768) / time_elapsed);
+	}
+
+	printf("%s packets %lu bytes %lu cycles %lu (%lu.%lu/byte) gaps %lu goodput %lu bps\r\n", direction,
+			(unsigned long)stats->packets, (unsigned long)stats->bytes, (unsigned long)stats->cycles,
+			(unsigned long)(stats->bytes ? stats->cycles / stats->bytes : 0),
+			(unsigned long)(stats->bytes ? ((uint64_t)stats->cycles * 10 / stats->bytes) % 10 : 0),
+			(unsigned long)stats->gaps, (unsigned long)goodput);
+}
+
+/**************************************************************************//**
+* @brief Console: crypto [on|off], AES-CTR payloads for the next runs. Both
+* ends must agree. Without an argument prints the counters of the last run
+*****************************************************************************/
+CONSOLE_Status_t consoleCrypto(int argc, char **argv)
+{
+	PAYLOADCRYPT_Stats_t tx;
+	PAYLOADCRYPT_Stats_t rx;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		if(runActive())
+		{
+			return CONSOLE_BUSY;
+		}
+		payloadCrypt = (strcmp(argv[1], "on") == 0);
+		return CONSOLE_OK;
+	}
+
+	PAYLOADCRYPT_GetStats(&tx, &rx);
+	printf("payload encryption %s\r\n", payloadCrypt ? "on" : "off");
+	cryptoPrint("tx", &tx);
+	cryptoPrint("rx", &rx);
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: digest [on|off], random payloads checked with a SHA-256
+* chain for the next runs. Both ends must agree. Without an argument prints
+* this end's digest of the last run and how it compared with the other end's
+*****************************************************************************/
+CONSOLE_Status_t consoleDigest(int argc, char **argv)
+{
+	static const char *states[] = { "no report", "partial report", "match", "MISMATCH" };
+	PAYLOADDIGEST_Report_t report;
+	PAYLOADDIGEST_Result_t result;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		if(runActive())
+		{
+			return CONSOLE_BUSY;
+		}
+		payloadDigest = (strcmp(argv[1], "on") == 0);
+		return CONSOLE_OK;
+	}
+
+	PAYLOADDIGEST_GetReport(&report);
+	PAYLOADDIGEST_GetResult(&result);
+	printf("payload digest %s, %lu packets, %u checkpoints of %lu, sha256 ", payloadDigest ? "on" : "off",
+			(unsigned long)report.packets, report.checkpoints, (unsigned long)report.window);
+	for(uint32_t i = 0; i < sizeof(report.digest); i++)
+	{
+		printf("%02x", report.digest[i]);
+	}
+	printf("\r\n%lu bytes hashed, %lu cycles (%lu/byte)\r\n", (unsigned long)result.bytes, (unsigned long)result.cycles,
+			(unsigned long)(result.bytes ? result.cycles / result.bytes : 0));
+	printf("remote %s", states[result.state]);
+	if(result.state == PAYLOADDIGEST_MATCH || result.state == PAYLOADDIGEST_MISMATCH)
+	{
+		printf(", %lu packets", (unsigned long)result.remotePackets);
+	}
+	if(result.state == PAYLOADDIGEST_MISMATCH && result.badWindow != 0)
+	{
+		printf(", first %lu agree, diverged in the next %lu", (unsigned long)result.lastGood, (unsigned long)result.badWindow);
+	}
+	else if(result.state == PAYLOADDIGEST_MISMATCH)
+	{
+		printf(", first %lu agree, diverged after them", (unsigned long)result.lastGood);
+	}
+	printf("\r\n");
+
+	return CONSOLE_OK;
+}
+
+/* Cycles per byte with one decimal, and bytes per second at the core clock */
+void cryptoBenchPrint(const char *backend, uint32_t cycles, uint32_t size)
+{
+	if(cycles == 0)
+	{
+		printf("  %s -", backend);
+		return;
+	}
+	printf("  %s %lu.%lu c/B %lu B/s", backend, (unsigned long)(cycles / size),
+			(unsigned long)(((uint64_t)cycles * 10 / size) % 10),
+			(unsigned long)(((uint64_t)size * CRYPTOBACKEND_CyclesPerSecond()) / cycles));
+}
+
+/**************************************************************************//**
+* @brief Console: cryptobench [hw|sw]. Without an argument runs the known
+* answer tests on both backends and times every operation on each, with an
+* argument picks the backend the crypto and digest modes use
+*****************************************************************************/
+CONSOLE_Status_t consoleCryptoBench(int argc, char **argv)
+{
+	static const uint32_t sizes[] = { 16, 64, 256, 1024 };
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "hw") != 0 && strcmp(argv[1], "sw") != 0))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
+	if(argc == 2)
+	{
+		CRYPTOBACKEND_Active = (strcmp(argv[1], "hw") == 0) ? &CRYPTOBACKEND_Hardware : &CRYPTOBACKEND_Software;
+		return CONSOLE_OK;
+	}
+
+	printf("using %s, self test hw %lu sw %lu failures\r\n", CRYPTOBACKEND_Active->name,
+			(unsigned long)CRYPTOBACKEND_SelfTest(&CRYPTOBACKEND_Hardware),
+			(unsigned long)CRYPTOBACKEND_SelfTest(&CRYPTOBACKEND_Software));
+	for(uint32_t op = 0; op < CRYPTOBACKEND_OPERATIONS; op++)
+	{
+		for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			printf("%-8s %4lu", CRYPTOBACKEND_OperationName(op), (unsigned long)sizes[s]);
+			cryptoBenchPrint("hw", CRYPTOBACKEND_Bench(&CRYPTOBACKEND_Hardware, op, sizes[s], CRYPTOBENCH_ITERATIONS), sizes[s]);
+			cryptoBenchPrint("sw", CRYPTOBACKEND_Bench(&CRYPTOBACKEND_Software, op, sizes[s], CRYPTOBENCH_ITERATIONS), sizes[s]);
+			printf("\r\n");
+		}
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: energy [csv], energy mode residency and airtime of the
+* current or last run, priced with the default current table. csv prints
+* one line for tools/energy_rank
+*****************************************************************************/
+CONSOLE_Status_t consoleEnergy(int argc, char **argv)
+{
+	static const ENERGY_Currents_t currents = ENERGY_CURRENTS_DEFAULT;
+	ENERGY_Residency_t r;
+	ENERGY_Estimate_t e;
+	uint32_t total = 0;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "csv") != 0))
+	{
+		return CONSOLE_USAGE;
+	}
+
+	ENERGY_GetResidency(&r, RTCC_CounterGet());
+	ENERGY_Estimate(&r, &currents, bitsSent, &e);
+
+	if(argc == 2)
+	{
+		printf("phy,mode,data,pdu,interval,bits,em0,em1,em2,em3,sleeps,txus,rxus\r\n");
+		printf("%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n", phyInUse, runMode, maxDataSizeNotifications,
+				pduSize, connInterval, (unsigned long)bitsSent, (unsigned long)r.ticks[ENERGY_EM0],
+				(unsigned long)r.ticks[ENERGY_EM1], (unsigned long)r.ticks[ENERGY_EM2], (unsigned long)r.ticks[ENERGY_EM3],
+				(unsigned long)r.sleeps[ENERGY_EM0], (unsigned long)r.txMicroseconds, (unsigned long)r.rxMicroseconds);
+		return CONSOLE_OK;
+	}
+
+	for(uint32_t m = 0; m < ENERGY_MODES; m++)
+	{
+		total += r.ticks[m];
+	}
+	for(uint32_t m = 0; m < ENERGY_MODES; m++)
+	{
+		printf("em%lu %lu ms (%lu%%) entered %lu\r\n", (unsigned long)m,
+				(unsigned long)(((uint64_t)r.ticks[m] * 1000) / ENERGY_TICKS_PER_SECOND),
+				(unsigned long)(total ? ((uint64_t)r.ticks[m] * 100) / total : 0), (unsigned long)r.sleeps[m]);
+	}
+	printf("airtime tx %lu us in %lu pdus, rx %lu us in %lu pdus\r\n", (unsigned long)r.txMicroseconds,
+			(unsigned long)r.txPackets, (unsigned long)r.rxMicroseconds, (unsigned long)r.rxPackets);
+	printf("%lu uJ, %lu uA average, radio %lu.%lu%%, %lu bits, %lu.%06lu uJ/bit\r\n", (unsigned long)e.microjoules,
+			(unsigned long)e.averageMicroamps, (unsigned long)(e.radioPermille / 10), (unsigned long)(e.radioPermille % 10),
+			(unsigned long)bitsSent, (unsigned long)(e.picojoulesPerBit / 1000000), (unsigned long)(e.picojoulesPerBit % 1000000));
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: wake, wakeup latency histograms of the current or last run
+* for each energy mode the stack slept in, bucket bounds in ns
+*****************************************************************************/
+CONSOLE_Status_t consoleWake(int argc, char **argv)
+{
+	WAKELAT_Stats_t wake;
+
+	(void)argv;
+
+	if(argc > 1)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	WAKELAT_GetStats(&wake);
+	printf("sleeps %lu, held in em1 %lu em2 %lu by sleep blocks, %lu woken by an rtcc compare\r\n",
+			(unsigned long)wake.sleeps, (unsigned long)wake.blocked[sleepEM1], (unsigned long)wake.blocked[sleepEM2],
+			(unsigned long)wake.compareWakes);
+	for(SLEEP_EnergyMode_t mode = sleepEM1; mode <= sleepEM3; mode++)
+	{
+		const HISTOGRAM_t *h = WAKELAT_Histogram(mode);
+
+		if(h->count == 0)
+		{
+			continue;
+		}
+		printf("em%u %lu wakeups, us min ", (unsigned)mode, (unsigned long)h->count);
+		microsecondsPrint(h->min);
+		printf(" mean ");
+		microsecondsPrint(HISTOGRAM_Mean(h));
+		printf(" p50 ");
+		microsecondsPrint(HISTOGRAM_Percentile(h, 500));
+		printf(" p99 ");
+		microsecondsPrint(HISTOGRAM_Percentile(h, 990));
+		printf(" max ");
+		microsecondsPrint(h->max);
+		printf("\r\n");
+		for(uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+		{
+			if(h->buckets[b] != 0)
+			{
+				printf("  %10lu..%-10lu %lu\r\n", (unsigned long)HISTOGRAM_BucketLow(b),
+						(unsigned long)HISTOGRAM_BucketHigh(b), (unsigned long)h->buckets[b]);
+			}
+		}
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Prints core cycles as microseconds with one decimal
+*****************************************************************************/
+void cyclesPrint(uint32_t cycles, uint32_t coreHz)
+{
+	microsecondsPrint((uint32_t)(((uint64_t)cycles * 1000000000u) / coreHz));
+}
+
+/**************************************************************************//**
+* @brief Console: crit [start|stop], interrupt disabled sections of the
+* current or last run, or of a profile started by hand: the longest ones
+* with their callers, as return addresses to look up in the .map or with
+* addr2line, then the histogram, bucket bounds in core cycles
+*****************************************************************************/
+CONSOLE_Status_t consoleCrit(int argc, char **argv)
+{
+	CRITPROF_Stats_t crit;
+	HISTOGRAM_t h;
+	uint32_t coreHz = CMU_ClockFreqGet(cmuClock_CORE);
+
+	if(argc > 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		if(strcmp(argv[1], "start") == 0)
+		{
+			CRITPROF_Start();
+		}
+		else if(strcmp(argv[1], "stop") == 0)
+		{
+			CRITPROF_Stop();
+		}
+		else
+		{
+			return CONSOLE_USAGE;
+		}
+		return CONSOLE_OK;
+	}
+	if(!CRITPROF_ENABLE)
+	{
+		printf("not built in, CRITPROF_ENABLE is 0\r\n");
+		return CONSOLE_OK;
+	}
+
+	CRITPROF_Get(&crit, &h);
+	printf("%lu sections, %lu yields, us mean ", (unsigned long)h.count, (unsigned long)crit.yields);
+	cyclesPrint(HISTOGRAM_Mean(&h), coreHz);
+	printf(" p99 ");
+	cyclesPrint(HISTOGRAM_Percentile(&h, 990), coreHz);
+	printf(" max ");
+	cyclesPrint(crit.maxCycles, coreHz);
+	printf(" at 0x%08lx, total ", (unsigned long)crit.maxPc);
+	microsecondsPrint((uint32_t)((h.sum * 1000000000u) / coreHz));
+	printf("\r\n");
+	for(uint32_t c = 0; c < CRITPROF_CALLERS && crit.callers[c].pc != 0; c++)
+	{
+		printf("  0x%08lx ", (unsigned long)crit.callers[c].pc);
+		cyclesPrint(crit.callers[c].maxCycles, coreHz);
+		printf(" us\r\n");
+	}
+	for(uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+	{
+		if(h.buckets[b] != 0)
+		{
+			printf("  %10lu..%-10lu %lu\r\n", (unsigned long)HISTOGRAM_BucketLow(b),
+					(unsigned long)HISTOGRAM_BucketHigh(b), (unsigned long)h.buckets[b]);
+		}
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: clock [<profile>], switches the core clock and DC-DC
+* profile between runs. Without an argument lists the profiles, the one in
+* use marked
+*****************************************************************************/
+CONSOLE_Status_t consoleClock(int argc, char **argv)
+{
+	int index;
+
+	if(argc > 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		if(runActive())
+		{
+			return CONSOLE_BUSY;
+		}
+		index = CLOCKPROF_Find(argv[1]);
+		if(index < 0)
+		{
+			return CONSOLE_USAGE;
+		}
+		CLOCKPROF_Apply((uint32_t)index);
+	}
+
+	index = CLOCKPROF_Current();
+	for(uint32_t i = 0; i < CLOCKPROF_Count(); i++)
+	{
+		const CLOCKPROF_Profile_t *profile = CLOCKPROF_Get(i);
+
+		printf("%c %-12s HFXO/%u, dcdc %s\r\n", ((int)i == index) ? '*' : ' ', profile->name,
+				(unsigned)profile->hfDivider, profile->dcdc ? "low noise" : "bypassed");
+	}
+	printf("core %lu Hz\r\n", (unsigned long)CMU_ClockFreqGet(cmuClock_CORE));
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: cpu, where the core's time went in the last run: the main
+* loop, stack calls, passes that found nothing to do and sleep. The last two
+* are the headroom
+*****************************************************************************/
+CONSOLE_Status_t consoleCpu(int argc, char **argv)
+{
+	static const char *shareNames[HEADROOM_SHARES] = { "app", "stack", "spin", "sleep" };
+	HEADROOM_Report_t report;
+
+	(void)argv;
+
+	if(argc > 1)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(HEADROOM_Running())
+	{
+		return CONSOLE_BUSY;
+	}
+
+	HEADROOM_Get(&report);
+	if(report.ticks == 0)
+	{
+		return CONSOLE_NOT_READY;
+	}
+	printf("%lu Hz, ", (unsigned long)report.coreHz);
+	millisecondsPrint((uint32_t)(((uint64_t)report.ticks * 1000000) / 32768));
+	printf(" ms, %lu passes, %lu idle\r\n", (unsigned long)report.passes, (unsigned long)report.idlePasses);
+	for(uint32_t s = 0; s < HEADROOM_SHARES; s++)
+	{
+		printf("  %-6s %3u.%u%%\r\n", shareNames[s], report.permille[s] / 10, report.permille[s] % 10);
+	}
+	printf("headroom %u.%u%%, needs about %lu.%lu MHz\r\n", report.headroomPermille / 10, report.headroomPermille % 10,
+			(unsigned long)(report.neededHz / 1000000), (unsigned long)((report.neededHz / 100000) % 10));
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Prints a value to one decimal, printf has no floating point here
+*****************************************************************************/
+void tenthsPrint(float value)
+{
+	int32_t tenths = (int32_t)((value < 0) ? value * 10 - 0.5f : value * 10 + 0.5f);
+	uint32_t magnitude = (tenths < 0) ? (uint32_t)-tenths : (uint32_t)tenths;
+
+	printf("%s%lu.%lu", (tenths < 0) ? "-" : "", (unsigned long)(magnitude / 10), (unsigned long)(magnitude % 10));
+}
+
+/**************************************************************************//**
+* @brief Console: stats, RSSI, throughput of each second and coex denial
+* rate of the current or last run: mean, standard deviation, extremes, p95
+* and p99. See samplestats.h
+*****************************************************************************/
+CONSOLE_Status_t consoleStats(int argc, char **argv)
+{
+	static const char *names[] = { "rssi dBm", "kbit/s", "denials permille" };
+	const SAMPLESTATS_Series_t *series[] = { &statsRssi, &statsThroughput, &statsDenials };
+	SAMPLESTATS_Summary_t summary;
+
+	(void)argv;
+
+	if(argc > 1)
+	{
+		return CONSOLE_USAGE;
+	}
+
+	for(uint32_t i = 0; i < sizeof(series) / sizeof(series[0]); i++)
+	{
+		SAMPLESTATS_Get(series[i], &summary);
+		printf("%s: %lu samples", names[i], (unsigned long)summary.count);
+		if(summary.count != 0)
+		{
+			printf(", mean ");
+			tenthsPrint(summary.mean);
+			printf(" std ");
+			tenthsPrint(summary.std);
+			printf(", min %d max %d, p95 ", summary.min, summary.max);
+			tenthsPrint(summary.p95);
+			printf(" p99 ");
+			tenthsPrint(summary.p99);
+		}
+		printf("\r\n");
+	}
+
+	return CONSOLE_OK;
+}
+
+/**************************************************************************//**
+* @brief Console: target [any|<address>], the address the master connects
+* to besides any device with the tester's name or service, as printed
+* most significant byte first. Without an argument prints the scan filter
+* counters
+*****************************************************************************/
+CONSOLE_Status_t consoleTarget(int argc, char **argv)
+{
+	ADVFILTER_Stats_t stats;
+	unsigned int b[6];
+	uint8_t address[6];
+
+	if(argc > 2)
+	{
+		return CONSOLE_USAGE;
+	}
+	if(argc == 2)
+	{
+		if(strcmp(argv[1], "any") == 0)
+		{
+			ADVFILTER_SetAddress(NULL);
+			return CONSOLE_OK;
+		}
+		if(sscanf(argv[1], "%2x:%2x:%2x:%2x:%2x:%2x", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 6)
+		{
+			return CONSOLE_USAGE;
+		}
+		for(uint32_t i = 0; i < 6; i++)
 		{
-			if(roleIsSlave) {
-				/* PB1 released */
-				gecko_external_signal(INDICATIONS_END);
-			}
-			else
-			{
-				gecko_external_signal(WRITE_NO_RESPONSE_END);
-			}
+			address[i] = (uint8_t)b[i];
 		}
+		ADVFILTER_SetAddress(address);
+		return CONSOLE_OK;
 	}
-}
 
+	ADVFILTER_GetStats(&stats);
+	printf("reports %lu cached %lu parsed %lu malformed %lu matches %lu evicted %lu\r\n",
+			(unsigned long)stats.reports, (unsigned long)stats.cacheHits, (unsigned long)stats.parsed,
+			(unsigned long)stats.malformed, (unsigned long)stats.matches, (unsigned long)stats.evictions);
+
+	return CONSOLE_OK;
+}
 
 /**************************************************************************//**
-* @brief Function to generate circular data (0-255) in the data payload
+* @brief Console: setup [clear], connection setup milestones over the cycles
+* since boot or the last clear, in ms from the start of the cycle and from
+* the milestone before
 *****************************************************************************/
-void generate_data_notifications(void){
+CONSOLE_Status_t consoleSetup(int argc, char **argv)
+{
+	CONNSETUP_Stats_t stats;
 
-	throughput_array_notifications[0] = throughput_array_notifications[maxDataSizeNotifications-1] + 1;
+	if(argc == 2 && strcmp(argv[1], "clear") == 0)
+	{
+		CONNSETUP_Clear();
+		return CONSOLE_OK;
+	}
+	if(argc > 1)
+	{
+		return CONSOLE_USAGE;
+	}
 
-	for(int i = 1; i<maxDataSizeNotifications; i++)
+	CONNSETUP_GetStats(&stats);
+	printf("cycles %lu completed %lu, abandoned after", (unsigned long)stats.cycles, (unsigned long)stats.completed);
+	for(CONNSETUP_Milestone_t m = CONNSETUP_START; m < CONNSETUP_FIRST_DATA; m++)
 	{
-		throughput_array_notifications[i] = throughput_array_notifications[i-1] + 1;
+		printf(" %s %lu", CONNSETUP_Name(m), (unsigned long)stats.stalled[m]);
+	}
+	printf("\r\n");
+
+	for(CONNSETUP_Milestone_t m = CONNSETUP_FOUND; m < CONNSETUP_MILESTONES; m++)
+	{
+		const HISTOGRAM_t *elapsed = CONNSETUP_Elapsed(m);
+		const HISTOGRAM_t *phase = CONNSETUP_Phase(m);
+
+		if(elapsed->count == 0)
+		{
+			continue;
+		}
+		printf("%-13s %4lu, ms since start min ", CONNSETUP_Name(m), (unsigned long)elapsed->count);
+		millisecondsPrint(elapsed->min);
+		printf(" mean ");
+		millisecondsPrint(HISTOGRAM_Mean(elapsed));
+		printf(" p90 ");
+		millisecondsPrint(HISTOGRAM_Percentile(elapsed, 900));
+		printf(" max ");
+		millisecondsPrint(elapsed->max);
+		printf(", phase min ");
+		millisecondsPrint(phase->min);
+		printf(" mean ");
+		millisecondsPrint(HISTOGRAM_Mean(phase));
+		printf(" p90 ");
+		millisecondsPrint(HISTOGRAM_Percentile(phase, 900));
+		printf(" max ");
+		millisecondsPrint(phase->max);
+		printf("\r\n");
+		RETARGET_SerialFlush();
 	}
-}
 
+	return CONSOLE_OK;
+}
 
 /**************************************************************************//**
-* @brief Function to generate circular data (0-255) in the data payload
+* @brief Console: reconnect <cycles> [hold ms]|stop, master only. Connects,
+* holds the link for the hold time once the first data came and closes it,
+* cycles times. A cycle not done within RECONNECT_TIMEOUT is abandoned. The
+* setup command shows the distributions
 *****************************************************************************/
-void generate_data_indications(void){
+CONSOLE_Status_t consoleReconnect(int argc, char **argv)
+{
+	uint32_t cycles;
+	uint32_t hold = RECONNECT_HOLD;
 
-	throughput_array_indications[0] = throughput_array_indications[maxDataSizeIndications-1] + 1;
+	if(argc == 2 && strcmp(argv[1], "stop") == 0)
+	{
+		reconnectCycles = 0;
+		gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_RECONNECT_HANDLE, 0);
+		return CONSOLE_OK;
+	}
+	if(argc < 2 || argc > 3 || !CONSOLE_ParseUint(argv[1], &cycles) || cycles == 0
+			|| (argc == 3 && (!CONSOLE_ParseUint(argv[2], &hold) || hold > 60000)))
+	{
+		return CONSOLE_USAGE;
+	}
+	if(roleIsSlave)
+	{
+		return CONSOLE_NOT_READY;
+	}
+	if(runActive())
+	{
+		return CONSOLE_BUSY;
+	}
 
-	for(int i = 1; i<maxDataSizeIndications; i++)
+	reconnectHold = (hold * 32768) / 1000;
+	if(openConnection != 0)
+	{
+		/* The closed event starts the first cycle */
+		reconnectCycles = cycles;
+		gecko_cmd_le_connection_close(openConnection);
+	}
+	else
 	{
-		throughput_array_indications[i] = throughput_array_indications[i-1] + 1;
+		/* Restart the scanning cycle, so it is timed from now */
+		reconnectCycles = 0;
+		CONNSETUP_Start(RTCC_CounterGet());
+		reconnectCycles = cycles;
+		gecko_cmd_hardware_set_soft_timer(RECONNECT_TIMEOUT, SOFT_TIMER_RECONNECT_HANDLE, 1);
 	}
+
+	return CONSOLE_OK;
 }
 
+CONSOLE_Status_t consoleHelp(int argc, char **argv);
+
+const CONSOLE_Command_t consoleCommands[] = {
+	{ "help",		"",									consoleHelp },
+	{ "start",		"[notify|indicate|write] [seconds]",	consoleStart },
+	{ "stop",		"",									consoleStop },
+	{ "phy",		"1m|2m|s2|s8",						consolePhy },
+	{ "interval",	"<min> [max] (1.25ms units)",		consoleInterval },
+	{ "payload",	"<bytes> (0 = auto)",				consolePayload },
+	{ "counters",	"",									consoleCounters },
+	{ "dump",		"",									consoleDump },
+	{ "log",		"",									consoleLog },
+	{ "logdump",	"",									consoleLogDump },
+	{ "logformat",	"",									consoleLogFormat },
+	{ "archive",	"[bench <count>]",					consoleArchive },
+	{ "ps",			"[flush]",							consolePs },
+	{ "crypto",		"[on|off]",							consoleCrypto },
+	{ "digest",		"[on|off]",							consoleDigest },
+	{ "cryptobench",	"[hw|sw]",							consoleCryptoBench },
+	{ "energy",		"[csv]",							consoleEnergy },
+	{ "wake",		"",									consoleWake },
+	{ "crit",		"[start|stop]",						consoleCrit },
+	{ "clock",		"[<profile>]",						consoleClock },
+	{ "cpu",		"",									consoleCpu },
+	{ "stats",		"",									consoleStats },
+	{ "bridge",		"[seconds|stats]",					consoleBridge },
+	{ "sink",		"[on|off|stats]",					consoleSink },
+	{ "target",		"[any|<address>]",					consoleTarget },
+	{ "setup",		"[clear]",							consoleSetup },
+	{ "reconnect",	"<cycles> [hold ms]|stop",			consoleReconnect },
+	{ "matrix",		"[run [seconds] [1m|2m|s2|s8]...|stop]",	consoleMatrix },
+	{ "dtm",		"[sweep|stop|csv]",					consoleDtm },
+	{ "chan",		"[survey|apply|off|compare [seconds]]",	consoleChan },
+};
+
 /**************************************************************************//**
-* @brief Processes advertisement packets looking for "Throughput Tester" device name
+* @brief Console: help
 *****************************************************************************/
-int process_scan_response(struct gecko_msg_le_gap_scan_response_evt_t *pResp)
+CONSOLE_Status_t consoleHelp(int argc, char **argv)
 {
-	/* Decoding advertising packets is done here. The list of AD types can be found
-	 * at: https://www.bluetooth.com/specifications/assigned-numbers/Generic-Access-Profile */
-
-    int i = 0;
-    int ad_match_found = 0;
-	int ad_len;
-    int ad_type;
+	(void)argc;
+	(void)argv;
 
-    while (i < (pResp->data.len - 1))
-    {
-        ad_len  = pResp->data.data[i];
-        ad_type = pResp->data.data[i+1];
-
-        if (ad_type == 0x09)
-        {
-            /* type 0x09 = Complete Local Name */
-
-        	/* Check if device name is Throughput Tester */
-        	if(memcmp(pResp->data.data+i+2, deviceNameString, 17) == 0)
-			{
-        		ad_match_found = 1;
-        		break;
-			}
-        }
-
-        /* Jump to next AD record */
-        i = i + ad_len + 1;
-    }
+	for(uint32_t i = 0; i < sizeof(consoleCommands) / sizeof(consoleCommands[0]); i++)
+	{
+		printf("%s %s\r\n", consoleCommands[i].name, consoleCommands[i].usage);
+	}
 
-    return(ad_match_found);
+	return CONSOLE_OK;
 }
 
 /**************************************************************************//**
-* @brief Does a few things before initiating data transmissions. Read RTCC, disable
-* display refresh in master side and turn ON LED indicating data transmission
+* @brief Serial RX went idle, called from interrupt context. The line is parsed
+* from the main loop, between stack events, so an active run is not held up
 *****************************************************************************/
-void dataTransmissionStart(void)
+void consoleRxIdle(void)
 {
-	bitsSent = 0;
-	throughput = 0;
-	time_elapsed = RTCC_CounterGet();
-
-	/* Turn OFF Display refresh on master side */
-	gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &displayRefreshOff);
-
-	/* Stop display refresh */
-	gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
-
-#ifdef USE_LED_FOR_DATA_SENDING_SIGNALING
-	/* Turn ON data LED */
-	GPIO_PinOutSet(BSP_LED1_PORT,BSP_LED1_PIN);
-#endif
+	gecko_external_signal(CONSOLE_INPUT);
 }
 
 /**************************************************************************//**
-* @brief Does a few after data transmissions ended. Calculate transmission time,
-* enable display refresh in master side and turn OFF LED indicating data transmission
+* @brief Feeds the received characters to the console and reports the result
+* of every completed line
 *****************************************************************************/
-void dataTransmissionEnd(void)
+void consolePoll(void)
 {
-	time_elapsed = RTCC_CounterGet() - time_elapsed;
-
-	/* Turn ON Display on master side - stack is probably still busy pushing the last few notifications out so we need to check output */
-	while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_display_refresh, 1, &displayRefreshOn)->result!=0);
-
-	/* Resume display refresh - stack is probably still busy pushing the last few notifications out so we need to check output */
-	while(gecko_cmd_hardware_set_soft_timer(32768, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
+	CONSOLE_Status_t status;
+	int c;
 
-#ifdef USE_LED_FOR_DATA_SENDING_SIGNALING
-	/* Turn ON data LED */
-	GPIO_PinOutClear(BSP_LED1_PORT,BSP_LED1_PIN);
-#endif
-	/* Calculate throughput */
-	throughput = (uint32_t)((float)bitsSent / (float)((float)time_elapsed / (float)32768));
+	/* A bridge started by the line takes the rest of the input */
+	while(!bridging && (c = RETARGET_ReadChar()) >= 0)
+	{
+		status = CONSOLE_Input(&console, (char)c);
+		if(status != CONSOLE_PENDING && status != CONSOLE_EMPTY)
+		{
+			printf("%s\r\n", CONSOLE_StatusString(status));
+		}
+	}
 }
 
 /**
@@ -588,6 +3145,7 @@ void dataTransmissionEnd(void)
 void main(void)
 {
   struct gecko_msg_system_get_counters_rsp_t *getCounters;
+  uint8_t flashId;
 
   // Initialize device
   initMcu();
@@ -599,6 +3157,7 @@ void main(void)
 
   // Initialize stack
   gecko_init(&config);
+  ENERGY_Init();
 
 #ifdef USE_LED_FOR_CONNECTION_SIGNALING
   /* Configure LED0 to indicate if connection is established or not */
@@ -638,18 +3197,66 @@ void main(void)
   GRAPHICS_Init();
 #endif
 
+  /* The last main loop pass found no event and the stack took no data */
+  bool passIdle = false;
+
   while (1) {
     /* Event pointer for handling events */
     struct gecko_cmd_packet* evt;
+    bool sent;
 
-    if(notifications_enabled && sendNotifications)
+    /* CRITPROF_Start() has the cycle counter running by the time a run starts */
+    HEADROOM_Pass(DWT->CYCCNT, passIdle);
+    passIdle = false;
+
+    if(bridging)
     {
-    	evt = gecko_peek_event();
+    	UARTBRIDGE_Result_t result;
 
-    	if(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_notifications, maxDataSizeNotifications, throughput_array_notifications)->result == 0)
+    	HEADROOM_Stack(DWT->CYCCNT);
+    	evt = gecko_peek_event();
+    	HEADROOM_App(DWT->CYCCNT);
+
+    	if(evt == NULL)
+    	{
+    		edgesDrain();
+    		FLASHLOG_Poll();
+    	}
+
+    	result = UARTBRIDGE_Poll(RTCC_CounterGet());
+    	passIdle = result != UARTBRIDGE_SENT && evt == NULL;
+    	if(result == UARTBRIDGE_ESCAPED)
+    	{
+    		bridgeEnd(true);
+    	}
+    }
+    else if(notifications_enabled && sendNotifications)
+    {
+    	HEADROOM_Stack(DWT->CYCCNT);
+    	evt = gecko_peek_event();
+    	HEADROOM_App(DWT->CYCCNT);
+
+    	/* Flash log work fits in the gaps between stack events */
+    	if(evt == NULL)
+    	{
+    		edgesDrain();
+    		FLASHLOG_Poll();
+    	}
+
+    	HEADROOM_Stack(DWT->CYCCNT);
+    	sent = gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_notifications, maxDataSizeNotifications, notificationsPayload())->result == 0;
+    	HEADROOM_App(DWT->CYCCNT);
+    	passIdle = !sent && evt == NULL;
+    	if(sent)
 		{
+    		setupFirstData();
     		bitsSent += (maxDataSizeNotifications*8);
     		operationCount++;
+    		energyPacket(maxDataSizeNotifications + 3, true);
+    		if(payloadDigest)
+    		{
+    			digestAdd(throughput_array_notifications, maxDataSizeNotifications);
+    		}
     		generate_data_notifications();
 #ifdef SEND_FIXED_TRANSFER_COUNT
     		if(++transferCount == SEND_FIXED_TRANSFER_COUNT) {
@@ -663,12 +3270,30 @@ void main(void)
     }
     else if(sendWriteNoResponse)
     {
+    	HEADROOM_Stack(DWT->CYCCNT);
     	evt = gecko_peek_event();
-
-    	if(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_throughput_write_no_response, maxDataSizeNotifications, throughput_array_notifications)->result == 0)
+    	HEADROOM_App(DWT->CYCCNT);
+
+    	if(evt == NULL)
+    	{
+    		edgesDrain();
+    		FLASHLOG_Poll();
+    	}
+
+    	HEADROOM_Stack(DWT->CYCCNT);
+    	sent = gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_throughput_write_no_response, maxDataSizeNotifications, notificationsPayload())->result == 0;
+    	HEADROOM_App(DWT->CYCCNT);
+    	passIdle = !sent && evt == NULL;
+    	if(sent)
 		{
+    		setupFirstData();
     		bitsSent += (maxDataSizeNotifications*8);
     		operationCount++;
+    		energyPacket(maxDataSizeNotifications + 3, true);
+    		if(payloadDigest)
+    		{
+    			digestAdd(throughput_array_notifications, maxDataSizeNotifications);
+    		}
     		generate_data_notifications();
 #ifdef SEND_FIXED_TRANSFER_COUNT
     		if(++transferCount == SEND_FIXED_TRANSFER_COUNT) {
@@ -679,10 +3304,50 @@ void main(void)
 #endif
 		}
     }
+    else if(UARTSINK_Hold(RTCC_CounterGet()))
+    {
+    	/* The UART has no room for another payload, stack events wait for it.
+    	 * See uartsink.h. Rather than spin, sleep in EM1, where the USART and
+    	 * the LDMA keep running, until an interrupt: the LDMA freeing room or
+    	 * the radio. Interrupts are off across the last check so a completion
+    	 * just before the WFI still wakes it */
+    	CORE_DECLARE_IRQ_STATE;
+
+    	CORE_ENTER_CRITICAL();
+    	if(UARTSINK_Hold(RTCC_CounterGet()))
+    	{
+    		EMU_EnterEM1();
+    	}
+    	CORE_EXIT_CRITICAL();
+    	passIdle = true;
+    	continue;
+    }
     else
     {
+    	/* Ship deferred log records and program the flash log while there is nothing else to do */
+    	if(!gecko_event_pending())
+    	{
+    		/* Log lines would land in the middle of a sink's stream */
+    		if(!UARTSINK_Running())
+    		{
+    			DLOG_Flush();
+    		}
+    		edgesDrain();
+    		FLASHLOG_Poll();
+    		ARCHIVE_Poll(connection == 0);
+    		PSCACHE_Poll();
+    	}
+
     	/* Check for stack event. */
+    	HEADROOM_Stack(DWT->CYCCNT);
     	evt = gecko_wait_event();
+    	HEADROOM_App(DWT->CYCCNT);
+    }
+
+    /* A peek that found nothing leaves no event to handle */
+    if(evt == NULL)
+    {
+    	continue;
     }
 
     /* Handle events */
@@ -692,7 +3357,36 @@ void main(void)
        * Here the system is set to start advertising immediately after boot procedure. */
       case gecko_evt_system_boot_id:
 
+    	  /* Connection setup is timed from here */
+    	  CONNSETUP_Init(setupDone);
+    	  setupCycleStart();
+
     	  RETARGET_SerialInit();
+    	  DLOG_Init();
+    	  CONSOLE_Init(&console, consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]));
+    	  RETARGET_SerialRxIdleCallbackSet(consoleRxIdle);
+
+    	  /* initBoard() left the flash in deep power down */
+    	  MX25_init();
+    	  MX25_RES(&flashId);
+    	  MX25_ReadFastConfigure();
+    	  DLOG("flash read mode %u, %u bytes/s\r\n", MX25_ReadFastMode(), MX25_ReadFastRate());
+    	  if(!FLASHLOG_Init())
+    	  {
+    		  DLOG("flash log: no flash\r\n");
+    	  }
+    	  FLASHLOG_Append(FLASHLOG_TYPE_BOOT, RTCC_CounterGet(), NULL, 0);
+
+    	  /* Coex REQUEST and GRANT edges go to the flash log */
+    	  GPIOINT_Init();
+    	  edgeQueuePin(BSP_COEX_REQ_PORT, BSP_COEX_REQ_PIN);
+    	  edgeQueuePin(BSP_COEX_GNT_PORT, BSP_COEX_GNT_PIN);
+    	  if(!ARCHIVE_Init())
+    	  {
+    		  DLOG("archive: no space reserved\r\n");
+    	  }
+    	  psRestore();
+    	  PAYLOADCRYPT_Init();
     	  gecko_cmd_hardware_set_soft_timer(3*32768,COEX_COUNTER_UPDATE,0);
 			sprintf(connIntervalString+7, "%04u", 0);
 			sprintf(phyInUseString+5, "%s", "1M");
@@ -725,6 +3419,8 @@ void main(void)
 				gecko_cmd_le_gap_set_conn_timing_parameters(CONN_INTERVAL_1MPHY_MIN, CONN_INTERVAL_1MPHY_MAX, SLAVE_LATENCY_1MPHY, SUPERVISION_TIMEOUT_1MPHY, 0, 0);
 
 				/* Set scan parameters and start scanning */
+				ADVFILTER_Init(&(ADVFILTER_Criteria_t){ .name = deviceNameString, .nameLen = sizeof(deviceNameString) - 1,
+						.uuid = throughputServiceUuid, .uuidLen = sizeof(throughputServiceUuid) });
 
 				gecko_cmd_le_gap_set_discovery_timing(1, SCAN_INTERVAL, SCAN_WINDOW);
 
@@ -742,6 +3438,8 @@ void main(void)
     	  /* Turn ON connection LED */
     	  GPIO_PinOutSet(BSP_LED0_PORT,BSP_LED0_PIN);
 #endif
+    	  openConnection = evt->data.evt_le_connection_opened.connection;
+    	  CONNSETUP_Mark(CONNSETUP_OPENED, RTCC_CounterGet());
     	  break;
 
       case gecko_evt_le_connection_closed_id:
@@ -750,8 +3448,12 @@ void main(void)
     	    GPIO_PinOutClear(BSP_LED0_PORT,BSP_LED0_PIN);
 #endif
 
+			PHYMATRIX_Closed();
+			bridgeEnd(false);
+
 			/* Clear all flags and relevant parameters */
 			connection = 0;
+			openConnection = 0;
 			mtuSize = 0;
 			pduSize = 0;
 			maxDataSizeNotifications = 0;
@@ -779,22 +3481,23 @@ void main(void)
 			memset(throughput_array_notifications, 0, DATA_SIZE);
 			memset(throughput_array_indications, 0, DATA_SIZE);
 
-			if(roleIsSlave) {
+			if(dtmPending) {
+				/* Both boards take the close as the common start of the DTM sweep */
+				dtmBegin();
+			} else if(roleIsSlave) {
 				/* Check if need to boot to dfu mode */
 				if (boot_to_dfu) {
 					/* Enter to DFU OTA mode */
+					PSCACHE_Flush();
 					gecko_cmd_system_reset(2);
 				}
 				else {
 					/* Restart advertising after client has disconnected */
-
-					gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_undirected_connectable);
-
+					linkRestart();
 				}
 			} else {
 				/* Back to scanning */
-
-				gecko_cmd_le_gap_start_discovery(1, le_gap_discover_generic);
+				linkRestart();
 			}
         break;
 
@@ -807,6 +3510,7 @@ void main(void)
 			  {
 				  notifications_enabled = true;
 				  notifyString = (char*)notifyEnabledString;
+				  CONNSETUP_Mark(CONNSETUP_CCCD_NOTIFY, RTCC_CounterGet());
 			  }
 
 			  if(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config &&
@@ -825,6 +3529,7 @@ void main(void)
 			  {
 				  indications_enabled = true;
 				  indicateString = (char*)indicateEnabledString;
+				  CONNSETUP_Mark(CONNSETUP_CCCD_INDICATE, RTCC_CounterGet());
 			  }
 
 			  if(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config &&
@@ -834,11 +3539,29 @@ void main(void)
 				  indicateString = (char*)indicateDisabledString;
 			  }
 
-			  if(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_confirmation)
+			  if(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_confirmation && digestTrailerInFlight)
+			  {
+				  /* Part of the digest trailer was acknowledged, send the rest */
+				  uint16_t len = PAYLOADDIGEST_TrailerNext(digest_trailer, maxDataSizeIndications);
+
+				  digestTrailerInFlight = (len != 0);
+				  if(len != 0)
+				  {
+					  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, len, digest_trailer)->result != 0);
+				  }
+			  }
+			  else if(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_confirmation)
 			  {
 				  /* Last indicate operation was acknowledged, send more data */
+				  setupFirstData();
 				  bitsSent += ((maxDataSizeIndications)*8);
 				  operationCount++;
+				  energyPacket(maxDataSizeIndications + 3, true);
+				  energyPacket(1, false);
+				  if(payloadDigest)
+				  {
+					  digestAdd(throughput_array_indications, maxDataSizeIndications);
+				  }
 				  generate_data_indications();
 #ifdef SEND_FIXED_TRANSFER_COUNT
 				  if(++transferCount == SEND_FIXED_TRANSFER_COUNT) {
@@ -849,7 +3572,18 @@ void main(void)
 #endif
 				  if(indications_enabled && sendIndications)
 				  {
-					  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, throughput_array_indications)->result != 0);
+					  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsPayload())->result != 0);
+				  }
+				  else if(indications_enabled && payloadDigest)
+				  {
+					  /* That was the last one of the run, the trailer goes next */
+					  uint16_t len = PAYLOADDIGEST_TrailerNext(digest_trailer, maxDataSizeIndications);
+
+					  digestTrailerInFlight = (len != 0);
+					  if(len != 0)
+					  {
+						  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, len, digest_trailer)->result != 0);
+					  }
 				  }
 			  }
 		  }
@@ -859,15 +3593,47 @@ void main(void)
       case gecko_evt_gatt_characteristic_value_id:
 
     	  /* Data received */
+    	  setupFirstData();
+    	  if(evt->data.evt_gatt_characteristic_value.att_opcode == gatt_read_response)
+    	  {
+    		  /* The reconnect loop's read, not throughput data */
+    		  break;
+    	  }
     	  if(evt->data.evt_gatt_characteristic_value.att_opcode == gatt_handle_value_indication) {
     		  gecko_cmd_gatt_send_characteristic_confirmation(evt->data.evt_gatt_characteristic_value.connection);
     	  }
 
+    	  if(payloadDigest && PAYLOADDIGEST_Receive(evt->data.evt_gatt_characteristic_value.value.data, evt->data.evt_gatt_characteristic_value.value.len))
+    	  {
+    		  /* Digest trailer, not data */
+    		  break;
+    	  }
+
     	  bitsSent += (evt->data.evt_gatt_characteristic_value.value.len*8);
     	  operationCount++;
+    	  energyPacket(evt->data.evt_gatt_characteristic_value.value.len + 3, false);
+    	  if(evt->data.evt_gatt_characteristic_value.att_opcode == gatt_handle_value_indication)
+    	  {
+    		  energyPacket(1, true);
+    	  }
+
+    	  if(payloadCrypt)
+    	  {
+    		  PAYLOADCRYPT_Decrypt((evt->data.evt_gatt_characteristic_value.att_opcode == gatt_handle_value_indication) ? PAYLOADCRYPT_STREAM_INDICATE : PAYLOADCRYPT_STREAM_NOTIFY,
+    				  evt->data.evt_gatt_characteristic_value.value.data, evt->data.evt_gatt_characteristic_value.value.len);
+    	  }
+
+    	  /* Out of the serial port too during a sink run */
+    	  UARTSINK_Put(evt->data.evt_gatt_characteristic_value.value.data, evt->data.evt_gatt_characteristic_value.value.len, RTCC_CounterGet());
+
+    	  if(payloadDigest)
+    	  {
+    		  digestAdd(evt->data.evt_gatt_characteristic_value.value.data, evt->data.evt_gatt_characteristic_value.value.len);
+    		  break;
+    	  }
 
-    	  /* Validate the data */
-    	  for(int i=1; i<evt->data.evt_gatt_characteristic_value.value.len; i++)
+    	  /* Validate the data, after the sequence number when encrypted */
+    	  for(int i=rampStart(); i<evt->data.evt_gatt_characteristic_value.value.len; i++)
     	  {
     		  if(evt->data.evt_gatt_characteristic_value.value.data[i] != (uint8)((evt->data.evt_gatt_characteristic_value.value.data[i-1])+1))
     		  {
@@ -882,12 +3648,46 @@ void main(void)
 
     	  if(evt->data.evt_gatt_server_attribute_value.attribute == gattdb_display_refresh)
     	  {
+			  /* The master's PHY matrix asks the slave for the data it measures */
+			  if(evt->data.evt_gatt_server_attribute_value.value.data[0] == PEER_STREAM_START)
+			  {
+				  if(roleIsSlave && !runActive())
+				  {
+					  gecko_external_signal(NOTIFICATIONS_START);
+				  }
+			  }
+			  else if(evt->data.evt_gatt_server_attribute_value.value.data[0] == PEER_STREAM_END)
+			  {
+				  if(roleIsSlave && sendNotifications)
+				  {
+					  gecko_external_signal(NOTIFICATIONS_END);
+				  }
+			  }
+			  else if(evt->data.evt_gatt_server_attribute_value.value.data[0] == PEER_DTM_SWEEP
+					  || evt->data.evt_gatt_server_attribute_value.value.data[0] == PEER_DTM_SURVEY)
+			  {
+				  if(roleIsSlave && !runActive())
+				  {
+					  /* The closed event starts the sweep, on the master too */
+					  dtmPending = true;
+					  dtmSurvey = (evt->data.evt_gatt_server_attribute_value.value.data[0] == PEER_DTM_SURVEY);
+					  dtmSync = connInterval * 82;
+					  gecko_cmd_le_connection_close(openConnection);
+				  }
+			  }
 			  /* Display ON/OFF state changes */
-			  if(evt->data.evt_gatt_server_attribute_value.value.data[0] == 0)
+			  else if(evt->data.evt_gatt_server_attribute_value.value.data[0] == 0)
 			  {
 				  bitsSent = 0;
 				  throughput = 0;
 				  time_elapsed = RTCC_CounterGet();
+				  ENERGY_Start(time_elapsed);
+				  WAKELAT_Start();
+				  CRITPROF_Start();
+				  HEADROOM_Start(DWT->CYCCNT, time_elapsed, CMU_ClockFreqGet(cmuClock_CORE));
+				  samplingStart();
+				  PAYLOADCRYPT_Start();
+				  PAYLOADDIGEST_Start(0);
 				  /* Disable display refresh */
 				  gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
 				  /* Turn ON data LED */
@@ -897,6 +3697,11 @@ void main(void)
 			  else
 			  {
 				  time_elapsed = RTCC_CounterGet() - time_elapsed;
+				  ENERGY_Stop(RTCC_CounterGet());
+				  WAKELAT_Stop();
+				  CRITPROF_Stop();
+				  HEADROOM_Stop(DWT->CYCCNT, RTCC_CounterGet());
+				  samplingStop();
 				  /* Enable display refresh */
 				  gecko_cmd_hardware_set_soft_timer(32768, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
 				  /* Turn OFF data LED */
@@ -904,17 +3709,39 @@ void main(void)
 				  /* Calculate throughput */
 				  throughput = (uint32_t)((float)bitsSent / (float)((float)time_elapsed / (float)32768));
 				  //throughput = bitsSent / (time_elapsed / 32768);
+				  PHYMATRIX_RunEnded();
 
 			  }
     	  }
 
     	  if(evt->data.evt_gatt_server_attribute_value.attribute == gattdb_throughput_write_no_response)
     	  {
+        	  if(payloadDigest && PAYLOADDIGEST_Receive(evt->data.evt_gatt_server_attribute_value.value.data, evt->data.evt_gatt_server_attribute_value.value.len))
+        	  {
+        		  /* Digest trailer, not data */
+        		  break;
+        	  }
+
+        	  setupFirstData();
         	  bitsSent += (evt->data.evt_gatt_server_attribute_value.value.len*8);
         	  operationCount++;
+        	  energyPacket(evt->data.evt_gatt_server_attribute_value.value.len + 3, false);
+
+        	  if(payloadCrypt)
+        	  {
+        		  PAYLOADCRYPT_Decrypt(PAYLOADCRYPT_STREAM_WRITE, evt->data.evt_gatt_server_attribute_value.value.data, evt->data.evt_gatt_server_attribute_value.value.len);
+        	  }
 
-        	  /* Validate the data */
-        	  for(int i=1; i<evt->data.evt_gatt_server_attribute_value.value.len; i++)
+        	  UARTSINK_Put(evt->data.evt_gatt_server_attribute_value.value.data, evt->data.evt_gatt_server_attribute_value.value.len, RTCC_CounterGet());
+
+        	  if(payloadDigest)
+        	  {
+        		  digestAdd(evt->data.evt_gatt_server_attribute_value.value.data, evt->data.evt_gatt_server_attribute_value.value.len);
+        		  break;
+        	  }
+
+        	  /* Validate the data, after the sequence number when encrypted */
+        	  for(int i=rampStart(); i<evt->data.evt_gatt_server_attribute_value.value.len; i++)
         	  {
         		  if(evt->data.evt_gatt_server_attribute_value.value.data[i] != (uint8)((evt->data.evt_gatt_server_attribute_value.value.data[i-1])+1))
         		  {
@@ -944,18 +3771,92 @@ void main(void)
 				  break;
 
 			  case SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE:
+				  if(bridging)
+				  {
+					  bridgeEnd(true);
+					  break;
+				  }
 				  dataTransmissionEnd();
 				  sendNotifications = false;
 				  sendIndications = false;
 				  sendWriteNoResponse = false;
 				  break;
+			  case SOFT_TIMER_SAMPLE_HANDLE:
+				  if(sampleCount < SAMPLE_COUNT)
+				  {
+					  samples[sampleCount].time = RTCC_CounterGet();
+					  samples[sampleCount].bits = bitsSent;
+					  samples[sampleCount].operations = operationCount;
+					  sampleCount++;
+				  }
+				  {
+					  FLASHLOG_Throughput_t sample = { bitsSent, operationCount };
+					  FLASHLOG_Append(FLASHLOG_TYPE_THROUGHPUT, RTCC_CounterGet(), &sample, sizeof(sample));
+				  }
+				  {
+					  uint32_t kbps = (bitsSent - statsBits) / 1000;
+
+					  SAMPLESTATS_Add(&statsThroughput, (int16_t)((kbps > INT16_MAX) ? INT16_MAX : kbps));
+					  statsBits = bitsSent;
+				  }
+				  /* The display refresh that asks for it otherwise is off during runs */
+				  gecko_cmd_le_connection_get_rssi(connection);
+				  break;
+			  case SOFT_TIMER_MATRIX_HANDLE:
+				  PHYMATRIX_Timer();
+				  break;
+			  case SOFT_TIMER_DTM_HANDLE:
+				  if(DTMSWEEP_Running())
+				  {
+					  uint32_t logged = DTMSWEEP_Done();
+
+					  DTMSWEEP_Timer(RTCC_CounterGet());
+					  dtmLog(logged);
+				  }
+				  else if(dtmPending)
+				  {
+					  /* The slave did not close the link, no sweep */
+					  dtmPending = false;
+					  printf("dtm: no answer from the slave\r\n");
+				  }
+				  break;
+			  case SOFT_TIMER_RECONNECT_HANDLE:
+				  if(openConnection != 0)
+				  {
+					  /* Held long enough, or the setup took too long. The closed event starts the next cycle */
+					  gecko_cmd_le_connection_close(openConnection);
+				  }
+				  else
+				  {
+					  /* Nothing found in time, scanning goes on */
+					  setupCycleStart();
+				  }
+				  break;
 			  case COEX_COUNTER_UPDATE:
 				  coex_counter_rsp = gecko_cmd_coex_get_counters(1);
-				  printf("lp requests %d, hp requests %d, lp denials %d, hp denials %d\r\n ",
+				  DLOG("lp requests %d, hp requests %d, lp denials %d, hp denials %d\r\n ",
 						  coex_counter_rsp->counters.data[0],
 						  coex_counter_rsp->counters.data[4],
 						  coex_counter_rsp->counters.data[8],
 						  coex_counter_rsp->counters.data[12]);
+				  if(coex_counter_rsp->result == 0 && coex_counter_rsp->counters.len >= sizeof(FLASHLOG_Coex_t))
+				  {
+					  FLASHLOG_Coex_t coex;
+					  memcpy(&coex, coex_counter_rsp->counters.data, sizeof(coex));
+					  FLASHLOG_Append(FLASHLOG_TYPE_COEX, RTCC_CounterGet(), &coex, sizeof(coex));
+					  if(runActive())
+					  {
+						  runCoex[0] += coex.lpRequests;
+						  runCoex[1] += coex.hpRequests;
+						  runCoex[2] += coex.lpDenials;
+						  runCoex[3] += coex.hpDenials;
+					  }
+					  if(sampling && coex.lpRequests + coex.hpRequests != 0)
+					  {
+						  SAMPLESTATS_Add(&statsDenials, (int16_t)(((uint32_t)coex.lpDenials + coex.hpDenials) * 1000
+								  / ((uint32_t)coex.lpRequests + coex.hpRequests)));
+					  }
+				  }
 				  break;
 			  default:
 				  break;
@@ -964,6 +3865,11 @@ void main(void)
 
 	  case gecko_evt_le_connection_rssi_id:
 		 // sprintf(statusConnectedString+6, "%03d", evt->data.evt_le_connection_rssi.rssi);
+		  PHYMATRIX_Rssi(evt->data.evt_le_connection_rssi.rssi);
+		  if(sampling)
+		  {
+			  SAMPLESTATS_Add(&statsRssi, evt->data.evt_le_connection_rssi.rssi);
+		  }
 		  break;
 
 #if 1
@@ -986,13 +3892,17 @@ void main(void)
 				  default:
 					  break;
 			  }
+    		  PHYMATRIX_PhyStatus((uint8_t)phyInUse);
     	  break;
 
       case gecko_evt_gatt_mtu_exchanged_id:
 
     	  mtuSize = evt->data.evt_gatt_mtu_exchanged.mtu;
+    	  CONNSETUP_Mark(CONNSETUP_MTU, RTCC_CounterGet());
 
+#ifndef NODISPLAY
     	  sprintf(mtuSizeString+5, "%03u", mtuSize);
+#endif
 
     	  connection = evt->data.evt_gatt_mtu_exchanged.connection;
 
@@ -1005,30 +3915,11 @@ void main(void)
     		  maxDataSizeIndications = DATA_TRANSFER_SIZE_INDICATIONS;
     	  }
 
-    	  if(DATA_TRANSFER_SIZE_NOTIFICATIONS == 0 || DATA_TRANSFER_SIZE_NOTIFICATIONS > (mtuSize-3))
-    	  {
-			  if(pduSize!=0 && mtuSize!=0) {
-				  if(pduSize <= mtuSize)
-				  {
-					  maxDataSizeNotifications = (pduSize - 7) + ((mtuSize - 3 - pduSize + 7) / pduSize * pduSize);
-				  }
-				  else
-				  {
-
-					  if(pduSize-mtuSize<=4)
-					  {
-						  maxDataSizeNotifications = pduSize - 7;
-					  } else {
-						  maxDataSizeNotifications = mtuSize - 3;
-					  }
-				  }
-			  }
-    	  }
-    	  else
-    	  {
-    		  maxDataSizeNotifications = DATA_TRANSFER_SIZE_NOTIFICATIONS;
-    	  }
+    	  updateMaxDataSizeNotifications();
+#ifndef NODISPLAY
     	  sprintf(maxDataSizeNotificationsString+11, "%03u", maxDataSizeNotifications);
+#endif
+    	  DLOG("MTU: %u DATA SIZE: %u\r\n", mtuSize, maxDataSizeNotifications);
 
     	  if(!roleIsSlave) {
 			  /* For the sake of simplicity we'll just assume that the CCCD handle for the indication
@@ -1041,7 +3932,15 @@ void main(void)
 #endif
       case gecko_evt_gatt_procedure_completed_id:
 
+    	  if(enableNotificationsIndications == 2 && CONNSETUP_Reached(CONNSETUP_CCCD_NOTIFY)
+    			  && CONNSETUP_Mark(CONNSETUP_CCCD_INDICATE, RTCC_CounterGet()) && reconnectCycles != 0)
+    	  {
+    		  /* Reconnect loop: nothing streams by itself, a read of the peer's display refresh is the first data */
+    		  gecko_cmd_gatt_read_characteristic_value(connection, gattdb_display_refresh);
+    	  }
+
     	  if(enableNotificationsIndications == 1) {
+    		  CONNSETUP_Mark(CONNSETUP_CCCD_NOTIFY, RTCC_CounterGet());
     		  notifications_enabled = 1;
     		  enableNotificationsIndications = 2;
     		  gecko_cmd_gatt_write_descriptor_value(connection, gattdb_throughput_indications+1, 1, &enableNotificationsIndications);
@@ -1055,34 +3954,23 @@ void main(void)
       case gecko_evt_le_connection_parameters_id:
 
     	  pduSize = evt->data.evt_le_connection_parameters.txsize;
+    	  CONNSETUP_Mark(CONNSETUP_PARAMETERS, RTCC_CounterGet());
+    	  connInterval = evt->data.evt_le_connection_parameters.interval;
+    	  PHYMATRIX_Parameters(connInterval);
+#ifndef NODISPLAY
     	  sprintf(pduSizeString+5, "%03u", pduSize);
     	  sprintf(connIntervalString+7, "%04u", (unsigned int)((float)evt->data.evt_le_connection_parameters.interval*1.25));
+#endif
     	  statusString = (char*)statusConnectedString;
 
 
-    	  if(DATA_TRANSFER_SIZE_NOTIFICATIONS == 0 || DATA_TRANSFER_SIZE_NOTIFICATIONS > (mtuSize-3))
-    	  {
-			  if(pduSize!=0 && mtuSize!=0) {
-				  if(pduSize <= mtuSize)
-				  {
-					  maxDataSizeNotifications = (pduSize - 7) + ((mtuSize - 3 - pduSize + 7) / pduSize * pduSize);
-				  }
-				  else
-				  {
-					  if(pduSize-mtuSize<=4)
-					  {
-						  maxDataSizeNotifications = pduSize - 7;
-					  } else {
-						  maxDataSizeNotifications = mtuSize - 3;
-					  }
-				  }
-			  }
-    	  }
-    	  else
-		  {
-			  maxDataSizeNotifications = DATA_TRANSFER_SIZE_NOTIFICATIONS;
-		  }
+    	  updateMaxDataSizeNotifications();
+#ifndef NODISPLAY
     	  sprintf(maxDataSizeNotificationsString+11, "%03u", maxDataSizeNotifications);
+#endif
+    	  /* Interval is logged in 1.25ms units, PDU and data size in bytes */
+    	  DLOG("INTRV: %u PDU: %u DATA SIZE: %u\r\n",
+    			  evt->data.evt_le_connection_parameters.interval, pduSize, maxDataSizeNotifications);
 
     	  /* Change phy if request */
     	  if(phyToUse) {
@@ -1092,11 +3980,16 @@ void main(void)
 
       case gecko_evt_system_external_signal_id:
 
-    	  switch (evt->data.evt_system_external_signal.extsignals)
+    	  if(evt->data.evt_system_external_signal.extsignals & CONSOLE_INPUT)
+    	  {
+    		  consolePoll();
+    	  }
+
+    	  switch (evt->data.evt_system_external_signal.extsignals & ~CONSOLE_INPUT)
     	  {
     	  	  case NOTIFICATIONS_START:
 
-    	  		  dataTransmissionStart();
+    	  		  dataTransmissionStart(FLASHLOG_MODE_NOTIFY);
     	  		  sendNotifications = true;
     	  		  generate_data_notifications();
 #if defined(SEND_FIXED_TRANSFER_COUNT)
@@ -1118,7 +4011,7 @@ void main(void)
     	  		  break;
 
     	  	  case WRITE_NO_RESPONSE_START:
-    	  		  dataTransmissionStart();
+    	  		  dataTransmissionStart(FLASHLOG_MODE_WRITE);
     	  		  sendWriteNoResponse = true;
     	  		  generate_data_notifications();
 #if defined(SEND_FIXED_TRANSFER_COUNT)
@@ -1138,7 +4031,7 @@ void main(void)
 
     	  	  case INDICATIONS_START:
 
-    	  		  dataTransmissionStart();
+    	  		  dataTransmissionStart(FLASHLOG_MODE_INDICATE);
     	  		  sendIndications = true;
 #if defined(SEND_FIXED_TRANSFER_COUNT)
     	  		  transferCount = 0;
@@ -1148,7 +4041,7 @@ void main(void)
     	  		  if(indications_enabled)
     	  		  {
     	  			  generate_data_indications();
-        	  		  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, throughput_array_indications)->result != 0);
+        	  		  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsPayload())->result != 0);
     	  		  }
     	  		  break;
 
@@ -1173,11 +4066,10 @@ void main(void)
 
     	  		  case PHY_2M:
 #if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_3)
-    	  			  /* We're on 2M PHY, go to 125kbit Coded PHY (S=8) - only supported by xG13 */
-    	  			  phyToUse = PHY_S8;
-    	  			  /* Change connection parameters according to set_phy command description
+    	  			  /* We're on 2M PHY, go to 500kbit Coded PHY (S=2) - only supported by xG13.
+    	  			   * Connection parameters change according to set_phy command description
 					   * in API Ref. Minimum connection interval for LE Coded PHY is 40ms */
-    	  			gecko_cmd_le_connection_set_timing_parameters(connection, CONN_INTERVAL_125KPHY_MIN, CONN_INTERVAL_125KPHY_MAX, SLAVE_LATENCY_125KPHY, SUPERVISION_TIMEOUT_125KPHY,0,0);
+    	  			  phyRequest(phyTiming(PHY_S2));
 #else
 					  /* We're on 2MPHY but with xG12, go back to 1M PHY */
 					  phyToUse = PHY_1M;
@@ -1186,6 +4078,13 @@ void main(void)
 #endif
     	  			  break;
 
+    	  		  case PHY_S2:
+#if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_3)
+    	  			  /* We're on S2 PHY, go to 125kbit Coded PHY (S=8). The timing stays, so the PHY is requested at once */
+    	  			  phyRequest(phyTiming(PHY_S8));
+#endif
+    	  			  break;
+
     	  		  case PHY_S8:
 #if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_3)
     	  			  /* We're on S8 PHY, go back to 1M PHY */
@@ -1205,13 +4104,30 @@ void main(void)
 
     	break;
 
+	  case gecko_evt_test_dtm_completed_id:
+		  {
+			  uint32_t logged = DTMSWEEP_Done();
+
+			  DTMSWEEP_Completed(evt->data.evt_test_dtm_completed.result, evt->data.evt_test_dtm_completed.number_of_packets,
+					  RTCC_CounterGet());
+			  dtmLog(logged);
+		  }
+		  break;
+
 	  case gecko_evt_le_gap_scan_response_id:
 			/* process scan responses: this function returns 1 if we found the "Throughput Tester" device name */
 			if(process_scan_response(&(evt->data.evt_le_gap_scan_response)) > 0) {
 				/* Match found - stop scanning and connect */
+				struct gecko_msg_le_gap_connect_rsp_t *connect;
+
+				CONNSETUP_Mark(CONNSETUP_FOUND, RTCC_CounterGet());
 				gecko_cmd_le_gap_end_procedure();
 
-				gecko_cmd_le_gap_connect(evt->data.evt_le_gap_scan_response.address, evt->data.evt_le_gap_scan_response.address_type, 1);
+				connect = gecko_cmd_le_gap_connect(evt->data.evt_le_gap_scan_response.address, evt->data.evt_le_gap_scan_response.address_type, 1);
+				if(connect->result == 0)
+				{
+					openConnection = connect->connection;
+				}
 			}
 		break;
 
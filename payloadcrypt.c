@@ -0,0 +1,140 @@
+/***************************************************************************//**
+ * @file
+ * @brief AES-128-CTR encryption of the throughput payloads
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "cryptobackend.h"
+#include "payloadcrypt.h"
+
+#define STREAMS					3
+#define BLOCK					CRYPTOBACKEND_AES_BLOCK
+
+static const uint8_t key[16] = PAYLOADCRYPT_KEY;
+static const uint8_t nonce[7] = PAYLOADCRYPT_NONCE;
+static uint32_t txSequence[STREAMS];
+static uint32_t rxSequence[STREAMS];		// Next sequence number expected
+static PAYLOADCRYPT_Stats_t txStats;
+static PAYLOADCRYPT_Stats_t rxStats;
+
+/**************************************************************************//**
+* @brief Runs len bytes through AES-CTR with the counter block of one packet.
+* Whole blocks go straight from in to out, a last partial block through a
+* zero padded copy
+*****************************************************************************/
+static void ctr(uint8_t stream, uint32_t sequence, uint8_t *out, const uint8_t *in, uint16_t len)
+{
+	uint8_t counter[16];
+	uint8_t block[BLOCK];
+	uint16_t whole = len & ~(BLOCK - 1);
+
+	memcpy(counter, nonce, sizeof(nonce));
+	counter[7] = stream;
+	counter[8] = (uint8_t)(sequence >> 24);
+	counter[9] = (uint8_t)(sequence >> 16);
+	counter[10] = (uint8_t)(sequence >> 8);
+	counter[11] = (uint8_t)sequence;
+	memset(&counter[12], 0, 4);
+
+	CRYPTOBACKEND_Active->aesCtr128(out, in, whole, key, counter);
+
+	if(whole < len)
+	{
+		memset(block, 0, sizeof(block));
+		memcpy(block, in + whole, len - whole);
+		CRYPTOBACKEND_Active->aesCtr128(block, block, sizeof(block), key, counter);
+		memcpy(out + whole, block, len - whole);
+	}
+}
+
+void PAYLOADCRYPT_Init(void)
+{
+	PAYLOADCRYPT_Start();
+}
+
+/**************************************************************************//**
+* @brief Starts every stream again from sequence number 0 and clears the
+* counters. Both ends call it when a run starts
+*****************************************************************************/
+void PAYLOADCRYPT_Start(void)
+{
+	memset(txSequence, 0, sizeof(txSequence));
+	memset(rxSequence, 0, sizeof(rxSequence));
+	memset(&txStats, 0, sizeof(txStats));
+	memset(&rxStats, 0, sizeof(rxStats));
+}
+
+/**************************************************************************//**
+* @brief Encrypts the next packet of a stream. The first
+* PAYLOADCRYPT_HEADER_SIZE bytes of in are replaced by the sequence number.
+* Call once per new payload, a payload sent again is not encrypted again
+*****************************************************************************/
+void PAYLOADCRYPT_Encrypt(uint8_t stream, uint8_t *out, const uint8_t *in, uint16_t len)
+{
+	uint32_t sequence = txSequence[stream % STREAMS]++;
+	uint32_t start;
+
+	if(len <= PAYLOADCRYPT_HEADER_SIZE)
+	{
+		memcpy(out, in, len);
+		return;
+	}
+
+	out[0] = (uint8_t)sequence;
+	out[1] = (uint8_t)(sequence >> 8);
+	out[2] = (uint8_t)(sequence >> 16);
+	out[3] = (uint8_t)(sequence >> 24);
+
+	start = CRYPTOBACKEND_Cycles();
+	ctr(stream, sequence, out + PAYLOADCRYPT_HEADER_SIZE, in + PAYLOADCRYPT_HEADER_SIZE, len - PAYLOADCRYPT_HEADER_SIZE);
+	txStats.cycles += CRYPTOBACKEND_Cycles() - start;
+	txStats.packets++;
+	txStats.bytes += len - PAYLOADCRYPT_HEADER_SIZE;
+}
+
+/**************************************************************************//**
+* @brief Decrypts a received packet in place, the sequence number is left in
+* front of the plaintext
+*****************************************************************************/
+void PAYLOADCRYPT_Decrypt(uint8_t stream, uint8_t *data, uint16_t len)
+{
+	uint32_t sequence;
+	uint32_t start;
+
+	if(len <= PAYLOADCRYPT_HEADER_SIZE)
+	{
+		return;
+	}
+
+	sequence = data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+	if(sequence != rxSequence[stream % STREAMS])
+	{
+		rxStats.gaps++;
+	}
+	rxSequence[stream % STREAMS] = sequence + 1;
+
+	start = CRYPTOBACKEND_Cycles();
+	ctr(stream, sequence, data + PAYLOADCRYPT_HEADER_SIZE, data + PAYLOADCRYPT_HEADER_SIZE, len - PAYLOADCRYPT_HEADER_SIZE);
+	rxStats.cycles += CRYPTOBACKEND_Cycles() - start;
+	rxStats.packets++;
+	rxStats.bytes += len - PAYLOADCRYPT_HEADER_SIZE;
+}
+
+void PAYLOADCRYPT_GetStats(PAYLOADCRYPT_Stats_t *tx, PAYLOADCRYPT_Stats_t *rx)
+{
+	*tx = txStats;
+	*rx = rxStats;
+}
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file
+ * @brief AES-128-CTR encryption of the throughput payloads
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PAYLOADCRYPT_H_
+#define PAYLOADCRYPT_H_
+
+#include <stdint.h>
+
+/* An encrypted payload starts with the sender's packet sequence number in
+ * the clear, little endian, followed by the rest of the plaintext run
+ * through AES-128-CTR on CRYPTOBACKEND_Active. The counter block is
+ *
+ *   PAYLOADCRYPT_NONCE (7 bytes) | stream | sequence (BE32) | block (BE32)
+ *
+ * so every packet of every stream gets its own key stream, and the receiver
+ * can decrypt any packet on its own and then check the ramp as before. A
+ * sequence number other than the one expected is counted as a gap.
+ *
+ * The key is a fixed test key, both ends of a run must be built with the
+ * same one. Cycles are CRYPTOBACKEND_Cycles(), DWT->CYCCNT on the target,
+ * which must be running. Built with -DCRYPTOBACKEND_SOFTWARE_ONLY the module
+ * runs on a PC, where cycles are nanoseconds. */
+
+#define PAYLOADCRYPT_HEADER_SIZE	4
+
+#ifndef PAYLOADCRYPT_KEY
+#define PAYLOADCRYPT_KEY		{ 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, \
+								  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c }
+#endif
+#ifndef PAYLOADCRYPT_NONCE
+#define PAYLOADCRYPT_NONCE		{ 'T', 'P', 'U', 'T', 'C', 'T', 'R' }
+#endif
+
+/* Stream numbers, one per direction and GATT operation */
+#define PAYLOADCRYPT_STREAM_NOTIFY		0
+#define PAYLOADCRYPT_STREAM_INDICATE	1
+#define PAYLOADCRYPT_STREAM_WRITE		2
+
+typedef struct {
+	uint32_t packets;
+	uint32_t bytes;							// Payload bytes run through AES, sequence numbers not included
+	uint32_t cycles;						// Spent in AES, including the CRYPTO set up
+	uint32_t gaps;							// Received packets whose sequence number was not the expected one
+} PAYLOADCRYPT_Stats_t;
+
+void PAYLOADCRYPT_Init(void);
+void PAYLOADCRYPT_Start(void);
+void PAYLOADCRYPT_Encrypt(uint8_t stream, uint8_t *out, const uint8_t *in, uint16_t len);
+void PAYLOADCRYPT_Decrypt(uint8_t stream, uint8_t *data, uint16_t len);
+void PAYLOADCRYPT_GetStats(PAYLOADCRYPT_Stats_t *tx, PAYLOADCRYPT_Stats_t *rx);
+
+#endif
@@ -0,0 +1,256 @@
+/***************************************************************************//**
+ * @file
+ * @brief SHA-256 integrity check of a whole throughput run
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "cryptobackend.h"
+#include "payloaddigest.h"
+
+#define DIGEST_SIZE				CRYPTOBACKEND_SHA256_SIZE
+#define REPORT_SIZE				sizeof(PAYLOADDIGEST_Report_t)
+
+_Static_assert(REPORT_SIZE == 12 + DIGEST_SIZE + 4 * PAYLOADDIGEST_CHECKPOINTS, "PAYLOADDIGEST_Report_t must not be padded");
+_Static_assert(REPORT_SIZE <= 255, "the report offset is one byte");
+_Static_assert((PAYLOADDIGEST_CHECKPOINTS % 2) == 0, "checkpoints are thinned in pairs");
+
+static const uint8_t magic[4] = PAYLOADDIGEST_MAGIC;
+
+/* Words, so the hardware backend can hash it in place */
+static uint32_t chain[(DIGEST_SIZE + PAYLOADDIGEST_LONGEST + 3) / 4];
+static PAYLOADDIGEST_Report_t local;
+static PAYLOADDIGEST_Report_t sent;			// local as it was when the trailer started
+static PAYLOADDIGEST_Report_t remote;
+static uint32_t sentBytes;					// Trailer bytes sent, ~0 = not started
+static uint32_t remoteBytes;				// Trailer bytes received in order
+static uint32_t prng;
+static PAYLOADDIGEST_Result_t result;
+
+/**************************************************************************//**
+* @brief Forgets the last run. The seed only matters on the sending end
+*****************************************************************************/
+void PAYLOADDIGEST_Start(uint32_t seed)
+{
+	memset(chain, 0, sizeof(chain));
+	memset(&local, 0, sizeof(local));
+	memset(&remote, 0, sizeof(remote));
+	memset(&result, 0, sizeof(result));
+	local.window = PAYLOADDIGEST_WINDOW;
+	sentBytes = ~0u;
+	remoteBytes = 0;
+	prng = seed ? seed : 1;
+}
+
+/**************************************************************************//**
+* @brief Fills a payload with the next bytes of an xorshift32 sequence. A
+* payload that would start like a trailer has its first byte changed
+*****************************************************************************/
+void PAYLOADDIGEST_Fill(uint8_t *data, uint16_t len)
+{
+	for(uint16_t i = 0; i < len; i++)
+	{
+		if((i % 4) == 0)
+		{
+			prng ^= prng << 13;
+			prng ^= prng >> 17;
+			prng ^= prng << 5;
+		}
+		data[i] = (uint8_t)(prng >> (8 * (i % 4)));
+	}
+
+	if(len >= sizeof(magic) && memcmp(data, magic, sizeof(magic)) == 0)
+	{
+		data[0] ^= 0xff;
+	}
+}
+
+/* Drops every other checkpoint and doubles the window */
+static void thin(void)
+{
+	for(uint32_t i = 0; i < PAYLOADDIGEST_CHECKPOINTS / 2; i++)
+	{
+		memcpy(local.checkpoint[i], local.checkpoint[2 * i + 1], sizeof(local.checkpoint[i]));
+	}
+	local.checkpoints = PAYLOADDIGEST_CHECKPOINTS / 2;
+	local.window *= 2;
+}
+
+/**************************************************************************//**
+* @brief Adds one payload, as sent or as received, to the hash chain
+*****************************************************************************/
+void PAYLOADDIGEST_Add(const uint8_t *data, uint16_t len)
+{
+	uint8_t *message = (uint8_t *)chain;
+	uint32_t start;
+
+	if(len > PAYLOADDIGEST_LONGEST)
+	{
+		len = PAYLOADDIGEST_LONGEST;
+	}
+
+	memcpy(message, local.digest, DIGEST_SIZE);
+	memcpy(message + DIGEST_SIZE, data, len);
+
+	start = CRYPTOBACKEND_Cycles();
+	CRYPTOBACKEND_Active->sha256(message, DIGEST_SIZE + len, message);
+	result.cycles += CRYPTOBACKEND_Cycles() - start;
+	result.bytes += DIGEST_SIZE + len;
+
+	memcpy(local.digest, message, DIGEST_SIZE);
+	local.packets++;
+
+	if((local.packets % local.window) == 0)
+	{
+		if(local.checkpoints == PAYLOADDIGEST_CHECKPOINTS)
+		{
+			thin();
+		}
+		if((local.packets % local.window) == 0)
+		{
+			memcpy(local.checkpoint[local.checkpoints++], local.digest, sizeof(local.checkpoint[0]));
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Gives the next trailer packet of this end's report, freezing the
+* report on the first call
+* @param max Largest payload the link takes now
+* @return Length of the packet in out, 0 when the report has been sent
+*****************************************************************************/
+uint16_t PAYLOADDIGEST_TrailerNext(uint8_t *out, uint16_t max)
+{
+	uint32_t chunk;
+
+	if(max <= PAYLOADDIGEST_TRAILER_HEADER)
+	{
+		return 0;
+	}
+	if(sentBytes == ~0u)
+	{
+		sent = local;
+		sentBytes = 0;
+	}
+	if(sentBytes >= REPORT_SIZE)
+	{
+		return 0;
+	}
+
+	chunk = REPORT_SIZE - sentBytes;
+	if(chunk > (uint32_t)(max - PAYLOADDIGEST_TRAILER_HEADER))
+	{
+		chunk = max - PAYLOADDIGEST_TRAILER_HEADER;
+	}
+
+	memcpy(out, magic, sizeof(magic));
+	out[4] = (uint8_t)sentBytes;
+	memcpy(out + PAYLOADDIGEST_TRAILER_HEADER, (const uint8_t *)&sent + sentBytes, chunk);
+	sentBytes += chunk;
+
+	return (uint16_t)(PAYLOADDIGEST_TRAILER_HEADER + chunk);
+}
+
+/* Checkpoint j at the coarser of the two windows, NULL past the table */
+static const uint8_t *checkpointAt(const PAYLOADDIGEST_Report_t *report, uint32_t window, uint32_t j)
+{
+	uint32_t index = (j + 1) * (window / report->window) - 1;
+
+	return (index < report->checkpoints) ? report->checkpoint[index] : NULL;
+}
+
+static void compare(void)
+{
+	uint32_t window = (local.window > remote.window) ? local.window : remote.window;
+	uint32_t j;
+
+	result.remotePackets = remote.packets;
+	if(remote.packets == local.packets && memcmp(remote.digest, local.digest, DIGEST_SIZE) == 0)
+	{
+		result.state = PAYLOADDIGEST_MATCH;
+		return;
+	}
+	result.state = PAYLOADDIGEST_MISMATCH;
+
+	/* A window that is not a power of two multiple of ours is a broken report */
+	if(remote.window < PAYLOADDIGEST_WINDOW || (window % local.window) != 0 || (window % remote.window) != 0)
+	{
+		return;
+	}
+
+	for(j = 0; ; j++)
+	{
+		const uint8_t *mine = checkpointAt(&local, window, j);
+		const uint8_t *theirs = checkpointAt(&remote, window, j);
+
+		if(mine == NULL || theirs == NULL)
+		{
+			/* Same up to the last checkpoint both have, the rest is unknown */
+			result.lastGood = j * window;
+			result.badWindow = 0;
+			return;
+		}
+		if(memcmp(mine, theirs, sizeof(local.checkpoint[0])) != 0)
+		{
+			result.lastGood = j * window;
+			result.badWindow = window;
+			return;
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Takes a received payload if it is a trailer packet
+* @return false for a data payload, which the caller adds itself
+*****************************************************************************/
+bool PAYLOADDIGEST_Receive(const uint8_t *data, uint16_t len)
+{
+	uint32_t chunk = len - PAYLOADDIGEST_TRAILER_HEADER;
+
+	if(len <= PAYLOADDIGEST_TRAILER_HEADER || memcmp(data, magic, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+
+	if(data[4] == 0)
+	{
+		remoteBytes = 0;
+	}
+	if(data[4] != remoteBytes || remoteBytes + chunk > REPORT_SIZE)
+	{
+		/* Out of order, wait for the start of the next report */
+		remoteBytes = REPORT_SIZE + 1;
+		return true;
+	}
+
+	memcpy((uint8_t *)&remote + remoteBytes, data + PAYLOADDIGEST_TRAILER_HEADER, chunk);
+	remoteBytes += chunk;
+	result.state = PAYLOADDIGEST_PENDING;
+	if(remoteBytes == REPORT_SIZE)
+	{
+		compare();
+	}
+	return true;
+}
+
+void PAYLOADDIGEST_GetReport(PAYLOADDIGEST_Report_t *report)
+{
+	*report = local;
+}
+
+void PAYLOADDIGEST_GetResult(PAYLOADDIGEST_Result_t *out)
+{
+	*out = result;
+}
@@ -0,0 +1,87 @@
+/***************************************************************************//**
+ * @file
+ * @brief SHA-256 integrity check of a whole throughput run
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PAYLOADDIGEST_H_
+#define PAYLOADDIGEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The sender fills payloads from a pseudo-random generator. Both ends fold
+ * every payload sent or received into a hash chain,
+ *
+ *   digest = SHA-256(previous digest | payload)
+ *
+ * on CRYPTOBACKEND_Active, so a lost, repeated, reordered or changed payload
+ * gives a different digest. The digest after every window of packets is
+ * kept, 4 bytes of it, as a checkpoint. When the table of checkpoints is
+ * full every other one is dropped and the window doubles, so the table
+ * always covers the whole run and both ends thin it at the same packets.
+ *
+ * At the end of the run the sender sends its report: packet count, window,
+ * final digest and checkpoints, cut into trailer packets that start with
+ * PAYLOADDIGEST_MAGIC, over the same characteristic as the data. The
+ * receiver compares it with its own and the first checkpoint that differs
+ * gives the window of packets where the streams first diverged.
+ *
+ * Built with -DCRYPTOBACKEND_SOFTWARE_ONLY the module runs on a PC. */
+
+#ifndef PAYLOADDIGEST_WINDOW
+#define PAYLOADDIGEST_WINDOW		64			// Packets per checkpoint at the start of a run
+#endif
+#ifndef PAYLOADDIGEST_CHECKPOINTS
+#define PAYLOADDIGEST_CHECKPOINTS	16			// Must be even
+#endif
+#define PAYLOADDIGEST_MAGIC			{ 'S', 'H', 'A', '2' }
+#define PAYLOADDIGEST_TRAILER_HEADER	5		// Magic and report offset
+#define PAYLOADDIGEST_LONGEST		255			// Longest payload hashed
+
+/* Comparison with the other end's report */
+typedef enum {
+	PAYLOADDIGEST_NONE,						// No report received
+	PAYLOADDIGEST_PENDING,					// Part of a report received
+	PAYLOADDIGEST_MATCH,
+	PAYLOADDIGEST_MISMATCH
+} PAYLOADDIGEST_State_t;
+
+typedef struct {
+	uint32_t packets;						// Payloads in the chain
+	uint32_t window;						// Packets per checkpoint
+	uint8_t checkpoints;					// Valid entries in checkpoint
+	uint8_t reserved[3];
+	uint8_t digest[32];
+	uint8_t checkpoint[PAYLOADDIGEST_CHECKPOINTS][4];
+} PAYLOADDIGEST_Report_t;
+
+typedef struct {
+	PAYLOADDIGEST_State_t state;
+	uint32_t remotePackets;
+	uint32_t lastGood;						// When mismatched, leading packets both ends agree on
+	uint32_t badWindow;						// and the packets after them where the streams diverged, 0 = not covered by checkpoints
+	uint32_t cycles;						// Spent in SHA-256 on this end
+	uint32_t bytes;							// Hashed on this end
+} PAYLOADDIGEST_Result_t;
+
+void PAYLOADDIGEST_Start(uint32_t seed);
+void PAYLOADDIGEST_Fill(uint8_t *data, uint16_t len);
+void PAYLOADDIGEST_Add(const uint8_t *data, uint16_t len);
+uint16_t PAYLOADDIGEST_TrailerNext(uint8_t *out, uint16_t max);
+bool PAYLOADDIGEST_Receive(const uint8_t *data, uint16_t len);
+void PAYLOADDIGEST_GetReport(PAYLOADDIGEST_Report_t *report);
+void PAYLOADDIGEST_GetResult(PAYLOADDIGEST_Result_t *result);
+
+#endif
@@ -0,0 +1,255 @@
+/***************************************************************************//**
+ * @file
+ * @brief PHY matrix runner, one throughput run per PHY with its own timing
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "phymatrix.h"
+
+typedef enum {
+	STATE_IDLE,
+	STATE_SWITCHING,
+	STATE_RUNNING,
+	STATE_ENDING
+} State_t;
+
+static const PHYMATRIX_Port_t *port;
+static PHYMATRIX_Step_t steps[PHYMATRIX_MAX_STEPS];
+static PHYMATRIX_Row_t rows[PHYMATRIX_MAX_STEPS];
+static uint32_t stepCount;
+static uint32_t rowCount;
+static uint32_t step;						// Index of the step under way
+static uint32_t runTicks;
+static State_t state = STATE_IDLE;
+static uint8_t phyInUse;					// As last reported by the stack
+static uint16_t interval;
+
+static void stepBegin(void);
+
+static void finish(void)
+{
+	state = STATE_IDLE;
+	port->timer(0);
+	port->done(rows, rowCount);
+}
+
+static void runBegin(void)
+{
+	state = STATE_RUNNING;
+	rows[rowCount - 1].interval = interval;
+	port->runStart();
+	port->timer(runTicks);
+}
+
+static void stepEnd(void)
+{
+	port->collect(&rows[rowCount - 1]);
+	step++;
+	stepBegin();
+}
+
+static bool switched(void)
+{
+	return phyInUse == steps[step].phy && interval >= steps[step].intervalMin && interval <= steps[step].intervalMax;
+}
+
+static void stepBegin(void)
+{
+	PHYMATRIX_Row_t *row;
+
+	if(step == stepCount)
+	{
+		finish();
+		return;
+	}
+
+	row = &rows[rowCount++];
+	memset(row, 0, sizeof(*row));
+	row->phy = steps[step].phy;
+	row->rssiMin = INT8_MAX;
+	row->rssiMax = INT8_MIN;
+
+	state = STATE_SWITCHING;
+	port->request(&steps[step]);
+	if(switched())
+	{
+		/* Nothing to change, so nothing will be reported */
+		runBegin();
+	}
+	else
+	{
+		port->timer(PHYMATRIX_SWITCH_TIMEOUT);
+	}
+}
+
+/**************************************************************************//**
+* @brief Starts the matrix
+* @param phy, interval In use on the connection now
+* @return false if a matrix is running or the steps do not fit
+*****************************************************************************/
+bool PHYMATRIX_Start(const PHYMATRIX_Port_t *p, const PHYMATRIX_Step_t *s, uint32_t count, uint32_t seconds,
+		uint8_t phy, uint16_t connInterval)
+{
+	if(state != STATE_IDLE || count == 0 || count > PHYMATRIX_MAX_STEPS || seconds == 0 || seconds > 3600)
+	{
+		return false;
+	}
+
+	port = p;
+	memcpy(steps, s, count * sizeof(steps[0]));
+	stepCount = count;
+	rowCount = 0;
+	step = 0;
+	runTicks = seconds * 32768;
+	phyInUse = phy;
+	interval = connInterval;
+	stepBegin();
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Stops the matrix, the step under way is dropped from the rows
+*****************************************************************************/
+void PHYMATRIX_Abort(void)
+{
+	if(state == STATE_IDLE)
+	{
+		return;
+	}
+	if(state == STATE_RUNNING)
+	{
+		port->runStop();
+	}
+	rowCount--;
+	finish();
+}
+
+bool PHYMATRIX_Running(void)
+{
+	return state != STATE_IDLE;
+}
+
+/**************************************************************************//**
+* @brief Whether data of a step is flowing, or its end is awaited
+*****************************************************************************/
+bool PHYMATRIX_Measuring(void)
+{
+	return state == STATE_RUNNING || state == STATE_ENDING;
+}
+
+void PHYMATRIX_PhyStatus(uint8_t phy)
+{
+	phyInUse = phy;
+	if(state == STATE_SWITCHING && switched())
+	{
+		runBegin();
+	}
+}
+
+void PHYMATRIX_Parameters(uint16_t connInterval)
+{
+	interval = connInterval;
+	if(state == STATE_SWITCHING && switched())
+	{
+		runBegin();
+	}
+}
+
+void PHYMATRIX_Rssi(int8_t rssi)
+{
+	PHYMATRIX_Row_t *row = &rows[rowCount - 1];
+
+	if(state != STATE_RUNNING)
+	{
+		return;
+	}
+	row->rssiMin = (rssi < row->rssiMin) ? rssi : row->rssiMin;
+	row->rssiMax = (rssi > row->rssiMax) ? rssi : row->rssiMax;
+	row->rssiSum += rssi;
+	row->rssiCount++;
+}
+
+/**************************************************************************//**
+* @brief The data asked to stop by runStop() has stopped
+*****************************************************************************/
+void PHYMATRIX_RunEnded(void)
+{
+	if(state == STATE_ENDING)
+	{
+		port->timer(0);
+		stepEnd();
+	}
+}
+
+void PHYMATRIX_Timer(void)
+{
+	PHYMATRIX_Row_t *row = &rows[rowCount - 1];
+
+	switch(state)
+	{
+		case STATE_SWITCHING:
+			if(phyInUse == steps[step].phy)
+			{
+				row->flags |= PHYMATRIX_INTERVAL_REFUSED;
+				runBegin();
+			}
+			else
+			{
+				row->flags |= PHYMATRIX_PHY_REFUSED;
+				row->interval = interval;
+				step++;
+				stepBegin();
+			}
+			break;
+		case STATE_RUNNING:
+			state = STATE_ENDING;
+			port->runStop();
+			port->timer(PHYMATRIX_END_TIMEOUT);
+			break;
+		case STATE_ENDING:
+			row->flags |= PHYMATRIX_NO_END;
+			stepEnd();
+			break;
+		default:
+			break;
+	}
+}
+
+/**************************************************************************//**
+* @brief The connection closed, ends the matrix with the rows done so far
+*****************************************************************************/
+void PHYMATRIX_Closed(void)
+{
+	if(state == STATE_IDLE)
+	{
+		return;
+	}
+	rows[rowCount - 1].flags |= PHYMATRIX_CLOSED;
+	if(PHYMATRIX_Measuring())
+	{
+		port->collect(&rows[rowCount - 1]);
+	}
+	finish();
+}
+
+/**************************************************************************//**
+* @brief Rows of the running or the last matrix
+*****************************************************************************/
+const PHYMATRIX_Row_t *PHYMATRIX_Rows(uint32_t *count)
+{
+	*count = rowCount;
+	return rows;
+}
@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ * @file
+ * @brief PHY matrix runner, one throughput run per PHY with its own timing
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PHYMATRIX_H_
+#define PHYMATRIX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Only sequences, the stack is reached through PHYMATRIX_Port_t and its
+ * events are passed in, so tools/phymatrix_sim.c runs it against a stand-in
+ * of the stack on a PC. For each step:
+ *
+ *   switching	request() has asked for the PHY and the timing. Waits until
+ *				the PHY is in use and the interval is in the step's range.
+ *				The stack only reports changes, so a PHY or interval that is
+ *				already right is not waited for. On timeout with the PHY in
+ *				use the step runs on the interval it got, otherwise it is
+ *				skipped as refused.
+ *   running	runStart() has asked for data, for the step's seconds.
+ *   ending		runStop() has asked the data to stop. Waits for
+ *				PHYMATRIX_RunEnded(), or a timeout, then collect() fills in
+ *				the figures of the row.
+ *
+ * RSSI samples given to PHYMATRIX_Rssi() while running go to the row. A
+ * closed connection ends the matrix with the rows done so far. A single one
+ * shot timer, PHYMATRIX_Timer() when it fires, covers every wait. Everything
+ * runs from the main loop. */
+
+#define PHYMATRIX_MAX_STEPS			8
+#define PHYMATRIX_SWITCH_TIMEOUT	(32768*6)	// RTCC ticks, a coded PHY parameter update takes a few 200 ms intervals
+#define PHYMATRIX_END_TIMEOUT		(32768*3)	// RTCC ticks for the run end to come back
+
+/* PHYMATRIX_Row_t flags */
+#define PHYMATRIX_PHY_REFUSED		0x01	// The PHY was not taken, the step did not run
+#define PHYMATRIX_INTERVAL_REFUSED	0x02	// Ran on an interval outside the step's range
+#define PHYMATRIX_NO_END			0x04	// The run end did not come back, figures may be short
+#define PHYMATRIX_CLOSED			0x08	// The connection closed during the step
+
+typedef struct {
+	uint8_t phy;							// PHY_1M, PHY_2M, PHY_S8 or PHY_S2
+	uint16_t intervalMin;					// 1.25 ms units
+	uint16_t intervalMax;
+	uint16_t latency;
+	uint16_t timeout;						// Supervision timeout, 10 ms units
+} PHYMATRIX_Step_t;
+
+typedef struct {
+	uint8_t phy;							// PHY asked for
+	uint8_t flags;							// PHYMATRIX_*
+	uint16_t interval;						// Interval the step ran on
+	uint32_t bits;
+	uint32_t ticks;							// Run length, RTCC ticks
+	uint32_t invalid;						// Bytes failing the data check
+	uint16_t lpDenials;						// Coex denials over the run
+	uint16_t hpDenials;
+	int8_t rssiMin;
+	int8_t rssiMax;
+	uint16_t rssiCount;
+	int32_t rssiSum;
+} PHYMATRIX_Row_t;
+
+typedef struct {
+	void (*request)(const PHYMATRIX_Step_t *step);	// Ask for the step's PHY and timing
+	void (*runStart)(void);
+	void (*runStop)(void);
+	void (*collect)(PHYMATRIX_Row_t *row);			// Fill in bits, ticks, invalid and denials
+	void (*timer)(uint32_t ticks);					// Arm the one shot timer, 0 stops it
+	void (*done)(const PHYMATRIX_Row_t *rows, uint32_t count);
+} PHYMATRIX_Port_t;
+
+bool PHYMATRIX_Start(const PHYMATRIX_Port_t *port, const PHYMATRIX_Step_t *steps, uint32_t count, uint32_t seconds,
+		uint8_t phy, uint16_t interval);
+void PHYMATRIX_Abort(void);
+bool PHYMATRIX_Running(void);
+bool PHYMATRIX_Measuring(void);
+void PHYMATRIX_PhyStatus(uint8_t phy);
+void PHYMATRIX_Parameters(uint16_t interval);
+void PHYMATRIX_Rssi(int8_t rssi);
+void PHYMATRIX_RunEnded(void);
+void PHYMATRIX_Timer(void);
+void PHYMATRIX_Closed(void);
+const PHYMATRIX_Row_t *PHYMATRIX_Rows(uint32_t *count);
+
+#endif
@@ -0,0 +1,162 @@
+/***************************************************************************//**
+ * @file
+ * @brief DMADRV API definition (LDMA subset)
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc.  Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement.  This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef __SILICON_LABS_DMADRV_H__
+#define __SILICON_LABS_DMADRV_H__
+
+#include <stdbool.h>
+#include "em_device.h"
+#include "ecode.h"
+#include "dmadrv_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup emdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup DMADRV
+ * @brief DMADRV Direct Memory Access Driver
+ * @details
+ *   Channel bookkeeping and peripheral <-> memory transfers on the LDMA.
+ *   This project does not ship emlib's em_ldma, so the driver programs the
+ *   channel registers directly and only implements the subset of the full
+ *   DMADRV API that the kit drivers use. Callers written against the full
+ *   DMADRV API build unchanged against this subset.
+ * @{
+ ******************************************************************************/
+
+/*******************************************************************************
+ ********************************   MACROS   ***********************************
+ ******************************************************************************/
+
+#define ECODE_EMDRV_DMADRV_OK                   (ECODE_OK)                             ///< A successful return value.
+#define ECODE_EMDRV_DMADRV_PARAM_ERROR          (ECODE_EMDRV_DMADRV_BASE | 0x00000001) ///< An illegal input parameter.
+#define ECODE_EMDRV_DMADRV_NOT_INITIALIZED      (ECODE_EMDRV_DMADRV_BASE | 0x00000002) ///< DMA is not initialized.
+#define ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED  (ECODE_EMDRV_DMADRV_BASE | 0x00000003) ///< DMA has already been initialized.
+#define ECODE_EMDRV_DMADRV_CHANNELS_EXHAUSTED   (ECODE_EMDRV_DMADRV_BASE | 0x00000004) ///< No DMA channels available.
+#define ECODE_EMDRV_DMADRV_IN_USE               (ECODE_EMDRV_DMADRV_BASE | 0x00000005) ///< DMA is in use.
+#define ECODE_EMDRV_DMADRV_ALREADY_FREED        (ECODE_EMDRV_DMADRV_BASE | 0x00000006) ///< A DMA channel was free.
+#define ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED     (ECODE_EMDRV_DMADRV_BASE | 0x00000007) ///< A channel is not reserved.
+
+/// Maximum number of items moved by a single LDMA descriptor.
+#define DMADRV_MAX_XFER_COUNT                   ((_LDMA_CH_CTRL_XFERCNT_MASK >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1)
+
+/*******************************************************************************
+ *******************************   TYPEDEFS   **********************************
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *  DMADRV transfer completion callback function.
+ *
+ * @details
+ *  The callback function is called when a transfer is complete.
+ *
+ * @param[in] channel
+ *  The DMA channel number.
+ *
+ * @param[in] sequenceNo
+ *  The number of times the callback was called. Useful on long chains of
+ *  linked transfers or on endless ping-pong type transfers.
+ *
+ * @param[in] userParam
+ *  Optional user parameter supplied on DMA invocation.
+ *
+ * @return
+ *   When doing ping-pong transfers, return true to continue or false to
+ *   stop transfers.
+ ******************************************************************************/
+typedef bool (*DMADRV_Callback_t)(unsigned int channel,
+                                  unsigned int sequenceNo,
+                                  void *userParam);
+
+/// Peripherals that can trigger LDMA transfers.
+typedef enum {
+  dmadrvPeripheralSignal_NONE = 0,                                                                    ///< No peripheral selected for DMA triggering.
+  dmadrvPeripheralSignal_USART0_RXDATAV = LDMA_CH_REQSEL_SIGSEL_USART0RXDATAV | LDMA_CH_REQSEL_SOURCESEL_USART0, ///< Trigger on USART0_RXDATAV.
+  dmadrvPeripheralSignal_USART0_TXBL = LDMA_CH_REQSEL_SIGSEL_USART0TXBL | LDMA_CH_REQSEL_SOURCESEL_USART0,       ///< Trigger on USART0_TXBL.
+  dmadrvPeripheralSignal_USART0_TXEMPTY = LDMA_CH_REQSEL_SIGSEL_USART0TXEMPTY | LDMA_CH_REQSEL_SOURCESEL_USART0, ///< Trigger on USART0_TXEMPTY.
+  dmadrvPeripheralSignal_USART1_RXDATAV = LDMA_CH_REQSEL_SIGSEL_USART1RXDATAV | LDMA_CH_REQSEL_SOURCESEL_USART1, ///< Trigger on USART1_RXDATAV.
+  dmadrvPeripheralSignal_USART1_TXBL = LDMA_CH_REQSEL_SIGSEL_USART1TXBL | LDMA_CH_REQSEL_SOURCESEL_USART1,       ///< Trigger on USART1_TXBL.
+  dmadrvPeripheralSignal_USART1_TXEMPTY = LDMA_CH_REQSEL_SIGSEL_USART1TXEMPTY | LDMA_CH_REQSEL_SOURCESEL_USART1, ///< Trigger on USART1_TXEMPTY.
+} DMADRV_PeripheralSignal_t;
+
+/// Data size of one LDMA transfer item.
+typedef enum {
+  dmadrvDataSize1 = _LDMA_CH_CTRL_SIZE_BYTE,     ///< Byte
+  dmadrvDataSize2 = _LDMA_CH_CTRL_SIZE_HALFWORD, ///< Halfword
+  dmadrvDataSize4 = _LDMA_CH_CTRL_SIZE_WORD      ///< Word
+} DMADRV_DataSize_t;
+
+/*******************************************************************************
+ ******************************   PROTOTYPES   *********************************
+ ******************************************************************************/
+
+Ecode_t DMADRV_AllocateChannel(unsigned int *channelId, void *capabilities);
+Ecode_t DMADRV_DeInit(void);
+Ecode_t DMADRV_FreeChannel(unsigned int channelId);
+Ecode_t DMADRV_Init(void);
+
+Ecode_t DMADRV_MemoryPeripheral(unsigned int channelId,
+                                DMADRV_PeripheralSignal_t peripheralSignal,
+                                void *dst,
+                                void *src,
+                                bool srcInc,
+                                int len,
+                                DMADRV_DataSize_t size,
+                                DMADRV_Callback_t callback,
+                                void *cbUserParam);
+
+Ecode_t DMADRV_PeripheralMemory(unsigned int channelId,
+                                DMADRV_PeripheralSignal_t peripheralSignal,
+                                void *dst,
+                                void *src,
+                                bool dstInc,
+                                int len,
+                                DMADRV_DataSize_t size,
+                                DMADRV_Callback_t callback,
+                                void *cbUserParam);
+
+Ecode_t DMADRV_PeripheralMemoryPingPong(unsigned int channelId,
+                                        DMADRV_PeripheralSignal_t peripheralSignal,
+                                        void *dst0,
+                                        void *dst1,
+                                        void *src,
+                                        bool dstInc,
+                                        int len,
+                                        DMADRV_DataSize_t size,
+                                        DMADRV_Callback_t callback,
+                                        void *cbUserParam);
+
+Ecode_t DMADRV_StopTransfer(unsigned int channelId);
+Ecode_t DMADRV_TransferActive(unsigned int channelId, bool *active);
+Ecode_t DMADRV_TransferDone(unsigned int channelId, bool *done);
+Ecode_t DMADRV_TransferRemainingCount(unsigned int channelId, int *remaining);
+
+/** @} (end addtogroup DMADRV) */
+/** @} (end addtogroup emdrv) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SILICON_LABS_DMADRV_H__ */
@@ -0,0 +1,735 @@
+/***************************************************************************//**
+ * @file
+ * @brief DMADRV API implementation (LDMA subset)
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc.  Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement.  This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_bus.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_assert.h"
+#include "em_common.h"
+#include "dmadrv.h"
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+#if !defined(LDMA_PRESENT)
+#error "This DMADRV subset only supports the LDMA controller"
+#endif
+
+#if (EMDRV_DMADRV_DMA_CH_COUNT > DMA_CHAN_COUNT)
+#error "DMA channel count exceeds available channels."
+#endif
+
+#if (EMDRV_DMADRV_DMA_CH_PRIORITY > EMDRV_DMADRV_DMA_CH_COUNT)
+#error "DMA channel priority exceeds available channels."
+#endif
+
+typedef struct {
+  DMADRV_Callback_t callback;
+  void              *userParam;
+  unsigned int      callbackCount;
+  bool              allocated;
+} ChTable_t;
+
+static bool initialized = false;
+static ChTable_t chTable[EMDRV_DMADRV_DMA_CH_COUNT];
+
+/* Two descriptors per channel, the second one is only used by ping-pong
+ * transfers. The channel loads them through LINKLOAD, so they must stay valid
+ * for as long as the transfer runs. */
+static DMA_DESCRIPTOR_TypeDef descriptors[EMDRV_DMADRV_DMA_CH_COUNT][2];
+
+static Ecode_t StartTransfer(unsigned int channelId,
+                             DMADRV_PeripheralSignal_t peripheralSignal,
+                             void *dst,
+                             void *src,
+                             uint32_t srcInc,
+                             uint32_t dstInc,
+                             int len,
+                             DMADRV_DataSize_t size,
+                             DMADRV_Callback_t callback,
+                             void *cbUserParam,
+                             void *dst1);
+
+/** @endcond */
+
+/***************************************************************************//**
+ * @brief
+ *  Allocate (reserve) a DMA channel.
+ *
+ * @param[out] channelId
+ *  The channel ID assigned by DMADRV.
+ *
+ * @param[in] capabilities
+ *  Not used.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_AllocateChannel(unsigned int *channelId, void *capabilities)
+{
+  unsigned int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  (void)capabilities;
+
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if (channelId == NULL) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  CORE_ENTER_ATOMIC();
+  for (i = 0U; i < (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT; i++) {
+    if (!chTable[i].allocated) {
+      *channelId           = i;
+      chTable[i].allocated = true;
+      chTable[i].callback  = NULL;
+      CORE_EXIT_ATOMIC();
+      return ECODE_EMDRV_DMADRV_OK;
+    }
+  }
+  CORE_EXIT_ATOMIC();
+  return ECODE_EMDRV_DMADRV_CHANNELS_EXHAUSTED;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Deinitialize DMADRV.
+ *
+ * @details
+ *  If no DMA channels are currently allocated, it will disable DMA hardware
+ *  and mask associated interrupts.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_DeInit(void)
+{
+  unsigned int i;
+  bool inUse;
+  CORE_DECLARE_IRQ_STATE;
+
+  inUse = false;
+
+  CORE_ENTER_ATOMIC();
+  for (i = 0U; i < (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT; i++) {
+    if (chTable[i].allocated) {
+      inUse = true;
+      break;
+    }
+  }
+
+  if (!inUse) {
+    NVIC_DisableIRQ(LDMA_IRQn);
+    LDMA->IEN  = 0;
+    LDMA->CHEN = 0;
+    CMU_ClockEnable(cmuClock_LDMA, false);
+    initialized = false;
+    CORE_EXIT_ATOMIC();
+    return ECODE_EMDRV_DMADRV_OK;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return ECODE_EMDRV_DMADRV_IN_USE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Free an allocated (reserved) DMA channel.
+ *
+ * @param[in] channelId
+ *  The channel ID to free.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_FreeChannel(unsigned int channelId)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if (channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  CORE_ENTER_ATOMIC();
+  if (chTable[channelId].allocated) {
+    chTable[channelId].allocated = false;
+    CORE_EXIT_ATOMIC();
+    return ECODE_EMDRV_DMADRV_OK;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return ECODE_EMDRV_DMADRV_ALREADY_FREED;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Initialize DMADRV.
+ *
+ * @details
+ *  The LDMA hardware is initialized, channels 0 to
+ *  EMDRV_DMADRV_DMA_CH_PRIORITY - 1 get fixed priority and the remaining
+ *  channels are arbitrated round-robin.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_Init(void)
+{
+  unsigned int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (initialized) {
+    CORE_EXIT_ATOMIC();
+    return ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED;
+  }
+  initialized = true;
+  CORE_EXIT_ATOMIC();
+
+  if (EMDRV_DMADRV_DMA_IRQ_PRIORITY > 7) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  for (i = 0U; i < (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT; i++) {
+    chTable[i].allocated = false;
+  }
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA->CTRL    = (uint32_t)EMDRV_DMADRV_DMA_CH_PRIORITY << _LDMA_CTRL_NUMFIXED_SHIFT;
+  LDMA->CHEN    = 0;
+  LDMA->DBGHALT = 0;
+  LDMA->REQDIS  = 0;
+
+  /* Enable LDMA error interrupt. */
+  LDMA->IEN = LDMA_IEN_ERROR;
+  LDMA->IFC = 0xFFFFFFFFUL;
+
+  NVIC_ClearPendingIRQ(LDMA_IRQn);
+  NVIC_SetPriority(LDMA_IRQn, EMDRV_DMADRV_DMA_IRQ_PRIORITY);
+  NVIC_EnableIRQ(LDMA_IRQn);
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Start a memory to a peripheral DMA transfer.
+ *
+ * @param[in] channelId
+ *  The channel ID to use for the transfer.
+ *
+ * @param[in] peripheralSignal
+ *  Selects which peripheral/peripheralsignal to use.
+ *
+ * @param[in] dst
+ *  A destination (peripheral register) memory address.
+ *
+ * @param[in] src
+ *  A source memory address.
+ *
+ * @param[in] srcInc
+ *  Set to true to enable source address increment (increments according to
+ *  @a size parameter).
+ *
+ * @param[in] len
+ *  A number of items (of @a size size) to transfer, at most
+ *  @ref DMADRV_MAX_XFER_COUNT.
+ *
+ * @param[in] size
+ *  An item size, byte, halfword or word.
+ *
+ * @param[in] callback
+ *  A function to call on DMA completion, use NULL if not needed.
+ *
+ * @param[in] cbUserParam
+ *  An optional user parameter to feed to the callback function. Use NULL if
+ *  not needed.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_MemoryPeripheral(unsigned int channelId,
+                                DMADRV_PeripheralSignal_t peripheralSignal,
+                                void *dst,
+                                void *src,
+                                bool srcInc,
+                                int len,
+                                DMADRV_DataSize_t size,
+                                DMADRV_Callback_t callback,
+                                void *cbUserParam)
+{
+  return StartTransfer(channelId,
+                       peripheralSignal,
+                       dst,
+                       src,
+                       srcInc ? LDMA_CH_CTRL_SRCINC_ONE : LDMA_CH_CTRL_SRCINC_NONE,
+                       LDMA_CH_CTRL_DSTINC_NONE,
+                       len,
+                       size,
+                       callback,
+                       cbUserParam,
+                       NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Start a peripheral to memory DMA transfer.
+ *
+ * @param[in] channelId
+ *  The channel ID to use for the transfer.
+ *
+ * @param[in] peripheralSignal
+ *  Selects which peripheral/peripheralsignal to use.
+ *
+ * @param[in] dst
+ *  A destination memory address.
+ *
+ * @param[in] src
+ *  A source memory (peripheral register) address.
+ *
+ * @param[in] dstInc
+ *  Set to true to enable destination address increment (increments according
+ *  to @a size parameter).
+ *
+ * @param[in] len
+ *  A number of items (of @a size size) to transfer, at most
+ *  @ref DMADRV_MAX_XFER_COUNT.
+ *
+ * @param[in] size
+ *  An item size, byte, halfword or word.
+ *
+ * @param[in] callback
+ *  A function to call on DMA completion, use NULL if not needed.
+ *
+ * @param[in] cbUserParam
+ *  An optional user parameter to feed to the callback function. Use NULL if
+ *  not needed.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_PeripheralMemory(unsigned int channelId,
+                                DMADRV_PeripheralSignal_t peripheralSignal,
+                                void *dst,
+                                void *src,
+                                bool dstInc,
+                                int len,
+                                DMADRV_DataSize_t size,
+                                DMADRV_Callback_t callback,
+                                void *cbUserParam)
+{
+  return StartTransfer(channelId,
+                       peripheralSignal,
+                       dst,
+                       src,
+                       LDMA_CH_CTRL_SRCINC_NONE,
+                       dstInc ? LDMA_CH_CTRL_DSTINC_ONE : LDMA_CH_CTRL_DSTINC_NONE,
+                       len,
+                       size,
+                       callback,
+                       cbUserParam,
+                       NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Start a peripheral to memory ping-pong DMA transfer.
+ *
+ * @details
+ *  The channel fills @a dst0 and @a dst1 alternately until it is stopped.
+ *  The callback is called each time a buffer has been filled. When the two
+ *  buffers are adjacent halves of one array, the transfer behaves like an
+ *  endless circular buffer.
+ *
+ * @param[in] channelId
+ *  The channel ID to use for the transfer.
+ *
+ * @param[in] peripheralSignal
+ *  Selects which peripheral/peripheralsignal to use.
+ *
+ * @param[in] dst0
+ *  A destination memory address for the first (ping) buffer.
+ *
+ * @param[in] dst1
+ *  A destination memory address for the second (pong) buffer.
+ *
+ * @param[in] src
+ *  A source memory (peripheral register) address.
+ *
+ * @param[in] dstInc
+ *  Set to true to enable destination address increment (increments according
+ *  to @a size parameter).
+ *
+ * @param[in] len
+ *  A number of items (of @a size size) to transfer into each buffer, at most
+ *  @ref DMADRV_MAX_XFER_COUNT.
+ *
+ * @param[in] size
+ *  An item size, byte, halfword or word.
+ *
+ * @param[in] callback
+ *  A function to call each time a buffer is full. Return false from it to
+ *  stop the transfer.
+ *
+ * @param[in] cbUserParam
+ *  An optional user parameter to feed to the callback function. Use NULL if
+ *  not needed.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_PeripheralMemoryPingPong(unsigned int channelId,
+                                        DMADRV_PeripheralSignal_t peripheralSignal,
+                                        void *dst0,
+                                        void *dst1,
+                                        void *src,
+                                        bool dstInc,
+                                        int len,
+                                        DMADRV_DataSize_t size,
+                                        DMADRV_Callback_t callback,
+                                        void *cbUserParam)
+{
+  if (dst1 == NULL) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  return StartTransfer(channelId,
+                       peripheralSignal,
+                       dst0,
+                       src,
+                       LDMA_CH_CTRL_SRCINC_NONE,
+                       dstInc ? LDMA_CH_CTRL_DSTINC_ONE : LDMA_CH_CTRL_DSTINC_NONE,
+                       len,
+                       size,
+                       callback,
+                       cbUserParam,
+                       dst1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Stop an ongoing DMA transfer.
+ *
+ * @param[in] channelId
+ *  The channel ID of the transfer to stop.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_StopTransfer(unsigned int channelId)
+{
+  uint32_t chMask;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if (channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  if (!chTable[channelId].allocated) {
+    return ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED;
+  }
+
+  chMask = 1UL << channelId;
+
+  CORE_ENTER_ATOMIC();
+  BUS_RegMaskedClear(&LDMA->IEN, chMask);
+  BUS_RegMaskedClear(&LDMA->CHEN, chMask);
+  LDMA->IFC = chMask;
+  CORE_EXIT_ATOMIC();
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Check if a transfer is running.
+ *
+ * @param[in] channelId
+ *  The channel ID of the transfer to check.
+ *
+ * @param[out] active
+ *  True if transfer is running, false otherwise.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_TransferActive(unsigned int channelId, bool *active)
+{
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if ((channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT)
+      || (active == NULL)) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  if (!chTable[channelId].allocated) {
+    return ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED;
+  }
+
+  *active = (LDMA->CHEN & (1UL << channelId)) != 0U;
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Check if a transfer has completed.
+ *
+ * @param[in] channelId
+ *  The channel ID of the transfer to check.
+ *
+ * @param[out] done
+ *  True if a transfer has completed, false otherwise.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_TransferDone(unsigned int channelId, bool *done)
+{
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if ((channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT)
+      || (done == NULL)) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  if (!chTable[channelId].allocated) {
+    return ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED;
+  }
+
+  *done = (LDMA->CHDONE & (1UL << channelId)) != 0U;
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Get number of items remaining in a transfer.
+ *
+ * @param[in] channelId
+ *  The channel ID of the transfer to check.
+ *
+ * @param[out] remaining
+ *  A number of items remaining in the transfer.
+ *
+ * @return
+ *  @ref ECODE_EMDRV_DMADRV_OK on success. On failure, an appropriate
+ *  DMADRV @ref Ecode_t is returned.
+ ******************************************************************************/
+Ecode_t DMADRV_TransferRemainingCount(unsigned int channelId, int *remaining)
+{
+  uint32_t chMask;
+  uint32_t done;
+  uint32_t iflag;
+  uint32_t count;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if ((channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT)
+      || (remaining == NULL)) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  if (!chTable[channelId].allocated) {
+    return ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED;
+  }
+
+  chMask = 1UL << channelId;
+
+  CORE_ENTER_ATOMIC();
+  iflag = LDMA->IF & chMask;
+  done  = LDMA->CHDONE & chMask;
+  count = (LDMA->CH[channelId].CTRL & _LDMA_CH_CTRL_XFERCNT_MASK)
+          >> _LDMA_CH_CTRL_XFERCNT_SHIFT;
+  CORE_EXIT_ATOMIC();
+
+  if ((done != 0U) || ((count == 0U) && (iflag != 0U))) {
+    *remaining = 0;
+  } else {
+    *remaining = (int)count + 1;
+  }
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/***************************************************************************//**
+ * @brief
+ *  Interrupt handler for LDMA.
+ ******************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  bool stop;
+  ChTable_t *ch;
+  uint32_t pending;
+  uint32_t chnum;
+  uint32_t chmask;
+
+  /* Get all pending and enabled interrupts. */
+  pending = LDMA->IF & LDMA->IEN;
+
+  /* Check for LDMA error. */
+  if ((pending & LDMA_IF_ERROR) != 0U) {
+    /* A descriptor pointed at an illegal address, nothing sane to do. */
+    EFM_ASSERT(false);
+    while (true) {
+    }
+  }
+
+  /* Iterate over all active channels. */
+  while ((pending & ~LDMA_IF_ERROR) != 0U) {
+    chnum  = SL_CTZ(pending & ~LDMA_IF_ERROR);
+    chmask = 1UL << chnum;
+    pending &= ~chmask;
+
+    /* Clear interrupt flag before the callback may restart the channel. */
+    LDMA->IFC = chmask;
+
+    if (chnum >= (uint32_t)EMDRV_DMADRV_DMA_CH_COUNT) {
+      continue;
+    }
+
+    ch = &chTable[chnum];
+    if (ch->callback != NULL) {
+      ch->callbackCount++;
+      stop = !ch->callback(chnum, ch->callbackCount, ch->userParam);
+
+      if (stop && ((LDMA->CHEN & chmask) != 0U)) {
+        BUS_RegMaskedClear(&LDMA->CHEN, chmask);
+        BUS_RegMaskedClear(&LDMA->IEN, chmask);
+      }
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Program the channel descriptors and start a transfer. A single transfer
+ *  when @a dst1 is NULL, otherwise an endless ping-pong between dst and dst1.
+ ******************************************************************************/
+static Ecode_t StartTransfer(unsigned int channelId,
+                             DMADRV_PeripheralSignal_t peripheralSignal,
+                             void *dst,
+                             void *src,
+                             uint32_t srcInc,
+                             uint32_t dstInc,
+                             int len,
+                             DMADRV_DataSize_t size,
+                             DMADRV_Callback_t callback,
+                             void *cbUserParam,
+                             void *dst1)
+{
+  uint32_t chMask;
+  ChTable_t *ch;
+  DMA_DESCRIPTOR_TypeDef *desc;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (!initialized) {
+    return ECODE_EMDRV_DMADRV_NOT_INITIALIZED;
+  }
+
+  if (channelId >= (unsigned int)EMDRV_DMADRV_DMA_CH_COUNT) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  ch = &chTable[channelId];
+  if (!ch->allocated) {
+    return ECODE_EMDRV_DMADRV_CH_NOT_ALLOCATED;
+  }
+
+  if ((len < 1) || (len > (int)DMADRV_MAX_XFER_COUNT)) {
+    return ECODE_EMDRV_DMADRV_PARAM_ERROR;
+  }
+
+  chMask = 1UL << channelId;
+  desc   = descriptors[channelId];
+
+  desc[0].CTRL = LDMA_CH_CTRL_STRUCTTYPE_TRANSFER
+                 | ((uint32_t)(len - 1) << _LDMA_CH_CTRL_XFERCNT_SHIFT)
+                 | LDMA_CH_CTRL_BLOCKSIZE_UNIT1
+                 | LDMA_CH_CTRL_DONEIFSEN
+                 | LDMA_CH_CTRL_REQMODE_BLOCK
+                 | srcInc
+                 | ((uint32_t)size << _LDMA_CH_CTRL_SIZE_SHIFT)
+                 | dstInc;
+  desc[0].SRC  = src;
+  desc[0].DST  = dst;
+  desc[0].LINK = 0;
+
+  if (dst1 != NULL) {
+    /* Each descriptor links to the other one, so the channel never stops */
+    desc[1]      = desc[0];
+    desc[1].DST  = dst1;
+    desc[0].LINK = (void *)(((uint32_t)&desc[1] & _LDMA_CH_LINK_LINKADDR_MASK)
+                            | LDMA_CH_LINK_LINKMODE_ABSOLUTE
+                            | LDMA_CH_LINK_LINK);
+    desc[1].LINK = (void *)(((uint32_t)&desc[0] & _LDMA_CH_LINK_LINKADDR_MASK)
+                            | LDMA_CH_LINK_LINKMODE_ABSOLUTE
+                            | LDMA_CH_LINK_LINK);
+  }
+
+  ch->callback      = callback;
+  ch->userParam     = cbUserParam;
+  ch->callbackCount = 0;
+
+  CORE_ENTER_ATOMIC();
+  LDMA->IFC = chMask;
+  LDMA->REQCLEAR = chMask;
+  LDMA->CH[channelId].REQSEL = (uint32_t)peripheralSignal;
+  LDMA->CH[channelId].LOOP   = 0;
+  LDMA->CH[channelId].CFG    = LDMA_CH_CFG_ARBSLOTS_ONE;
+  LDMA->CH[channelId].LINK   = (uint32_t)desc & _LDMA_CH_LINK_LINKADDR_MASK;
+  BUS_RegMaskedSet(&LDMA->IEN, chMask);
+  LDMA->LINKLOAD = chMask;
+  CORE_EXIT_ATOMIC();
+
+  return ECODE_EMDRV_DMADRV_OK;
+}
+
+/** @endcond */
@@ -18,7 +18,10 @@
 #ifndef GPIOINTERRUPT_H
 #define GPIOINTERRUPT_H
 
+#include <stdbool.h>
 #include "em_device.h"
+#include "em_gpio.h"
+#include "gpiointring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +37,22 @@ extern "C" {
  * @{
  ******************************************************************************/
 
+/*******************************************************************************
+ ****************************   CONFIGURATION   ********************************
+ ******************************************************************************/
+
+/** Number of edges the edge queue holds, a power of two. 0 leaves the edge
+ *  queue out. */
+#ifndef GPIOINT_EDGE_QUEUE_SIZE
+#define GPIOINT_EDGE_QUEUE_SIZE    64
+#endif
+
+/** Time stamp of the queued edges, read once per dispatcher run. The RTCC
+ *  keeps counting in EM2, at the price of its tick resolution. */
+#ifndef GPIOINT_EDGE_TIMESTAMP
+#define GPIOINT_EDGE_TIMESTAMP()   RTCC_CounterGet()
+#endif
+
 /*******************************************************************************
  *******************************   TYPEDEFS   **********************************
  ******************************************************************************/
@@ -53,6 +72,13 @@ typedef void (*GPIOINT_IrqCallbackPtr_t)(uint8_t intNo);
 void GPIOINT_Init(void);
 void GPIOINT_CallbackRegister(uint8_t intNo, GPIOINT_IrqCallbackPtr_t callbackPtr);
 static __INLINE void GPIOINT_CallbackUnRegister(uint8_t intNo);
+#if (GPIOINT_EDGE_QUEUE_SIZE > 0)
+void GPIOINT_EdgeQueueEnable(uint8_t intNo, GPIO_Port_TypeDef port, unsigned int pin);
+void GPIOINT_EdgeQueueDisable(uint8_t intNo);
+bool GPIOINT_EdgeGet(GPIOINT_Edge_t *edge);
+uint32_t GPIOINT_EdgeOverflows(void);
+uint32_t GPIOINT_EdgeHighWater(void);
+#endif
 
 /***************************************************************************//**
  * @brief
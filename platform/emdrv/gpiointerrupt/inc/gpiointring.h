@@ -0,0 +1,79 @@
+/***************************************************************************//**
+ * @file
+ * @brief Edge ring buffer used by the GPIOINT edge queue.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef GPIOINTRING_H
+#define GPIOINTRING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup emdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup GPIOINT
+ * @{
+ ******************************************************************************/
+
+/** One pin interrupt as seen by the dispatcher. */
+typedef struct {
+  uint32_t timestamp;   /**< GPIOINT_EDGE_TIMESTAMP() when the dispatcher ran */
+  uint8_t  intNo;       /**< Pin interrupt number, 0 to 15 */
+  uint8_t  level;       /**< Pin level read by the dispatcher, 0 or 1 */
+  uint16_t dropped;     /**< Edges lost to a full ring just before this one, saturates */
+} GPIOINT_Edge_t;
+
+/**
+ * Single producer / single consumer edge ring.
+ *
+ * The producer (GPIO interrupt) only advances @ref put and the consumer
+ * (main loop) only advances @ref get. Both are free running, so the fill
+ * level is always put - get. An edge is stored before put publishes it and
+ * read before get releases its slot; the core sees its own stores in order,
+ * so on a single core a compiler barrier is all the ordering needed. The
+ * ring does not know anything about the hardware, so it can be compiled and
+ * exercised on a host.
+ */
+typedef struct {
+  GPIOINT_Edge_t    *buf;       /**< Storage, size edges */
+  uint32_t          size;       /**< Storage size, must be a power of two */
+  volatile uint32_t put;        /**< Free running write counter */
+  volatile uint32_t get;        /**< Free running read counter */
+  volatile uint32_t overflows;  /**< Edges lost to a full ring, producer only */
+  uint32_t          unreported; /**< Losses not yet carried by an edge, producer only */
+  uint32_t          highWater;  /**< Highest fill level seen, producer only */
+} GPIOINT_Ring_t;
+
+void     GPIOINT_RingInit(GPIOINT_Ring_t *ring, GPIOINT_Edge_t *buf, uint32_t size);
+uint32_t GPIOINT_RingUsed(const GPIOINT_Ring_t *ring);
+bool     GPIOINT_RingPush(GPIOINT_Ring_t *ring, const GPIOINT_Edge_t *edge);
+bool     GPIOINT_RingPop(GPIOINT_Ring_t *ring, GPIOINT_Edge_t *edge);
+
+/** @} (end addtogroup GPIOINT) */
+/** @} (end addtogroup emdrv) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPIOINTRING_H */
@@ -17,6 +17,7 @@
 
 #include "em_gpio.h"
 #include "em_core.h"
+#include "em_rtcc.h"
 #include "gpiointerrupt.h"
 #include "em_assert.h"
 #include "em_common.h"
@@ -46,6 +47,18 @@ typedef struct {
 /* Array of user callbacks. One for each pin interrupt number. */
 static GPIOINT_IrqCallbackPtr_t gpioCallbacks[16] = { 0 };
 
+#if (GPIOINT_EDGE_QUEUE_SIZE > 0)
+/* Pin interrupt numbers whose edges are queued, and the pin each one reads. */
+static uint32_t edgeQueueMask = 0;
+static struct {
+  uint8_t port;
+  uint8_t pin;
+} edgePins[16];
+
+static GPIOINT_Edge_t edgeBuf[GPIOINT_EDGE_QUEUE_SIZE];
+static GPIOINT_Ring_t edgeRing = { edgeBuf, GPIOINT_EDGE_QUEUE_SIZE, 0, 0, 0, 0, 0 };
+#endif
+
 /*******************************************************************************
  ******************************   PROTOTYPES   *********************************
  ******************************************************************************/
@@ -93,6 +106,85 @@ void GPIOINT_CallbackRegister(uint8_t intNo, GPIOINT_IrqCallbackPtr_t callbackPt
     )
 }
 
+#if (GPIOINT_EDGE_QUEUE_SIZE > 0)
+/***************************************************************************//**
+ * @brief
+ *   Queues the edges of a pin interrupt number.
+ *
+ * @details
+ *   From then on every interrupt of intNo puts a time stamped edge with the
+ *   level of the pin in a ring that the main loop drains with
+ *   GPIOINT_EdgeGet(), before the callback, if any, is called. The interrupt
+ *   itself must be configured externally, and both edges enabled to see the
+ *   pin go both ways. An edge that finds the ring full is counted by
+ *   GPIOINT_EdgeOverflows() and by the dropped field of the next queued edge.
+ *
+ * @param[in] intNo
+ *   Pin interrupt number.
+ * @param[in] port
+ *   Port of the pin whose level is read.
+ * @param[in] pin
+ *   Pin whose level is read.
+ ******************************************************************************/
+void GPIOINT_EdgeQueueEnable(uint8_t intNo, GPIO_Port_TypeDef port, unsigned int pin)
+{
+  EFM_ASSERT(intNo < 16);
+
+  CORE_ATOMIC_SECTION(
+    edgePins[intNo].port = (uint8_t)port;
+    edgePins[intNo].pin = (uint8_t)pin;
+    edgeQueueMask |= 1UL << intNo;
+    )
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops queueing the edges of a pin interrupt number.
+ *
+ * @param[in] intNo
+ *   Pin interrupt number.
+ ******************************************************************************/
+void GPIOINT_EdgeQueueDisable(uint8_t intNo)
+{
+  CORE_ATOMIC_SECTION(
+    edgeQueueMask &= ~(1UL << intNo);
+    )
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the oldest queued edge. Main loop only, there is one consumer.
+ *
+ * @param[out] edge
+ *   Receives the edge.
+ *
+ * @return
+ *   false if no edge is queued.
+ ******************************************************************************/
+bool GPIOINT_EdgeGet(GPIOINT_Edge_t *edge)
+{
+  return GPIOINT_RingPop(&edgeRing, edge);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Edges lost to a full queue since boot.
+ ******************************************************************************/
+uint32_t GPIOINT_EdgeOverflows(void)
+{
+  return edgeRing.overflows;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Highest number of edges the queue held since boot.
+ ******************************************************************************/
+uint32_t GPIOINT_EdgeHighWater(void)
+{
+  return edgeRing.highWater;
+}
+#endif
+
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 
 /***************************************************************************//**
@@ -112,14 +204,33 @@ static void GPIOINT_IRQDispatcher(uint32_t iflags)
 {
   uint32_t irqIdx;
   GPIOINT_IrqCallbackPtr_t callback;
+#if (GPIOINT_EDGE_QUEUE_SIZE > 0)
+  GPIOINT_Edge_t edge;
+
+  /* One time stamp for all the flags latched by this interrupt. */
+  if ((iflags & edgeQueueMask) != 0U) {
+    edge.timestamp = GPIOINT_EDGE_TIMESTAMP();
+  }
+#endif
 
   /* check for all flags set in IF register */
   while (iflags != 0U) {
+    /* Lowest set flag, count trailing zeros is a CLZ of the bit reversed
+     * flags on Cortex-M3 and up, no scan of the clear bits. */
     irqIdx = SL_CTZ(iflags);
 
     /* clear flag*/
     iflags &= ~(1 << irqIdx);
 
+#if (GPIOINT_EDGE_QUEUE_SIZE > 0)
+    if ((edgeQueueMask & (1UL << irqIdx)) != 0U) {
+      edge.intNo = (uint8_t)irqIdx;
+      edge.level = (uint8_t)GPIO_PinInGet((GPIO_Port_TypeDef)edgePins[irqIdx].port,
+                                          edgePins[irqIdx].pin);
+      GPIOINT_RingPush(&edgeRing, &edge);
+    }
+#endif
+
     callback = gpioCallbacks[irqIdx];
     if (callback) {
       /* call user callback */
@@ -218,6 +329,11 @@ void GPIO_ODD_IRQHandler(void)
 ///   @ref GPIOINT_CallbackUnRegister() @n
 ///    Un-register a callback function on a pin interrupt number.
 ///
+///   @ref GPIOINT_EdgeQueueEnable(), @ref GPIOINT_EdgeQueueDisable() @n
+///    Start or stop queueing time stamped edges of a pin interrupt number,
+///    for the main loop to take with @ref GPIOINT_EdgeGet(). Lost edges are
+///    counted by @ref GPIOINT_EdgeOverflows().
+///
 ///   @n @section gpioint_example Example
 ///   @code{.c}
 ///
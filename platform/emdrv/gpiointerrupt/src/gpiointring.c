@@ -0,0 +1,123 @@
+/***************************************************************************//**
+ * @file
+ * @brief Edge ring buffer used by the GPIOINT edge queue.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include "gpiointring.h"
+
+/***************************************************************************//**
+ * @addtogroup emdrv
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup GPIOINT
+ * @{
+ ******************************************************************************/
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/* Keeps the compiler from moving memory accesses across the publication of
+ * put or get. */
+#define RING_BARRIER()  __asm__ volatile ("" ::: "memory")
+
+/** @endcond */
+
+/**************************************************************************//**
+ * @brief Initialize an empty ring
+ * @param ring Ring to initialize
+ * @param buf Backing storage
+ * @param size Number of edges in buf, must be a power of two
+ *****************************************************************************/
+void GPIOINT_RingInit(GPIOINT_Ring_t *ring, GPIOINT_Edge_t *buf, uint32_t size)
+{
+  ring->buf        = buf;
+  ring->size       = size;
+  ring->put        = 0;
+  ring->get        = 0;
+  ring->overflows  = 0;
+  ring->unreported = 0;
+  ring->highWater  = 0;
+}
+
+/**************************************************************************//**
+ * @brief Number of edges waiting to be drained
+ *****************************************************************************/
+uint32_t GPIOINT_RingUsed(const GPIOINT_Ring_t *ring)
+{
+  return ring->put - ring->get;
+}
+
+/**************************************************************************//**
+ * @brief Enqueue one edge, producer side
+ * @param ring Ring to write to
+ * @param edge Edge to copy, its dropped field is filled in by the ring
+ * @return false if the ring was full and the edge was counted as lost
+ *****************************************************************************/
+bool GPIOINT_RingPush(GPIOINT_Ring_t *ring, const GPIOINT_Edge_t *edge)
+{
+  uint32_t put  = ring->put;
+  uint32_t used = put - ring->get;
+  GPIOINT_Edge_t *slot;
+
+  if (used >= ring->size) {
+    ring->overflows++;
+    ring->unreported++;
+    return false;
+  }
+
+  slot = &ring->buf[put & (ring->size - 1)];
+  *slot = *edge;
+  slot->dropped = (ring->unreported > 0xFFFFu) ? 0xFFFFu : (uint16_t)ring->unreported;
+  ring->unreported = 0;
+
+  /* Publish the edge only after it has been stored. */
+  RING_BARRIER();
+  ring->put = put + 1;
+
+  if ((used + 1) > ring->highWater) {
+    ring->highWater = used + 1;
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Dequeue the oldest edge, consumer side
+ * @param ring Ring to read from
+ * @param edge Receives the edge
+ * @return false if the ring was empty
+ *****************************************************************************/
+bool GPIOINT_RingPop(GPIOINT_Ring_t *ring, GPIOINT_Edge_t *edge)
+{
+  uint32_t get = ring->get;
+
+  if (ring->put == get) {
+    return false;
+  }
+
+  /* The edge is complete once put covers it. */
+  RING_BARRIER();
+  *edge = ring->buf[get & (ring->size - 1)];
+
+  /* Release the slot only after it has been read. */
+  RING_BARRIER();
+  ring->get = get + 1;
+
+  return true;
+}
+
+/** @} (end addtogroup GPIOINT) */
+/** @} (end addtogroup emdrv) */
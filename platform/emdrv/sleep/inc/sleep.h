@@ -153,6 +153,13 @@ extern "C" {
 #define SLEEP_LOWEST_ENERGY_MODE_DEFAULT    sleepEM3
 #endif
 
+/** Enable/disable calling SLEEP_SleepHook(), SLEEP_WakeupHook() and
+ *  SLEEP_RestoreHook(). The driver provides empty weak definitions, an
+ *  application that wants to time the sleep and wakeup path overrides them. */
+#ifndef SLEEP_HOOKS_ENABLED
+#define SLEEP_HOOKS_ENABLED                  true
+#endif
+
 /*******************************************************************************
  ******************************   TYPEDEFS   ***********************************
  ******************************************************************************/
@@ -239,6 +246,12 @@ void SLEEP_SleepBlockBegin(SLEEP_EnergyMode_t eMode);
 
 void SLEEP_SleepBlockEnd(SLEEP_EnergyMode_t eMode);
 
+void SLEEP_SleepHook(SLEEP_EnergyMode_t allowedEM);
+
+void SLEEP_WakeupHook(SLEEP_EnergyMode_t eMode);
+
+void SLEEP_RestoreHook(SLEEP_EnergyMode_t modeEntered);
+
 /** @} (end addtogroup SLEEP) */
 /** @} (end addtogroup emdrv) */
 
@@ -21,6 +21,7 @@
 #include "em_core.h"
 #include "em_rmu.h"
 #include "em_emu.h"
+#include "em_common.h"
 
 /* Module header file(s). */
 #include "sleep.h"
@@ -200,6 +201,9 @@ SLEEP_EnergyMode_t SLEEP_Sleep(void)
   /* Critical section to allow sleep blocks in ISRs. */
   CORE_ENTER_CRITICAL();
   allowedEM = SLEEP_LowestEnergyModeGet();
+#if (SLEEP_HOOKS_ENABLED == true)
+  SLEEP_SleepHook(allowedEM);
+#endif
   if (allowedEM == sleepEM2 || allowedEM == sleepEM3) {
     EMU_Save();
   }
@@ -219,6 +223,11 @@ SLEEP_EnergyMode_t SLEEP_Sleep(void)
   if (modeEntered == sleepEM2 || modeEntered == sleepEM3) {
     EMU_Restore();
   }
+#if (SLEEP_HOOKS_ENABLED == true)
+  if (modeEntered != sleepEM0) {
+    SLEEP_RestoreHook(modeEntered);
+  }
+#endif
   CORE_EXIT_CRITICAL();
 
   return modeEntered;
@@ -369,6 +378,58 @@ SLEEP_EnergyMode_t SLEEP_LowestEnergyModeGet(void)
   return tmpLowestEM;
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Called by SLEEP_Sleep() with interrupts disabled, before the sleep.
+ *
+ * @details
+ *   The default does nothing. An application can override it, for instance
+ *   to count the sleeps that sleep blocks kept out of the lowest energy mode.
+ *
+ * @param[in] allowedEM
+ *   Lowest energy mode the sleep blocks allow, see
+ *   SLEEP_LowestEnergyModeGet().
+ ******************************************************************************/
+SL_WEAK void SLEEP_SleepHook(SLEEP_EnergyMode_t allowedEM)
+{
+  (void) allowedEM;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Called on wakeup with interrupts disabled, right after the instruction
+ *   that entered the energy mode and before the wakeup callback.
+ *
+ * @details
+ *   The default does nothing. The interrupt that woke the core is still
+ *   pending, and for EM2 and EM3 the core runs from the wakeup clock until
+ *   SLEEP_RestoreHook().
+ *
+ * @param[in] eMode
+ *   Energy mode the core woke up from.
+ ******************************************************************************/
+SL_WEAK void SLEEP_WakeupHook(SLEEP_EnergyMode_t eMode)
+{
+  (void) eMode;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Called by SLEEP_Sleep() with interrupts disabled once the wakeup path is
+ *   complete and the clocks are restored, just before the interrupt that woke
+ *   the core is allowed to run.
+ *
+ * @details
+ *   The default does nothing. Not called when no energy mode was entered.
+ *
+ * @param[in] modeEntered
+ *   Energy mode the core woke up from.
+ ******************************************************************************/
+SL_WEAK void SLEEP_RestoreHook(SLEEP_EnergyMode_t modeEntered)
+{
+  (void) modeEntered;
+}
+
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 
 /***************************************************************************//**
@@ -425,6 +486,11 @@ static SLEEP_EnergyMode_t enterEMx(SLEEP_EnergyMode_t eMode)
       break;
   }
 
+#if (SLEEP_HOOKS_ENABLED == true)
+  /* First instruction after the wakeup, before anything else runs. */
+  SLEEP_WakeupHook(eMode);
+#endif
+
   /* Call the callback after waking up from sleep. */
   if (NULL != sleepContext.wakeupCallback) {
     sleepContext.wakeupCallback(eMode);
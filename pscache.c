@@ -0,0 +1,343 @@
+/***************************************************************************//**
+ * @file
+ * @brief RAM write-back cache in front of the flash PS keys
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#ifdef PSCACHE_HOST_MODEL
+#include "ps_model.h"
+#define PSCACHE_TIMESTAMP()		PS_MODEL_Ticks()
+#else
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#define PSCACHE_TIMESTAMP()		RTCC_CounterGet()
+#endif
+
+#include "pscache.h"
+
+typedef struct {
+	bool used;
+	bool present;							// false: the PS has no such key
+	bool dirty;
+	uint8_t len;
+	uint16_t key;
+	uint32_t lastUse;						// useCounter at the last access, for LRU
+	uint32_t dirtySince;					// PSCACHE_TIMESTAMP() of the first unflushed save
+	uint8_t value[PSCACHE_VALUE_SIZE];
+} Entry_t;
+
+static Entry_t entries[PSCACHE_ENTRIES];
+static uint32_t useCounter;
+static PSCACHE_Stats_t stats;
+
+#ifdef PSCACHE_HOST_MODEL
+#define psSave					PS_MODEL_Save
+#define psLoad					PS_MODEL_Load
+#define psErase					PS_MODEL_Erase
+#else
+static uint16_t psSave(uint16_t key, const uint8_t *value, uint8_t len)
+{
+	return gecko_cmd_flash_ps_save(key, len, value)->result;
+}
+
+/* *len is the buffer size on the way in and the value length on the way out */
+static uint16_t psLoad(uint16_t key, uint8_t *value, uint8_t *len)
+{
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(key);
+
+	if(rsp->result == 0)
+	{
+		memcpy(value, rsp->value.data, (rsp->value.len < *len) ? rsp->value.len : *len);
+		*len = rsp->value.len;
+	}
+	return rsp->result;
+}
+
+static uint16_t psErase(uint16_t key)
+{
+	return gecko_cmd_flash_ps_erase(key)->result;
+}
+#endif
+
+static Entry_t *find(uint16_t key)
+{
+	for(uint32_t i = 0; i < PSCACHE_ENTRIES; i++)
+	{
+		if(entries[i].used && entries[i].key == key)
+		{
+			entries[i].lastUse = ++useCounter;
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+static bool writeBack(Entry_t *entry)
+{
+	uint16_t result = entry->present ? psSave(entry->key, entry->value, entry->len) : psErase(entry->key);
+
+	stats.flushes++;
+	if(result != 0 && !(result == bg_err_hardware_ps_key_not_found && !entry->present))
+	{
+		stats.flushErrors++;
+		return false;
+	}
+	entry->dirty = false;
+	stats.dirty--;
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Frees an entry for the given key, preferring the least recently
+* used clean one. A dirty one is written back first
+* @return NULL if every candidate failed to write back
+*****************************************************************************/
+static Entry_t *allocate(uint16_t key)
+{
+	Entry_t *victim = NULL;
+
+	for(uint32_t i = 0; i < PSCACHE_ENTRIES; i++)
+	{
+		Entry_t *entry = &entries[i];
+
+		if(!entry->used)
+		{
+			victim = entry;
+			break;
+		}
+		if(victim == NULL
+				|| (victim->dirty && !entry->dirty)
+				|| (victim->dirty == entry->dirty && entry->lastUse < victim->lastUse))
+		{
+			victim = entry;
+		}
+	}
+
+	if(victim->used)
+	{
+		if(victim->dirty)
+		{
+			stats.evictionFlushes++;
+			if(!writeBack(victim))
+			{
+				return NULL;
+			}
+		}
+		stats.evictions++;
+	}
+
+	memset(victim, 0, sizeof(*victim));
+	victim->used = true;
+	victim->key = key;
+	victim->lastUse = ++useCounter;
+	return victim;
+}
+
+void PSCACHE_Init(void)
+{
+	memset(entries, 0, sizeof(entries));
+	memset(&stats, 0, sizeof(stats));
+	useCounter = 0;
+}
+
+/**************************************************************************//**
+* @brief Reads a key, from RAM when it was seen before
+* @param len Size of value on the way in, length of the stored value on the
+* way out. A value longer than the buffer is cut short
+*****************************************************************************/
+uint16_t PSCACHE_Load(uint16_t key, void *value, uint8_t *len)
+{
+	Entry_t *entry = find(key);
+	uint8_t buffer[PSCACHE_VALUE_SIZE];
+	uint8_t got = sizeof(buffer);
+	uint16_t result;
+
+	stats.loads++;
+
+	if(entry == NULL)
+	{
+		result = psLoad(key, buffer, &got);
+		if(result != 0 && result != bg_err_hardware_ps_key_not_found)
+		{
+			return result;
+		}
+		if(result == 0 && got > sizeof(buffer))
+		{
+			stats.bypassed++;
+			return psLoad(key, value, len);
+		}
+
+		entry = allocate(key);
+		if(entry == NULL)
+		{
+			stats.bypassed++;
+			return psLoad(key, value, len);
+		}
+		entry->present = (result == 0);
+		entry->len = entry->present ? got : 0;
+		memcpy(entry->value, buffer, entry->len);
+	}
+	else
+	{
+		stats.hits++;
+	}
+
+	if(!entry->present)
+	{
+		return bg_err_hardware_ps_key_not_found;
+	}
+	memcpy(value, entry->value, (entry->len < *len) ? entry->len : *len);
+	*len = entry->len;
+	return 0;
+}
+
+static void markDirty(Entry_t *entry)
+{
+	if(entry->dirty)
+	{
+		stats.coalesced++;
+		return;
+	}
+	entry->dirty = true;
+	entry->dirtySince = PSCACHE_TIMESTAMP();
+	stats.dirty++;
+}
+
+/**************************************************************************//**
+* @brief Updates a key in RAM, the PS write happens later
+*****************************************************************************/
+uint16_t PSCACHE_Save(uint16_t key, const void *value, uint8_t len)
+{
+	Entry_t *entry;
+
+	stats.saves++;
+
+	if(len > PSCACHE_VALUE_SIZE)
+	{
+		/* The PS copy becomes the only one */
+		entry = find(key);
+		if(entry != NULL)
+		{
+			stats.dirty -= entry->dirty;
+			entry->used = false;
+		}
+		stats.bypassed++;
+		return psSave(key, value, len);
+	}
+
+	entry = find(key);
+	if(entry != NULL && entry->present && entry->len == len && memcmp(entry->value, value, len) == 0)
+	{
+		stats.unchanged++;
+		return 0;
+	}
+	if(entry == NULL)
+	{
+		entry = allocate(key);
+		if(entry == NULL)
+		{
+			stats.bypassed++;
+			return psSave(key, value, len);
+		}
+	}
+
+	entry->present = true;
+	entry->len = len;
+	memcpy(entry->value, value, len);
+	markDirty(entry);
+	return 0;
+}
+
+/**************************************************************************//**
+* @brief Removes a key. The erase is cached like a save
+*****************************************************************************/
+uint16_t PSCACHE_Erase(uint16_t key)
+{
+	Entry_t *entry = find(key);
+
+	if(entry != NULL && !entry->present)
+	{
+		stats.unchanged++;
+		return 0;
+	}
+	if(entry == NULL)
+	{
+		entry = allocate(key);
+		if(entry == NULL)
+		{
+			stats.bypassed++;
+			return psErase(key);
+		}
+	}
+
+	entry->present = false;
+	entry->len = 0;
+	markDirty(entry);
+	return 0;
+}
+
+/**************************************************************************//**
+* @brief Writes back the key dirty for longest, once it is PSCACHE_FLUSH_DELAY
+* old. Call while the event loop is idle
+*****************************************************************************/
+void PSCACHE_Poll(void)
+{
+	uint32_t now = PSCACHE_TIMESTAMP();
+	Entry_t *oldest = NULL;
+
+	if(stats.dirty == 0)
+	{
+		return;
+	}
+
+	for(uint32_t i = 0; i < PSCACHE_ENTRIES; i++)
+	{
+		Entry_t *entry = &entries[i];
+
+		if(entry->used && entry->dirty && (oldest == NULL || (int32_t)(entry->dirtySince - oldest->dirtySince) < 0))
+		{
+			oldest = entry;
+		}
+	}
+
+	if(oldest != NULL && now - oldest->dirtySince >= PSCACHE_FLUSH_DELAY)
+	{
+		writeBack(oldest);
+	}
+}
+
+/**************************************************************************//**
+* @brief Writes back every dirty key now
+* @return Number of keys that could not be written
+*****************************************************************************/
+uint32_t PSCACHE_Flush(void)
+{
+	uint32_t failed = 0;
+
+	for(uint32_t i = 0; i < PSCACHE_ENTRIES; i++)
+	{
+		if(entries[i].used && entries[i].dirty && !writeBack(&entries[i]))
+		{
+			failed++;
+		}
+	}
+	return failed;
+}
+
+void PSCACHE_GetStats(PSCACHE_Stats_t *out)
+{
+	*out = stats;
+}
@@ -0,0 +1,76 @@
+/***************************************************************************//**
+ * @file
+ * @brief RAM write-back cache in front of the flash PS keys
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PSCACHE_H_
+#define PSCACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Loads are served from RAM after the first one, including keys the PS does
+ * not have. Saves only update RAM; a key that stays dirty for
+ * PSCACHE_FLUSH_DELAY is written by PSCACHE_Poll(), one key per call, so a
+ * value saved many times in a row costs one flash write. PSCACHE_Flush()
+ * writes everything at once, e.g. before a reset. When all entries are in
+ * use the least recently used one is dropped, written back first if dirty.
+ * Values longer than PSCACHE_VALUE_SIZE bypass the cache.
+ *
+ * Stalls: PSCACHE_VALUE_SIZE is the longest value the PS takes, so a save
+ * never bypasses the cache for its length. Save, Load and Erase then only
+ * write the PS to evict a dirty entry when every entry is dirty, which the
+ * firmware's three keys never cause. Every other write is made by
+ * PSCACHE_Poll() or PSCACHE_Flush(). A PS write that finds the NVM3 log full
+ * compacts it first, erasing every page, so the worst case of a single
+ * PSCACHE_Poll() is about 80 ms with three pages (tools/pscache_sim); the
+ * cache makes these rarer, it cannot make one shorter.
+ *
+ * Results are the stack's: 0 or a bg_err_* code. Built with
+ * -DPSCACHE_HOST_MODEL the module runs on a PC against tools/ps_model.c. */
+
+#ifndef PSCACHE_ENTRIES
+#define PSCACHE_ENTRIES			8
+#endif
+#ifndef PSCACHE_VALUE_SIZE
+#define PSCACHE_VALUE_SIZE		56			// Longest value kept in RAM, the PS maximum
+#endif
+#ifndef PSCACHE_FLUSH_DELAY
+#define PSCACHE_FLUSH_DELAY		(5 * 32768)	// RTCC ticks a key stays dirty before the idle flush
+#endif
+
+typedef struct {
+	uint32_t loads;
+	uint32_t hits;							// Loads served from RAM
+	uint32_t saves;
+	uint32_t coalesced;						// Saves to a key that was already dirty
+	uint32_t unchanged;						// Saves of the value the key already had
+	uint32_t flushes;						// PS writes done for the cache
+	uint32_t flushErrors;
+	uint32_t evictions;						// Entries dropped for space
+	uint32_t evictionFlushes;				// Of those, dirty ones written back by a load or save
+	uint32_t bypassed;						// Operations sent straight to the PS
+	uint32_t dirty;							// Keys waiting for a flush
+} PSCACHE_Stats_t;
+
+void PSCACHE_Init(void);
+uint16_t PSCACHE_Load(uint16_t key, void *value, uint8_t *len);
+uint16_t PSCACHE_Save(uint16_t key, const void *value, uint8_t len);
+uint16_t PSCACHE_Erase(uint16_t key);
+void PSCACHE_Poll(void);
+uint32_t PSCACHE_Flush(void);
+void PSCACHE_GetStats(PSCACHE_Stats_t *stats);
+
+#endif
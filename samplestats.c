@@ -0,0 +1,270 @@
+/***************************************************************************//**
+ * @file
+ * @brief Running statistics and p95/p99 of a series of link samples
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "samplestats.h"
+
+#if defined(SAMPLESTATS_HOST_MODEL)
+#include "simd_model.h"
+#define SIMD		1
+#elif defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "em_device.h"		// __SMLAD and the other SIMD intrinsics of cmsis_gcc.h
+#define SIMD		1
+#else
+#define SIMD		0
+#endif
+
+/**************************************************************************//**
+* @brief Sum, sum of squares, minimum and maximum of a block of samples.
+* The sum is 32 bit inside, enough for 65536 samples
+*****************************************************************************/
+void SAMPLESTATS_Reduce(const int16_t *samples, uint32_t count, SAMPLESTATS_Moments_t *moments)
+{
+	int32_t sum = 0;
+	uint64_t squares = 0;
+	int16_t min = INT16_MAX;
+	int16_t max = INT16_MIN;
+	uint32_t i = 0;
+
+#if SIMD
+	uint32_t mins = 0x7FFF7FFFu;
+	uint32_t maxs = 0x80008000u;
+
+	/* Two samples a word: one instruction adds both to the sum, one their
+	 * squares, two keep each half's minimum or maximum */
+	for(; i + 2 <= count; i += 2)
+	{
+		uint32_t pair;
+
+		memcpy(&pair, &samples[i], sizeof(pair));
+		sum = (int32_t)__SMLAD(pair, 0x00010001u, (uint32_t)sum);
+		squares = __SMLALD(pair, pair, squares);
+		__SSUB16(pair, maxs);
+		maxs = __SEL(pair, maxs);
+		__SSUB16(mins, pair);
+		mins = __SEL(pair, mins);
+	}
+	if(i > 0)
+	{
+		int16_t lowMin = (int16_t)(mins & 0xFFFF);
+		int16_t highMin = (int16_t)(mins >> 16);
+		int16_t lowMax = (int16_t)(maxs & 0xFFFF);
+		int16_t highMax = (int16_t)(maxs >> 16);
+
+		min = (lowMin < highMin) ? lowMin : highMin;
+		max = (lowMax > highMax) ? lowMax : highMax;
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		int32_t x = samples[i];
+
+		sum += x;
+		squares += (uint64_t)(x * x);
+		min = (x < min) ? (int16_t)x : min;
+		max = (x > max) ? (int16_t)x : max;
+	}
+
+	moments->sum = sum;
+	moments->squares = squares;
+	moments->min = min;
+	moments->max = max;
+}
+
+static void merge(SAMPLESTATS_Moments_t *into, const SAMPLESTATS_Moments_t *from)
+{
+	into->sum += from->sum;
+	into->squares += from->squares;
+	into->min = (from->min < into->min) ? from->min : into->min;
+	into->max = (from->max > into->max) ? from->max : into->max;
+}
+
+void SAMPLESTATS_QuantileReset(SAMPLESTATS_Quantile_t *quantile, float q)
+{
+	memset(quantile, 0, sizeof(*quantile));
+	quantile->quantile = q;
+}
+
+/**************************************************************************//**
+* @brief Moves marker i one rank in direction d, on the parabola through it
+* and its neighbours, or on a line if that would put it out of order
+*****************************************************************************/
+static void adjust(SAMPLESTATS_Quantile_t *p, uint32_t i, int32_t d)
+{
+	float *q = p->heights;
+	int32_t *n = p->positions;
+	float parabolic = q[i] + (float)d / (float)(n[i + 1] - n[i - 1])
+			* ((float)(n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (float)(n[i + 1] - n[i])
+			+ (float)(n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (float)(n[i] - n[i - 1]));
+
+	if(q[i - 1] < parabolic && parabolic < q[i + 1])
+	{
+		q[i] = parabolic;
+	}
+	else
+	{
+		q[i] += (float)d * (q[i + d] - q[i]) / (float)(n[i + d] - n[i]);
+	}
+	n[i] += d;
+}
+
+void SAMPLESTATS_QuantileAdd(SAMPLESTATS_Quantile_t *p, float x)
+{
+	float *q = p->heights;
+	int32_t *n = p->positions;
+	float increments[SAMPLESTATS_MARKERS] = { 0.0f, p->quantile / 2, p->quantile, (1.0f + p->quantile) / 2, 1.0f };
+	uint32_t k;
+
+	/* The first five are kept sorted as they come */
+	if(p->count < SAMPLESTATS_MARKERS)
+	{
+		for(k = p->count; k > 0 && q[k - 1] > x; k--)
+		{
+			q[k] = q[k - 1];
+		}
+		q[k] = x;
+		if(++p->count == SAMPLESTATS_MARKERS)
+		{
+			for(k = 0; k < SAMPLESTATS_MARKERS; k++)
+			{
+				n[k] = (int32_t)k + 1;
+				p->desired[k] = 1.0f + 4.0f * increments[k];
+			}
+		}
+		return;
+	}
+	p->count++;
+
+	/* The cell the sample falls in, the extremes move with it */
+	if(x < q[0])
+	{
+		q[0] = x;
+		k = 0;
+	}
+	else if(x >= q[4])
+	{
+		q[4] = x;
+		k = 3;
+	}
+	else
+	{
+		for(k = 0; x >= q[k + 1]; k++);
+	}
+
+	for(uint32_t i = k + 1; i < SAMPLESTATS_MARKERS; i++)
+	{
+		n[i]++;
+	}
+	for(uint32_t i = 0; i < SAMPLESTATS_MARKERS; i++)
+	{
+		p->desired[i] += increments[i];
+	}
+
+	for(uint32_t i = 1; i < SAMPLESTATS_MARKERS - 1; i++)
+	{
+		float d = p->desired[i] - (float)n[i];
+
+		if((d >= 1.0f && n[i + 1] - n[i] > 1) || (d <= -1.0f && n[i - 1] - n[i] < -1))
+		{
+			adjust(p, i, (d > 0) ? 1 : -1);
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief The estimate, 0 before the first sample. Up to five samples it is
+* the nearest rank of the sorted samples
+*****************************************************************************/
+float SAMPLESTATS_QuantileGet(const SAMPLESTATS_Quantile_t *p)
+{
+	uint32_t rank;
+
+	if(p->count == 0)
+	{
+		return 0.0f;
+	}
+	if(p->count <= SAMPLESTATS_MARKERS)
+	{
+		rank = (uint32_t)ceilf(p->quantile * (float)p->count);
+		return p->heights[(rank > 0) ? rank - 1 : 0];
+	}
+	return p->heights[2];
+}
+
+void SAMPLESTATS_Reset(SAMPLESTATS_Series_t *series)
+{
+	memset(series, 0, sizeof(*series));
+	series->totals.min = INT16_MAX;
+	series->totals.max = INT16_MIN;
+	SAMPLESTATS_QuantileReset(&series->p95, 0.95f);
+	SAMPLESTATS_QuantileReset(&series->p99, 0.99f);
+}
+
+/**************************************************************************//**
+* @brief Adds a sample, reducing the block once it is full
+*****************************************************************************/
+void SAMPLESTATS_Add(SAMPLESTATS_Series_t *series, int16_t sample)
+{
+	SAMPLESTATS_QuantileAdd(&series->p95, sample);
+	SAMPLESTATS_QuantileAdd(&series->p99, sample);
+
+	series->block[series->fill++] = sample;
+	if(series->fill == SAMPLESTATS_BLOCK)
+	{
+		SAMPLESTATS_Moments_t block;
+
+		SAMPLESTATS_Reduce(series->block, SAMPLESTATS_BLOCK, &block);
+		merge(&series->totals, &block);
+		series->count += SAMPLESTATS_BLOCK;
+		series->fill = 0;
+	}
+}
+
+/**************************************************************************//**
+* @brief Summary of every sample so far, the block not yet full included
+*****************************************************************************/
+void SAMPLESTATS_Get(const SAMPLESTATS_Series_t *series, SAMPLESTATS_Summary_t *summary)
+{
+	SAMPLESTATS_Moments_t all = series->totals;
+	SAMPLESTATS_Moments_t block;
+	uint32_t count = series->count + series->fill;
+	double mean;
+	double variance;
+
+	memset(summary, 0, sizeof(*summary));
+	if(count == 0)
+	{
+		return;
+	}
+	SAMPLESTATS_Reduce(series->block, series->fill, &block);
+	merge(&all, &block);
+
+	/* Sums are exact, only the last steps are in floating point */
+	mean = (double)all.sum / count;
+	variance = (count > 1) ? ((double)all.squares - (double)all.sum * mean) / (count - 1) : 0.0;
+
+	summary->count = count;
+	summary->mean = (float)mean;
+	summary->std = (variance > 0.0) ? sqrtf((float)variance) : 0.0f;
+	summary->min = all.min;
+	summary->max = all.max;
+	summary->p95 = SAMPLESTATS_QuantileGet(&series->p95);
+	summary->p99 = SAMPLESTATS_QuantileGet(&series->p99);
+}
@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ * @file
+ * @brief Running statistics and p95/p99 of a series of link samples
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef SAMPLESTATS_H_
+#define SAMPLESTATS_H_
+
+#include <stdint.h>
+
+/* Samples are 16 bit: RSSI in dBm, throughput of a window in kbit/s, denial
+ * rate in permille. They gather in a block, a full block is reduced to its
+ * sum, sum of squares, minimum and maximum and added to the series totals,
+ * the way arm_mean_q15(), arm_power_q15() and arm_max_q15() of CMSIS-DSP
+ * work through a block. Only arm_math.h of CMSIS-DSP is in the SDK, not the
+ * library, so SAMPLESTATS_Reduce() has its own two samples at a time loop
+ * on the Cortex-M4 SIMD instructions, and a plain one elsewhere.
+ * tools/samplestats_check.c runs both on a PC, the first built with
+ * -DSAMPLESTATS_HOST_MODEL on the instructions of tools/simd_model.h.
+ *
+ * p95 and p99 come from the P-square algorithm of Jain and Chlamtac: five
+ * markers a quantile, moved on every sample, so nothing but the block is
+ * kept. The estimate is exact up to five samples. */
+
+#define SAMPLESTATS_BLOCK		32		// Samples reduced at a time, even
+#define SAMPLESTATS_MARKERS		5
+
+typedef struct {
+	int64_t sum;
+	uint64_t squares;
+	int16_t min;
+	int16_t max;
+} SAMPLESTATS_Moments_t;
+
+typedef struct {
+	float quantile;								// 0.95 for p95
+	uint32_t count;								// Samples seen, the markers are set from the fifth
+	float heights[SAMPLESTATS_MARKERS];			// Marker values, the middle one is the estimate
+	int32_t positions[SAMPLESTATS_MARKERS];		// Marker ranks, from 1
+	float desired[SAMPLESTATS_MARKERS];			// Ranks the markers should be at
+} SAMPLESTATS_Quantile_t;
+
+typedef struct {
+	int16_t block[SAMPLESTATS_BLOCK];			// Samples not reduced yet
+	uint32_t fill;
+	uint32_t count;								// Samples in the totals
+	SAMPLESTATS_Moments_t totals;
+	SAMPLESTATS_Quantile_t p95;
+	SAMPLESTATS_Quantile_t p99;
+} SAMPLESTATS_Series_t;
+
+typedef struct {
+	uint32_t count;
+	float mean;
+	float std;									// Sample standard deviation, as arm_std_f32()
+	int16_t min;
+	int16_t max;
+	float p95;
+	float p99;
+} SAMPLESTATS_Summary_t;
+
+void SAMPLESTATS_Reset(SAMPLESTATS_Series_t *series);
+void SAMPLESTATS_Add(SAMPLESTATS_Series_t *series, int16_t sample);
+void SAMPLESTATS_Get(const SAMPLESTATS_Series_t *series, SAMPLESTATS_Summary_t *summary);
+void SAMPLESTATS_Reduce(const int16_t *samples, uint32_t count, SAMPLESTATS_Moments_t *moments);
+void SAMPLESTATS_QuantileReset(SAMPLESTATS_Quantile_t *quantile, float q);
+void SAMPLESTATS_QuantileAdd(SAMPLESTATS_Quantile_t *quantile, float sample);
+float SAMPLESTATS_QuantileGet(const SAMPLESTATS_Quantile_t *quantile);
+
+#endif
@@ -0,0 +1,470 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check and benchmark of the scan report filter
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* First checks advfilter.c: structures running past the report, the zero
+ * length terminator, name, UUID and address matches, and which misses the
+ * cache keeps. Then replays scan reports through the former parser, a copy
+ * of process_scan_response() before the filter, and through
+ * ADVFILTER_Report(), and prints the time per report of each and the report
+ * each would have connected on.
+ *
+ * The reports are read from a file, one per line:
+ *     <address> <address type> <packet type> <data as hex>
+ * e.g. "00:0b:57:1a:2b:3c 0 0 020106120954687..." with the address most
+ * significant byte first and packet_type as in le_gap_scan_response. A
+ * btmon or hcidump capture of a crowded room turns into this with a few
+ * lines of awk. Without a file, a room of -d devices with typical
+ * payloads, some malformed, is made up, the tester appearing late; -w
+ * saves it in the same format.
+ *
+ * The former parser reads 17 bytes past any name and past the end of the
+ * report, so every report is copied into a buffer of 255 bytes first.
+ *
+ * Build:  gcc -O2 -Wall -I. -o advfilter_bench tools/advfilter_bench.c advfilter.c
+ * Usage:  advfilter_bench [-w out.txt] [-n reports] [-d devices] [reports.txt]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "advfilter.h"
+
+#define MAX_REPORTS		200000
+#define ROUNDS			20
+
+typedef struct {
+	uint8_t address[6];						// Little endian, as in bd_addr
+	uint8_t addressType;
+	uint8_t packetType;
+	uint8_t len;
+	uint8_t data[255];
+} Report_t;
+
+static const char name[] = "Throughput Tester";
+static const uint8_t uuid[16] = { 0xf2, 0x20, 0x18, 0xc7, 0x32, 0x2d, 0xc7, 0xab,
+		0xcf, 0x46, 0xf7, 0xff, 0x70, 0x9e, 0xb9, 0xbb };
+static Report_t *reports;
+static uint32_t failures;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+/* process_scan_response() as it was, data padded by the caller */
+static int legacyParse(const uint8_t *data, uint8_t len)
+{
+	int i = 0;
+	int ad_len;
+	int ad_type;
+
+	while(i < (len - 1))
+	{
+		ad_len = data[i];
+		ad_type = data[i + 1];
+		if(ad_type == 0x09 && memcmp(data + i + 2, name, 17) == 0)
+		{
+			return 1;
+		}
+		i = i + ad_len + 1;
+		if(i >= 255 - 1)
+		{
+			/* The former loop went on into whatever followed */
+			break;
+		}
+	}
+	return 0;
+}
+
+static bool finalReport(const Report_t *r)
+{
+	return (r->packetType & 0x07) != 0;
+}
+
+static bool connectable(const Report_t *r)
+{
+	uint8_t type = r->packetType & 0x07;
+
+	return type != 2 && type != 3;
+}
+
+static void checks(void)
+{
+	ADVFILTER_Criteria_t c = { name, sizeof(name) - 1, uuid, sizeof(uuid), false, { 0 } };
+	static const uint8_t device[6] = { 1, 2, 3, 4, 5, 6 };
+	static const uint8_t other[6] = { 9, 9, 9, 9, 9, 9 };
+	uint8_t good[32] = { 0x02, 0x01, 0x06, 0x12, 0x09 };
+	uint8_t prefix[32] = { 0x02, 0x01, 0x06, 0x14, 0x09 };
+	uint8_t uuids[] = { 0x05, 0x03, 0x0f, 0x18, 0x0a, 0x18, 0x11, 0x07,
+			0xf2, 0x20, 0x18, 0xc7, 0x32, 0x2d, 0xc7, 0xab, 0xcf, 0x46, 0xf7, 0xff, 0x70, 0x9e, 0xb9, 0xbb };
+	uint8_t overrun[] = { 0x02, 0x01, 0x06, 0x1f, 0x09, 'T', 'h' };
+	uint8_t padded[] = { 0x02, 0x01, 0x06, 0x00, 0x12, 0x09 };
+	ADVFILTER_Stats_t s;
+	ADVFILTER_Ad_t ad;
+	uint32_t offset = 0;
+
+	memcpy(&good[5], name, 17);
+	memcpy(&prefix[5], "Throughput Tester 2", 19);
+
+	expect("first ad", ADVFILTER_AdNext(good, 22, &offset, &ad), ADVFILTER_AD_FOUND);
+	expect("flags", ad.type, 0x01);
+	expect("second ad", ADVFILTER_AdNext(good, 22, &offset, &ad), ADVFILTER_AD_FOUND);
+	expect("name length", ad.len, 17);
+	expect("end", ADVFILTER_AdNext(good, 22, &offset, &ad), ADVFILTER_AD_END);
+	offset = 0;
+	expect("cut short", ADVFILTER_AdNext(good, 21, &offset, &ad), ADVFILTER_AD_FOUND);
+	expect("cut short name", ADVFILTER_AdNext(good, 21, &offset, &ad), ADVFILTER_AD_MALFORMED);
+	offset = 3;
+	expect("terminator", ADVFILTER_AdNext(padded, sizeof(padded), &offset, &ad), ADVFILTER_AD_END);
+
+	expect("name", ADVFILTER_Match(&c, good, 22), true);
+	expect("longer name", ADVFILTER_Match(&c, prefix, 24), false);
+	expect("overrun", ADVFILTER_Match(&c, overrun, sizeof(overrun)), false);
+	expect("uuid128", ADVFILTER_Match(&c, uuids, sizeof(uuids)), true);
+	c.uuid = (const uint8_t *)"\x0a\x18";
+	c.uuidLen = 2;
+	expect("uuid16", ADVFILTER_Match(&c, uuids, sizeof(uuids)), true);
+	c.uuid = (const uint8_t *)"\x0d\x18";
+	expect("uuid16 absent", ADVFILTER_Match(&c, uuids, sizeof(uuids)), false);
+	c.uuid = uuid;
+	c.uuidLen = sizeof(uuid);
+
+	ADVFILTER_Init(&c);
+	expect("advertisement miss", ADVFILTER_Report(device, 0, padded, sizeof(padded), false), false);
+	expect("scan response match", ADVFILTER_Report(device, 0, good, 22, true), true);
+	expect("remembered match", ADVFILTER_Report(device, 0, padded, sizeof(padded), false), true);
+	expect("other type", ADVFILTER_Report(device, 1, padded, sizeof(padded), true), false);
+	expect("final miss", ADVFILTER_Report(other, 0, padded, sizeof(padded), true), false);
+	expect("remembered miss", ADVFILTER_Report(other, 0, good, 22, true), false);
+	ADVFILTER_GetStats(&s);
+	expect("reports", s.reports, 6);
+	expect("cache hits", s.cacheHits, 2);
+	expect("parsed", s.parsed, 4);
+
+	ADVFILTER_SetAddress(other);
+	expect("address", ADVFILTER_Report(other, 0, padded, sizeof(padded), true), true);
+	ADVFILTER_SetAddress(NULL);
+	expect("address cleared", ADVFILTER_Report(other, 0, padded, sizeof(padded), true), false);
+
+	/* More misses than slots, each still parsed once */
+	ADVFILTER_Init(&c);
+	for(uint32_t i = 0; i < 4 * ADVFILTER_CACHE_SIZE; i++)
+	{
+		uint8_t a[6] = { (uint8_t)i, (uint8_t)(i >> 8), 0x55, 0, 0, 0xC0 };
+
+		ADVFILTER_Report(a, 1, padded, sizeof(padded), true);
+	}
+	ADVFILTER_GetStats(&s);
+	expect("evictions", s.evictions, 3 * ADVFILTER_CACHE_SIZE);
+	expect("malformed", s.malformed, 0);
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void put(Report_t *r, uint8_t type, const void *value, uint8_t len)
+{
+	if(r->len + 2 + len > 31)
+	{
+		return;
+	}
+	r->data[r->len++] = (uint8_t)(len + 1);
+	r->data[r->len++] = type;
+	memcpy(&r->data[r->len], value, len);
+	r->len += len;
+}
+
+/* A room of devices, taking turns at random: a fifth are non-connectable
+ * beacons, the others advertise connectable and, scanned actively, follow
+ * every advertisement with a scan response. The tester shows up after
+ * three quarters of the reports */
+static void makeDevice(uint32_t d, Report_t *adv, Report_t *rsp)
+{
+	static const char *names[] = { "Phone", "Watch", "Throughput", "Throughput Tester 2", "TV", "Tag" };
+	uint8_t flags = 0x06;
+	uint8_t payload[24];
+
+	memset(adv, 0, sizeof(*adv));
+	srand(d * 7919 + 1);
+	for(uint32_t b = 0; b < 6; b++)
+	{
+		adv->address[b] = (uint8_t)random32();
+	}
+	adv->addressType = (uint8_t)(d & 1);
+	adv->packetType = (uint8_t)(d % 5 == 0 ? 3 : 0);
+	put(adv, 0x01, &flags, 1);
+	switch(d % 4)
+	{
+		case 0:
+			put(adv, 0x09, names[d % 6], (uint8_t)strlen(names[d % 6]));
+			break;
+		case 1:
+			for(uint32_t b = 0; b < sizeof(payload); b++)
+			{
+				payload[b] = (uint8_t)random32();
+			}
+			put(adv, 0xFF, payload, 25 - adv->len);
+			break;
+		case 2:
+			put(adv, 0x03, "\x0f\x18\x0a\x18", 4);
+			put(adv, 0x08, "Sens", 4);
+			break;
+		default:
+			/* Broken length */
+			adv->data[adv->len++] = 0x1e;
+			adv->data[adv->len++] = 0x16;
+			break;
+	}
+
+	*rsp = *adv;
+	rsp->packetType = 4;
+	rsp->len = 0;
+	if(d % 3 == 0)
+	{
+		put(rsp, 0x09, names[(d / 3) % 6], (uint8_t)strlen(names[(d / 3) % 6]));
+	}
+}
+
+static uint32_t makeUp(uint32_t count, uint32_t devices)
+{
+	uint32_t i = 0;
+
+	srand(12345);
+	while(i < count)
+	{
+		uint32_t d = random32() % devices;
+		uint32_t seed = (uint32_t)rand();
+		Report_t rsp;
+
+		makeDevice(d, &reports[i], &rsp);
+		if(reports[i++].packetType == 0 && i < count)
+		{
+			reports[i++] = rsp;
+		}
+		srand(seed);
+	}
+
+	{
+		Report_t *tester = &reports[count * 3 / 4];
+		uint8_t flags = 0x06;
+
+		memset(tester, 0, sizeof(*tester));
+		memcpy(tester->address, "\x3c\x2b\x1a\x57\x0b\x00", 6);
+		put(tester, 0x01, &flags, 1);
+		put(tester, 0x09, name, 17);
+	}
+	return count;
+}
+
+static uint32_t readReports(FILE *in)
+{
+	char line[700];
+	uint32_t count = 0;
+
+	while(count < MAX_REPORTS && fgets(line, sizeof(line), in) != NULL)
+	{
+		Report_t *r = &reports[count];
+		unsigned int a[6];
+		unsigned int type;
+		unsigned int packet;
+		char hex[600];
+
+		memset(r, 0, sizeof(*r));
+		hex[0] = 0;
+		if(sscanf(line, "%x:%x:%x:%x:%x:%x %u %u %599s", &a[5], &a[4], &a[3], &a[2], &a[1], &a[0], &type, &packet,
+				hex) < 8)
+		{
+			continue;
+		}
+		for(uint32_t b = 0; b < 6; b++)
+		{
+			r->address[b] = (uint8_t)a[b];
+		}
+		r->addressType = (uint8_t)type;
+		r->packetType = (uint8_t)packet;
+		for(uint32_t i = 0; hex[2 * i] && hex[2 * i + 1] && i < sizeof(r->data); i++)
+		{
+			unsigned int byte;
+
+			sscanf(&hex[2 * i], "%2x", &byte);
+			r->data[r->len++] = (uint8_t)byte;
+		}
+		count++;
+	}
+	return count;
+}
+
+static void writeReports(const char *path, uint32_t count)
+{
+	FILE *out = fopen(path, "w");
+
+	if(out == NULL)
+	{
+		perror(path);
+		return;
+	}
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const Report_t *r = &reports[i];
+
+		fprintf(out, "%02x:%02x:%02x:%02x:%02x:%02x %u %u ", r->address[5], r->address[4], r->address[3],
+				r->address[2], r->address[1], r->address[0], r->addressType, r->packetType);
+		for(uint32_t b = 0; b < r->len; b++)
+		{
+			fprintf(out, "%02x", r->data[b]);
+		}
+		fprintf(out, "\n");
+	}
+	fclose(out);
+}
+
+static double nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(uint32_t count)
+{
+	ADVFILTER_Criteria_t c = { name, sizeof(name) - 1, uuid, sizeof(uuid), false, { 0 } };
+	uint32_t legacyFirst = UINT32_MAX;
+	uint32_t filterFirst = UINT32_MAX;
+	volatile uint32_t sink = 0;
+	ADVFILTER_Stats_t s;
+	double start;
+	double legacyNs;
+	double filterNs;
+
+	for(uint32_t i = 0; i < count && legacyFirst == UINT32_MAX; i++)
+	{
+		if(legacyParse(reports[i].data, reports[i].len))
+		{
+			legacyFirst = i;
+		}
+	}
+	ADVFILTER_Init(&c);
+	for(uint32_t i = 0; i < count && filterFirst == UINT32_MAX; i++)
+	{
+		if(connectable(&reports[i])
+				&& ADVFILTER_Report(reports[i].address, reports[i].addressType, reports[i].data, reports[i].len,
+						finalReport(&reports[i])))
+		{
+			filterFirst = i;
+		}
+	}
+
+	/* Every report, as if no device ever matched */
+	start = nowNs();
+	for(uint32_t round = 0; round < ROUNDS; round++)
+	{
+		for(uint32_t i = 0; i < count; i++)
+		{
+			sink += legacyParse(reports[i].data, reports[i].len);
+		}
+	}
+	legacyNs = (nowNs() - start) / ((double)ROUNDS * count);
+
+	start = nowNs();
+	for(uint32_t round = 0; round < ROUNDS; round++)
+	{
+		ADVFILTER_Init(&c);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			if(connectable(&reports[i]))
+			{
+				sink += ADVFILTER_Report(reports[i].address, reports[i].addressType, reports[i].data, reports[i].len,
+						finalReport(&reports[i]));
+			}
+		}
+	}
+	filterNs = (nowNs() - start) / ((double)ROUNDS * count);
+	ADVFILTER_GetStats(&s);
+
+	printf("%u reports\n", count);
+	printf("former parser  %7.1f ns/report, first match at report %d\n", legacyNs,
+			legacyFirst == UINT32_MAX ? -1 : (int)legacyFirst);
+	printf("filter + cache %7.1f ns/report, first match at report %d\n", filterNs,
+			filterFirst == UINT32_MAX ? -1 : (int)filterFirst);
+	printf("last round: %u reports, %u from the cache, %u parsed, %u malformed, %u evicted\n", s.reports,
+			s.cacheHits, s.parsed, s.malformed, s.evictions);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out = NULL;
+	FILE *in = NULL;
+	uint32_t count = 20000;
+	uint32_t devices = 40;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+		{
+			out = argv[++i];
+		}
+		else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+		{
+			count = strtoul(argv[++i], NULL, 0);
+		}
+		else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+		{
+			devices = strtoul(argv[++i], NULL, 0);
+		}
+		else if((in = fopen(argv[i], "r")) == NULL)
+		{
+			perror(argv[i]);
+			return 2;
+		}
+	}
+	if(count == 0 || count > MAX_REPORTS)
+	{
+		count = MAX_REPORTS;
+	}
+
+	checks();
+	printf("filter checks: %u failures\n\n", failures);
+
+	reports = calloc(MAX_REPORTS, sizeof(Report_t));
+	if(in != NULL)
+	{
+		count = readReports(in);
+		fclose(in);
+	}
+	else
+	{
+		count = makeUp(count, devices ? devices : 1);
+	}
+	if(out != NULL)
+	{
+		writeReports(out, count);
+	}
+	bench(count);
+	free(reports);
+
+	return failures ? 1 : 0;
+}
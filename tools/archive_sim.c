@@ -0,0 +1,223 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host soak test and benchmark of the internal flash result archive
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs archive.c against the MSC model: saves random summaries, polls with
+ * the radio randomly quiet or busy, and cuts the power in the middle of
+ * writes and erases. After every cut ARCHIVE_Init() runs again and the
+ * archive must hold an unbroken run of the newest summaries written, with
+ * the contents they were saved with, and at least all but two pages worth
+ * less any torn slots.
+ * Any difference, or any page or word rule the model sees broken, fails
+ * the run.
+ *
+ * The cost per summary is printed in model time, including the amortized
+ * page erase, with the longest time interrupts were off in one burst. The
+ * flash PS side of the comparison needs the stack; run "archive bench" on
+ * the board for it.
+ *
+ * Build:  gcc -O2 -Wall -DARCHIVE_HOST_MODEL -I. -Itools -o archive_sim \
+ *             tools/archive_sim.c archive.c tools/msc_model.c
+ * Usage:  archive_sim [saves] [cuts] [seed]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archive.h"
+#include "msc_model.h"
+
+#define PAGES			(MSC_MODEL_SIZE / ARCHIVE_PAGE_SIZE)
+
+static ARCHIVE_Summary_t *reference;	// By sequence
+static ARCHIVE_Summary_t pending[ARCHIVE_QUEUE_SIZE];
+static uint32_t pendingPut;
+static uint32_t pendingGet;
+static uint32_t committed;				// Summaries known to be in flash
+static uint32_t walked;
+static uint32_t expect;
+static uint32_t failures;
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void fail(const char *what, uint32_t sequence)
+{
+	if(failures++ < 10)
+	{
+		printf("%s, sequence %u\n", what, sequence);
+	}
+}
+
+static void randomSummary(ARCHIVE_Summary_t *summary)
+{
+	memset(summary, 0, sizeof(*summary));
+	summary->timestamp = random32();
+	summary->kind = ARCHIVE_KIND_RUN;
+	summary->phy = 1 << (random32() % 4);
+	summary->mode = random32() % 3;
+	summary->dataSize = random32() % 245;
+	summary->mtu = 23 + random32() % 225;
+	summary->interval = 6 + random32() % 100;
+	summary->bits = random32();
+	summary->ticks = random32();
+	summary->throughput = random32() % 1400000;
+	summary->operations = random32();
+	summary->lpDenials = random32() % 100;
+}
+
+/* Moves the summary the archive just wrote from pending to the reference */
+static void poll(bool quiet)
+{
+	ARCHIVE_Stats_t before, after;
+
+	ARCHIVE_GetStats(&before);
+	ARCHIVE_Poll(quiet);
+	ARCHIVE_GetStats(&after);
+
+	if(after.written != before.written)
+	{
+		reference[committed] = pending[pendingGet++ % ARCHIVE_QUEUE_SIZE];
+		committed++;
+	}
+}
+
+static void checkSummary(const ARCHIVE_Summary_t *summary)
+{
+	ARCHIVE_Summary_t copy = *summary;
+
+	if(summary->sequence >= committed)
+	{
+		fail("summary that was never committed", summary->sequence);
+		return;
+	}
+	if(walked > 0 && summary->sequence != expect)
+	{
+		fail("hole or reordering", summary->sequence);
+	}
+	copy.sequence = 0;
+	copy.crc = 0;
+	if(memcmp(&copy, &reference[summary->sequence], sizeof(copy)) != 0)
+	{
+		fail("contents differ", summary->sequence);
+	}
+	expect = summary->sequence + 1;
+	walked++;
+}
+
+static void verify(void)
+{
+	ARCHIVE_Stats_t stats;
+	uint32_t least;
+
+	/* Torn slots still in the ring take the place of a summary each */
+	ARCHIVE_GetStats(&stats);
+	least = (PAGES - 2) * ARCHIVE_SLOTS_PER_PAGE - stats.corrupt;
+
+	walked = 0;
+	ARCHIVE_Walk(checkSummary);
+	if(committed && expect != committed)
+	{
+		fail("newest summary missing", committed - 1);
+	}
+	if(walked < (committed < least ? committed : least))
+	{
+		fail("too few summaries kept", walked);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t saves = (argc > 1) ? strtoul(argv[1], NULL, 0) : 20000;
+	uint32_t cuts = (argc > 2) ? strtoul(argv[2], NULL, 0) : 200;
+	uint32_t seed = (argc > 3) ? strtoul(argv[3], NULL, 0) : 1;
+	uint32_t interval = cuts ? saves / cuts : saves + 1;
+	uint32_t cutsDone = 0;
+	uint32_t minErases = UINT32_MAX;
+	uint32_t maxErases = 0;
+	ARCHIVE_Stats_t stats;
+
+	srand(seed);
+	reference = calloc(saves + 1, sizeof(*reference));
+	MSC_MODEL_Reset();
+	ARCHIVE_Init();
+
+	for(uint32_t n = 0; n < saves && failures == 0; n++)
+	{
+		ARCHIVE_Summary_t summary;
+
+		randomSummary(&summary);
+		while(!ARCHIVE_Save(&summary))
+		{
+			poll(true);
+		}
+		pending[pendingPut++ % ARCHIVE_QUEUE_SIZE] = summary;
+
+		/* Mostly a few polls between saves, sometimes none so the queue fills */
+		for(uint32_t i = random32() % 4; i > 0; i--)
+		{
+			poll((random32() % 3) == 0);
+		}
+
+		if(interval && (n % interval) == interval - 1)
+		{
+			MSC_MODEL_CutAfter(random32() % 48);
+			for(uint32_t i = 0; i < 64; i++)
+			{
+				poll(true);
+			}
+			if(MSC_MODEL_PowerUp())
+			{
+				cutsDone++;
+			}
+			pendingGet = pendingPut;
+			ARCHIVE_Init();
+			verify();
+		}
+	}
+
+	ARCHIVE_Flush();
+	while(pendingGet != pendingPut && failures == 0)
+	{
+		poll(true);
+	}
+	verify();
+
+	ARCHIVE_GetStats(&stats);
+	for(uint32_t page = 0; page < PAGES; page++)
+	{
+		uint32_t erases = MSC_MODEL_Erases(page);
+
+		minErases = erases < minErases ? erases : minErases;
+		maxErases = erases > maxErases ? erases : maxErases;
+	}
+
+	printf("%u saves, %u committed, %u power cuts, %u kept, %u torn slots at the last init\n",
+			saves, committed, cutsDone, walked, stats.corrupt);
+	printf("since the last init: written %u, write errors %u, erases ahead %u, forced %u, pages recycled %u, dropped %u\n",
+			stats.written, stats.writeErrors, stats.erases, stats.forcedErases, stats.recycled, stats.dropped);
+	printf("erases per page %u..%u, %u words written\n", minErases, maxErases, MSC_MODEL_Words());
+	printf("model time %.1f s, %.1f us per summary with erases, longest burst %u us with interrupts off\n",
+			MSC_MODEL_Now() / 1e6, committed ? (double)MSC_MODEL_Now() / committed : 0.0, MSC_MODEL_MaxIrqOff());
+	printf("%u failures, %u model violations\n", failures, MSC_MODEL_Violations());
+
+	free(reference);
+	return (failures || MSC_MODEL_Violations()) ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the data channel classification
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Feeds chanclass.c synthetic surveys: a clean band, one Wi-Fi channel with
+ * its skirts, Wi-Fi channels 1, 6 and 11 together so the floor of used
+ * channels comes in, a channel hovering about the limit over repeated
+ * surveys, and gaps in the survey. Checks the channel numbering and the bit
+ * layout of the map the stack takes, then random surveys against the rules
+ * one by one. Prints the maps.
+ *
+ * Build:  gcc -O2 -Wall -I. -o chanclass_check tools/chanclass_check.c chanclass.c
+ * Usage:  chanclass_check [random surveys]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chanclass.h"
+
+static uint32_t failures;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void print(const char *name, const uint32_t per[], const uint8_t map[])
+{
+	printf("%-22s ", name);
+	for(uint8_t rf = 0; rf < CHANCLASS_RF_CHANNELS; rf++)
+	{
+		int index = CHANCLASS_DataChannel(rf);
+
+		printf("%c", (index < 0) ? '|' : CHANCLASS_Used(map, (uint8_t)index) ? '-' : (per[rf] >= CHANCLASS_BAD_PER) ? 'X' : 'x');
+	}
+	printf(" %2u used, %02x %02x %02x %02x %02x\n", CHANCLASS_Count(map), map[0], map[1], map[2], map[3], map[4]);
+}
+
+/* Wi-Fi channel w, loss over its 22 MHz, falling off over the 4 MHz after */
+static void wifi(uint32_t per[], uint8_t w, uint32_t level)
+{
+	uint32_t centre = 2407 + 5 * w;
+
+	for(uint8_t rf = 0; rf < CHANCLASS_RF_CHANNELS; rf++)
+	{
+		uint32_t mhz = 2402 + 2 * rf;
+		uint32_t off = (mhz > centre) ? mhz - centre : centre - mhz;
+
+		if(off <= 11)
+		{
+			per[rf] += level;
+		}
+		else if(off <= 15)
+		{
+			per[rf] += level / 5;
+		}
+	}
+}
+
+static void numbering(void)
+{
+	uint8_t map[CHANCLASS_MAP_SIZE];
+
+	expect("data 0", CHANCLASS_RfChannel(0), 1);
+	expect("data 10", CHANCLASS_RfChannel(10), 11);
+	expect("data 11", CHANCLASS_RfChannel(11), 13);
+	expect("data 36", CHANCLASS_RfChannel(36), 38);
+	expect("adv 37", CHANCLASS_DataChannel(0), (uint32_t)-1);
+	expect("adv 38", CHANCLASS_DataChannel(12), (uint32_t)-1);
+	expect("adv 39", CHANCLASS_DataChannel(39), (uint32_t)-1);
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		expect("round trip", CHANCLASS_DataChannel(CHANCLASS_RfChannel(i)), i);
+	}
+
+	CHANCLASS_All(map);
+	expect("all byte 0", map[0], 0xff);
+	expect("all byte 4", map[4], 0x1f);
+	expect("all count", CHANCLASS_Count(map), 37);
+}
+
+static void scenarios(void)
+{
+	uint32_t per[CHANCLASS_RF_CHANNELS];
+	uint8_t all[CHANCLASS_MAP_SIZE];
+	uint8_t map[CHANCLASS_MAP_SIZE];
+
+	CHANCLASS_All(all);
+
+	memset(per, 0, sizeof(per));
+	per[20] = CHANCLASS_BAD_PER - 1;
+	expect("clean", CHANCLASS_Classify(per, all, map), 37);
+	expect("clean map", memcmp(map, all, sizeof(map)), 0);
+	print("clean", per, map);
+
+	/* Wi-Fi 6 is 2426 to 2448 MHz, data channels 11 to 21, the skirts 10 and 22 */
+	memset(per, 0, sizeof(per));
+	wifi(per, 6, 300);
+	CHANCLASS_Classify(per, all, map);
+	print("wifi 6", per, map);
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		expect("wifi 6 channel", CHANCLASS_Used(map, i), i < 10 || i > 22);
+	}
+
+	/* A weak one, the skirts under CHANCLASS_GOOD_PER are kept */
+	memset(per, 0, sizeof(per));
+	wifi(per, 6, CHANCLASS_BAD_PER);
+	CHANCLASS_Classify(per, all, map);
+	print("weak wifi 6", per, map);
+	expect("weak skirt 10", CHANCLASS_Used(map, 10), true);
+	expect("weak centre", CHANCLASS_Used(map, 15), false);
+
+	/* Three at once leave 5, the floor takes back the 3 best */
+	memset(per, 0, sizeof(per));
+	wifi(per, 1, 400);
+	wifi(per, 6, 300);
+	wifi(per, 11, 200);
+	CHANCLASS_Classify(per, all, map);
+	print("wifi 1, 6 and 11", per, map);
+	expect("floor", CHANCLASS_Count(map), CHANCLASS_MIN_USED);
+	for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+	{
+		if(!CHANCLASS_Used(map, i))
+		{
+			for(uint8_t j = 0; j < CHANCLASS_DATA_CHANNELS; j++)
+			{
+				if(CHANCLASS_Used(map, j) && per[CHANCLASS_RfChannel(j)] > per[CHANCLASS_RfChannel(i)])
+				{
+					expect("floor took back a worse channel", j, i);
+				}
+			}
+		}
+	}
+
+	/* Hysteresis, one channel drifting about the limit over surveys */
+	{
+		static const uint32_t drift[] = { 50, 120, 90, 60, 45, 39, 60, 99, 100 };
+		static const bool usedAfter[] = { true, false, false, false, false, true, true, true, false };
+		uint8_t current[CHANCLASS_MAP_SIZE];
+
+		CHANCLASS_All(current);
+		memset(per, 0, sizeof(per));
+		for(uint32_t s = 0; s < sizeof(drift) / sizeof(drift[0]); s++)
+		{
+			per[CHANCLASS_RfChannel(5)] = drift[s];
+			CHANCLASS_Classify(per, current, current);
+			expect("hysteresis", CHANCLASS_Used(current, 5), usedAfter[s]);
+		}
+	}
+
+	/* No figure, left as it was */
+	{
+		uint8_t current[CHANCLASS_MAP_SIZE];
+
+		memset(per, 0, sizeof(per));
+		per[CHANCLASS_RfChannel(3)] = 500;
+		CHANCLASS_Classify(per, all, current);
+		for(uint8_t rf = 0; rf < CHANCLASS_RF_CHANNELS; rf++)
+		{
+			per[rf] = CHANCLASS_NO_DATA;
+		}
+		per[CHANCLASS_RfChannel(30)] = 500;
+		CHANCLASS_Classify(per, current, map);
+		print("gaps", per, map);
+		expect("gap keeps bad", CHANCLASS_Used(map, 3), false);
+		expect("gap keeps used", CHANCLASS_Used(map, 4), true);
+		expect("figure counts", CHANCLASS_Used(map, 30), false);
+	}
+}
+
+/* Random surveys, the map against the rules */
+static void randomSurveys(uint32_t surveys)
+{
+	uint32_t per[CHANCLASS_RF_CHANNELS];
+	uint8_t previous[CHANCLASS_MAP_SIZE];
+	uint8_t map[CHANCLASS_MAP_SIZE];
+
+	srand(7);
+	CHANCLASS_All(previous);
+	for(uint32_t s = 0; s < surveys; s++)
+	{
+		uint32_t used;
+		bool floor;
+
+		memset(per, 0, sizeof(per));
+		for(uint32_t w = rand() % 4; w > 0; w--)
+		{
+			wifi(per, (uint8_t)(1 + rand() % 13), rand() % 600);
+		}
+		for(uint8_t rf = 0; rf < CHANCLASS_RF_CHANNELS; rf++)
+		{
+			per[rf] = (rand() % 20 == 0) ? CHANCLASS_NO_DATA : (per[rf] + rand() % 30 > 1000) ? 1000 : per[rf] + rand() % 30;
+		}
+
+		used = CHANCLASS_Classify(per, previous, map);
+		expect("count", CHANCLASS_Count(map), used);
+		expect("reserved bits", map[4] & 0xe0, 0);
+		if(used < CHANCLASS_MIN_USED)
+		{
+			expect("floor", used, CHANCLASS_MIN_USED);
+		}
+		floor = (used == CHANCLASS_MIN_USED);
+
+		for(uint8_t i = 0; i < CHANCLASS_DATA_CHANNELS; i++)
+		{
+			uint32_t p = per[CHANCLASS_RfChannel(i)];
+			bool usedNow = CHANCLASS_Used(map, i);
+
+			if(p == CHANCLASS_NO_DATA)
+			{
+				/* Only the floor may take back one without a figure */
+				if(!floor)
+				{
+					expect("no figure, as before", usedNow, CHANCLASS_Used(previous, i));
+				}
+			}
+			else if(p >= CHANCLASS_BAD_PER && usedNow && !floor)
+			{
+				expect("bad channel used", i, 255);
+			}
+			else if(p < CHANCLASS_GOOD_PER && !usedNow)
+			{
+				expect("good channel dropped", i, 255);
+			}
+		}
+		memcpy(previous, map, sizeof(map));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t surveys = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+
+	numbering();
+	scenarios();
+	randomSurveys(surveys);
+	printf("chanclass checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the connection setup milestones
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Drives connsetup.c the way main.c does through a reconnect loop, with
+ * random phase lengths in RTCC ticks: some cycles give up after a random
+ * milestone, some see the MTU before the connection parameters, and the
+ * RTCC wraps half way. Every cycle handed to the callback is checked
+ * against the one that was played, and at the end the counters, the
+ * abandoned cycles by milestone and the mean of every histogram are
+ * checked against sums kept here. Prints the figures the way the "setup"
+ * console command does.
+ *
+ * Build:  gcc -O2 -Wall -I. -o connsetup_check tools/connsetup_check.c connsetup.c histogram.c
+ * Usage:  connsetup_check [cycles]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "connsetup.h"
+
+#define TICKS_TO_US(ticks)	((uint32_t)(((uint64_t)(ticks) * 1000000u) >> 15))
+
+static uint32_t failures;
+static CONNSETUP_Cycle_t played;
+static bool playedCompleted;
+static uint32_t callbacks;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void done(const CONNSETUP_Cycle_t *cycle, bool completed)
+{
+	callbacks++;
+	expect("callback cycle", cycle->cycle, played.cycle);
+	expect("callback completed", completed, playedCompleted);
+	expect("callback reached", cycle->reached, played.reached);
+	expect("callback start", cycle->start, played.start);
+	for(uint32_t m = 0; m < CONNSETUP_MILESTONES; m++)
+	{
+		expect("callback ticks", cycle->ticks[m], played.ticks[m]);
+	}
+}
+
+static void basics(void)
+{
+	CONNSETUP_Stats_t stats;
+
+	CONNSETUP_Init(NULL);
+	expect("mark before start", CONNSETUP_Mark(CONNSETUP_OPENED, 10), false);
+	CONNSETUP_Start(100);
+	expect("start is reached", CONNSETUP_Reached(CONNSETUP_START), true);
+	expect("start cannot be marked", CONNSETUP_Mark(CONNSETUP_START, 110), false);
+	expect("first mark", CONNSETUP_Mark(CONNSETUP_OPENED, 132), true);
+	expect("second mark", CONNSETUP_Mark(CONNSETUP_OPENED, 200), false);
+	expect("reached", CONNSETUP_Reached(CONNSETUP_OPENED), true);
+	expect("not reached", CONNSETUP_Reached(CONNSETUP_MTU), false);
+	expect("elapsed", CONNSETUP_Elapsed(CONNSETUP_OPENED)->min, TICKS_TO_US(32));
+	expect("first data", CONNSETUP_Mark(CONNSETUP_FIRST_DATA, 164), true);
+	expect("phase", CONNSETUP_Phase(CONNSETUP_FIRST_DATA)->min, TICKS_TO_US(32));
+	expect("after completion", CONNSETUP_Mark(CONNSETUP_MTU, 170), false);
+	expect("still reached", CONNSETUP_Reached(CONNSETUP_FIRST_DATA), true);
+	CONNSETUP_Start(300);
+	expect("new cycle", CONNSETUP_Reached(CONNSETUP_FIRST_DATA), false);
+	CONNSETUP_GetStats(&stats);
+	expect("cycles", stats.cycles, 2);
+	expect("completed", stats.completed, 1);
+	expect("none abandoned", stats.stalled[CONNSETUP_START] + stats.stalled[CONNSETUP_OPENED], 0);
+	expect("name", strcmp(CONNSETUP_Name(CONNSETUP_FIRST_DATA), "first data"), 0);
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void print(void)
+{
+	CONNSETUP_Stats_t stats;
+
+	CONNSETUP_GetStats(&stats);
+	printf("cycles %u completed %u, abandoned after", stats.cycles, stats.completed);
+	for(CONNSETUP_Milestone_t m = CONNSETUP_START; m < CONNSETUP_FIRST_DATA; m++)
+	{
+		printf(" %s %u", CONNSETUP_Name(m), stats.stalled[m]);
+	}
+	printf("\n");
+	for(CONNSETUP_Milestone_t m = CONNSETUP_FOUND; m < CONNSETUP_MILESTONES; m++)
+	{
+		const HISTOGRAM_t *e = CONNSETUP_Elapsed(m);
+		const HISTOGRAM_t *p = CONNSETUP_Phase(m);
+
+		printf("%-13s %5u, ms since start min %.1f mean %.1f p90 %.1f max %.1f, phase min %.1f mean %.1f p90 %.1f max %.1f\n",
+				CONNSETUP_Name(m), e->count, e->min / 1000.0, HISTOGRAM_Mean(e) / 1000.0,
+				HISTOGRAM_Percentile(e, 900) / 1000.0, e->max / 1000.0, p->min / 1000.0, HISTOGRAM_Mean(p) / 1000.0,
+				HISTOGRAM_Percentile(p, 900) / 1000.0, p->max / 1000.0);
+	}
+}
+
+/* Phase lengths roughly as on air: scanning dominates, the rest is a few
+ * connection intervals each */
+static uint32_t phaseTicks(CONNSETUP_Milestone_t m)
+{
+	return (m == CONNSETUP_FOUND) ? 300 + random32() % 30000 : 20 + random32() % 3000;
+}
+
+static void loop(uint32_t cycles)
+{
+	static const CONNSETUP_Milestone_t order[] = { CONNSETUP_FOUND, CONNSETUP_OPENED, CONNSETUP_PARAMETERS,
+			CONNSETUP_MTU, CONNSETUP_CCCD_NOTIFY, CONNSETUP_CCCD_INDICATE, CONNSETUP_FIRST_DATA };
+	uint64_t elapsedSum[CONNSETUP_MILESTONES] = {0};
+	uint64_t phaseSum[CONNSETUP_MILESTONES] = {0};
+	uint32_t count[CONNSETUP_MILESTONES] = {0};
+	uint32_t stalled[CONNSETUP_MILESTONES] = {0};
+	uint32_t completed = 0;
+	uint32_t now = 0u - (cycles / 2) * 20000u;	// Wraps half way
+	CONNSETUP_Stats_t stats;
+
+	CONNSETUP_Init(done);
+	callbacks = 0;
+	for(uint32_t c = 0; c < cycles; c++)
+	{
+		CONNSETUP_Milestone_t seq[sizeof(order) / sizeof(order[0])];
+		uint32_t n = sizeof(order) / sizeof(order[0]);
+		uint32_t previous = 0;
+		uint32_t expectedCallbacks = callbacks + 1;
+
+		memcpy(seq, order, sizeof(seq));
+		if(random32() % 4 == 0)
+		{
+			seq[2] = CONNSETUP_MTU;
+			seq[3] = CONNSETUP_PARAMETERS;
+		}
+		if(random32() % 8 == 0)
+		{
+			n = random32() % n;				// Gives up before the first data
+		}
+
+		if(c > 0)
+		{
+			/* Starting this cycle hands the last one over if it was abandoned */
+			if(playedCompleted)
+			{
+				expectedCallbacks--;
+			}
+			CONNSETUP_Start(now);
+			expect("callbacks", callbacks, expectedCallbacks);
+		}
+		else
+		{
+			CONNSETUP_Start(now);
+		}
+
+		memset(&played, 0, sizeof(played));
+		played.cycle = (uint16_t)(c + 1);
+		played.reached = 1 << CONNSETUP_START;
+		played.start = now;
+		playedCompleted = false;
+
+		for(uint32_t i = 0; i < n; i++)
+		{
+			uint32_t step = phaseTicks(seq[i]);
+			uint32_t ticks;
+
+			now += step;
+			ticks = now - played.start;
+			played.ticks[seq[i]] = ticks;
+			played.reached |= 1 << seq[i];
+			playedCompleted = (seq[i] == CONNSETUP_FIRST_DATA);
+			elapsedSum[seq[i]] += TICKS_TO_US(ticks);
+			phaseSum[seq[i]] += TICKS_TO_US(ticks - previous);
+			count[seq[i]]++;
+			previous = ticks;
+
+			expect("mark", CONNSETUP_Mark(seq[i], now), true);
+			expect("mark again", CONNSETUP_Mark(seq[i], now + 1), false);
+		}
+		if(playedCompleted)
+		{
+			completed++;
+		}
+		else
+		{
+			stalled[n ? seq[n - 1] : CONNSETUP_START]++;
+		}
+		now += 5000;						// Link held, then closed
+	}
+
+	CONNSETUP_GetStats(&stats);
+	expect("loop cycles", stats.cycles, cycles);
+	expect("loop completed", stats.completed, completed);
+	for(uint32_t m = 0; m < CONNSETUP_MILESTONES; m++)
+	{
+		expect("stalled", stats.stalled[m], stalled[m]);
+		expect("count", CONNSETUP_Elapsed(m)->count, count[m]);
+		if(count[m] != 0)
+		{
+			expect("elapsed mean", HISTOGRAM_Mean(CONNSETUP_Elapsed(m)), (uint32_t)(elapsedSum[m] / count[m]));
+			expect("phase mean", HISTOGRAM_Mean(CONNSETUP_Phase(m)), (uint32_t)(phaseSum[m] / count[m]));
+		}
+	}
+	print();
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+
+	basics();
+	loop(cycles);
+	printf("setup checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the serial command console
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Feeds console.c character by character the way the RX idle callback
+ * does: CR, LF and CRLF line endings, backspace and DEL, lines past
+ * CONSOLE_LINE_SIZE and the line after them, more words than
+ * CONSOLE_MAX_ARGS. Then CONSOLE_ParseUint() on the edges of 32 bits in
+ * both bases and on text it has to refuse.
+ *
+ * Build:  gcc -O2 -Wall -I. -o console_check tools/console_check.c console.c
+ * Usage:  console_check
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "console.h"
+
+static uint32_t failures;
+static CONSOLE_t console;
+
+static int lastArgc;
+static char lastArgs[CONSOLE_MAX_ARGS][CONSOLE_LINE_SIZE];
+static uint32_t runs;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void expectText(const char *what, const char *got, const char *expected)
+{
+	if(strcmp(got, expected) != 0)
+	{
+		failures++;
+		printf("FAIL: %s, \"%s\" instead of \"%s\"\n", what, got, expected);
+	}
+}
+
+static CONSOLE_Status_t record(int argc, char **argv)
+{
+	runs++;
+	lastArgc = argc;
+	for(int i = 0; i < argc; i++)
+	{
+		snprintf(lastArgs[i], sizeof(lastArgs[i]), "%s", argv[i]);
+	}
+	return CONSOLE_OK;
+}
+
+static CONSOLE_Status_t usage(int argc, char **argv)
+{
+	(void)argv;
+
+	runs++;
+	return (argc == 2) ? CONSOLE_OK : CONSOLE_USAGE;
+}
+
+static const CONSOLE_Command_t commands[] = {
+	{ "echo",	"[words]",	record },
+	{ "one",	"<n>",		usage },
+};
+
+/* Feeds text, returns the status of the last completed line, CONSOLE_PENDING
+ * if none completed, and counts the completed lines */
+static CONSOLE_Status_t feed(const char *text, uint32_t *lines)
+{
+	CONSOLE_Status_t last = CONSOLE_PENDING;
+	uint32_t completed = 0;
+
+	for(; *text; text++)
+	{
+		CONSOLE_Status_t status = CONSOLE_Input(&console, *text);
+
+		if(status != CONSOLE_PENDING)
+		{
+			last = status;
+			completed++;
+		}
+	}
+	if(lines)
+	{
+		*lines = completed;
+	}
+	return last;
+}
+
+static void endings(void)
+{
+	static const char *endings[] = { "\r", "\n", "\r\n" };
+	char text[32];
+	uint32_t lines;
+
+	CONSOLE_Init(&console, commands, sizeof(commands) / sizeof(commands[0]));
+	for(uint32_t i = 0; i < sizeof(endings) / sizeof(endings[0]); i++)
+	{
+		/* Two lines back to back, each ending counts once */
+		snprintf(text, sizeof(text), "echo a%secho b%s", endings[i], endings[i]);
+		runs = 0;
+		expect("ending status", feed(text, &lines), CONSOLE_OK);
+		expect("ending lines", lines, 2);
+		expect("ending runs", runs, 2);
+		expectText("ending argument", lastArgs[1], "b");
+	}
+
+	/* LF CR is two endings, the second an empty line */
+	expect("lf cr", feed("echo\n\r", &lines), CONSOLE_EMPTY);
+	expect("lf cr lines", lines, 2);
+
+	/* A blank line and one of blanks only */
+	expect("empty", feed("\r", &lines), CONSOLE_EMPTY);
+	expect("blanks", feed(" \t \r\n", &lines), CONSOLE_EMPTY);
+	expect("blanks lines", lines, 1);
+
+	/* CRLF split across two calls, as the idle callback may see it */
+	expect("split cr", feed("echo x\r", &lines), CONSOLE_OK);
+	expect("split lf", feed("\n", &lines), CONSOLE_PENDING);
+	expect("split lf lines", lines, 0);
+}
+
+static void editing(void)
+{
+	CONSOLE_Init(&console, commands, sizeof(commands) / sizeof(commands[0]));
+
+	/* Backspace and DEL on an empty line do nothing */
+	expect("backspace empty", feed("\b\b\x7F\r", NULL), CONSOLE_EMPTY);
+	expect("backspace empty len", console.len, 0);
+	expect("backspace then text", feed("\b\x7F" "echo z\r", NULL), CONSOLE_OK);
+	expectText("backspace then text word", lastArgs[0], "echo");
+
+	/* Both remove the last character */
+	expect("backspace", feed("echx\bo ab\x7F" "c\r", NULL), CONSOLE_OK);
+	expect("backspace argc", lastArgc, 2);
+	expectText("backspace argument", lastArgs[1], "ac");
+	expect("backspace unknown", feed("echo\b\b\r", NULL), CONSOLE_UNKNOWN);
+}
+
+static void overflow(void)
+{
+	char text[3 * CONSOLE_LINE_SIZE];
+	uint32_t lines;
+
+	CONSOLE_Init(&console, commands, sizeof(commands) / sizeof(commands[0]));
+
+	/* The longest line that fits runs */
+	memset(text, 0, sizeof(text));
+	memcpy(text, "echo ", 5);
+	memset(&text[5], 'a', CONSOLE_LINE_SIZE - 1 - 5);
+	strcat(text, "\r");
+	runs = 0;
+	expect("longest", feed(text, NULL), CONSOLE_OK);
+	expect("longest runs", runs, 1);
+	expect("longest length", strlen(lastArgs[1]), CONSOLE_LINE_SIZE - 1 - 5);
+
+	/* One more is discarded whole, backspace does not bring it back */
+	memset(text, 0, sizeof(text));
+	memcpy(text, "echo ", 5);
+	memset(&text[5], 'a', CONSOLE_LINE_SIZE - 5);
+	strcat(text, "\b\r\n");
+	runs = 0;
+	expect("overflow", feed(text, &lines), CONSOLE_OVERFLOW);
+	expect("overflow lines", lines, 1);
+	expect("overflow runs", runs, 0);
+
+	/* Far longer, then the next line works as usual */
+	memset(text, 'b', sizeof(text) - 1);
+	text[sizeof(text) - 1] = '\0';
+	expect("overflow long", feed(text, NULL), CONSOLE_PENDING);
+	expect("overflow long end", feed("\n", NULL), CONSOLE_OVERFLOW);
+	expect("after overflow", feed("echo ok\r\n", NULL), CONSOLE_OK);
+	expectText("after overflow argument", lastArgs[1], "ok");
+	expect("after overflow empty", feed("\r", NULL), CONSOLE_EMPTY);
+}
+
+static void words(void)
+{
+	CONSOLE_Init(&console, commands, sizeof(commands) / sizeof(commands[0]));
+
+	/* As many words as fit, extra blanks anywhere */
+	expect("max args", feed("  echo 1\t2  3 4   5 \r", NULL), CONSOLE_OK);
+	expect("max args argc", lastArgc, CONSOLE_MAX_ARGS);
+	expectText("max args last", lastArgs[CONSOLE_MAX_ARGS - 1], "5");
+
+	/* One more is a usage error, the handler is not called */
+	runs = 0;
+	expect("too many args", feed("echo 1 2 3 4 5 6\r", NULL), CONSOLE_USAGE);
+	expect("too many args runs", runs, 0);
+	expect("too many blanks after", feed("echo 1 2 3 4 5    \r", NULL), CONSOLE_OK);
+
+	/* Handler results come back as they are */
+	expect("handler usage", feed("one\r", NULL), CONSOLE_USAGE);
+	expect("handler ok", feed("one 7\r", NULL), CONSOLE_OK);
+	expect("unknown", feed("two 7\r", NULL), CONSOLE_UNKNOWN);
+	expect("prefix", feed("ech\r", NULL), CONSOLE_UNKNOWN);
+}
+
+static void parse(const char *text, bool ok, uint32_t expected)
+{
+	uint32_t value = 0xA5A5A5A5u;
+	char what[64];
+
+	snprintf(what, sizeof(what), "parse \"%s\"", text);
+	expect(what, CONSOLE_ParseUint(text, &value), ok);
+	snprintf(what, sizeof(what), "parse \"%s\" value", text);
+	expect(what, value, ok ? expected : 0xA5A5A5A5u);
+}
+
+static void numbers(void)
+{
+	parse("0", true, 0);
+	parse("42", true, 42);
+	parse("007", true, 7);
+	parse("4294967295", true, 4294967295u);
+	parse("4294967296", false, 0);
+	parse("4294967300", false, 0);
+	parse("99999999999", false, 0);
+	parse("0x0", true, 0);
+	parse("0xff", true, 0xFF);
+	parse("0XaB", true, 0xAB);
+	parse("0xFFFFFFFF", true, 0xFFFFFFFFu);
+	parse("0x00000000FFFFFFFF", true, 0xFFFFFFFFu);
+	parse("0x100000000", false, 0);
+
+	/* Nothing to parse */
+	parse("", false, 0);
+	parse("0x", false, 0);
+	parse("0X", false, 0);
+
+	/* Trailing garbage, signs, blanks, hex digits without the prefix */
+	parse("12a", false, 0);
+	parse("0x1g", false, 0);
+	parse("1 ", false, 0);
+	parse(" 1", false, 0);
+	parse("+1", false, 0);
+	parse("-1", false, 0);
+	parse("ff", false, 0);
+	parse("0x0x1", false, 0);
+}
+
+int main(void)
+{
+	endings();
+	editing();
+	overflow();
+	words();
+	numbers();
+	printf("console checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the critical section profiler bookkeeping
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Drives the em_core overrides of critprof.c with a fake cycle counter and
+ * PRIMASK: single sections, nested ones, yields, the disable/enable pair,
+ * sections open across CRITPROF_Start() and CRITPROF_Stop(), and a counter
+ * wrapping inside a window. Then random sections from SITES call sites
+ * against a model of the caller table. Each call site is a different
+ * return address; the address of each is learnt first by making it the
+ * longest window.
+ *
+ * Build:  gcc -O2 -Wall -DCRITPROF_HOST_MODEL -I. -o critprof_check tools/critprof_check.c critprof.c histogram.c
+ * Usage:  critprof_check [random sections]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "critprof.h"
+
+#define SITES		20
+
+static uint32_t failures;
+static CRITPROF_Stats_t stats;
+static HISTOGRAM_t histogram;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void get(void)
+{
+	CRITPROF_Get(&stats, &histogram);
+}
+
+/* A section taken from a known function, the caller must fall inside it */
+static __attribute__((noinline)) void sectionA(uint32_t cycles)
+{
+	CORE_irqState_t irqState = CORE_EnterCritical();
+
+	CRITPROF_HostCycles += cycles;
+	CORE_ExitCritical(irqState);
+}
+
+static __attribute__((noinline)) void sectionB(uint32_t cycles)
+{
+	CORE_irqState_t irqState = CORE_EnterAtomic();
+
+	CRITPROF_HostCycles += cycles;
+	sectionA(cycles);
+	CRITPROF_HostCycles += cycles;
+	CORE_ExitAtomic(irqState);
+}
+
+static void expectIn(const char *what, uint32_t pc, void (*function)(uint32_t))
+{
+	uint32_t start = (uint32_t)(uintptr_t)function;
+
+	if(pc < start || pc > start + 256)
+	{
+		failures++;
+		printf("FAIL: %s, caller %08x not in %08x\n", what, pc, start);
+	}
+}
+
+/* SITES call sites, one return address each. The count of runs keeps the
+ * compiler from folding them into one */
+static uint32_t siteRuns[SITES];
+
+#define SITE(n) \
+static __attribute__((noinline)) void site##n(uint32_t cycles) \
+{ \
+	CORE_irqState_t irqState = CORE_EnterCritical(); \
+\
+	CRITPROF_HostCycles += cycles; \
+	siteRuns[n]++; \
+	CORE_ExitCritical(irqState); \
+}
+SITE(0) SITE(1) SITE(2) SITE(3) SITE(4) SITE(5) SITE(6) SITE(7) SITE(8) SITE(9)
+SITE(10) SITE(11) SITE(12) SITE(13) SITE(14) SITE(15) SITE(16) SITE(17) SITE(18) SITE(19)
+#undef SITE
+
+static void (*const site[SITES])(uint32_t) = {
+	site0, site1, site2, site3, site4, site5, site6, site7, site8, site9,
+	site10, site11, site12, site13, site14, site15, site16, site17, site18, site19
+};
+
+static void sections(void)
+{
+	CORE_irqState_t irqState;
+
+	/* Not started, nothing recorded */
+	CRITPROF_Start();
+	CRITPROF_Stop();
+	sectionA(100);
+	get();
+	expect("stopped", histogram.count, 0);
+	expect("primask after", CRITPROF_HostPrimask, 0);
+
+	CRITPROF_Start();
+	sectionA(100);
+	sectionA(300);
+	sectionA(200);
+	get();
+	expect("count", histogram.count, 3);
+	expect("sum", (uint32_t)histogram.sum, 600);
+	expect("max", stats.maxCycles, 300);
+	expect("histogram max", histogram.max, 300);
+	expectIn("caller A", stats.maxPc, sectionA);
+	expect("callers", stats.callers[1].pc, 0);
+	expect("caller max", stats.callers[0].maxCycles, 300);
+
+	/* Nested, one window of the whole outer section, the outer caller */
+	CRITPROF_Start();
+	sectionB(1000);
+	get();
+	expect("nested count", histogram.count, 1);
+	expect("nested cycles", stats.maxCycles, 3000);
+	expectIn("nested caller", stats.maxPc, sectionB);
+	expect("nested primask", CRITPROF_HostPrimask, 0);
+
+	/* Yield, two windows of the same caller */
+	CRITPROF_Start();
+	irqState = CORE_EnterCritical();
+	CRITPROF_HostCycles += 500;
+	CORE_YieldCritical();
+	CRITPROF_HostCycles += 700;
+	CORE_ExitCritical(irqState);
+	get();
+	expect("yield count", histogram.count, 2);
+	expect("yields", stats.yields, 1);
+	expect("yield max", stats.maxCycles, 700);
+	expect("yield min", histogram.min, 500);
+	expect("yield callers", stats.callers[1].pc, 0);
+
+	/* Yield outside of a section does nothing */
+	CORE_YieldAtomic();
+	get();
+	expect("bare yield", stats.yields, 1);
+	expect("bare yield primask", CRITPROF_HostPrimask, 0);
+
+	/* The disable/enable pair */
+	CRITPROF_Start();
+	CORE_CriticalDisableIrq();
+	CRITPROF_HostCycles += 40;
+	CORE_CriticalEnableIrq();
+	CORE_AtomicDisableIrq();
+	CRITPROF_HostCycles += 60;
+	CORE_AtomicEnableIrq();
+	CORE_AtomicEnableIrq();
+	get();
+	expect("disable count", histogram.count, 2);
+	expect("disable sum", (uint32_t)histogram.sum, 100);
+
+	/* Open across a start, not counted; the counter wrapping inside one */
+	irqState = CORE_EnterCritical();
+	CRITPROF_Start();
+	expect("start keeps masked", CRITPROF_HostPrimask, 1);
+	CORE_ExitCritical(irqState);
+	CRITPROF_HostCycles = 0xFFFFFF00u;
+	sectionA(0x200);
+	get();
+	expect("across start", histogram.count, 1);
+	expect("wrap", stats.maxCycles, 0x200);
+
+	/* Open across a stop, not counted */
+	irqState = CORE_EnterCritical();
+	CRITPROF_Stop();
+	CORE_ExitCritical(irqState);
+	get();
+	expect("across stop", histogram.count, 1);
+}
+
+static void randomSections(uint32_t count)
+{
+	uint32_t pcs[SITES];
+	uint32_t longest[SITES];
+
+	/* Learn the return address of each site */
+	for(uint32_t s = 0; s < SITES; s++)
+	{
+		CRITPROF_Start();
+		site[s](10);
+		get();
+		pcs[s] = stats.maxPc;
+		for(uint32_t t = 0; t < s; t++)
+		{
+			expect("distinct sites", pcs[t] != pcs[s], 1);
+		}
+	}
+
+	srand(11);
+	memset(longest, 0, sizeof(longest));
+	CRITPROF_Start();
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t s = rand() % SITES;
+		/* Mostly short, some sites much longer now and then */
+		uint32_t cycles = 1 + rand() % 200 + ((rand() % 1000 == 0) ? (uint32_t)(rand() % 100000) * (s + 1) : 0);
+
+		site[s](cycles);
+		longest[s] = (cycles > longest[s]) ? cycles : longest[s];
+	}
+	get();
+	expect("random count", histogram.count, count);
+
+	for(uint32_t c = 0; c < CRITPROF_CALLERS; c++)
+	{
+		uint32_t s;
+
+		for(s = 0; s < SITES && pcs[s] != stats.callers[c].pc; s++)
+		{
+		}
+		expect("caller known", s < SITES, 1);
+		if(s == SITES)
+		{
+			continue;
+		}
+		expect("caller longest", stats.callers[c].maxCycles, longest[s]);
+		if(c > 0)
+		{
+			expect("callers ordered", stats.callers[c].maxCycles <= stats.callers[c - 1].maxCycles, 1);
+		}
+		longest[s] = 0;
+	}
+	/* No site left out is longer than the shortest kept */
+	for(uint32_t s = 0; s < SITES; s++)
+	{
+		expect("site left out", longest[s] <= stats.callers[CRITPROF_CALLERS - 1].maxCycles, 1);
+	}
+	expect("max is first caller", stats.maxPc, stats.callers[0].pc);
+	expect("max cycles", stats.maxCycles, stats.callers[0].maxCycles);
+
+	printf("%u sections, mean %u max %u cycles, p99 %u\n", histogram.count, HISTOGRAM_Mean(&histogram),
+			histogram.max, HISTOGRAM_Percentile(&histogram, 990));
+	for(uint32_t c = 0; c < CRITPROF_CALLERS; c++)
+	{
+		printf("  %08x %u\n", stats.callers[c].pc, stats.callers[c].maxCycles);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+
+	sections();
+	randomSections(count);
+	printf("critprof checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
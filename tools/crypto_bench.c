@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host known answer tests and benchmark of the software crypto backend
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs CRYPTOBACKEND_SelfTest() on the software backend, then prints bytes
+ * per second for every operation and buffer size. The sizes are the
+ * CRYPTOBACKEND_Bench() buffer, for mul the size of each operand. These are
+ * host figures, for deciding what is worth offloading compare the board's
+ * "cryptobench" console command, which times both backends on the EFR32.
+ *
+ * Build:  gcc -O2 -Wall -DCRYPTOBACKEND_SOFTWARE_ONLY -DCRYPTOBACKEND_BENCH_MAX=4096 -I. \
+ *             -o crypto_bench tools/crypto_bench.c cryptobackend.c cryptobackend_sw.c
+ * Usage:  crypto_bench [milliseconds per cell]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cryptobackend.h"
+
+static const uint32_t sizes[] = { 16, 64, 256, 1024, 4096 };
+#define SIZES		(sizeof(sizes) / sizeof(sizes[0]))
+
+/* Doubles the iterations until one call of CRYPTOBACKEND_Bench() fills the time */
+static double bytesPerSecond(CRYPTOBACKEND_Operation_t operation, uint32_t size, uint32_t milliseconds)
+{
+	uint64_t budget = (uint64_t)milliseconds * 1000000u;
+
+	for(uint32_t iterations = 1; iterations < (1u << 30); iterations *= 2)
+	{
+		uint32_t perCall = CRYPTOBACKEND_Bench(&CRYPTOBACKEND_Software, operation, size, iterations);
+
+		if(perCall == 0 && iterations == 1)
+		{
+			return 0.0;
+		}
+		if((uint64_t)perCall * iterations >= budget)
+		{
+			return (double)size * CRYPTOBACKEND_CyclesPerSecond() / perCall;
+		}
+	}
+	return 0.0;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t milliseconds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100;
+	uint32_t failures = CRYPTOBACKEND_SelfTest(&CRYPTOBACKEND_Software);
+
+	printf("software backend self test: %u failures\n\n", failures);
+
+	printf("%-8s", "MB/s");
+	for(uint32_t s = 0; s < SIZES; s++)
+	{
+		printf("%10u", sizes[s]);
+	}
+	printf("\n");
+
+	for(uint32_t op = 0; op < CRYPTOBACKEND_OPERATIONS; op++)
+	{
+		printf("%-8s", CRYPTOBACKEND_OperationName(op));
+		for(uint32_t s = 0; s < SIZES; s++)
+		{
+			double rate = bytesPerSecond(op, sizes[s], milliseconds);
+
+			if(rate == 0.0)
+			{
+				printf("%10s", "-");
+			}
+			else
+			{
+				printf("%10.2f", rate / 1e6);
+			}
+		}
+		printf("\n");
+	}
+
+	return failures ? 1 : 0;
+}
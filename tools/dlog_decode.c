@@ -0,0 +1,334 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host decoder for DLOG() records
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Turns the binary record stream written by DLOG_Flush() back into text,
+ * using the format strings stored in the .dlog_fmt section of the .axf that
+ * produced it. Bytes outside of valid records are printed unchanged.
+ *
+ * Build:  gcc -O2 -Wall -o dlog_decode tools/dlog_decode.c
+ * Usage:  dlog_decode <app.axf> [capture.bin]     (stdin if no capture)
+ *         e.g. stty -F /dev/ttyACM0 115200 raw && dlog_decode app.axf /dev/ttyACM0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../dlog.h"
+
+#define RTCC_TICKS_PER_SECOND 32768.0
+
+#define FRAME_MAX (DLOG_HEADER_SIZE + (4 * DLOG_MAX_ARGS) + 1)
+
+static char *fmtSection;
+static uint32_t fmtSectionSize;
+
+/* Bytes handed back after a failed record so they are scanned again */
+static uint8_t rescan[2 * FRAME_MAX];
+static uint32_t rescanLen;
+
+static uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static int nextByte(FILE *in)
+{
+	if(rescanLen)
+	{
+		int c = rescan[0];
+		memmove(rescan, rescan + 1, --rescanLen);
+		return c;
+	}
+	return fgetc(in);
+}
+
+static void pushBack(const uint8_t *data, uint32_t len)
+{
+	memmove(rescan + len, rescan, rescanLen);
+	memcpy(rescan, data, len);
+	rescanLen += len;
+}
+
+/**************************************************************************//**
+* @brief Load the .dlog_fmt section of a little endian ELF32 image
+*****************************************************************************/
+static int loadFormats(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *elf;
+	long size;
+	uint32_t shoff, shentsize, shnum, shstrndx;
+	uint32_t shstrOffset, shstrSize;
+	const uint8_t *shstr;
+
+	if(!f)
+	{
+		perror(path);
+		return -1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	elf = malloc(size);
+	if(!elf || fread(elf, 1, size, f) != (size_t)size)
+	{
+		fprintf(stderr, "%s: read failed\n", path);
+		free(elf);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	if(size < 52 || memcmp(elf, "\177ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1)
+	{
+		fprintf(stderr, "%s: not a little endian ELF32 file\n", path);
+		free(elf);
+		return -1;
+	}
+
+	shoff = le32(&elf[32]);
+	shentsize = le16(&elf[46]);
+	shnum = le16(&elf[48]);
+	shstrndx = le16(&elf[50]);
+	if(shentsize < 40 || shstrndx >= shnum || (shoff + (uint64_t)shnum * shentsize) > (uint64_t)size)
+	{
+		fprintf(stderr, "%s: bad section header table\n", path);
+		free(elf);
+		return -1;
+	}
+	shstrOffset = le32(&elf[shoff + shstrndx * shentsize + 16]);
+	shstrSize = le32(&elf[shoff + shstrndx * shentsize + 20]);
+	if((uint64_t)shstrOffset + shstrSize > (uint64_t)size)
+	{
+		fprintf(stderr, "%s: bad section name table\n", path);
+		free(elf);
+		return -1;
+	}
+	shstr = elf + shstrOffset;
+
+	for(uint32_t i = 0; i < shnum; i++)
+	{
+		const uint8_t *sh = &elf[shoff + i * shentsize];
+		uint32_t offset = le32(&sh[16]);
+		uint32_t len = le32(&sh[20]);
+		uint32_t name = le32(&sh[0]);
+
+		/* The name and its NUL have to lie inside the name table */
+		if(name >= shstrSize || shstrSize - name < sizeof(DLOG_SECTION))
+		{
+			continue;
+		}
+		if(memcmp(shstr + name, DLOG_SECTION, sizeof(DLOG_SECTION)) == 0)
+		{
+			if((uint64_t)offset + len > (uint64_t)size)
+			{
+				break;
+			}
+			/* One extra NUL so a truncated last string is still terminated */
+			fmtSection = calloc(1, len + 1);
+			memcpy(fmtSection, &elf[offset], len);
+			fmtSectionSize = len;
+			free(elf);
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "%s: no %s section, was the image linked with DLOG support?\n", path, DLOG_SECTION);
+	free(elf);
+	return -1;
+}
+
+/**************************************************************************//**
+* @brief printf() a format string whose arguments are raw 32-bit words
+*****************************************************************************/
+static void printRecord(const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+	char spec[32];
+	uint32_t arg = 0;
+
+	while(*fmt)
+	{
+		size_t n;
+		char conv;
+		uint32_t value;
+
+		if(*fmt != '%')
+		{
+			putchar(*fmt++);
+			continue;
+		}
+		if(fmt[1] == '%')
+		{
+			putchar('%');
+			fmt += 2;
+			continue;
+		}
+
+		/* Copy flags, width and precision, drop length modifiers */
+		n = 0;
+		spec[n++] = *fmt++;
+		while(*fmt && strchr("-+ #0123456789.", *fmt) && n < sizeof(spec) - 3)
+		{
+			spec[n++] = *fmt++;
+		}
+		while(*fmt && strchr("hlLjzt", *fmt))
+		{
+			fmt++;
+		}
+		conv = *fmt;
+		if(conv == '\0')
+		{
+			break;
+		}
+		fmt++;
+
+		value = (arg < nargs) ? args[arg] : 0;
+		arg++;
+
+		switch(conv)
+		{
+		case 'd':
+		case 'i':
+			spec[n++] = conv;
+			spec[n] = '\0';
+			printf(spec, (int32_t)value);
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'c':
+			spec[n++] = conv;
+			spec[n] = '\0';
+			printf(spec, value);
+			break;
+		case 'p':
+			printf("0x%08x", value);
+			break;
+		case 'f':
+		case 'e':
+		case 'g':
+		{
+			/* Only meaningful if the caller passed the bits of a float */
+			float fvalue;
+			memcpy(&fvalue, &value, sizeof(fvalue));
+			spec[n++] = conv;
+			spec[n] = '\0';
+			printf(spec, (double)fvalue);
+			break;
+		}
+		default:
+			/* %s and anything else cannot be recovered from a 32-bit word */
+			printf("<%c:0x%08x>", conv, value);
+			break;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	uint8_t frame[FRAME_MAX];
+	uint32_t len = 0;
+	uint32_t bad = 0;
+	int c;
+
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "usage: %s <app.axf> [capture]\n", argv[0]);
+		return 1;
+	}
+	if(loadFormats(argv[1]) != 0)
+	{
+		return 1;
+	}
+	if(argc == 3 && !(in = fopen(argv[2], "rb")))
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	while((c = nextByte(in)) != EOF)
+	{
+		uint32_t need;
+
+		if(len == 0 && c != DLOG_SYNC)
+		{
+			putchar(c);
+			continue;
+		}
+		frame[len++] = (uint8_t)c;
+
+		if(len < 2)
+		{
+			continue;
+		}
+		if(frame[1] > DLOG_MAX_ARGS)
+		{
+			/* Not a record after all, emit the sync byte as text */
+			putchar(frame[0]);
+			pushBack(&frame[1], len - 1);
+			len = 0;
+			continue;
+		}
+		need = DLOG_HEADER_SIZE + (4 * frame[1]) + 1;
+		if(len < need)
+		{
+			continue;
+		}
+
+		uint8_t checksum = 0;
+		for(uint32_t i = 0; i < need - 1; i++)
+		{
+			checksum ^= frame[i];
+		}
+		uint16_t id = le16(&frame[2]);
+
+		if(checksum != frame[need - 1] || id >= fmtSectionSize)
+		{
+			/* Resync: print the sync byte as text and rescan what follows it */
+			bad++;
+			putchar(frame[0]);
+			pushBack(&frame[1], len - 1);
+			len = 0;
+			continue;
+		}
+
+		uint32_t args[DLOG_MAX_ARGS];
+		for(uint32_t i = 0; i < frame[1]; i++)
+		{
+			args[i] = le32(&frame[DLOG_HEADER_SIZE + 4 * i]);
+		}
+		printf("[%10.6f] ", le32(&frame[4]) / RTCC_TICKS_PER_SECOND);
+		printRecord(&fmtSection[id], args, frame[1]);
+		fflush(stdout);
+		len = 0;
+	}
+
+	if(bad)
+	{
+		fprintf(stderr, "%u corrupted records skipped\n", bad);
+	}
+	return 0;
+}
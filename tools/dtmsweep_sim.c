@@ -0,0 +1,448 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the DTM sweep schedule and its packet error rates
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs dtmsweep.c as the receiver against a transmitter played here on a
+ * clock of its own: it takes the common start late by most of the sync
+ * allowance and runs 100 ppm fast or slow. It sends its packets I(L) apart
+ * in its windows, a packet counts when it falls whole inside the window the
+ * module opened, and a Wi-Fi like loss per channel and PHY drops some. The
+ * stack's completed events come a little after each command.
+ *
+ * Checks the packet spacing against worked examples of the specification,
+ * that every transmit window falls inside its receive window whatever the
+ * drift, so a clean sweep has no errors, that the rates found are those
+ * played, and the failed start, the lost count and the stop. A transmit
+ * run checks its windows open and close on their ticks. Prints the heatmap
+ * of the interference run.
+ *
+ * Build:  gcc -O2 -Wall -I. -o dtmsweep_sim tools/dtmsweep_sim.c dtmsweep.c -lm
+ * Usage:  dtmsweep_sim
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dtmsweep.h"
+
+#define US_PER_TICK		(1000000.0 / 32768.0)
+#define LATENCY_US		800.0				// Command to completed event
+#define NEVER			1e30
+
+typedef struct {
+	const char *name;
+	double syncUs;							// Transmitter takes the start this much later
+	double ppm;								// Transmitter clock error
+	bool wifi;								// Loss over Wi-Fi channel 6
+	int failChannel;						// Start refused on this channel, -1 for none
+	int nackChannel;						// Start acknowledged with an error, -1 for none
+	int lostCell;							// No count after the end of this cell, -1 for none
+	int stopCell;							// Stopped while this cell is open, -1 for none
+} Scenario_t;
+
+static const Scenario_t *scenario;
+static uint32_t failures;
+static double now;							// True time, microseconds
+static double timerAt;
+static double completedAt;
+static uint16_t completedResult;
+static uint16_t completedPackets;
+static double openAt;
+static uint32_t rxBase;						// Receiver RTCC at true time 0
+static uint32_t rxStart;					// Common start on the receiver's RTCC
+static uint32_t opened;
+static uint32_t ended;
+static uint32_t doneCount;
+static uint32_t played[DTMSWEEP_MAX_CELLS];	// Received as played here
+static uint64_t rng = 88172645463325252ull;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s: %s, %u instead of %u\n", scenario ? scenario->name : "basics", what, got, expected);
+	}
+}
+
+static double uniform(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return (rng >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint32_t rtcc(void)
+{
+	return rxBase + (uint32_t)floor(now / US_PER_TICK);
+}
+
+/* Loss on the 22 MHz of Wi-Fi channel 6, 2426 to 2448 MHz; coded PHYs get more through */
+static double loss(uint8_t channel, uint8_t phy)
+{
+	uint32_t mhz = 2402 + 2 * channel;
+
+	if(!scenario->wifi || mhz < 2426 || mhz > 2448)
+	{
+		return 0.0;
+	}
+	return (phy == DTMSWEEP_PHY_S8) ? 0.05 : (phy == DTMSWEEP_PHY_S2) ? 0.15 : 0.30;
+}
+
+static uint32_t packetUs(uint8_t phy, uint8_t length)
+{
+	switch(phy)
+	{
+		case DTMSWEEP_PHY_2M:
+			return (length + 11) * 4;
+		case DTMSWEEP_PHY_S8:
+			return 680 + 64 * length;
+		case DTMSWEEP_PHY_S2:
+			return 422 + 16 * length;
+		default:
+			return (length + 10) * 8;
+	}
+}
+
+/* Port ------------------------------------------------------------------- */
+
+static bool rx(uint8_t channel, uint8_t phy)
+{
+	(void)phy;
+	expect("open while open", openAt != NEVER, false);
+	if(channel == scenario->failChannel)
+	{
+		return false;
+	}
+	openAt = now;
+	completedAt = now + LATENCY_US;
+	completedResult = (channel == scenario->nackChannel) ? 0x0181 : 0;
+	completedPackets = 0;
+	opened++;
+	return true;
+}
+
+/* Transmitting, the window opens on its tick and the count is what was sent */
+static bool tx(uint8_t length, uint8_t channel, uint8_t phy)
+{
+	uint32_t open, close;
+
+	DTMSWEEP_Window(DTMSWEEP_Done(), DTMSWEEP_TX, &open, &close);
+	expect("transmit opens on time", rtcc() - rxStart, open);
+	openAt = now;
+	completedAt = now + LATENCY_US;
+	completedResult = 0;
+	completedPackets = 0;
+	played[DTMSWEEP_Done()] = DTMSWEEP_Expected(phy, length, DTMSWEEP_Plan()->cellTicks) + channel % 2;
+	opened++;
+	return true;
+}
+
+/* Count what the transmitter sent inside the window just closed */
+static void end(void)
+{
+	const DTMSWEEP_Plan_t *plan = DTMSWEEP_Plan();
+	uint32_t index = DTMSWEEP_Done();
+	uint32_t open, close, received = 0;
+	double txOpen, txScale = 1.0 / (1.0 + scenario->ppm * 1e-6);
+	DTMSWEEP_Cell_t cell;
+
+	if(DTMSWEEP_Role() == DTMSWEEP_TX)
+	{
+		DTMSWEEP_Window(index, DTMSWEEP_TX, &open, &close);
+		expect("transmit closes on time", rtcc() - rxStart, close);
+		openAt = NEVER;
+		ended++;
+		completedAt = now + LATENCY_US;
+		completedPackets = (uint16_t)played[index];
+		return;
+	}
+	if((int)index == scenario->stopCell)
+	{
+		/* Stopped before the window closed, nothing comes back */
+		openAt = NEVER;
+		ended++;
+		return;
+	}
+
+	DTMSWEEP_Cell(index, &cell);
+	DTMSWEEP_Window(index, DTMSWEEP_TX, &open, &close);
+	txOpen = (rxStart - rxBase) * US_PER_TICK + scenario->syncUs + open * US_PER_TICK * txScale;
+
+	for(uint32_t n = 0; n < DTMSWEEP_Expected(cell.phy, cell.length, plan->cellTicks); n++)
+	{
+		double at = txOpen + n * DTMSWEEP_PacketInterval(cell.phy, cell.length) * txScale;
+
+		if(at < openAt || at + packetUs(cell.phy, cell.length) > now)
+		{
+			failures++;
+			printf("FAIL: %s: cell %u packet %u outside the window by %.0f us\n", scenario->name, index, n,
+					(at < openAt) ? openAt - at : at + packetUs(cell.phy, cell.length) - now);
+			break;
+		}
+		if(uniform() >= loss(cell.channel, cell.phy))
+		{
+			received++;
+		}
+	}
+
+	played[index] = received;
+	openAt = NEVER;
+	ended++;
+	if((int)index != scenario->lostCell)
+	{
+		completedAt = now + LATENCY_US;
+		completedResult = 0;
+		completedPackets = (uint16_t)received;
+	}
+}
+
+static void timer(uint32_t ticks)
+{
+	timerAt = ticks ? now + ticks * US_PER_TICK : NEVER;
+}
+
+static void done(void)
+{
+	doneCount++;
+	expect("timer armed at done", timerAt == NEVER, true);
+}
+
+static const DTMSWEEP_Port_t port = { rx, tx, end, timer, done };
+
+/* ------------------------------------------------------------------------ */
+
+static void defaultPlan(DTMSWEEP_Plan_t *plan)
+{
+	static const uint8_t phys[] = { DTMSWEEP_PHY_1M, DTMSWEEP_PHY_2M, DTMSWEEP_PHY_S2, DTMSWEEP_PHY_S8 };
+	static const uint8_t lengths[] = { 37, 128, 255 };
+
+	memset(plan, 0, sizeof(*plan));
+	plan->channels = ((uint64_t)1 << DTMSWEEP_CHANNELS) - 1;
+	memcpy(plan->phys, phys, sizeof(phys));
+	plan->phyCount = sizeof(phys);
+	memcpy(plan->lengths, lengths, sizeof(lengths));
+	plan->lengthCount = sizeof(lengths);
+	plan->cellTicks = 32768 / 4;
+	plan->syncTicks = 32768 / 20;
+}
+
+static void run(const Scenario_t *s, const DTMSWEEP_Plan_t *plan, DTMSWEEP_Role_t role)
+{
+	scenario = s;
+	now = 0;
+	timerAt = NEVER;
+	completedAt = NEVER;
+	openAt = NEVER;
+	rxBase = 0xfff00000u;					// Wraps during the sweep
+	rxStart = rxBase + 32768;
+	opened = ended = doneCount = 0;
+	memset(played, 0, sizeof(played));
+
+	expect("start", DTMSWEEP_Start(&port, plan, role, rxStart, rtcc()), true);
+	expect("second start", DTMSWEEP_Start(&port, plan, role, rxStart, rtcc()), false);
+
+	while(DTMSWEEP_Running())
+	{
+		if((int)DTMSWEEP_Done() == s->stopCell && openAt != NEVER && completedAt == NEVER)
+		{
+			DTMSWEEP_Stop();
+		}
+		else if(completedAt < timerAt)
+		{
+			now = completedAt;
+			completedAt = NEVER;
+			if(completedResult != 0)
+			{
+				/* Did not start, nothing to end */
+				openAt = NEVER;
+			}
+			DTMSWEEP_Completed(completedResult, completedPackets, rtcc());
+		}
+		else if(timerAt != NEVER)
+		{
+			now = timerAt;
+			timerAt = NEVER;
+			DTMSWEEP_Timer(rtcc());
+		}
+		else
+		{
+			expect("stalled", 0, 1);
+			break;
+		}
+	}
+	expect("done once", doneCount, 1);
+}
+
+/* Every cell with a figure has what was played, no cell lost a packet to the schedule */
+static void expectCells(void)
+{
+	DTMSWEEP_Cell_t cell;
+
+	for(uint32_t i = 0; i < DTMSWEEP_Done() && DTMSWEEP_Cell(i, &cell); i++)
+	{
+		if(cell.flags == 0)
+		{
+			expect("cell packets", cell.packets, played[i]);
+		}
+	}
+}
+
+static void heatmap(const DTMSWEEP_Plan_t *plan)
+{
+	printf("%s, PER permille\n MHz", scenario->name);
+	for(uint32_t p = 0; p < plan->phyCount; p++)
+	{
+		printf("  phy%u", plan->phys[p]);
+	}
+	printf("\n");
+	for(uint8_t c = 0; c < DTMSWEEP_CHANNELS; c++)
+	{
+		printf("%u", 2402 + 2 * c);
+		for(uint32_t p = 0; p < plan->phyCount; p++)
+		{
+			uint32_t per = DTMSWEEP_Per(c, plan->phys[p]);
+
+			if(per == DTMSWEEP_NO_DATA)
+			{
+				printf("     -");
+			}
+			else
+			{
+				printf("  %4u", per);
+			}
+		}
+		printf("\n");
+	}
+}
+
+static void basics(void)
+{
+	DTMSWEEP_Plan_t plan;
+
+	/* Core specification Vol 6 Part F 4.1.6, I(L) = ceil((L + 249) / 625) * 625 us */
+	expect("1M 37", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_1M, 37), 625);
+	expect("1M 255", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_1M, 255), 2500);
+	expect("2M 255", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_2M, 255), 1875);
+	expect("S2 37", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_S2, 37), 1875);
+	expect("S8 37", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_S8, 37), 3750);
+	expect("S8 255", DTMSWEEP_PacketInterval(DTMSWEEP_PHY_S8, 255), 17500);
+	expect("expected 1M 37 1 s", DTMSWEEP_Expected(DTMSWEEP_PHY_1M, 37, 32768), 1600);
+	expect("expected S8 255 1 s", DTMSWEEP_Expected(DTMSWEEP_PHY_S8, 255, 32768), 58);
+
+	defaultPlan(&plan);
+	plan.channels = 0;
+	expect("no channel", DTMSWEEP_Start(&port, &plan, DTMSWEEP_RX, 0, 0), false);
+	plan.channels = (uint64_t)1 << DTMSWEEP_CHANNELS;
+	expect("channel 40", DTMSWEEP_Start(&port, &plan, DTMSWEEP_RX, 0, 0), false);
+	defaultPlan(&plan);
+	plan.lengthCount = 0;
+	expect("no length", DTMSWEEP_Start(&port, &plan, DTMSWEEP_RX, 0, 0), false);
+}
+
+int main(void)
+{
+	static const Scenario_t late = { "transmitter late and fast", 40000.0, 100.0, false, -1, -1, -1, -1 };
+	static const Scenario_t early = { "transmitter early and slow", -40000.0, -100.0, false, -1, -1, -1, -1 };
+	static const Scenario_t wifi = { "Wi-Fi channel 6", 10000.0, 30.0, true, -1, -1, -1, -1 };
+	static const Scenario_t faults = { "refused, nacked and lost", 0.0, 0.0, false, 5, 7, 100, -1 };
+	static const Scenario_t stop = { "stopped", 0.0, 0.0, false, -1, -1, -1, 30 };
+	static const Scenario_t sending = { "transmitting", 0.0, 0.0, false, -1, -1, -1, -1 };
+	DTMSWEEP_Plan_t plan;
+	DTMSWEEP_Cell_t cell;
+	uint32_t worst = 0, worstPer = 0;
+
+	basics();
+	defaultPlan(&plan);
+
+	run(&late, &plan, DTMSWEEP_RX);
+	expect("cells", DTMSWEEP_Done(), 480);
+	expect("opened", opened, 480);
+	expectCells();
+	for(uint8_t c = 0; c < DTMSWEEP_CHANNELS; c++)
+	{
+		expect("clean PER", DTMSWEEP_Per(c, DTMSWEEP_PHY_1M), 0);
+		expect("clean PER", DTMSWEEP_Per(c, DTMSWEEP_PHY_S8), 0);
+	}
+
+	run(&early, &plan, DTMSWEEP_RX);
+	expect("cells", DTMSWEEP_Done(), 480);
+	expectCells();
+
+	run(&wifi, &plan, DTMSWEEP_RX);
+	expectCells();
+	heatmap(&plan);
+	for(uint8_t c = 0; c < DTMSWEEP_CHANNELS; c++)
+	{
+		for(uint32_t p = 0; p < plan.phyCount; p++)
+		{
+			uint32_t expected = 0;
+			double rate = loss(c, plan.phys[p]);
+			uint32_t per = DTMSWEEP_Per(c, plan.phys[p]);
+			double sigma;
+
+			for(uint32_t l = 0; l < plan.lengthCount; l++)
+			{
+				expected += DTMSWEEP_Expected(plan.phys[p], plan.lengths[l], plan.cellTicks);
+			}
+			sigma = 1000.0 * sqrt(rate * (1.0 - rate) / expected);
+			if(fabs(per - 1000.0 * rate) > 4 * sigma + 1)
+			{
+				failures++;
+				printf("FAIL: %s: channel %u phy %u PER %u played %.0f\n", scenario->name, c, plan.phys[p], per,
+						1000.0 * rate);
+			}
+			if(plan.phys[p] == DTMSWEEP_PHY_1M && per > worstPer)
+			{
+				worstPer = per;
+				worst = c;
+			}
+		}
+	}
+	expect("worst channel under Wi-Fi", worst >= 12 && worst <= 23, true);
+
+	run(&faults, &plan, DTMSWEEP_RX);
+	expect("cells", DTMSWEEP_Done(), 480);
+	expectCells();
+	expect("refused channel", DTMSWEEP_Per(5, DTMSWEEP_PHY_1M), DTMSWEEP_NO_DATA);
+	expect("nacked channel", DTMSWEEP_Per(7, DTMSWEEP_PHY_2M), DTMSWEEP_NO_DATA);
+	expect("opened", opened, 480 - 12);
+	DTMSWEEP_Cell(5, &cell);
+	expect("refused flag", cell.flags, DTMSWEEP_FAILED);
+	DTMSWEEP_Cell(7, &cell);
+	expect("nacked flag", cell.flags, DTMSWEEP_FAILED);
+	DTMSWEEP_Cell(100, &cell);
+	expect("lost flag", cell.flags, DTMSWEEP_NO_END);
+	DTMSWEEP_Cell(101, &cell);
+	expect("after the lost count", cell.flags, 0);
+
+	run(&stop, &plan, DTMSWEEP_RX);
+	expect("stopped cells", DTMSWEEP_Done(), 30);
+	expect("stopped cell ended", ended, opened);
+	DTMSWEEP_Cell(30, &cell);
+	expect("stopped flag", cell.flags, DTMSWEEP_FAILED);
+
+	run(&sending, &plan, DTMSWEEP_TX);
+	expect("cells", DTMSWEEP_Done(), 480);
+	expectCells();
+	expect("no PER transmitting", DTMSWEEP_Per(0, DTMSWEEP_PHY_1M), DTMSWEEP_NO_DATA);
+
+	printf("dtm checks: %u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,253 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the energy accounting and ranking of runs by energy
+ * per delivered bit
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* First checks energy.c on a PC: the airtime of PDUs whose on-air time the
+ * Core specification gives, a made up sleep and wake sequence whose
+ * residency is known, and a hand computed estimate. Then reads the lines
+ * the "energy csv" console command printed after each run, from one board
+ * or several, prices them with the current table and prints the runs from
+ * the fewest to the most microjoules per delivered bit. Lines that are not
+ * 13 numbers, headers and console echo, are skipped.
+ *
+ * Build:  gcc -O2 -Wall -DENERGY_HOST_MODEL -I. -o energy_rank tools/energy_rank.c energy.c
+ * Usage:  energy_rank [-c em0,em1,em2,em3,tx,rx,mV] [runs.csv]
+ *         Currents in uA, the default is ENERGY_CURRENTS_DEFAULT
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "energy.h"
+
+#define MAX_RUNS		256
+#define FIELDS			13
+
+typedef struct {
+	uint32_t line;
+	uint32_t phy;
+	uint32_t mode;
+	uint32_t data;
+	uint32_t pdu;
+	uint32_t interval;
+	uint32_t bits;
+	ENERGY_Residency_t residency;
+	ENERGY_Estimate_t estimate;
+} Run_t;
+
+static Run_t runs[MAX_RUNS];
+static uint32_t failures;
+
+static void fail(const char *what, uint32_t got, uint32_t expected)
+{
+	failures++;
+	printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+}
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		fail(what, got, expected);
+	}
+}
+
+static void checks(void)
+{
+	static const ENERGY_Currents_t currents = { { 1000, 100, 10, 1 }, 5000, 6000, 3000 };
+	ENERGY_Residency_t r;
+	ENERGY_Estimate_t e;
+
+	/* Empty PDU 80 us on 1M, a 27 byte one 296 us without MIC, 251 bytes
+	 * 2088 us on 1M and 1048 us on 2M, 27 bytes on S8 2448 us */
+	expect("1M empty", ENERGY_AirtimeMicroseconds(ENERGY_PHY_1M, 0), 80);
+	expect("1M 27", ENERGY_AirtimeMicroseconds(ENERGY_PHY_1M, 27), 296);
+	expect("1M 251", ENERGY_AirtimeMicroseconds(ENERGY_PHY_1M, 251), 2088);
+	expect("2M 251", ENERGY_AirtimeMicroseconds(ENERGY_PHY_2M, 251), 1048);
+	expect("S8 27", ENERGY_AirtimeMicroseconds(ENERGY_PHY_S8, 27), 2448);
+	expect("S2 0", ENERGY_AirtimeMicroseconds(ENERGY_PHY_S2, 0), 462);
+
+	/* Nothing counts before the start */
+	ENERGY_Sleep(ENERGY_EM1, 10);
+	ENERGY_Wake(20);
+	ENERGY_Start(1000);
+	ENERGY_Sleep(ENERGY_EM1, 1100);
+	ENERGY_Wake(1400);
+	ENERGY_Sleep(ENERGY_EM2, 1500);
+	ENERGY_Wake(2500);
+	ENERGY_Sleep(ENERGY_EM1, 2600);
+	ENERGY_GetResidency(&r, 2700);
+	expect("open interval", r.ticks[ENERGY_EM1], 300 + 100);
+	ENERGY_Wake(2800);
+	ENERGY_Packet(ENERGY_PHY_1M, 251 + 27, 251, true);
+	ENERGY_Packet(ENERGY_PHY_2M, 5, 27, false);
+	ENERGY_Stop(3000);
+	ENERGY_Sleep(ENERGY_EM1, 3100);
+	ENERGY_Wake(3200);
+	ENERGY_GetResidency(&r, 4000);
+	expect("EM0 ticks", r.ticks[ENERGY_EM0], 100 + 100 + 100 + 200);
+	expect("EM1 ticks", r.ticks[ENERGY_EM1], 300 + 200);
+	expect("EM2 ticks", r.ticks[ENERGY_EM2], 1000);
+	expect("EM1 entries", r.sleeps[ENERGY_EM1], 2);
+	expect("wake ups", r.sleeps[ENERGY_EM0], 3);
+	expect("tx airtime", r.txMicroseconds, 2088 + 296 + 44);
+	expect("rx airtime", r.rxMicroseconds, 80 + 80 + (8 * 6 + 8 * 10) / 2);
+	expect("tx pdus", r.txPackets, 3);
+
+	/* One second in each mode, 100 ms of each radio direction:
+	 * 3000 mV * (1111 uA * 1 s + 5000 uA * 0.1 s + 6000 uA * 0.1 s) = 6633 uJ */
+	memset(&r, 0, sizeof(r));
+	for(uint32_t m = 0; m < ENERGY_MODES; m++)
+	{
+		r.ticks[m] = ENERGY_TICKS_PER_SECOND;
+	}
+	r.txMicroseconds = 100000;
+	r.rxMicroseconds = 100000;
+	ENERGY_Estimate(&r, &currents, 1000000, &e);
+	expect("microjoules", e.microjoules, 3000 * 1111 / 1000 + 1500 + 1800);
+	expect("average", e.averageMicroamps, 6633000 / (4 * 3000));
+	expect("pJ/bit", e.picojoulesPerBit, 6633);
+	expect("radio share", e.radioPermille, 3300 * 1000 / 6633);
+}
+
+static const char *phyName(uint32_t phy)
+{
+	switch(phy)
+	{
+		case ENERGY_PHY_1M:
+			return "1M";
+		case ENERGY_PHY_2M:
+			return "2M";
+		case ENERGY_PHY_S8:
+			return "S8";
+		case ENERGY_PHY_S2:
+			return "S2";
+		default:
+			return "?";
+	}
+}
+
+static int byEnergy(const void *a, const void *b)
+{
+	const Run_t *x = a;
+	const Run_t *y = b;
+
+	if(x->estimate.picojoulesPerBit != y->estimate.picojoulesPerBit)
+	{
+		return (x->estimate.picojoulesPerBit < y->estimate.picojoulesPerBit) ? -1 : 1;
+	}
+	return (x->line < y->line) ? -1 : 1;
+}
+
+static uint32_t readRuns(FILE *in, const ENERGY_Currents_t *currents)
+{
+	char text[512];
+	uint32_t count = 0;
+	uint32_t line = 0;
+
+	while(fgets(text, sizeof(text), in) != NULL && count < MAX_RUNS)
+	{
+		unsigned long v[FIELDS];
+		Run_t *run = &runs[count];
+
+		line++;
+		if(sscanf(text, "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", &v[0], &v[1], &v[2], &v[3], &v[4],
+				&v[5], &v[6], &v[7], &v[8], &v[9], &v[10], &v[11], &v[12]) != FIELDS)
+		{
+			continue;
+		}
+
+		memset(run, 0, sizeof(*run));
+		run->line = line;
+		run->phy = v[0];
+		run->mode = v[1];
+		run->data = v[2];
+		run->pdu = v[3];
+		run->interval = v[4];
+		run->bits = v[5];
+		for(uint32_t m = 0; m < ENERGY_MODES; m++)
+		{
+			run->residency.ticks[m] = v[6 + m];
+		}
+		run->residency.sleeps[ENERGY_EM0] = v[10];
+		run->residency.txMicroseconds = v[11];
+		run->residency.rxMicroseconds = v[12];
+		ENERGY_Estimate(&run->residency, currents, run->bits, &run->estimate);
+		count++;
+	}
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	ENERGY_Currents_t currents = ENERGY_CURRENTS_DEFAULT;
+	FILE *in = NULL;
+	uint32_t count;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+		{
+			if(sscanf(argv[++i], "%u,%u,%u,%u,%u,%u,%u", &currents.microamps[0], &currents.microamps[1],
+					&currents.microamps[2], &currents.microamps[3], &currents.txMicroamps, &currents.rxMicroamps,
+					&currents.millivolts) != 7)
+			{
+				fprintf(stderr, "-c takes seven numbers\n");
+				return 2;
+			}
+		}
+		else if((in = fopen(argv[i], "r")) == NULL)
+		{
+			perror(argv[i]);
+			return 2;
+		}
+	}
+
+	checks();
+	printf("model checks: %u failures\n", failures);
+	if(in == NULL)
+	{
+		return failures ? 1 : 0;
+	}
+
+	count = readRuns(in, &currents);
+	fclose(in);
+	qsort(runs, count, sizeof(runs[0]), byEnergy);
+
+	printf("\n%4s %4s %4s %5s %4s %8s %10s %6s %6s %8s %10s\n", "line", "phy", "mode", "data", "pdu", "interval",
+			"bit/s", "EM1 %", "radio%", "avg uA", "uJ/bit");
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const Run_t *run = &runs[i];
+		uint64_t ticks = 0;
+
+		for(uint32_t m = 0; m < ENERGY_MODES; m++)
+		{
+			ticks += run->residency.ticks[m];
+		}
+		printf("%4u %4s %4u %5u %4u %8u %10llu %6.1f %6.1f %8u %10.6f\n", run->line, phyName(run->phy), run->mode,
+				run->data, run->pdu, run->interval,
+				ticks ? (unsigned long long)((uint64_t)run->bits * ENERGY_TICKS_PER_SECOND / ticks) : 0ull,
+				ticks ? 100.0 * run->residency.ticks[ENERGY_EM1] / ticks : 0.0,
+				run->estimate.radioPermille / 10.0, run->estimate.averageMicroamps,
+				run->estimate.picojoulesPerBit / 1e6);
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host decoder for flash log images
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Prints the records of a raw image of the MX25 flash, as read back with
+ * Simplicity Commander or written by flashlog_sim, oldest first, followed by
+ * the state and erase count of every sector. Records failing the CRC are
+ * reported and skipped. The image is read the same way FLASHLOG_Init() and
+ * FLASHLOG_Walk() read the part, so a record listed here is one the firmware
+ * would return.
+ *
+ * Build:  gcc -O2 -Wall -o flashlog_dump tools/flashlog_dump.c
+ * Usage:  flashlog_dump <image.bin> [base] [sectors]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../flashlog.h"
+
+#define RTCC_TICKS_PER_SECOND 32768.0
+
+static const char *phyNames[] = { "?", "1M", "2M", "?", "S8", "?", "?", "?", "S2" };
+static const char *modeNames[] = { "notify", "indicate", "write" };
+static const char *milestoneNames[] = { "start", "found", "opened", "parameters", "mtu", "cccd notify",
+		"cccd indicate", "first data" };
+
+static uint8_t *image;
+static long imageSize;
+
+static uint32_t get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void printRecord(uint8_t type, uint32_t timestamp, const uint8_t *p, uint32_t len)
+{
+	printf("%12.3f ", timestamp / RTCC_TICKS_PER_SECOND);
+
+	if(type == FLASHLOG_TYPE_BOOT)
+	{
+		printf("boot\n");
+	}
+	else if(type == FLASHLOG_TYPE_RUN_START && len >= 8)
+	{
+		printf("run start phy %s mode %s data %u mtu %u interval %.2f ms\n",
+				p[0] < sizeof(phyNames) / sizeof(phyNames[0]) ? phyNames[p[0]] : "?",
+				p[1] < sizeof(modeNames) / sizeof(modeNames[0]) ? modeNames[p[1]] : "?",
+				get16(&p[2]), get16(&p[4]), get16(&p[6]) * 1.25);
+	}
+	else if(type == FLASHLOG_TYPE_THROUGHPUT && len >= 8)
+	{
+		printf("sample bits %u operations %u\n", get32(&p[0]), get32(&p[4]));
+	}
+	else if(type == FLASHLOG_TYPE_RUN_END && len >= 16)
+	{
+		printf("run end bits %u in %.3f s, %u bit/s, operations %u\n",
+				get32(&p[0]), get32(&p[4]) / RTCC_TICKS_PER_SECOND, get32(&p[8]), get32(&p[12]));
+	}
+	else if(type == FLASHLOG_TYPE_COEX && len >= 16)
+	{
+		printf("coex lp req %u hp req %u lp deny %u hp deny %u\n",
+				get32(&p[0]), get32(&p[4]), get32(&p[8]), get32(&p[12]));
+	}
+	else if(type == FLASHLOG_TYPE_EDGES)
+	{
+		printf("edges\n");
+		for(uint32_t i = 0; i + 8 <= len; i += 8)
+		{
+			printf("%12.6f   pin %u %s", get32(&p[i]) / RTCC_TICKS_PER_SECOND, p[i + 4], p[i + 5] ? "high" : "low");
+			if(get16(&p[i + 6]) != 0)
+			{
+				printf(", %u edges lost before", get16(&p[i + 6]));
+			}
+			printf("\n");
+		}
+	}
+	else if(type == FLASHLOG_TYPE_SETUP && len >= 8)
+	{
+		uint32_t reached = get16(&p[2]);
+
+		printf("setup cycle %u %s\n", get16(&p[0]), (reached & 0x80) ? "completed" : "abandoned");
+		for(uint32_t m = 1; m < sizeof(milestoneNames) / sizeof(milestoneNames[0]) && 8 + 4 * m + 4 <= len; m++)
+		{
+			if(reached & (1 << m))
+			{
+				printf("%12s   %-14s %9.1f ms\n", "", milestoneNames[m], get32(&p[8 + 4 * m]) * 1000 / RTCC_TICKS_PER_SECOND);
+			}
+		}
+	}
+	else if(type == FLASHLOG_TYPE_PHY_STEP && len >= 28)
+	{
+		uint32_t ticks = get32(&p[8]);
+
+		printf("phy step %s interval %.2f ms, %u bits in %.3f s, %.0f bit/s, invalid %u, denials lp %u hp %u",
+				p[0] < sizeof(phyNames) / sizeof(phyNames[0]) ? phyNames[p[0]] : "?", get16(&p[2]) * 1.25,
+				get32(&p[4]), ticks / RTCC_TICKS_PER_SECOND, ticks ? get32(&p[4]) * RTCC_TICKS_PER_SECOND / ticks : 0.0,
+				get32(&p[12]), get16(&p[16]), get16(&p[18]));
+		if(get16(&p[22]) != 0)
+		{
+			printf(", rssi %d..%d mean %.1f", (int8_t)p[20], (int8_t)p[21], (int32_t)get32(&p[24]) / (double)get16(&p[22]));
+		}
+		printf(", flags %#x\n", p[1]);
+	}
+	else if(type == FLASHLOG_TYPE_DTM_CELL && len >= 8)
+	{
+		static const char *dtmPhyNames[] = { "?", "1M", "2M", "S8", "S2" };
+
+		printf("dtm cell %u MHz %s length %u, %u of %u packets, flags %#x\n", 2402 + 2 * p[0],
+				p[1] < sizeof(dtmPhyNames) / sizeof(dtmPhyNames[0]) ? dtmPhyNames[p[1]] : "?", p[2], get16(&p[6]),
+				get16(&p[4]), p[3]);
+	}
+	else if(type == FLASHLOG_TYPE_CPU && len >= 16)
+	{
+		printf("cpu %.1f MHz, app %.1f%% stack %.1f%% spin %.1f%% sleep %.1f%%, needs about %.1f MHz\n",
+				get32(&p[0]) / 1e6, get16(&p[4]) / 10.0, get16(&p[6]) / 10.0, get16(&p[8]) / 10.0,
+				get16(&p[10]) / 10.0, get32(&p[12]) / 1e6);
+	}
+	else
+	{
+		printf("type %u:", type);
+		for(uint32_t i = 0; i < len; i++)
+		{
+			printf(" %02x", p[i]);
+		}
+		printf("\n");
+	}
+}
+
+/* Same rules as scanSector() in flashlog.c */
+static void dumpSector(const uint8_t *sector, uint32_t *records, uint32_t *corrupt)
+{
+	uint32_t offset = FLASHLOG_HEADER_SIZE;
+
+	while(offset + FLASHLOG_RECORD_HEADER <= FLASHLOG_SECTOR_SIZE)
+	{
+		const uint8_t *r = &sector[offset];
+		uint32_t len = r[0];
+		uint16_t crc;
+
+		if(len == 0xFF)
+		{
+			return;
+		}
+		if(len > FLASHLOG_MAX_PAYLOAD || offset + FLASHLOG_RECORD_HEADER + len > FLASHLOG_SECTOR_SIZE)
+		{
+			printf("%12s torn record at offset 0x%03x, rest of sector skipped\n", "", offset);
+			(*corrupt)++;
+			return;
+		}
+
+		crc = FLASHLOG_Crc16(0xFFFF, r, 2);
+		crc = FLASHLOG_Crc16(crc, &r[4], 4 + len);
+		if(crc != get16(&r[2]))
+		{
+			printf("%12s bad crc at offset 0x%03x\n", "", offset);
+			(*corrupt)++;
+		}
+		else
+		{
+			printRecord(r[1], get32(&r[4]), &r[FLASHLOG_RECORD_HEADER], len);
+			(*records)++;
+		}
+		offset += FLASHLOG_RECORD_HEADER + len;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t base = (argc > 2) ? strtoul(argv[2], NULL, 0) : FLASHLOG_BASE;
+	uint32_t sectors = (argc > 3) ? strtoul(argv[3], NULL, 0) : FLASHLOG_SECTORS;
+	uint32_t *order;
+	uint32_t live = 0;
+	uint32_t spare = 0;
+	uint32_t records = 0;
+	uint32_t corrupt = 0;
+	uint32_t minErases = UINT32_MAX;
+	uint32_t maxErases = 0;
+	FILE *f;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: %s <image.bin> [base] [sectors]\n", argv[0]);
+		return 2;
+	}
+
+	f = fopen(argv[1], "rb");
+	if(!f)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	imageSize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	image = malloc(imageSize);
+	if(!image || fread(image, 1, imageSize, f) != (size_t)imageSize)
+	{
+		fprintf(stderr, "%s: read failed\n", argv[1]);
+		return 1;
+	}
+	fclose(f);
+
+	if((uint64_t)base + (uint64_t)sectors * FLASHLOG_SECTOR_SIZE > (uint64_t)imageSize)
+	{
+		fprintf(stderr, "%s: image too small for %u sectors at 0x%x\n", argv[1], sectors, base);
+		return 1;
+	}
+
+	/* Live sectors, sorted by seq */
+	order = malloc(sectors * sizeof(uint32_t));
+	for(uint32_t s = 0; s < sectors; s++)
+	{
+		const uint8_t *h = &image[base + s * FLASHLOG_SECTOR_SIZE];
+		uint32_t seq = get32(&h[8]);
+		uint32_t i;
+
+		if(get32(&h[0]) != FLASHLOG_MAGIC)
+		{
+			continue;
+		}
+		if(get32(&h[4]) < minErases)
+		{
+			minErases = get32(&h[4]);
+		}
+		if(get32(&h[4]) > maxErases)
+		{
+			maxErases = get32(&h[4]);
+		}
+		if(seq == 0xFFFFFFFF && get32(&h[12]) == 0xFFFFFFFF)
+		{
+			spare++;
+			continue;
+		}
+		if(seq != ~get32(&h[12]))
+		{
+			continue;
+		}
+
+		for(i = live; i > 0 && get32(&image[base + order[i - 1] * FLASHLOG_SECTOR_SIZE + 8]) > seq; i--)
+		{
+			order[i] = order[i - 1];
+		}
+		order[i] = s;
+		live++;
+	}
+
+	for(uint32_t i = 0; i < live; i++)
+	{
+		dumpSector(&image[base + order[i] * FLASHLOG_SECTOR_SIZE], &records, &corrupt);
+	}
+
+	printf("\n%u records, %u corrupt\n", records, corrupt);
+	printf("%u sectors: %u live, %u spare, %u other\n", sectors, live, spare, sectors - live - spare);
+	if(live)
+	{
+		printf("oldest seq %u in sector %u, newest seq %u in sector %u\n",
+				get32(&image[base + order[0] * FLASHLOG_SECTOR_SIZE + 8]), order[0],
+				get32(&image[base + order[live - 1] * FLASHLOG_SECTOR_SIZE + 8]), order[live - 1]);
+	}
+	if(maxErases >= minErases)
+	{
+		printf("erase count %u..%u\n", minErases, maxErases);
+	}
+
+	free(order);
+	free(image);
+	return 0;
+}
@@ -0,0 +1,186 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host soak run of the flash log store against the MX25 model
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs flashlog.c and flasherase.c unchanged on top of mx25flash_spi.c built
+ * for the flash model, appending THROUGHPUT records at a fixed rate and
+ * cutting the power at random points. After every cut the store is recovered
+ * and walked; the run fails if a record that was reported written is missing
+ * or out of order, if the model saw a sequencing mistake or if a program
+ * went over bits that were not erased. The image can
+ * be kept in a file and read back with flashlog_dump.
+ *
+ * Build:  gcc -O2 -Wall -DMX25_HOST_MODEL -I. -Itools -Ihardware/kit/common/drivers \
+ *             -o flashlog_sim tools/flashlog_sim.c tools/mx25_model.c flashlog.c \
+ *             flasherase.c hardware/kit/common/drivers/mx25flash_spi.c \
+ *             hardware/kit/common/drivers/mx25flash_sfdp.c
+ * Usage:  flashlog_sim [records] [cuts] [image.bin]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx25flash_spi.h"
+#include "mx25_model.h"
+#include "flasherase.h"
+#include "flashlog.h"
+
+#define RECORD_INTERVAL_US	2000		// One record every 2 ms, far above the app's rate
+#define POLL_COST_US		20			// CPU time of one pass through the main loop
+
+static uint32_t lastWalked;
+static uint32_t walkErrors;
+static bool walkStarted;
+
+static void walker(uint8_t type, uint32_t timestamp, const uint8_t *payload, uint32_t len)
+{
+	FLASHLOG_Throughput_t record;
+
+	(void)timestamp;
+	if(type != FLASHLOG_TYPE_THROUGHPUT || len != sizeof(record))
+	{
+		return;
+	}
+	memcpy(&record, payload, sizeof(record));
+	if(walkStarted && record.operations <= lastWalked)
+	{
+		printf("order: %u after %u\n", record.operations, lastWalked);
+		walkErrors++;
+	}
+	walkStarted = true;
+	lastWalked = record.operations;
+}
+
+/* Written records are contiguous from the oldest surviving one to the newest */
+static uint32_t walk(uint32_t written)
+{
+	uint32_t count;
+
+	walkStarted = false;
+	lastWalked = 0;
+	count = FLASHLOG_Walk(walker);
+	if(written && (!walkStarted || lastWalked + 1 < written))
+	{
+		printf("lost: newest walked %u, %u were written\n", lastWalked, written);
+		walkErrors++;
+	}
+	return count;
+}
+
+static void boot(void)
+{
+	uint8_t id;
+
+	MX25_init();
+	MX25_RES(&id);
+	MX25_ReadFastConfigure();
+	if(!FLASHLOG_Init())
+	{
+		printf("FLASHLOG_Init failed\n");
+		exit(1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t records = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+	uint32_t cuts = (argc > 2) ? strtoul(argv[2], NULL, 0) : 20;
+	uint32_t sequence = 1;
+	uint32_t written = 0;					// Highest sequence number known to be in flash
+	uint64_t maxPoll = 0;
+	FLASHLOG_Stats_t stats;
+
+	srand(1);
+	MX25_MODEL_Reset();
+	if(argc > 3 && MX25_MODEL_Open(argv[3]) != 0)
+	{
+		perror(argv[3]);
+		return 1;
+	}
+	boot();
+	FLASHLOG_Format();
+
+	for(uint32_t cut = 0; cut <= cuts; cut++)
+	{
+		uint32_t batch = records / (cuts + 1);
+		uint64_t due = MX25_MODEL_Now();
+
+		/* Random cut point inside the batch */
+		if(cut < cuts)
+		{
+			batch = batch / 2 + (uint32_t)rand() % (batch / 2 + 1);
+		}
+
+		for(uint32_t i = 0; i < batch; )
+		{
+			uint64_t before = MX25_MODEL_Now();
+
+			if(MX25_MODEL_Now() >= due)
+			{
+				FLASHLOG_Throughput_t record = { sequence * 8, sequence };
+
+				if(FLASHLOG_Append(FLASHLOG_TYPE_THROUGHPUT, (uint32_t)(due * 32768 / 1000000), &record, sizeof(record)))
+				{
+					sequence++;
+				}
+				due += RECORD_INTERVAL_US;
+				i++;
+			}
+
+			FLASHLOG_Poll();
+			if(MX25_MODEL_Now() - before > maxPoll)
+			{
+				maxPoll = MX25_MODEL_Now() - before;
+			}
+			MX25_MODEL_Advance(POLL_COST_US);
+
+			/* Nothing staged, everything appended so far is in flash */
+			FLASHLOG_GetStats(&stats);
+			if(stats.staged == 0)
+			{
+				written = sequence - 1;
+			}
+		}
+
+		if(cut < cuts)
+		{
+			MX25_MODEL_PowerCut();
+			boot();
+			walk(written);
+		}
+	}
+
+	while(!FLASHLOG_Idle())
+	{
+		FLASHLOG_Poll();
+		MX25_MODEL_Advance(POLL_COST_US);
+	}
+	FLASHLOG_GetStats(&stats);
+	printf("records: %u appended, %u dropped, %u written, %u walked, %u corrupt\n",
+		stats.appended, stats.dropped, stats.written, walk(sequence - 1), stats.corrupt);
+	printf("sectors: %u live, %u recycled, erases per sector %u..%u\n",
+		stats.live, stats.recycled, stats.minErases, stats.maxErases);
+	printf("erases: %u, %u suspended, longest suspend %u polls\n",
+		FLASHERASE_Stats()->erases, FLASHERASE_Stats()->suspends, FLASHERASE_Stats()->maxSuspendPolls);
+	printf("longest FLASHLOG_Poll(): %llu us, %.1f s simulated, %u model violations, %u overprogrammed bytes\n",
+		(unsigned long long)maxPoll, MX25_MODEL_Now() / 1e6, MX25_MODEL_Violations(), MX25_MODEL_Overprograms());
+
+	MX25_MODEL_Close();
+	/* The store only ever programs erased space */
+	return (walkErrors || MX25_MODEL_Violations() || MX25_MODEL_Overprograms()) ? 1 : 0;
+}
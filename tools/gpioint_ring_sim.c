@@ -0,0 +1,228 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the GPIOINT edge ring under interrupt interleaving
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* A signal handler plays the GPIO interrupt: like the interrupt it runs on
+ * the same thread as the main loop and cuts in between any two of its
+ * instructions. An interval timer fires it every few tens of microseconds
+ * and it pushes one to three edges, as if that many flags were latched,
+ * numbered in the timestamp field. The main loop pops them, at times
+ * stalling long enough to fill the ring, and checks that every edge comes
+ * out whole and in order and that each gap in the numbering is exactly the
+ * dropped count of the edge after it. At the end, pushed edges must equal
+ * popped edges plus overflows. A short sequential check of the full and
+ * empty edges comes first.
+ *
+ * Build:  gcc -O2 -Wall -Iplatform/emdrv/gpiointerrupt/inc -o gpioint_ring_sim \
+ *             tools/gpioint_ring_sim.c platform/emdrv/gpiointerrupt/src/gpiointring.c
+ * Usage:  gpioint_ring_sim [seconds] [interrupt period us]
+ */
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "gpiointring.h"
+
+#define RING_SIZE	16
+
+static GPIOINT_Edge_t buf[RING_SIZE];
+static GPIOINT_Ring_t ring;
+static volatile uint32_t produced;			// Edges offered by the "interrupt"
+static volatile uint32_t interrupts;
+static uint32_t failures;
+
+static void fail(const char *what, uint32_t got, uint32_t expected)
+{
+	failures++;
+	printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+}
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		fail(what, got, expected);
+	}
+}
+
+/* intNo and level are derived from the number, so a torn edge shows */
+static void makeEdge(GPIOINT_Edge_t *edge, uint32_t number)
+{
+	edge->timestamp = number;
+	edge->intNo = (uint8_t)(number % 16);
+	edge->level = (uint8_t)((number >> 4) & 1);
+	edge->dropped = 0xA5A5;
+}
+
+static void sequential(void)
+{
+	GPIOINT_Edge_t edge;
+
+	GPIOINT_RingInit(&ring, buf, RING_SIZE);
+	expect("pop empty", GPIOINT_RingPop(&ring, &edge), false);
+	for(uint32_t i = 0; i < RING_SIZE; i++)
+	{
+		makeEdge(&edge, i);
+		expect("push", GPIOINT_RingPush(&ring, &edge), true);
+	}
+	makeEdge(&edge, RING_SIZE);
+	expect("push full", GPIOINT_RingPush(&ring, &edge), false);
+	expect("push full again", GPIOINT_RingPush(&ring, &edge), false);
+	expect("overflows", ring.overflows, 2);
+	expect("high water", ring.highWater, RING_SIZE);
+	expect("used", GPIOINT_RingUsed(&ring), RING_SIZE);
+
+	GPIOINT_RingPop(&ring, &edge);
+	expect("first out", edge.timestamp, 0);
+	expect("nothing dropped yet", edge.dropped, 0);
+	makeEdge(&edge, RING_SIZE + 2);
+	GPIOINT_RingPush(&ring, &edge);
+	for(uint32_t i = 1; i < RING_SIZE; i++)
+	{
+		GPIOINT_RingPop(&ring, &edge);
+		expect("order", edge.timestamp, i);
+	}
+	GPIOINT_RingPop(&ring, &edge);
+	expect("after the loss", edge.timestamp, RING_SIZE + 2);
+	expect("loss reported", edge.dropped, 2);
+	expect("drained", GPIOINT_RingPop(&ring, &edge), false);
+}
+
+static void interrupt(int signal)
+{
+	uint32_t flags = 1 + (interrupts++ % 3);
+
+	(void)signal;
+	for(uint32_t i = 0; i < flags; i++)
+	{
+		GPIOINT_Edge_t edge;
+
+		makeEdge(&edge, produced);
+		GPIOINT_RingPush(&ring, &edge);
+		produced++;
+	}
+}
+
+static uint64_t nowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static bool check(const GPIOINT_Edge_t *edge, uint32_t *next, uint32_t *dropped)
+{
+	GPIOINT_Edge_t whole;
+
+	makeEdge(&whole, edge->timestamp);
+	if(edge->intNo != whole.intNo || edge->level != whole.level)
+	{
+		fail("torn edge", edge->timestamp, *next);
+		return false;
+	}
+	if(edge->timestamp != *next + edge->dropped)
+	{
+		fail("gap not matching dropped", edge->timestamp - *next, edge->dropped);
+		return false;
+	}
+	*dropped += edge->dropped;
+	*next = edge->timestamp + 1;
+	return true;
+}
+
+static void interleaved(uint32_t seconds, uint32_t period)
+{
+	struct itimerval timer = { { 0, period }, { 0, period } };
+	struct sigaction action;
+	sigset_t block;
+	GPIOINT_Edge_t edge;
+	uint64_t end = nowUs() + (uint64_t)seconds * 1000000u;
+	uint32_t next = 0;
+	uint32_t popped = 0;
+	uint32_t dropped = 0;
+	uint32_t stalls = 0;
+	bool ok = true;
+
+	GPIOINT_RingInit(&ring, buf, RING_SIZE);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = interrupt;
+	sigaction(SIGALRM, &action, NULL);
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	while(ok && nowUs() < end)
+	{
+		/* Now and then the main loop is busy elsewhere */
+		if(rand() % 65536 == 0)
+		{
+			uint64_t until = nowUs() + (rand() % 2000);
+
+			stalls++;
+			while(nowUs() < until)
+			{
+			}
+		}
+		if(GPIOINT_RingPop(&ring, &edge))
+		{
+			popped++;
+			ok = check(&edge, &next, &dropped);
+		}
+	}
+
+	/* Mask the interrupt and drain what is left */
+	sigemptyset(&block);
+	sigaddset(&block, SIGALRM);
+	sigprocmask(SIG_BLOCK, &block, NULL);
+	timer.it_value.tv_usec = 0;
+	timer.it_interval.tv_usec = 0;
+	setitimer(ITIMER_REAL, &timer, NULL);
+	while(ok && GPIOINT_RingPop(&ring, &edge))
+	{
+		popped++;
+		ok = check(&edge, &next, &dropped);
+	}
+
+	printf("%u interrupts, %u edges, %u popped, %u overflows, high water %u, %u stalls\n", interrupts, produced,
+			popped, ring.overflows, ring.highWater, stalls);
+	if(ok)
+	{
+		expect("pushed = popped + overflows", produced, popped + ring.overflows);
+		expect("reported drops", dropped + ring.unreported, ring.overflows);
+		expect("last edge", next + ring.unreported, produced);
+	}
+	if(interrupts < 1000)
+	{
+		printf("only %u interrupts, the interleaving was not exercised\n", interrupts);
+		failures++;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t seconds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2;
+	uint32_t period = (argc > 2) ? strtoul(argv[2], NULL, 0) : 50;
+
+	sequential();
+	interleaved(seconds, period);
+	printf("ring checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
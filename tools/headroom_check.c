@@ -0,0 +1,256 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the CPU headroom arithmetic
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs headroom.c against a fake cycle counter and RTCC the way the main
+ * loop of main.c drives it: a busy sender, a sender held back by full
+ * buffers, a receiver that mostly sleeps, the cycle counter wrapping, a run
+ * stopped part way through a pass. Then random main loops against a model
+ * of the shares, to the permille.
+ *
+ * Build:  gcc -O2 -Wall -I. -o headroom_check tools/headroom_check.c headroom.c
+ * Usage:  headroom_check [random runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "headroom.h"
+
+#define CORE_HZ		38400000u
+
+static uint32_t failures;
+static uint32_t cycles;						// The fake DWT->CYCCNT
+static uint64_t ticks;						// The fake RTCC, in core cycles to keep it exact
+static HEADROOM_Report_t report;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void expectNear(const char *what, uint32_t got, uint32_t expected, uint32_t within)
+{
+	if(got + within < expected || got > expected + within)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static uint32_t rtcc(void)
+{
+	return (uint32_t)(ticks * HEADROOM_TICKS_PER_SECOND / CORE_HZ);
+}
+
+/* The core runs, both clocks move */
+static void run(uint32_t n)
+{
+	cycles += n;
+	ticks += n;
+}
+
+/* The core sleeps, only the RTCC moves */
+static void doze(uint32_t n)
+{
+	ticks += n;
+}
+
+static void start(void)
+{
+	HEADROOM_Start(cycles, rtcc(), CORE_HZ);
+}
+
+static void stop(void)
+{
+	HEADROOM_Stop(cycles, rtcc());
+	HEADROOM_Get(&report);
+}
+
+/* One pass of the main loop: app work, a stack call, app work again */
+static void pass(uint32_t app, uint32_t stack, uint32_t sleeping, uint32_t after, bool idle)
+{
+	run(app);
+	HEADROOM_Stack(cycles);
+	run(stack);
+	doze(sleeping);
+	HEADROOM_App(cycles);
+	run(after);
+	HEADROOM_Pass(cycles, idle);
+}
+
+static void scenarios(void)
+{
+	/* Nothing before a start, zeros while running */
+	HEADROOM_Pass(cycles, true);
+	start();
+	expect("running", HEADROOM_Running(), 1);
+	HEADROOM_Get(&report);
+	expect("running report", report.passes, 0);
+
+	/* A busy sender: 300 app, 700 stack a pass, no headroom */
+	for(uint32_t i = 0; i < 1000; i++)
+	{
+		pass(100, 700, 0, 200, false);
+	}
+	stop();
+	expect("running after", HEADROOM_Running(), 0);
+	expect("busy passes", report.passes, 1000);
+	expect("busy app", (uint32_t)report.cycles[HEADROOM_APP], 300000);
+	expect("busy stack", (uint32_t)report.cycles[HEADROOM_STACK], 700000);
+	expect("busy spin", (uint32_t)report.cycles[HEADROOM_SPIN], 0);
+	expectNear("busy sleep", (uint32_t)report.cycles[HEADROOM_SLEEP], 0, CORE_HZ / HEADROOM_TICKS_PER_SECOND + 1);
+	expect("busy app permille", report.permille[HEADROOM_APP], 300);
+	expect("busy headroom", report.headroomPermille, 0);
+	expectNear("busy needed", report.neededHz, CORE_HZ, CORE_HZ / 1000);
+
+	/* A sender held back by the link: three idle passes to each busy one */
+	start();
+	for(uint32_t i = 0; i < 1000; i++)
+	{
+		pass(100, 400, 0, 0, false);
+		pass(50, 150, 0, 0, true);
+		pass(50, 150, 0, 0, true);
+		pass(50, 150, 0, 0, true);
+	}
+	stop();
+	expect("spin passes", report.passes, 4000);
+	expect("spin idle passes", report.idlePasses, 3000);
+	expect("spin app", (uint32_t)report.cycles[HEADROOM_APP], 100000);
+	expect("spin stack", (uint32_t)report.cycles[HEADROOM_STACK], 400000);
+	expect("spin spin", (uint32_t)report.cycles[HEADROOM_SPIN], 600000);
+	expect("spin spin permille", report.permille[HEADROOM_SPIN], 545);
+	expectNear("spin headroom", report.headroomPermille, 545, 1);
+	expectNear("spin needed", report.neededHz, CORE_HZ / 11 * 5, CORE_HZ / 1000);
+
+	/* A receiver asleep in gecko_wait_event() nine tenths of the time */
+	start();
+	for(uint32_t i = 0; i < 1000; i++)
+	{
+		pass(1000, 2000, 36000, 1000, false);
+	}
+	stop();
+	expect("sleep app", (uint32_t)report.cycles[HEADROOM_APP], 2000000);
+	expect("sleep stack", (uint32_t)report.cycles[HEADROOM_STACK], 2000000);
+	expectNear("sleep sleep", (uint32_t)report.cycles[HEADROOM_SLEEP], 36000000, CORE_HZ / HEADROOM_TICKS_PER_SECOND + 1);
+	expect("sleep permille", report.permille[HEADROOM_SLEEP], 900);
+	expect("sleep headroom", report.headroomPermille, 900);
+	expectNear("sleep needed", report.neededHz, CORE_HZ / 10, CORE_HZ / 1000);
+	expectNear("sleep ticks", report.ticks, 40000000ull * HEADROOM_TICKS_PER_SECOND / CORE_HZ, 1);
+
+	/* The counter wrapping inside a stack call */
+	cycles = 0xFFFFFF00u;
+	start();
+	pass(0x80, 0x200, 0, 0x80, false);
+	stop();
+	expect("wrap stack", (uint32_t)report.cycles[HEADROOM_STACK], 0x200);
+	expect("wrap app", (uint32_t)report.cycles[HEADROOM_APP], 0x100);
+
+	/* Stopped inside a stack call, that pass is busy but not a pass */
+	start();
+	pass(100, 100, 0, 100, true);
+	run(50);
+	HEADROOM_Stack(cycles);
+	run(70);
+	stop();
+	expect("mid pass passes", report.passes, 1);
+	expect("mid pass spin", (uint32_t)report.cycles[HEADROOM_SPIN], 300);
+	expect("mid pass app", (uint32_t)report.cycles[HEADROOM_APP], 50);
+	expect("mid pass stack", (uint32_t)report.cycles[HEADROOM_STACK], 70);
+
+	/* Calls after the stop change nothing */
+	pass(100, 100, 0, 100, false);
+	HEADROOM_Stop(cycles, rtcc());
+	HEADROOM_Get(&report);
+	expect("after stop", (uint32_t)report.cycles[HEADROOM_STACK], 70);
+
+	/* An empty run */
+	start();
+	stop();
+	expect("empty passes", report.passes, 0);
+	expect("empty headroom", report.headroomPermille, 0);
+}
+
+static uint32_t permille(uint64_t part, uint64_t total)
+{
+	return (uint32_t)((part * 1000 + total / 2) / total);
+}
+
+static void randomRuns(uint32_t count)
+{
+	srand(5);
+	for(uint32_t r = 0; r < count; r++)
+	{
+		uint64_t model[HEADROOM_SHARES] = { 0 };
+		uint64_t total = 0;
+		/* Long enough for the RTCC to be fine grained, as a run is */
+		uint32_t passes = 1000 + rand() % 5000;
+
+		cycles = (uint32_t)rand() * 2654435761u;
+		start();
+		for(uint32_t p = 0; p < passes; p++)
+		{
+			uint32_t app = rand() % 500;
+			uint32_t stack = rand() % 3000;
+			uint32_t sleeping = (rand() % 4 == 0) ? (uint32_t)(rand() % 200000) : 0;
+			uint32_t after = rand() % 500;
+			bool idle = rand() % 3 == 0;
+
+			pass(app, stack, sleeping, after, idle);
+			if(idle)
+			{
+				model[HEADROOM_SPIN] += app + stack + after;
+			}
+			else
+			{
+				model[HEADROOM_APP] += app + after;
+				model[HEADROOM_STACK] += stack;
+			}
+			model[HEADROOM_SLEEP] += sleeping;
+		}
+		stop();
+		for(uint32_t s = 0; s < HEADROOM_SHARES; s++)
+		{
+			total += model[s];
+		}
+		expect("random passes", report.passes, passes);
+		expect("random app", (uint32_t)report.cycles[HEADROOM_APP], (uint32_t)model[HEADROOM_APP]);
+		expect("random stack", (uint32_t)report.cycles[HEADROOM_STACK], (uint32_t)model[HEADROOM_STACK]);
+		expect("random spin", (uint32_t)report.cycles[HEADROOM_SPIN], (uint32_t)model[HEADROOM_SPIN]);
+		/* Sleep comes from the RTCC, right to within a tick */
+		for(uint32_t s = 0; s < HEADROOM_SHARES; s++)
+		{
+			expectNear("random permille", report.permille[s], permille(model[s], total), 1);
+		}
+		expectNear("random headroom", report.headroomPermille,
+				permille(model[HEADROOM_SPIN] + model[HEADROOM_SLEEP], total), 1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+
+	scenarios();
+	randomRuns(count);
+	printf("headroom checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
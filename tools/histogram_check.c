@@ -0,0 +1,188 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the log2 histogram
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Checks the bucket edges of histogram.c, then feeds it random samples of
+ * several shapes and compares every percentile with the exact one from the
+ * sorted samples: the histogram's answer must be at least the exact value
+ * and in the same bucket. Given a file of numbers, one per line, as cut
+ * from a log, prints their histogram the way the "wake" console command
+ * does.
+ *
+ * Build:  gcc -O2 -Wall -I. -o histogram_check tools/histogram_check.c histogram.c
+ * Usage:  histogram_check [values.txt]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "histogram.h"
+
+#define SAMPLES		10000
+
+static uint32_t failures;
+static uint32_t samples[SAMPLES];
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static int ascending(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void edges(void)
+{
+	HISTOGRAM_t h;
+
+	expect("bucket 0", HISTOGRAM_Bucket(0), 0);
+	expect("bucket 1", HISTOGRAM_Bucket(1), 0);
+	expect("bucket 2", HISTOGRAM_Bucket(2), 1);
+	expect("bucket 3", HISTOGRAM_Bucket(3), 1);
+	expect("bucket 4", HISTOGRAM_Bucket(4), 2);
+	expect("bucket 2^31-1", HISTOGRAM_Bucket(0x7FFFFFFFu), 30);
+	expect("bucket max", HISTOGRAM_Bucket(UINT32_MAX), 31);
+	for(uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+	{
+		expect("low edge", HISTOGRAM_Bucket(HISTOGRAM_BucketLow(b)), b);
+		expect("high edge", HISTOGRAM_Bucket(HISTOGRAM_BucketHigh(b)), b);
+		if(b > 0)
+		{
+			expect("contiguous", HISTOGRAM_BucketLow(b), HISTOGRAM_BucketHigh(b - 1) + 1);
+		}
+	}
+
+	HISTOGRAM_Reset(&h);
+	expect("empty percentile", HISTOGRAM_Percentile(&h, 500), 0);
+	expect("empty mean", HISTOGRAM_Mean(&h), 0);
+	for(uint32_t v = 1; v <= 100; v++)
+	{
+		HISTOGRAM_Add(&h, v);
+	}
+	expect("count", h.count, 100);
+	expect("min", h.min, 1);
+	expect("max", h.max, 100);
+	expect("mean", HISTOGRAM_Mean(&h), 50);
+	expect("p0", HISTOGRAM_Percentile(&h, 0), 1);
+	expect("p50", HISTOGRAM_Percentile(&h, 500), 63);
+	expect("p100", HISTOGRAM_Percentile(&h, 1000), 100);
+}
+
+/* shape 0 uniform, 1 log uniform, 2 a few values, 3 one large outlier */
+static void shapes(void)
+{
+	static const uint32_t permilles[] = { 0, 1, 10, 100, 500, 900, 990, 999, 1000 };
+
+	for(uint32_t shape = 0; shape < 4; shape++)
+	{
+		HISTOGRAM_t h;
+
+		HISTOGRAM_Reset(&h);
+		for(uint32_t i = 0; i < SAMPLES; i++)
+		{
+			switch(shape)
+			{
+				case 0:
+					samples[i] = random32() % 1000000;
+					break;
+				case 1:
+					samples[i] = random32() >> (random32() % 32);
+					break;
+				case 2:
+					samples[i] = 30 << (random32() % 4);
+					break;
+				default:
+					samples[i] = (i == SAMPLES / 2) ? 3000000 : 400 + random32() % 50;
+					break;
+			}
+			HISTOGRAM_Add(&h, samples[i]);
+		}
+		qsort(samples, SAMPLES, sizeof(samples[0]), ascending);
+
+		for(uint32_t p = 0; p < sizeof(permilles) / sizeof(permilles[0]); p++)
+		{
+			uint64_t rank = ((uint64_t)SAMPLES * permilles[p] + 999) / 1000;
+			uint32_t exact = samples[rank ? rank - 1 : 0];
+			uint32_t got = HISTOGRAM_Percentile(&h, permilles[p]);
+
+			if(got < exact || HISTOGRAM_Bucket(got) != HISTOGRAM_Bucket(exact))
+			{
+				failures++;
+				printf("FAIL: shape %u p%u.%u, %u for exact %u\n", shape, permilles[p] / 10, permilles[p] % 10,
+						got, exact);
+			}
+		}
+		expect("shape max", HISTOGRAM_Percentile(&h, 1000), samples[SAMPLES - 1]);
+	}
+}
+
+static void print(const HISTOGRAM_t *h)
+{
+	printf("count %u min %u mean %u p50 %u p99 %u max %u\n", h->count, h->count ? h->min : 0, HISTOGRAM_Mean(h),
+			HISTOGRAM_Percentile(h, 500), HISTOGRAM_Percentile(h, 990), h->max);
+	for(uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+	{
+		if(h->buckets[b] != 0)
+		{
+			printf("%10u..%-10u %u\n", HISTOGRAM_BucketLow(b), HISTOGRAM_BucketHigh(b), h->buckets[b]);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	edges();
+	shapes();
+	printf("histogram checks: %u failures\n", failures);
+
+	if(argc > 1)
+	{
+		FILE *in = fopen(argv[1], "r");
+		HISTOGRAM_t h;
+		unsigned long value;
+
+		if(in == NULL)
+		{
+			perror(argv[1]);
+			return 2;
+		}
+		HISTOGRAM_Reset(&h);
+		while(fscanf(in, "%lu", &value) == 1)
+		{
+			HISTOGRAM_Add(&h, (uint32_t)value);
+		}
+		fclose(in);
+		printf("\n");
+		print(&h);
+	}
+
+	return failures ? 1 : 0;
+}
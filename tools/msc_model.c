@@ -0,0 +1,257 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the series 1 MSC and its flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Lets archive.c run unchanged on a PC.
+ *
+ * Build:  gcc -O2 -Wall -DARCHIVE_HOST_MODEL -I. -Itools -o archivecheck \
+ *             archivecheck.c archive.c tools/msc_model.c
+ *
+ * where archivecheck.c is any host program calling ARCHIVE_*.
+ * MSC_MODEL_Violations() must stay 0 for correct use of the flash.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "msc_model.h"
+
+#define WORDS			(MSC_MODEL_SIZE / 4)
+#define PAGES			(MSC_MODEL_SIZE / MSC_MODEL_PAGE_SIZE)
+#define PAGE_WORDS		(MSC_MODEL_PAGE_SIZE / 4)
+
+static uint32_t flash[WORDS];
+static uint8_t writes[WORDS];			// Writes since the last erase of the word
+static uint32_t erases[PAGES];
+static uint64_t now;
+static uint32_t words;
+static uint32_t maxIrqOff;
+static uint32_t violations;
+
+static bool cutArmed;
+static uint32_t cutCountdown;
+static bool powered = true;
+static bool wasCut;
+
+static void violation(const char *what, const uint32_t *address)
+{
+	violations++;
+	if(violations <= 10)
+	{
+		fprintf(stderr, "msc model: %s at offset 0x%05lx\n", what, (unsigned long)((address - flash) * 4));
+	}
+}
+
+/* True if this operation is the one the power cut lands in */
+static bool cutNow(void)
+{
+	if(cutArmed && cutCountdown-- == 0)
+	{
+		cutArmed = false;
+		powered = false;
+		wasCut = true;
+		return true;
+	}
+	return false;
+}
+
+static MSC_Status_TypeDef checkRange(const uint32_t *address, uint32_t numBytes)
+{
+	if(((uintptr_t)address & 3) || (numBytes & 3))
+	{
+		violation("unaligned write", address);
+		return mscReturnUnaligned;
+	}
+	if(address < flash || address + numBytes / 4 > flash + WORDS)
+	{
+		violation("write outside the flash", address);
+		return mscReturnInvalidAddr;
+	}
+	return mscReturnOk;
+}
+
+static MSC_Status_TypeDef write(uint32_t *address, void const *data, uint32_t numBytes, uint32_t wordTime)
+{
+	MSC_Status_TypeDef status = checkRange(address, numBytes);
+	const uint8_t *bytes = data;
+
+	if(status != mscReturnOk)
+	{
+		return status;
+	}
+
+	for(uint32_t i = 0; i < numBytes / 4; i++)
+	{
+		uint32_t index = (uint32_t)(address - flash) + i;
+		uint32_t value;
+
+		if(!powered)
+		{
+			return mscReturnTimeOut;
+		}
+		memcpy(&value, &bytes[i * 4], 4);
+		if(cutNow())
+		{
+			/* Some of the bits got there */
+			flash[index] &= value | (uint32_t)rand();
+			return mscReturnTimeOut;
+		}
+
+		if(~flash[index] & value)
+		{
+			violation("write sets bits back to 1", &flash[index]);
+		}
+		if(++writes[index] > MSC_MODEL_WRITES_PER_WORD)
+		{
+			violation("word written too often between erases", &flash[index]);
+		}
+		flash[index] &= value;
+		words++;
+		now += wordTime;
+	}
+	return mscReturnOk;
+}
+
+void MSC_Init(void)
+{
+}
+
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address, void const *data, uint32_t numBytes)
+{
+	return write(address, data, numBytes, MSC_MODEL_T_WORD);
+}
+
+MSC_Status_TypeDef MSC_WriteWordFast(uint32_t *address, void const *data, uint32_t numBytes)
+{
+	uint64_t start = now;
+	MSC_Status_TypeDef status = write(address, data, numBytes, MSC_MODEL_T_WORD_FAST);
+
+	if(now - start > maxIrqOff)
+	{
+		maxIrqOff = (uint32_t)(now - start);
+	}
+	return status;
+}
+
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress)
+{
+	uint32_t index = (uint32_t)(startAddress - flash);
+	uint32_t page = index / PAGE_WORDS;
+
+	if(startAddress < flash || index >= WORDS)
+	{
+		violation("erase outside the flash", startAddress);
+		return mscReturnInvalidAddr;
+	}
+	if(((uintptr_t)startAddress & 3) || (index % PAGE_WORDS))
+	{
+		violation("unaligned erase", startAddress);
+		return mscReturnUnaligned;
+	}
+	if(!powered)
+	{
+		return mscReturnTimeOut;
+	}
+	if(cutNow())
+	{
+		for(uint32_t i = 0; i < PAGE_WORDS; i++)
+		{
+			flash[index + i] |= (uint32_t)rand();
+		}
+		return mscReturnTimeOut;
+	}
+
+	if(++erases[page] > MSC_MODEL_ENDURANCE)
+	{
+		violation("page erased past its endurance", startAddress);
+	}
+	memset(&flash[index], 0xFF, MSC_MODEL_PAGE_SIZE);
+	memset(&writes[index], 0, PAGE_WORDS);
+	now += MSC_MODEL_T_ERASE;
+	return mscReturnOk;
+}
+
+/**************************************************************************//**
+* @brief Erased flash, counters and clock cleared
+*****************************************************************************/
+void MSC_MODEL_Reset(void)
+{
+	memset(flash, 0xFF, sizeof(flash));
+	memset(writes, 0, sizeof(writes));
+	memset(erases, 0, sizeof(erases));
+	now = 0;
+	words = 0;
+	maxIrqOff = 0;
+	violations = 0;
+	cutArmed = false;
+	powered = true;
+	wasCut = false;
+}
+
+/**************************************************************************//**
+* @brief Cut the power in the word write or page erase after the given
+* number of them. Everything after it fails until MSC_MODEL_PowerUp()
+*****************************************************************************/
+void MSC_MODEL_CutAfter(uint32_t operations)
+{
+	cutArmed = true;
+	cutCountdown = operations;
+}
+
+/**************************************************************************//**
+* @brief Power back on, the flash keeps what it had
+* @return true if a cut happened since the last call
+*****************************************************************************/
+bool MSC_MODEL_PowerUp(void)
+{
+	bool cut = wasCut;
+
+	cutArmed = false;
+	powered = true;
+	wasCut = false;
+	return cut;
+}
+
+uint32_t *MSC_MODEL_Base(void)
+{
+	return flash;
+}
+
+uint64_t MSC_MODEL_Now(void)
+{
+	return now;
+}
+
+uint32_t MSC_MODEL_Words(void)
+{
+	return words;
+}
+
+uint32_t MSC_MODEL_Erases(uint32_t page)
+{
+	return page < PAGES ? erases[page] : 0;
+}
+
+uint32_t MSC_MODEL_MaxIrqOff(void)
+{
+	return maxIrqOff;
+}
+
+uint32_t MSC_MODEL_Violations(void)
+{
+	return violations;
+}
@@ -0,0 +1,82 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the series 1 MSC and its flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef MSC_MODEL_H_
+#define MSC_MODEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* archive.c built with -DARCHIVE_HOST_MODEL calls these instead of em_msc.c.
+ * The model holds MSC_MODEL_SIZE bytes of internal flash and applies the
+ * rules of the part: word aligned writes of whole words, writes only clear
+ * bits, at most MSC_MODEL_WRITES_PER_WORD writes to a word between erases,
+ * erases of whole aligned pages. Breaking a rule is counted as a violation.
+ *
+ * Time is virtual, in microseconds. MSC_WriteWordFast() keeps interrupts
+ * off for the whole call, and the longest such stretch is recorded, since
+ * that is what a burst costs the radio. MSC_MODEL_CutAfter() cuts the power
+ * part way through a later write or erase. */
+
+#define MSC_MODEL_PAGE_SIZE		2048
+#ifndef MSC_MODEL_SIZE
+#define MSC_MODEL_SIZE			(8 * MSC_MODEL_PAGE_SIZE)	// Same as __archive_size
+#endif
+#define MSC_MODEL_WRITES_PER_WORD	2
+
+/* Busy times in microseconds, around the EFR32xG13 datasheet typicals */
+#ifndef MSC_MODEL_T_WORD
+#define MSC_MODEL_T_WORD		20			// MSC_WriteWord(), one word at a time
+#endif
+#ifndef MSC_MODEL_T_WORD_FAST
+#define MSC_MODEL_T_WORD_FAST	11			// MSC_WriteWordFast(), no wait between words
+#endif
+#ifndef MSC_MODEL_T_ERASE
+#define MSC_MODEL_T_ERASE		26000
+#endif
+
+/* Rated erase cycles per page, erasing past it is a violation */
+#ifndef MSC_MODEL_ENDURANCE
+#define MSC_MODEL_ENDURANCE		10000
+#endif
+
+/* Same values as em_msc.h */
+typedef enum {
+	mscReturnOk          =  0,
+	mscReturnInvalidAddr = -1,
+	mscReturnLocked      = -2,
+	mscReturnTimeOut     = -3,
+	mscReturnUnaligned   = -4
+} MSC_Status_TypeDef;
+
+void MSC_Init(void);
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address, void const *data, uint32_t numBytes);
+MSC_Status_TypeDef MSC_WriteWordFast(uint32_t *address, void const *data, uint32_t numBytes);
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress);
+
+void     MSC_MODEL_Reset(void);
+void     MSC_MODEL_CutAfter(uint32_t operations);
+bool     MSC_MODEL_PowerUp(void);
+
+uint32_t *MSC_MODEL_Base(void);
+uint64_t MSC_MODEL_Now(void);
+uint32_t MSC_MODEL_Words(void);
+uint32_t MSC_MODEL_Erases(uint32_t page);
+uint32_t MSC_MODEL_MaxIrqOff(void);
+uint32_t MSC_MODEL_Violations(void);
+
+#endif
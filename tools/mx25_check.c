@@ -0,0 +1,136 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the MX25 command sequencing on the flash model
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs MX25_READ, MX25_FASTREAD and MX25_PP, asynchronous and blocking,
+ * through mx25flash_spi.c built for the flash model. Every transfer has to
+ * read back what was programmed, every callback has to come once and only
+ * from MX25_AsyncPoll(), a second transfer has to be refused while one is
+ * running, and the model must not have seen a single sequencing mistake.
+ *
+ * Build:  gcc -O2 -Wall -DMX25_HOST_MODEL -Itools -Ihardware/kit/common/drivers \
+ *             -o mx25_check tools/mx25_check.c tools/mx25_model.c \
+ *             hardware/kit/common/drivers/mx25flash_spi.c \
+ *             hardware/kit/common/drivers/mx25flash_sfdp.c
+ * Usage:  mx25_check
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mx25flash_spi.h"
+#include "mx25_model.h"
+
+#define LENGTH		300				// Crosses a page boundary
+
+static uint32_t failures;
+static uint32_t callbacks;
+static ReturnMsg lastStatus;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+static void done(ReturnMsg status, void *user)
+{
+	(void)user;
+
+	callbacks++;
+	lastStatus = status;
+}
+
+/* Polls the running transfer to its end, its callback is due once */
+static void finish(const char *what)
+{
+	char text[64];
+
+	callbacks = 0;
+	while(MX25_AsyncPoll());
+	snprintf(text, sizeof(text), "%s callbacks", what);
+	expect(text, callbacks, 1);
+	snprintf(text, sizeof(text), "%s status", what);
+	expect(text, lastStatus, FlashOperationSuccess);
+}
+
+static void fill(uint8_t *data, uint32_t length, uint8_t seed)
+{
+	for(uint32_t i = 0; i < length; i++)
+	{
+		data[i] = (uint8_t)(seed + i * 7);
+	}
+}
+
+int main(void)
+{
+	static uint8_t page[Page_Offset];
+	static uint8_t data[2 * Page_Offset];
+	static uint8_t out[LENGTH];
+
+	MX25_MODEL_Reset();
+	MX25_init();
+
+	/* Asynchronous program, nothing is reported before the poll */
+	fill(page, Page_Offset, 1);
+	callbacks = 0;
+	expect("PP async start", MX25_PP_Async(0, page, Page_Offset, done, NULL), FlashOperationSuccess);
+	expect("PP async early callback", callbacks, 0);
+	expect("PP async refuses a second", MX25_READ_Async(0, out, 1, done, NULL), FlashIsBusy);
+	finish("PP async");
+
+	/* Blocking program of the next page */
+	fill(page, Page_Offset, 2);
+	expect("PP", MX25_PP(Page_Offset, page, Page_Offset), FlashOperationSuccess);
+	fill(data, Page_Offset, 1);
+	fill(&data[Page_Offset], Page_Offset, 2);
+
+	/* Reads across the page boundary, both ways, both instructions */
+	memset(out, 0, sizeof(out));
+	expect("READ async start", MX25_READ_Async(100, out, LENGTH, done, NULL), FlashOperationSuccess);
+	finish("READ async");
+	expect("READ async data", memcmp(out, &data[100], LENGTH), 0);
+
+	memset(out, 0, sizeof(out));
+	expect("FASTREAD async start", MX25_FASTREAD_Async(100, out, LENGTH, done, NULL), FlashOperationSuccess);
+	finish("FASTREAD async");
+	expect("FASTREAD async data", memcmp(out, &data[100], LENGTH), 0);
+
+	memset(out, 0, sizeof(out));
+	expect("READ", MX25_READ(100, out, LENGTH), FlashOperationSuccess);
+	expect("READ data", memcmp(out, &data[100], LENGTH), 0);
+
+	memset(out, 0, sizeof(out));
+	expect("FASTREAD", MX25_FASTREAD(100, out, LENGTH), FlashOperationSuccess);
+	expect("FASTREAD data", memcmp(out, &data[100], LENGTH), 0);
+
+	/* What went over the bus */
+	expect("idle after", MX25_AsyncPoll(), false);
+	expect("PP commands", MX25_MODEL_Commands(FLASH_CMD_PP), 2);
+	expect("WREN commands", MX25_MODEL_Commands(FLASH_CMD_WREN), 2);
+	expect("READ commands", MX25_MODEL_Commands(FLASH_CMD_READ), 2);
+	expect("FASTREAD commands", MX25_MODEL_Commands(FLASH_CMD_FASTREAD), 2);
+	expect("array", memcmp(MX25_MODEL_Memory(), data, sizeof(data)), 0);
+	expect("violations", MX25_MODEL_Violations(), 0);
+
+	printf("mx25 checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
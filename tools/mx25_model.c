@@ -0,0 +1,646 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the MX25 SPI NOR flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Lets the MX25 driver run unchanged on a PC, so command sequencing and the
+ * async read/program paths can be exercised without a board.
+ *
+ * Build:  gcc -O2 -Wall -DMX25_HOST_MODEL -Ihardware/kit/common/drivers -Itools \
+ *             -o flashcheck flashcheck.c hardware/kit/common/drivers/mx25flash_spi.c \
+ *             tools/mx25_model.c
+ *
+ * where flashcheck.c is any host program calling MX25_init() and the MX25_*
+ * commands. MX25_MODEL_Violations() must stay 0 for a correct sequence.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mx25flash_spi.h"
+#include "mx25_model.h"
+
+#define BYTE_NS ((8 * 1000000000ULL) / MX25_MODEL_SPI_HZ)
+
+typedef enum {
+	OP_NONE,
+	OP_PROGRAM,
+	OP_ERASE
+} Op_Kind_t;
+
+/* A program or erase the array has not seen yet */
+typedef struct {
+	Op_Kind_t kind;
+	uint32_t base;
+	uint32_t size;
+	uint64_t duration;					// ns
+	uint64_t end;						// ns, while running
+	uint64_t remaining;					// ns, while suspended
+	uint64_t suspendedAt;				// ns, while suspended
+	uint8_t data[Page_Offset];			// Page buffer of a program
+	bool loaded[Page_Offset];
+} Op_t;
+
+static uint8_t ramImage[FlashSize];
+static uint8_t *memory = ramImage;
+static int imageFd = -1;
+
+static bool selected;
+static uint32_t clocked;				// Bytes clocked since chip select went low
+static uint8_t cmd;						// Instruction of the current command
+static uint32_t address;
+static bool wel;						// Write enable latch
+static Op_t active;						// Running program or erase
+static Op_t suspended;					// Program or erase parked by PGM_ERS_S
+static Op_t loading;					// Page program being clocked in
+static uint64_t now;					// Virtual time, ns
+
+static uint32_t commands[256];
+static uint32_t bytes;
+static uint32_t violations;
+static uint32_t overprograms;
+static uint32_t sectorErases[FlashSize / Sector_Offset];
+
+/* SFDP space of the MX25R8035F: JESD216 header, a 9 DWORD basic flash
+ * parameter table at 0x30 and the Macronix table at 0x60 */
+static const uint8_t mx25r8035fSfdp[] = {
+	0x53, 0x46, 0x44, 0x50, 0x00, 0x01, 0x01, 0xFF,		// "SFDP" rev 1.0, 2 parameter headers
+	0x00, 0x00, 0x01, 0x09, 0x30, 0x00, 0x00, 0xFF,		// BFPT rev 1.0, 9 DWORDs at 0x30
+	0xC2, 0x00, 0x01, 0x04, 0x60, 0x00, 0x00, 0xFF,		// Macronix table, 4 DWORDs at 0x60
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xE5, 0x20, 0xF1, 0xFF,								// 4K erase 20h, 1-1-2, 1-2-2, 1-4-4, 1-1-4, 3 byte address
+	0xFF, 0xFF, 0x7F, 0x00,								// 8 Mbit
+	0x44, 0xEB, 0x08, 0x6B,								// 4READ EBh 4+2 clocks, QREAD 6Bh 8 clocks
+	0x08, 0x3B, 0x04, 0xBB,								// DREAD 3Bh 8 clocks, 2READ BBh 4 clocks
+	0xEE, 0xFF, 0xFF, 0xFF,								// No 2-2-2 or 4-4-4
+	0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF,
+	0x0C, 0x20, 0x0F, 0x52,								// 4 KB 20h, 32 KB 52h
+	0x10, 0xD8, 0x00, 0xFF,								// 64 KB D8h
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF,
+	0x00, 0x36, 0x50, 0x16,								// Vcc 3.6 V max, 1.65 V min
+	0x9D, 0xF9, 0xC0, 0x64,								// Reset, suspend/resume, DP, 4 byte address
+	0xD9, 0xC8, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF
+};
+static const uint8_t *sfdp = mx25r8035fSfdp;
+static uint32_t sfdpLength = sizeof(mx25r8035fSfdp);
+
+static void powerUp(void)
+{
+	static bool once;
+
+	if(!once)
+	{
+		once = true;
+		memset(ramImage, 0xFF, sizeof(ramImage));
+	}
+}
+
+static void violation(const char *what)
+{
+	violations++;
+	fprintf(stderr, "mx25_model: %s (cmd 0x%02X at %llu us)\n", what, cmd, (unsigned long long)(now / 1000));
+}
+
+/* Let the array see the first done/total of an operation */
+static void apply(const Op_t *op, uint64_t done, uint64_t total)
+{
+	if(op->kind == OP_PROGRAM)
+	{
+		uint32_t count = 0;
+		uint32_t limit;
+
+		for(uint32_t i = 0; i < Page_Offset; i++)
+		{
+			count += op->loaded[i];
+		}
+		limit = (uint32_t)((count * done) / total);
+		count = 0;
+		for(uint32_t i = 0; i < Page_Offset && count < limit; i++)
+		{
+			if(op->loaded[i])
+			{
+				/* NOR program can only clear bits */
+				memory[op->base + i] &= op->data[i];
+				count++;
+			}
+		}
+	}
+	else if(op->kind == OP_ERASE)
+	{
+		memset(&memory[op->base], 0xFF, (size_t)((op->size * done) / total));
+	}
+}
+
+/* Finish the running operation once its time is up */
+static void settle(void)
+{
+	if(active.kind != OP_NONE && now >= active.end)
+	{
+		apply(&active, 1, 1);
+		active.kind = OP_NONE;
+	}
+}
+
+static bool busy(void)
+{
+	settle();
+	return active.kind != OP_NONE
+		|| (suspended.kind != OP_NONE && now < suspended.suspendedAt + MX25_MODEL_T_SUSPEND * 1000ULL);
+}
+
+static bool inSuspended(uint32_t start, uint32_t len)
+{
+	return suspended.kind != OP_NONE
+		&& start < suspended.base + suspended.size
+		&& suspended.base < start + len;
+}
+
+static bool isErase(uint8_t instruction)
+{
+	return instruction == FLASH_CMD_SE || instruction == FLASH_CMD_BE32K || instruction == FLASH_CMD_BE
+		|| instruction == FLASH_CMD_CE || instruction == 0xC7;
+}
+
+/* Instructions the part accepts while WIP is set */
+static bool allowedWhileBusy(uint8_t instruction)
+{
+	return instruction == FLASH_CMD_RDSR
+		|| instruction == FLASH_CMD_RDSCUR
+		|| instruction == FLASH_CMD_PGM_ERS_S;
+}
+
+/* Instructions the part rejects while an operation is suspended */
+static bool refusedWhileSuspended(uint8_t instruction)
+{
+	return isErase(instruction)
+		|| instruction == FLASH_CMD_WRSR
+		|| instruction == FLASH_CMD_PGM_ERS_S
+		|| (instruction == FLASH_CMD_PP && suspended.kind == OP_PROGRAM);
+}
+
+static void start(Op_Kind_t kind, uint32_t base, uint32_t size, uint32_t us)
+{
+	if(kind == OP_PROGRAM)
+	{
+		active = loading;
+	}
+	active.kind = kind;
+	active.base = base;
+	active.size = size;
+	active.duration = us * 1000ULL;
+	active.end = now + active.duration;
+	wel = false;
+
+	if(kind == OP_ERASE)
+	{
+		for(uint32_t sector = base / Sector_Offset; sector < (base + size) / Sector_Offset; sector++)
+		{
+			if(++sectorErases[sector] == MX25_MODEL_ENDURANCE + 1)
+			{
+				violation("sector erased past the rated endurance");
+			}
+		}
+	}
+}
+
+static void erase(uint32_t size, uint32_t us)
+{
+	uint32_t base = address & ~(size - 1) & (FlashSize - 1);
+
+	if(clocked != 4)
+	{
+		violation("erase without a complete address");
+		return;
+	}
+	start(OP_ERASE, base, size, us);
+}
+
+/* Commit the command when chip select goes high */
+static void complete(void)
+{
+	if(clocked == 0)
+	{
+		return;
+	}
+
+	switch(cmd)
+	{
+	case FLASH_CMD_WREN:
+		wel = true;
+		return;
+	case FLASH_CMD_WRDI:
+		wel = false;
+		return;
+	case FLASH_CMD_PGM_ERS_S:
+		if(active.kind != OP_NONE && suspended.kind == OP_NONE)
+		{
+			suspended = active;
+			suspended.remaining = active.end - now;
+			suspended.suspendedAt = now;
+			active.kind = OP_NONE;
+		}
+		return;
+	case FLASH_CMD_PGM_ERS_R:
+		if(suspended.kind != OP_NONE && active.kind == OP_NONE)
+		{
+			active = suspended;
+			active.end = now + suspended.remaining;
+			suspended.kind = OP_NONE;
+		}
+		return;
+	default:
+		break;
+	}
+
+	/* Everything below needs the latch and an idle part; both were already
+	 * reported when the instruction byte arrived */
+	if(!wel || active.kind != OP_NONE)
+	{
+		return;
+	}
+
+	switch(cmd)
+	{
+	case FLASH_CMD_PP:
+	{
+		uint32_t base = address & ~(Page_Offset - 1) & (FlashSize - 1);
+		if(clocked < 5)
+		{
+			violation("page program without data");
+			return;
+		}
+		if(inSuspended(base, Page_Offset))
+		{
+			violation("page program into the suspended region");
+			return;
+		}
+		for(uint32_t i = 0; i < Page_Offset; i++)
+		{
+			/* A 1 over a programmed 0 needs an erase first, the part just ignores it */
+			if(loading.loaded[i] && (loading.data[i] & ~memory[base + i]))
+			{
+				overprograms++;
+			}
+		}
+		start(OP_PROGRAM, base, Page_Offset, MX25_MODEL_T_PP);
+		break;
+	}
+	case FLASH_CMD_SE:
+		erase(Sector_Offset, MX25_MODEL_T_SE);
+		break;
+	case FLASH_CMD_BE32K:
+		erase(Block32K_Offset, MX25_MODEL_T_BE32K);
+		break;
+	case FLASH_CMD_BE:
+		erase(Block_Offset, MX25_MODEL_T_BE);
+		break;
+	case FLASH_CMD_CE:
+	case 0xC7:
+		start(OP_ERASE, 0, FlashSize, MX25_MODEL_T_CE);
+		break;
+	default:
+		break;
+	}
+}
+
+/**************************************************************************//**
+* @brief Clean power cycle: finish pending work and clear state and counters
+*****************************************************************************/
+void MX25_MODEL_Reset(void)
+{
+	powerUp();
+	if(active.kind != OP_NONE)
+	{
+		apply(&active, 1, 1);
+	}
+	if(suspended.kind != OP_NONE)
+	{
+		apply(&suspended, 1, 1);
+	}
+	active.kind = OP_NONE;
+	suspended.kind = OP_NONE;
+	memset(commands, 0, sizeof(commands));
+	selected = false;
+	clocked = 0;
+	wel = false;
+	bytes = 0;
+	violations = 0;
+	overprograms = 0;
+}
+
+/**************************************************************************//**
+* @brief Back the array with an image file, created erased if missing
+* @return 0 on success, -1 with errno set otherwise
+*****************************************************************************/
+int MX25_MODEL_Open(const char *path)
+{
+	struct stat st;
+	uint8_t blank[4096];
+	void *map;
+	int fd;
+
+	MX25_MODEL_Close();
+
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(fd < 0 || fstat(fd, &st) != 0)
+	{
+		return -1;
+	}
+
+	/* Grow a new or short image with erased bytes */
+	memset(blank, 0xFF, sizeof(blank));
+	while(st.st_size < FlashSize)
+	{
+		size_t n = FlashSize - st.st_size;
+		ssize_t written;
+
+		if(n > sizeof(blank))
+		{
+			n = sizeof(blank);
+		}
+		written = pwrite(fd, blank, n, st.st_size);
+		if(written <= 0)
+		{
+			close(fd);
+			return -1;
+		}
+		st.st_size += written;
+	}
+
+	map = mmap(NULL, FlashSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		close(fd);
+		return -1;
+	}
+	imageFd = fd;
+	memory = map;
+	return 0;
+}
+
+/**************************************************************************//**
+* @brief Write the image back and return to the RAM array
+*****************************************************************************/
+void MX25_MODEL_Close(void)
+{
+	if(imageFd < 0)
+	{
+		return;
+	}
+	msync(memory, FlashSize, MS_SYNC);
+	munmap(memory, FlashSize);
+	close(imageFd);
+	imageFd = -1;
+	memory = ramImage;
+}
+
+/**************************************************************************//**
+* @brief Drop power now. A running or suspended program or erase is left
+* partly done, in proportion to the time it had
+*****************************************************************************/
+void MX25_MODEL_PowerCut(void)
+{
+	settle();
+	if(active.kind != OP_NONE)
+	{
+		apply(&active, active.duration - (active.end - now), active.duration);
+	}
+	if(suspended.kind != OP_NONE)
+	{
+		apply(&suspended, suspended.duration - suspended.remaining, suspended.duration);
+	}
+	active.kind = OP_NONE;
+	suspended.kind = OP_NONE;
+	selected = false;
+	clocked = 0;
+	wel = false;
+}
+
+/**************************************************************************//**
+* @brief Chip select, true for low (selected)
+*****************************************************************************/
+void MX25_MODEL_Select(bool low)
+{
+	powerUp();
+	if(low == selected)
+	{
+		return;
+	}
+	if(!low)
+	{
+		complete();
+	}
+	selected = low;
+	clocked = 0;
+}
+
+/**************************************************************************//**
+* @brief Clock one byte in on MOSI and return the byte driven on MISO
+*****************************************************************************/
+uint8_t MX25_MODEL_Transfer(uint8_t mosi)
+{
+	uint32_t n;
+
+	powerUp();
+	n = clocked++;
+	bytes++;
+	now += BYTE_NS;
+	if(!selected)
+	{
+		violation("clock with chip select high");
+		return 0xFF;
+	}
+
+	if(n == 0)
+	{
+		bool wip = busy();
+
+		cmd = mosi;
+		commands[cmd]++;
+		address = 0;
+		if(wip && !allowedWhileBusy(cmd))
+		{
+			violation("command while WIP is set");
+		}
+		else if(suspended.kind != OP_NONE && refusedWhileSuspended(cmd))
+		{
+			violation("command not allowed while suspended");
+		}
+		if(cmd == FLASH_CMD_PP)
+		{
+			if(!wel)
+			{
+				violation("page program without WREN");
+			}
+			memset(loading.loaded, 0, sizeof(loading.loaded));
+		}
+		if(isErase(cmd) && !wel)
+		{
+			violation("erase without WREN");
+		}
+		return 0xFF;
+	}
+
+	switch(cmd)
+	{
+	case FLASH_CMD_RDSR:
+		return (wel ? 0x02 : 0) | (busy() ? FLASH_WIP_MASK : 0);
+	case FLASH_CMD_RDSCUR:
+		if(suspended.kind == OP_ERASE)
+		{
+			return MX25_MODEL_SCUR_ESB;
+		}
+		return (suspended.kind == OP_PROGRAM) ? MX25_MODEL_SCUR_PSB : 0x00;
+	case FLASH_CMD_RDCR:
+		return 0x00;
+	case FLASH_CMD_RDID:
+		return (uint8_t)(FlashID >> (8 * (3 - n)));
+	case FLASH_CMD_READ:
+	case FLASH_CMD_FASTREAD:
+	case FLASH_CMD_RDSFDP:
+	{
+		uint32_t data = (cmd == FLASH_CMD_READ) ? 4 : 5;	// FASTREAD has one dummy byte
+		if(n < 4)
+		{
+			address = (address << 8) | mosi;
+			if(n == 3 && cmd != FLASH_CMD_RDSFDP && inSuspended(address & (FlashSize - 1), 1))
+			{
+				violation("read from the suspended region");
+			}
+			return 0xFF;
+		}
+		if(n < data)
+		{
+			return 0xFF;
+		}
+		if(cmd == FLASH_CMD_RDSFDP)
+		{
+			return (address + (n - data) < sfdpLength) ? sfdp[address + (n - data)] : 0xFF;
+		}
+		return memory[(address + (n - data)) & (FlashSize - 1)];
+	}
+	case FLASH_CMD_PP:
+		if(n < 4)
+		{
+			address = (address << 8) | mosi;
+			return 0xFF;
+		}
+		{
+			/* Data wraps around within the page, the last write to a byte wins */
+			uint32_t offset = (address + (n - 4)) & (Page_Offset - 1);
+			loading.data[offset] = mosi;
+			loading.loaded[offset] = true;
+		}
+		return 0xFF;
+	case FLASH_CMD_SE:
+	case FLASH_CMD_BE32K:
+	case FLASH_CMD_BE:
+		if(n < 4)
+		{
+			address = (address << 8) | mosi;
+		}
+		return 0xFF;
+	default:
+		return 0xFF;
+	}
+}
+
+/**************************************************************************//**
+* @brief Answer RDSFDP from a captured table instead of the MX25R8035F one
+* @param table SFDP space from address 0, kept by reference; NULL restores
+* the built in table
+*****************************************************************************/
+void MX25_MODEL_SetSfdp(const uint8_t *table, uint32_t length)
+{
+	sfdp = table ? table : mx25r8035fSfdp;
+	sfdpLength = table ? length : sizeof(mx25r8035fSfdp);
+}
+
+/**************************************************************************//**
+* @brief Let time pass outside of the SPI bus
+*****************************************************************************/
+void MX25_MODEL_Advance(uint32_t us)
+{
+	now += us * 1000ULL;
+	settle();
+}
+
+/**************************************************************************//**
+* @brief Virtual time in microseconds
+*****************************************************************************/
+uint64_t MX25_MODEL_Now(void)
+{
+	return now / 1000;
+}
+
+/**************************************************************************//**
+* @brief The flash array, FlashSize bytes
+*****************************************************************************/
+uint8_t *MX25_MODEL_Memory(void)
+{
+	powerUp();
+	return memory;
+}
+
+/**************************************************************************//**
+* @brief Number of times an instruction has been issued
+*****************************************************************************/
+uint32_t MX25_MODEL_Commands(uint8_t instruction)
+{
+	return commands[instruction];
+}
+
+/**************************************************************************//**
+* @brief Total bytes clocked on the bus
+*****************************************************************************/
+uint32_t MX25_MODEL_Bytes(void)
+{
+	return bytes;
+}
+
+/**************************************************************************//**
+* @brief Bytes programmed with a 1 over a bit that was already 0. Harmless on
+* the part, but the written data is not what the caller meant
+*****************************************************************************/
+uint32_t MX25_MODEL_Overprograms(void)
+{
+	return overprograms;
+}
+
+/**************************************************************************//**
+* @brief Erase cycles seen by the sector holding address, since the process
+* started; the image file does not keep them
+*****************************************************************************/
+uint32_t MX25_MODEL_SectorErases(uint32_t address)
+{
+	return sectorErases[(address & (FlashSize - 1)) / Sector_Offset];
+}
+
+/**************************************************************************//**
+* @brief Number of sequencing errors seen
+*****************************************************************************/
+uint32_t MX25_MODEL_Violations(void)
+{
+	return violations;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the MX25 SPI NOR flash
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef MX25_MODEL_H_
+#define MX25_MODEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* mx25flash_spi.c built with -DMX25_HOST_MODEL drives chip select and the
+ * SPI byte transfer through these functions instead of GPIO and USART. The
+ * model decodes the same command bytes the part would, keeps the array in
+ * RAM or in an mmap'd image file with NOR semantics (program only clears
+ * bits, erase sets them) and counts sequencing mistakes such as a page
+ * program without WREN or a command other than RDSR while WIP is set.
+ *
+ * Time is virtual: every byte on the bus costs one byte time at
+ * MX25_MODEL_SPI_HZ and the host adds the time its own code would take with
+ * MX25_MODEL_Advance(). Program and erase keep WIP set for the typical
+ * MX25R8035F durations below and only change the array when they finish. */
+
+#ifndef MX25_MODEL_SPI_HZ
+#define MX25_MODEL_SPI_HZ     8000000
+#endif
+
+/* Typical busy times in microseconds */
+#ifndef MX25_MODEL_T_PP
+#define MX25_MODEL_T_PP       850
+#endif
+#ifndef MX25_MODEL_T_SE
+#define MX25_MODEL_T_SE       40000
+#endif
+#ifndef MX25_MODEL_T_BE32K
+#define MX25_MODEL_T_BE32K    200000
+#endif
+#ifndef MX25_MODEL_T_BE
+#define MX25_MODEL_T_BE       400000
+#endif
+#ifndef MX25_MODEL_T_CE
+#define MX25_MODEL_T_CE       5000000
+#endif
+/* Suspend latency, WIP stays set this long after PGM_ERS_S */
+#ifndef MX25_MODEL_T_SUSPEND
+#define MX25_MODEL_T_SUSPEND  20
+#endif
+
+/* Rated erase cycles per sector, erasing past it is a violation */
+#ifndef MX25_MODEL_ENDURANCE
+#define MX25_MODEL_ENDURANCE  100000
+#endif
+
+/* Security register bits reported while suspended */
+#define MX25_MODEL_SCUR_PSB   0x04
+#define MX25_MODEL_SCUR_ESB   0x08
+
+void     MX25_MODEL_Reset(void);
+int      MX25_MODEL_Open(const char *path);
+void     MX25_MODEL_Close(void);
+void     MX25_MODEL_PowerCut(void);
+void     MX25_MODEL_SetSfdp(const uint8_t *table, uint32_t length);
+
+void     MX25_MODEL_Select(bool low);
+uint8_t  MX25_MODEL_Transfer(uint8_t mosi);
+
+void     MX25_MODEL_Advance(uint32_t us);
+uint64_t MX25_MODEL_Now(void);
+
+uint8_t  *MX25_MODEL_Memory(void);
+uint32_t MX25_MODEL_Commands(uint8_t cmd);
+uint32_t MX25_MODEL_Bytes(void);
+uint32_t MX25_MODEL_Violations(void);
+uint32_t MX25_MODEL_Overprograms(void);
+uint32_t MX25_MODEL_SectorErases(uint32_t address);
+
+#endif
@@ -0,0 +1,132 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the MX25 SFDP parser and read mode selection
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Decodes SFDP blobs captured from parts (RDSFDP from address 0, e.g. with
+ * flashrom or a logic analyzer) and prints what mx25flash_sfdp.c makes of
+ * them: the basic parameters, every read instruction and the one
+ * MX25_ReadFast() would use for 1, 2 and 4 data lines. Every blob is then
+ * served by the flash model to MX25_ReadFastConfigure(), the same code the
+ * firmware runs at boot. Without arguments the model's own MX25R8035F
+ * table is used. Exits non zero if a blob does not parse.
+ *
+ * Build:  gcc -O2 -Wall -DMX25_HOST_MODEL -Itools -Ihardware/kit/common/drivers \
+ *             -o mx25_sfdp tools/mx25_sfdp.c tools/mx25_model.c \
+ *             hardware/kit/common/drivers/mx25flash_spi.c \
+ *             hardware/kit/common/drivers/mx25flash_sfdp.c
+ * Usage:  mx25_sfdp [sfdp.bin ...]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx25flash_spi.h"
+#include "mx25flash_sfdp.h"
+#include "mx25_model.h"
+
+/* fR of the MX25R8035F, as in the driver */
+#define READ_MAX_HZ 33000000
+
+static bool check(const char *name, const uint8_t *blob, uint32_t length)
+{
+	static const uint8_t lines[] = { 1, 2, 4 };
+	MX25_SFDP_Info_t info;
+	ReturnMsg status;
+
+	printf("%s: %u bytes\n", name, length);
+	if(!MX25_SFDP_Parse(blob, length, &info))
+	{
+		printf("  no valid SFDP header or basic flash parameter table\n");
+		return false;
+	}
+
+	printf("  BFPT %u.%u, %u DWORDs, %u bytes, %u byte pages, address bytes %u\n",
+			info.major, info.minor, info.dwords, info.sizeBytes, info.pageSize, info.addressBytes);
+	for(int i = 0; i < 4; i++)
+	{
+		if(info.erase[i].size)
+		{
+			printf("  erase %6u bytes %02Xh\n", info.erase[i].size, info.erase[i].opcode);
+		}
+	}
+	for(int mode = 0; mode < MX25_SFDP_READ_MODES; mode++)
+	{
+		const MX25_SFDP_Read_t *read = &info.read[mode];
+
+		if(read->supported)
+		{
+			printf("  %-15s %02Xh  %u mode + %u wait clocks, %u clocks per page\n",
+					MX25_SFDP_ReadName((MX25_SFDP_ReadMode_t)mode), read->opcode, read->modeClocks,
+					read->waitStates, MX25_SFDP_ReadClocks(&info, (MX25_SFDP_ReadMode_t)mode, info.pageSize));
+		}
+	}
+	for(unsigned i = 0; i < sizeof(lines); i++)
+	{
+		printf("  %u line%s at %u Hz: %s\n", lines[i], lines[i] > 1 ? "s" : "", MX25_MODEL_SPI_HZ,
+				MX25_SFDP_ReadName(MX25_SFDP_SelectRead(&info, lines[i], MX25_MODEL_SPI_HZ, READ_MAX_HZ)));
+	}
+
+	/* The driver's boot path, against the model */
+	MX25_MODEL_SetSfdp(blob, length);
+	MX25_init();
+	status = MX25_ReadFastConfigure();
+	printf("  MX25_ReadFastConfigure: %s, %s, %u bytes/s\n",
+			status == FlashOperationSuccess ? "ok" : "no SFDP",
+			MX25_SFDP_ReadName((MX25_SFDP_ReadMode_t)MX25_ReadFastMode()), MX25_ReadFastRate());
+	MX25_MODEL_SetSfdp(NULL, 0);
+
+	return status == FlashOperationSuccess;
+}
+
+int main(int argc, char *argv[])
+{
+	int failed = 0;
+
+	MX25_MODEL_Reset();
+
+	if(argc < 2)
+	{
+		uint8_t blob[MX25_SFDP_SIZE];
+
+		MX25_init();
+		MX25_RDSFDP(0, blob, sizeof(blob));
+		return check("model MX25R8035F", blob, sizeof(blob)) ? 0 : 1;
+	}
+
+	for(int i = 1; i < argc; i++)
+	{
+		static uint8_t blob[65536];
+		FILE *f = fopen(argv[i], "rb");
+		size_t length;
+
+		if(!f)
+		{
+			perror(argv[i]);
+			failed++;
+			continue;
+		}
+		length = fread(blob, 1, sizeof(blob), f);
+		fclose(f);
+		if(!check(argv[i], blob, (uint32_t)length))
+		{
+			failed++;
+		}
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,294 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stress run and benchmark of the MX25 driver on the flash model
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Issues a random mix of MX25_READ, MX25_ReadFast, MX25_PP, MX25_SE,
+ * MX25_BE32K and suspended erases through mx25flash_spi.c built for the
+ * flash model, and checks every read against a plain array that applies
+ * the NOR rules on its own: programs AND into the array and wrap inside
+ * the page, erases set whole sectors or blocks. Any difference, or any
+ * sequencing mistake the model reports, fails the run.
+ *
+ * The run also works as a benchmark. Host time shows how fast code built
+ * on the driver can be exercised; virtual time shows what each operation
+ * would cost on the part at MX25_MODEL_SPI_HZ.
+ *
+ * Build:  gcc -O2 -Wall -DMX25_HOST_MODEL -Itools -Ihardware/kit/common/drivers \
+ *             -o mx25_stress tools/mx25_stress.c tools/mx25_model.c \
+ *             hardware/kit/common/drivers/mx25flash_spi.c \
+ *             hardware/kit/common/drivers/mx25flash_sfdp.c
+ * Usage:  mx25_stress [operations] [seed] [image.bin]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx25flash_spi.h"
+#include "mx25_model.h"
+
+typedef enum {
+	OP_READ,
+	OP_READ_FAST,
+	OP_PROGRAM,
+	OP_ERASE_SECTOR,
+	OP_ERASE_BLOCK,
+	OP_ERASE_SUSPENDED,
+	OP_COUNT
+} Op_t;
+
+static const char *opNames[OP_COUNT] = {
+	"READ", "ReadFast", "PP", "SE", "BE32K", "SE + suspend"
+};
+
+/* Percent of the mix, erases kept rare like in real use */
+static const uint32_t opWeights[OP_COUNT] = { 35, 15, 38, 6, 1, 5 };
+
+static uint8_t reference[FlashSize];
+static uint32_t opCount[OP_COUNT];
+static uint64_t opMicros[OP_COUNT];		// Virtual time
+static uint64_t opBytes[OP_COUNT];
+static uint32_t mismatches;
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void referenceProgram(uint32_t address, const uint8_t *data, uint32_t len)
+{
+	uint32_t page = address & ~(Page_Offset - 1);
+	uint8_t buffer[Page_Offset];
+	bool loaded[Page_Offset] = { false };
+
+	/* Only the last 256 bytes count, wrapping to the start of the page */
+	for(uint32_t i = 0; i < len; i++)
+	{
+		uint32_t offset = (address + i) & (Page_Offset - 1);
+		buffer[offset] = data[i];
+		loaded[offset] = true;
+	}
+	for(uint32_t i = 0; i < Page_Offset; i++)
+	{
+		if(loaded[i])
+		{
+			reference[page + i] &= buffer[i];
+		}
+	}
+}
+
+static void referenceErase(uint32_t address, uint32_t size)
+{
+	memset(&reference[address & ~(size - 1)], 0xFF, size);
+}
+
+static void compare(const char *what, uint32_t address, const uint8_t *data, uint32_t len)
+{
+	for(uint32_t i = 0; i < len; i++)
+	{
+		if(data[i] != reference[address + i])
+		{
+			if(mismatches++ < 10)
+			{
+				printf("%s at 0x%06X: read %02X, expected %02X\n", what, address + i, data[i], reference[address + i]);
+			}
+			return;
+		}
+	}
+}
+
+static void waitReady(void)
+{
+	uint8_t status;
+
+	do
+	{
+		MX25_RDSR(&status);
+	} while(status & FLASH_WIP_MASK);
+}
+
+/* Erase a sector, reading and programming elsewhere while it is suspended */
+static void suspendedErase(uint32_t sector)
+{
+	uint8_t data[Page_Offset];
+	uint32_t other;
+	uint32_t len = 1 + random32() % Page_Offset;
+
+	do
+	{
+		other = random32() % (FlashSize - Page_Offset);
+	} while((other & ~(Sector_Offset - 1)) == sector || ((other + Page_Offset - 1) & ~(Sector_Offset - 1)) == sector);
+
+	MX25_SE_Start(sector);
+	MX25_MODEL_Advance(random32() % MX25_MODEL_T_SE);
+	MX25_PGM_ERS_S();
+	waitReady();
+
+	MX25_READ(other, data, Page_Offset);
+	compare("read while suspended", other, data, Page_Offset);
+
+	for(uint32_t i = 0; i < len; i++)
+	{
+		data[i] = (uint8_t)random32();
+	}
+	MX25_PP(other, data, len);
+	referenceProgram(other, data, len);
+
+	MX25_PGM_ERS_R();
+	waitReady();
+	referenceErase(sector, Sector_Offset);
+}
+
+static Op_t pick(void)
+{
+	uint32_t r = random32() % 100;
+
+	for(int op = 0; op < OP_COUNT; op++)
+	{
+		if(r < opWeights[op])
+		{
+			return (Op_t)op;
+		}
+		r -= opWeights[op];
+	}
+	return OP_READ;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t operations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+	uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+	uint8_t data[Page_Offset];
+	struct timespec begin, end;
+	uint32_t maxErases = 0;
+	uint64_t moved = 0;
+	double seconds;
+
+	srand(seed);
+	MX25_MODEL_Reset();
+	if(argc > 3 && MX25_MODEL_Open(argv[3]) != 0)
+	{
+		perror(argv[3]);
+		return 1;
+	}
+	memcpy(reference, MX25_MODEL_Memory(), FlashSize);
+
+	MX25_init();
+	MX25_ReadFastConfigure();
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for(uint32_t n = 0; n < operations && mismatches == 0; n++)
+	{
+		Op_t op = pick();
+		uint32_t address = random32() % FlashSize;
+		uint32_t len = 1 + random32() % Page_Offset;
+		uint64_t before = MX25_MODEL_Now();
+
+		switch(op)
+		{
+		case OP_READ:
+		case OP_READ_FAST:
+			if(address + len > FlashSize)
+			{
+				len = FlashSize - address;
+			}
+			if(op == OP_READ)
+			{
+				MX25_READ(address, data, len);
+			}
+			else
+			{
+				MX25_ReadFast(address, data, len);
+			}
+			compare(opNames[op], address, data, len);
+			break;
+		case OP_PROGRAM:
+			for(uint32_t i = 0; i < len; i++)
+			{
+				uint8_t old = reference[(address & ~(Page_Offset - 1)) + ((address + i) & (Page_Offset - 1))];
+
+				/* Mostly leave programmed bits alone, like real data going into
+				 * erased space; the rest try to set bits back to 1 */
+				data[i] = (uint8_t)((random32() % 8) ? (random32() | ~old) : random32());
+			}
+			MX25_PP(address, data, len);
+			referenceProgram(address, data, len);
+			break;
+		case OP_ERASE_SECTOR:
+			len = Sector_Offset;
+			MX25_SE(address);
+			referenceErase(address, Sector_Offset);
+			break;
+		case OP_ERASE_BLOCK:
+			len = Block32K_Offset;
+			MX25_BE32K(address);
+			referenceErase(address, Block32K_Offset);
+			break;
+		case OP_ERASE_SUSPENDED:
+			len = Sector_Offset;
+			suspendedErase(address & ~(Sector_Offset - 1));
+			break;
+		default:
+			break;
+		}
+
+		opCount[op]++;
+		opBytes[op] += len;
+		opMicros[op] += MX25_MODEL_Now() - before;
+		moved += len;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+	/* Whole array, in case a write landed somewhere it should not have */
+	for(uint32_t address = 0; address < FlashSize && mismatches == 0; address += Sector_Offset)
+	{
+		uint8_t sector[Sector_Offset];
+
+		MX25_READ(address, sector, Sector_Offset);
+		compare("final check", address, sector, Sector_Offset);
+	}
+	for(uint32_t address = 0; address < FlashSize; address += Sector_Offset)
+	{
+		if(MX25_MODEL_SectorErases(address) > maxErases)
+		{
+			maxErases = MX25_MODEL_SectorErases(address);
+		}
+	}
+
+	printf("%-14s %8s %12s %12s\n", "operation", "count", "avg us", "part KB/s");
+	for(int op = 0; op < OP_COUNT; op++)
+	{
+		if(opCount[op])
+		{
+			printf("%-14s %8u %12.1f %12.1f\n", opNames[op], opCount[op],
+					(double)opMicros[op] / opCount[op],
+					opMicros[op] ? opBytes[op] * 1e6 / 1024.0 / opMicros[op] : 0.0);
+		}
+	}
+	printf("host: %.2f s, %.0f operations/s, %.1f MB/s through the driver\n",
+			seconds, operations / seconds, moved / seconds / 1e6);
+	printf("part: %.1f s of flash time, %.0fx faster than real time\n",
+			MX25_MODEL_Now() / 1e6, (MX25_MODEL_Now() / 1e6) / seconds);
+	printf("%u bus bytes, %u overprogrammed bytes, most erases on one sector %u\n",
+			MX25_MODEL_Bytes(), MX25_MODEL_Overprograms(), maxErases);
+	printf("%u mismatches, %u model violations\n", mismatches, MX25_MODEL_Violations());
+
+	MX25_MODEL_Close();
+	return (mismatches || MX25_MODEL_Violations()) ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the payload AES-CTR mode
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* First runs the software backend's self test and checks its AES-CTR against
+ * the CTR-AES128 vectors of NIST SP 800-38A F.5.1 and F.5.2 a block at a
+ * time, whose counter also carries into the third byte of the 32 bit block
+ * counter. Then runs ramps of every
+ * payload length through PAYLOADCRYPT_Encrypt() and _Decrypt() the way the
+ * firmware does, and checks that
+ *   - the ramp comes back after the sequence number,
+ *   - the ciphertext of two streams, or two packets, never matches,
+ *   - a lost and a repeated packet are counted as gaps.
+ * The time per byte printed is host time and only says the model is usable,
+ * the board's figure comes from the "crypto" console command.
+ *
+ * Build:  gcc -O2 -Wall -DCRYPTOBACKEND_SOFTWARE_ONLY -I. -o payloadcrypt_kat \
+ *             tools/payloadcrypt_kat.c payloadcrypt.c cryptobackend.c cryptobackend_sw.c
+ * Usage:  payloadcrypt_kat [packets]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cryptobackend.h"
+#include "payloadcrypt.h"
+
+#define DATA_SIZE		255
+
+static const uint8_t nistKey[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t nistCounter[16] = {
+	0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+static const uint8_t nistPlain[64] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+static const uint8_t nistCipher[64] = {
+	0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+	0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+	0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+	0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+};
+
+static uint32_t failures;
+
+static void fail(const char *what, uint32_t n)
+{
+	if(failures++ < 10)
+	{
+		printf("FAIL: %s (%u)\n", what, n);
+	}
+}
+
+/* F.5.1 encrypts, F.5.2 decrypts, in one call and one block per call */
+static void vectors(void)
+{
+	uint8_t counter[16];
+	uint8_t out[64];
+
+	if(CRYPTOBACKEND_SelfTest(&CRYPTOBACKEND_Software) != 0)
+	{
+		fail("software backend self test", 0);
+	}
+
+	memcpy(counter, nistCounter, sizeof(counter));
+	CRYPTOBACKEND_Software.aesCtr128(out, nistPlain, sizeof(out), nistKey, counter);
+	if(memcmp(out, nistCipher, sizeof(out)) != 0)
+	{
+		fail("F.5.1 CTR-AES128.Encrypt", 0);
+	}
+	if(counter[15] != 0x03 || counter[14] != 0xff)
+	{
+		fail("counter after F.5.1", counter[15]);
+	}
+
+	memcpy(counter, nistCounter, sizeof(counter));
+	for(uint32_t i = 0; i < sizeof(out); i += 16)
+	{
+		CRYPTOBACKEND_Software.aesCtr128(&out[i], &nistCipher[i], 16, nistKey, counter);
+	}
+	if(memcmp(out, nistPlain, sizeof(out)) != 0)
+	{
+		fail("F.5.2 CTR-AES128.Decrypt", 0);
+	}
+}
+
+static void ramp(uint8_t *data, uint16_t len, uint8_t first)
+{
+	for(uint16_t i = 0; i < len; i++)
+	{
+		data[i] = first + i;
+	}
+}
+
+static bool rampValid(const uint8_t *data, uint16_t len)
+{
+	for(uint16_t i = PAYLOADCRYPT_HEADER_SIZE + 1; i < len; i++)
+	{
+		if(data[i] != (uint8_t)(data[i - 1] + 1))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t packets = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+	uint8_t plain[DATA_SIZE];
+	uint8_t sent[DATA_SIZE];
+	uint8_t other[DATA_SIZE];
+	PAYLOADCRYPT_Stats_t tx;
+	PAYLOADCRYPT_Stats_t rx;
+
+	vectors();
+	printf("SP 800-38A F.5.1/F.5.2 %s\n", failures ? "failed" : "passed");
+
+	/* Every length, each stream, compared with the other streams */
+	PAYLOADCRYPT_Init();
+	for(uint16_t len = PAYLOADCRYPT_HEADER_SIZE + 1; len <= DATA_SIZE; len++)
+	{
+		ramp(plain, len, (uint8_t)len);
+		for(uint8_t stream = PAYLOADCRYPT_STREAM_NOTIFY; stream <= PAYLOADCRYPT_STREAM_WRITE; stream++)
+		{
+			PAYLOADCRYPT_Encrypt(stream, sent, plain, len);
+			if(stream != PAYLOADCRYPT_STREAM_NOTIFY
+					&& memcmp(sent + PAYLOADCRYPT_HEADER_SIZE, other + PAYLOADCRYPT_HEADER_SIZE, len - PAYLOADCRYPT_HEADER_SIZE) == 0)
+			{
+				fail("same ciphertext on two streams", len);
+			}
+			memcpy(other, sent, len);
+			if(len >= PAYLOADCRYPT_HEADER_SIZE + 8 && rampValid(sent, len))
+			{
+				fail("ciphertext still a ramp", len);
+			}
+			PAYLOADCRYPT_Decrypt(stream, sent, len);
+			if(!rampValid(sent, len) || memcmp(sent + PAYLOADCRYPT_HEADER_SIZE, plain + PAYLOADCRYPT_HEADER_SIZE, len - PAYLOADCRYPT_HEADER_SIZE) != 0)
+			{
+				fail("round trip", len);
+			}
+		}
+	}
+	PAYLOADCRYPT_GetStats(&tx, &rx);
+	if(rx.gaps != 0)
+	{
+		fail("gaps in an unbroken stream", rx.gaps);
+	}
+
+	/* Same plaintext twice must not give the same ciphertext */
+	ramp(plain, DATA_SIZE, 0);
+	PAYLOADCRYPT_Start();
+	PAYLOADCRYPT_Encrypt(PAYLOADCRYPT_STREAM_NOTIFY, sent, plain, DATA_SIZE);
+	PAYLOADCRYPT_Encrypt(PAYLOADCRYPT_STREAM_NOTIFY, other, plain, DATA_SIZE);
+	if(memcmp(sent + PAYLOADCRYPT_HEADER_SIZE, other + PAYLOADCRYPT_HEADER_SIZE, DATA_SIZE - PAYLOADCRYPT_HEADER_SIZE) == 0)
+	{
+		fail("key stream reused", 0);
+	}
+
+	/* Packet 1 lost, packet 2 repeated: two gaps, both still decrypt */
+	PAYLOADCRYPT_Start();
+	for(uint32_t i = 0; i < 3; i++)
+	{
+		PAYLOADCRYPT_Encrypt(PAYLOADCRYPT_STREAM_WRITE, sent, plain, DATA_SIZE);
+		if(i == 1)
+		{
+			continue;
+		}
+		memcpy(other, sent, DATA_SIZE);
+		PAYLOADCRYPT_Decrypt(PAYLOADCRYPT_STREAM_WRITE, sent, DATA_SIZE);
+		if(i == 2)
+		{
+			PAYLOADCRYPT_Decrypt(PAYLOADCRYPT_STREAM_WRITE, other, DATA_SIZE);
+			if(!rampValid(other, DATA_SIZE))
+			{
+				fail("repeated packet", i);
+			}
+		}
+		if(!rampValid(sent, DATA_SIZE))
+		{
+			fail("packet after a gap", i);
+		}
+	}
+	PAYLOADCRYPT_GetStats(&tx, &rx);
+	if(rx.gaps != 2)
+	{
+		fail("gaps counted", rx.gaps);
+	}
+
+	/* Full size packets, as the firmware sends them */
+	PAYLOADCRYPT_Start();
+	for(uint32_t i = 0; i < packets; i++)
+	{
+		ramp(plain, DATA_SIZE, (uint8_t)i);
+		PAYLOADCRYPT_Encrypt(PAYLOADCRYPT_STREAM_NOTIFY, sent, plain, DATA_SIZE);
+		PAYLOADCRYPT_Decrypt(PAYLOADCRYPT_STREAM_NOTIFY, sent, DATA_SIZE);
+		if(!rampValid(sent, DATA_SIZE))
+		{
+			fail("ramp after decryption", i);
+		}
+	}
+	PAYLOADCRYPT_GetStats(&tx, &rx);
+	printf("%u packets of %u bytes, %u payload bytes each way, %u gaps\n",
+			tx.packets, DATA_SIZE, tx.bytes, rx.gaps);
+	printf("encrypt %.1f ns/byte, decrypt %.1f ns/byte (host software AES)\n",
+			tx.bytes ? (double)tx.cycles / tx.bytes : 0.0, rx.bytes ? (double)rx.cycles / rx.bytes : 0.0);
+	printf("%u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the SHA-256 stream integrity mode
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* First checks the software backend's SHA-256 against the FIPS 180-2
+ * appendix B messages, one of them a million bytes long, and the empty
+ * message. Then plays runs end to end: the module sends a stream of random
+ * payloads and its trailer, is started again as the receiver, and is fed
+ * the same stream with one fault in it: a payload lost, repeated, swapped
+ * with the next or with a bit flipped. Every fault must give a mismatch
+ * whose window holds the faulty packet, and a clean stream a match, for
+ * trailer packets of the smallest and largest size.
+ *
+ * Build:  gcc -O2 -Wall -DCRYPTOBACKEND_SOFTWARE_ONLY -I. -o payloaddigest_kat \
+ *             tools/payloaddigest_kat.c payloaddigest.c cryptobackend.c cryptobackend_sw.c
+ * Usage:  payloaddigest_kat [runs] [seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cryptobackend.h"
+#include "payloaddigest.h"
+
+#define MAX_PACKETS		5000
+#define PAYLOAD			64
+#define TRAILER_MAX		(PAYLOADDIGEST_TRAILER_HEADER + sizeof(PAYLOADDIGEST_Report_t))
+
+enum { FAULT_NONE, FAULT_LOST, FAULT_REPEATED, FAULT_SWAPPED, FAULT_FLIPPED, FAULTS };
+static const char *faultNames[FAULTS] = { "none", "lost", "repeated", "swapped", "flipped" };
+
+static const struct {
+	const char *message;
+	uint32_t repeat;
+	const char *digest;
+} vectors[] = {
+	{ "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+static uint8_t payloads[MAX_PACKETS][PAYLOAD];
+static uint8_t trailer[64][TRAILER_MAX];
+static uint16_t trailerLength[64];
+static uint32_t failures;
+
+static void fail(const char *what, uint32_t a, uint32_t b)
+{
+	if(failures++ < 10)
+	{
+		printf("FAIL: %s (%u, %u)\n", what, a, b);
+	}
+}
+
+static void known(void)
+{
+	for(uint32_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++)
+	{
+		uint32_t len = (uint32_t)strlen(vectors[v].message);
+		uint8_t *message = malloc(len * vectors[v].repeat + 1);
+		uint8_t digest[CRYPTOBACKEND_SHA256_SIZE];
+		char hex[65];
+
+		for(uint32_t i = 0; i < vectors[v].repeat; i++)
+		{
+			memcpy(message + i * len, vectors[v].message, len);
+		}
+		CRYPTOBACKEND_Software.sha256(message, len * vectors[v].repeat, digest);
+		for(uint32_t i = 0; i < sizeof(digest); i++)
+		{
+			sprintf(&hex[2 * i], "%02x", digest[i]);
+		}
+		if(strcmp(hex, vectors[v].digest) != 0)
+		{
+			fail("SHA-256 known answer", v, 0);
+		}
+		free(message);
+	}
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+/**************************************************************************//**
+* @brief One run: sender pass, then receiver pass with the fault at packet k
+*****************************************************************************/
+static void run(uint32_t packets, uint32_t fault, uint32_t k, uint16_t trailerSize)
+{
+	PAYLOADDIGEST_Result_t result;
+	uint32_t fragments = 0;
+	uint16_t len;
+
+	PAYLOADDIGEST_Start(random32());
+	for(uint32_t i = 0; i < packets; i++)
+	{
+		PAYLOADDIGEST_Fill(payloads[i], PAYLOAD);
+		PAYLOADDIGEST_Add(payloads[i], PAYLOAD);
+	}
+	while((len = PAYLOADDIGEST_TrailerNext(trailer[fragments], trailerSize)) != 0)
+	{
+		trailerLength[fragments++] = len;
+	}
+
+	PAYLOADDIGEST_Start(0);
+	for(uint32_t i = 0; i < packets; i++)
+	{
+		uint8_t copy[PAYLOAD];
+
+		memcpy(copy, payloads[i], PAYLOAD);
+		if(i == k)
+		{
+			if(fault == FAULT_LOST)
+			{
+				continue;
+			}
+			if(fault == FAULT_REPEATED)
+			{
+				PAYLOADDIGEST_Add(copy, PAYLOAD);
+			}
+			if(fault == FAULT_SWAPPED)
+			{
+				memcpy(copy, payloads[i + 1], PAYLOAD);
+				memcpy(payloads[i + 1], payloads[i], PAYLOAD);
+			}
+			if(fault == FAULT_FLIPPED)
+			{
+				copy[random32() % PAYLOAD] ^= 1 << (random32() % 8);
+			}
+		}
+		if(PAYLOADDIGEST_Receive(copy, PAYLOAD))
+		{
+			fail("payload taken for a trailer", i, 0);
+		}
+		PAYLOADDIGEST_Add(copy, PAYLOAD);
+	}
+	for(uint32_t i = 0; i < fragments; i++)
+	{
+		if(!PAYLOADDIGEST_Receive(trailer[i], trailerLength[i]))
+		{
+			fail("trailer not recognised", i, 0);
+		}
+	}
+
+	PAYLOADDIGEST_GetResult(&result);
+	if(fault == FAULT_NONE)
+	{
+		if(result.state != PAYLOADDIGEST_MATCH)
+		{
+			fail("clean run did not match", packets, result.state);
+		}
+		return;
+	}
+	if(result.state != PAYLOADDIGEST_MISMATCH)
+	{
+		fail(faultNames[fault], packets, k);
+		return;
+	}
+	if(k < result.lastGood || (result.badWindow != 0 && k >= result.lastGood + result.badWindow))
+	{
+		printf("  %s at %u of %u: window %u+%u\n", faultNames[fault], k, packets, result.lastGood, result.badWindow);
+		fail("divergence outside the window reported", k, result.lastGood);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+	uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+	uint32_t located = 0;
+	uint32_t faulty = 0;
+	PAYLOADDIGEST_Result_t result;
+
+	known();
+	printf("SHA-256 known answers %s\n", failures ? "failed" : "passed");
+
+	srand(seed);
+	for(uint32_t n = 0; n < runs; n++)
+	{
+		uint32_t packets = 2 + random32() % (MAX_PACKETS - 2);
+		uint32_t fault = n % FAULTS;
+		uint32_t k = random32() % (packets - 1);
+		uint16_t trailerSize = (n & 1) ? 20 : 247;
+
+		run(packets, fault, k, trailerSize);
+		PAYLOADDIGEST_GetResult(&result);
+		if(fault != FAULT_NONE)
+		{
+			faulty++;
+			located += (result.badWindow != 0);
+		}
+	}
+
+	PAYLOADDIGEST_GetResult(&result);
+	printf("%u runs, %u with a fault, %u of them placed in one window\n", runs, faulty, located);
+	printf("%.1f ns per hashed byte (host software SHA-256)\n", result.bytes ? (double)result.cycles / result.bytes : 0.0);
+	printf("%u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,429 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the PHY matrix sequencing against a stand-in stack
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* The stand-in answers the requests of phymatrix.c the way the stack and
+ * the slave do: a new interval comes back as a connection parameters event
+ * a few intervals later, a new PHY as a PHY status event, nothing at all
+ * when neither changes. Once asked, the peer sends at the PHY's rate and
+ * the run end comes back shortly after the stop. RSSI samples come once a
+ * second while data flows. Time is simulated in RTCC ticks, so a matrix of
+ * minutes checks in no time.
+ *
+ * Each scenario sets how the peer behaves: everything accepted, the S2
+ * coding refused with S8 taken instead, an interval refused, no run end
+ * (a slave without the stream request), the link lost mid matrix, and a
+ * console stop. The rows handed to done() are checked against what the
+ * stand-in did, and the port calls against the order the steps allow: no
+ * data before the PHY is in use, one run at a time, no timer left armed.
+ *
+ * Build:  gcc -O2 -Wall -I. -o phymatrix_sim tools/phymatrix_sim.c phymatrix.c
+ * Usage:  phymatrix_sim [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "phymatrix.h"
+
+#define PHY_1M		0x01
+#define PHY_2M		0x02
+#define PHY_S8		0x04
+#define PHY_S2		0x08
+
+#define SECOND		32768u
+#define NONE		UINT32_MAX
+#define EVENTS		16
+
+typedef enum {
+	EVENT_PHY,
+	EVENT_PARAMETERS,
+	EVENT_RUN_END,
+	EVENT_CLOSED
+} EventKind_t;
+
+typedef struct {
+	uint32_t at;
+	EventKind_t kind;
+	uint32_t value;
+} Event_t;
+
+/* Peer behaviour of a scenario */
+typedef struct {
+	const char *name;
+	uint8_t refusePhy;						// Asked for this PHY, the peer takes S8 instead
+	uint8_t refuseIntervalOn;				// Interval not changed when asked with this PHY
+	bool noRunEnd;
+	uint32_t closeAt;						// Link lost at this time, NONE for never
+	uint32_t abortAt;						// Console stop at this time, NONE for never
+} Scenario_t;
+
+static const PHYMATRIX_Step_t timings[] = {
+	{ PHY_1M, 40, 40, 0, 100 },
+	{ PHY_2M, 20, 20, 0, 100 },
+	{ PHY_S2, 160, 160, 0, 200 },
+	{ PHY_S8, 160, 160, 0, 200 },
+};
+
+static const Scenario_t *scenario;
+static Event_t events[EVENTS];
+static uint32_t eventCount;
+static uint32_t now;
+static uint32_t timerAt;
+static uint8_t phy;
+static uint16_t interval;
+static bool streaming;
+static uint32_t streamStart;
+static uint32_t streamTicks;
+static uint32_t nextRssi;
+static uint32_t failures;
+static bool verbose;
+static bool finished;
+static uint32_t doneCount;
+static PHYMATRIX_Row_t result[PHYMATRIX_MAX_STEPS];
+static uint32_t resultCount;
+static uint32_t ranOn[PHYMATRIX_MAX_STEPS];	// PHY each run saw at its start, per row
+
+static void fail(const char *what, uint32_t got, uint32_t expected)
+{
+	failures++;
+	printf("FAIL: %s: %s, %u instead of %u\n", scenario->name, what, got, expected);
+}
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		fail(what, got, expected);
+	}
+}
+
+static void post(uint32_t delay, EventKind_t kind, uint32_t value)
+{
+	if(eventCount == EVENTS)
+	{
+		fail("event queue full", eventCount, EVENTS);
+		return;
+	}
+	events[eventCount].at = now + delay;
+	events[eventCount].kind = kind;
+	events[eventCount].value = value;
+	eventCount++;
+}
+
+static uint32_t rate(uint8_t p)
+{
+	return (p == PHY_1M) ? 700000 : (p == PHY_2M) ? 1300000 : (p == PHY_S2) ? 350000 : 95000;
+}
+
+static int8_t rssiOf(uint8_t p, uint32_t n)
+{
+	return (int8_t)(((p == PHY_S8) ? -80 : -60) - (int32_t)(n % 5));
+}
+
+/* Port ------------------------------------------------------------------- */
+
+static void request(const PHYMATRIX_Step_t *step)
+{
+	uint8_t target = (step->phy == scenario->refusePhy) ? PHY_S8 : step->phy;
+	bool intervalChanges = (step->intervalMin != interval) && (step->phy != scenario->refuseIntervalOn);
+
+	if(verbose)
+	{
+		printf("%9.3f request phy %u interval %u\n", now / (double)SECOND, step->phy, step->intervalMin);
+	}
+	expect("request while streaming", streaming, false);
+
+	/* Six intervals for the update, the PHY follows it */
+	if(intervalChanges)
+	{
+		post(6 * step->intervalMin * 41, EVENT_PARAMETERS, step->intervalMin);
+	}
+	if(target != phy)
+	{
+		post(6 * step->intervalMin * 41 + 2 * step->intervalMin * 41, EVENT_PHY, target);
+	}
+}
+
+static void runStart(void)
+{
+	uint32_t count;
+
+	PHYMATRIX_Rows(&count);
+	if(verbose)
+	{
+		printf("%9.3f run start on phy %u interval %u\n", now / (double)SECOND, phy, interval);
+	}
+	expect("run start while streaming", streaming, false);
+	ranOn[count - 1] = phy;
+	streaming = true;
+	streamStart = now + SECOND / 100;		// The request goes out over the air
+	nextRssi = now + SECOND;
+}
+
+static void runStop(void)
+{
+	if(verbose)
+	{
+		printf("%9.3f run stop\n", now / (double)SECOND);
+	}
+	expect("run stop while not streaming", streaming, true);
+	streaming = false;
+	streamTicks = now - streamStart;
+	if(!scenario->noRunEnd)
+	{
+		post(SECOND / 50, EVENT_RUN_END, 0);
+	}
+}
+
+static void collect(PHYMATRIX_Row_t *row)
+{
+	uint32_t ticks = streaming ? now - streamStart : streamTicks;
+
+	row->bits = (uint32_t)(((uint64_t)rate(phy) * ticks) / SECOND);
+	row->ticks = ticks;
+	row->invalid = 0;
+	row->lpDenials = (uint16_t)(ticks / SECOND);
+	row->hpDenials = 0;
+	streaming = false;
+}
+
+static void timer(uint32_t ticks)
+{
+	timerAt = ticks ? now + ticks : NONE;
+}
+
+static void done(const PHYMATRIX_Row_t *rows, uint32_t count)
+{
+	doneCount++;
+	finished = true;
+	resultCount = count;
+	memcpy(result, rows, count * sizeof(rows[0]));
+	expect("timer armed at done", timerAt, NONE);
+}
+
+static const PHYMATRIX_Port_t port = { request, runStart, runStop, collect, timer, done };
+
+/* Event loop -------------------------------------------------------------- */
+
+static void deliver(uint32_t i)
+{
+	Event_t e = events[i];
+
+	events[i] = events[--eventCount];
+	switch(e.kind)
+	{
+		case EVENT_PHY:
+			phy = (uint8_t)e.value;
+			PHYMATRIX_PhyStatus(phy);
+			break;
+		case EVENT_PARAMETERS:
+			interval = (uint16_t)e.value;
+			PHYMATRIX_Parameters(interval);
+			break;
+		case EVENT_RUN_END:
+			PHYMATRIX_RunEnded();
+			break;
+		case EVENT_CLOSED:
+			streaming = false;
+			PHYMATRIX_Closed();
+			break;
+	}
+}
+
+static void run(const Scenario_t *s, const PHYMATRIX_Step_t *steps, uint32_t count, uint32_t seconds)
+{
+	uint32_t rssiSamples = 0;
+
+	scenario = s;
+	now = 1000;
+	timerAt = NONE;
+	eventCount = 0;
+	phy = PHY_1M;
+	interval = 40;
+	streaming = false;
+	finished = false;
+	doneCount = 0;
+	memset(ranOn, 0, sizeof(ranOn));
+
+	if(s->closeAt != NONE)
+	{
+		post(s->closeAt - now, EVENT_CLOSED, 0);
+	}
+	expect("start", PHYMATRIX_Start(&port, steps, count, seconds, phy, interval), true);
+	expect("second start", PHYMATRIX_Start(&port, steps, count, seconds, phy, interval), false);
+
+	while(!finished)
+	{
+		uint32_t next = timerAt;
+		uint32_t first = NONE;
+
+		for(uint32_t i = 0; i < eventCount; i++)
+		{
+			if(events[i].at <= next)
+			{
+				next = events[i].at;
+				first = i;
+			}
+		}
+		if(now < s->abortAt && s->abortAt < next && !(streaming && nextRssi < s->abortAt))
+		{
+			now = s->abortAt;
+			PHYMATRIX_Abort();
+			continue;
+		}
+		if(streaming && nextRssi < next)
+		{
+			now = nextRssi;
+			nextRssi += SECOND;
+			PHYMATRIX_Rssi(rssiOf(phy, rssiSamples++));
+			continue;
+		}
+		if(next == NONE)
+		{
+			fail("stalled with nothing pending", 0, 1);
+			break;
+		}
+
+		now = next;
+		if(first != NONE)
+		{
+			deliver(first);
+		}
+		else
+		{
+			timerAt = NONE;
+			PHYMATRIX_Timer();
+		}
+	}
+
+	expect("done once", doneCount, 1);
+	expect("running after done", PHYMATRIX_Running(), false);
+	expect("streaming after done", streaming, false);
+}
+
+static void print(void)
+{
+	printf("%s\n", scenario->name);
+	for(uint32_t i = 0; i < resultCount; i++)
+	{
+		const PHYMATRIX_Row_t *r = &result[i];
+
+		printf("  phy %u interval %3u  %7.0f bit/s  rssi %d/%d/%d  denials %u  flags %#x\n", r->phy, r->interval,
+				r->ticks ? (double)r->bits * SECOND / r->ticks : 0.0, r->rssiCount ? r->rssiMin : 0,
+				r->rssiCount ? (int)(r->rssiSum / r->rssiCount) : 0, r->rssiCount ? r->rssiMax : 0, r->lpDenials,
+				r->flags);
+	}
+}
+
+/* A row that ran: right PHY, full length, rate and RSSI of that PHY */
+static void expectRan(uint32_t i, const PHYMATRIX_Step_t *step, uint32_t seconds, uint8_t flags)
+{
+	const PHYMATRIX_Row_t *r = &result[i];
+	uint8_t p = step->phy;
+	uint32_t bps = r->ticks ? (uint32_t)(((uint64_t)r->bits * SECOND) / r->ticks) : 0;
+
+	expect("row phy", r->phy, p);
+	expect("row flags", r->flags, flags);
+	expect("ran on phy", ranOn[i], p);
+	if(!(flags & PHYMATRIX_INTERVAL_REFUSED))
+	{
+		expect("row interval", r->interval, step->intervalMin);
+	}
+	if(r->ticks + SECOND / 100 != seconds * SECOND)
+	{
+		fail("run length", r->ticks, seconds * SECOND - SECOND / 100);
+	}
+	if(bps + 1 < rate(p) || bps > rate(p))
+	{
+		fail("throughput", bps, rate(p));
+	}
+	expect("rssi samples", r->rssiCount, seconds - 1);
+	if(r->rssiCount != 0 && (r->rssiMax > rssiOf(p, 0) || r->rssiMin < rssiOf(p, 4)))
+	{
+		fail("rssi range", (uint32_t)-r->rssiMin, (uint32_t)-rssiOf(p, 4));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static const Scenario_t all = { "all accepted", 0, 0, false, NONE, NONE };
+	static const Scenario_t s2 = { "S2 refused, S8 taken", PHY_S2, 0, false, NONE, NONE };
+	static const Scenario_t slow = { "2M interval refused", 0, PHY_2M, false, NONE, NONE };
+	static const Scenario_t noEnd = { "no run end", 0, 0, true, NONE, NONE };
+	static const Scenario_t lost = { "link lost in the second step", 0, 0, false, 1000 + 15 * SECOND, NONE };
+	static const Scenario_t stop = { "stopped in the third step", 0, 0, false, NONE, 1000 + 25 * SECOND };
+	static const Scenario_t same = { "same PHY twice", 0, 0, false, NONE, NONE };
+	const PHYMATRIX_Step_t twice[] = { timings[0], timings[0] };
+
+	verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+
+	run(&all, timings, 4, 10);
+	print();
+	expect("rows", resultCount, 4);
+	for(uint32_t i = 0; i < resultCount && i < 4; i++)
+	{
+		expectRan(i, &timings[i], 10, 0);
+	}
+
+	run(&s2, timings, 4, 5);
+	print();
+	expect("rows", resultCount, 4);
+	expectRan(0, &timings[0], 5, 0);
+	expectRan(1, &timings[1], 5, 0);
+	expect("S2 refused", result[2].flags, PHYMATRIX_PHY_REFUSED);
+	expect("S2 no data", result[2].bits, 0);
+	expect("S2 no rssi", result[2].rssiCount, 0);
+	expectRan(3, &timings[3], 5, 0);
+
+	run(&slow, timings, 4, 5);
+	print();
+	expect("rows", resultCount, 4);
+	expectRan(1, &timings[1], 5, PHYMATRIX_INTERVAL_REFUSED);
+	expect("2M kept the 1M interval", result[1].interval, 40);
+	expectRan(2, &timings[2], 5, 0);
+
+	run(&noEnd, timings, 2, 5);
+	print();
+	expect("rows", resultCount, 2);
+	expect("no end flagged", result[0].flags, PHYMATRIX_NO_END);
+	expect("no end flagged", result[1].flags, PHYMATRIX_NO_END);
+
+	run(&lost, timings, 4, 10);
+	print();
+	expect("rows", resultCount, 2);
+	expect("first row", result[0].flags, 0);
+	expect("closed row", result[1].flags, PHYMATRIX_CLOSED);
+	if(result[1].bits == 0)
+	{
+		fail("closed row keeps its data", result[1].bits, 1);
+	}
+
+	run(&stop, timings, 4, 10);
+	print();
+	expect("rows", resultCount, 2);
+	expectRan(1, &timings[1], 10, 0);
+
+	run(&same, twice, 2, 3);
+	print();
+	expect("rows", resultCount, 2);
+	expectRan(0, &twice[0], 3, 0);
+	expectRan(1, &twice[1], 3, 0);
+
+	printf("matrix checks: %u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the Bluetooth stack's flash PS
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Lets pscache.c run unchanged on a PC.
+ *
+ * Build:  gcc -O2 -Wall -DPSCACHE_HOST_MODEL -I. -Itools -o pscheck \
+ *             pscheck.c pscache.c tools/ps_model.c
+ *
+ * where pscheck.c is any host program calling PSCACHE_*.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "ps_model.h"
+
+#define OBJECT_HEADER	8
+#define LOG_SIZE		(PS_MODEL_PAGES * PS_MODEL_PAGE_SIZE)
+
+typedef struct {
+	bool used;
+	uint16_t key;
+	uint8_t len;
+	uint8_t value[PS_MODEL_VALUE_SIZE];
+} Key_t;
+
+static Key_t keys[PS_MODEL_KEYS];
+static uint32_t logUsed;				// Bytes appended since the last compaction
+static uint64_t now;					// Virtual time, us
+static uint64_t busy;					// Part of now spent on flash work, us
+static uint32_t writes;
+static uint32_t loads;
+static uint32_t pageErases;
+static uint32_t maxStall;
+
+static Key_t *find(uint16_t key)
+{
+	for(uint32_t i = 0; i < PS_MODEL_KEYS; i++)
+	{
+		if(keys[i].used && keys[i].key == key)
+		{
+			return &keys[i];
+		}
+	}
+	return NULL;
+}
+
+static uint32_t objectSize(uint32_t len)
+{
+	return OBJECT_HEADER + ((len + 3) & ~3u);
+}
+
+/* Bytes the live keys take after a compaction */
+static uint32_t liveSize(void)
+{
+	uint32_t size = 0;
+
+	for(uint32_t i = 0; i < PS_MODEL_KEYS; i++)
+	{
+		if(keys[i].used)
+		{
+			size += objectSize(keys[i].len);
+		}
+	}
+	return size;
+}
+
+/**************************************************************************//**
+* @brief Appends one object, compacting first if it does not fit
+* @return Time the caller was blocked, us
+*****************************************************************************/
+static uint32_t append(uint32_t size)
+{
+	uint32_t stall = PS_MODEL_T_SAVE + (size / 4) * PS_MODEL_T_WORD;
+
+	if(logUsed + size > LOG_SIZE)
+	{
+		logUsed = liveSize();
+		pageErases += PS_MODEL_PAGES;
+		stall += PS_MODEL_PAGES * PS_MODEL_T_ERASE + (logUsed / 4) * PS_MODEL_T_WORD;
+	}
+	logUsed += size;
+	writes++;
+
+	now += stall;
+	busy += stall;
+	if(stall > maxStall)
+	{
+		maxStall = stall;
+	}
+	return stall;
+}
+
+uint16_t PS_MODEL_Save(uint16_t key, const uint8_t *value, uint8_t len)
+{
+	Key_t *slot = find(key);
+
+	if(len > PS_MODEL_VALUE_SIZE)
+	{
+		return bg_err_invalid_param;
+	}
+	if(slot == NULL)
+	{
+		for(uint32_t i = 0; i < PS_MODEL_KEYS && slot == NULL; i++)
+		{
+			if(!keys[i].used)
+			{
+				slot = &keys[i];
+			}
+		}
+		if(slot == NULL || liveSize() + objectSize(len) > LOG_SIZE - PS_MODEL_PAGE_SIZE)
+		{
+			return bg_err_hardware_ps_store_full;
+		}
+	}
+
+	slot->used = true;
+	slot->key = key;
+	slot->len = len;
+	memcpy(slot->value, value, len);
+	append(objectSize(len));
+	return 0;
+}
+
+uint16_t PS_MODEL_Load(uint16_t key, uint8_t *value, uint8_t *len)
+{
+	Key_t *slot = find(key);
+
+	loads++;
+	now += PS_MODEL_T_SAVE / 4;
+	busy += PS_MODEL_T_SAVE / 4;
+	if(slot == NULL)
+	{
+		return bg_err_hardware_ps_key_not_found;
+	}
+	memcpy(value, slot->value, (slot->len < *len) ? slot->len : *len);
+	*len = slot->len;
+	return 0;
+}
+
+uint16_t PS_MODEL_Erase(uint16_t key)
+{
+	Key_t *slot = find(key);
+
+	if(slot == NULL)
+	{
+		return bg_err_hardware_ps_key_not_found;
+	}
+	slot->used = false;
+	append(OBJECT_HEADER);
+	return 0;
+}
+
+/**************************************************************************//**
+* @brief No keys, empty log, counters and clock cleared
+*****************************************************************************/
+void PS_MODEL_Reset(void)
+{
+	memset(keys, 0, sizeof(keys));
+	logUsed = 0;
+	now = 0;
+	busy = 0;
+	writes = 0;
+	loads = 0;
+	pageErases = 0;
+	maxStall = 0;
+}
+
+void PS_MODEL_Advance(uint32_t us)
+{
+	now += us;
+}
+
+/* The RTCC runs at 32768 Hz */
+uint32_t PS_MODEL_Ticks(void)
+{
+	return (uint32_t)((now * 32768) / 1000000);
+}
+
+uint64_t PS_MODEL_Now(void)
+{
+	return now;
+}
+
+uint64_t PS_MODEL_Busy(void)
+{
+	return busy;
+}
+
+uint32_t PS_MODEL_Writes(void)
+{
+	return writes;
+}
+
+uint32_t PS_MODEL_Loads(void)
+{
+	return loads;
+}
+
+uint32_t PS_MODEL_PageErases(void)
+{
+	return pageErases;
+}
+
+uint32_t PS_MODEL_MaxStall(void)
+{
+	return maxStall;
+}
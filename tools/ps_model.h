@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in for the Bluetooth stack's flash PS
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PS_MODEL_H_
+#define PS_MODEL_H_
+
+#include <stdint.h>
+
+/* pscache.c built with -DPSCACHE_HOST_MODEL calls these instead of
+ * gecko_cmd_flash_ps_save/load/erase. Keys live in RAM. The flash behind
+ * them is modelled as a log the way NVM3 keeps it: every save or erase
+ * appends an object of an 8 byte header plus the value in whole words, and
+ * a full log is compacted, erasing every page, before the next append.
+ * Only the time and the wear are modelled, the contents are not.
+ *
+ * Time is virtual: PS_MODEL_Advance() moves it on, flash work adds its
+ * typical duration, and PS_MODEL_Ticks() reads it as the RTCC would. */
+
+#ifndef PS_MODEL_KEYS
+#define PS_MODEL_KEYS			64
+#endif
+#define PS_MODEL_VALUE_SIZE		56			// Longest value the stack accepts
+#ifndef PS_MODEL_PAGES
+#define PS_MODEL_PAGES			3
+#endif
+#define PS_MODEL_PAGE_SIZE		2048
+
+/* Busy times in microseconds */
+#ifndef PS_MODEL_T_SAVE
+#define PS_MODEL_T_SAVE			100			// Object lookup and bookkeeping
+#endif
+#ifndef PS_MODEL_T_WORD
+#define PS_MODEL_T_WORD			20
+#endif
+#ifndef PS_MODEL_T_ERASE
+#define PS_MODEL_T_ERASE		26000
+#endif
+
+/* Same values as bg_errorcodes.h */
+#define bg_err_hardware_ps_store_full		0x0501
+#define bg_err_hardware_ps_key_not_found	0x0502
+#define bg_err_invalid_param				0x0180
+
+uint16_t PS_MODEL_Save(uint16_t key, const uint8_t *value, uint8_t len);
+uint16_t PS_MODEL_Load(uint16_t key, uint8_t *value, uint8_t *len);
+uint16_t PS_MODEL_Erase(uint16_t key);
+
+void     PS_MODEL_Reset(void);
+void     PS_MODEL_Advance(uint32_t us);
+uint32_t PS_MODEL_Ticks(void);
+uint64_t PS_MODEL_Now(void);
+uint64_t PS_MODEL_Busy(void);
+uint32_t PS_MODEL_Writes(void);
+uint32_t PS_MODEL_Loads(void);
+uint32_t PS_MODEL_PageErases(void);
+uint32_t PS_MODEL_MaxStall(void);
+
+#endif
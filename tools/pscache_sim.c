@@ -0,0 +1,238 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the flash PS write-back cache
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs pscache.c against the PS model with a workload like the firmware's:
+ * a few counters saved over and over, settings saved now and then, loads of
+ * all of them, the odd erase and value too long to cache, and more keys than
+ * cache entries. Every load is checked against a plain copy of what was
+ * saved. Every so often the cache is flushed and started again, like a
+ * reset, and the PS alone must then give back the same values.
+ *
+ * The report compares the PS writes and the longest stalls, in the callers
+ * of PSCACHE_Save/Load/Erase and in PSCACHE_Poll(), both of which run in
+ * the event loop, against what the same saves would have cost written
+ * straight through. Build with a smaller -DPSCACHE_VALUE_SIZE to see long
+ * values bypass the cache.
+ *
+ * Build:  gcc -O2 -Wall -DPSCACHE_HOST_MODEL -I. -Itools -o pscache_sim \
+ *             tools/pscache_sim.c pscache.c tools/ps_model.c
+ * Usage:  pscache_sim [operations] [keys] [seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pscache.h"
+#include "ps_model.h"
+
+#define KEY_BASE		0x4000
+#define MAX_KEYS		PS_MODEL_KEYS
+
+typedef struct {
+	bool present;
+	uint8_t len;
+	uint8_t value[PS_MODEL_VALUE_SIZE];
+} Reference_t;
+
+static Reference_t reference[MAX_KEYS];
+static uint32_t mismatches;
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+/* Adds up the counters of one cache session */
+static void accumulate(PSCACHE_Stats_t *total)
+{
+	PSCACHE_Stats_t stats;
+
+	PSCACHE_GetStats(&stats);
+	total->loads += stats.loads;
+	total->hits += stats.hits;
+	total->saves += stats.saves;
+	total->coalesced += stats.coalesced;
+	total->unchanged += stats.unchanged;
+	total->flushes += stats.flushes;
+	total->flushErrors += stats.flushErrors;
+	total->evictions += stats.evictions;
+	total->evictionFlushes += stats.evictionFlushes;
+	total->bypassed += stats.bypassed;
+}
+
+static void check(uint32_t k)
+{
+	uint8_t value[PS_MODEL_VALUE_SIZE];
+	uint8_t len = sizeof(value);
+	uint16_t result = PSCACHE_Load(KEY_BASE + k, value, &len);
+
+	if(reference[k].present != (result == 0)
+			|| (result == 0 && (len != reference[k].len || memcmp(value, reference[k].value, len) != 0)))
+	{
+		if(mismatches++ < 10)
+		{
+			printf("key 0x%04x: result 0x%04x len %u, expected %s len %u\n", KEY_BASE + k, result, len,
+					reference[k].present ? "present" : "absent", reference[k].len);
+		}
+	}
+}
+
+/* Hot keys are picked far more often, like run and boot counters */
+static uint32_t pickKey(uint32_t count)
+{
+	return (random32() % 4) ? random32() % 3 : random32() % count;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t operations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+	uint32_t count = (argc > 2) ? strtoul(argv[2], NULL, 0) : 12;
+	uint32_t seed = (argc > 3) ? strtoul(argv[3], NULL, 0) : 1;
+	uint32_t saves = 0;
+	uint32_t resets = 0;
+	uint32_t loopStall = 0;
+	uint32_t loopWrites = 0;				// Operations that had to write the PS before returning
+	uint32_t pollStall = 0;
+	uint32_t pollWrites = 0;				// PSCACHE_Poll() calls that wrote the PS
+	uint32_t directWrites;
+	uint64_t directTime;
+	uint32_t directStall;
+	PSCACHE_Stats_t total = { 0 };
+
+	if(count < 3 || count > MAX_KEYS)
+	{
+		fprintf(stderr, "keys must be 3..%u\n", MAX_KEYS);
+		return 2;
+	}
+
+	srand(seed);
+	PS_MODEL_Reset();
+	PSCACHE_Init();
+
+	for(uint32_t n = 0; n < operations && mismatches == 0; n++)
+	{
+		uint32_t k = pickKey(count);
+		uint32_t r = random32() % 100;
+		uint64_t before = PS_MODEL_Now();
+
+		if(r < 55)
+		{
+			Reference_t *ref = &reference[k];
+
+			/* Counters mostly change, settings mostly get saved unchanged */
+			ref->len = (k < 3) ? 4 : 1 + k % PSCACHE_VALUE_SIZE;
+			if(random32() % 100 == 0)
+			{
+				/* Long values, near the most the PS takes */
+				ref->len = PS_MODEL_VALUE_SIZE - random32() % 8;
+			}
+			if(k < 3 || (random32() % 4) == 0)
+			{
+				for(uint32_t i = 0; i < ref->len; i++)
+				{
+					ref->value[i] = (uint8_t)random32();
+				}
+			}
+			ref->present = true;
+			if(PSCACHE_Save(KEY_BASE + k, ref->value, ref->len) != 0)
+			{
+				printf("save of key 0x%04x failed\n", KEY_BASE + k);
+				mismatches++;
+			}
+			saves++;
+		}
+		else if(r < 97)
+		{
+			check(k);
+		}
+		else
+		{
+			PSCACHE_Erase(KEY_BASE + k);
+			reference[k].present = false;
+			saves++;
+		}
+		if(PS_MODEL_Now() - before >= PS_MODEL_T_SAVE)
+		{
+			loopWrites++;
+		}
+		if(PS_MODEL_Now() - before > loopStall)
+		{
+			loopStall = (uint32_t)(PS_MODEL_Now() - before);
+		}
+
+		/* The event loop goes idle between operations, up to a second */
+		PS_MODEL_Advance(random32() % 1000000);
+		before = PS_MODEL_Now();
+		PSCACHE_Poll();
+		if(PS_MODEL_Now() != before)
+		{
+			pollWrites++;
+		}
+		if(PS_MODEL_Now() - before > pollStall)
+		{
+			pollStall = (uint32_t)(PS_MODEL_Now() - before);
+		}
+
+		if((n % 10000) == 9999)
+		{
+			if(PSCACHE_Flush() != 0)
+			{
+				printf("flush failed\n");
+				mismatches++;
+			}
+			accumulate(&total);
+			PSCACHE_Init();
+			resets++;
+			for(uint32_t i = 0; i < count; i++)
+			{
+				check(i);
+			}
+		}
+	}
+	PSCACHE_Flush();
+	accumulate(&total);
+
+	printf("%u operations on %u keys, %u saves or erases, %u resets\n", operations, count, saves, resets);
+	printf("hit rate %.1f%%, %u saves coalesced, %u unchanged, %u evictions, %u of them written back, %u bypassed\n",
+			total.loads ? 100.0 * total.hits / total.loads : 0.0,
+			total.coalesced, total.unchanged, total.evictions, total.evictionFlushes, total.bypassed);
+	printf("%u flushes, %u flush errors\n", total.flushes, total.flushErrors);
+	printf("cached:  %u PS writes, %u page erases, %.1f s of flash time\n",
+			PS_MODEL_Writes(), PS_MODEL_PageErases(), PS_MODEL_Busy() / 1e6);
+	printf("         %u writes in save/load/erase, longest stall %u us\n", loopWrites, loopStall);
+	printf("         %u writes in PSCACHE_Poll(), longest stall %u us\n", pollWrites, pollStall);
+
+	/* Same saves straight through, for comparison */
+	PS_MODEL_Reset();
+	for(uint32_t i = 0; i < saves; i++)
+	{
+		uint8_t value[4] = { 0 };
+
+		PS_MODEL_Save(KEY_BASE + (i % count), value, sizeof(value));
+	}
+	directWrites = PS_MODEL_Writes();
+	directTime = PS_MODEL_Busy();
+	directStall = PS_MODEL_MaxStall();
+	printf("direct:  %u PS writes, %u page erases, %.1f s of flash time, %u writes in the event loop, longest stall %u us\n",
+			directWrites, PS_MODEL_PageErases(), directTime / 1e6, directWrites, directStall);
+	printf("%u mismatches\n", mismatches);
+
+	return mismatches ? 1 : 0;
+}
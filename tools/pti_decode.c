@@ -0,0 +1,674 @@
+/***************************************************************************//**
+ * @file
+ * @brief Bluetooth LE packets and airtime from a packet trace capture
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Reads a capture of the frames pti.c sends out, as debug channel records
+ * (see pti_format.h) or with -r as the bare PTI UART stream, and rebuilds the
+ * Bluetooth LE frames: access address, header, time, RSSI, PHY and channel.
+ * Frames of a connection are grouped into connection events, a new event
+ * starting on a change of channel or after PTI_EVENT_GAP_NS without a frame.
+ *
+ * For every connection, named by its access address, it prints the events,
+ * the frames per event, retransmissions, CRC errors and new data, and splits
+ * the time from the first frame to the last into
+ *   airtime        frames on air
+ *   T_IFS          the 150 us between frames of an event
+ *   turnaround     time between frames of an event past T_IFS
+ *   idle           time between events
+ * which is where a throughput run goes. A retransmission is a frame with the
+ * SN of the last frame sent the same way, tx being the board traced. The
+ * SN of a frame received with a bad CRC cannot be trusted, the next one
+ * received is counted as a retransmission instead, as the peer is not
+ * acknowledged and sends it again.
+ *
+ * The capture is read in one pass through a fixed buffer, a capture of any
+ * size takes the same memory. A bare UART capture has no time, only counts
+ * are given and events are split on the channel alone.
+ *
+ * Build:  gcc -O2 -Wall -Itools -o pti_decode tools/pti_decode.c
+ * Usage:  pti_decode [-r] [-e events.csv] [capture]     (stdin if no capture)
+ *         -e writes a line per connection event
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pti_format.h"
+
+#define READ_SIZE			65536
+#define MAX_CONNECTIONS		32
+#define EVENT_BUCKETS		17			// Frames per event, 16 and up in the last
+#define PTI_EVENT_GAP_NS	1000000u	// Shortest connection interval is 7.5 ms, an event has 150 us between frames
+
+typedef struct
+{
+	uint64_t end;						// ns, 0 when not known
+	uint64_t start;
+	bool rx;
+	bool aborted;
+	bool crcError;
+	bool hasRssi;
+	int8_t rssi;
+	uint8_t phy;
+	uint8_t channel;
+	uint32_t aa;
+	uint8_t header;
+	uint8_t length;
+	uint32_t airtime;					// us
+} Frame_t;
+
+typedef struct
+{
+	uint32_t aa;
+	uint64_t frames;
+	uint64_t tx;
+	uint64_t rx;
+	uint64_t retransmitTx;
+	uint64_t retransmitRx;
+	uint64_t crcErrors;
+	uint64_t aborted;
+	uint64_t empty;
+	uint64_t newBytes;
+	uint64_t events;
+	uint64_t perEvent[EVENT_BUCKETS];
+	uint32_t mostPerEvent;
+	uint64_t phy[4];
+	uint64_t channels;					// Bit per RF channel
+	int64_t rssiSum;
+	uint64_t rssiCount;
+	int8_t rssiMin;
+	int8_t rssiMax;
+	uint64_t first;						// ns
+	uint64_t last;
+	uint64_t airtime;
+	uint64_t ifs;
+	uint64_t turnaround;
+	uint64_t idle;
+	bool snSeen[2];						// Index 1 received
+	uint8_t sn[2];
+	bool resend;						// Frame received with a bad CRC, the peer sends it again
+	/* Event open */
+	bool inEvent;
+	uint8_t channel;
+	uint8_t eventPhy;
+	uint64_t eventStart;
+	uint64_t eventEnd;
+	uint64_t eventIdle;
+	uint32_t eventFrames;
+	uint32_t eventTx;
+	uint32_t eventRetransmit;
+	uint32_t eventCrc;
+	uint64_t eventAirtime;
+} Conn_t;
+
+static const char *phyNames[] = { "1M", "2M", "S8", "S2" };
+
+static FILE *in;
+static uint8_t buffer[READ_SIZE + 4 + PTI_DCH_V3_HEADER + PTI_DCH_MAX];
+static uint32_t head;
+static uint32_t tail;
+static uint64_t offset;
+static bool eof;
+
+static Conn_t conns[MAX_CONNECTIONS];
+static uint32_t connCount;
+static uint64_t connOverflow;
+static FILE *events;
+static bool timed = true;
+
+static uint64_t records;
+static uint64_t otherRecords;
+static uint64_t skipped;
+static uint64_t badFrames;
+static uint64_t otherProtocol;
+static uint64_t advFrames;
+static uint64_t advCrcErrors;
+static uint64_t advAirtime;
+
+static uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le48(const uint8_t *p)
+{
+	return le32(p) | ((uint64_t)le16(p + 4) << 32);
+}
+
+static uint64_t le64(const uint8_t *p)
+{
+	return le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+/**************************************************************************//**
+* @brief Bytes ready at buffer[head], reading more if fewer than wanted
+*****************************************************************************/
+static uint32_t ready(uint32_t wanted)
+{
+	while(tail - head < wanted && !eof)
+	{
+		size_t got;
+
+		memmove(buffer, buffer + head, tail - head);
+		tail -= head;
+		head = 0;
+		got = fread(buffer + tail, 1, sizeof(buffer) - tail, in);
+		if(got == 0)
+		{
+			eof = true;
+		}
+		tail += (uint32_t)got;
+	}
+	return tail - head;
+}
+
+static void consume(uint32_t count)
+{
+	head += count;
+	offset += count;
+}
+
+/**************************************************************************//**
+* @brief Reads a PTI frame, start marker to end marker
+* @return false if it is not a whole Bluetooth LE frame
+*****************************************************************************/
+static bool parseFrame(const uint8_t *p, uint32_t len, Frame_t *frame)
+{
+	uint8_t cfg;
+	uint8_t appended;
+	uint8_t status;
+	uint32_t ota;
+
+	if(len < 3)
+	{
+		return false;
+	}
+	cfg = p[len - 2];
+	appended = PTI_CFG_LENGTH(cfg);
+	if(appended < 2 || len < 9u + appended)
+	{
+		return false;
+	}
+	frame->rx = (p[0] == PTI_RX_START);
+	if(!frame->rx && p[0] != PTI_TX_START)
+	{
+		return false;
+	}
+	if(frame->rx != ((cfg & PTI_CFG_RX) != 0))
+	{
+		return false;
+	}
+	switch(p[len - 1])
+	{
+	case PTI_RX_END:
+	case PTI_TX_END:
+		frame->aborted = false;
+		break;
+	case PTI_RX_ABORT:
+	case PTI_TX_ABORT:
+		frame->aborted = true;
+		break;
+	default:
+		return false;
+	}
+
+	status = p[len - 3];
+	if(PTI_STATUS_PROTOCOL(status) != PTI_PROTOCOL_BLE)
+	{
+		otherProtocol++;
+		return false;
+	}
+	frame->crcError = frame->rx && PTI_STATUS_ERROR(status) != 0;
+	frame->channel = p[len - 4] & 0x3F;
+	frame->phy = (PTI_CFG_VERSION(cfg) >= 2 && appended >= 3) ? p[len - 5] & 3 : PTI_PHY_1M;
+	frame->hasRssi = frame->rx && appended >= 3 + (PTI_CFG_VERSION(cfg) >= 2);
+	frame->rssi = frame->hasRssi ? (int8_t)p[len - 2 - appended] : 0;
+
+	/* Over the air bytes, short on an abort */
+	ota = len - 3 - appended;
+	frame->aa = le32(p + 1);
+	frame->header = p[5];
+	frame->length = p[6];
+	if(!frame->aborted && ota != 4u + 2 + frame->length + 3)
+	{
+		return false;
+	}
+	frame->airtime = PTI_BleAirtimeUs(frame->phy, frame->length);
+	return true;
+}
+
+static Conn_t *connection(uint32_t aa)
+{
+	for(uint32_t i = 0; i < connCount; i++)
+	{
+		if(conns[i].aa == aa)
+		{
+			return &conns[i];
+		}
+	}
+	if(connCount == MAX_CONNECTIONS)
+	{
+		return NULL;
+	}
+	memset(&conns[connCount], 0, sizeof(Conn_t));
+	conns[connCount].aa = aa;
+	conns[connCount].rssiMin = INT8_MAX;
+	conns[connCount].rssiMax = INT8_MIN;
+	return &conns[connCount++];
+}
+
+static void closeEvent(Conn_t *c)
+{
+	if(!c->inEvent)
+	{
+		return;
+	}
+	c->inEvent = false;
+	c->events++;
+	c->perEvent[(c->eventFrames < EVENT_BUCKETS) ? c->eventFrames : EVENT_BUCKETS - 1]++;
+	if(c->eventFrames > c->mostPerEvent)
+	{
+		c->mostPerEvent = c->eventFrames;
+	}
+	if(events)
+	{
+		fprintf(events, "%08x,%llu,%.3f,%u,%s,%u,%u,%u,%u,%u,%llu,%.3f,%.3f\n", c->aa, (unsigned long long)c->events,
+				c->eventStart / 1000.0, c->channel, phyNames[c->eventPhy], c->eventFrames, c->eventTx,
+				c->eventFrames - c->eventTx, c->eventRetransmit, c->eventCrc, (unsigned long long)c->eventAirtime,
+				(c->eventEnd - c->eventStart) / 1000.0, c->eventIdle / 1000.0);
+	}
+}
+
+/**************************************************************************//**
+* @brief Counts a connection frame into its event
+*****************************************************************************/
+static void connectionFrame(Conn_t *c, const Frame_t *frame)
+{
+	uint8_t way = frame->rx;
+	bool retransmit = false;
+	bool newEvent;
+	uint64_t gap = 0;
+
+	if(timed && c->frames && frame->start > c->last)
+	{
+		gap = frame->start - c->last;
+	}
+	newEvent = !c->inEvent || frame->channel != c->channel || (timed && gap > PTI_EVENT_GAP_NS);
+	if(newEvent)
+	{
+		closeEvent(c);
+		c->inEvent = true;
+		c->channel = frame->channel;
+		c->eventPhy = frame->phy;
+		c->eventStart = frame->start;
+		c->eventIdle = gap;
+		c->eventFrames = 0;
+		c->eventTx = 0;
+		c->eventRetransmit = 0;
+		c->eventCrc = 0;
+		c->eventAirtime = 0;
+		c->idle += gap;
+	}
+	else if(gap > PTI_BLE_T_IFS_NS)
+	{
+		c->ifs += PTI_BLE_T_IFS_NS;
+		c->turnaround += gap - PTI_BLE_T_IFS_NS;
+	}
+	else
+	{
+		c->ifs += gap;
+	}
+	if(!c->frames)
+	{
+		c->first = frame->start;
+	}
+	if(frame->end > c->last)
+	{
+		c->last = frame->end;
+	}
+	c->eventEnd = frame->end;
+
+	c->frames++;
+	c->eventFrames++;
+	c->airtime += frame->airtime * 1000ull;
+	c->eventAirtime += frame->airtime;
+	c->phy[frame->phy]++;
+	c->channels |= 1ull << frame->channel;
+	if(frame->rx)
+	{
+		c->rx++;
+	}
+	else
+	{
+		c->tx++;
+		c->eventTx++;
+	}
+	if(frame->hasRssi)
+	{
+		c->rssiSum += frame->rssi;
+		c->rssiCount++;
+		c->rssiMin = (frame->rssi < c->rssiMin) ? frame->rssi : c->rssiMin;
+		c->rssiMax = (frame->rssi > c->rssiMax) ? frame->rssi : c->rssiMax;
+	}
+	if(frame->aborted)
+	{
+		c->aborted++;
+		return;
+	}
+	if(frame->crcError)
+	{
+		c->crcErrors++;
+		c->eventCrc++;
+		c->resend = true;
+		return;
+	}
+
+	/* Same SN as the last frame sent this way, the peer did not take it */
+	if((frame->rx && c->resend) || (c->snSeen[way] && (frame->header & PTI_BLE_SN) == c->sn[way]))
+	{
+		retransmit = true;
+		c->eventRetransmit++;
+		if(frame->rx)
+		{
+			c->retransmitRx++;
+		}
+		else
+		{
+			c->retransmitTx++;
+		}
+	}
+	c->snSeen[way] = true;
+	c->sn[way] = frame->header & PTI_BLE_SN;
+	if(frame->rx)
+	{
+		c->resend = false;
+	}
+
+	if(frame->length == 0)
+	{
+		c->empty++;
+	}
+	else if(!retransmit)
+	{
+		c->newBytes += frame->length;
+	}
+}
+
+static void frameRead(Frame_t *frame)
+{
+	Conn_t *c;
+
+	frame->start = (frame->end > frame->airtime * 1000ull) ? frame->end - frame->airtime * 1000ull : 0;
+	if(frame->aa == PTI_BLE_ADV_AA)
+	{
+		advFrames++;
+		advCrcErrors += frame->crcError;
+		advAirtime += frame->airtime;
+		return;
+	}
+	c = connection(frame->aa);
+	if(!c)
+	{
+		connOverflow++;
+		return;
+	}
+	connectionFrame(c, frame);
+}
+
+/**************************************************************************//**
+* @brief One debug channel record at buffer[head]
+* @return Bytes taken, 0 if it is not a record
+*****************************************************************************/
+static uint32_t readRecord(void)
+{
+	const uint8_t *p = buffer + head;
+	uint32_t len;
+	uint32_t header;
+	uint16_t version;
+	uint16_t type;
+	uint64_t time;
+	Frame_t frame;
+
+	if(ready(5) < 5 || p[0] != PTI_DCH_START)
+	{
+		return 0;
+	}
+	len = le16(p + 1);
+	version = le16(p + 3);
+	if(version == 2)
+	{
+		header = PTI_DCH_V2_HEADER;
+	}
+	else if(version == 3)
+	{
+		header = PTI_DCH_V3_HEADER;
+	}
+	else
+	{
+		return 0;
+	}
+	if(len < header || len > header + PTI_DCH_MAX || ready(len + 4) < len + 4)
+	{
+		return 0;
+	}
+	p = buffer + head;
+	if(p[3 + len] != PTI_DCH_END)
+	{
+		return 0;
+	}
+
+	if(version == 2)
+	{
+		time = le48(p + 5) * 1000;
+		type = le16(p + 11);
+	}
+	else
+	{
+		time = le64(p + 5);
+		type = le16(p + 13);
+	}
+	records++;
+	if(type != PTI_DCH_TYPE_PTI)
+	{
+		otherRecords++;
+	}
+	else if(parseFrame(p + 3 + header, len - header, &frame))
+	{
+		frame.end = time;
+		frameRead(&frame);
+	}
+	else
+	{
+		badFrames++;
+	}
+	return len + 4;
+}
+
+/**************************************************************************//**
+* @brief One bare PTI frame at buffer[head]. The end marker is found from the
+* PDU length and the count of appended bytes in front of it
+* @return Bytes taken, 0 if it is not a frame
+*****************************************************************************/
+static uint32_t readRaw(void)
+{
+	const uint8_t *p = buffer + head;
+	uint32_t ota;
+
+	if(ready(7) < 7 || (p[0] != PTI_RX_START && p[0] != PTI_TX_START))
+	{
+		return 0;
+	}
+	ota = 4 + 2 + p[6] + 3;
+	ready(1 + ota + 7);
+	p = buffer + head;
+	for(uint32_t k = 3; k <= 7 && 1 + ota + k <= tail - head; k++)
+	{
+		uint32_t len = 1 + ota + k;
+		Frame_t frame;
+
+		if(PTI_CFG_LENGTH(p[len - 2]) == k - 2 && parseFrame(p, len, &frame))
+		{
+			frame.end = 0;
+			frameRead(&frame);
+			return len;
+		}
+	}
+	return 0;
+}
+
+static void percent(const char *name, uint64_t part, uint64_t whole)
+{
+	printf(" %s %.1f%%", name, whole ? 100.0 * part / whole : 0.0);
+}
+
+static void report(const Conn_t *c)
+{
+	uint64_t span = c->last - c->first;
+	uint32_t channels = 0;
+
+	for(uint8_t ch = 0; ch < 64; ch++)
+	{
+		channels += (c->channels >> ch) & 1;
+	}
+
+	printf("connection %08x\n", c->aa);
+	printf("  frames %llu, tx %llu, rx %llu, empty %llu, PHY", (unsigned long long)c->frames,
+			(unsigned long long)c->tx, (unsigned long long)c->rx, (unsigned long long)c->empty);
+	for(uint8_t phy = 0; phy < 4; phy++)
+	{
+		if(c->phy[phy])
+		{
+			printf(" %s %llu", phyNames[phy], (unsigned long long)c->phy[phy]);
+		}
+	}
+	printf(", %u channels\n", channels);
+
+	printf("  events %llu, frames per event mean %.2f most %u:", (unsigned long long)c->events,
+			c->events ? (double)c->frames / c->events : 0.0, c->mostPerEvent);
+	for(uint32_t i = 1; i < EVENT_BUCKETS; i++)
+	{
+		if(c->perEvent[i])
+		{
+			printf(" %u%s x%llu", i, (i == EVENT_BUCKETS - 1) ? "+" : "", (unsigned long long)c->perEvent[i]);
+		}
+	}
+	printf("\n");
+
+	printf("  retransmissions tx %llu (%.2f%%), rx %llu (%.2f%%), CRC errors", (unsigned long long)c->retransmitTx,
+			c->tx ? 100.0 * c->retransmitTx / c->tx : 0.0, (unsigned long long)c->retransmitRx,
+			c->rx ? 100.0 * c->retransmitRx / c->rx : 0.0);
+	printf(" %llu, aborted %llu\n", (unsigned long long)c->crcErrors, (unsigned long long)c->aborted);
+
+	if(c->rssiCount)
+	{
+		printf("  RSSI %d / %.1f / %d dBm\n", c->rssiMin, (double)c->rssiSum / c->rssiCount, c->rssiMax);
+	}
+	if(!timed)
+	{
+		printf("  new data %llu bytes, airtime %.3f s\n", (unsigned long long)c->newBytes, c->airtime / 1e9);
+		return;
+	}
+	printf("  new data %llu bytes over %.3f s, %.1f kbit/s, mean interval %.3f ms\n", (unsigned long long)c->newBytes,
+			span / 1e9, span ? c->newBytes * 8e6 / span : 0.0, (c->events > 1) ? (c->eventStart - c->first) / 1e6 / (c->events - 1) : 0.0);
+	printf("  time:");
+	percent("airtime", c->airtime, span);
+	percent("T_IFS", c->ifs, span);
+	percent("turnaround", c->turnaround, span);
+	percent("idle", c->idle, span);
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	bool raw = false;
+	int opt;
+
+	while((opt = getopt(argc, argv, "re:")) != -1)
+	{
+		switch(opt)
+		{
+		case 'r':
+			raw = true;
+			break;
+		case 'e':
+			if(!(events = fopen(optarg, "w")))
+			{
+				perror(optarg);
+				return 1;
+			}
+			fprintf(events, "aa,event,start_us,channel,phy,frames,tx,rx,retransmissions,crc_errors,airtime_us,duration_us,idle_before_us\n");
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-r] [-e events.csv] [capture]\n", argv[0]);
+			return 1;
+		}
+	}
+	in = stdin;
+	if(optind < argc && !(in = fopen(argv[optind], "rb")))
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	timed = !raw;
+
+	while(ready(1))
+	{
+		uint32_t taken = raw ? readRaw() : readRecord();
+
+		if(taken)
+		{
+			consume(taken);
+		}
+		else
+		{
+			/* Not a record or frame here, resync on the next byte */
+			consume(1);
+			skipped++;
+		}
+	}
+
+	for(uint32_t i = 0; i < connCount; i++)
+	{
+		closeEvent(&conns[i]);
+	}
+	printf("%llu bytes, %llu records, %llu not PTI, %llu bytes skipped, %llu bad frames, %llu not Bluetooth LE\n",
+			(unsigned long long)offset, (unsigned long long)records, (unsigned long long)otherRecords,
+			(unsigned long long)skipped, (unsigned long long)badFrames, (unsigned long long)otherProtocol);
+	printf("advertising %llu frames, %llu CRC errors, airtime %.3f ms\n", (unsigned long long)advFrames,
+			(unsigned long long)advCrcErrors, advAirtime / 1000.0);
+	if(connOverflow)
+	{
+		printf("%llu frames of connections past the first %u not counted\n", (unsigned long long)connOverflow, MAX_CONNECTIONS);
+	}
+	for(uint32_t i = 0; i < connCount; i++)
+	{
+		report(&conns[i]);
+	}
+	if(events)
+	{
+		fclose(events);
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+/***************************************************************************//**
+ * @file
+ * @brief Layout of packet trace captures, shared by the host PTI tools
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef PTI_FORMAT_H_
+#define PTI_FORMAT_H_
+
+#include <stdint.h>
+
+/* pti.c sends every frame the radio handles out of the PTI pins, UART mode
+ * at HAL_PTI_BAUD_RATE. The UART stream carries no time, the debug adapter
+ * that reads it puts each frame in a debug channel record stamped with its
+ * own clock, and that is what gets recorded, e.g. from the adapter's port
+ * 4905. Both are read:
+ *
+ * Debug channel record, little endian:
+ *   '['  length(2)  version(2)  time  type(2)  [flags(4)  sequence(2)]  payload  ']'
+ *   version 2: time is 6 bytes of microseconds, then a 1 byte sequence
+ *   version 3: time is 8 bytes of nanoseconds, then flags and sequence
+ *   length counts from version to the end of the payload
+ *   type PTI_DCH_TYPE_PTI holds one PTI frame, other types are skipped
+ *
+ * PTI frame:
+ *   start(1)  over the air bytes  appended info  end(1)
+ *   over the air, for Bluetooth LE: access address(4) header(2) payload CRC(3)
+ *
+ * Appended info, in order, as these tools take it:
+ *   rssi(1)        received frames only, dBm, signed
+ *   config(1)      version 2 and up, PTI_PHY_* in bits 1..0
+ *   radio info(1)  RF channel in bits 5..0
+ *   status(1)      protocol in bits 7..4, error in bits 3..0, not 0 for a
+ *                  frame received with a bad CRC
+ *   cfg(1)         received in bit 6, version in bits 5..3, bytes before
+ *                  it in bits 2..0
+ *
+ * An abort end marker is a frame the radio gave up on part way, the over
+ * the air bytes may be short. The time of a record is taken as the end of
+ * the frame over the air, the adapter stamps it once the end byte is
+ * through. */
+
+#define PTI_RX_START			0xF8
+#define PTI_RX_END				0xF9
+#define PTI_RX_ABORT			0xFA
+#define PTI_TX_START			0xFC
+#define PTI_TX_END				0xFD
+#define PTI_TX_ABORT			0xFE
+
+#define PTI_PROTOCOL_BLE		3
+#define PTI_CFG_RX				0x40
+#define PTI_CFG_VERSION(cfg)	(((cfg) >> 3) & 7)
+#define PTI_CFG_LENGTH(cfg)		((cfg) & 7)
+#define PTI_STATUS_PROTOCOL(s)	((s) >> 4)
+#define PTI_STATUS_ERROR(s)		((s) & 0x0F)
+
+#define PTI_PHY_1M				0
+#define PTI_PHY_2M				1
+#define PTI_PHY_S8				2
+#define PTI_PHY_S2				3
+
+#define PTI_DCH_START			'['
+#define PTI_DCH_END				']'
+#define PTI_DCH_TYPE_PTI		0x0029
+#define PTI_DCH_V2_HEADER		11			// Version to sequence
+#define PTI_DCH_V3_HEADER		18
+#define PTI_DCH_MAX				300			// Longest payload read, a BLE frame is 4 + 2 + 255 + 3 bytes and at most 7 around it
+
+#define PTI_BLE_ADV_AA			0x8E89BED6u
+#define PTI_BLE_LLID_EMPTY		1			// Header byte 0: LLID in bits 1..0, NESN bit 2, SN bit 3, MD bit 4
+#define PTI_BLE_SN				0x08
+#define PTI_BLE_NESN			0x04
+#define PTI_BLE_MD				0x10
+#define PTI_BLE_T_IFS_NS		150000u
+
+/* Time on air of a Bluetooth LE frame with a payload of length bytes, in
+ * microseconds. The coded PHY sends the access address, CI and TERM1 at S8
+ * whatever the coding of the rest */
+static inline uint32_t PTI_BleAirtimeUs(uint8_t phy, uint32_t length)
+{
+	switch(phy)
+	{
+	case PTI_PHY_2M:
+		return (length + 11) * 4;
+	case PTI_PHY_S8:
+		return 720 + 64 * length;
+	case PTI_PHY_S2:
+		return 462 + 16 * length;
+	default:
+		return (length + 10) * 8;
+	}
+}
+
+#endif
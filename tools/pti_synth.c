@@ -0,0 +1,291 @@
+/***************************************************************************//**
+ * @file
+ * @brief Synthetic packet trace capture for pti_decode
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Writes the capture a master running a throughput test would give, laid
+ * out as in pti_format.h, and prints what pti_decode should make of it.
+ *
+ *  - Advertising frames on channel 37 at 1M, in version 2 records.
+ *  - A connection at 2M, 15 ms interval, hopping over the data channels.
+ *    Each event the master sends 244 bytes per frame and the slave answers
+ *    with empty PDUs, FRAMES_PER_EVENT frames each way.
+ *  - Every 25th event the slave does not take one frame, the master sends it
+ *    again. Every 40th event a slave frame is received with a bad CRC, the
+ *    slave sends it again. Every 10th event the slave answers 20 us late.
+ *  - Records of another type and bytes that are not records between them.
+ *
+ * The bare UART stream, -r, is the frames alone, without records or time.
+ *
+ * Build:  gcc -O2 -Wall -Itools -o pti_synth tools/pti_synth.c
+ * Usage:  pti_synth [-r] <capture> [events]
+ *         e.g. pti_synth cap.bin 100000 && pti_decode cap.bin
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pti_format.h"
+
+#define CONN_AA				0x50654C39u
+#define INTERVAL_NS			15000000ull
+#define FRAMES_PER_EVENT	4
+#define DATA_LENGTH			244
+#define ADV_FRAMES			30
+
+static FILE *out;
+static bool raw;
+static uint16_t sequence;
+
+static uint64_t frames;
+static uint64_t tx;
+static uint64_t rx;
+static uint64_t retransmitTx;
+static uint64_t retransmitRx;
+static uint64_t crcErrors;
+static uint64_t empty;
+static uint64_t newBytes;
+static uint64_t airtime;
+static uint64_t ifs;
+static uint64_t turnaround;
+static uint64_t idle;
+static uint64_t first;
+static uint64_t last;
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, (uint16_t)v);
+	put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void record(uint8_t version, uint16_t type, uint64_t timeNs, const uint8_t *payload, uint32_t len)
+{
+	uint8_t r[4 + PTI_DCH_V3_HEADER + PTI_DCH_MAX];
+	uint32_t header = (version == 2) ? PTI_DCH_V2_HEADER : PTI_DCH_V3_HEADER;
+
+	r[0] = PTI_DCH_START;
+	put16(r + 1, (uint16_t)(header + len));
+	put16(r + 3, version);
+	if(version == 2)
+	{
+		uint64_t us = timeNs / 1000;
+
+		put32(r + 5, (uint32_t)us);
+		put16(r + 9, (uint16_t)(us >> 32));
+		put16(r + 11, type);
+		r[13] = (uint8_t)sequence;
+	}
+	else
+	{
+		put32(r + 5, (uint32_t)timeNs);
+		put32(r + 9, (uint32_t)(timeNs >> 32));
+		put16(r + 13, type);
+		put32(r + 15, 0);
+		put16(r + 19, sequence);
+	}
+	sequence++;
+	memcpy(r + 3 + header, payload, len);
+	r[3 + header + len] = PTI_DCH_END;
+	fwrite(r, 1, 4 + header + len, out);
+}
+
+/**************************************************************************//**
+* @brief Writes one frame ending at endNs
+*****************************************************************************/
+static void frame(uint8_t version, bool received, uint32_t aa, uint8_t header, uint8_t length, uint8_t phy,
+		uint8_t channel, bool crcError, uint64_t endNs)
+{
+	uint8_t f[1 + 4 + 2 + 255 + 3 + 7];
+	uint32_t n = 0;
+	uint8_t appended = 2 + received + 1;
+
+	f[n++] = received ? PTI_RX_START : PTI_TX_START;
+	put32(f + n, aa);
+	n += 4;
+	f[n++] = header;
+	f[n++] = length;
+	for(uint32_t i = 0; i < length; i++)
+	{
+		f[n++] = (uint8_t)(i * 7);
+	}
+	f[n++] = 0x55;
+	f[n++] = 0x55;
+	f[n++] = 0x55;
+	if(received)
+	{
+		f[n++] = (uint8_t)(int8_t)(-50 - (channel % 20));
+	}
+	f[n++] = phy;
+	f[n++] = channel;
+	f[n++] = (PTI_PROTOCOL_BLE << 4) | (crcError ? 1 : 0);
+	f[n++] = (received ? PTI_CFG_RX : 0) | (2 << 3) | appended;
+	f[n++] = received ? PTI_RX_END : PTI_TX_END;
+
+	if(raw)
+	{
+		fwrite(f, 1, n, out);
+	}
+	else
+	{
+		record(version, PTI_DCH_TYPE_PTI, endNs, f, n);
+	}
+}
+
+static void noise(uint32_t event)
+{
+	static const uint8_t junk[] = { '[', 0xff, 0xff, 0x03, 0x00, ']', PTI_TX_START, 0x39, '[', 0x05, 0x00, 0x09 };
+	uint8_t other[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	if(event % 50 == 0)
+	{
+		fwrite(junk, 1, sizeof(junk), out);
+		if(!raw)
+		{
+			record(3, 0x0001, 0, other, sizeof(other));
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count;
+	uint64_t t = 1000000000ull;
+	uint64_t eventEnd = 0;
+	uint8_t snMaster = 0;
+	uint8_t snSlave = 0;
+
+	if(argc > 1 && strcmp(argv[1], "-r") == 0)
+	{
+		raw = true;
+		argc--;
+		argv++;
+	}
+	if(argc < 2 || !(out = fopen(argv[1], "wb")))
+	{
+		fprintf(stderr, "usage: pti_synth [-r] <capture> [events]\n");
+		return 1;
+	}
+	count = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1000;
+
+	for(uint32_t i = 0; i < ADV_FRAMES; i++)
+	{
+		frame(2, true, PTI_BLE_ADV_AA, 0x00, 20, PTI_PHY_1M, 0, false, t + i * 1000000ull);
+	}
+
+	for(uint32_t event = 0; event < count; event++)
+	{
+		uint64_t start = t + 100000000ull + event * INTERVAL_NS;
+		uint8_t index = (event * 7) % 37;
+		uint8_t channel = (index <= 10) ? index + 1 : index + 2;
+		uint64_t now = start;
+		bool nack = (event % 25 == 3);
+		bool crc = (event % 40 == 7);
+		bool late = (event % 10 == 9);
+
+		noise(event);
+		if(event == 0)
+		{
+			first = start;
+		}
+		else
+		{
+			idle += start - eventEnd;
+		}
+
+		for(uint32_t i = 0; i < FRAMES_PER_EVENT; i++)
+		{
+			uint32_t mt = PTI_BleAirtimeUs(PTI_PHY_2M, DATA_LENGTH) * 1000;
+			uint32_t st = PTI_BleAirtimeUs(PTI_PHY_2M, 0) * 1000;
+			bool masterAgain = nack && i == 2;	// Slave did not take frame 1
+			bool slaveBad = crc && i == 1;
+			bool slaveAgain = crc && i == 2;	// Master did not take frame 1
+
+			if(i > 0)
+			{
+				now += PTI_BLE_T_IFS_NS;
+				ifs += PTI_BLE_T_IFS_NS;
+			}
+			if(masterAgain)
+			{
+				snMaster ^= PTI_BLE_SN;
+				retransmitTx++;
+			}
+			else
+			{
+				newBytes += DATA_LENGTH;
+			}
+			now += mt;
+			frame(3, false, CONN_AA, 0x02 | snMaster | PTI_BLE_MD, DATA_LENGTH, PTI_PHY_2M, channel, false, now);
+			snMaster ^= PTI_BLE_SN;
+			tx++;
+
+			now += PTI_BLE_T_IFS_NS;
+			ifs += PTI_BLE_T_IFS_NS;
+			if(late)
+			{
+				now += 20000;
+				turnaround += 20000;
+			}
+			if(slaveAgain)
+			{
+				snSlave ^= PTI_BLE_SN;
+				retransmitRx++;
+			}
+			now += st;
+			frame(3, true, CONN_AA, PTI_BLE_LLID_EMPTY | snSlave, 0, PTI_PHY_2M, channel, slaveBad, now);
+			snSlave ^= PTI_BLE_SN;
+			rx++;
+			if(slaveBad)
+			{
+				crcErrors++;
+			}
+			else
+			{
+				empty++;
+			}
+			airtime += mt + st;
+			frames += 2;
+		}
+		eventEnd = now;
+		last = now;
+	}
+	fclose(out);
+
+	printf("expected: advertising %u frames\n", ADV_FRAMES);
+	printf("expected: connection %08x, frames %llu, tx %llu, rx %llu, empty %llu, events %u of %u frames\n", CONN_AA,
+			(unsigned long long)frames, (unsigned long long)tx, (unsigned long long)rx, (unsigned long long)empty,
+			count, 2 * FRAMES_PER_EVENT);
+	printf("expected: retransmissions tx %llu, rx %llu, CRC errors %llu, new data %llu bytes\n",
+			(unsigned long long)retransmitTx, (unsigned long long)retransmitRx, (unsigned long long)crcErrors,
+			(unsigned long long)newBytes);
+	if(!raw)
+	{
+		uint64_t span = last - first;
+
+		printf("expected: %.3f s, %.1f kbit/s, time: airtime %.1f%% T_IFS %.1f%% turnaround %.1f%% idle %.1f%%\n",
+				span / 1e9, newBytes * 8e6 / span, 100.0 * airtime / span, 100.0 * ifs / span,
+				100.0 * turnaround / span, 100.0 * idle / span);
+	}
+	return 0;
+}
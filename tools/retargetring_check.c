@@ -0,0 +1,280 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the retarget TX ring
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Checks retargetring.c the way retargetserial.c drives it: the edges of
+ * the buffer and of the free running counters, RETARGET_RingPeek() handing
+ * out contiguous runs the LDMA can take, LF to CRLF with a line ending
+ * never split, the high water mark. Then a producer and a consumer taking
+ * random turns, the consumer draining partial runs the way a transfer
+ * does, against a plain reference queue.
+ *
+ * Build:  gcc -O2 -Wall -I. -Ihardware/kit/common/drivers -o retargetring_check
+ *           tools/retargetring_check.c hardware/kit/common/drivers/retargetring.c
+ * Usage:  retargetring_check [random turns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "retargetring.h"
+
+#define SIZE			16
+#define BIG_SIZE		1024		// TXBUFSIZE of retargetserial.c
+#define REFERENCE_SIZE	(1u << 20)
+
+static uint32_t failures;
+static RETARGET_Ring_t ring;
+static uint8_t buf[BIG_SIZE];
+
+static uint8_t reference[REFERENCE_SIZE];	// What should come out, in order
+static uint32_t referencePut;
+static uint32_t referenceGet;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+/* Drains n bytes through peek and consume, into out */
+static uint32_t drain(uint8_t *out, uint32_t n)
+{
+	uint32_t taken = 0;
+
+	while(taken < n)
+	{
+		uint8_t *data;
+		uint32_t len = RETARGET_RingPeek(&ring, &data);
+
+		if(len == 0)
+		{
+			break;
+		}
+		len = (len > n - taken) ? n - taken : len;
+		memcpy(&out[taken], data, len);
+		RETARGET_RingConsume(&ring, len);
+		taken += len;
+	}
+	return taken;
+}
+
+static void wrap(void)
+{
+	uint8_t out[SIZE];
+	uint8_t *data;
+
+	RETARGET_RingInit(&ring, buf, SIZE);
+	expect("empty used", RETARGET_RingUsed(&ring), 0);
+	expect("empty free", RETARGET_RingFree(&ring), SIZE);
+	expect("empty peek", RETARGET_RingPeek(&ring, &data), 0);
+
+	/* Fill to the brim, one more is refused */
+	expect("fill", RETARGET_RingWrite(&ring, "0123456789abcdef", SIZE, false), SIZE);
+	expect("full free", RETARGET_RingFree(&ring), 0);
+	expect("full refused", RETARGET_RingWrite(&ring, "x", 1, false), 0);
+	expect("full peek", RETARGET_RingPeek(&ring, &data), SIZE);
+	expect("full peek start", data == buf, 1);
+
+	/* Take 10, write 8 across the end: the run stops at the end of the buffer */
+	expect("take", drain(out, 10), 10);
+	expect("take bytes", memcmp(out, "0123456789", 10), 0);
+	expect("across", RETARGET_RingWrite(&ring, "ABCDEFGH", 8, false), 8);
+	expect("across used", RETARGET_RingUsed(&ring), 14);
+	expect("run to end", RETARGET_RingPeek(&ring, &data), 6);
+	expect("run to end start", data == &buf[10], 1);
+	RETARGET_RingConsume(&ring, 6);
+	expect("run after wrap", RETARGET_RingPeek(&ring, &data), 8);
+	expect("run after wrap start", data == buf, 1);
+	expect("run after wrap bytes", memcmp(data, "ABCDEFGH", 8), 0);
+	RETARGET_RingConsume(&ring, 8);
+	expect("drained", RETARGET_RingUsed(&ring), 0);
+
+	/* The free running counters wrapping past 2^32 */
+	RETARGET_RingInit(&ring, buf, SIZE);
+	ring.put = 0xFFFFFFF8u;
+	ring.get = 0xFFFFFFF8u;
+	expect("counter wrap write", RETARGET_RingWrite(&ring, "0123456789ab", 12, false), 12);
+	expect("counter wrap used", RETARGET_RingUsed(&ring), 12);
+	expect("counter wrap free", RETARGET_RingFree(&ring), SIZE - 12);
+	expect("counter wrap drain", drain(out, SIZE), 12);
+	expect("counter wrap bytes", memcmp(out, "0123456789ab", 12), 0);
+}
+
+static void crlf(void)
+{
+	uint8_t out[SIZE];
+
+	RETARGET_RingInit(&ring, buf, SIZE);
+	expect("crlf line", RETARGET_RingWrite(&ring, "ab\ncd\n", 6, true), 6);
+	expect("crlf used", RETARGET_RingUsed(&ring), 8);
+	expect("crlf drain", drain(out, SIZE), 8);
+	expect("crlf bytes", memcmp(out, "ab\r\ncd\r\n", 8), 0);
+
+	/* Off, a line feed is a byte like any other */
+	expect("raw line", RETARGET_RingWrite(&ring, "a\n", 2, false), 2);
+	expect("raw used", RETARGET_RingUsed(&ring), 2);
+	drain(out, SIZE);
+
+	/* One byte free: the pair is refused whole and nothing after it goes */
+	expect("one free", RETARGET_RingWrite(&ring, "0123456789abcde", 15, true), 15);
+	expect("pair refused", RETARGET_RingWrite(&ring, "\nz", 2, true), 0);
+	expect("pair refused used", RETARGET_RingUsed(&ring), 15);
+	expect("byte still fits", RETARGET_RingWrite(&ring, "z\n", 2, true), 1);
+	expect("full", RETARGET_RingFree(&ring), 0);
+	drain(out, SIZE);
+
+	/* Two free: the pair goes, split across the end of the buffer */
+	RETARGET_RingInit(&ring, buf, SIZE);
+	RETARGET_RingWrite(&ring, "0123456789abcde", 15, false);
+	drain(out, 15);
+	expect("split pair", RETARGET_RingWrite(&ring, "\n", 1, true), 1);
+	expect("split pair used", RETARGET_RingUsed(&ring), 2);
+	expect("split pair drain", drain(out, SIZE), 2);
+	expect("split pair bytes", memcmp(out, "\r\n", 2), 0);
+}
+
+static void highWater(void)
+{
+	uint8_t out[SIZE];
+
+	RETARGET_RingInit(&ring, buf, SIZE);
+	expect("high water start", ring.highWater, 0);
+	RETARGET_RingWrite(&ring, "0123456", 7, false);
+	expect("high water 7", ring.highWater, 7);
+	drain(out, 5);
+	RETARGET_RingWrite(&ring, "01", 2, false);
+	expect("high water kept", ring.highWater, 7);
+	RETARGET_RingWrite(&ring, "\n\n\n", 3, true);
+	expect("high water crlf", ring.highWater, 10);
+	RETARGET_RingWrite(&ring, "0123456789", 10, false);
+	expect("high water full", ring.highWater, SIZE);
+	expect("high water refused", RETARGET_RingWrite(&ring, "x", 1, false), 0);
+	expect("high water at size", ring.highWater, SIZE);
+}
+
+static void produce(uint32_t size)
+{
+	char chunk[64];
+	uint32_t len = rand() % sizeof(chunk);
+	bool lfToCrLf = rand() % 2;
+	int taken;
+
+	for(uint32_t i = 0; i < len; i++)
+	{
+		chunk[i] = (rand() % 5 == 0) ? '\n' : (char)('a' + rand() % 26);
+	}
+	taken = RETARGET_RingWrite(&ring, chunk, (int)len, lfToCrLf);
+
+	/* What the reference says fits, a pair only whole */
+	uint32_t free = size - (referencePut - referenceGet);
+	uint32_t expected = 0;
+
+	for(; expected < len; expected++)
+	{
+		uint32_t need = (lfToCrLf && chunk[expected] == '\n') ? 2 : 1;
+
+		if(need > free)
+		{
+			break;
+		}
+		if(need == 2)
+		{
+			reference[referencePut++ % REFERENCE_SIZE] = '\r';
+		}
+		reference[referencePut++ % REFERENCE_SIZE] = (uint8_t)chunk[expected];
+		free -= need;
+	}
+	expect("random taken", (uint32_t)taken, expected);
+}
+
+static void consume(uint32_t size)
+{
+	uint8_t *data;
+	uint32_t len = RETARGET_RingPeek(&ring, &data);
+	uint32_t index = ring.get & (size - 1);
+
+	/* A run never goes past the end of the buffer nor past the data */
+	expect("random run start", (uint32_t)(data - buf), index);
+	expect("random run length", len, ((referencePut - referenceGet) < size - index) ? referencePut - referenceGet : size - index);
+
+	/* A transfer may stop short, as a capped LDMA one does */
+	len = (len && rand() % 3 == 0) ? 1 + rand() % len : len;
+	for(uint32_t i = 0; i < len; i++)
+	{
+		if(data[i] != reference[referenceGet % REFERENCE_SIZE])
+		{
+			failures++;
+			printf("FAIL: random byte %u\n", referenceGet);
+			break;
+		}
+		referenceGet++;
+	}
+	RETARGET_RingConsume(&ring, len);
+}
+
+static void interleaved(uint32_t turns)
+{
+	static const uint32_t sizes[] = { 4, SIZE, 256, BIG_SIZE };
+
+	srand(9);
+	for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		uint32_t highest = 0;
+
+		RETARGET_RingInit(&ring, buf, sizes[s]);
+		/* Start near the top of the counters, they wrap on the way */
+		ring.put = ring.get = 0u - sizes[s] * 37;
+		referencePut = referenceGet = 0;
+
+		for(uint32_t t = 0; t < turns; t++)
+		{
+			if(rand() % 2)
+			{
+				produce(sizes[s]);
+			}
+			else
+			{
+				consume(sizes[s]);
+			}
+			expect("random used", RETARGET_RingUsed(&ring), referencePut - referenceGet);
+			expect("random free", RETARGET_RingFree(&ring), sizes[s] - (referencePut - referenceGet));
+			highest = (referencePut - referenceGet > highest) ? referencePut - referenceGet : highest;
+			expect("random high water", ring.highWater, highest);
+			if(failures > 20)
+			{
+				return;
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t turns = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+
+	wrap();
+	crlf();
+	highWater();
+	interleaved(turns);
+	printf("retargetring checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,295 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the sample statistics and the quantile sketch
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Checks SAMPLESTATS_Reduce() against a plain loop on random blocks of every
+ * length up to a few blocks, extremes included, then series of several
+ * shapes against the exact figures: count, minimum and maximum equal, mean
+ * and standard deviation close, p95 and p99 within a rank band of the
+ * sorted samples. Built twice, once for each path of SAMPLESTATS_Reduce():
+ *
+ * Build:  gcc -O2 -Wall -I. -o samplestats_check tools/samplestats_check.c samplestats.c -lm
+ *         gcc -O2 -Wall -I. -Itools -DSAMPLESTATS_HOST_MODEL -o samplestats_check_simd
+ *           tools/samplestats_check.c samplestats.c -lm
+ * Usage:  samplestats_check [random blocks]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "samplestats.h"
+
+#define SAMPLES		20000
+
+static uint32_t failures;
+static int16_t samples[SAMPLES];
+static int16_t sorted[SAMPLES];
+
+static void expect(const char *what, int64_t got, int64_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %lld instead of %lld\n", what, (long long)got, (long long)expected);
+	}
+}
+
+static void expectClose(const char *what, double got, double expected, double within)
+{
+	if(fabs(got - expected) > within)
+	{
+		failures++;
+		printf("FAIL: %s, %f instead of %f\n", what, got, expected);
+	}
+}
+
+static int16_t randomSample(void)
+{
+	return (int16_t)(rand() & 0xFFFF);
+}
+
+static void blocks(uint32_t count)
+{
+	int16_t block[3 * SAMPLESTATS_BLOCK + 1];
+	SAMPLESTATS_Moments_t m;
+
+	srand(7);
+	for(uint32_t r = 0; r < count; r++)
+	{
+		uint32_t n = rand() % (sizeof(block) / sizeof(block[0]) + 1);
+		int64_t sum = 0;
+		uint64_t squares = 0;
+		int16_t min = INT16_MAX;
+		int16_t max = INT16_MIN;
+
+		for(uint32_t i = 0; i < n; i++)
+		{
+			switch(rand() % 8)
+			{
+			case 0:
+				block[i] = INT16_MIN;
+				break;
+			case 1:
+				block[i] = INT16_MAX;
+				break;
+			case 2:
+				block[i] = (int16_t)(rand() % 200 - 100);
+				break;
+			default:
+				block[i] = randomSample();
+				break;
+			}
+			sum += block[i];
+			squares += (uint64_t)((int64_t)block[i] * block[i]);
+			min = (block[i] < min) ? block[i] : min;
+			max = (block[i] > max) ? block[i] : max;
+		}
+
+		SAMPLESTATS_Reduce(block, n, &m);
+		expect("block sum", m.sum, sum);
+		expect("block squares", (int64_t)m.squares, (int64_t)squares);
+		expect("block min", m.min, min);
+		expect("block max", m.max, max);
+	}
+}
+
+static int compare(const void *a, const void *b)
+{
+	return *(const int16_t *)a - *(const int16_t *)b;
+}
+
+/* The estimate has to lie between the exact quantiles a band either side,
+ * give or take half a unit, the samples being whole numbers */
+static void expectQuantile(const char *what, float estimate, double q, double band, uint32_t n)
+{
+	int32_t low = (int32_t)ceil((q - band) * n) - 1;
+	int32_t high = (int32_t)ceil((q + band) * n) - 1;
+
+	low = (low < 0) ? 0 : low;
+	high = (high > (int32_t)n - 1) ? (int32_t)n - 1 : high;
+	if(estimate < sorted[low] - 0.5f || estimate > sorted[high] + 0.5f)
+	{
+		failures++;
+		printf("FAIL: %s, %.2f not in %d..%d\n", what, estimate, sorted[low], sorted[high]);
+	}
+}
+
+static void series(const char *name, uint32_t n)
+{
+	SAMPLESTATS_Series_t s;
+	SAMPLESTATS_Summary_t summary;
+	double mean = 0;
+	double variance = 0;
+	char what[64];
+
+	SAMPLESTATS_Reset(&s);
+	for(uint32_t i = 0; i < n; i++)
+	{
+		SAMPLESTATS_Add(&s, samples[i]);
+		mean += samples[i];
+	}
+	mean /= n;
+	for(uint32_t i = 0; i < n; i++)
+	{
+		variance += (samples[i] - mean) * (samples[i] - mean);
+	}
+	variance = (n > 1) ? variance / (n - 1) : 0;
+	memcpy(sorted, samples, n * sizeof(samples[0]));
+	qsort(sorted, n, sizeof(sorted[0]), compare);
+
+	SAMPLESTATS_Get(&s, &summary);
+	snprintf(what, sizeof(what), "%s count", name);
+	expect(what, summary.count, n);
+	snprintf(what, sizeof(what), "%s min", name);
+	expect(what, summary.min, sorted[0]);
+	snprintf(what, sizeof(what), "%s max", name);
+	expect(what, summary.max, sorted[n - 1]);
+	snprintf(what, sizeof(what), "%s mean", name);
+	expectClose(what, summary.mean, mean, 1e-3 + fabs(mean) * 1e-6);
+	snprintf(what, sizeof(what), "%s std", name);
+	expectClose(what, summary.std, sqrt(variance), 1e-3 + sqrt(variance) * 1e-5);
+
+	if(n <= SAMPLESTATS_MARKERS)
+	{
+		/* Exact, the nearest rank */
+		snprintf(what, sizeof(what), "%s few p95", name);
+		expect(what, (int64_t)summary.p95, sorted[(uint32_t)ceil(0.95 * n) - 1]);
+		snprintf(what, sizeof(what), "%s few p99", name);
+		expect(what, (int64_t)summary.p99, sorted[(uint32_t)ceil(0.99 * n) - 1]);
+		return;
+	}
+	snprintf(what, sizeof(what), "%s p95", name);
+	expectQuantile(what, summary.p95, 0.95, 0.01, n);
+	snprintf(what, sizeof(what), "%s p99", name);
+	expectQuantile(what, summary.p99, 0.99, 0.005, n);
+	printf("%-10s n %5u  mean %8.2f  std %8.2f  min %6d  max %6d  p95 %8.2f (exact %6d)  p99 %8.2f (exact %6d)\n",
+			name, n, summary.mean, summary.std, summary.min, summary.max,
+			summary.p95, sorted[(uint32_t)ceil(0.95 * n) - 1], summary.p99, sorted[(uint32_t)ceil(0.99 * n) - 1]);
+}
+
+static double uniform(void)
+{
+	return (rand() + 0.5) / ((double)RAND_MAX + 1);
+}
+
+static void shapes(void)
+{
+	/* RSSI: about normal around -62 dBm, whole dBm */
+	srand(11);
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		double x = 0;
+
+		for(uint32_t k = 0; k < 12; k++)
+		{
+			x += uniform();
+		}
+		samples[i] = (int16_t)lround(-62 + (x - 6) * 5);
+	}
+	series("rssi", SAMPLES);
+
+	/* Throughput of one second windows in kbit/s: mostly near the link
+	 * rate, a long tail down to nothing when the link degrades */
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = (int16_t)((rand() % 10) ? 1300 - rand() % 60 : lround(1300 * uniform() * uniform()));
+	}
+	series("throughput", SAMPLES);
+
+	/* Denial rate in permille: zero most windows, bursts when WLAN is busy */
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = (int16_t)((rand() % 5) ? 0 : lround(-200 * log(uniform())));
+		samples[i] = (samples[i] > 1000) ? 1000 : samples[i];
+	}
+	series("denials", SAMPLES);
+
+	/* Heavy tail */
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = (int16_t)fmin(32767, lround(10 / pow(uniform(), 1.2)));
+	}
+	series("pareto", SAMPLES);
+
+	/* Ascending and descending, the worst order for the markers */
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = (int16_t)(i - SAMPLES / 2);
+	}
+	series("ascending", SAMPLES);
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = (int16_t)(SAMPLES / 2 - i);
+	}
+	series("descending", SAMPLES);
+
+	/* A short run, and one value only */
+	for(uint32_t i = 0; i < 300; i++)
+	{
+		samples[i] = (int16_t)(rand() % 30 - 80);
+	}
+	series("short", 300);
+	for(uint32_t i = 0; i < SAMPLES; i++)
+	{
+		samples[i] = -70;
+	}
+	series("constant", SAMPLES);
+
+	/* Up to five, exact */
+	for(uint32_t n = 1; n <= SAMPLESTATS_MARKERS; n++)
+	{
+		for(uint32_t i = 0; i < n; i++)
+		{
+			samples[i] = (int16_t)(rand() % 100);
+		}
+		series("few", n);
+	}
+}
+
+static void empty(void)
+{
+	SAMPLESTATS_Series_t s;
+	SAMPLESTATS_Summary_t summary;
+
+	SAMPLESTATS_Reset(&s);
+	SAMPLESTATS_Get(&s, &summary);
+	expect("empty count", summary.count, 0);
+	expect("empty p99", (int64_t)summary.p99, 0);
+	SAMPLESTATS_Add(&s, -55);
+	SAMPLESTATS_Get(&s, &summary);
+	expect("one std", (int64_t)summary.std, 0);
+	expect("one min", summary.min, -55);
+	expect("one p95", (int64_t)summary.p95, -55);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+
+#ifdef SAMPLESTATS_HOST_MODEL
+	printf("SIMD path, on the instruction model\n");
+#else
+	printf("plain path\n");
+#endif
+	blocks(count);
+	empty();
+	shapes();
+	printf("samplestats checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief The Cortex-M4 SIMD instructions samplestats.c uses, in plain C
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef SIMD_MODEL_H_
+#define SIMD_MODEL_H_
+
+#include <stdint.h>
+
+/* samplestats.c built with -DSAMPLESTATS_HOST_MODEL calls these instead of
+ * the intrinsics of cmsis_gcc.h. They follow the ARMv7-M reference manual,
+ * the GE flags __SEL() reads included: __SSUB16() sets the two low flags
+ * when the low halfword difference is not negative and the two high ones
+ * for the high halfword. */
+
+static uint32_t simdModelGe;				// APSR.GE, one bit a byte lane
+
+static inline int32_t simdModelLow(uint32_t x)
+{
+	return (int16_t)(x & 0xFFFF);
+}
+
+static inline int32_t simdModelHigh(uint32_t x)
+{
+	return (int16_t)(x >> 16);
+}
+
+static inline uint32_t __SMLAD(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+	return op3 + (uint32_t)(simdModelLow(op1) * simdModelLow(op2)) + (uint32_t)(simdModelHigh(op1) * simdModelHigh(op2));
+}
+
+static inline uint64_t __SMLALD(uint32_t op1, uint32_t op2, uint64_t acc)
+{
+	return acc + (uint64_t)((int64_t)simdModelLow(op1) * simdModelLow(op2) + (int64_t)simdModelHigh(op1) * simdModelHigh(op2));
+}
+
+static inline uint32_t __SSUB16(uint32_t op1, uint32_t op2)
+{
+	int32_t low = simdModelLow(op1) - simdModelLow(op2);
+	int32_t high = simdModelHigh(op1) - simdModelHigh(op2);
+
+	simdModelGe = ((low >= 0) ? 0x3 : 0) | ((high >= 0) ? 0xC : 0);
+	return ((uint32_t)high << 16) | ((uint32_t)low & 0xFFFF);
+}
+
+static inline uint32_t __SEL(uint32_t op1, uint32_t op2)
+{
+	uint32_t result = 0;
+
+	for(uint32_t lane = 0; lane < 4; lane++)
+	{
+		uint32_t mask = 0xFFu << (lane * 8);
+
+		result |= ((simdModelGe >> lane) & 1) ? (op1 & mask) : (op2 & mask);
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,715 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the serial to BLE bridge against a pseudo terminal
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* First uartbridge.c against a RAM ring and a made up clock: how packets
+ * are cut, a refusing stack, and the escape with every near miss of it.
+ *
+ * Then against a pseudo terminal. A child process is the serial device on
+ * the far side, it writes a known byte stream into the master end at about
+ * a baud rate. The UART stand-in is a thread that keeps emptying the slave
+ * end into a 256 byte ring as the LDMA does, losing the oldest bytes when
+ * the bridge falls behind, and reports the line idle after 2 ms without
+ * bytes. The stack stand-in takes packets into a queue of a few,
+ * emptied at a link rate. Time is the monotonic clock in RTCC ticks.
+ *
+ *   bursts		bursts of any length with gaps, a fast link. Every byte
+ *				comes out, in order, in full packets but for the end of
+ *				each burst.
+ *   slow		a steady stream faster than the link. The stack refuses,
+ *				the ring overruns. What comes out is the stream with the
+ *				lost bytes taken out, and the counts add up.
+ *   escape		data, a second of silence, +++, a second of silence. The
+ *				run ends with the data out and the plus signs not.
+ *
+ * Build:  gcc -O2 -Wall -I. -pthread -o uartbridge_pty tools/uartbridge_pty.c uartbridge.c
+ * Usage:  uartbridge_pty [-v]
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "uartbridge.h"
+
+#define RING_SIZE		256					// RXBUFSIZE of retargetserial.c
+#define PACKET_SIZE		244
+#define OUT_SIZE		(4 * 1024 * 1024)
+
+static uint32_t failures;
+static int verbose;
+
+static void expect(const char *what, uint32_t got, uint32_t expected)
+{
+	if(got != expected)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, expected);
+	}
+}
+
+/* The bytes of a stream, the same on both sides */
+static uint8_t streamByte(uint32_t i)
+{
+	uint32_t x = i * 2654435761u;
+
+	x ^= x >> 15;
+	/* No plus signs, the escape checks put their own */
+	return ((uint8_t)x == UARTBRIDGE_ESCAPE_CHAR) ? 0 : (uint8_t)x;
+}
+
+/* What the stack was given, in order, and the size of each packet */
+static uint8_t *out;
+static uint32_t outLen;
+static uint32_t packetSizes[PACKET_SIZE + 1];
+
+static void outAdd(const uint8_t *data, uint16_t len)
+{
+	if(outLen + len <= OUT_SIZE)
+	{
+		memcpy(out + outLen, data, len);
+		outLen += len;
+	}
+	packetSizes[len]++;
+}
+
+static void outReset(void)
+{
+	outLen = 0;
+	memset(packetSizes, 0, sizeof(packetSizes));
+}
+
+/* RAM ring and clock for the first part */
+
+static uint8_t ramRing[4096];
+static uint32_t ramPut;
+static uint32_t ramGet;
+static uint32_t ramNow;
+static uint32_t ramRefuse;					// Refuse this many sends
+
+static uint32_t ramRead(uint8_t *data, uint32_t len)
+{
+	uint32_t n = 0;
+
+	while(n < len && ramGet != ramPut)
+	{
+		data[n++] = ramRing[ramGet++ % sizeof(ramRing)];
+	}
+	return n;
+}
+
+static uint32_t ramPending(void)
+{
+	return ramPut - ramGet;
+}
+
+static uint32_t ramOverruns(void)
+{
+	return 0;
+}
+
+static bool ramSend(const uint8_t *data, uint16_t len)
+{
+	if(ramRefuse > 0)
+	{
+		ramRefuse--;
+		return false;
+	}
+	outAdd(data, len);
+	return true;
+}
+
+static const UARTBRIDGE_Port_t ramPort = { ramRead, ramPending, ramOverruns, ramSend };
+
+static void ramWrite(const char *text, uint32_t len)
+{
+	for(uint32_t i = 0; i < len; i++)
+	{
+		ramRing[ramPut++ % sizeof(ramRing)] = (uint8_t)text[i];
+	}
+}
+
+/* Polls until nothing more happens at this time */
+static UARTBRIDGE_Result_t ramPoll(void)
+{
+	UARTBRIDGE_Result_t result;
+
+	while((result = UARTBRIDGE_Poll(ramNow)) == UARTBRIDGE_SENT)
+	{
+	}
+	return result;
+}
+
+static bool outIs(const char *text)
+{
+	return outLen == strlen(text) && memcmp(out, text, outLen) == 0;
+}
+
+static void expectOut(const char *what, const char *text)
+{
+	if(!outIs(text))
+	{
+		failures++;
+		printf("FAIL: %s, \"%.*s\" instead of \"%s\"\n", what, (int)outLen, out, text);
+	}
+}
+
+static void ramStart(uint16_t size)
+{
+	ramPut = ramGet = 0;
+	ramRefuse = 0;
+	outReset();
+	UARTBRIDGE_Start(&ramPort, size, ramNow);
+}
+
+static void ramChecks(void)
+{
+	UARTBRIDGE_Stats_t stats;
+	char text[1000];
+
+	/* Full packets, the rest on the line going idle */
+	ramNow = 1000;
+	ramStart(PACKET_SIZE);
+	for(uint32_t i = 0; i < sizeof(text); i++)
+	{
+		text[i] = (char)streamByte(i);
+	}
+	ramWrite(text, sizeof(text));
+	UARTBRIDGE_LineIdle();
+	expect("idle result", ramPoll(), UARTBRIDGE_IDLE);
+	UARTBRIDGE_GetStats(&stats);
+	expect("full packets", stats.fullPackets, 4);
+	expect("idle packets", stats.idlePackets, 1);
+	expect("idle size", packetSizes[1000 - 4 * PACKET_SIZE], 1);
+	expect("bytes out", stats.bytesOut, 1000);
+	expect("same bytes", outLen == 1000 && memcmp(out, text, 1000) == 0, 1);
+	expect("pending max", stats.pendingMax, 1000);
+
+	/* No idle, out after the flush time */
+	outReset();
+	ramWrite("abc", 3);
+	expect("early", ramPoll(), UARTBRIDGE_IDLE);
+	ramNow += UARTBRIDGE_FLUSH_TICKS - 1;
+	ramPoll();
+	expect("not yet", outLen, 0);
+	ramNow++;
+	ramPoll();
+	expectOut("timeout", "abc");
+	UARTBRIDGE_GetStats(&stats);
+	expect("timeout packets", stats.timeoutPackets, 1);
+	expect("hold", stats.holdMaxTicks, UARTBRIDGE_FLUSH_TICKS);
+
+	/* Refused: offered again, nothing more read meanwhile */
+	outReset();
+	ramRefuse = 3;
+	ramWrite("defg", 4);
+	UARTBRIDGE_LineIdle();
+	expect("refused", UARTBRIDGE_Poll(ramNow), UARTBRIDGE_BLOCKED);
+	ramWrite("hij", 3);
+	UARTBRIDGE_LineIdle();
+	ramNow += 10;
+	UARTBRIDGE_Poll(ramNow);
+	ramNow += 10;
+	expect("refused again", UARTBRIDGE_Poll(ramNow), UARTBRIDGE_BLOCKED);
+	expect("not read", ramPending(), 3);
+	ramNow += 10;
+	expect("taken", UARTBRIDGE_Poll(ramNow), UARTBRIDGE_SENT);
+	ramPoll();
+	expectOut("after refusals", "defghij");
+	UARTBRIDGE_GetStats(&stats);
+	expect("refusals", stats.refusals, 3);
+	expect("stall", stats.stallTicks, 30);
+	UARTBRIDGE_Stop(ramNow);
+	expect("stopped", UARTBRIDGE_Running(), 0);
+
+	/* The escape, nothing goes out */
+	ramNow += 100000;
+	ramStart(PACKET_SIZE);
+	ramNow += UARTBRIDGE_GUARD_TICKS;
+	ramWrite("+++", 3);
+	expect("escape early", ramPoll(), UARTBRIDGE_IDLE);
+	ramNow += UARTBRIDGE_GUARD_TICKS - 1;
+	expect("escape guard", ramPoll(), UARTBRIDGE_IDLE);
+	ramNow++;
+	expect("escape", ramPoll(), UARTBRIDGE_ESCAPED);
+	expect("escape out", outLen, 0);
+	UARTBRIDGE_GetStats(&stats);
+	expect("escape stats", stats.escaped, 1);
+
+	/* Data, then the escape once it has gone */
+	ramNow += 100000;
+	ramStart(PACKET_SIZE);
+	ramWrite("data", 4);
+	UARTBRIDGE_LineIdle();
+	ramPoll();
+	ramNow += UARTBRIDGE_GUARD_TICKS;
+	ramWrite("++", 2);
+	ramPoll();
+	ramNow += 5;
+	ramWrite("+", 1);
+	ramPoll();
+	ramNow += UARTBRIDGE_GUARD_TICKS;
+	expect("escape after data", ramPoll(), UARTBRIDGE_ESCAPED);
+	expectOut("escape after data out", "data");
+
+	/* Near misses, all of them data */
+	ramNow += 100000;
+	ramStart(PACKET_SIZE);
+	ramWrite("x+++", 4);							// No silence before
+	UARTBRIDGE_LineIdle();
+	ramNow += 2 * UARTBRIDGE_GUARD_TICKS;
+	expect("no guard before", ramPoll(), UARTBRIDGE_IDLE);
+	expectOut("no guard before out", "x+++");
+
+	outReset();
+	ramWrite("+++y", 4);							// Not silent after
+	UARTBRIDGE_LineIdle();
+	ramPoll();
+	expectOut("no guard after", "+++y");
+
+	outReset();
+	ramNow += 2 * UARTBRIDGE_GUARD_TICKS;
+	ramWrite("++++", 4);							// One too many
+	ramPoll();
+	ramNow += 2 * UARTBRIDGE_GUARD_TICKS;
+	expect("four", ramPoll(), UARTBRIDGE_IDLE);
+	expectOut("four out", "++++");
+
+	outReset();
+	ramNow += 2 * UARTBRIDGE_GUARD_TICKS;
+	ramWrite("++", 2);								// One too few
+	ramPoll();
+	expect("two held", outLen, 0);
+	ramNow += UARTBRIDGE_GUARD_TICKS;
+	expect("two", ramPoll(), UARTBRIDGE_IDLE);
+	expectOut("two out", "++");
+
+	UARTBRIDGE_Stop(ramNow);
+
+	/* Held plus signs never overflow a packet */
+	ramNow += 100000;
+	ramStart(4);
+	ramNow += UARTBRIDGE_GUARD_TICKS;
+	ramWrite("++abcdefgh", 10);
+	ramPoll();
+	ramNow += UARTBRIDGE_FLUSH_TICKS;
+	ramPoll();
+	expectOut("small packets", "++abcdefgh");
+	expect("small packet size", packetSizes[4], 2);
+	expect("small packet rest", packetSizes[2], 1);
+	UARTBRIDGE_Stop(ramNow);
+
+	/* Not started with a data size of 0 */
+	ramStart(0);
+	expect("no size", UARTBRIDGE_Running(), 0);
+}
+
+/* The pseudo terminal */
+
+typedef struct {
+	const char *name;
+	uint32_t bytes;							// Stream length
+	uint32_t baud;
+	uint32_t burstMax;						// 0 for a steady stream
+	uint32_t gapUs;
+	uint32_t linkBytesPerSecond;
+	bool escape;
+} Scenario_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t ring[RING_SIZE];
+static uint32_t ringPut;					// Free running, as in retargetserial.c
+static uint32_t ringGet;
+static uint32_t ringOverruns;
+static bool ringIdle;
+static volatile bool ldmaStop;
+static int slaveFd;
+
+static uint32_t ticksNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(((uint64_t)ts.tv_sec * 32768) + ((uint64_t)ts.tv_nsec * 32768 / 1000000000));
+}
+
+/* The LDMA: empties the pty into the ring, oldest bytes lost when full */
+static void *ldma(void *arg)
+{
+	struct pollfd pfd = { slaveFd, POLLIN, 0 };
+	bool received = false;
+	uint8_t buffer[64];
+
+	(void)arg;
+	while(!ldmaStop)
+	{
+		int n = poll(&pfd, 1, 2);
+
+		if(n == 0)
+		{
+			/* TIMECMP1 */
+			if(received)
+			{
+				pthread_mutex_lock(&lock);
+				ringIdle = true;
+				pthread_mutex_unlock(&lock);
+				received = false;
+			}
+			continue;
+		}
+		n = read(slaveFd, buffer, sizeof(buffer));
+		if(n <= 0)
+		{
+			continue;
+		}
+		received = true;
+		pthread_mutex_lock(&lock);
+		for(int i = 0; i < n; i++)
+		{
+			ring[ringPut++ % RING_SIZE] = buffer[i];
+		}
+		if(ringPut - ringGet > RING_SIZE)
+		{
+			ringOverruns += ringPut - ringGet - RING_SIZE;
+			ringGet = ringPut - RING_SIZE;
+		}
+		pthread_mutex_unlock(&lock);
+	}
+	return NULL;
+}
+
+static uint32_t ptyRead(uint8_t *data, uint32_t len)
+{
+	uint32_t n = 0;
+
+	pthread_mutex_lock(&lock);
+	while(n < len && ringGet != ringPut)
+	{
+		data[n++] = ring[ringGet++ % RING_SIZE];
+	}
+	pthread_mutex_unlock(&lock);
+	return n;
+}
+
+static uint32_t ptyPending(void)
+{
+	uint32_t n;
+
+	pthread_mutex_lock(&lock);
+	n = ringPut - ringGet;
+	pthread_mutex_unlock(&lock);
+	return n;
+}
+
+static uint32_t ptyOverruns(void)
+{
+	uint32_t n;
+
+	pthread_mutex_lock(&lock);
+	n = ringOverruns;
+	pthread_mutex_unlock(&lock);
+	return n;
+}
+
+/* The stack: a queue of a few packets emptied at the link rate */
+#define LINK_QUEUE		4
+
+static uint32_t linkRate;
+static uint32_t linkQueued;					// Bytes waiting to go on air
+static uint32_t linkTicks;
+
+static bool ptySend(const uint8_t *data, uint16_t len)
+{
+	uint32_t now = ticksNow();
+	uint64_t drained = ((uint64_t)(now - linkTicks) * linkRate) / 32768;
+
+	if(drained > 0)
+	{
+		linkQueued = (drained >= linkQueued) ? 0 : linkQueued - (uint32_t)drained;
+		linkTicks = now;
+	}
+	if(linkQueued + len > LINK_QUEUE * PACKET_SIZE)
+	{
+		return false;
+	}
+	linkQueued += len;
+	outAdd(data, len);
+	return true;
+}
+
+static const UARTBRIDGE_Port_t ptyPort = { ptyRead, ptyPending, ptyOverruns, ptySend };
+
+static void sleepUs(uint32_t us)
+{
+	struct timespec ts = { us / 1000000, (long)(us % 1000000) * 1000 };
+
+	while(nanosleep(&ts, &ts) != 0 && errno == EINTR)
+	{
+	}
+}
+
+static void writeAll(int fd, const uint8_t *data, uint32_t len)
+{
+	while(len > 0)
+	{
+		ssize_t n = write(fd, data, len);
+
+		if(n <= 0)
+		{
+			if(errno == EINTR || errno == EAGAIN)
+			{
+				continue;
+			}
+			_exit(2);
+		}
+		data += n;
+		len -= (uint32_t)n;
+	}
+}
+
+/* The far side: the stream in chunks at about the baud rate */
+static void device(int fd, const Scenario_t *s)
+{
+	uint8_t chunk[16];
+	uint32_t sent = 0;
+	uint32_t burst = 0;
+	uint32_t seed = 7;
+
+	while(sent < s->bytes)
+	{
+		uint32_t n = s->bytes - sent;
+
+		if(s->burstMax && burst == 0)
+		{
+			seed = seed * 1103515245u + 12345u;
+			burst = 1 + (seed >> 8) % s->burstMax;
+		}
+		n = (n > sizeof(chunk)) ? sizeof(chunk) : n;
+		n = (s->burstMax && n > burst) ? burst : n;
+		for(uint32_t i = 0; i < n; i++)
+		{
+			chunk[i] = streamByte(sent + i);
+		}
+		writeAll(fd, chunk, n);
+		sent += n;
+		/* Ten bits a byte */
+		sleepUs((uint32_t)(((uint64_t)n * 10 * 1000000) / s->baud));
+		if(s->burstMax)
+		{
+			burst -= n;
+			if(burst == 0)
+			{
+				sleepUs(s->gapUs);
+			}
+		}
+	}
+	if(s->escape)
+	{
+		sleepUs(1300000);
+		writeAll(fd, (const uint8_t *)"+++", 3);
+		sleepUs(1500000);
+	}
+	/* Let the last bytes be read before the master end closes */
+	sleepUs(200000);
+}
+
+/* The stream with some runs of bytes lost, as the ring overruns */
+static bool outIsStreamLess(uint32_t total, uint32_t *lost)
+{
+	uint32_t in = 0;
+
+	*lost = 0;
+	for(uint32_t o = 0; o < outLen; o++)
+	{
+		while(in < total && streamByte(in) != out[o])
+		{
+			in++;
+			(*lost)++;
+		}
+		if(in == total)
+		{
+			return false;
+		}
+		in++;
+	}
+	*lost += total - in;
+	return true;
+}
+
+static void runScenario(const Scenario_t *s)
+{
+	UARTBRIDGE_Stats_t stats;
+	UARTBRIDGE_Result_t result = UARTBRIDGE_IDLE;
+	struct termios raw;
+	pthread_t thread;
+	int masterFd;
+	pid_t child;
+	int status;
+	uint32_t lost;
+	uint32_t left;
+	uint32_t quietTicks;
+	bool childDone = false;
+
+	masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+	{
+		perror("posix_openpt");
+		exit(2);
+	}
+	slaveFd = open(ptsname(masterFd), O_RDWR | O_NOCTTY);
+	if(slaveFd < 0 || tcgetattr(slaveFd, &raw) != 0)
+	{
+		perror("pty");
+		exit(2);
+	}
+	cfmakeraw(&raw);
+	tcsetattr(slaveFd, TCSANOW, &raw);
+
+	child = fork();
+	if(child == 0)
+	{
+		close(slaveFd);
+		device(masterFd, s);
+		_exit(0);
+	}
+
+	ringPut = ringGet = ringOverruns = 0;
+	ringIdle = false;
+	ldmaStop = false;
+	outReset();
+	linkRate = s->linkBytesPerSecond;
+	linkQueued = 0;
+	linkTicks = ticksNow();
+	pthread_create(&thread, NULL, ldma, NULL);
+
+	UARTBRIDGE_Start(&ptyPort, PACKET_SIZE, ticksNow());
+	quietTicks = ticksNow();
+	/* The main loop, until the escape or the device is gone and nothing has
+	 * moved for 200 ms */
+	while(result != UARTBRIDGE_ESCAPED)
+	{
+		uint32_t now = ticksNow();
+		bool idle;
+
+		pthread_mutex_lock(&lock);
+		idle = ringIdle;
+		ringIdle = false;
+		pthread_mutex_unlock(&lock);
+		if(idle)
+		{
+			UARTBRIDGE_LineIdle();
+		}
+		result = UARTBRIDGE_Poll(now);
+		if(!childDone && waitpid(child, &status, WNOHANG) == child)
+		{
+			childDone = true;
+		}
+		if(result != UARTBRIDGE_IDLE || ptyPending() != 0)
+		{
+			quietTicks = now;
+		}
+		else if(childDone && now - quietTicks > 32768 / 5)
+		{
+			break;
+		}
+		else
+		{
+			sleepUs(20);
+		}
+	}
+	UARTBRIDGE_Stop(ticksNow());
+	UARTBRIDGE_GetStats(&stats);
+	left = ptyPending();
+
+	ldmaStop = true;
+	pthread_join(thread, NULL);
+	if(!childDone)
+	{
+		waitpid(child, &status, 0);
+	}
+	close(slaveFd);
+	close(masterFd);
+
+	printf("%-7s %7u in %7u out %5u packets (%u full %u idle %u timeout), %u refusals, stall %.1f ms, "
+			"ring max %u mean %.1f, %u overruns, hold max %.1f ms, %.0f bit/s%s\n",
+			s->name, stats.bytesIn, stats.bytesOut, stats.packets, stats.fullPackets, stats.idlePackets,
+			stats.timeoutPackets, stats.refusals, stats.stallTicks * 1000.0 / 32768, stats.pendingMax,
+			stats.polls ? (double)stats.pendingSum / stats.polls : 0.0, stats.overruns,
+			stats.holdMaxTicks * 1000.0 / 32768, (double)UARTBRIDGE_Throughput(&stats),
+			stats.escaped ? ", escaped" : "");
+	if(verbose)
+	{
+		for(uint32_t i = 0; i <= PACKET_SIZE; i++)
+		{
+			if(packetSizes[i])
+			{
+				printf("  %3u bytes: %u\n", i, packetSizes[i]);
+			}
+		}
+	}
+
+	/* Everything read went out, but the escape */
+	expect("all sent", stats.bytesIn, stats.bytesOut + (s->escape ? UARTBRIDGE_ESCAPE_COUNT : 0));
+	expect("ring empty", left, 0);
+	expect("counted", stats.bytesOut, outLen);
+	expect("packets", stats.packets, stats.fullPackets + stats.idlePackets + stats.timeoutPackets);
+	expect("full size", stats.fullPackets, packetSizes[PACKET_SIZE]);
+	expect("ring max", stats.pendingMax <= RING_SIZE, 1);
+	expect("escaped", stats.escaped, s->escape);
+	expect("stream less lost", outIsStreamLess(s->bytes, &lost), 1);
+	expect("lost", lost, stats.overruns);
+	expect("bytes in", stats.bytesIn + stats.overruns, s->bytes + (s->escape ? UARTBRIDGE_ESCAPE_COUNT : 0));
+}
+
+static const Scenario_t scenarios[] = {
+	/* name		bytes	baud	burst	gap us	link B/s	escape */
+	{ "bursts",	150000,	460800,	3000,	5000,	1000000,	false },
+	{ "slow",	200000,	460800,	0,		0,		20000,		false },
+	{ "escape",	20000,	115200,	0,		0,		1000000,	true },
+};
+
+int main(int argc, char *argv[])
+{
+	verbose = (argc > 1) && strcmp(argv[1], "-v") == 0;
+	out = malloc(OUT_SIZE);
+	if(out == NULL)
+	{
+		return 2;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	ramChecks();
+	for(uint32_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+	{
+		runScenario(&scenarios[i]);
+		/* The slow link has to lose bytes, the others must not */
+		expect(scenarios[i].name, outLen < scenarios[i].bytes, scenarios[i].linkBytesPerSecond < 46080);
+	}
+	printf("uartbridge checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the BLE to serial sink queue and backpressure
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+/* Runs uartsink.c against the retarget TX ring itself, a model of the LDMA
+ * draining it into a USART that waits on CTS, and a model of the link: a
+ * peer with packets to send every connection event, a stack with a few
+ * receive buffers that only acknowledges what it has room for, and a main
+ * loop that takes one event a pass unless the sink holds it. Time goes in
+ * microseconds, the sink sees the RTCC.
+ *
+ * Scenarios first: a link faster than the UART, a link slower than it, the
+ * far end pausing CTS, and CTS stuck long enough for the hold to be given
+ * up. Then random setups. Every byte the USART sends is checked against the
+ * payloads the sink took, in order.
+ *
+ * Build:  gcc -O2 -Wall -I. -Ihardware/kit/common/drivers -o uartsink_check
+ *           tools/uartsink_check.c uartsink.c hardware/kit/common/drivers/retargetring.c
+ * Usage:  uartsink_check [random runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "retargetring.h"
+#include "uartsink.h"
+
+#define RING_SIZE		1024		// TXBUFSIZE of retargetserial.c
+#define DMA_MAX			2048		// DMADRV_MAX_XFER_COUNT
+#define PASS_US			20			// A main loop pass
+#define MAX_BUFFERS		32
+#define EXPECT_SIZE		(1u << 22)
+
+typedef struct {
+	uint32_t baud;
+	uint32_t intervalUs;			// Connection interval
+	uint32_t perEvent;				// Packets the peer sends an event when it may
+	uint32_t payload;				// Payload length
+	uint32_t buffers;				// Stack receive buffers
+	uint32_t seconds;				// Peer sends this long, the UART then drains
+	uint32_t ctsPeriodUs;			// CTS off ctsOffUs of every ctsPeriodUs, 0 for never
+	uint32_t ctsOffUs;
+	uint32_t ctsStuckFromUs;		// CTS off between these, both 0 for never
+	uint32_t ctsStuckToUs;
+} Setup_t;
+
+typedef struct {
+	UARTSINK_Stats_t stats;
+	uint32_t wireBytes;				// Sent by the USART
+	uint32_t refused;				// Packets the stack had no buffer for
+	uint32_t mismatches;
+} Result_t;
+
+static uint32_t failures;
+
+static RETARGET_Ring_t ring;
+static uint8_t ringBuf[RING_SIZE];
+static uint8_t expected[EXPECT_SIZE];	// What the sink took, in order
+static uint32_t expectPut;
+
+static void expect(const char *what, uint32_t got, uint32_t wanted)
+{
+	if(got != wanted)
+	{
+		failures++;
+		printf("FAIL: %s, %u instead of %u\n", what, got, wanted);
+	}
+}
+
+static void expectRange(const char *what, uint32_t got, uint32_t low, uint32_t high)
+{
+	if(got < low || got > high)
+	{
+		failures++;
+		printf("FAIL: %s, %u not in %u..%u\n", what, got, low, high);
+	}
+}
+
+static uint32_t room(void)
+{
+	return RETARGET_RingFree(&ring);
+}
+
+static uint32_t queued(void)
+{
+	return RETARGET_RingUsed(&ring);
+}
+
+static uint32_t write(const uint8_t *data, uint32_t len)
+{
+	return (uint32_t)RETARGET_RingWrite(&ring, (const char *)data, (int)len, false);
+}
+
+static const UARTSINK_Port_t port = { room, queued, write };
+
+static uint32_t rtcc(uint64_t us)
+{
+	return (uint32_t)(us * 32768 / 1000000);
+}
+
+static bool ctsOn(const Setup_t *s, uint64_t us)
+{
+	if(us >= s->ctsStuckFromUs && us < s->ctsStuckToUs)
+	{
+		return false;
+	}
+	return s->ctsPeriodUs == 0 || us % s->ctsPeriodUs >= s->ctsOffUs;
+}
+
+static void run(const Setup_t *s, Result_t *r)
+{
+	static uint8_t stack[MAX_BUFFERS][UARTSINK_MAX_PACKET];
+	uint32_t stackGet = 0;
+	uint32_t stackPut = 0;
+	uint32_t peerSeq = 0;			// Payload bytes the peer has had taken
+	uint8_t *dmaData = NULL;
+	uint32_t dmaLen = 0;
+	uint32_t dmaSent = 0;
+	double byteUs = 10e6 / s->baud;
+	double nextByte = 0;
+	uint64_t nextEvent = 0;
+	uint64_t nextPass = 0;
+	uint64_t sendUntil = (uint64_t)s->seconds * 1000000;
+	uint64_t drainUs = (uint64_t)(RING_SIZE + s->buffers * s->payload) * 10000000 / s->baud;
+	uint64_t end;
+	uint32_t wireGet = 0;
+
+	/* Long enough for all the peer sent to get out of the USART */
+	if(s->ctsPeriodUs)
+	{
+		drainUs = drainUs * s->ctsPeriodUs / (s->ctsPeriodUs - s->ctsOffUs) + s->ctsPeriodUs;
+	}
+	end = sendUntil + drainUs + 2000000;
+
+	memset(r, 0, sizeof(*r));
+	RETARGET_RingInit(&ring, ringBuf, RING_SIZE);
+	expectPut = 0;
+	UARTSINK_Start(&port, 0);
+
+	for(uint64_t us = 0; us < end; us++)
+	{
+		/* The link: the stack acknowledges what it has buffers for */
+		if(us == nextEvent)
+		{
+			nextEvent += s->intervalUs;
+			for(uint32_t i = 0; us < sendUntil && i < s->perEvent; i++)
+			{
+				if(stackPut - stackGet == s->buffers)
+				{
+					r->refused++;
+					break;
+				}
+				for(uint32_t b = 0; b < s->payload; b++)
+				{
+					stack[stackPut % MAX_BUFFERS][b] = (uint8_t)((peerSeq + b) * 7 + ((peerSeq + b) >> 8));
+				}
+				peerSeq += s->payload;
+				stackPut++;
+			}
+		}
+
+		/* The main loop */
+		if(us == nextPass)
+		{
+			nextPass += PASS_US;
+			if(!UARTSINK_Hold(rtcc(us)) && stackPut != stackGet)
+			{
+				uint8_t *data = stack[stackGet++ % MAX_BUFFERS];
+
+				if(UARTSINK_Put(data, (uint16_t)s->payload, rtcc(us)))
+				{
+					memcpy(&expected[expectPut % EXPECT_SIZE], data, s->payload);
+					expectPut += s->payload;
+				}
+			}
+		}
+
+		/* The LDMA and the USART, a frame only starts with CTS on */
+		if(dmaLen == 0)
+		{
+			dmaLen = RETARGET_RingPeek(&ring, &dmaData);
+			dmaLen = (dmaLen > DMA_MAX) ? DMA_MAX : dmaLen;
+			dmaSent = 0;
+		}
+		if(dmaLen != 0 && us >= nextByte && ctsOn(s, us))
+		{
+			if(dmaData[dmaSent] != expected[wireGet % EXPECT_SIZE] || wireGet >= expectPut)
+			{
+				r->mismatches++;
+			}
+			wireGet++;
+			nextByte = ((double)us > nextByte + byteUs ? (double)us : nextByte) + byteUs;
+			if(++dmaSent == dmaLen)
+			{
+				RETARGET_RingConsume(&ring, dmaLen);
+				dmaLen = 0;
+			}
+		}
+	}
+
+	UARTSINK_Stop(rtcc(end));
+	UARTSINK_GetStats(&r->stats);
+	r->wireBytes = wireGet;
+}
+
+static uint32_t bps(uint32_t baud)
+{
+	return baud / 10 * 8;
+}
+
+static void scenarios(void)
+{
+	Result_t r;
+	uint8_t data[UARTSINK_MAX_PACKET] = { 0 };
+
+	/* Nothing before a start */
+	expect("put idle", UARTSINK_Put(data, 20, 0), 0);
+	expect("hold idle", UARTSINK_Hold(0), 0);
+
+	/* A link far faster than the UART, the stack is held most of the run */
+	Setup_t flood = { 115200, 7500, 6, 244, 8, 10, 0, 0, 0, 0 };
+	run(&flood, &r);
+	expect("flood mismatches", r.mismatches, 0);
+	expect("flood drops", r.stats.drops, 0);
+	expect("flood give ups", r.stats.giveUps, 0);
+	expect("flood wire", r.wireBytes, r.stats.bytesQueued);
+	expect("flood out", r.stats.bytesOut, r.stats.bytesQueued);
+	expect("flood in", r.stats.bytesIn, r.stats.bytesQueued);
+	expectRange("flood high water", r.stats.queueHighWater, RING_SIZE - UARTSINK_MAX_PACKET, RING_SIZE);
+	expectRange("flood throughput", UARTSINK_Throughput(&r.stats), bps(115200) * 98 / 100, bps(115200));
+	expectRange("flood stalled", r.stats.stallTicks, rtcc(8000000), rtcc(11000000));
+	expect("flood peer held off", r.refused > 0, 1);
+
+	/* A link slower than the UART, never held */
+	Setup_t trickle = { 115200, 7500, 1, 20, 8, 10, 0, 0, 0, 0 };
+	run(&trickle, &r);
+	expect("trickle mismatches", r.mismatches, 0);
+	expect("trickle stalls", r.stats.stalls, 0);
+	expect("trickle refused", r.refused, 0);
+	expect("trickle out", r.stats.bytesOut, 20 * (10000000 / 7500 + 1));
+	expectRange("trickle high water", r.stats.queueHighWater, 20, 40);
+	expectRange("trickle throughput", UARTSINK_Throughput(&r.stats), 20 * 8 * 1000000 / 7500 * 97 / 100,
+			20 * 8 * 1000000 / 7500 * 103 / 100);
+
+	/* The far end pauses CTS half of every second, shorter than a hold */
+	Setup_t paused = { 115200, 7500, 6, 244, 8, 10, 1000000, 500000, 0, 0 };
+	run(&paused, &r);
+	expect("paused mismatches", r.mismatches, 0);
+	expect("paused drops", r.stats.drops, 0);
+	expect("paused give ups", r.stats.giveUps, 0);
+	expectRange("paused stall max", r.stats.stallMaxTicks, rtcc(500000), rtcc(1000000));
+	expectRange("paused throughput", UARTSINK_Throughput(&r.stats), bps(115200) * 45 / 100, bps(115200) * 55 / 100);
+
+	/* CTS stuck for four seconds, the hold is given up and payloads dropped
+	 * until the UART moves again */
+	Setup_t stuck = { 115200, 7500, 6, 244, 8, 10, 0, 0, 1000000, 5000000 };
+	run(&stuck, &r);
+	expect("stuck mismatches", r.mismatches, 0);
+	expect("stuck give ups", r.stats.giveUps, 1);
+	expect("stuck dropped", r.stats.drops > 0, 1);
+	expect("stuck in", r.stats.bytesIn, r.stats.bytesQueued + r.stats.droppedBytes);
+	expect("stuck out", r.stats.bytesOut, r.stats.bytesQueued);
+	expectRange("stuck stall max", r.stats.stallMaxTicks, UARTSINK_HOLD_TICKS, UARTSINK_HOLD_TICKS + 1);
+
+	/* Stopped with bytes queued, they are not counted out */
+	RETARGET_RingInit(&ring, ringBuf, RING_SIZE);
+	UARTSINK_Start(&port, 100);
+	expect("stop put", UARTSINK_Put(data, 200, 200), 1);
+	UARTSINK_Stop(300);
+	UARTSINK_GetStats(&r.stats);
+	expect("stop queued", r.stats.bytesQueued, 200);
+	expect("stop out", r.stats.bytesOut, 0);
+	expect("stop last", r.stats.lastTicks, 300);
+	expect("stop running", UARTSINK_Running(), 0);
+	expect("stop put after", UARTSINK_Put(data, 20, 400), 0);
+}
+
+static void randomRuns(uint32_t count)
+{
+	static const uint32_t bauds[] = { 9600, 115200, 460800, 921600 };
+	Result_t r;
+
+	srand(3);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		Setup_t s;
+
+		s.baud = bauds[rand() % 4];
+		s.intervalUs = 7500 + (rand() % 20) * 1250;
+		s.perEvent = 1 + rand() % 8;
+		s.payload = 1 + rand() % UARTSINK_MAX_PACKET;
+		s.buffers = 1 + rand() % MAX_BUFFERS;
+		s.seconds = 1 + rand() % 4;
+		s.ctsPeriodUs = (rand() % 2) ? 10000 + rand() % 1000000 : 0;
+		s.ctsOffUs = s.ctsPeriodUs ? rand() % (s.ctsPeriodUs * 4 / 5) : 0;
+		s.ctsStuckFromUs = 0;
+		s.ctsStuckToUs = 0;
+		run(&s, &r);
+
+		expect("random mismatches", r.mismatches, 0);
+		expect("random in", r.stats.bytesIn, r.stats.bytesQueued + r.stats.droppedBytes);
+		expect("random out", r.stats.bytesOut, r.stats.bytesQueued);
+		expect("random wire", r.wireBytes, r.stats.bytesQueued);
+		expectRange("random high water", r.stats.queueHighWater, 0, RING_SIZE);
+		expectRange("random stall max", r.stats.stallMaxTicks, 0, UARTSINK_HOLD_TICKS + 1);
+		/* Room comes back a whole LDMA transfer at a time, payloads are only
+		 * lost when a ring's worth, slowed by the pauses, outlasts a hold */
+		if((uint64_t)RING_SIZE * 10000000 / s.baud * (s.ctsPeriodUs ? s.ctsPeriodUs : 1)
+				/ (s.ctsPeriodUs ? s.ctsPeriodUs - s.ctsOffUs : 1) + s.ctsOffUs < 1900000)
+		{
+			expect("random drops", r.stats.drops, 0);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 50;
+
+	scenarios();
+	randomRuns(count);
+	printf("uartsink checks: %u failures\n", failures);
+
+	return failures ? 1 : 0;
+}
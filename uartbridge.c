@@ -0,0 +1,270 @@
+/***************************************************************************//**
+ * @file
+ * @brief Serial to BLE bridge, packs UART bytes into notifications or writes
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "uartbridge.h"
+
+#define READ_CHUNK		32
+
+typedef enum {
+	REASON_FULL,
+	REASON_IDLE,
+	REASON_TIMEOUT
+} Reason_t;
+
+static const UARTBRIDGE_Port_t *port;
+static bool running;
+static volatile bool lineIdle;
+static bool idlePending;					// A burst ends at idleAt
+static uint32_t idleAt;						// In bytes read or lost since the start
+static UARTBRIDGE_Stats_t stats;
+static uint32_t overrunsStart;
+
+static uint8_t packet[UARTBRIDGE_MAX_PACKET];
+static uint16_t packetSize;
+static uint16_t length;
+static uint32_t packetTicks;				// First byte of the packet read
+static bool closed;							// Ready to go, nothing more is added
+static Reason_t reason;
+static bool refused;						// The stack refused it at least once
+static uint32_t refusedTicks;
+
+static uint8_t held;						// Escape characters held back
+static uint32_t lastRxTicks;				// Last byte read, or the start
+
+void UARTBRIDGE_Start(const UARTBRIDGE_Port_t *portIn, uint16_t size, uint32_t now)
+{
+	port = portIn;
+	packetSize = (size > UARTBRIDGE_MAX_PACKET) ? UARTBRIDGE_MAX_PACKET : size;
+	memset(&stats, 0, sizeof(stats));
+	overrunsStart = port->overruns();
+	length = 0;
+	closed = false;
+	refused = false;
+	held = 0;
+	lastRxTicks = now;
+	lineIdle = false;
+	idlePending = false;
+	running = packetSize != 0;
+}
+
+/**************************************************************************//**
+* @brief Ends the run. A packet not yet taken and plus signs held back are
+* dropped, bytesIn less bytesOut says how many
+*****************************************************************************/
+void UARTBRIDGE_Stop(uint32_t now)
+{
+	if(!running)
+	{
+		return;
+	}
+	running = false;
+	if(refused)
+	{
+		stats.stallTicks += now - refusedTicks;
+	}
+	stats.overruns = port->overruns() - overrunsStart;
+}
+
+bool UARTBRIDGE_Running(void)
+{
+	return running;
+}
+
+/**************************************************************************//**
+* @brief The UART saw the line go idle, may be called from its interrupt
+*****************************************************************************/
+void UARTBRIDGE_LineIdle(void)
+{
+	lineIdle = true;
+}
+
+static void append(uint8_t c, uint32_t now)
+{
+	if(length == 0)
+	{
+		packetTicks = now;
+	}
+	packet[length++] = c;
+}
+
+static void release(uint32_t now)
+{
+	for(; held > 0; held--)
+	{
+		append(UARTBRIDGE_ESCAPE_CHAR, now);
+	}
+}
+
+/**************************************************************************//**
+* @brief Plus signs after a guard time of silence are held back, up to the
+* escape count. Anything else shows they were data
+*****************************************************************************/
+static void take(uint8_t c, uint32_t now)
+{
+	if(c == UARTBRIDGE_ESCAPE_CHAR && held < UARTBRIDGE_ESCAPE_COUNT
+			&& (held > 0 || now - lastRxTicks >= UARTBRIDGE_GUARD_TICKS))
+	{
+		held++;
+	}
+	else
+	{
+		release(now);
+		append(c, now);
+	}
+	lastRxTicks = now;
+}
+
+static void closePacket(Reason_t why)
+{
+	closed = true;
+	reason = why;
+}
+
+/**************************************************************************//**
+* @brief Reads what fits in the packet, then sends it if it is ready. Called
+* on every main loop pass of the run, at most one packet goes per call
+*****************************************************************************/
+UARTBRIDGE_Result_t UARTBRIDGE_Poll(uint32_t now)
+{
+	uint8_t chunk[READ_CHUNK];
+	uint32_t pending;
+	bool idle = false;
+
+	if(!running)
+	{
+		return UARTBRIDGE_IDLE;
+	}
+
+	/* Taken before the fill, every byte of the burst it ends is counted in it.
+	 * The burst may only be read a few packets later */
+	if(lineIdle)
+	{
+		lineIdle = false;
+		idlePending = true;
+		idleAt = stats.bytesIn + stats.overruns + port->pending();
+	}
+
+	pending = port->pending();
+	stats.pendingMax = (pending > stats.pendingMax) ? pending : stats.pendingMax;
+	stats.pendingSum += pending;
+	stats.polls++;
+	stats.overruns = port->overruns() - overrunsStart;
+
+	/* Held characters are kept room for, releasing them always fits */
+	while(!closed && length + held < packetSize)
+	{
+		uint32_t want = packetSize - length - held;
+		uint32_t n = port->read(chunk, (want > READ_CHUNK) ? READ_CHUNK : want);
+
+		if(n == 0)
+		{
+			break;
+		}
+		if(stats.bytesIn == 0)
+		{
+			stats.firstTicks = now;
+		}
+		stats.bytesIn += n;
+		for(uint32_t i = 0; i < n; i++)
+		{
+			take(chunk[i], now);
+		}
+	}
+
+	if(idlePending && (int32_t)(stats.bytesIn + stats.overruns - idleAt) >= 0)
+	{
+		idlePending = false;
+		idle = true;
+	}
+
+	if(held > 0 && held < UARTBRIDGE_ESCAPE_COUNT && now - lastRxTicks >= UARTBRIDGE_GUARD_TICKS && !closed)
+	{
+		/* Too few and the line stayed silent, they were data */
+		release(now);
+		idle = true;
+	}
+
+	if(!closed && length > 0)
+	{
+		if(length == packetSize)
+		{
+			closePacket(REASON_FULL);
+		}
+		else if(idle)
+		{
+			closePacket(REASON_IDLE);
+		}
+		else if(now - lastRxTicks >= UARTBRIDGE_FLUSH_TICKS)
+		{
+			closePacket(REASON_TIMEOUT);
+		}
+	}
+
+	if(closed)
+	{
+		if(!port->send(packet, length))
+		{
+			if(!refused)
+			{
+				refused = true;
+				refusedTicks = now;
+			}
+			stats.refusals++;
+			return UARTBRIDGE_BLOCKED;
+		}
+		if(refused)
+		{
+			stats.stallTicks += now - refusedTicks;
+		}
+		stats.holdMaxTicks = (now - packetTicks > stats.holdMaxTicks) ? now - packetTicks : stats.holdMaxTicks;
+		stats.bytesOut += length;
+		stats.packets++;
+		stats.fullPackets += (reason == REASON_FULL);
+		stats.idlePackets += (reason == REASON_IDLE);
+		stats.timeoutPackets += (reason == REASON_TIMEOUT);
+		stats.lastTicks = now;
+		length = 0;
+		closed = false;
+		refused = false;
+		return UARTBRIDGE_SENT;
+	}
+
+	if(length == 0 && held == UARTBRIDGE_ESCAPE_COUNT && now - lastRxTicks >= UARTBRIDGE_GUARD_TICKS)
+	{
+		stats.escaped = true;
+		return UARTBRIDGE_ESCAPED;
+	}
+
+	return UARTBRIDGE_IDLE;
+}
+
+void UARTBRIDGE_GetStats(UARTBRIDGE_Stats_t *statsOut)
+{
+	*statsOut = stats;
+}
+
+/**************************************************************************//**
+* @brief Bits per second from the first byte read to the last packet sent
+*****************************************************************************/
+uint32_t UARTBRIDGE_Throughput(const UARTBRIDGE_Stats_t *s)
+{
+	uint32_t ticks = s->lastTicks - s->firstTicks;
+
+	return ticks ? (uint32_t)(((uint64_t)s->bytesOut * 8 * 32768) / ticks) : 0;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************//**
+ * @file
+ * @brief Serial to BLE bridge, packs UART bytes into notifications or writes
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef UARTBRIDGE_H_
+#define UARTBRIDGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Only packing and flow control. The UART and the stack are reached through
+ * UARTBRIDGE_Port_t, so tools/uartbridge_pty.c runs it on a PC against a
+ * pseudo terminal standing in for the UART.
+ *
+ * The LDMA fills the retarget RX ring in two halves, the bridge takes bytes
+ * out of it into a packet of the connection's data size, as the ramp runs
+ * have it from the MTU and PDU. A packet goes when it is full, when the
+ * UART reports the line idle after the last byte in it, or when nothing has
+ * come for UARTBRIDGE_FLUSH_TICKS, should the idle report be missed. A
+ * packet the stack refuses is offered again on the next poll and nothing
+ * more is read meanwhile, so a slow link backs up into the RX ring, then
+ * overruns it. RTS cannot help: the LDMA keeps the USART's own buffer empty
+ * whatever the ring holds.
+ *
+ * The run ends, as on a modem, on "+++" with UARTBRIDGE_GUARD_TICKS of
+ * silence either side. Plus signs that could be the start of it are held
+ * back until they turn out to be data. Everything runs from the main loop,
+ * UARTBRIDGE_LineIdle() only sets a flag and may be called from the UART
+ * interrupt. */
+
+#define UARTBRIDGE_MAX_PACKET		244		// Largest notification data size
+#define UARTBRIDGE_FLUSH_TICKS		328		// RTCC ticks of silence, 10 ms
+#define UARTBRIDGE_GUARD_TICKS		32768	// RTCC ticks of silence around the escape
+#define UARTBRIDGE_ESCAPE_CHAR		'+'
+#define UARTBRIDGE_ESCAPE_COUNT		3
+
+typedef enum {
+	UARTBRIDGE_IDLE,						// Nothing to send
+	UARTBRIDGE_SENT,						// A packet went
+	UARTBRIDGE_BLOCKED,						// The stack refused a packet
+	UARTBRIDGE_ESCAPED						// The escape came, the run is over
+} UARTBRIDGE_Result_t;
+
+typedef struct {
+	uint32_t (*read)(uint8_t *data, uint32_t len);	// Take up to len received bytes
+	uint32_t (*pending)(void);						// Received bytes waiting
+	uint32_t (*overruns)(void);						// Received bytes lost so far
+	bool (*send)(const uint8_t *data, uint16_t len);	// False if the stack has no room
+} UARTBRIDGE_Port_t;
+
+typedef struct {
+	uint32_t bytesIn;						// Read from the UART
+	uint32_t bytesOut;						// Taken by the stack
+	uint32_t packets;
+	uint32_t fullPackets;					// Sent at the data size
+	uint32_t idlePackets;					// Sent short, the line went idle
+	uint32_t timeoutPackets;				// Sent short after UARTBRIDGE_FLUSH_TICKS of silence
+	uint32_t refusals;						// Sends the stack refused
+	uint32_t stallTicks;					// Time a packet waited on the stack after the first refusal
+	uint32_t overruns;						// Received bytes lost in the RX ring
+	uint32_t pendingMax;					// RX ring fill, highest and summed over the polls
+	uint64_t pendingSum;
+	uint32_t polls;
+	uint32_t holdMaxTicks;					// Longest from a packet's first byte to the stack taking it
+	uint32_t firstTicks;					// First byte read and last packet sent, for the throughput
+	uint32_t lastTicks;
+	bool escaped;
+} UARTBRIDGE_Stats_t;
+
+void UARTBRIDGE_Start(const UARTBRIDGE_Port_t *port, uint16_t packetSize, uint32_t now);
+void UARTBRIDGE_Stop(uint32_t now);
+bool UARTBRIDGE_Running(void);
+void UARTBRIDGE_LineIdle(void);
+UARTBRIDGE_Result_t UARTBRIDGE_Poll(uint32_t now);
+void UARTBRIDGE_GetStats(UARTBRIDGE_Stats_t *stats);
+uint32_t UARTBRIDGE_Throughput(const UARTBRIDGE_Stats_t *stats);
+
+#endif
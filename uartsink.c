@@ -0,0 +1,175 @@
+/***************************************************************************//**
+ * @file
+ * @brief BLE to serial sink, forwards received payloads to the UART
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "uartsink.h"
+
+static const UARTSINK_Port_t *port;
+static bool running;
+static UARTSINK_Stats_t stats;
+static bool stalled;						// The stack is being held
+static uint32_t stallStart;
+static bool gaveUp;							// Not held again until there is room
+static bool draining;						// The TX queue had bytes at the last look
+
+void UARTSINK_Start(const UARTSINK_Port_t *portIn, uint32_t now)
+{
+	port = portIn;
+	memset(&stats, 0, sizeof(stats));
+	stats.firstTicks = now;
+	stats.lastTicks = now;
+	stalled = false;
+	gaveUp = false;
+	draining = false;
+	running = true;
+}
+
+/**************************************************************************//**
+* @brief Tracks the queue level. The UART is busy until the queue is seen
+* empty, that ends the sustained throughput
+*****************************************************************************/
+static void look(uint32_t now)
+{
+	uint32_t queued = port->queued();
+
+	stats.queueHighWater = (queued > stats.queueHighWater) ? queued : stats.queueHighWater;
+	if(queued > 0 || draining)
+	{
+		stats.lastTicks = now;
+	}
+	draining = queued > 0;
+	stats.bytesOut = stats.bytesQueued - queued;
+}
+
+static void stallEnd(uint32_t now)
+{
+	uint32_t ticks = now - stallStart;
+
+	if(!stalled)
+	{
+		return;
+	}
+	stalled = false;
+	stats.stallTicks += ticks;
+	stats.stallMaxTicks = (ticks > stats.stallMaxTicks) ? ticks : stats.stallMaxTicks;
+}
+
+/**************************************************************************//**
+* @brief Ends the run. Bytes still queued keep going out, they are not in
+* bytesOut
+*****************************************************************************/
+void UARTSINK_Stop(uint32_t now)
+{
+	if(!running)
+	{
+		return;
+	}
+	look(now);
+	stallEnd(now);
+	running = false;
+}
+
+bool UARTSINK_Running(void)
+{
+	return running;
+}
+
+/**************************************************************************//**
+* @brief Queues a received payload for the UART, whole or not at all
+* @return false if it was dropped, or no run is on
+*****************************************************************************/
+bool UARTSINK_Put(const uint8_t *data, uint16_t len, uint32_t now)
+{
+	if(!running)
+	{
+		return false;
+	}
+	if(stats.bytesIn == 0 && stats.drops == 0)
+	{
+		stats.firstTicks = now;
+	}
+	stats.bytesIn += len;
+
+	if(port->room() < len)
+	{
+		stats.drops++;
+		stats.droppedBytes += len;
+		return false;
+	}
+	stats.bytesQueued += port->write(data, len);
+	stats.packets++;
+	look(now);
+	return true;
+}
+
+/**************************************************************************//**
+* @brief Asks whether the next stack event should wait for the UART. Called
+* on every main loop pass of the run before the stack is asked for an event
+* @return true while the TX queue has no room for a whole payload, for
+* UARTSINK_HOLD_TICKS at most
+*****************************************************************************/
+bool UARTSINK_Hold(uint32_t now)
+{
+	if(!running)
+	{
+		return false;
+	}
+	look(now);
+
+	if(port->room() >= UARTSINK_MAX_PACKET)
+	{
+		gaveUp = false;
+		stallEnd(now);
+		return false;
+	}
+	if(gaveUp)
+	{
+		return false;
+	}
+	if(!stalled)
+	{
+		stalled = true;
+		stallStart = now;
+		stats.stalls++;
+	}
+	if(now - stallStart >= UARTSINK_HOLD_TICKS)
+	{
+		/* The far end has held CTS too long, the link comes first */
+		gaveUp = true;
+		stats.giveUps++;
+		stallEnd(now);
+		return false;
+	}
+	return true;
+}
+
+void UARTSINK_GetStats(UARTSINK_Stats_t *statsOut)
+{
+	*statsOut = stats;
+}
+
+/**************************************************************************//**
+* @brief Bits per second the UART sent, from the first payload to the queue
+* going empty or the stop
+*****************************************************************************/
+uint32_t UARTSINK_Throughput(const UARTSINK_Stats_t *s)
+{
+	uint32_t ticks = s->lastTicks - s->firstTicks;
+
+	return ticks ? (uint32_t)(((uint64_t)s->bytesOut * 8 * 32768) / ticks) : 0;
+}
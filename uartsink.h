@@ -0,0 +1,77 @@
+/***************************************************************************//**
+ * @file
+ * @brief BLE to serial sink, forwards received payloads to the UART
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef UARTSINK_H_
+#define UARTSINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The other end of uartbridge.h: notifications on the master, writes on the
+ * slave, go out of the UART instead of being dropped once they are checked.
+ * Only the queueing and the backpressure are here. The TX queue is reached
+ * through UARTSINK_Port_t, on the board it is the retarget TX ring the LDMA
+ * drains, so tools/uartsink_check.c runs the same code on a PC against the
+ * same ring and a model of the LDMA and of the link.
+ *
+ * With RTS/CTS on, the USART stops taking bytes while the far end holds CTS
+ * and the ring fills. Once there is no room left for a whole payload,
+ * UARTSINK_Hold() asks the main loop not to take the next stack event. The
+ * stack's buffers then fill, the link layer stops acknowledging the peer's
+ * packets and the peer's sends start to fail, the same backpressure a slow
+ * receiver puts on the ramp runs. Nothing is lost on the way, a payload only
+ * waits in the stack.
+ *
+ * All stack events wait during a hold, timers and the link closing as well,
+ * so a hold is given up after UARTSINK_HOLD_TICKS. Payloads that find no
+ * room then are dropped and counted, until room for a whole payload comes
+ * back. */
+
+#define UARTSINK_MAX_PACKET		244		// Largest notification or write data size
+#define UARTSINK_HOLD_TICKS		65536	// RTCC ticks the stack is held at most, 2 s
+
+typedef struct {
+	uint32_t (*room)(void);								// Free bytes in the TX queue
+	uint32_t (*queued)(void);							// Bytes in the TX queue the UART has not taken
+	uint32_t (*write)(const uint8_t *data, uint32_t len);	// Queue bytes, returns how many fitted
+} UARTSINK_Port_t;
+
+typedef struct {
+	uint32_t bytesIn;						// Payload bytes received
+	uint32_t bytesQueued;					// Put in the TX queue
+	uint32_t bytesOut;						// Taken from it by the UART
+	uint32_t packets;						// Payloads queued
+	uint32_t drops;							// Payloads that found no room after a hold was given up
+	uint32_t droppedBytes;
+	uint32_t queueHighWater;				// Most bytes in the TX queue
+	uint32_t stalls;						// Holds on the stack
+	uint32_t stallTicks;					// Time the stack was held, in all and the longest hold
+	uint32_t stallMaxTicks;
+	uint32_t giveUps;						// Holds ended by UARTSINK_HOLD_TICKS
+	uint32_t firstTicks;					// First payload, and the TX queue last seen with bytes in it
+	uint32_t lastTicks;
+} UARTSINK_Stats_t;
+
+void UARTSINK_Start(const UARTSINK_Port_t *port, uint32_t now);
+void UARTSINK_Stop(uint32_t now);
+bool UARTSINK_Running(void);
+bool UARTSINK_Put(const uint8_t *data, uint16_t len, uint32_t now);
+bool UARTSINK_Hold(uint32_t now);
+void UARTSINK_GetStats(UARTSINK_Stats_t *stats);
+uint32_t UARTSINK_Throughput(const UARTSINK_Stats_t *stats);
+
+#endif
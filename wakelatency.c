@@ -0,0 +1,139 @@
+/***************************************************************************//**
+ * @file
+ * @brief Wakeup latency of the sleep driver per energy mode
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_rtcc.h"
+
+#include "wakelatency.h"
+
+#define RTCC_COMPARE_FLAGS		(RTCC_IF_CC0 | RTCC_IF_CC1 | RTCC_IF_CC2)
+#define TICKS_TO_NS(ticks)		((uint32_t)(((uint64_t)(ticks) * 1000000000u) >> 15))
+
+static HISTOGRAM_t histograms[sleepEM3];	// EM1 to EM3, index mode - 1
+static WAKELAT_Stats_t stats;
+static bool running;
+static uint32_t coreHz;
+static uint32_t sleepTicks;					// RTCC when SLEEP_Sleep() started
+static uint32_t wakeTicks;					// RTCC and DWT at the first instruction after the WFI
+static uint32_t wakeCycles;
+static uint32_t hardwareNs;					// Compare to first instruction, 0 if not known
+
+void WAKELAT_Start(void)
+{
+	memset(&stats, 0, sizeof(stats));
+	for(uint32_t m = 0; m < sizeof(histograms) / sizeof(histograms[0]); m++)
+	{
+		HISTOGRAM_Reset(&histograms[m]);
+	}
+	coreHz = CMU_ClockFreqGet(cmuClock_CORE);
+	running = true;
+}
+
+void WAKELAT_Stop(void)
+{
+	running = false;
+}
+
+const HISTOGRAM_t *WAKELAT_Histogram(SLEEP_EnergyMode_t mode)
+{
+	return (mode >= sleepEM1 && mode <= sleepEM3) ? &histograms[mode - sleepEM1] : NULL;
+}
+
+void WAKELAT_GetStats(WAKELAT_Stats_t *out)
+{
+	*out = stats;
+}
+
+/**************************************************************************//**
+* @brief Sleep driver hook, counts the sleep and whether a block held it
+*****************************************************************************/
+void SLEEP_SleepHook(SLEEP_EnergyMode_t allowedEM)
+{
+	if(!running)
+	{
+		return;
+	}
+	stats.sleeps++;
+	if(allowedEM < SLEEP_LOWEST_ENERGY_MODE_DEFAULT)
+	{
+		stats.blocked[allowedEM]++;
+	}
+	sleepTicks = RTCC_CounterGet();
+}
+
+/**************************************************************************//**
+* @brief Sleep driver hook, first instruction after the WFI. The interrupt
+* that woke the core has not run yet, so a pending compare flag still names
+* the channel and the compare value when the wakeup was asked for. A flag
+* older than the sleep would have stopped the WFI at once, not woken it
+*****************************************************************************/
+void SLEEP_WakeupHook(SLEEP_EnergyMode_t eMode)
+{
+	uint32_t pending;
+
+	(void)eMode;
+
+	wakeCycles = DWT->CYCCNT;
+	wakeTicks = RTCC_CounterGet();
+	hardwareNs = 0;
+	if(!running)
+	{
+		return;
+	}
+
+	pending = RTCC->IF & RTCC->IEN & RTCC_COMPARE_FLAGS;
+	if(pending != 0)
+	{
+		/* CC0 is bit 1 of the flags */
+		uint32_t channel = (uint32_t)__builtin_ctz(pending) - 1;
+		uint32_t compare = RTCC->CC[channel].CCV;
+
+		if(compare - sleepTicks <= wakeTicks - sleepTicks)
+		{
+			hardwareNs = TICKS_TO_NS(wakeTicks - compare);
+			stats.compareWakes++;
+		}
+	}
+}
+
+/**************************************************************************//**
+* @brief Sleep driver hook, the wakeup path is done and the interrupt is
+* about to run
+*****************************************************************************/
+void SLEEP_RestoreHook(SLEEP_EnergyMode_t modeEntered)
+{
+	uint32_t softwareNs;
+
+	if(!running || modeEntered < sleepEM1 || modeEntered > sleepEM3)
+	{
+		return;
+	}
+
+	if(modeEntered == sleepEM1)
+	{
+		softwareNs = (uint32_t)(((uint64_t)(DWT->CYCCNT - wakeCycles) * 1000000000u) / coreHz);
+	}
+	else
+	{
+		softwareNs = TICKS_TO_NS(RTCC_CounterGet() - wakeTicks);
+	}
+	HISTOGRAM_Add(&histograms[modeEntered - sleepEM1], hardwareNs + softwareNs);
+}
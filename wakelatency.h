@@ -0,0 +1,54 @@
+/***************************************************************************//**
+ * @file
+ * @brief Wakeup latency of the sleep driver per energy mode
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+#ifndef WAKELATENCY_H_
+#define WAKELATENCY_H_
+
+#include <stdint.h>
+
+#include "sleep.h"
+#include "histogram.h"
+
+/* Overrides the sleep driver hooks, so every SLEEP_Sleep() of the stack is
+ * seen. The latency of one wakeup runs from the wakeup interrupt to the
+ * point SLEEP_Sleep() lets that interrupt run, the first application
+ * instruction: the stack's wakeup callback and, from EM2 and EM3, the HFXO
+ * restart of EMU_Restore() are in it.
+ *
+ * The core cannot see itself wake, so the hardware part before the first
+ * instruction after the WFI is only counted when an enabled RTCC compare
+ * woke it, from the compare value, to the RTCC tick. Otherwise a wakeup
+ * starts at that first instruction. The software part is timed in core
+ * cycles from EM1, where the clock does not change, and in RTCC ticks from
+ * EM2 and EM3, whose HFXO restart is hundreds of microseconds.
+ *
+ * Sleeps that sleep blocks kept above SLEEP_LOWEST_ENERGY_MODE_DEFAULT are
+ * counted by the mode they were held in. Sleeping and reading the figures
+ * both happen in the main loop, so no locking is needed. */
+
+typedef struct {
+	uint32_t sleeps;						// SLEEP_Sleep() calls
+	uint32_t blocked[sleepEM3];				// Sleeps held in EM1 or EM2 by a sleep block
+	uint32_t compareWakes;					// Wakeups timed from an RTCC compare
+} WAKELAT_Stats_t;
+
+void WAKELAT_Start(void);
+void WAKELAT_Stop(void);
+const HISTOGRAM_t *WAKELAT_Histogram(SLEEP_EnergyMode_t mode);
+void WAKELAT_GetStats(WAKELAT_Stats_t *stats);
+
+#endif